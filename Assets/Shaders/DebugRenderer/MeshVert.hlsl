@@ -0,0 +1,54 @@
+/*
+    The meshes of DebugRenderer, the vertex buffer holds the unique edges of each mesh as a line list in the space of the mesh.
+    Each instance is one push of the mesh, with its own transform and color.
+*/
+
+struct VSIn
+{
+    float3 position : POSITION;
+    uint instanceID : SV_InstanceID;
+};
+
+struct VSOut
+{
+    float4 position : SV_POSITION;
+    float4 color : COLOR;
+};
+
+// Same layout as DebugRenderer::MeshInstance.
+struct MeshInstance
+{
+    float4x4 transform;
+    uint color; // RGBA8
+    uint wireframeID;
+    uint padding;
+};
+
+cbuffer FrameData : register(b0)
+{
+    float4x4 pv;
+}
+
+// Same layout as DebugRenderer::ShapeData, only the first instance is used.
+cbuffer ShapeData : register(b1)
+{
+    uint firstInstance;
+    uint3 padding;
+}
+
+StructuredBuffer<MeshInstance> meshInstances : register(t0);
+
+float4 UnpackColor(uint color)
+{
+    return float4(color & 0xFF, (color >> 8) & 0xFF, (color >> 16) & 0xFF, color >> 24) / 255.f;
+}
+
+VSOut main(VSIn input)
+{
+    MeshInstance instance = meshInstances[firstInstance + input.instanceID];
+
+    VSOut output;
+    output.position = mul(pv, mul(instance.transform, float4(input.position, 1.f)));
+    output.color = UnpackColor(instance.color);
+    return output;
+}
@@ -0,0 +1,47 @@
+/*
+    The points of DebugRenderer, each point is a quad of two triangles which is made from the vertex id, without a geometry shader.
+    The size of a point is in pixels, it is added after the projection.
+*/
+struct VSIn
+{
+    float2 position : POSITION; // This is not used.
+    uint vertexID : SV_VertexID;
+};
+
+struct VSOut
+{
+    float4 position : SV_POSITION;
+    float4 color : COLOR;
+};
+
+// Same layout as DebugRenderer::Point.
+struct DebugPoint
+{
+    float3 position;
+    uint colorAndSize; // RGB8, and the size in pixels in the high 8 bits.
+};
+
+cbuffer FrameData : register(b0)
+{
+    float4x4 pv;
+    float2 invScreenSize;
+    float2 padding;
+}
+
+StructuredBuffer<DebugPoint> points : register(t0);
+
+VSOut main(VSIn input)
+{
+    // The vertex id includes the start vertex of the draw, six vertices for each point.
+    DebugPoint debugPoint = points[input.vertexID / 6];
+
+    static const float2 corners[6] = { float2(-1.f, -1.f), float2(1.f, -1.f), float2(-1.f, 1.f), float2(-1.f, 1.f), float2(1.f, -1.f), float2(1.f, 1.f) };
+    float2 corner = corners[input.vertexID % 6];
+    float size = (float)(debugPoint.colorAndSize >> 24);
+
+    VSOut output;
+    output.position = mul(pv, float4(debugPoint.position, 1.f));
+    output.position.xy += corner * size * invScreenSize * output.position.w;
+    output.color = float4(debugPoint.colorAndSize & 0xFF, (debugPoint.colorAndSize >> 8) & 0xFF, (debugPoint.colorAndSize >> 16) & 0xFF, 255.f) / 255.f;
+    return output;
+}
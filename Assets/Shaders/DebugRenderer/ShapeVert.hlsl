@@ -0,0 +1,107 @@
+/*
+    The shapes of DebugRenderer, each instance is a unit shape made from the vertex id and drawn as a line list:
+        SHAPE_BOX: The 12 edges of the box from -1 to 1, 24 vertices.
+        SHAPE_SPHERE: Three circles with a radius of 1, 192 vertices.
+        SHAPE_AXES: The x, y and z axes from 0 to 1 in red, green and blue, 6 vertices.
+*/
+#define SHAPE_BOX 0
+#define SHAPE_SPHERE 1
+#define SHAPE_AXES 2
+#define SPHERE_SEGMENTS 32
+
+struct VSIn
+{
+    float2 position : POSITION; // This is not used.
+    uint vertexID : SV_VertexID;
+    uint instanceID : SV_InstanceID;
+};
+
+struct VSOut
+{
+    float4 position : SV_POSITION;
+    float4 color : COLOR;
+};
+
+// Same layout as DebugRenderer::ShapeInstance.
+struct ShapeInstance
+{
+    float4x4 transform;
+    uint color; // RGBA8
+};
+
+cbuffer FrameData : register(b0)
+{
+    float4x4 pv;
+}
+
+cbuffer ShapeData : register(b1)
+{
+    uint firstInstance;
+    uint shapeType;
+    uint2 padding;
+}
+
+StructuredBuffer<ShapeInstance> shapeInstances : register(t0);
+
+float3 GetBoxVertex(uint vertexID)
+{
+    // Four edges along each axis, the two lowest bits of the edge give the other coordinates.
+    uint edge = vertexID / 2;
+    uint axis = edge / 4;
+    float a = (edge & 1) ? 1.f : -1.f;
+    float b = (edge & 2) ? 1.f : -1.f;
+    float t = (vertexID & 1) ? 1.f : -1.f;
+    if (axis == 0)
+        return float3(t, a, b);
+    if (axis == 1)
+        return float3(a, t, b);
+    return float3(a, b, t);
+}
+
+float3 GetSphereVertex(uint vertexID)
+{
+    uint circle = vertexID / (SPHERE_SEGMENTS * 2);
+    uint segment = (vertexID / 2) % SPHERE_SEGMENTS + (vertexID & 1);
+    float angle = (float)segment * (6.28318530718f / SPHERE_SEGMENTS);
+    float2 p = float2(cos(angle), sin(angle));
+    if (circle == 0)
+        return float3(p.x, p.y, 0.f);
+    if (circle == 1)
+        return float3(0.f, p.x, p.y);
+    return float3(p.y, 0.f, p.x);
+}
+
+float4 UnpackColor(uint color)
+{
+    return float4(color & 0xFF, (color >> 8) & 0xFF, (color >> 16) & 0xFF, color >> 24) / 255.f;
+}
+
+VSOut main(VSIn input)
+{
+    ShapeInstance instance = shapeInstances[firstInstance + input.instanceID];
+    float4 color = UnpackColor(instance.color);
+    float3 position;
+    if (shapeType == SHAPE_BOX)
+    {
+        position = GetBoxVertex(input.vertexID);
+    }
+    else if (shapeType == SHAPE_SPHERE)
+    {
+        position = GetSphereVertex(input.vertexID);
+    }
+    else
+    {
+        uint axis = input.vertexID / 2;
+        float3 direction = float3(axis == 0, axis == 1, axis == 2);
+        position = direction * (float)(input.vertexID & 1);
+        color = float4(direction, 1.f);
+    }
+
+    // The transform of a frustum is projective, so the position is divided by w.
+    float4 worldPos = mul(instance.transform, float4(position, 1.f));
+
+    VSOut output;
+    output.position = mul(pv, float4(worldPos.xyz / worldPos.w, 1.f));
+    output.color = color;
+    return output;
+}
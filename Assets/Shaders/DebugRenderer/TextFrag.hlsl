@@ -0,0 +1,17 @@
+struct PSIn
+{
+    float4 position : SV_POSITION;
+    float4 color : COLOR;
+    float2 uv : TEXCOORD;
+};
+
+Texture2D fontAtlas : register(t0);
+SamplerState fontSampler : register(s0);
+
+float4 main(PSIn input) : SV_TARGET
+{
+    // There is no blending, the edges of the glyphs are cut at half coverage.
+    float coverage = fontAtlas.Sample(fontSampler, input.uv).r;
+    clip(coverage - 0.5f);
+    return input.color;
+}
@@ -0,0 +1,86 @@
+/*
+    The glyphs of DebugRenderer, each instance is a quad of two triangles made from the vertex id.
+    World space text keeps its size in pixels, the offset of the glyph is added after the projection.
+*/
+struct VSIn
+{
+    float2 position : POSITION; // This is not used.
+    uint vertexID : SV_VertexID;
+    uint instanceID : SV_InstanceID;
+};
+
+struct VSOut
+{
+    float4 position : SV_POSITION;
+    float4 color : COLOR;
+    float2 uv : TEXCOORD;
+};
+
+// Same layout as DebugRenderer::GlyphInstance.
+struct GlyphInstance
+{
+    float3 position;
+    uint color; // RGBA8
+    float2 offset;
+    float2 size;
+    uint atlasMin; // Texels, x in the low and y in the high 16 bits.
+    uint atlasMax;
+    uint isScreenSpace;
+};
+
+cbuffer FrameData : register(b0)
+{
+    float4x4 pv;
+    float2 invScreenSize;
+    float2 padding;
+}
+
+cbuffer TextData : register(b1)
+{
+    uint firstInstance;
+    uint padding2;
+    float2 invAtlasSize;
+}
+
+StructuredBuffer<GlyphInstance> glyphInstances : register(t0);
+
+float4 UnpackColor(uint color)
+{
+    return float4(color & 0xFF, (color >> 8) & 0xFF, (color >> 16) & 0xFF, color >> 24) / 255.f;
+}
+
+float2 UnpackTexel(uint texel)
+{
+    return float2(texel & 0xFFFF, texel >> 16);
+}
+
+VSOut main(VSIn input)
+{
+    GlyphInstance glyph = glyphInstances[firstInstance + input.instanceID];
+
+    // Two triangles: (0, 0), (1, 0), (0, 1) and (0, 1), (1, 0), (1, 1).
+    static const float2 corners[6] = { float2(0.f, 0.f), float2(1.f, 0.f), float2(0.f, 1.f), float2(0.f, 1.f), float2(1.f, 0.f), float2(1.f, 1.f) };
+    float2 corner = corners[input.vertexID];
+
+    // Pixels from the position, with y pointing down.
+    float2 pixelOffset = glyph.offset + corner * glyph.size;
+    float2 ndcOffset = float2(pixelOffset.x, -pixelOffset.y) * 2.f * invScreenSize;
+
+    VSOut output;
+    if (glyph.isScreenSpace)
+    {
+        float2 ndc = float2(glyph.position.x, -glyph.position.y) * 2.f * invScreenSize + float2(-1.f, 1.f);
+        output.position = float4(ndc + ndcOffset, 0.f, 1.f);
+    }
+    else
+    {
+        output.position = mul(pv, float4(glyph.position, 1.f));
+        output.position.xy += ndcOffset * output.position.w;
+    }
+
+    float2 atlasMin = UnpackTexel(glyph.atlasMin);
+    float2 atlasMax = UnpackTexel(glyph.atlasMax);
+    output.uv = lerp(atlasMin, atlasMax, corner) * invAtlasSize;
+    output.color = UnpackColor(glyph.color);
+    return output;
+}
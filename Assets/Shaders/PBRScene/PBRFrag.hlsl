@@ -11,38 +11,19 @@ struct PSIn
 cbuffer MaterialData : register(b0)
 {
     float4 materialInfo; // x: UseCombined, y: debug draw index, z: preFilterMaxLOD, w: not used
-    /*
-    Debug draw index:
-        0: Normal rendering
-        1: Only albedo
-        2: Only normal
-        3: Only ao
-        4: Only metallic
-        5: Only roughness
-        6: Only combined metallic-roughness (If avaliable)
-        7: -------- Not used --------
-
-    Additional flags on the draw index (Three flags: 8, 16 and 32):
-        8: Use Diffuse IBL (Add contribution from an irradiance map)
-        16: -------- Not used --------
-        32: -------- Not used --------
-    */
 }
 
-#define INDEX_ALBEDO 1
-#define INDEX_NORMAL 2
-#define INDEX_AO 3
-#define INDEX_METALLIC 4
-#define INDEX_ROUGHNESS 5
-#define INDEX_METALLIC_ROUGHNESS 6
-
-#define FLAG_DIFF_IBL 8
-#define FLAG_SPEC_IBL 16
-
-#define INDEX(a) ((uint)a & 7)
-#define IS_INDEX(i) (INDEX(materialInfo.y) == i)
-#define FLAGS(a) ((uint)a & (~7))
-#define GET_FLAGS FLAGS(materialInfo.y)
+/*
+    The shader is compiled into one variant for each combination of these keywords which is used (See ShaderPermutations and MaterialKeyword):
+        COMBINED_METALLIC_ROUGHNESS: The metallic, roughness and ao are read from the combined metallic-roughness texture.
+        DIFFUSE_IBL: Add the contribution from the irradiance map.
+        SPECULAR_IBL: Add the contribution from the pre-filtered environment map.
+    Debug keywords, at most one of these is defined:
+        DEBUG_ALBEDO, DEBUG_NORMAL, DEBUG_AO, DEBUG_METALLIC, DEBUG_ROUGHNESS, DEBUG_METALLIC_ROUGHNESS
+*/
+#if defined(DEBUG_ALBEDO) || defined(DEBUG_NORMAL) || defined(DEBUG_AO) || defined(DEBUG_METALLIC) || defined(DEBUG_ROUGHNESS) || defined(DEBUG_METALLIC_ROUGHNESS)
+    #define DEBUG_TEXTURES
+#endif
 
 cbuffer CameraData : register(b1)
 {
@@ -61,6 +42,12 @@ TextureCube     preFilterMap : register(t7);
 Texture2D       brdfLUT : register(t8);
 SamplerState    linearSampler;
 
+// The lights of the clustered lighting path (b2, t9 - t11), see DeferredRenderer.
+#include <Utils/ClusteredLights.hlsl>
+
+// The directional light and its shadows (b3, t12, s1), see CascadedShadowMap.
+#include <Utils/CascadedShadows.hlsl>
+
 static const float PI = 3.14159265359f;
 
 struct MaterialData
@@ -98,74 +85,51 @@ float3 GetAlbedoColor(MaterialData materialData)
 
 float GetMetallicData(MaterialData materialData)
 {
-    if(materialInfo.x > 0.5f)
-        return materialData.metallicRoughness.b;
-    else
-        return materialData.metallic.r;
+#ifdef COMBINED_METALLIC_ROUGHNESS
+    return materialData.metallicRoughness.b;
+#else
+    return materialData.metallic.r;
+#endif
 }
 
 float GetRoughnessData(MaterialData materialData)
 {
-    if(materialInfo.x > 0.5f)
-        return materialData.metallicRoughness.g;
-    else
-        return materialData.roughness.r;
+#ifdef COMBINED_METALLIC_ROUGHNESS
+    return materialData.metallicRoughness.g;
+#else
+    return materialData.roughness.r;
+#endif
 }
 
 float GetAOData(MaterialData materialData)
 {
-    if(materialInfo.x > 0.5f)
-        return materialData.metallicRoughness.r;
-    else
-        return materialData.ao.r;
+#ifdef COMBINED_METALLIC_ROUGHNESS
+    return materialData.metallicRoughness.r;
+#else
+    return materialData.ao.r;
+#endif
 }
 
 float3 DebugTextures(MaterialData materialData)
 {
-    if(materialInfo.x > 0.5f)
-    {
-        if(IS_INDEX(INDEX_AO)) // AO
-        {
-            return float3(materialData.metallicRoughness.r, materialData.metallicRoughness.r, materialData.metallicRoughness.r);
-        }
-        else if(IS_INDEX(INDEX_METALLIC)) // Metallic
-        {
-             return float3(materialData.metallicRoughness.b, materialData.metallicRoughness.b, materialData.metallicRoughness.b);
-        }
-        else if(IS_INDEX(INDEX_ROUGHNESS)) // Roughness
-        {
-             return float3(materialData.metallicRoughness.g, materialData.metallicRoughness.g, materialData.metallicRoughness.g);
-        }
-    }
-
-    if(IS_INDEX(INDEX_ALBEDO))
-    {
-        return  pow(materialData.albedo, 1.f/2.2f);
-    }
-    else if(IS_INDEX(INDEX_NORMAL))
-    {
-        return materialData.normal*0.5f + 0.5f;
-    }
-    else if(IS_INDEX(INDEX_AO))
-    {
-        return materialData.ao;
-    }
-    else if(IS_INDEX(INDEX_METALLIC))
-    {
-        return materialData.metallic;
-    }
-    else if(IS_INDEX(INDEX_ROUGHNESS))
-    {
-        return materialData.roughness;
-    }
-    else if(IS_INDEX(INDEX_METALLIC_ROUGHNESS))
-    {
-        return materialData.metallicRoughness;
-    }
-    else
-    {
-        return float3(1.f, 0.f, 1.f);
-    }
+#if defined(DEBUG_ALBEDO)
+    return pow(materialData.albedo, 1.f/2.2f);
+#elif defined(DEBUG_NORMAL)
+    return materialData.normal*0.5f + 0.5f;
+#elif defined(DEBUG_AO)
+    float ao = GetAOData(materialData);
+    return float3(ao, ao, ao);
+#elif defined(DEBUG_METALLIC)
+    float metallic = GetMetallicData(materialData);
+    return float3(metallic, metallic, metallic);
+#elif defined(DEBUG_ROUGHNESS)
+    float roughness = GetRoughnessData(materialData);
+    return float3(roughness, roughness, roughness);
+#elif defined(DEBUG_METALLIC_ROUGHNESS)
+    return materialData.metallicRoughness;
+#else
+    return float3(1.f, 0.f, 1.f);
+#endif
 }
 
 struct PBRMaterial
@@ -246,6 +210,37 @@ float3 FresnelSchlick(float cosTheta, float3 F0, float roughness)
     return F0 + (max(v, F0) - F0) * pow(max(1.f - c, 0.f), 5.f);
 }
 
+/*
+    The light from one light source, with the Cook-Torrance BRDF.
+    @param invLightDir: Normalized direction from the surface to the light.
+    @param radiance: The light which reaches the surface.
+*/
+float3 CalcDirectLight(PBRMaterial material, float3 F0, float3 invLightDir, float3 radiance)
+{
+    material.invLightDir = invLightDir;
+
+    float nDotVMax = max(dot(material.normal, material.invViewDir), 0.f);
+    float nDotL = dot(material.normal, material.invLightDir);
+    float nDotLMax = max(nDotL, 0.f);
+
+    float3 h = normalize(material.invLightDir + material.normal);
+
+    float cosTheta = max(dot(material.normal, h), 0.f);
+    float NDF   = DistributionGGX(material.normal, h, material.roughness);
+    float G     = GeometrySmith(nDotVMax, nDotLMax, material.roughness);
+    float3 F    = FresnelSchlick(cosTheta, F0, material.roughness);
+
+    float3 ks = F;
+    material.kd = float3(1.f, 1.f, 1.f) - ks;
+    material.kd *= 1.f - material.metallic;
+
+    // BRDF
+    float denom = 4.f*nDotLMax*nDotVMax;
+    float3 specular = NDF*F*G / max(denom, 0.0001f);
+
+    return (material.kd * material.albedo / PI + specular) * radiance * nDotLMax;
+}
+
 float4 main(PSIn input) : SV_TARGET
 {
     MaterialData materialData;
@@ -261,8 +256,9 @@ float4 main(PSIn input) : SV_TARGET
 
     materialData.normal = CalcNormal(input.tangent.xyz, input.bitangent.xyz, input.normal.xyz, input.uv);
 
-    if(INDEX(materialInfo.y) > 0)
-        return float4(DebugTextures(materialData), 1.f);
+#ifdef DEBUG_TEXTURES
+    return float4(DebugTextures(materialData), 1.f);
+#endif
 
     PBRMaterial material;
     material.normal = materialData.normal;
@@ -278,66 +274,65 @@ float4 main(PSIn input) : SV_TARGET
     float3 Lo = float3(0.f, 0.f, 0.f);
     {
         float3 lightColor = float3(1.f, 1.f, 1.f);
-        float3 lightDir = normalize(input.worldPosition.xyz - lightPos.xyz);
-        material.invLightDir = -lightDir;
-
-        float nDotVMax = max(dot(material.normal, material.invViewDir), 0.f);
-        float nDotL = dot(material.normal, material.invLightDir);
-        float nDotLMax = max(nDotL, 0.f);
-
-        float3 h = normalize(material.invLightDir + material.normal);
+        float3 invLightDir = normalize(lightPos.xyz - input.worldPosition.xyz);
 
         float distance = length(lightPos.xyz - input.worldPosition.xyz);
         float attenuation = 1.f / (distance*distance);
         float3 radiance = lightColor * attenuation;
 
-        float cosTheta = max(dot(material.normal, h), 0.f);
-        float NDF   = DistributionGGX(material.normal, h, material.roughness);
-        float G     = GeometrySmith(nDotVMax, nDotLMax, material.roughness);
-        float3 F    = FresnelSchlick(cosTheta, F0, material.roughness);
-
-        float3 ks = F;
-        material.kd = float3(1.f, 1.f, 1.f) - ks;
-        material.kd *= 1.f - material.metallic;
-
-        // BRDF
-        float denom = 4.f*nDotLMax*nDotVMax;
-        float3 specular = NDF*F*G / max(denom, 0.0001f);
+        Lo += CalcDirectLight(material, F0, invLightDir, radiance);
+    }
 
-        Lo += (material.kd * material.albedo / PI + specular) * radiance * nDotL;
+    // The directional light, SV_Position.w is the view depth.
+    if (shadowLightDirection.w > 0.f)
+    {
+        float shadow = GetShadow(input.worldPosition.xyz, input.position.w);
+        float3 radiance = float3(1.f, 1.f, 1.f) * shadowLightDirection.w;
+        Lo += CalcDirectLight(material, F0, -shadowLightDirection.xyz, radiance) * shadow;
     }
 
-    float3 ambient = float3(0.f, 0.f, 0.f);
-    if(GET_FLAGS & FLAG_DIFF_IBL || GET_FLAGS & FLAG_SPEC_IBL)
+    // The clustered lights.
     {
-        if(GET_FLAGS & FLAG_DIFF_IBL)
+        uint2 cluster = GetCluster(input.position.xy, input.position.w);
+        for (uint i = 0; i < cluster.y; i++)
         {
-            float3 kS = FresnelSchlick(max(dot(material.normal, material.invViewDir), 0.f), F0, material.roughness);
-            float3 kD = 1.f - kS;
-            float3 irradiance = irradianceMap.Sample(linearSampler, material.normal).rgb;
-            float3 diffuse = irradiance * material.albedo;
-            ambient = kD * diffuse;
+            Light light = clusterLights[clusterLightIndices[cluster.x + i]];
+            float3 invLightDir;
+            float3 radiance = GetLightRadiance(light, input.worldPosition.xyz, invLightDir);
+            Lo += CalcDirectLight(material, F0, invLightDir, radiance);
         }
+    }
 
-        if(GET_FLAGS & FLAG_SPEC_IBL)
-        {
-            float3 R = reflect(-material.invViewDir, material.normal);
-            float3 prefilteredColor = preFilterMap.SampleLevel(linearSampler, R, material.roughness * materialInfo.z).rgb;
+    float3 ambient = float3(0.f, 0.f, 0.f);
+#if defined(DIFFUSE_IBL) || defined(SPECULAR_IBL)
+    #ifdef DIFFUSE_IBL
+    {
+        float3 kS = FresnelSchlick(max(dot(material.normal, material.invViewDir), 0.f), F0, material.roughness);
+        float3 kD = 1.f - kS;
+        float3 irradiance = irradianceMap.Sample(linearSampler, material.normal).rgb;
+        float3 diffuse = irradiance * material.albedo;
+        ambient = kD * diffuse;
+    }
+    #endif
 
-            float nDotV = max(dot(material.normal, material.invViewDir), 0.f);
-            float3 F = FresnelSchlick(nDotV, F0, material.roughness);
-            float2 envBRDF = brdfLUT.Sample(linearSampler, float2(nDotV, material.roughness)).rg;
-            float3 specular = prefilteredColor * (F * envBRDF.x + envBRDF.y);
+    #ifdef SPECULAR_IBL
+    {
+        float3 R = reflect(-material.invViewDir, material.normal);
+        float3 prefilteredColor = preFilterMap.SampleLevel(linearSampler, R, material.roughness * materialInfo.z).rgb;
 
-            ambient += specular;
-        }
+        float nDotV = max(dot(material.normal, material.invViewDir), 0.f);
+        float3 F = FresnelSchlick(nDotV, F0, material.roughness);
+        float2 envBRDF = brdfLUT.Sample(linearSampler, float2(nDotV, material.roughness)).rg;
+        float3 specular = prefilteredColor * (F * envBRDF.x + envBRDF.y);
 
-        ambient *= GetAOData(materialData);
-    }
-    else
-    {
-        ambient = float3(0.03f, 0.03f, 0.03f) * material.albedo * GetAOData(materialData);
+        ambient += specular;
     }
+    #endif
+
+    ambient *= GetAOData(materialData);
+#else
+    ambient = float3(0.03f, 0.03f, 0.03f) * material.albedo * GetAOData(materialData);
+#endif
 
     float3 color = ambient + Lo;
 
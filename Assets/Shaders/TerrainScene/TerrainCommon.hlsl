@@ -0,0 +1,33 @@
+/*
+    The frame data and the streamed terrain tiles of TerrainScene, shared by its vertex and fragment shader.
+    Each slice of the arrays is one tile of TerrainStreamer, its first sample is at the origin of the tile and its samples are tile.z world units apart.
+    The heights have one apron sample on each side, such that the normals at the edges of a tile read the samples of its neighbours.
+*/
+#define MAX_LODS 16
+
+// Same layout as TerrainScene::FrameData.
+cbuffer FrameData : register(b0)
+{
+    float4x4 viewProj;
+    float4 cameraPos;
+    float4 info; // x: Sample spacing, y: Height scale, z: Tile size, w: Patch mesh size.
+    float4 debug; // x: One to color the patches by their LOD.
+    float4 morphRanges[MAX_LODS]; // x: Morph start, y: Morph end.
+}
+
+Texture2DArray<float> heightTiles : register(t1);
+Texture2DArray<float4> splatTiles : register(t2);
+SamplerState tileSampler : register(s0);
+
+// tile, xy: World xz of the first sample, z: World units between the samples, w: Slice of the tile.
+float SampleHeight(float2 worldXZ, float4 tile)
+{
+    float2 uv = ((worldXZ - tile.xy) / tile.z + 1.5f) / (info.z + 3.f);
+    return heightTiles.SampleLevel(tileSampler, float3(uv, tile.w), 0.f) * info.y;
+}
+
+float4 SampleSplat(float2 worldXZ, float4 tile)
+{
+    float2 uv = ((worldXZ - tile.xy) / tile.z + 0.5f) / (info.z + 1.f);
+    return splatTiles.SampleLevel(tileSampler, float3(uv, tile.w), 0.f);
+}
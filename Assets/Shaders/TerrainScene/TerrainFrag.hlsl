@@ -0,0 +1,41 @@
+#include <TerrainScene/TerrainCommon.hlsl>
+
+struct PSIn
+{
+    float4 position : SV_POSITION;
+    float3 worldPos : POSITION;
+    float lod : LOD;
+    nointerpolation float4 tile : TILE;
+};
+
+float3 GetLodColor(float lod)
+{
+    static const float3 colors[4] = { float3(1.f, 0.3f, 0.3f), float3(0.3f, 1.f, 0.3f), float3(0.3f, 0.3f, 1.f), float3(1.f, 1.f, 0.3f) };
+    uint lodIndex = (uint)lod;
+    return lerp(colors[lodIndex % 4], colors[(lodIndex + 1) % 4], frac(lod));
+}
+
+float4 main(PSIn input) : SV_TARGET
+{
+    // The normal from the neighbouring samples of the tile, it does not change when the vertices morph.
+    float4 tile = input.tile;
+    float spacing = tile.z;
+    float heightLeft = SampleHeight(input.worldPos.xz - float2(spacing, 0.f), tile);
+    float heightRight = SampleHeight(input.worldPos.xz + float2(spacing, 0.f), tile);
+    float heightBack = SampleHeight(input.worldPos.xz - float2(0.f, spacing), tile);
+    float heightFront = SampleHeight(input.worldPos.xz + float2(0.f, spacing), tile);
+    float3 normal = normalize(float3(heightLeft - heightRight, 2.f * spacing, heightBack - heightFront));
+
+    // The four materials of the splat weights: sand, grass, rock and snow. Rock is added on the slopes for splat weights which only follow the height.
+    static const float3 materials[4] = { float3(0.55f, 0.5f, 0.35f), float3(0.22f, 0.36f, 0.12f), float3(0.4f, 0.37f, 0.33f), float3(0.95f, 0.95f, 0.97f) };
+    float4 weights = SampleSplat(input.worldPos.xz, tile);
+    float3 albedo = materials[0] * weights.x + materials[1] * weights.y + materials[2] * weights.z + materials[3] * weights.w;
+    float slope = 1.f - normal.y;
+    albedo = lerp(albedo, float3(0.4f, 0.37f, 0.33f), smoothstep(0.1f, 0.3f, slope));
+    if (debug.x > 0.5f)
+        albedo = GetLodColor(input.lod);
+
+    float3 sunDir = normalize(float3(0.4f, 0.8f, 0.3f));
+    float3 color = albedo * (0.15f + 0.85f * saturate(dot(normal, sunDir)));
+    return float4(color, 1.f);
+}
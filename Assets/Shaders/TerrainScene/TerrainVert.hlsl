@@ -0,0 +1,55 @@
+/*
+    The patches of TerrainScene, each instance is one patch of TerrainQuadtree drawn with the same grid mesh.
+    The vertices morph into the grid of the next LOD towards the end of the range of their LOD, such that neighbouring patches meet.
+*/
+#include <TerrainScene/TerrainCommon.hlsl>
+
+struct VSIn
+{
+    float2 gridPos : POSITION; // In quads of the mesh, [0, info.w].
+    uint instanceID : SV_InstanceID;
+};
+
+struct VSOut
+{
+    float4 position : SV_POSITION;
+    float3 worldPos : POSITION;
+    float lod : LOD;
+    nointerpolation float4 tile : TILE;
+};
+
+// Same layout as TerrainScene::PatchData.
+struct TerrainPatch
+{
+    float2 offset;
+    float size;
+    uint lod;
+    float2 tileOrigin;
+    float tileSpacing;
+    uint tileSlot;
+};
+
+StructuredBuffer<TerrainPatch> patches : register(t0);
+
+VSOut main(VSIn input)
+{
+    TerrainPatch patch = patches[input.instanceID];
+    float4 tile = float4(patch.tileOrigin, patch.tileSpacing, (float)patch.tileSlot);
+    float quadSize = patch.size / info.w;
+    float2 worldXZ = patch.offset + input.gridPos * quadSize;
+
+    float distance = length(cameraPos.xyz - float3(worldXZ.x, SampleHeight(worldXZ, tile), worldXZ.y));
+    float2 morphRange = morphRanges[patch.lod].xy;
+    float morph = saturate((distance - morphRange.x) / (morphRange.y - morphRange.x));
+
+    // The odd vertices slide onto their even neighbour, when fully morphed the patch is the grid of the next LOD.
+    float2 oddOffset = frac(input.gridPos * 0.5f) * 2.f;
+    worldXZ -= oddOffset * quadSize * morph;
+
+    VSOut output;
+    output.worldPos = float3(worldXZ.x, SampleHeight(worldXZ, tile), worldXZ.y);
+    output.position = mul(viewProj, float4(output.worldPos, 1.f));
+    output.lod = patch.lod + morph;
+    output.tile = tile;
+    return output;
+}
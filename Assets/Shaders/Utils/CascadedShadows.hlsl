@@ -0,0 +1,60 @@
+/*
+    The shadows of CascadedShadowMap, include this file and define the registers before it if the defaults are taken:
+        SHADOW_DATA_REGISTER: The ShadowData constant buffer.
+        SHADOW_MAP_REGISTER: The shadow map.
+        SHADOW_SAMPLER_REGISTER: The comparison sampler.
+    Usage:
+        float shadow = GetShadow(input.worldPosition.xyz, viewDepth);
+        Lo += CalcLight(-shadowLightDirection.xyz, ...) * shadowLightDirection.w * shadow;
+*/
+#ifndef SHADOW_DATA_REGISTER
+    #define SHADOW_DATA_REGISTER b3
+#endif
+#ifndef SHADOW_MAP_REGISTER
+    #define SHADOW_MAP_REGISTER t12
+#endif
+#ifndef SHADOW_SAMPLER_REGISTER
+    #define SHADOW_SAMPLER_REGISTER s1
+#endif
+
+#define MAX_CASCADES 4
+
+cbuffer ShadowData : register(SHADOW_DATA_REGISTER)
+{
+    float4x4 cascadeViewProj[MAX_CASCADES];
+    float4 cascadeSplits; // The far split of each cascade, as view depth.
+    float4 shadowLightDirection; // w: The intensity of the light.
+    float4 shadowParams; // x: Size of a texel, y: Number of cascades, z: Depth bias.
+}
+
+Texture2DArray shadowMap : register(SHADOW_MAP_REGISTER);
+SamplerComparisonState shadowSampler : register(SHADOW_SAMPLER_REGISTER);
+
+/*
+    @param worldPosition: World position of the surface.
+    @param viewDepth: The distance along the view direction, positive in front of the camera.
+    @return 0 when the surface is in shadow and 1 when it is lit, filtered with 3x3 samples.
+*/
+float GetShadow(float3 worldPosition, float viewDepth)
+{
+    uint numCascades = (uint)shadowParams.y;
+    uint cascade = 0;
+    while (cascade < numCascades && viewDepth > cascadeSplits[cascade])
+        cascade++;
+    if (cascade >= numCascades)
+        return 1.f;
+
+    float4 position = mul(cascadeViewProj[cascade], float4(worldPosition, 1.f));
+    float2 uv = position.xy * float2(0.5f, -0.5f) + 0.5f;
+    float depth = position.z - shadowParams.z;
+
+    float shadow = 0.f;
+    [unroll]
+    for (int y = -1; y <= 1; y++)
+    {
+        [unroll]
+        for (int x = -1; x <= 1; x++)
+            shadow += shadowMap.SampleCmpLevelZero(shadowSampler, float3(uv + float2(x, y) * shadowParams.x, cascade), depth);
+    }
+    return shadow / 9.f;
+}
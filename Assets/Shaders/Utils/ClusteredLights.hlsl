@@ -0,0 +1,85 @@
+/*
+    The light clusters uploaded by DeferredRenderer, include this file and define the registers before it if the defaults are taken:
+        CLUSTER_DATA_REGISTER: The ClusterData constant buffer.
+        CLUSTER_LIGHTS_REGISTER, CLUSTER_GRID_REGISTER, CLUSTER_INDICES_REGISTER: Three shader resources in a row, in the order of DeferredRenderer::Bind.
+    Usage:
+        uint2 cluster = GetCluster(input.position.xy, viewDepth);
+        for (uint i = 0; i < cluster.y; i++)
+        {
+            Light light = clusterLights[clusterLightIndices[cluster.x + i]];
+            ...
+        }
+*/
+#ifndef CLUSTER_DATA_REGISTER
+    #define CLUSTER_DATA_REGISTER b2
+#endif
+#ifndef CLUSTER_LIGHTS_REGISTER
+    #define CLUSTER_LIGHTS_REGISTER t9
+    #define CLUSTER_GRID_REGISTER t10
+    #define CLUSTER_INDICES_REGISTER t11
+#endif
+
+#define LIGHT_TYPE_POINT 0
+#define LIGHT_TYPE_SPOT 1
+
+// Same layout as LightClusters::Light.
+struct Light
+{
+    float3 position;
+    float range;
+    float3 color;
+    float intensity;
+    float3 direction;
+    float cosOuterAngle;
+    float cosInnerAngle;
+    uint type;
+    float2 padding;
+};
+
+cbuffer ClusterData : register(CLUSTER_DATA_REGISTER)
+{
+    uint3 clusterGridSize;
+    uint numClusterLights;
+    float clusterSliceScale;
+    float clusterSliceBias;
+    float2 clusterTileScale; // Pixels to tiles.
+}
+
+StructuredBuffer<Light> clusterLights : register(CLUSTER_LIGHTS_REGISTER);
+StructuredBuffer<uint2> clusterGrid : register(CLUSTER_GRID_REGISTER); // x: Offset in the index list, y: Number of lights.
+StructuredBuffer<uint> clusterLightIndices : register(CLUSTER_INDICES_REGISTER);
+
+/*
+    @param pixel: SV_Position.xy of the pixel.
+    @param viewDepth: The distance along the view direction, positive in front of the camera.
+    @return x: Offset in clusterLightIndices, y: Number of lights.
+*/
+uint2 GetCluster(float2 pixel, float viewDepth)
+{
+    uint3 cluster;
+    cluster.xy = min((uint2)(pixel * clusterTileScale), clusterGridSize.xy - 1);
+    cluster.z = (uint)clamp(log2(max(viewDepth, 0.0001f)) * clusterSliceScale + clusterSliceBias, 0.f, (float)(clusterGridSize.z - 1));
+    return clusterGrid[cluster.x + (cluster.y + cluster.z * clusterGridSize.y) * clusterGridSize.x];
+}
+
+/*
+    The light which reaches the position, without the BRDF.
+    @param light: The light.
+    @param position: World position of the surface.
+    @param invLightDir: Is set to the normalized direction from the surface to the light.
+*/
+float3 GetLightRadiance(Light light, float3 position, out float3 invLightDir)
+{
+    float3 toLight = light.position - position;
+    float distance = length(toLight);
+    invLightDir = toLight / max(distance, 0.0001f);
+
+    // Falls off with the square of the distance, and smoothly to zero at the range.
+    float rangeFactor = saturate(1.f - pow(distance / light.range, 4.f));
+    float attenuation = rangeFactor * rangeFactor / (distance * distance + 1.f);
+
+    if (light.type == LIGHT_TYPE_SPOT)
+        attenuation *= smoothstep(light.cosOuterAngle, light.cosInnerAngle, dot(-invLightDir, light.direction));
+
+    return light.color * light.intensity * attenuation;
+}
@@ -0,0 +1,19 @@
+struct VSIn
+{
+    float3 position : POSITION;
+};
+
+cbuffer MeshData : register(b0)
+{
+    float4x4 worldMat;
+}
+
+cbuffer CascadeData : register(b1)
+{
+    float4x4 lightViewProj;
+}
+
+float4 main(VSIn input) : SV_POSITION
+{
+    return mul(lightViewProj, mul(worldMat, float4(input.position, 1.f)));
+}
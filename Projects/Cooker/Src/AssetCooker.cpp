@@ -0,0 +1,288 @@
+#include "PreCompiled.h"
+#include "AssetCooker.h"
+
+#include "Core/VirtualFileSystem.h"
+#include "Loaders/CookedAssets.h"
+#include "Utils/Timer.h"
+
+#include <stb_image.h>
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+using namespace RS;
+
+namespace
+{
+	// The models are cooked with the import flags of a default ModelLoadDesc, a model loaded with other flags is imported from the source.
+	const ModelLoadDesc::LoaderFlags COOK_MODEL_FLAGS = ModelLoadDesc().Flags & ModelImporter::IMPORT_FLAGS_MASK;
+	const std::string DATABASE_PATH = "Cooked/CookDatabase.json";
+
+	// Tiles of 256 quads are 130 KB of heights and 260 KB of splat weights.
+	const uint32 COOK_TERRAIN_TILE_SIZE = 256;
+	const uint32 COOK_TERRAIN_LEAF_SIZE = 32;
+}
+
+AssetCooker::AssetCooker(const std::string& assetFolder) : m_AssetFolder(assetFolder), m_Database(assetFolder)
+{
+}
+
+bool AssetCooker::Cook(uint32 numThreads, bool force, Stats& outStats)
+{
+	Timer totalTimer;
+	totalTimer.Start();
+	outStats = Stats();
+
+	std::string databasePath = (std::filesystem::path(m_AssetFolder) / DATABASE_PATH).string();
+	if (!force)
+		m_Database.Load(databasePath, CookedAssets::VERSION);
+
+	// Find all assets, the cooked files are skipped.
+	std::vector<Job> jobs;
+	{
+		Timer scanTimer;
+		scanTimer.Start();
+		std::vector<std::string> paths;
+		LooseFileBackend(m_AssetFolder).ListFiles(paths);
+		for (const std::string& path : paths)
+		{
+			Job job;
+			job.Path = path;
+			if (path.compare(0, 7, "Cooked/") != 0 && GetAssetType(path, job.Type))
+				jobs.push_back(job);
+		}
+		outStats.ScanTimeMS = scanTimer.Stop().GetDeltaTimeMS();
+	}
+	outStats.NumAssets = (uint32)jobs.size();
+
+	// Models take the longest, start them first.
+	std::stable_sort(jobs.begin(), jobs.end(), [](const Job& a, const Job& b) { return a.Type == AssetType::MODEL && b.Type != AssetType::MODEL; });
+
+	std::atomic<uint32> nextJob = 0;
+	auto Worker = [&]()
+	{
+		for (uint32 index = nextJob++; index < (uint32)jobs.size(); index = nextJob++)
+			CookJob(jobs[index], force, outStats);
+	};
+
+	numThreads = std::clamp(numThreads, 1u, std::max((uint32)jobs.size(), 1u));
+	std::vector<std::thread> threads;
+	for (uint32 i = 1; i < numThreads; i++)
+		threads.emplace_back(Worker);
+	Worker();
+	for (std::thread& thread : threads)
+		thread.join();
+
+	std::error_code error;
+	std::filesystem::create_directories(std::filesystem::path(databasePath).parent_path(), error);
+	bool savedDatabase = m_Database.Save(databasePath);
+	if (!savedDatabase)
+		PrintError("Failed to save the dependency database " + databasePath);
+
+	outStats.NumHashedFiles	= m_Database.GetNumHashedFiles();
+	outStats.TotalTimeMS	= totalTimer.Stop().GetDeltaTimeMS();
+	return outStats.NumFailed == 0 && savedDatabase;
+}
+
+bool AssetCooker::CookJob(const Job& job, bool force, Stats& outStats)
+{
+	std::string options = GetOptions(job);
+	if (!force && m_Database.IsUpToDate(job.Path, options))
+	{
+		std::lock_guard<std::mutex> lock(m_StatsMutex);
+		outStats.NumUpToDate++;
+		return true;
+	}
+
+	std::vector<uint8> data;
+	std::vector<std::string> dependencies;
+	bool succeeded = false;
+	switch (job.Type)
+	{
+	case AssetType::IMAGE: succeeded = CookImage(job, data, dependencies); break;
+	case AssetType::MODEL: succeeded = CookModel(job, data, dependencies); break;
+	case AssetType::TERRAIN: succeeded = CookTerrain(job, data, dependencies); break;
+	default: break;
+	}
+
+	CookDatabase::Entry entry;
+	entry.Output	= GetOutputPath(job);
+	entry.Options	= options;
+	succeeded		= succeeded && WriteFile(entry.Output, data);
+
+	uint64 sourceBytes = 0;
+	for (const std::string& dependency : dependencies)
+	{
+		CookDatabase::FileStamp stamp;
+		if (succeeded && !m_Database.ComputeStamp(dependency, stamp))
+		{
+			PrintError("Failed to stamp the dependency " + dependency + " of " + job.Path);
+			succeeded = false;
+		}
+		entry.Dependencies[dependency] = stamp;
+		sourceBytes += stamp.Size;
+	}
+
+	// A failed asset does not get an entry, such that it is tried again the next time.
+	if (succeeded)
+		m_Database.SetEntry(job.Path, entry);
+	else
+		PrintError("Failed to cook " + job.Path);
+
+	std::lock_guard<std::mutex> lock(m_StatsMutex);
+	if (succeeded)
+	{
+		outStats.NumCooked++;
+		outStats.SourceBytes += sourceBytes;
+		outStats.CookedBytes += (uint64)data.size();
+	}
+	else
+	{
+		outStats.NumFailed++;
+	}
+	return succeeded;
+}
+
+bool AssetCooker::CookImage(const Job& job, std::vector<uint8>& outData, std::vector<std::string>& outDependencies)
+{
+	outDependencies.push_back(job.Path);
+
+	FileView view;
+	if (!VirtualFileSystem::Get()->Read(job.Path, view))
+		return false;
+	return CookedAssets::CookImage(view.pData, view.Size, GetExtension(job.Path) == "hdr", outData);
+}
+
+bool AssetCooker::CookModel(const Job& job, std::vector<uint8>& outData, std::vector<std::string>& outDependencies)
+{
+	// Every file Assimp opens is a dependency (e.g. the .bin file of a gltf model), textures are cooked on their own.
+	ImportedModel model;
+	bool succeeded = ModelImporter::ImportWithAssimp(job.Path, COOK_MODEL_FLAGS, model, &outDependencies);
+	if (std::find(outDependencies.begin(), outDependencies.end(), job.Path) == outDependencies.end())
+		outDependencies.push_back(job.Path);
+	return succeeded && CookedAssets::CookModel(model, COOK_MODEL_FLAGS, outDependencies, outData);
+}
+
+bool AssetCooker::CookTerrain(const Job& job, std::vector<uint8>& outData, std::vector<std::string>& outDependencies)
+{
+	// A raw square of 16 bit heights without a header, the size follows from the size of the file.
+	outDependencies.push_back(job.Path);
+	FileView view;
+	if (!VirtualFileSystem::Get()->Read(job.Path, view))
+		return false;
+
+	const uint32 size = (uint32)std::llround(std::sqrt((double)(view.Size / sizeof(uint16))));
+	if ((uint64)size * size * sizeof(uint16) != view.Size)
+	{
+		PrintError(job.Path + " is not a square of 16 bit heights");
+		return false;
+	}
+
+	// The splat weights are read from a RGBA image next to the heights, e.g. Valley.splat.png for Valley.r16, which has the same size.
+	std::vector<uint8> splat;
+	const std::string splatPath = job.Path.substr(0, job.Path.rfind('.')) + ".splat.png";
+	if (VirtualFileSystem::Get()->Exists(splatPath))
+	{
+		outDependencies.push_back(splatPath);
+		FileView splatView;
+		if (!VirtualFileSystem::Get()->Read(splatPath, splatView))
+			return false;
+
+		int width = 0, height = 0, channelCount = 0;
+		stbi_uc* pPixels = stbi_load_from_memory(splatView.pData, (int)splatView.Size, &width, &height, &channelCount, 4);
+		if (pPixels == nullptr || (uint32)width != size || (uint32)height != size)
+		{
+			PrintError("The splat map " + splatPath + " could not be decoded or is not " + std::to_string(size) + " x " + std::to_string(size));
+			stbi_image_free(pPixels);
+			return false;
+		}
+		splat.assign(pPixels, pPixels + (size_t)size * size * 4);
+		stbi_image_free(pPixels);
+	}
+
+	const uint32 tileSize = std::min(COOK_TERRAIN_TILE_SIZE, size);
+	const uint32 leafSize = std::min(COOK_TERRAIN_LEAF_SIZE, tileSize);
+	return CookedAssets::CookTerrain((const uint16*)view.pData, splat.empty() ? nullptr : splat.data(), size, tileSize, leafSize, outData);
+}
+
+bool AssetCooker::WriteFile(const std::string& path, const std::vector<uint8>& data)
+{
+	std::filesystem::path diskPath = std::filesystem::path(m_AssetFolder) / path;
+	std::error_code error;
+	std::filesystem::create_directories(diskPath.parent_path(), error);
+
+	std::ofstream file(diskPath, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		PrintError("Failed to open " + diskPath.string() + " for writing");
+		return false;
+	}
+	file.write((const char*)data.data(), (std::streamsize)data.size());
+	return file.good();
+}
+
+std::string AssetCooker::GetOutputPath(const Job& job) const
+{
+	std::string cookedPath;
+	switch (job.Type)
+	{
+	case AssetType::MODEL: cookedPath = CookedAssets::GetCookedModelPath(job.Path, COOK_MODEL_FLAGS); break;
+	case AssetType::TERRAIN: cookedPath = CookedAssets::GetCookedTerrainPath(job.Path); break;
+	default: cookedPath = CookedAssets::GetCookedImagePath(job.Path); break;
+	}
+	return VirtualFileSystem::NormalizePath(cookedPath);
+}
+
+std::string AssetCooker::GetOptions(const Job& job) const
+{
+	if (job.Type == AssetType::MODEL)
+		return "Model Flags=" + std::to_string(COOK_MODEL_FLAGS);
+	if (job.Type == AssetType::TERRAIN)
+		return "Terrain TileSize=" + std::to_string(COOK_TERRAIN_TILE_SIZE) + " LeafSize=" + std::to_string(COOK_TERRAIN_LEAF_SIZE);
+	return "Image";
+}
+
+void AssetCooker::PrintError(const std::string& message)
+{
+	std::lock_guard<std::mutex> lock(m_PrintMutex);
+	std::cout << "[Error] " << message << "\n";
+}
+
+bool AssetCooker::GetAssetType(const std::string& path, AssetType& outType)
+{
+	// Obj files are loaded with tinyobj and are not cooked.
+	static const std::vector<std::string> s_ImageExtensions = { "png", "jpg", "jpeg", "tga", "bmp", "hdr" };
+	static const std::vector<std::string> s_ModelExtensions = { "gltf", "glb", "fbx" };
+
+	std::string extension = GetExtension(path);
+	if (std::find(s_ImageExtensions.begin(), s_ImageExtensions.end(), extension) != s_ImageExtensions.end())
+	{
+		outType = AssetType::IMAGE;
+		return true;
+	}
+	if (std::find(s_ModelExtensions.begin(), s_ModelExtensions.end(), extension) != s_ModelExtensions.end())
+	{
+		outType = AssetType::MODEL;
+		return true;
+	}
+	if (extension == "r16")
+	{
+		outType = AssetType::TERRAIN;
+		return true;
+	}
+	return false;
+}
+
+std::string AssetCooker::GetExtension(const std::string& path)
+{
+	size_t dotPos = path.rfind('.');
+	if (dotPos == std::string::npos)
+		return "";
+	std::string extension = path.substr(dotPos + 1);
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return (char)std::tolower(c); });
+	return extension;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "CookDatabase.h"
+
+namespace RS
+{
+	/*
+	* Cooks all images, Assimp models and raw terrain heightmaps in the asset folder in parallel. Only assets which have changed since the last cook are cooked.
+	* The output is written to the Cooked folder inside the asset folder together with the dependency database.
+	*/
+	class AssetCooker
+	{
+	public:
+		struct Stats
+		{
+			uint32	NumAssets		= 0;
+			uint32	NumCooked		= 0;
+			uint32	NumUpToDate		= 0;
+			uint32	NumFailed		= 0;
+			uint32	NumHashedFiles	= 0;
+			uint64	SourceBytes		= 0; // Size of the sources of the cooked assets.
+			uint64	CookedBytes		= 0;
+			float	ScanTimeMS		= 0.f;
+			float	TotalTimeMS		= 0.f;
+		};
+
+	public:
+		RS_NO_COPY_AND_MOVE(AssetCooker);
+		AssetCooker(const std::string& assetFolder);
+		~AssetCooker() = default;
+
+		bool Cook(uint32 numThreads, bool force, Stats& outStats);
+
+	private:
+		enum class AssetType
+		{
+			IMAGE = 0,
+			MODEL,
+			TERRAIN
+		};
+
+		struct Job
+		{
+			std::string	Path	= "";
+			AssetType	Type	= AssetType::IMAGE;
+		};
+
+		bool CookJob(const Job& job, bool force, Stats& outStats);
+		bool CookImage(const Job& job, std::vector<uint8>& outData, std::vector<std::string>& outDependencies);
+		bool CookModel(const Job& job, std::vector<uint8>& outData, std::vector<std::string>& outDependencies);
+		bool CookTerrain(const Job& job, std::vector<uint8>& outData, std::vector<std::string>& outDependencies);
+		bool WriteFile(const std::string& path, const std::vector<uint8>& data);
+
+		std::string GetOutputPath(const Job& job) const;
+		std::string GetOptions(const Job& job) const;
+		void PrintError(const std::string& message);
+
+		static bool GetAssetType(const std::string& path, AssetType& outType);
+		static std::string GetExtension(const std::string& path);
+
+	private:
+		std::string		m_AssetFolder;
+		CookDatabase	m_Database;
+		std::mutex		m_PrintMutex;
+		std::mutex		m_StatsMutex;
+	};
+}
@@ -0,0 +1,168 @@
+#include "PreCompiled.h"
+#include "CookDatabase.h"
+
+#include "Core/MappedFile.h"
+#include "Loaders/CookedAssets.h"
+#include "Utils/Config.h"
+
+#include <filesystem>
+#include <fstream>
+
+using namespace RS;
+
+CookDatabase::CookDatabase(const std::string& assetFolder) : m_AssetFolder(assetFolder)
+{
+}
+
+bool CookDatabase::Load(const std::string& filePath, uint32 toolVersion)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_ToolVersion = toolVersion;
+	m_Entries.clear();
+
+	std::ifstream file(filePath);
+	if (!file.is_open())
+		return false;
+
+	json root = json::parse(file, nullptr, false);
+	if (root.is_discarded() || !root.is_object())
+		return false;
+
+	// Everything has to be cooked again if the tool has changed.
+	if (root.value("ToolVersion", 0u) != toolVersion)
+		return false;
+
+	for (auto& item : root["Entries"].items())
+	{
+		const json& jsonEntry = item.value();
+		Entry entry;
+		entry.Output	= jsonEntry.value("Output", "");
+		entry.Options	= jsonEntry.value("Options", "");
+		if (!jsonEntry.contains("Dependencies"))
+			continue;
+		for (auto& dependency : jsonEntry["Dependencies"].items())
+		{
+			const json& jsonStamp = dependency.value();
+			FileStamp stamp;
+			stamp.Size		= jsonStamp.value("Size", (uint64)0);
+			stamp.WriteTime	= jsonStamp.value("WriteTime", (int64)0);
+			stamp.Hash		= jsonStamp.value("Hash", (uint64)0);
+			entry.Dependencies[dependency.key()] = stamp;
+		}
+		m_Entries[item.key()] = entry;
+	}
+	return true;
+}
+
+bool CookDatabase::Save(const std::string& filePath) const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	json root;
+	root["ToolVersion"] = m_ToolVersion;
+	json& entries = root["Entries"];
+	entries = json::object();
+	for (auto& [sourcePath, entry] : m_Entries)
+	{
+		json& jsonEntry = entries[sourcePath];
+		jsonEntry["Output"]		= entry.Output;
+		jsonEntry["Options"]	= entry.Options;
+		json& dependencies = jsonEntry["Dependencies"];
+		for (auto& [dependencyPath, stamp] : entry.Dependencies)
+		{
+			json& jsonStamp = dependencies[dependencyPath];
+			jsonStamp["Size"]		= stamp.Size;
+			jsonStamp["WriteTime"]	= stamp.WriteTime;
+			jsonStamp["Hash"]		= stamp.Hash;
+		}
+	}
+
+	std::ofstream file(filePath);
+	if (!file.is_open())
+		return false;
+	file << root.dump(1, '\t');
+	return true;
+}
+
+bool CookDatabase::IsUpToDate(const std::string& sourcePath, const std::string& options)
+{
+	Entry entry;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		auto it = m_Entries.find(sourcePath);
+		if (it == m_Entries.end())
+			return false;
+		entry = it->second;
+	}
+
+	if (entry.Options != options || entry.Dependencies.empty())
+		return false;
+
+	std::error_code error;
+	if (!std::filesystem::exists(GetDiskPath(entry.Output), error))
+		return false;
+
+	bool touched = false;
+	for (auto& [dependencyPath, stamp] : entry.Dependencies)
+	{
+		std::string diskPath = GetDiskPath(dependencyPath);
+		uint64 size = (uint64)std::filesystem::file_size(diskPath, error);
+		if (error || size != stamp.Size)
+			return false;
+
+		int64 writeTime = (int64)std::filesystem::last_write_time(diskPath, error).time_since_epoch().count();
+		if (error)
+			return false;
+		if (writeTime == stamp.WriteTime)
+			continue;
+
+		// The file was written to, but it might have the same content.
+		uint64 hash = 0;
+		if (!HashFile(diskPath, hash) || hash != stamp.Hash)
+			return false;
+		m_NumHashedFiles++;
+		stamp.WriteTime = writeTime;
+		touched = true;
+	}
+
+	// Remember the new write times, such that the files are not hashed again the next time.
+	if (touched)
+		SetEntry(sourcePath, entry);
+	return true;
+}
+
+void CookDatabase::SetEntry(const std::string& sourcePath, const Entry& entry)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Entries[sourcePath] = entry;
+}
+
+bool CookDatabase::ComputeStamp(const std::string& path, FileStamp& outStamp) const
+{
+	std::string diskPath = GetDiskPath(path);
+	std::error_code error;
+	outStamp.Size = (uint64)std::filesystem::file_size(diskPath, error);
+	if (error)
+		return false;
+	outStamp.WriteTime = (int64)std::filesystem::last_write_time(diskPath, error).time_since_epoch().count();
+	if (error)
+		return false;
+	m_NumHashedFiles++;
+	return HashFile(diskPath, outStamp.Hash);
+}
+
+std::string CookDatabase::GetDiskPath(const std::string& path) const
+{
+	return (std::filesystem::path(m_AssetFolder) / path).string();
+}
+
+bool CookDatabase::HashFile(const std::string& diskPath, uint64& outHash)
+{
+	MappedFile file;
+	if (!file.Open(diskPath))
+		return false;
+
+	// The same hash as the stamps in the cooked files.
+	outHash = CookedAssets::HashData(file.GetData(), file.GetSize());
+	return true;
+}
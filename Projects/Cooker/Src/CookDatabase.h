@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+namespace RS
+{
+	/*
+	* Remembers what every cooked asset was cooked from, such that only changed assets are cooked again.
+	* An asset is up to date when the tool version and the options are the same and none of its dependencies have changed.
+	* The size and write time of a dependency is checked first, the content is only hashed when they differ.
+	*/
+	class CookDatabase
+	{
+	public:
+		struct FileStamp
+		{
+			uint64	Size		= 0;
+			int64	WriteTime	= 0;
+			uint64	Hash		= 0;
+		};
+
+		struct Entry
+		{
+			std::string									Output		= ""; // Relative to the asset folder.
+			std::string									Options		= "";
+			std::unordered_map<std::string, FileStamp>	Dependencies;
+		};
+
+	public:
+		RS_NO_COPY_AND_MOVE(CookDatabase);
+		CookDatabase(const std::string& assetFolder);
+		~CookDatabase() = default;
+
+		/*
+		* Entries which were written by another tool version are discarded.
+		*/
+		bool Load(const std::string& filePath, uint32 toolVersion);
+		bool Save(const std::string& filePath) const;
+
+		/*
+		* Thread safe.
+		*/
+		bool IsUpToDate(const std::string& sourcePath, const std::string& options);
+		void SetEntry(const std::string& sourcePath, const Entry& entry);
+
+		/*
+		* Stamp a file relative to the asset folder. Returns false if it could not be read.
+		*/
+		bool ComputeStamp(const std::string& path, FileStamp& outStamp) const;
+
+		uint32 GetNumHashedFiles() const { return m_NumHashedFiles; }
+
+	private:
+		std::string GetDiskPath(const std::string& path) const;
+		static bool HashFile(const std::string& diskPath, uint64& outHash);
+
+	private:
+		std::string								m_AssetFolder;
+		uint32									m_ToolVersion		= 0;
+		mutable std::mutex						m_Mutex;
+		std::unordered_map<std::string, Entry>	m_Entries;
+		mutable std::atomic<uint32>				m_NumHashedFiles	= 0;
+	};
+}
@@ -0,0 +1,74 @@
+#include <iostream>
+#include <thread>
+#include <algorithm>
+
+#include "AssetCooker.h"
+#include "Core/VirtualFileSystem.h"
+
+using namespace RS;
+
+namespace
+{
+	void PrintUsage()
+	{
+		std::cout << "Usage:\n";
+		std::cout << "\tCooker [assetFolder] [--force] [--threads N]\n";
+		std::cout << "\t\tCook all changed images and models in the asset folder (Default: " << RS_ASSET_PATH << ").\n";
+		std::cout << "\t\t--force cooks everything, even if it is up to date.\n";
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	Logger::Init();
+
+	std::string assetFolder	= RS_ASSET_PATH;
+	bool force				= false;
+	uint32 numThreads		= std::max(std::thread::hardware_concurrency(), 1u);
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg == "--force")
+			force = true;
+		else if (arg == "--threads" && i + 1 < argc)
+			numThreads = (uint32)std::max(1, std::atoi(argv[++i]));
+		else if (arg == "--help")
+		{
+			PrintUsage();
+			return 0;
+		}
+		else if (arg.rfind("--", 0) == 0)
+		{
+			std::cout << "Unknown option " << arg << "\n";
+			PrintUsage();
+			return 1;
+		}
+		else
+			assetFolder = arg;
+	}
+
+	VirtualFileSystem::Get()->Init();
+	if (!VirtualFileSystem::Get()->MountLooseFiles(assetFolder))
+	{
+		std::cout << "Failed to mount " << assetFolder << "\n";
+		return 1;
+	}
+
+	AssetCooker cooker(assetFolder);
+	AssetCooker::Stats stats;
+	bool succeeded = cooker.Cook(numThreads, force, stats);
+	VirtualFileSystem::Get()->Release();
+
+	const float sourceMB = (float)stats.SourceBytes / (1024.f * 1024.f);
+	const float cookedMB = (float)stats.CookedBytes / (1024.f * 1024.f);
+	std::cout << "Cooked " << stats.NumCooked << " of " << stats.NumAssets << " assets with " << numThreads << " threads in " << stats.TotalTimeMS << " ms"
+		<< " (" << stats.NumUpToDate << " up to date, " << stats.NumFailed << " failed)\n";
+	std::cout << "\tScan: " << stats.ScanTimeMS << " ms, hashed files: " << stats.NumHashedFiles << "\n";
+	if (stats.NumCooked > 0)
+	{
+		std::cout << "\tSource: " << sourceMB << " MB -> Cooked: " << cookedMB << " MB, "
+			<< (stats.TotalTimeMS > 0.f ? sourceMB / (stats.TotalTimeMS / 1000.f) : 0.f) << " MB/s, "
+			<< (stats.TotalTimeMS > 0.f ? (float)stats.NumCooked / (stats.TotalTimeMS / 1000.f) : 0.f) << " assets/s\n";
+	}
+	return succeeded ? 0 : 1;
+}
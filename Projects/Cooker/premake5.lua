@@ -0,0 +1,78 @@
+-- Command line tool which cooks the assets into runtime-ready files (See CookedAssets in the Sandbox).
+project "Cooker"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++latest"
+	systemversion "latest"
+
+	forceincludes
+	{
+		"PreCompiled.h"
+	}
+
+	-- Targets
+	targetdir ("%{wks.location}/Build/bin/" .. outputdir .. "/%{prj.name}")
+	objdir ("%{wks.location}/Build/obj/" .. outputdir .. "/%{prj.name}")
+
+	-- Files to include, the importers and file formats are shared with the Sandbox.
+	files
+	{
+		"Src/**.h",
+		"Src/**.cpp",
+		"../Sandbox/Src/PreCompiled.h",
+		"../Sandbox/Src/Utils/Logger.h",
+		"../Sandbox/Src/Utils/Logger.cpp",
+		"../Sandbox/Src/Utils/Timer.h",
+		"../Sandbox/Src/Utils/Timer.cpp",
+		"../Sandbox/Src/Utils/Compression.h",
+		"../Sandbox/Src/Utils/Compression.cpp",
+		"../Sandbox/Src/Core/FileView.h",
+		"../Sandbox/Src/Core/MappedFile.h",
+		"../Sandbox/Src/Core/MappedFile.cpp",
+		"../Sandbox/Src/Core/PackArchive.h",
+		"../Sandbox/Src/Core/PackArchive.cpp",
+		"../Sandbox/Src/Core/VirtualFileSystem.h",
+		"../Sandbox/Src/Core/VirtualFileSystem.cpp",
+		"../Sandbox/Src/Loaders/AssimpIOSystem.h",
+		"../Sandbox/Src/Loaders/AssimpIOSystem.cpp",
+		"../Sandbox/Src/Loaders/ModelImporter.h",
+		"../Sandbox/Src/Loaders/ModelImporter.cpp",
+		"../Sandbox/Src/Loaders/CookedAssets.h",
+		"../Sandbox/Src/Loaders/CookedAssets.cpp"
+	}
+
+	--Includes
+	includedirs { "Src", "../Sandbox/Src" }
+
+	sysincludedirs
+	{
+		"%{includeDir.glm}",
+		"%{includeDir.spdlog}",
+		"%{includeDir.stb}",
+		"%{includeDir.json}",
+		"%{includeDir.assimp}"
+	}
+
+	filter "configurations:Debug"
+		links
+		{
+			"%{libDir.assimp}/assimp-vc142-mtd.lib",
+			"%{libDir.assimp}/zlibstaticd.lib",
+			"%{libDir.assimp}/dracod.lib"
+		}
+
+	filter "configurations:Release"
+		links
+		{
+			"%{libDir.assimp}/assimp-vc142-mt.lib",
+			"%{libDir.assimp}/zlibstatic.lib",
+			"%{libDir.assimp}/draco.lib"
+		}
+	filter "configurations:Production"
+		links
+		{
+			"%{libDir.assimp}/assimp-vc142-mt.lib",
+			"%{libDir.assimp}/zlibstatic.lib",
+			"%{libDir.assimp}/draco.lib"
+		}
+	filter {}
@@ -0,0 +1,163 @@
+#include <iostream>
+#include <filesystem>
+#include <algorithm>
+
+#include "Core/PackArchive.h"
+#include "Core/VirtualFileSystem.h"
+#include "Utils/Timer.h"
+
+using namespace RS;
+
+namespace
+{
+	void PrintUsage()
+	{
+		std::cout << "Usage:\n";
+		std::cout << "\tPacker pack <assetFolder> <outputFile> [--no-compression] [--alignment N]\n";
+		std::cout << "\t\tPack all files in the asset folder into a single archive.\n";
+		std::cout << "\tPacker bench <assetFolder> <packFile>\n";
+		std::cout << "\t\tCompare reading all files as loose files against reading them from the archive.\n";
+	}
+
+	/*
+	* Files which already are compressed will not get any smaller, store them as they are.
+	*/
+	bool ShouldCompress(const std::string& path)
+	{
+		std::string extension = std::filesystem::path(path).extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return (char)std::tolower(c); });
+		return extension != ".png" && extension != ".jpg" && extension != ".jpeg" && extension != ".glb";
+	}
+
+	int Pack(const std::string& assetFolder, const std::string& outputFile, bool compress, uint32 alignment)
+	{
+		LooseFileBackend looseFiles(assetFolder);
+		std::vector<std::string> paths;
+		looseFiles.ListFiles(paths);
+		if (paths.empty())
+		{
+			std::cout << "No files found in " << assetFolder << "\n";
+			return 1;
+		}
+
+		std::vector<PackArchive::SourceFile> files;
+		files.reserve(paths.size());
+		for (const std::string& path : paths)
+		{
+			PackArchive::SourceFile file;
+			file.Path				= path;
+			file.DiskPath			= (std::filesystem::path(assetFolder) / path).string();
+			file.AllowCompression	= ShouldCompress(path);
+			files.push_back(file);
+		}
+
+		Timer timer;
+		timer.Start();
+		PackArchive::WriteStats stats;
+		if (!PackArchive::Write(outputFile, files, alignment, compress, 0.1f, stats))
+		{
+			std::cout << "Failed to write " << outputFile << "\n";
+			return 1;
+		}
+		float timeMS = timer.Stop().GetDeltaTimeMS();
+
+		std::cout << "Packed " << stats.NumEntries << " files (" << stats.NumCompressed << " compressed) into " << outputFile << " in " << timeMS << " ms\n";
+		std::cout << "\tFile size: " << (stats.UncompressedBytes / 1024) << " KB -> Archive size: " << (stats.ArchiveBytes / 1024) << " KB\n";
+		return 0;
+	}
+
+	/*
+	* Reads every file once and touches every byte, to make sure memory mapped pages are loaded.
+	*/
+	void ReadAll(const IFileBackend& backend, const std::vector<std::string>& paths, const std::string& name)
+	{
+		uint64 totalBytes	= 0;
+		uint64 checksum		= 0;
+		uint32 numFailed	= 0;
+
+		Timer timer;
+		timer.Start();
+		for (const std::string& path : paths)
+		{
+			FileView view;
+			if (!backend.Read(path, view))
+			{
+				numFailed++;
+				continue;
+			}
+
+			for (uint64 i = 0; i < view.Size; i++)
+				checksum += view.pData[i];
+			totalBytes += view.Size;
+		}
+		float timeMS = timer.Stop().GetDeltaTimeMS();
+
+		float megaBytes = (float)totalBytes / (1024.f * 1024.f);
+		std::cout << "\t" << name << ": " << timeMS << " ms, " << (timeMS > 0.f ? megaBytes / (timeMS / 1000.f) : 0.f) << " MB/s"
+			<< " (" << megaBytes << " MB, checksum " << checksum << (numFailed > 0 ? ", " + std::to_string(numFailed) + " failed" : std::string("")) << ")\n";
+	}
+
+	int Bench(const std::string& assetFolder, const std::string& packFile)
+	{
+		LooseFileBackend looseFiles(assetFolder);
+		PackFileBackend packedFiles;
+		if (!packedFiles.Open(packFile))
+		{
+			std::cout << "Failed to open " << packFile << "\n";
+			return 1;
+		}
+
+		std::vector<std::string> paths;
+		packedFiles.ListFiles(paths);
+
+		// The first pass is the first access in this process. It is only cold if the OS file cache does not have the files yet.
+		std::cout << "Reading " << paths.size() << " files.\n";
+		std::cout << "First pass:\n";
+		ReadAll(looseFiles, paths, "Loose");
+		ReadAll(packedFiles, paths, "Packed");
+		std::cout << "Second pass:\n";
+		ReadAll(looseFiles, paths, "Loose");
+		ReadAll(packedFiles, paths, "Packed");
+		return 0;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	Logger::Init();
+
+	if (argc < 4)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	std::string command = argv[1];
+	if (command == "pack")
+	{
+		bool compress		= true;
+		uint32 alignment	= 64;
+		for (int i = 4; i < argc; i++)
+		{
+			std::string option = argv[i];
+			if (option == "--no-compression")
+				compress = false;
+			else if (option == "--alignment" && i + 1 < argc)
+				alignment = (uint32)std::max(1, std::atoi(argv[++i]));
+			else
+			{
+				std::cout << "Unknown option " << option << "\n";
+				PrintUsage();
+				return 1;
+			}
+		}
+		return Pack(argv[2], argv[3], compress, alignment);
+	}
+	else if (command == "bench")
+	{
+		return Bench(argv[2], argv[3]);
+	}
+
+	PrintUsage();
+	return 1;
+}
@@ -0,0 +1,44 @@
+-- Command line tool which packs the asset folder into a single pack archive, which the VirtualFileSystem can mount.
+project "Packer"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++latest"
+	systemversion "latest"
+
+	forceincludes
+	{
+		"PreCompiled.h"
+	}
+
+	-- Targets
+	targetdir ("%{wks.location}/Build/bin/" .. outputdir .. "/%{prj.name}")
+	objdir ("%{wks.location}/Build/obj/" .. outputdir .. "/%{prj.name}")
+
+	-- Files to include, the archive code is shared with the Sandbox.
+	files
+	{
+		"Src/**.h",
+		"Src/**.cpp",
+		"../Sandbox/Src/PreCompiled.h",
+		"../Sandbox/Src/Utils/Logger.h",
+		"../Sandbox/Src/Utils/Logger.cpp",
+		"../Sandbox/Src/Utils/Timer.h",
+		"../Sandbox/Src/Utils/Timer.cpp",
+		"../Sandbox/Src/Utils/Compression.h",
+		"../Sandbox/Src/Utils/Compression.cpp",
+		"../Sandbox/Src/Core/FileView.h",
+		"../Sandbox/Src/Core/MappedFile.h",
+		"../Sandbox/Src/Core/MappedFile.cpp",
+		"../Sandbox/Src/Core/PackArchive.h",
+		"../Sandbox/Src/Core/PackArchive.cpp",
+		"../Sandbox/Src/Core/VirtualFileSystem.h",
+		"../Sandbox/Src/Core/VirtualFileSystem.cpp"
+	}
+
+	--Includes
+	includedirs { "Src", "../Sandbox/Src" }
+
+	sysincludedirs
+	{
+		"%{includeDir.spdlog}"
+	}
@@ -9,12 +9,17 @@
 #include "Core/Display.h"
 #include "Core/Input.h"
 #include "Core/ResourceManager.h"
+#include "Core/VirtualFileSystem.h"
+#include "Loaders/CookedAssets.h"
 
 #include "Renderer/RenderAPI.h"
 #include "Renderer/Renderer.h"
 #include "Renderer/DebugRenderer.h"
 #include "Renderer/ImGuiRenderer.h"
 #include "Renderer/ShaderHotReloader.h"
+#include "Renderer/ShaderCache.h"
+#include "Renderer/StateCache.h"
+#include "Renderer/RenderTargetPool.h"
 
 #include "Core/ResourceInspector.h"
 
@@ -28,6 +33,17 @@ void RS::EngineLoop::Init(std::function<void(void)> fixedTickCallback, std::func
     Logger::Init();
     Config::Get()->Init(RS_CONFIG_FILE_PATH);
 
+    // Packs are mounted first, such that they are searched before the loose files.
+    VirtualFileSystem::Get()->Init();
+    if (Config::Get()->Fetch<bool>("FileSystem/UsePack", false))
+    {
+        std::string packPath = Config::Get()->Fetch<std::string>("FileSystem/PackPath", "../../Assets.rspak");
+        if (!VirtualFileSystem::Get()->MountPack(packPath))
+            LOG_WARNING("Failed to mount pack {}, using loose files only!", packPath.c_str());
+    }
+    VirtualFileSystem::Get()->MountLooseFiles(RS_ASSET_PATH);
+    CookedAssets::SetEnabled(Config::Get()->Fetch<bool>("FileSystem/UseCookedAssets", true));
+
     DisplayDescription displayDesc = {};
     displayDesc.Title       = Config::Get()->Fetch<std::string>("Display/Title", "Arcane Engine");
     displayDesc.Width       = Config::Get()->Fetch<uint32>("Display/DefaultWidth", 1920);
@@ -38,8 +54,18 @@ void RS::EngineLoop::Init(std::function<void(void)> fixedTickCallback, std::func
     Input::Get()->Init();
     displayDesc = Display::Get()->GetDescription();
     RenderAPI::Get()->Init(displayDesc);
+
+    bool useShaderCache     = Config::Get()->Fetch<bool>("Shaders/UseCache", true);
+    uint64 shaderCacheSize  = (uint64)Config::Get()->Fetch<uint32>("Shaders/CacheSizeMB", 64) * 1024 * 1024;
+    ShaderCache::Get()->Init(std::string(RS_COOKED_PATH) + "Shaders/", shaderCacheSize, useShaderCache);
+
     Renderer::Get()->Init(displayDesc.Width, displayDesc.Height, true);
     DebugRenderer::Get()->Init();
+
+    // Compare a run with an empty cache (cold) to a run after it (warm) to see what the cache saves.
+    ShaderCache::Stats shaderStats = ShaderCache::Get()->GetStats();
+    LOG_INFO("Initialized shaders in {:.1f} ms ({} from cache, {} compiled)", shaderStats.PreprocessTimeMS + shaderStats.CompileTimeMS + shaderStats.LoadTimeMS,
+        shaderStats.NumHits, shaderStats.NumMisses);
     ImGuiRenderer::Init(Display::Get().get());
 
     ShaderHotReloader::Init();
@@ -58,8 +84,10 @@ void RS::EngineLoop::Release()
     ImGuiRenderer::Release();
     DebugRenderer::Get()->Release();
     Renderer::Get()->Release();
+    ShaderCache::Get()->Release();
     RenderAPI::Get()->Release();
     Display::Get()->Release();
+    VirtualFileSystem::Get()->Release();
 }
 
 void RS::EngineLoop::Run()
@@ -116,6 +144,10 @@ void RS::EngineLoop::Tick(const FrameStats& frameStats)
 
     ShaderHotReloader::Update();
 
+    StateCache::Get()->NewFrame();
+    RenderTargetPool::Get()->NewFrame();
+    DebugRenderer::Get()->NewFrame(frameStats.frame.currentDT);
+
     std::shared_ptr<Renderer> renderer = Renderer::Get();
     renderer->BeginScene(0.f, 0.f, 0.f, 1.f);
 
@@ -124,6 +156,8 @@ void RS::EngineLoop::Tick(const FrameStats& frameStats)
     DebugRenderer::Get()->Render();
 
     ImGuiRenderer::Render();
+    // The ImGui backend binds its state directly on the context.
+    StateCache::Get()->Invalidate();
     renderer->Present();
 }
 
@@ -163,7 +197,7 @@ void RS::EngineLoop::DrawFrameStats(const FrameStats& frameStats)
         uint32 displayWidth = Display::Get()->GetWidth();
         float scale = ImGuiRenderer::GetGuiScale();
         const uint32 width  = (uint32)(260.f * scale);
-        const uint32 height = (uint32)(405.f * scale);
+        const uint32 height = (uint32)(640.f * scale);
 
         // Draw the stats in the top right corner.
         ImGui::SetNextWindowPos(ImVec2((float)displayWidth - width, 0));
@@ -239,8 +273,44 @@ void RS::EngineLoop::DrawFrameStats(const FrameStats& frameStats)
                 const DebugRenderer::Stats& stats = DebugRenderer::Get()->GetStats();
                 ImGui::Indent();
                 ImGui::Text("Num line vertices: %d", stats.NumberOfLineVertices);
-                ImGui::Text("Num point vertices: %d", stats.NumberOfPointVertices);
+                ImGui::Text("Num points: %d", stats.NumberOfPoints);
+                ImGui::Text("Num shapes: %d", stats.NumberOfShapes);
+                ImGui::Text("Num glyphs: %d", stats.NumberOfGlyphs);
+                ImGui::Text("Num meshes: %d (%d wireframe vertices)", stats.NumberOfMeshes, stats.NumberOfWireframeVertices);
                 ImGui::Text("Num IDs: %d", stats.NumberOfIDs);
+                ImGui::Text("Draw calls: %d", stats.NumberOfDrawCalls);
+                ImGui::Text("Uploaded: %.2f KB of %.2f MB", (float)stats.NumberOfUploadedBytes / 1024.f, (float)stats.NumberOfBufferBytes / (1024.f * 1024.f));
+                ImGui::Text("Update time: %.3f ms", stats.UpdateTimeMS);
+                ImGui::Text("Timed buckets: %d (%d vertices expired)", stats.NumberOfTimedBuckets, stats.NumberOfExpiredVertices);
+                ImGui::Text("Thread commands: %d", stats.NumberOfThreadCommands);
+                ImGui::Unindent();
+            }
+
+            ImGui::NewLine();
+            ImGui::Text("State Cache");
+            {
+                std::shared_ptr<StateCache> stateCache = StateCache::Get();
+                const StateCache::Stats& stats = stateCache->GetFrameStats();
+                ImGui::Indent();
+                ImGui::Text("Filtering:");
+                ImGui::SameLine(); OnOffText(stateCache->IsFiltering(), "On", "Off");
+                ImGui::Text("Binds requested: %d", stats.NumRequested);
+                ImGui::Text("Calls issued: %d", stats.NumIssued);
+                ImGui::Text("Filtered: %d", stats.NumFiltered);
+                ImGui::Text("Coalesced: %d", stats.NumCoalesced);
+                ImGui::Text("Draws: %d", stats.NumDraws);
+                ImGui::Unindent();
+            }
+
+            ImGui::NewLine();
+            ImGui::Text("Render Target Pool");
+            {
+                const RenderTargetPool::Stats& stats = RenderTargetPool::Get()->GetStats();
+                ImGui::Indent();
+                ImGui::Text("Targets: %d (%d in use)", stats.NumTargets, stats.NumInUse);
+                ImGui::Text("Held: %.2f / %.2f MB", (float)stats.BytesHeld / (1024.f * 1024.f), (float)stats.BudgetBytes / (1024.f * 1024.f));
+                ImGui::Text("Hits: %d Misses: %d", stats.NumHits, stats.NumMisses);
+                ImGui::Text("Evicted: %d", stats.NumEvicted);
                 ImGui::Unindent();
             }
 
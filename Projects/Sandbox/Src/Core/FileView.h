@@ -0,0 +1,23 @@
+#pragma once
+
+#include <memory>
+
+namespace RS
+{
+	/*
+	* A read-only view of the content of a file.
+	* The data is either borrowed from a memory mapped file (zero-copy) or owned by the view (e.g. decompressed data).
+	* The view keeps the memory alive through pOwner, except for views into a mounted pack archive,
+	* which are valid for as long as the archive is mounted.
+	*/
+	struct FileView
+	{
+		const uint8*			pData		= nullptr;
+		uint64					Size		= 0;
+		bool					IsZeroCopy	= false;
+		std::shared_ptr<void>	pOwner		= nullptr;
+
+		bool IsValid() const { return pData != nullptr || (Size == 0 && pOwner != nullptr); }
+		std::string ToString() const { return std::string((const char*)pData, (size_t)Size); }
+	};
+}
@@ -0,0 +1,69 @@
+#include "PreCompiled.h"
+#include "MappedFile.h"
+
+using namespace RS;
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+bool MappedFile::Open(const std::string& filePath)
+{
+	Close();
+
+	m_FileHandle = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (m_FileHandle == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize = {};
+	if (!GetFileSizeEx(m_FileHandle, &fileSize))
+	{
+		Close();
+		return false;
+	}
+	m_Size = (uint64)fileSize.QuadPart;
+
+	// Empty files cannot be mapped, but they are still valid files.
+	if (m_Size == 0)
+		return true;
+
+	m_MappingHandle = CreateFileMappingA(m_FileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (m_MappingHandle == NULL)
+	{
+		Close();
+		return false;
+	}
+
+	m_pData = (const uint8*)MapViewOfFile(m_MappingHandle, FILE_MAP_READ, 0, 0, 0);
+	if (m_pData == nullptr)
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (m_pData)
+	{
+		UnmapViewOfFile(m_pData);
+		m_pData = nullptr;
+	}
+
+	if (m_MappingHandle != NULL)
+	{
+		CloseHandle(m_MappingHandle);
+		m_MappingHandle = NULL;
+	}
+
+	if (m_FileHandle != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(m_FileHandle);
+		m_FileHandle = INVALID_HANDLE_VALUE;
+	}
+
+	m_Size = 0;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+namespace RS
+{
+	/*
+	* A read-only memory mapped file.
+	*/
+	class MappedFile
+	{
+	public:
+		RS_NO_COPY_AND_MOVE(MappedFile);
+		MappedFile() = default;
+		~MappedFile();
+
+		bool Open(const std::string& filePath);
+		void Close();
+
+		bool IsOpen() const { return m_FileHandle != INVALID_HANDLE_VALUE; }
+		const uint8* GetData() const { return m_pData; }
+		uint64 GetSize() const { return m_Size; }
+
+	private:
+		HANDLE			m_FileHandle	= INVALID_HANDLE_VALUE;
+		HANDLE			m_MappingHandle	= NULL;
+		const uint8*	m_pData			= nullptr;
+		uint64			m_Size			= 0;
+	};
+}
@@ -0,0 +1,255 @@
+#include "PreCompiled.h"
+#include "PackArchive.h"
+
+#include "Utils/Compression.h"
+
+#include <algorithm>
+#include <fstream>
+
+using namespace RS;
+
+bool PackArchive::Open(const std::string& filePath)
+{
+	Close();
+
+	if (!m_File.Open(filePath))
+	{
+		LOG_WARNING("Failed to open pack archive {}!", filePath.c_str());
+		return false;
+	}
+
+	const uint8* pBase = m_File.GetData();
+	uint64 size = m_File.GetSize();
+	if (size < sizeof(Header))
+	{
+		LOG_ERROR("Pack archive {} is too small!", filePath.c_str());
+		Close();
+		return false;
+	}
+
+	const Header* pHeader = (const Header*)pBase;
+	if (pHeader->Magic != MAGIC || pHeader->Version != VERSION)
+	{
+		LOG_ERROR("Pack archive {} has the wrong magic or version! Version: {}, expected {}", filePath.c_str(), pHeader->Version, VERSION);
+		Close();
+		return false;
+	}
+
+	// The offsets are compared with what is left of the file, such that a corrupt offset can not overflow.
+	if (pHeader->TOCOffset > size || pHeader->NumEntries > (size - pHeader->TOCOffset) / sizeof(Entry)
+		|| pHeader->StringsOffset > size || pHeader->StringsSize > size - pHeader->StringsOffset)
+	{
+		LOG_ERROR("Pack archive {} is corrupt, the table of contents is outside of the file!", filePath.c_str());
+		Close();
+		return false;
+	}
+
+	m_pHeader	= pHeader;
+	m_pEntries	= (const Entry*)(pBase + pHeader->TOCOffset);
+	m_pStrings	= (const char*)(pBase + pHeader->StringsOffset);
+
+	// Every entry is checked once here, Find and GetPath trust them after this. Find needs the paths to be sorted and unique.
+	for (uint32 i = 0; i < pHeader->NumEntries; i++)
+	{
+		const Entry& entry = m_pEntries[i];
+		if (!IsEntryValid(entry))
+		{
+			LOG_ERROR("Pack archive {} is corrupt, entry {} is outside of the file or has the wrong size!", filePath.c_str(), i);
+			Close();
+			return false;
+		}
+
+		if (i > 0 && GetPath(&m_pEntries[i - 1]) >= GetPath(&entry))
+		{
+			LOG_ERROR("Pack archive {} is corrupt, the table of contents is not sorted at entry {}!", filePath.c_str(), i);
+			Close();
+			return false;
+		}
+	}
+	return true;
+}
+
+void PackArchive::Close()
+{
+	m_pHeader	= nullptr;
+	m_pEntries	= nullptr;
+	m_pStrings	= nullptr;
+	m_File.Close();
+}
+
+const PackArchive::Entry* PackArchive::Find(std::string_view path) const
+{
+	if (!IsOpen())
+		return nullptr;
+
+	const Entry* pBegin = m_pEntries;
+	const Entry* pEnd = m_pEntries + m_pHeader->NumEntries;
+	const Entry* pIt = std::lower_bound(pBegin, pEnd, path, [&](const Entry& entry, std::string_view value)
+		{
+			return GetPath(&entry) < value;
+		});
+
+	if (pIt != pEnd && GetPath(pIt) == path)
+		return pIt;
+	return nullptr;
+}
+
+bool PackArchive::Read(const Entry* pEntry, FileView& outView) const
+{
+	if (!IsOpen() || pEntry == nullptr)
+		return false;
+
+	if (!IsEntryValid(*pEntry))
+	{
+		LOG_ERROR("Pack entry is outside of the archive or has the wrong size!");
+		return false;
+	}
+
+	const uint8* pStored = m_File.GetData() + pEntry->DataOffset;
+	if (pEntry->CompressionType == Compression::NONE)
+	{
+		outView.pData		= pStored;
+		outView.Size		= pEntry->Size;
+		outView.IsZeroCopy	= true;
+		outView.pOwner		= nullptr;
+		return true;
+	}
+	else if (pEntry->CompressionType == Compression::LZ)
+	{
+		std::shared_ptr<std::vector<uint8>> pBuffer = std::make_shared<std::vector<uint8>>((size_t)pEntry->Size);
+		if (!Compression::DecompressLZ(pStored, pEntry->StoredSize, pBuffer->data(), pEntry->Size))
+		{
+			LOG_ERROR("Failed to decompress pack entry {}!", std::string(GetPath(pEntry)).c_str());
+			return false;
+		}
+		outView.pData		= pBuffer->data();
+		outView.Size		= pEntry->Size;
+		outView.IsZeroCopy	= false;
+		outView.pOwner		= pBuffer;
+		return true;
+	}
+
+	LOG_ERROR("Pack entry {} has an unknown compression!", std::string(GetPath(pEntry)).c_str());
+	return false;
+}
+
+uint32 PackArchive::GetNumEntries() const
+{
+	return IsOpen() ? m_pHeader->NumEntries : 0;
+}
+
+const PackArchive::Entry* PackArchive::GetEntry(uint32 index) const
+{
+	if (index >= GetNumEntries())
+		return nullptr;
+	return m_pEntries + index;
+}
+
+std::string_view PackArchive::GetPath(const Entry* pEntry) const
+{
+	return std::string_view(m_pStrings + pEntry->PathOffset, (size_t)pEntry->PathLength);
+}
+
+bool PackArchive::IsEntryValid(const Entry& entry) const
+{
+	const uint64 size = m_File.GetSize();
+	if (entry.DataOffset > size || entry.StoredSize > size - entry.DataOffset)
+		return false;
+	if ((uint64)entry.PathOffset + (uint64)entry.PathLength > m_pHeader->StringsSize)
+		return false;
+
+	// Uncompressed entries are returned as they are stored.
+	if (entry.CompressionType == Compression::NONE)
+		return entry.StoredSize == entry.Size;
+	return entry.CompressionType == Compression::LZ;
+}
+
+bool PackArchive::Write(const std::string& filePath, std::vector<SourceFile> files, uint32 alignment, bool compress, float minSavings, WriteStats& outStats)
+{
+	outStats = {};
+	alignment = std::max(alignment, 1u);
+	auto Align = [alignment](uint64 offset)->uint64 { return (offset + alignment - 1) / alignment * alignment; };
+
+	// The table of contents is sorted, such that it can be binary searched.
+	std::sort(files.begin(), files.end(), [](const SourceFile& a, const SourceFile& b) { return a.Path < b.Path; });
+	for (size_t i = 1; i < files.size(); i++)
+	{
+		if (files[i].Path == files[i - 1].Path)
+		{
+			LOG_ERROR("Cannot write pack archive {}, the path {} exists more than once!", filePath.c_str(), files[i].Path.c_str());
+			return false;
+		}
+	}
+
+	Header header = {};
+	header.NumEntries		= (uint32)files.size();
+	header.Alignment		= alignment;
+	header.TOCOffset		= sizeof(Header);
+
+	std::vector<Entry> entries(files.size());
+	std::string strings;
+	for (size_t i = 0; i < files.size(); i++)
+	{
+		entries[i].PathOffset = (uint32)strings.size();
+		entries[i].PathLength = (uint32)files[i].Path.size();
+		strings += files[i].Path;
+	}
+	header.StringsOffset	= header.TOCOffset + (uint64)entries.size() * sizeof(Entry);
+	header.StringsSize		= (uint64)strings.size();
+
+	std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		LOG_ERROR("Failed to create pack archive {}!", filePath.c_str());
+		return false;
+	}
+
+	// Write the data first, the header and table of contents are written last when all offsets are known.
+	uint64 offset = Align(header.StringsOffset + header.StringsSize);
+	for (size_t i = 0; i < files.size(); i++)
+	{
+		std::ifstream source(files[i].DiskPath, std::ios::binary | std::ios::ate);
+		if (!source.is_open())
+		{
+			LOG_ERROR("Failed to read {} when writing pack archive!", files[i].DiskPath.c_str());
+			return false;
+		}
+		std::vector<uint8> data((size_t)source.tellg());
+		source.seekg(0);
+		source.read((char*)data.data(), (std::streamsize)data.size());
+
+		Entry& entry = entries[i];
+		entry.Size				= (uint64)data.size();
+		entry.DataOffset		= offset;
+		entry.CompressionType	= Compression::NONE;
+
+		std::vector<uint8> compressed;
+		if (compress && files[i].AllowCompression && !data.empty())
+			compressed = Compression::CompressLZ(data.data(), (uint64)data.size());
+
+		const std::vector<uint8>* pStored = &data;
+		if (!compressed.empty() && (float)compressed.size() <= (float)data.size() * (1.f - minSavings))
+		{
+			pStored = &compressed;
+			entry.CompressionType = Compression::LZ;
+			outStats.NumCompressed++;
+		}
+		entry.StoredSize = (uint64)pStored->size();
+
+		file.seekp((std::streamoff)offset);
+		file.write((const char*)pStored->data(), (std::streamsize)pStored->size());
+		offset = Align(offset + entry.StoredSize);
+
+		outStats.UncompressedBytes += entry.Size;
+	}
+
+	file.seekp(0);
+	file.write((const char*)&header, sizeof(Header));
+	file.write((const char*)entries.data(), (std::streamsize)(entries.size() * sizeof(Entry)));
+	file.write(strings.data(), (std::streamsize)strings.size());
+	file.close();
+
+	outStats.NumEntries		= header.NumEntries;
+	outStats.ArchiveBytes	= offset;
+	return !file.fail();
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "Core/FileView.h"
+#include "Core/MappedFile.h"
+
+#include <string_view>
+
+namespace RS
+{
+	/*
+	* A pack archive is a single file which contains many assets. It is memory mapped when opened.
+	* Layout:
+	*	[Header][Table of contents (Sorted by path)][Path strings][Entry data, each aligned to Header.Alignment]
+	* The paths are relative to the asset folder, use '/' as separator and are not null terminated.
+	*/
+	class PackArchive
+	{
+	public:
+		static const uint32 MAGIC	= 0x4B505352; // "RSPK"
+		static const uint32 VERSION	= 1;
+
+		enum class Compression : uint32
+		{
+			NONE = 0,
+			LZ
+		};
+
+		struct Header
+		{
+			uint32	Magic				= MAGIC;
+			uint32	Version				= VERSION;
+			uint32	NumEntries			= 0;
+			uint32	Alignment			= 0;
+			uint64	TOCOffset			= 0;
+			uint64	StringsOffset		= 0;
+			uint64	StringsSize			= 0;
+		};
+
+		struct Entry
+		{
+			uint64		DataOffset		= 0;
+			uint64		StoredSize		= 0; // Size in the archive.
+			uint64		Size			= 0; // Size when decompressed.
+			uint32		PathOffset		= 0;
+			uint32		PathLength		= 0;
+			Compression	CompressionType	= Compression::NONE;
+			uint32		_Padding		= 0;
+		};
+
+		struct SourceFile
+		{
+			std::string	Path				= ""; // Path inside the archive.
+			std::string	DiskPath			= ""; // Where to read the file from.
+			bool		AllowCompression	= true;
+		};
+
+		struct WriteStats
+		{
+			uint32	NumEntries			= 0;
+			uint32	NumCompressed		= 0;
+			uint64	UncompressedBytes	= 0;
+			uint64	ArchiveBytes		= 0;
+		};
+
+	public:
+		RS_NO_COPY_AND_MOVE(PackArchive);
+		PackArchive() = default;
+		~PackArchive() = default;
+
+		bool Open(const std::string& filePath);
+		void Close();
+		bool IsOpen() const { return m_pHeader != nullptr; }
+
+		/*
+		* Binary search for the entry in the table of contents. Returns nullptr if it does not exist.
+		*/
+		const Entry* Find(std::string_view path) const;
+
+		/*
+		* Read the entry into a view. Uncompressed entries are returned without copying.
+		*/
+		bool Read(const Entry* pEntry, FileView& outView) const;
+
+		uint32 GetNumEntries() const;
+		const Entry* GetEntry(uint32 index) const;
+		std::string_view GetPath(const Entry* pEntry) const;
+
+		/*
+		* Write an archive with the files. Compressed entries are only kept if they save at least minSavings (fraction) of the size.
+		*/
+		static bool Write(const std::string& filePath, std::vector<SourceFile> files, uint32 alignment, bool compress, float minSavings, WriteStats& outStats);
+
+	private:
+		bool IsEntryValid(const Entry& entry) const;
+
+	private:
+		MappedFile		m_File;
+		const Header*	m_pHeader	= nullptr;
+		const Entry*	m_pEntries	= nullptr;
+		const char*		m_pStrings	= nullptr;
+	};
+}
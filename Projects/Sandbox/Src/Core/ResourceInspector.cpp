@@ -4,6 +4,7 @@
 #include <unordered_set>
 
 #include "Core/ResourceManager.h"
+#include "Core/VirtualFileSystem.h"
 #include "Renderer/RenderUtils.h"
 
 using namespace RS;
@@ -34,6 +35,27 @@ void ResourceInspector::Draw()
 	{
 		if (ImGui::Begin("Resource Inspector", &s_ResourceInspectorWindow))
 		{
+			ResourceManager::Stats stats = s_ResourceManager->GetStats();
+			if (ImGui::TreeNode("Memory"))
+			{
+				for (auto& [type, bytes] : stats.TypeCPUBytes)
+					ImGui::Text("%s: CPU %.2f MB, GPU %.2f MB", Resource::TypeToString(type).c_str(), (float)bytes / (1024.f * 1024.f), (float)stats.TypeGPUBytes[type] / (1024.f * 1024.f));
+				ImGui::Text("Resident images: %d, Evicted images: %d, Reloads: %d", stats.NumResidentImages, stats.NumEvictedImages, stats.NumImageReloads);
+				if (stats.ImageBudgetBytes > 0)
+					ImGui::Text("Image budget: %.2f MB", (float)stats.ImageBudgetBytes / (1024.f * 1024.f));
+				if (ImGui::Button("Export Memory Report"))
+					s_ResourceManager->ExportMemoryReport("MemoryReport.json");
+				ImGui::TreePop();
+			}
+
+			if (ImGui::TreeNode("File System"))
+			{
+				VirtualFileSystem::Stats fileStats = VirtualFileSystem::Get()->GetStats();
+				ImGui::Text("Reads: %d (Zero-copy: %d, Failed: %d)", fileStats.NumReads, fileStats.NumZeroCopyReads, fileStats.NumFailedReads);
+				ImGui::Text("Read: %.2f MB in %.2f ms", (float)fileStats.BytesRead / (1024.f * 1024.f), fileStats.TotalReadTimeMS);
+				ImGui::TreePop();
+			}
+
 			for (auto& [type, resources] : s_TypeToResourcesMap)
 			{
 				std::string typeStr = Resource::TypeToString(type);
@@ -60,6 +82,7 @@ void ResourceInspector::Draw()
 							{
 								ImGui::Text("Ref. count: %d", refCount);
 								ImGui::Text("Key: %s", resourceKeyString.c_str());
+								DrawResourceMemory(resources[index].second);
 								DrawTextureResource(pResource);
 								ImGui::TreePop();
 							}
@@ -71,6 +94,7 @@ void ResourceInspector::Draw()
 							{
 								ImGui::Text("Ref. count: %d", refCount);
 								ImGui::Text("Key: %s", resourceKeyString.c_str());
+								DrawResourceMemory(resources[index].second);
 								DrawCubeMapResource(pResource);
 								ImGui::TreePop();
 							}
@@ -82,6 +106,7 @@ void ResourceInspector::Draw()
 							{
 								ImGui::Text("Ref. count: %d", refCount);
 								ImGui::Text("Key: %s", resourceKeyString.c_str());
+								DrawResourceMemory(resources[index].second);
 								DrawImageResource(pResource);
 								ImGui::TreePop();
 							}
@@ -93,6 +118,7 @@ void ResourceInspector::Draw()
 							{
 								ImGui::Text("Ref. count: %d", refCount);
 								ImGui::Text("Key: %s", resourceKeyString.c_str());
+								DrawResourceMemory(resources[index].second);
 								DrawSamplerResource(pResource);
 								ImGui::TreePop();
 							}
@@ -105,6 +131,7 @@ void ResourceInspector::Draw()
 							{
 								ImGui::Text("Ref. count: %d", refCount);
 								ImGui::Text("Key: %s", resourceKeyString.c_str());
+								DrawResourceMemory(resources[index].second);
 								DrawMaterialResource(pResource);
 								ImGui::TreePop();
 							}
@@ -117,6 +144,7 @@ void ResourceInspector::Draw()
 							{
 								ImGui::Text("Ref. count: %d", refCount);
 								ImGui::Text("Key: %s", resourceKeyString.c_str());
+								DrawResourceMemory(resources[index].second);
 								DrawModelResource(pResource);
 								ImGui::TreePop();
 							}
@@ -140,6 +168,11 @@ void ResourceInspector::Draw()
 	});
 }
 
+void ResourceInspector::DrawResourceMemory(const Resource* pResource)
+{
+	ImGui::Text("Memory: CPU %.2f MB, GPU %.2f MB", (float)pResource->CPUBytes / (1024.f * 1024.f), (float)pResource->GPUBytes / (1024.f * 1024.f));
+}
+
 void ResourceInspector::DrawSamplerResource(SamplerResource* pSampler)
 {
 	RS_UNREFERENCED_VARIABLE(pSampler);
@@ -184,6 +217,18 @@ void ResourceInspector::DrawImageResource(ImageResource* pImage)
 	ImGui::Text("Height: %d", pImage->Height);
 	std::string formatStr = RenderUtils::FormatToString(pImage->Format);
 	ImGui::Text("Image Format: %s", formatStr.c_str());
+
+	ImGui::Text("Is in RAM: ");
+	float on = pImage->IsResident ? 1.f : 0.f;
+	ImGui::SameLine(); ImGui::TextColored(ImVec4(1.f - on, on, 0.f, 1.f), "%s (%.2f MB)", on > 0.5f ? "True" : "False", (float)pImage->Data.size() / (1024.f * 1024.f));
+	if (!pImage->IsResident && pImage->IsReloadable)
+	{
+		ImGui::SameLine();
+		ImGui::PushID(pImage);
+		if (ImGui::SmallButton("Reload"))
+			s_ResourceManager->RequestImageData(pImage);
+		ImGui::PopID();
+	}
 }
 
 void ResourceInspector::DrawMaterialResource(MaterialResource* pMaterial)
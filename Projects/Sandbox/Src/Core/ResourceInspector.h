@@ -15,6 +15,7 @@ namespace RS
 		static void Draw();
 
 	private:
+		static void DrawResourceMemory(const Resource* pResource);
 		static void DrawSamplerResource(SamplerResource* pSampler);
 		static void DrawTextureResource(TextureResource* pTexture);
 		static void DrawCubeMapResource(CubeMapResource* pCubeMap);
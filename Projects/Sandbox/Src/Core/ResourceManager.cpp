@@ -3,6 +3,7 @@
 
 #include "Loaders/ModelLoader.h"
 
+#include "Renderer/DebugRenderer.h"
 #include "Renderer/ImGuiRenderer.h"
 #include "Renderer/RenderUtils.h"
 #include "Renderer/Renderer.h"
@@ -11,7 +12,10 @@
 
 #include "Loaders/ResourceLoader.h"
 
+#include "Utils/Config.h"
+
 #include <unordered_set>
+#include <fstream>
 
 using namespace RS;
 
@@ -23,6 +27,22 @@ std::shared_ptr<ResourceManager> ResourceManager::Get()
 
 void ResourceManager::Init()
 {
+	// Image residency
+	{
+		std::string residencyStr = Config::Get()->Fetch<std::string>("Resources/ImageResidency", "Keep");
+		uint64 budgetBytes = (uint64)Config::Get()->Fetch<uint32>("Resources/ImageBudgetMB", 256) * 1024ull * 1024ull;
+		if (residencyStr == "Drop")
+			SetImageResidency(ImageResidency::DROP_AFTER_UPLOAD);
+		else if (residencyStr == "LRU")
+			SetImageResidency(ImageResidency::LRU_BUDGET, budgetBytes);
+		else
+		{
+			if (residencyStr != "Keep")
+				LOG_WARNING("Unknown image residency \"{}\", expected Keep, Drop or LRU! Using Keep.", residencyStr.c_str());
+			SetImageResidency(ImageResidency::KEEP);
+		}
+	}
+
 	// Load default textures!
 	{
 		// Load a white texture
@@ -151,6 +171,9 @@ void ResourceManager::Release()
 	m_StringToResourceIDMap.clear();
 	m_TypeResourcesRefCount.clear();
 	m_ResourcesRefCount.clear();
+	m_ImageLRU.clear();
+	m_ImageLRUMap.clear();
+	m_ResidentImageBytes = 0;
 }
 
 std::pair<ImageResource*, ResourceID> ResourceManager::LoadImageResource(ImageLoadDesc& imageDescription)
@@ -166,6 +189,12 @@ std::pair<ImageResource*, ResourceID> ResourceManager::LoadImageResource(ImageLo
 			ResourceLoader::LoadImageFromFile(pImage, imageDescription);
 		else
 			ResourceLoader::LoadImageFromMemory(pImage, imageDescription);
+
+		pImage->IsResident		= true;
+		pImage->IsReloadable	= imageDescription.IsFromFile;
+		pImage->Source			= imageDescription;
+		pImage->Source.Memory	= {};
+		UpdateMemoryFootprint(pImage);
 	}
 
 	return { pImage, id };
@@ -267,12 +296,17 @@ std::pair<TextureResource*, ResourceID> ResourceManager::LoadTextureResource(Tex
 			D3D11_SUBRESOURCE_DATA* pSubData = nullptr;
 			if (!isEmpty)
 			{
+				// The image can be shared and might have been evicted by another texture.
+				RequestImageData(pImage);
 				subData = D3D11Helper::FillTexture2DSubdata(textureDesc, pImage->Data.data());
 				pSubData = subData.data();
 			}
 			HRESULT result = RenderAPI::Get()->GetDevice()->CreateTexture2D(&textureDesc, pSubData, &pTexture->pTexture);
 			RS_D311_ASSERT_CHECK(result, "Failed to create texture!");
 
+			if (!isEmpty)
+				NotifyImageUploaded(pImage);
+
 			D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
 			srvDesc.Format						= textureDesc.Format;
 			srvDesc.ViewDimension				= D3D11_SRV_DIMENSION_TEXTURE2D;
@@ -284,6 +318,7 @@ std::pair<TextureResource*, ResourceID> ResourceManager::LoadTextureResource(Tex
 			if (textureDescription.GenerateMipmaps)
 				GenerateTextureMipmaps(pTexture);
 		}
+		UpdateMemoryFootprint(pTexture);
 	}
 
 	return { pTexture, id };
@@ -320,7 +355,10 @@ std::pair<CubeMapResource*, ResourceID> ResourceManager::LoadCubeMapResource(Cub
 			}
 			else
 			{
+				// The faces are pinned until all of them are uploaded, such that requesting one face cannot evict the data of another.
 				auto [pImage, imageId]		= LoadImageResource(cubeMapDescription.ImageDescs[i]);
+				pImage->PinCount++;
+				RequestImageData(pImage);
 				pImageResources[i]			= pImage;
 				pTexture->ImageHandlers[i]	= pImage->key;
 			}
@@ -389,6 +427,14 @@ std::pair<CubeMapResource*, ResourceID> ResourceManager::LoadCubeMapResource(Cub
 			HRESULT result = RenderAPI::Get()->GetDevice()->CreateTexture2D(&textureDesc, cubeMapDescription.EmptyInitialization ? nullptr : subData.data(), &pTexture->pTexture);
 			RS_D311_ASSERT_CHECK(result, "Failed to create cube map texture!");
 
+			if (!cubeMapDescription.EmptyInitialization)
+			{
+				for (uint32 i = 0; i < 6; i++)
+					pImageResources[i]->PinCount--;
+				for (uint32 i = 0; i < 6; i++)
+					NotifyImageUploaded(pImageResources[i]);
+			}
+
 			{
 				D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
 				srvDesc.Format = textureDesc.Format;
@@ -420,6 +466,7 @@ std::pair<CubeMapResource*, ResourceID> ResourceManager::LoadCubeMapResource(Cub
 				}
 			}
 		}
+		UpdateMemoryFootprint(pTexture);
 	}
 
 	return { pTexture, id };
@@ -473,6 +520,7 @@ std::pair<ModelResource*, ResourceID> ResourceManager::LoadModelResource(ModelLo
 		else if (modelDescription.Loader == ModelLoadDesc::Loader::ASSIMP 
 			|| modelDescription.Loader == ModelLoadDesc::Loader::DEFAULT)
 			ModelLoader::LoadWithAssimp(modelDescription.FilePath, pModel, modelDescription.Flags);
+		UpdateMemoryFootprint(pModel);
 	}
 
 	return { pModel, id };
@@ -542,11 +590,182 @@ ResourceManager::Stats ResourceManager::GetStats()
 	stats.pStringToResourceIDMap = &m_StringToResourceIDMap;
 	std::vector<ResourceID> resourceIDs;
 	for (auto [id, pResource] : m_IDToResourceMap)
+	{
 		resourceIDs.push_back(id);
+
+		stats.TypeCPUBytes[pResource->type] += pResource->CPUBytes;
+		stats.TypeGPUBytes[pResource->type] += pResource->GPUBytes;
+		if (pResource->type == Resource::Type::IMAGE)
+		{
+			if (dynamic_cast<ImageResource*>(pResource)->IsResident)
+				stats.NumResidentImages++;
+			else
+				stats.NumEvictedImages++;
+		}
+	}
 	stats.ResourceIDs = resourceIDs;
+	stats.ImageBudgetBytes = m_ImageResidency == ImageResidency::LRU_BUDGET ? m_ImageBudgetBytes : 0;
+	stats.NumImageReloads = m_NumImageReloads;
 	return stats;
 }
 
+ResourceManager::MemoryReport ResourceManager::GetMemoryReport()
+{
+	MemoryReport report;
+	for (auto& [id, pResource] : m_IDToResourceMap)
+	{
+		MemoryFootprint& typeFootprint = report.PerType[pResource->type];
+		typeFootprint.CPUBytes	+= pResource->CPUBytes;
+		typeFootprint.GPUBytes	+= pResource->GPUBytes;
+		report.Total.CPUBytes	+= pResource->CPUBytes;
+		report.Total.GPUBytes	+= pResource->GPUBytes;
+	}
+
+	// Each model also counts the materials, textures and images it uses.
+	for (auto& [id, pResource] : m_IDToResourceMap)
+	{
+		if (pResource->type != Resource::Type::MODEL)
+			continue;
+
+		ModelResource* pModel = dynamic_cast<ModelResource*>(pResource);
+		MemoryFootprint& modelFootprint = report.PerModel[id];
+		modelFootprint.CPUBytes = pModel->CPUBytes;
+		modelFootprint.GPUBytes = pModel->GPUBytes;
+
+		std::unordered_set<ResourceID> visited;
+		AddModelDependenciesFootprintRecursive(*pModel, modelFootprint, visited);
+	}
+
+	return report;
+}
+
+bool ResourceManager::ExportMemoryReport(const std::string& filePath)
+{
+	MemoryReport report = GetMemoryReport();
+
+	json j;
+	j["Total"]["CPUBytes"] = report.Total.CPUBytes;
+	j["Total"]["GPUBytes"] = report.Total.GPUBytes;
+	for (auto& [type, footprint] : report.PerType)
+	{
+		std::string typeStr = Resource::TypeToString(type);
+		j["PerType"][typeStr]["CPUBytes"] = footprint.CPUBytes;
+		j["PerType"][typeStr]["GPUBytes"] = footprint.GPUBytes;
+	}
+
+	j["PerModel"] = json::array();
+	for (auto& [id, footprint] : report.PerModel)
+	{
+		ModelResource* pModel = GetResource<ModelResource>(id);
+		json model;
+		model["ID"]			= id;
+		model["Name"]		= pModel ? pModel->Name : "";
+		model["Key"]		= GetResourceName(id);
+		model["CPUBytes"]	= footprint.CPUBytes;
+		model["GPUBytes"]	= footprint.GPUBytes;
+		j["PerModel"].push_back(model);
+	}
+
+	j["Resources"] = json::array();
+	for (auto& [id, pResource] : m_IDToResourceMap)
+	{
+		json resource;
+		resource["ID"]			= id;
+		resource["Type"]		= Resource::TypeToString(pResource->type);
+		resource["CPUBytes"]	= pResource->CPUBytes;
+		resource["GPUBytes"]	= pResource->GPUBytes;
+		j["Resources"].push_back(resource);
+	}
+
+	std::ofstream file(filePath);
+	if (!file.is_open())
+	{
+		LOG_WARNING("Failed to export memory report to {}!", filePath.c_str());
+		return false;
+	}
+	file << j.dump(4);
+	file.close();
+	LOG_INFO("Exported memory report to {}", filePath.c_str());
+	return true;
+}
+
+void ResourceManager::SetImageResidency(ImageResidency residency, uint64 budgetBytes)
+{
+	m_ImageResidency	= residency;
+	m_ImageBudgetBytes	= budgetBytes;
+
+	// Apply the new policy on the images which already have been uploaded.
+	if (m_ImageResidency == ImageResidency::DROP_AFTER_UPLOAD)
+	{
+		while (!m_ImageLRU.empty())
+			EvictImageData(GetResource<ImageResource>(m_ImageLRU.back()));
+	}
+	else if (m_ImageResidency == ImageResidency::LRU_BUDGET)
+	{
+		EnforceImageBudget(nullptr);
+	}
+}
+
+bool ResourceManager::RequestImageData(ImageResource* pImage)
+{
+	if (pImage == nullptr)
+		return false;
+
+	if (!pImage->IsResident)
+	{
+		if (!pImage->IsReloadable)
+		{
+			LOG_ERROR("Image {} has been evicted and cannot be reloaded!", pImage->key);
+			return false;
+		}
+
+		// Keep the old dimensions, the loader will overwrite them with the same values if the file is unchanged.
+		ResourceLoader::LoadImageFromFile(pImage, pImage->Source);
+		if (pImage->Data.empty())
+		{
+			LOG_ERROR("Failed to reload the pixel data of image {}!", pImage->key);
+			return false;
+		}
+
+		pImage->IsResident = true;
+		m_NumImageReloads++;
+		UpdateMemoryFootprint(pImage);
+	}
+
+	if (pImage->IsReloadable)
+	{
+		TouchImage(pImage);
+		EnforceImageBudget(pImage);
+	}
+	return true;
+}
+
+void ResourceManager::NotifyImageUploaded(ImageResource* pImage)
+{
+	if (pImage == nullptr || !pImage->IsReloadable || !pImage->IsResident)
+		return;
+
+	switch (m_ImageResidency)
+	{
+	case ImageResidency::DROP_AFTER_UPLOAD:
+		RemoveImageFromLRU(pImage);
+		pImage->Data.clear();
+		pImage->Data.shrink_to_fit();
+		pImage->IsResident = false;
+		UpdateMemoryFootprint(pImage);
+		break;
+	case ImageResidency::LRU_BUDGET:
+		TouchImage(pImage);
+		EnforceImageBudget(pImage);
+		break;
+	case ImageResidency::KEEP:
+	default:
+		// Still track it, such that a later change of policy can evict it.
+		TouchImage(pImage);
+		break;
+	}
+}
+
 std::string ResourceManager::GetResourceName(ResourceID id)
 {
 	for(auto& nameEntry : m_StringToResourceIDMap)
@@ -592,6 +811,8 @@ bool ResourceManager::RemoveResource(Resource* pResource, bool fullRemoval)
 		case RS::Resource::Type::MODEL:
 		{
 			ModelResource* pModel = dynamic_cast<ModelResource*>(pResource);
+			// The debug wireframes are keyed by the meshes, a model which is loaded later at the same address must not get their lines.
+			DebugRenderer::Get()->RemoveMesh(pModel);
 			FreeModelRecursive(pModel, fullRemoval);
 		}
 		break;
@@ -621,7 +842,9 @@ void ResourceManager::FreeImage(ImageResource* pImage, bool fullRemoval)
 
 	if (pImage)
 	{
+		RemoveImageFromLRU(pImage);
 		pImage->Data.clear();
+		pImage->IsResident = false;
 		pImage->Width	= 0;
 		pImage->Height	= 0;
 		pImage->Format	= DXGI_FORMAT_UNKNOWN;
@@ -823,6 +1046,197 @@ void ResourceManager::UpdateStats(Resource* pResrouce, bool add)
 	}
 }
 
+void ResourceManager::EvictImageData(ImageResource* pImage)
+{
+	if (pImage == nullptr)
+		return;
+
+	RemoveImageFromLRU(pImage);
+	if (pImage->IsReloadable && pImage->IsResident)
+	{
+		pImage->Data.clear();
+		pImage->Data.shrink_to_fit();
+		pImage->IsResident = false;
+		UpdateMemoryFootprint(pImage);
+	}
+}
+
+void ResourceManager::TouchImage(ImageResource* pImage)
+{
+	auto it = m_ImageLRUMap.find(pImage->key);
+	if (it != m_ImageLRUMap.end())
+	{
+		m_ImageLRU.splice(m_ImageLRU.begin(), m_ImageLRU, it->second);
+	}
+	else
+	{
+		m_ImageLRU.push_front(pImage->key);
+		m_ImageLRUMap[pImage->key] = m_ImageLRU.begin();
+		m_ResidentImageBytes += (uint64)pImage->Data.size();
+	}
+}
+
+void ResourceManager::RemoveImageFromLRU(ImageResource* pImage)
+{
+	auto it = m_ImageLRUMap.find(pImage->key);
+	if (it != m_ImageLRUMap.end())
+	{
+		m_ResidentImageBytes -= glm::min(m_ResidentImageBytes, (uint64)pImage->Data.size());
+		m_ImageLRU.erase(it->second);
+		m_ImageLRUMap.erase(it);
+	}
+}
+
+void ResourceManager::EnforceImageBudget(ImageResource* pImageToKeep)
+{
+	if (m_ImageResidency != ImageResidency::LRU_BUDGET)
+		return;
+
+	// Evict from the back (least recently used) until we are under the budget. The image which was just used and pinned images are never evicted.
+	auto it = m_ImageLRU.end();
+	while (m_ResidentImageBytes > m_ImageBudgetBytes && it != m_ImageLRU.begin())
+	{
+		ImageResource* pImage = GetResource<ImageResource>(*std::prev(it));
+		if (pImage == pImageToKeep || pImage->PinCount > 0)
+			--it;
+		else
+			EvictImageData(pImage); // Only erases the image before the iterator.
+	}
+}
+
+void ResourceManager::UpdateMemoryFootprint(Resource* pResource)
+{
+	pResource->CPUBytes = 0;
+	pResource->GPUBytes = 0;
+	switch (pResource->type)
+	{
+	case Resource::Type::IMAGE:
+	{
+		ImageResource* pImage = dynamic_cast<ImageResource*>(pResource);
+		pImage->CPUBytes = (uint64)pImage->Data.size();
+	}
+	break;
+	case Resource::Type::TEXTURE:
+	{
+		TextureResource* pTexture = dynamic_cast<TextureResource*>(pResource);
+		pTexture->GPUBytes = GetTextureSize(pTexture->pTexture);
+	}
+	break;
+	case Resource::Type::CUBE_MAP:
+	{
+		CubeMapResource* pCubeMap = dynamic_cast<CubeMapResource*>(pResource);
+		pCubeMap->GPUBytes = GetTextureSize(pCubeMap->pTexture);
+	}
+	break;
+	case Resource::Type::MATERIAL:
+	{
+		MaterialResource* pMaterial = dynamic_cast<MaterialResource*>(pResource);
+		pMaterial->GPUBytes = GetBufferSize(pMaterial->pConstantBuffer);
+	}
+	break;
+	case Resource::Type::MODEL:
+	{
+		// The materials are made by the loader together with the model.
+		MemoryFootprint footprint;
+		ModelResource* pModel = dynamic_cast<ModelResource*>(pResource);
+		AddMeshesFootprintRecursive(*pModel, footprint);
+		UpdateMaterialFootprintsRecursive(*pModel);
+		pResource->CPUBytes = footprint.CPUBytes;
+		pResource->GPUBytes = footprint.GPUBytes;
+	}
+	break;
+	case Resource::Type::SAMPLER:
+	default:
+		break;
+	}
+}
+
+void ResourceManager::AddMeshesFootprintRecursive(const ModelResource& model, MemoryFootprint& footprint) const
+{
+	for (const MeshObject& mesh : model.Meshes)
+	{
+		footprint.CPUBytes += (uint64)mesh.Vertices.size() * sizeof(MeshObject::Vertex);
+		footprint.CPUBytes += (uint64)mesh.Indices.size() * sizeof(uint32);
+		footprint.GPUBytes += GetBufferSize(mesh.pVertexBuffer);
+		footprint.GPUBytes += GetBufferSize(mesh.pIndexBuffer);
+		footprint.GPUBytes += GetBufferSize(mesh.pMeshBuffer);
+	}
+
+	for (const ModelResource& child : model.Children)
+		AddMeshesFootprintRecursive(child, footprint);
+}
+
+void ResourceManager::UpdateMaterialFootprintsRecursive(const ModelResource& model)
+{
+	for (const MeshObject& mesh : model.Meshes)
+	{
+		if (MaterialResource* pMaterial = GetResource<MaterialResource>(mesh.MaterialHandler))
+			UpdateMemoryFootprint(pMaterial);
+	}
+
+	for (const ModelResource& child : model.Children)
+		UpdateMaterialFootprintsRecursive(child);
+}
+
+void ResourceManager::AddModelDependenciesFootprintRecursive(const ModelResource& model, MemoryFootprint& footprint, std::unordered_set<ResourceID>& visited)
+{
+	for (const MeshObject& mesh : model.Meshes)
+	{
+		MaterialResource* pMaterial = GetResource<MaterialResource>(mesh.MaterialHandler);
+		if (pMaterial == nullptr || !visited.insert(pMaterial->key).second)
+			continue;
+
+		footprint.CPUBytes += pMaterial->CPUBytes;
+		footprint.GPUBytes += pMaterial->GPUBytes;
+		AddTextureFootprint(pMaterial->AlbedoTextureHandler, footprint, visited);
+		AddTextureFootprint(pMaterial->NormalTextureHandler, footprint, visited);
+		AddTextureFootprint(pMaterial->AOTextureHandler, footprint, visited);
+		AddTextureFootprint(pMaterial->MetallicTextureHandler, footprint, visited);
+		AddTextureFootprint(pMaterial->RoughnessTextureHandler, footprint, visited);
+		AddTextureFootprint(pMaterial->MetallicRoughnessTextureHandler, footprint, visited);
+	}
+
+	for (const ModelResource& child : model.Children)
+		AddModelDependenciesFootprintRecursive(child, footprint, visited);
+}
+
+void ResourceManager::AddTextureFootprint(ResourceID textureID, MemoryFootprint& footprint, std::unordered_set<ResourceID>& visited)
+{
+	TextureResource* pTexture = GetResource<TextureResource>(textureID);
+	if (pTexture == nullptr || !visited.insert(textureID).second)
+		return;
+
+	footprint.CPUBytes += pTexture->CPUBytes;
+	footprint.GPUBytes += pTexture->GPUBytes;
+
+	ImageResource* pImage = GetResource<ImageResource>(pTexture->ImageHandler);
+	if (pImage && visited.insert(pImage->key).second)
+	{
+		footprint.CPUBytes += pImage->CPUBytes;
+		footprint.GPUBytes += pImage->GPUBytes;
+	}
+}
+
+uint64 ResourceManager::GetBufferSize(ID3D11Buffer* pBuffer)
+{
+	if (pBuffer == nullptr)
+		return 0;
+
+	D3D11_BUFFER_DESC bufferDesc = {};
+	pBuffer->GetDesc(&bufferDesc);
+	return (uint64)bufferDesc.ByteWidth;
+}
+
+uint64 ResourceManager::GetTextureSize(ID3D11Texture2D* pTexture)
+{
+	if (pTexture == nullptr)
+		return 0;
+
+	D3D11_TEXTURE2D_DESC textureDesc = {};
+	pTexture->GetDesc(&textureDesc);
+	return RenderUtils::EstimateTextureSize(textureDesc.Format, textureDesc.Width, textureDesc.Height, textureDesc.MipLevels, textureDesc.ArraySize) * (uint64)glm::max(textureDesc.SampleDesc.Count, 1u);
+}
+
 std::string	ResourceManager::GetImageResourceStringKey(ImageLoadDesc& imageDescription)
 {
 	if (imageDescription.Name.empty())
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <list>
+#include <unordered_set>
+
 #include "Renderer/RenderAPI.h"
 #include "Resources/RefObject.h"
 #include "Resources/Resources.h"
@@ -19,6 +22,27 @@ namespace RS
 			std::unordered_map<ResourceID, uint32>*			pResourcesRefCount		= nullptr;
 			std::unordered_map<std::string, ResourceID>*	pStringToResourceIDMap	= nullptr;
 			std::vector<ResourceID>							ResourceIDs;
+
+			// Memory
+			std::unordered_map<Resource::Type, uint64>		TypeCPUBytes;
+			std::unordered_map<Resource::Type, uint64>		TypeGPUBytes;
+			uint64											ImageBudgetBytes		= 0;
+			uint32											NumResidentImages		= 0;
+			uint32											NumEvictedImages		= 0;
+			uint32											NumImageReloads			= 0;
+		};
+
+		struct MemoryFootprint
+		{
+			uint64 CPUBytes = 0;
+			uint64 GPUBytes = 0;
+		};
+
+		struct MemoryReport
+		{
+			std::unordered_map<Resource::Type, MemoryFootprint>	PerType;
+			std::unordered_map<ResourceID, MemoryFootprint>		PerModel; // Includes the materials, textures and images used by the model. Shared resources are counted in each model.
+			MemoryFootprint										Total;
 		};
 
 	public:
@@ -99,6 +123,24 @@ namespace RS
 		*/
 		void GenerateMipmaps(Resource* pResource);
 
+		/*
+		* Set what should happen to the pixel data of images after they have been uploaded to the GPU.
+		* BudgetBytes is only used by ImageResidency::LRU_BUDGET.
+		*/
+		void SetImageResidency(ImageResidency residency, uint64 budgetBytes = 0);
+
+		/*
+		* Makes sure the pixel data of the image is in RAM, it will be reloaded from its source if it has been evicted.
+		* Returns false if the image is not resident and could not be reloaded.
+		*/
+		bool RequestImageData(ImageResource* pImage);
+
+		/*
+		* Tell the system that the pixel data of the image has been uploaded to the GPU.
+		* The residency policy will then decide if the data should be kept in RAM or not.
+		*/
+		void NotifyImageUploaded(ImageResource* pImage);
+
 		/*
 			Load a model from a file path.
 			Arguments:
@@ -154,6 +196,22 @@ namespace RS
 
 		Stats GetStats();
 
+		/*
+		* Aggregates the memory footprint of all resources per type and per model.
+		*/
+		MemoryReport GetMemoryReport();
+
+		/*
+		* Compute the CPU and GPU bytes of the resource again, they are kept on the resource such that the stats do not query the device.
+		* The ResourceManager does this when it loads, reloads or evicts a resource, call it after replacing the data or device objects of a resource.
+		*/
+		void UpdateMemoryFootprint(Resource* pResource);
+
+		/*
+		* Writes the memory report as JSON to the file path. Returns false if the file could not be written.
+		*/
+		bool ExportMemoryReport(const std::string& filePath);
+
 		std::string GetResourceName(ResourceID id);
 
 		// Default textures
@@ -191,6 +249,20 @@ namespace RS
 
 		void UpdateStats(Resource* pResrouce, bool add);
 
+		// --------------- Image residency -----------------
+		void EvictImageData(ImageResource* pImage);
+		void TouchImage(ImageResource* pImage);
+		void RemoveImageFromLRU(ImageResource* pImage);
+		void EnforceImageBudget(ImageResource* pImageToKeep);
+
+		// --------------- Memory accounting -----------------
+		void UpdateMaterialFootprintsRecursive(const ModelResource& model);
+		void AddMeshesFootprintRecursive(const ModelResource& model, MemoryFootprint& footprint) const;
+		void AddModelDependenciesFootprintRecursive(const ModelResource& model, MemoryFootprint& footprint, std::unordered_set<ResourceID>& visited);
+		void AddTextureFootprint(ResourceID textureID, MemoryFootprint& footprint, std::unordered_set<ResourceID>& visited);
+		static uint64 GetBufferSize(ID3D11Buffer* pBuffer);
+		static uint64 GetTextureSize(ID3D11Texture2D* pTexture);
+
 		std::string GetImageResourceStringKey(ImageLoadDesc& imageDescription);
 		std::string GetSamplerResourceStringKey(SamplerLoadDesc& samplerDescription);
 		std::string GetTextureResourceStringKey(TextureLoadDesc& textureDescription);
@@ -217,6 +289,14 @@ namespace RS
 		// Stats
 		std::unordered_map<Resource::Type, uint32>	m_TypeResourcesRefCount;
 		std::unordered_map<ResourceID, uint32>		m_ResourcesRefCount;
+
+		// Image residency
+		ImageResidency														m_ImageResidency		= ImageResidency::KEEP;
+		uint64																m_ImageBudgetBytes		= 0;
+		uint64																m_ResidentImageBytes	= 0; // Only evictable images are counted.
+		uint32																m_NumImageReloads		= 0;
+		std::list<ResourceID>												m_ImageLRU;				// Front is the most recently used.
+		std::unordered_map<ResourceID, std::list<ResourceID>::iterator>		m_ImageLRUMap;
 	};
 
 	template<typename ResourceT>
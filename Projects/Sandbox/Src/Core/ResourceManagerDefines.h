@@ -2,6 +2,17 @@
 
 namespace RS
 {
+	/*
+		Decides what happens to the pixel data of an image after it has been uploaded to the GPU.
+		Only images loaded from a file can be evicted, images from memory have no source to be reloaded from.
+	*/
+	enum class ImageResidency : uint32
+	{
+		KEEP = 0,			// Keep the pixel data in RAM for as long as the image lives.
+		DROP_AFTER_UPLOAD,	// Free the pixel data directly after the upload, it is reloaded when requested.
+		LRU_BUDGET			// Keep the pixel data while the total is under the budget, the least recently used image is evicted first.
+	};
+
 	struct ImageLoadDesc
 	{
 		enum class Channels : uint32
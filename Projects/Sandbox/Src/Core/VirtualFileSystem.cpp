@@ -0,0 +1,216 @@
+#include "PreCompiled.h"
+#include "VirtualFileSystem.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <chrono>
+
+using namespace RS;
+
+LooseFileBackend::LooseFileBackend(const std::string& rootPath) : m_RootPath(rootPath)
+{
+	if (!m_RootPath.empty() && m_RootPath.back() != '/' && m_RootPath.back() != '\\')
+		m_RootPath += "/";
+}
+
+bool LooseFileBackend::Exists(const std::string& path) const
+{
+	DWORD attributes = GetFileAttributesA((m_RootPath + path).c_str());
+	return attributes != INVALID_FILE_ATTRIBUTES && !(attributes & FILE_ATTRIBUTE_DIRECTORY);
+}
+
+bool LooseFileBackend::Read(const std::string& path, FileView& outView) const
+{
+	std::shared_ptr<MappedFile> pFile = std::make_shared<MappedFile>();
+	if (!pFile->Open(m_RootPath + path))
+		return false;
+
+	outView.pData		= pFile->GetData();
+	outView.Size		= pFile->GetSize();
+	outView.IsZeroCopy	= true;
+	outView.pOwner		= pFile; // Unmapped when the last view is destroyed.
+	return true;
+}
+
+void LooseFileBackend::ListFiles(std::vector<std::string>& outPaths) const
+{
+	std::error_code error;
+	for (const auto& entry : std::filesystem::recursive_directory_iterator(m_RootPath, error))
+	{
+		if (entry.is_regular_file())
+		{
+			std::string relativePath = std::filesystem::relative(entry.path(), m_RootPath, error).generic_string();
+			outPaths.push_back(VirtualFileSystem::NormalizePath(relativePath));
+		}
+	}
+}
+
+std::string LooseFileBackend::GetName() const
+{
+	return "Loose files [" + m_RootPath + "]";
+}
+
+bool PackFileBackend::Open(const std::string& packPath)
+{
+	m_PackPath = packPath;
+	return m_Archive.Open(packPath);
+}
+
+bool PackFileBackend::Exists(const std::string& path) const
+{
+	return m_Archive.Find(path) != nullptr;
+}
+
+bool PackFileBackend::Read(const std::string& path, FileView& outView) const
+{
+	const PackArchive::Entry* pEntry = m_Archive.Find(path);
+	if (pEntry == nullptr)
+		return false;
+	return m_Archive.Read(pEntry, outView);
+}
+
+void PackFileBackend::ListFiles(std::vector<std::string>& outPaths) const
+{
+	for (uint32 i = 0; i < m_Archive.GetNumEntries(); i++)
+		outPaths.push_back(std::string(m_Archive.GetPath(m_Archive.GetEntry(i))));
+}
+
+std::string PackFileBackend::GetName() const
+{
+	return "Pack [" + m_PackPath + "]";
+}
+
+std::shared_ptr<VirtualFileSystem> VirtualFileSystem::Get()
+{
+	static std::shared_ptr<VirtualFileSystem> s_VirtualFileSystem = std::make_shared<VirtualFileSystem>();
+	return s_VirtualFileSystem;
+}
+
+void VirtualFileSystem::Init()
+{
+	m_NumReads			= 0;
+	m_NumFailedReads	= 0;
+	m_NumZeroCopyReads	= 0;
+	m_BytesRead			= 0;
+	m_TotalReadTimeUS	= 0;
+}
+
+void VirtualFileSystem::Release()
+{
+	UnmountAll();
+}
+
+bool VirtualFileSystem::MountLooseFiles(const std::string& rootPath)
+{
+	m_Backends.push_back(std::make_unique<LooseFileBackend>(rootPath));
+	LOG_INFO("Mounted {}", m_Backends.back()->GetName().c_str());
+	return true;
+}
+
+bool VirtualFileSystem::MountPack(const std::string& packPath)
+{
+	std::unique_ptr<PackFileBackend> pBackend = std::make_unique<PackFileBackend>();
+	if (!pBackend->Open(packPath))
+		return false;
+
+	m_Backends.push_back(std::move(pBackend));
+	LOG_INFO("Mounted {}", m_Backends.back()->GetName().c_str());
+	return true;
+}
+
+void VirtualFileSystem::UnmountAll()
+{
+	m_Backends.clear();
+}
+
+bool VirtualFileSystem::Read(const std::string& path, FileView& outView)
+{
+	auto startTime = std::chrono::steady_clock::now();
+
+	std::string normalizedPath = NormalizePath(path);
+	bool succeeded = false;
+	for (const std::unique_ptr<IFileBackend>& pBackend : m_Backends)
+	{
+		if (pBackend->Read(normalizedPath, outView))
+		{
+			succeeded = true;
+			break;
+		}
+	}
+
+	uint64 timeUS = (uint64)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count();
+	m_TotalReadTimeUS += timeUS;
+	m_NumReads++;
+	if (succeeded)
+	{
+		m_BytesRead += outView.Size;
+		if (outView.IsZeroCopy)
+			m_NumZeroCopyReads++;
+	}
+	else
+	{
+		m_NumFailedReads++;
+	}
+	return succeeded;
+}
+
+bool VirtualFileSystem::Exists(const std::string& path) const
+{
+	std::string normalizedPath = NormalizePath(path);
+	for (const std::unique_ptr<IFileBackend>& pBackend : m_Backends)
+	{
+		if (pBackend->Exists(normalizedPath))
+			return true;
+	}
+	return false;
+}
+
+std::string VirtualFileSystem::NormalizePath(const std::string& path)
+{
+	std::string str = path;
+	std::replace(str.begin(), str.end(), '\\', '/');
+
+	static const std::string s_AssetPath = RS_ASSET_PATH;
+	if (str.compare(0, s_AssetPath.size(), s_AssetPath) == 0)
+		str = str.substr(s_AssetPath.size());
+
+	// Resolve "." and "..".
+	std::vector<std::string> parts;
+	size_t start = 0;
+	while (start <= str.size())
+	{
+		size_t end = str.find('/', start);
+		if (end == std::string::npos)
+			end = str.size();
+
+		std::string part = str.substr(start, end - start);
+		if (part == "..")
+		{
+			if (!parts.empty() && parts.back() != "..")
+				parts.pop_back();
+			else
+				parts.push_back(part);
+		}
+		else if (!part.empty() && part != ".")
+		{
+			parts.push_back(part);
+		}
+		start = end + 1;
+	}
+
+	std::string result;
+	for (size_t i = 0; i < parts.size(); i++)
+		result += (i == 0 ? "" : "/") + parts[i];
+	return result;
+}
+
+VirtualFileSystem::Stats VirtualFileSystem::GetStats() const
+{
+	Stats stats;
+	stats.NumReads			= m_NumReads;
+	stats.NumFailedReads	= m_NumFailedReads;
+	stats.NumZeroCopyReads	= m_NumZeroCopyReads;
+	stats.BytesRead			= m_BytesRead;
+	stats.TotalReadTimeMS	= (float)m_TotalReadTimeUS / 1000.f;
+	return stats;
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "Core/FileView.h"
+#include "Core/PackArchive.h"
+
+#include <atomic>
+
+namespace RS
+{
+	/*
+	* A source of files for the VirtualFileSystem. All paths are relative to the asset folder and normalized.
+	*/
+	class IFileBackend
+	{
+	public:
+		RS_DEFAULT_ABSTRACT_CLASS(IFileBackend);
+
+		virtual bool Exists(const std::string& path) const = 0;
+		virtual bool Read(const std::string& path, FileView& outView) const = 0;
+		virtual void ListFiles(std::vector<std::string>& outPaths) const = 0;
+		virtual std::string GetName() const = 0;
+	};
+
+	/*
+	* Reads loose files from a folder on disk. The files are memory mapped for as long as the view lives.
+	*/
+	class LooseFileBackend : public IFileBackend
+	{
+	public:
+		LooseFileBackend(const std::string& rootPath);
+
+		bool Exists(const std::string& path) const override;
+		bool Read(const std::string& path, FileView& outView) const override;
+		void ListFiles(std::vector<std::string>& outPaths) const override;
+		std::string GetName() const override;
+
+	private:
+		std::string m_RootPath;
+	};
+
+	/*
+	* Reads files from a single memory mapped pack archive.
+	*/
+	class PackFileBackend : public IFileBackend
+	{
+	public:
+		bool Open(const std::string& packPath);
+
+		bool Exists(const std::string& path) const override;
+		bool Read(const std::string& path, FileView& outView) const override;
+		void ListFiles(std::vector<std::string>& outPaths) const override;
+		std::string GetName() const override;
+
+	private:
+		std::string m_PackPath;
+		PackArchive m_Archive;
+	};
+
+	class VirtualFileSystem
+	{
+	public:
+		struct Stats
+		{
+			uint32	NumReads			= 0;
+			uint32	NumFailedReads		= 0;
+			uint32	NumZeroCopyReads	= 0;
+			uint64	BytesRead			= 0;
+			float	TotalReadTimeMS		= 0.f;
+		};
+
+	public:
+		RS_DEFAULT_ABSTRACT_CLASS(VirtualFileSystem);
+
+		static std::shared_ptr<VirtualFileSystem> Get();
+
+		void Init();
+		void Release();
+
+		/*
+		* Backends are searched in the order they were mounted, mount packs before the loose files to let them take priority.
+		* Mounting is not thread safe, reading is.
+		*/
+		bool MountLooseFiles(const std::string& rootPath);
+		bool MountPack(const std::string& packPath);
+		void UnmountAll();
+
+		/*
+		* Read a file through the mounted backends. The path can either be relative to the asset folder or start with RS_ASSET_PATH.
+		*/
+		bool Read(const std::string& path, FileView& outView);
+		bool Exists(const std::string& path) const;
+
+		/*
+		* Makes the path relative to the asset folder, uses '/' as separator and resolves "." and "..".
+		* Example:
+		*	"../../Assets/Models\\FlightHelmet/./FlightHelmet.gltf" -> "Models/FlightHelmet/FlightHelmet.gltf"
+		*/
+		static std::string NormalizePath(const std::string& path);
+
+		Stats GetStats() const;
+
+	private:
+		std::vector<std::unique_ptr<IFileBackend>> m_Backends;
+
+		// Stats
+		std::atomic<uint32>	m_NumReads				= 0;
+		std::atomic<uint32>	m_NumFailedReads		= 0;
+		std::atomic<uint32>	m_NumZeroCopyReads		= 0;
+		std::atomic<uint64>	m_BytesRead				= 0;
+		std::atomic<uint64>	m_TotalReadTimeUS		= 0;
+	};
+}
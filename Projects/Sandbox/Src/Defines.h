@@ -18,6 +18,8 @@
 #endif
 
 #define RS_CONFIG_FILE_PATH "../../Assets/Config/EngineConfig.json"
+#define RS_ASSET_PATH "../../Assets/"
+#define RS_COOKED_PATH "../../Assets/Cooked/"
 #define RS_SHADER_PATH "../../Assets/Shaders/"
 #define RS_TEXTURE_PATH "../../Assets/Textures/"
 #define RS_MODEL_PATH "../../Assets/Models/"
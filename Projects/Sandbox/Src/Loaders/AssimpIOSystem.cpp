@@ -0,0 +1,109 @@
+#include "PreCompiled.h"
+#include "AssimpIOSystem.h"
+
+#include "Core/VirtualFileSystem.h"
+
+#include <algorithm>
+
+using namespace RS;
+
+AssimpIOStream::AssimpIOStream(FileView&& view) : m_View(std::move(view))
+{
+}
+
+size_t AssimpIOStream::Read(void* pvBuffer, size_t pSize, size_t pCount)
+{
+	if (pSize == 0 || pCount == 0)
+		return 0;
+
+	size_t available = (size_t)m_View.Size - m_Position;
+	size_t count = std::min(pCount, available / pSize);
+	size_t bytes = count * pSize;
+	if (bytes > 0)
+	{
+		memcpy(pvBuffer, m_View.pData + m_Position, bytes);
+		m_Position += bytes;
+	}
+	return count;
+}
+
+size_t AssimpIOStream::Write(const void* pvBuffer, size_t pSize, size_t pCount)
+{
+	RS_UNREFERENCED_VARIABLE(pvBuffer);
+	RS_UNREFERENCED_VARIABLE(pSize);
+	RS_UNREFERENCED_VARIABLE(pCount);
+	LOG_WARNING("Assimp tried to write to a file in the virtual file system, which is read-only!");
+	return 0;
+}
+
+aiReturn AssimpIOStream::Seek(size_t pOffset, aiOrigin pOrigin)
+{
+	size_t newPosition = 0;
+	switch (pOrigin)
+	{
+	case aiOrigin_SET: newPosition = pOffset; break;
+	case aiOrigin_CUR: newPosition = m_Position + pOffset; break;
+	case aiOrigin_END: newPosition = (size_t)m_View.Size - pOffset; break;
+	default:
+		return aiReturn_FAILURE;
+	}
+
+	if (newPosition > (size_t)m_View.Size)
+		return aiReturn_FAILURE;
+	m_Position = newPosition;
+	return aiReturn_SUCCESS;
+}
+
+size_t AssimpIOStream::Tell() const
+{
+	return m_Position;
+}
+
+size_t AssimpIOStream::FileSize() const
+{
+	return (size_t)m_View.Size;
+}
+
+void AssimpIOStream::Flush()
+{
+}
+
+AssimpIOSystem::AssimpIOSystem(std::vector<std::string>* pOpenedFiles) : m_pOpenedFiles(pOpenedFiles)
+{
+}
+
+bool AssimpIOSystem::Exists(const char* pFile) const
+{
+	return VirtualFileSystem::Get()->Exists(pFile);
+}
+
+char AssimpIOSystem::getOsSeparator() const
+{
+	return '/';
+}
+
+Assimp::IOStream* AssimpIOSystem::Open(const char* pFile, const char* pMode)
+{
+	if (pMode && (strchr(pMode, 'w') || strchr(pMode, 'a')))
+	{
+		LOG_WARNING("Assimp tried to open {} for writing, the virtual file system is read-only!", pFile);
+		return nullptr;
+	}
+
+	FileView view;
+	if (!VirtualFileSystem::Get()->Read(pFile, view))
+		return nullptr;
+
+	if (m_pOpenedFiles)
+	{
+		std::string path = VirtualFileSystem::NormalizePath(pFile);
+		if (std::find(m_pOpenedFiles->begin(), m_pOpenedFiles->end(), path) == m_pOpenedFiles->end())
+			m_pOpenedFiles->push_back(path);
+	}
+	return new AssimpIOStream(std::move(view));
+}
+
+void AssimpIOSystem::Close(Assimp::IOStream* pFile)
+{
+	delete pFile;
+}
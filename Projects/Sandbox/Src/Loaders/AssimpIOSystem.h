@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Core/FileView.h"
+
+#include <assimp/IOStream.hpp>
+#include <assimp/IOSystem.hpp>
+
+namespace RS
+{
+	/*
+	* Lets Assimp read the model and the files it references (e.g. .bin files of gltf) through the VirtualFileSystem.
+	*/
+	class AssimpIOStream : public Assimp::IOStream
+	{
+	public:
+		AssimpIOStream(FileView&& view);
+
+		size_t Read(void* pvBuffer, size_t pSize, size_t pCount) override;
+		size_t Write(const void* pvBuffer, size_t pSize, size_t pCount) override;
+		aiReturn Seek(size_t pOffset, aiOrigin pOrigin) override;
+		size_t Tell() const override;
+		size_t FileSize() const override;
+		void Flush() override;
+
+	private:
+		FileView	m_View;
+		size_t		m_Position = 0;
+	};
+
+	class AssimpIOSystem : public Assimp::IOSystem
+	{
+	public:
+		/*
+		* If pOpenedFiles is set, the normalized path of every file which was opened is added to it. This is used to track the dependencies of a model.
+		*/
+		AssimpIOSystem(std::vector<std::string>* pOpenedFiles = nullptr);
+
+		bool Exists(const char* pFile) const override;
+		char getOsSeparator() const override;
+		Assimp::IOStream* Open(const char* pFile, const char* pMode = "rb") override;
+		void Close(Assimp::IOStream* pFile) override;
+
+	private:
+		std::vector<std::string>* m_pOpenedFiles = nullptr;
+	};
+}
@@ -0,0 +1,608 @@
+#include "PreCompiled.h"
+#include "CookedAssets.h"
+
+#pragma warning( push )
+#pragma warning( disable : 6011 )
+#pragma warning( disable : 6262 )
+#pragma warning( disable : 6308 )
+#pragma warning( disable : 6387 )
+#pragma warning( disable : 26451 )
+#pragma warning( disable : 28182 )
+#include <stb_image.h>
+#pragma warning( pop )
+
+#include "Core/VirtualFileSystem.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+using namespace RS;
+
+bool CookedAssets::s_Enabled = true;
+
+namespace
+{
+	class BinaryWriter
+	{
+	public:
+		BinaryWriter(std::vector<uint8>& data) : m_Data(data) {}
+
+		void WriteBytes(const void* pData, uint64 size)
+		{
+			const uint8* pBytes = (const uint8*)pData;
+			m_Data.insert(m_Data.end(), pBytes, pBytes + size);
+		}
+
+		template<typename T>
+		void Write(const T& value)
+		{
+			WriteBytes(&value, sizeof(T));
+		}
+
+		void WriteString(const std::string& str)
+		{
+			Write<uint32>((uint32)str.size());
+			WriteBytes(str.data(), str.size());
+		}
+
+	private:
+		std::vector<uint8>& m_Data;
+	};
+
+	/*
+	* Reads from a view with bounds checks. When a read fails, every read after it also fails.
+	*/
+	class BinaryReader
+	{
+	public:
+		BinaryReader(const uint8* pData, uint64 size) : m_pData(pData), m_Size(size) {}
+
+		bool ReadBytes(void* pData, uint64 size)
+		{
+			if (m_Failed || size > m_Size - m_Position)
+			{
+				m_Failed = true;
+				return false;
+			}
+			memcpy(pData, m_pData + m_Position, (size_t)size);
+			m_Position += size;
+			return true;
+		}
+
+		template<typename T>
+		bool Read(T& value)
+		{
+			return ReadBytes(&value, sizeof(T));
+		}
+
+		bool ReadString(std::string& str)
+		{
+			uint32 size = 0;
+			if (!Read(size) || size > m_Size - m_Position)
+			{
+				m_Failed = true;
+				return false;
+			}
+			str.assign((const char*)(m_pData + m_Position), (size_t)size);
+			m_Position += size;
+			return true;
+		}
+
+		template<typename T>
+		bool ReadVector(std::vector<T>& vec, uint64 count)
+		{
+			if (m_Failed || count * sizeof(T) > m_Size - m_Position)
+			{
+				m_Failed = true;
+				return false;
+			}
+			vec.resize((size_t)count);
+			return ReadBytes(vec.data(), count * sizeof(T));
+		}
+
+		bool HasFailed() const { return m_Failed; }
+
+	private:
+		const uint8*	m_pData		= nullptr;
+		uint64			m_Size		= 0;
+		uint64			m_Position	= 0;
+		bool			m_Failed	= false;
+	};
+
+	void WriteNode(BinaryWriter& writer, const ModelResource& model)
+	{
+		writer.WriteString(model.Name);
+		writer.Write(model.Transform);
+		writer.Write(model.BoundingBox);
+
+		writer.Write<uint32>((uint32)model.Meshes.size());
+		for (const MeshObject& mesh : model.Meshes)
+		{
+			writer.Write<uint32>((uint32)mesh.Vertices.size());
+			writer.WriteBytes(mesh.Vertices.data(), mesh.Vertices.size() * sizeof(MeshObject::Vertex));
+			writer.Write<uint32>((uint32)mesh.Indices.size());
+			writer.WriteBytes(mesh.Indices.data(), mesh.Indices.size() * sizeof(uint32));
+			writer.Write(mesh.BoundingBox);
+			writer.Write<uint32>(mesh.MaterialHandler);
+		}
+
+		writer.Write<uint32>((uint32)model.Children.size());
+		for (const ModelResource& child : model.Children)
+			WriteNode(writer, child);
+	}
+
+	bool ReadNode(BinaryReader& reader, ModelResource& model, ModelResource* pParent)
+	{
+		model.pParent = pParent;
+		reader.ReadString(model.Name);
+		reader.Read(model.Transform);
+		reader.Read(model.BoundingBox);
+
+		uint32 numMeshes = 0;
+		if (!reader.Read(numMeshes))
+			return false;
+		model.Meshes.resize((size_t)numMeshes);
+		for (MeshObject& mesh : model.Meshes)
+		{
+			reader.Read(mesh.NumVertices);
+			reader.ReadVector(mesh.Vertices, mesh.NumVertices);
+			reader.Read(mesh.NumIndices);
+			reader.ReadVector(mesh.Indices, mesh.NumIndices);
+			reader.Read(mesh.BoundingBox);
+			reader.Read(mesh.MaterialHandler);
+			if (reader.HasFailed())
+				return false;
+		}
+
+		uint32 numChildren = 0;
+		if (!reader.Read(numChildren))
+			return false;
+		// The children are not added after this, such that the parent pointers stay valid.
+		model.Children.resize((size_t)numChildren);
+		for (ModelResource& child : model.Children)
+		{
+			if (!ReadNode(reader, child, &model))
+				return false;
+		}
+		return !reader.HasFailed();
+	}
+
+	/*
+	* Returns false if the source file exists and differs from the one the cooked file was made from.
+	*/
+	bool IsSourceUnchanged(const std::string& sourcePath, uint64 size, uint64 hash)
+	{
+		FileView view;
+		if (!VirtualFileSystem::Get()->Exists(sourcePath) || !VirtualFileSystem::Get()->Read(sourcePath, view))
+			return true;
+		return view.Size == size && CookedAssets::HashData(view.pData, view.Size) == hash;
+	}
+
+	uint64 AlignUp(uint64 value, uint64 alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	// Four bands with linear transitions between them, the weights add up to 255.
+	void GetBandWeights(uint16 height, uint8* pWeights)
+	{
+		const float band = (float)height / (float)UINT16_MAX * 3.f;
+		const uint32 lower = std::min((uint32)band, 2u);
+		const uint8 lowerWeight = (uint8)std::lround((1.f - std::min(band - (float)lower, 1.f)) * 255.f);
+		memset(pWeights, 0, 4);
+		pWeights[lower] = lowerWeight;
+		pWeights[lower + 1] = 255 - lowerWeight;
+	}
+}
+
+void CookedAssets::SetEnabled(bool enabled)
+{
+	s_Enabled = enabled;
+}
+
+bool CookedAssets::IsEnabled()
+{
+	return s_Enabled;
+}
+
+std::string CookedAssets::GetCookedImagePath(const std::string& sourcePath)
+{
+	return std::string(RS_COOKED_PATH) + VirtualFileSystem::NormalizePath(sourcePath) + ".rsimg";
+}
+
+std::string CookedAssets::GetCookedModelPath(const std::string& sourcePath, ModelLoadDesc::LoaderFlags flags)
+{
+	return std::string(RS_COOKED_PATH) + VirtualFileSystem::NormalizePath(sourcePath) + "." + std::to_string(flags & ModelImporter::IMPORT_FLAGS_MASK) + ".rsmdl";
+}
+
+bool CookedAssets::CookImage(const uint8* pFileData, uint64 fileSize, bool isHDR, std::vector<uint8>& outData)
+{
+	int width = 0, height = 0, channelCount = 0;
+	void* pPixels = nullptr;
+	uint64 size = 0;
+	if (isHDR)
+	{
+		// HDR images are always loaded as four floats, the same as when they are loaded from the source.
+		pPixels = stbi_loadf_from_memory(pFileData, (int)fileSize, &width, &height, &channelCount, 4);
+		channelCount = 4;
+		size = (uint64)width * (uint64)height * 4 * sizeof(float);
+	}
+	else
+	{
+		pPixels = stbi_load_from_memory(pFileData, (int)fileSize, &width, &height, &channelCount, 0);
+		size = (uint64)width * (uint64)height * (uint64)channelCount;
+	}
+
+	if (!pPixels)
+	{
+		LOG_WARNING("Unable to cook image: {}", stbi_failure_reason());
+		return false;
+	}
+
+	ImageHeader header;
+	header.Width		= (uint32)width;
+	header.Height		= (uint32)height;
+	header.NumChannels	= (uint32)channelCount;
+	header.IsHDR		= isHDR ? 1 : 0;
+	header.DataSize		= size;
+	header.SourceSize	= fileSize;
+	header.SourceHash	= HashData(pFileData, fileSize);
+
+	outData.clear();
+	outData.reserve(sizeof(ImageHeader) + (size_t)size);
+	BinaryWriter writer(outData);
+	writer.Write(header);
+	writer.WriteBytes(pPixels, size);
+	stbi_image_free(pPixels);
+	return true;
+}
+
+bool CookedAssets::ReadImage(const std::string& sourcePath, int requestedChannels, CookedImage& outImage)
+{
+	if (!s_Enabled)
+		return false;
+
+	FileView view;
+	std::string cookedPath = GetCookedImagePath(sourcePath);
+	if (!VirtualFileSystem::Get()->Exists(cookedPath) || !VirtualFileSystem::Get()->Read(cookedPath, view))
+		return false;
+
+	BinaryReader reader(view.pData, view.Size);
+	ImageHeader header;
+	if (!reader.Read(header) || header.Magic != IMAGE_MAGIC || header.Version != VERSION)
+	{
+		LOG_WARNING("Cooked image [{}] is outdated or corrupt, loading the source instead!", cookedPath.c_str());
+		return false;
+	}
+
+	if (!IsSourceUnchanged(sourcePath, header.SourceSize, header.SourceHash))
+	{
+		LOG_WARNING("Cooked image [{}] was cooked from another version of the source, loading the source instead!", cookedPath.c_str());
+		return false;
+	}
+
+	outImage.Width			= header.Width;
+	outImage.Height			= header.Height;
+	outImage.NumChannels	= header.NumChannels;
+	outImage.IsHDR			= header.IsHDR != 0;
+	if (!reader.ReadVector(outImage.Data, header.DataSize))
+	{
+		LOG_WARNING("Cooked image [{}] is corrupt, loading the source instead!", cookedPath.c_str());
+		return false;
+	}
+
+	if (!outImage.IsHDR)
+		ConvertToTextureChannels(outImage, requestedChannels);
+	return true;
+}
+
+bool CookedAssets::CookModel(const ImportedModel& model, ModelLoadDesc::LoaderFlags flags, const std::vector<std::string>& sourcePaths, std::vector<uint8>& outData)
+{
+	ModelHeader header;
+	header.ImportFlags			= flags & ModelImporter::IMPORT_FLAGS_MASK;
+	header.NumMaterials			= (uint32)model.Materials.size();
+	header.NumEmbeddedTextures	= (uint32)model.EmbeddedTextures.size();
+	header.NumSources			= (uint32)sourcePaths.size();
+
+	outData.clear();
+	BinaryWriter writer(outData);
+	writer.Write(header);
+
+	for (const std::string& sourcePath : sourcePaths)
+	{
+		FileView view;
+		if (!VirtualFileSystem::Get()->Read(sourcePath, view))
+		{
+			LOG_WARNING("Unable to cook model: the source [{}] could not be read!", sourcePath.c_str());
+			return false;
+		}
+		writer.WriteString(VirtualFileSystem::NormalizePath(sourcePath));
+		writer.Write<uint64>(view.Size);
+		writer.Write<uint64>(HashData(view.pData, view.Size));
+	}
+
+	for (const ImportedMaterial& material : model.Materials)
+	{
+		writer.WriteString(material.Name);
+		writer.Write<uint32>(material.UseCombinedMetallicRoughness ? 1 : 0);
+		for (uint32 slot = 0; slot < ImportedMaterial::SLOT_COUNT; slot++)
+		{
+			writer.WriteString(material.Textures[slot].Path);
+			writer.Write<int32>(material.Textures[slot].EmbeddedIndex);
+		}
+	}
+
+	for (const ImportedEmbeddedTexture& texture : model.EmbeddedTextures)
+	{
+		writer.WriteString(texture.Name);
+		writer.Write<uint32>((uint32)texture.Data.size());
+		writer.WriteBytes(texture.Data.data(), texture.Data.size());
+	}
+
+	WriteNode(writer, model.Root);
+	return true;
+}
+
+bool CookedAssets::ReadModel(const std::string& sourcePath, ModelLoadDesc::LoaderFlags flags, ImportedModel& outModel)
+{
+	if (!s_Enabled)
+		return false;
+
+	FileView view;
+	std::string cookedPath = GetCookedModelPath(sourcePath, flags);
+	if (!VirtualFileSystem::Get()->Exists(cookedPath) || !VirtualFileSystem::Get()->Read(cookedPath, view))
+		return false;
+
+	BinaryReader reader(view.pData, view.Size);
+	ModelHeader header;
+	if (!reader.Read(header) || header.Magic != MODEL_MAGIC || header.Version != VERSION || header.ImportFlags != (flags & ModelImporter::IMPORT_FLAGS_MASK))
+	{
+		LOG_WARNING("Cooked model [{}] is outdated or corrupt, importing the source instead!", cookedPath.c_str());
+		return false;
+	}
+
+	for (uint32 i = 0; i < header.NumSources; i++)
+	{
+		std::string path;
+		uint64 size = 0;
+		uint64 hash = 0;
+		reader.ReadString(path);
+		reader.Read(size);
+		if (!reader.Read(hash))
+		{
+			LOG_WARNING("Cooked model [{}] is corrupt, importing the source instead!", cookedPath.c_str());
+			return false;
+		}
+
+		if (!IsSourceUnchanged(path, size, hash))
+		{
+			LOG_WARNING("Cooked model [{}] was cooked from another version of [{}], importing the source instead!", cookedPath.c_str(), path.c_str());
+			return false;
+		}
+	}
+
+	outModel.Materials.resize((size_t)header.NumMaterials);
+	for (ImportedMaterial& material : outModel.Materials)
+	{
+		uint32 useCombined = 0;
+		reader.ReadString(material.Name);
+		reader.Read(useCombined);
+		material.UseCombinedMetallicRoughness = useCombined != 0;
+		for (uint32 slot = 0; slot < ImportedMaterial::SLOT_COUNT; slot++)
+		{
+			reader.ReadString(material.Textures[slot].Path);
+			reader.Read(material.Textures[slot].EmbeddedIndex);
+		}
+	}
+
+	outModel.EmbeddedTextures.resize((size_t)header.NumEmbeddedTextures);
+	for (ImportedEmbeddedTexture& texture : outModel.EmbeddedTextures)
+	{
+		uint32 size = 0;
+		reader.ReadString(texture.Name);
+		reader.Read(size);
+		reader.ReadVector(texture.Data, size);
+	}
+
+	if (reader.HasFailed() || !ReadNode(reader, outModel.Root, nullptr))
+	{
+		LOG_WARNING("Cooked model [{}] is corrupt, importing the source instead!", cookedPath.c_str());
+		outModel = ImportedModel();
+		return false;
+	}
+	return true;
+}
+
+std::string CookedAssets::GetCookedTerrainPath(const std::string& sourcePath)
+{
+	return std::string(RS_COOKED_PATH) + VirtualFileSystem::NormalizePath(sourcePath) + ".rster";
+}
+
+bool CookedAssets::CookTerrain(const uint16* pHeights, const uint8* pSplat, uint32 size, uint32 tileSize, uint32 leafSize, std::vector<uint8>& outData)
+{
+	if (!std::has_single_bit(size) || !std::has_single_bit(tileSize) || !std::has_single_bit(leafSize) || tileSize > size || leafSize > tileSize)
+	{
+		LOG_WARNING("Unable to cook terrain: the size {}, tile size {} and leaf size {} are not powers of two which fit into each other!", size, tileSize, leafSize);
+		return false;
+	}
+
+	const uint32 numLeaves = size / leafSize;
+	TerrainHeader header;
+	header.Size			= size;
+	header.TileSize		= tileSize;
+	header.NumLevels	= (uint32)std::countr_zero(size / tileSize) + 1;
+	header.LeafSize		= leafSize;
+	header.SplatOffset	= (uint32)AlignUp((uint64)(tileSize + 3) * (tileSize + 3) * sizeof(uint16), 4);
+	header.TileStride	= (uint32)AlignUp(header.SplatOffset + (uint64)(tileSize + 1) * (tileSize + 1) * 4, TERRAIN_TILE_ALIGNMENT);
+	header.MinMaxOffset	= sizeof(TerrainHeader);
+	header.TilesOffset	= AlignUp(header.MinMaxOffset + (uint64)numLeaves * numLeaves * 2 * sizeof(uint16), TERRAIN_TILE_ALIGNMENT);
+
+	outData.assign((size_t)GetTerrainTileOffset(header, header.NumLevels, 0, 0), 0);
+	memcpy(outData.data(), &header, sizeof(TerrainHeader));
+
+	auto GetHeight = [&](int64 x, int64 z)
+	{
+		x = std::clamp<int64>(x, 0, (int64)size - 1);
+		z = std::clamp<int64>(z, 0, (int64)size - 1);
+		return pHeights[z * size + x];
+	};
+
+	// A leaf also holds the first row and column of its neighbours, since its last quads end there.
+	uint16* pMinMax = (uint16*)(outData.data() + header.MinMaxOffset);
+	for (uint32 leafZ = 0; leafZ < numLeaves; leafZ++)
+	{
+		for (uint32 leafX = 0; leafX < numLeaves; leafX++, pMinMax += 2)
+		{
+			pMinMax[0] = UINT16_MAX;
+			pMinMax[1] = 0;
+			for (uint32 z = leafZ * leafSize; z <= (leafZ + 1) * leafSize; z++)
+			{
+				for (uint32 x = leafX * leafSize; x <= (leafX + 1) * leafSize; x++)
+				{
+					const uint16 height = GetHeight(x, z);
+					pMinMax[0] = std::min(pMinMax[0], height);
+					pMinMax[1] = std::max(pMinMax[1], height);
+				}
+			}
+		}
+	}
+
+	for (uint32 level = 0; level < header.NumLevels; level++)
+	{
+		const int64 step = 1ll << level;
+		const uint32 numTiles = GetNumTerrainTiles(header, level);
+		for (uint32 tileZ = 0; tileZ < numTiles; tileZ++)
+		{
+			for (uint32 tileX = 0; tileX < numTiles; tileX++)
+			{
+				uint8* pTile = outData.data() + GetTerrainTileOffset(header, level, tileX, tileZ);
+				const int64 firstX = (int64)tileX * tileSize;
+				const int64 firstZ = (int64)tileZ * tileSize;
+
+				uint16* pTileHeights = (uint16*)pTile;
+				for (int32 z = -1; z <= (int32)tileSize + 1; z++)
+				{
+					for (int32 x = -1; x <= (int32)tileSize + 1; x++)
+						pTileHeights[GetTerrainHeightIndex(header, x, z)] = GetHeight((firstX + x) * step, (firstZ + z) * step);
+				}
+
+				uint8* pTileSplat = pTile + header.SplatOffset;
+				for (int64 z = 0; z <= (int64)tileSize; z++)
+				{
+					for (int64 x = 0; x <= (int64)tileSize; x++, pTileSplat += 4)
+					{
+						const int64 sampleX = std::min((firstX + x) * step, (int64)size - 1);
+						const int64 sampleZ = std::min((firstZ + z) * step, (int64)size - 1);
+						if (pSplat)
+							memcpy(pTileSplat, pSplat + (sampleZ * size + sampleX) * 4, 4);
+						else
+							GetBandWeights(GetHeight(sampleX, sampleZ), pTileSplat);
+					}
+				}
+			}
+		}
+	}
+	return true;
+}
+
+bool CookedAssets::ReadTerrainHeader(const FileView& view, TerrainHeader& outHeader)
+{
+	BinaryReader reader(view.pData, view.Size);
+	if (!reader.Read(outHeader) || outHeader.Magic != TERRAIN_MAGIC || outHeader.Version != VERSION)
+	{
+		LOG_WARNING("Cooked terrain is outdated or corrupt!");
+		return false;
+	}
+
+	const TerrainHeader& header = outHeader;
+	const bool hasValidSizes = std::has_single_bit(header.Size) && std::has_single_bit(header.TileSize) && std::has_single_bit(header.LeafSize)
+		&& header.TileSize <= header.Size && header.LeafSize <= header.TileSize && header.NumLevels == (uint32)std::countr_zero(header.Size / header.TileSize) + 1
+		&& header.SplatOffset >= (header.TileSize + 3) * (header.TileSize + 3) * sizeof(uint16) && header.TileStride >= header.SplatOffset + (header.TileSize + 1) * (header.TileSize + 1) * 4
+		&& header.TilesOffset >= header.MinMaxOffset + (uint64)(header.Size / header.LeafSize) * (header.Size / header.LeafSize) * 2 * sizeof(uint16);
+	if (!hasValidSizes || GetTerrainTileOffset(header, header.NumLevels, 0, 0) > view.Size)
+	{
+		LOG_WARNING("Cooked terrain is corrupt or truncated!");
+		return false;
+	}
+	return true;
+}
+
+uint32 CookedAssets::GetNumTerrainTiles(const TerrainHeader& header, uint32 level)
+{
+	return (header.Size / header.TileSize) >> level;
+}
+
+uint64 CookedAssets::GetTerrainTileOffset(const TerrainHeader& header, uint32 level, uint32 x, uint32 z)
+{
+	// The offset of the first tile after the last level is the size of the file.
+	uint64 index = 0;
+	for (uint32 previous = 0; previous < level; previous++)
+		index += (uint64)GetNumTerrainTiles(header, previous) * GetNumTerrainTiles(header, previous);
+	index += (uint64)z * GetNumTerrainTiles(header, level) + x;
+	return header.TilesOffset + index * header.TileStride;
+}
+
+uint32 CookedAssets::GetTerrainHeightIndex(const TerrainHeader& header, int32 x, int32 z)
+{
+	// The apron sample before the origin comes first.
+	return (uint32)(z + 1) * (header.TileSize + 3) + (uint32)(x + 1);
+}
+
+uint64 CookedAssets::HashData(const uint8* pData, uint64 size)
+{
+	// FNV-1a
+	uint64 hash = 14695981039346656037ull;
+	for (uint64 i = 0; i < size; i++)
+	{
+		hash ^= pData[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+void CookedAssets::ConvertToTextureChannels(CookedImage& image, int requestedChannels)
+{
+	const uint32 numChannels = requestedChannels == 0 ? image.NumChannels : (uint32)requestedChannels;
+	ConvertChannels(image, numChannels == 3 ? 4 : numChannels);
+}
+
+void CookedAssets::ConvertChannels(CookedImage& image, uint32 numChannels)
+{
+	const uint32 src = image.NumChannels;
+	const uint32 dst = numChannels;
+	if (src == dst || src == 0 || dst == 0 || src > 4 || dst > 4)
+		return;
+
+	// Same conversion as stb_image does when a channel count is requested.
+	const uint64 numPixels = (uint64)image.Width * (uint64)image.Height;
+	std::vector<uint8> data((size_t)(numPixels * dst));
+	for (uint64 i = 0; i < numPixels; i++)
+	{
+		const uint8* s = image.Data.data() + i * src;
+		uint8* d = data.data() + i * dst;
+
+		uint8 r = s[0], g = s[0], b = s[0], a = 255;
+		if (src == 2)
+			a = s[1];
+		else if (src >= 3)
+		{
+			g = s[1];
+			b = s[2];
+			a = src == 4 ? s[3] : 255;
+		}
+		uint8 luminance = src >= 3 ? (uint8)(((uint32)r * 77 + (uint32)g * 150 + (uint32)b * 29) >> 8) : r;
+
+		switch (dst)
+		{
+		case 1: d[0] = luminance; break;
+		case 2: d[0] = luminance; d[1] = a; break;
+		case 3: d[0] = r; d[1] = g; d[2] = b; break;
+		case 4: d[0] = r; d[1] = g; d[2] = b; d[3] = a; break;
+		default: break;
+		}
+	}
+
+	image.Data			= std::move(data);
+	image.NumChannels	= dst;
+}
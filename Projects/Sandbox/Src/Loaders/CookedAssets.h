@@ -0,0 +1,157 @@
+#pragma once
+
+#include "Core/FileView.h"
+#include "Loaders/ModelImporter.h"
+
+namespace RS
+{
+	/*
+	* Runtime-ready versions of the assets, which are written by the Cooker.
+	* They are placed in RS_COOKED_PATH, inside of the asset folder, such that they are read through the VirtualFileSystem and can be packed.
+	* The loaders use the cooked file instead of the source file when it exists and was cooked from the same source files.
+	* A source file which can not be found is not checked, such that the cooked files can be shipped without the sources.
+	*/
+	class CookedAssets
+	{
+	public:
+		// Increase this when a file format or an importer changes, it will make the Cooker recook everything and the loaders ignore old files.
+		static const uint32 VERSION		= 2;
+		static const uint32 IMAGE_MAGIC	= 0x4D495352; // "RSIM"
+		static const uint32 MODEL_MAGIC	= 0x444D5352; // "RSMD"
+		static const uint32 TERRAIN_MAGIC	= 0x52545352; // "RSTR"
+
+		// Terrain tiles start on a page, such that reading one tile of a mapped file only touches the pages of that tile.
+		static const uint32 TERRAIN_TILE_ALIGNMENT = 4096;
+
+		struct ImageHeader
+		{
+			uint32	Magic		= IMAGE_MAGIC;
+			uint32	Version		= VERSION;
+			uint32	Width		= 0;
+			uint32	Height		= 0;
+			uint32	NumChannels	= 0;
+			uint32	IsHDR		= 0;
+			uint64	DataSize	= 0;
+			uint64	SourceSize	= 0;
+			uint64	SourceHash	= 0;
+		};
+
+		struct ModelHeader
+		{
+			uint32	Magic				= MODEL_MAGIC;
+			uint32	Version				= VERSION;
+			uint32	ImportFlags			= 0;
+			uint32	NumMaterials		= 0;
+			uint32	NumEmbeddedTextures	= 0;
+			uint32	NumSources			= 0; // Followed by the path, size and hash of each file the model was imported from.
+		};
+
+		/*
+		* A terrain which is cut into tiles of TileSize x TileSize quads on each level of a pyramid, level k has every 2^k-th sample of level 0.
+		* A tile holds (TileSize + 3)^2 uint16 heights, with one apron sample on each side for the normals, then (TileSize + 1)^2 RGBA8 splat weights.
+		* The tiles are stored level by level in rows of increasing z, each at a multiple of TERRAIN_TILE_ALIGNMENT.
+		* The min/max map holds a uint16 pair for each LeafSize x LeafSize cell of level 0, the same as the leaves of TerrainQuadtree.
+		*/
+		struct TerrainHeader
+		{
+			uint32	Magic			= TERRAIN_MAGIC;
+			uint32	Version			= VERSION;
+			uint32	Size			= 0; // Quads along a side of level 0, there are as many samples since the last quads use the last sample again.
+			uint32	TileSize		= 0;
+			uint32	NumLevels		= 0; // The last level is a single tile.
+			uint32	LeafSize		= 0;
+			uint32	TileStride		= 0; // Bytes from the start of a tile to the next one.
+			uint32	SplatOffset		= 0; // Bytes from the start of a tile to its splat weights.
+			uint64	MinMaxOffset	= 0;
+			uint64	TilesOffset		= 0;
+		};
+
+		/*
+		* Decoded pixels. LDR images have 8 bits per channel, HDR images are always four 32 bit floats per pixel.
+		*/
+		struct CookedImage
+		{
+			uint32				Width		= 0;
+			uint32				Height		= 0;
+			uint32				NumChannels	= 0;
+			bool				IsHDR		= false;
+			std::vector<uint8>	Data;
+		};
+
+	public:
+		RS_DEFAULT_ABSTRACT_CLASS(CookedAssets);
+
+		static void SetEnabled(bool enabled);
+		static bool IsEnabled();
+
+		/*
+		* The cooked path is the normalized source path with an extension added, relative to the asset folder.
+		* Example:
+		*	"../../Assets/Textures/Home.jpg" -> "Cooked/Textures/Home.jpg.rsimg"
+		* Models also include the import flags, since they change the result.
+		*/
+		static std::string GetCookedImagePath(const std::string& sourcePath);
+		static std::string GetCookedModelPath(const std::string& sourcePath, ModelLoadDesc::LoaderFlags flags);
+
+		/*
+		* Decode the image file and write it in the cooked format. The image keeps the channel count of the source.
+		*/
+		static bool CookImage(const uint8* pFileData, uint64 fileSize, bool isHDR, std::vector<uint8>& outData);
+
+		/*
+		* Read the cooked version of the source image, the channels are converted with ConvertToTextureChannels.
+		* Returns false if there is no valid cooked file, the caller should load the source file instead.
+		*/
+		static bool ReadImage(const std::string& sourcePath, int requestedChannels, CookedImage& outImage);
+
+		/*
+		* The source paths are every file the model was imported from (See ModelImporter::ImportWithAssimp), they are read to stamp the cooked file.
+		*/
+		static bool CookModel(const ImportedModel& model, ModelLoadDesc::LoaderFlags flags, const std::vector<std::string>& sourcePaths, std::vector<uint8>& outData);
+
+		/*
+		* Read the cooked version of the source model which was imported with the same import flags.
+		* Returns false if there is no valid cooked file, the caller should import the source file instead.
+		*/
+		static bool ReadModel(const std::string& sourcePath, ModelLoadDesc::LoaderFlags flags, ImportedModel& outModel);
+
+		/*
+		* Example:
+		*	"../../Assets/Terrains/Valley.r16" -> "Cooked/Terrains/Valley.r16.rster"
+		*/
+		static std::string GetCookedTerrainPath(const std::string& sourcePath);
+
+		/*
+		* Cut size x size heights, in rows of increasing z, into the tiles of a terrain. Size and the tile size are powers of two and the leaf size is at most the tile size.
+		* pSplat holds four RGBA8 weights for each height. If it is null, the weights follow the height in four bands.
+		*/
+		static bool CookTerrain(const uint16* pHeights, const uint8* pSplat, uint32 size, uint32 tileSize, uint32 leafSize, std::vector<uint8>& outData);
+
+		/*
+		* Check the header of a cooked terrain and that the view holds all of its tiles.
+		*/
+		static bool ReadTerrainHeader(const FileView& view, TerrainHeader& outHeader);
+
+		static uint32 GetNumTerrainTiles(const TerrainHeader& header, uint32 level); // Along a side of the level.
+		static uint64 GetTerrainTileOffset(const TerrainHeader& header, uint32 level, uint32 x, uint32 z);
+		static uint32 GetTerrainHeightIndex(const TerrainHeader& header, int32 x, int32 z); // Of a sample in the heights of a tile, x and z are from the origin in [-1, TileSize + 1].
+
+		/*
+		* FNV-1a of the content of a file, the stamp of a source in the cooked files and in the dependency database of the Cooker.
+		*/
+		static uint64 HashData(const uint8* pData, uint64 size);
+
+		/*
+		* Convert the pixels of a decoded LDR image to the requested channel count, or keep its count if requestedChannels is zero.
+		* Three channels are always expanded to four, there is no texture format for them (See ResourceLoader::GetFormatFromChannelCount).
+		* Both the cooked images and the images decoded from the source are converted with this, such that they are the same.
+		*/
+		static void ConvertToTextureChannels(CookedImage& image, int requestedChannels);
+
+	private:
+		static void ConvertChannels(CookedImage& image, uint32 numChannels);
+
+	private:
+		static bool s_Enabled;
+	};
+}
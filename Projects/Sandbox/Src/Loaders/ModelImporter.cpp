@@ -0,0 +1,280 @@
+#include "PreCompiled.h"
+#include "ModelImporter.h"
+
+#include <algorithm>
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+#include <assimp/pbrmaterial.h>
+
+#include "Loaders/AssimpIOSystem.h"
+
+using namespace RS;
+
+bool ModelImporter::ImportWithAssimp(const std::string& filePath, ModelLoadDesc::LoaderFlags flags, ImportedModel& outModel, std::vector<std::string>* pOpenedFiles)
+{
+	static const bool s_UseLH = false;
+	Assimp::Importer importer;
+	importer.SetIOHandler(new AssimpIOSystem(pOpenedFiles)); // The importer takes ownership of the IO system.
+
+	// Remove the line and point primitives. This ensure the mesh always contains only triangles together with the aiProcess_Triangulate flag.
+	importer.SetPropertyInteger(AI_CONFIG_PP_SBP_REMOVE, aiPrimitiveType_LINE | aiPrimitiveType_POINT);
+
+	// Bounding boxes are always generated, such that the result does not depend on LOADER_FLAG_GENERATE_BOUNDING_BOX.
+	int assimpFlags = aiProcess_CalcTangentSpace | aiProcess_Triangulate | aiProcess_JoinIdenticalVertices | aiProcess_SortByPType | aiProcess_GenBoundingBoxes;
+	if (flags & ModelLoadDesc::LoaderFlag::LOADER_FLAG_WINDING_ORDER_CW)
+		assimpFlags |= aiProcess_FlipWindingOrder;
+	if (s_UseLH)
+		assimpFlags |= aiProcess_MakeLeftHanded;
+	if (flags & ModelLoadDesc::LoaderFlag::LOADER_FLAG_USE_UV_TOP_LEFT)
+		assimpFlags |= aiProcess_FlipUVs;
+	const aiScene* pScene = importer.ReadFile(filePath.c_str(), assimpFlags);
+
+	if (!pScene)
+	{
+		LOG_ERROR("Assimp Errror: {}", importer.GetErrorString());
+		return false;
+	}
+
+	outModel.Materials.resize((size_t)pScene->mNumMaterials);
+	for (uint32 i = 0; i < pScene->mNumMaterials; i++)
+		LoadMaterial(pScene, i, outModel.Materials[i], outModel);
+
+	outModel.Root.Name = std::string(pScene->mRootNode->mName.C_Str());
+	outModel.Root.BoundingBox.min = glm::vec3(FLT_MAX);
+	outModel.Root.BoundingBox.max = glm::vec3(FLT_MIN);
+	RecursiveLoadMeshes(pScene, pScene->mRootNode, &outModel.Root, glm::mat4(1.f));
+	return true;
+}
+
+void ModelImporter::RecursiveLoadMeshes(const aiScene* pScene, aiNode* pNode, ModelResource* pParent, glm::mat4 accTransform)
+{
+	ModelResource* pTargetParent = nullptr;
+
+	glm::mat4 transform = glm::make_mat4x4(&pNode->mTransformation.a1);
+	transform = glm::transpose(transform);
+
+	// Only add models which have meshes.
+	if (pNode->mNumMeshes > 0)
+	{
+		// Create an AABB that encompasses all of the messhes' individual AABBs.
+		AABB modelAABB;
+		modelAABB.min = glm::vec3(FLT_MAX);
+		modelAABB.max = glm::vec3(FLT_MIN);
+
+		pParent->Children.push_back(ModelResource());
+		ModelResource* pNewModel = &pParent->Children.back();
+		pNewModel->pParent = pParent;
+
+		pNewModel->Meshes.resize((size_t)pNode->mNumMeshes);
+		for (uint32 m = 0; m < pNode->mNumMeshes; m++)
+		{
+			uint32 meshIndex	= pNode->mMeshes[m];
+			aiMesh* pMesh		= pScene->mMeshes[meshIndex];
+			MeshObject& mesh	= pNewModel->Meshes[m];
+			FillMesh(mesh, pMesh);
+
+			// Expand the bounding box of this model to fit all meshes inside it.
+			modelAABB.min = Maths::GetMinElements(mesh.BoundingBox.min, modelAABB.min);
+			modelAABB.max = Maths::GetMaxElements(mesh.BoundingBox.max, modelAABB.max);
+		}
+
+		// Add transform.
+		pNewModel->Transform = transform;
+		transform = glm::mat4(1.f); // Reset the accumulated transform for its children.
+
+		// Add an AABB that encompasses all meshes this node has.
+		pNewModel->BoundingBox = modelAABB;
+
+		pNewModel->Name = std::string(pNode->mName.C_Str());
+
+		pTargetParent = pNewModel;
+	}
+	else
+	{
+		// Skip saving this node and go to the next nodes instead. However, save the transform.
+		pTargetParent = pParent;
+		transform = accTransform * transform;
+	}
+
+	// Add children if this node has any.
+	for (uint32 i = 0; i < pNode->mNumChildren; i++)
+	{
+		aiNode* pChild = pNode->mChildren[(size_t)i];
+		RecursiveLoadMeshes(pScene, pChild, pTargetParent, transform);
+	}
+
+	// Expand Bounding box of the model to fit all child models inside it.
+	for (ModelResource& child : pTargetParent->Children)
+	{
+		pTargetParent->BoundingBox.min = Maths::GetMinElements(child.BoundingBox.min, pTargetParent->BoundingBox.min);
+		pTargetParent->BoundingBox.max = Maths::GetMaxElements(child.BoundingBox.max, pTargetParent->BoundingBox.max);
+	}
+}
+
+void ModelImporter::FillMesh(MeshObject& outMesh, aiMesh* pMesh)
+{
+	// The material is resolved by the ModelLoader when the resources are created.
+	outMesh.MaterialHandler = pMesh->mMaterialIndex;
+
+	// Add vertices
+	outMesh.NumVertices = pMesh->mNumVertices;
+	outMesh.Vertices.resize((uint64)outMesh.NumVertices);
+	for (uint32 v = 0; v < outMesh.NumVertices; v++)
+	{
+		MeshObject::Vertex& vertex = outMesh.Vertices[v];
+
+		// Position
+		aiVector3D& pos = pMesh->mVertices[v];
+		vertex.Position = glm::vec3(pos.x, pos.y, pos.z);
+
+		// Normals
+		if (pMesh->HasNormals())
+		{
+			aiVector3D& norm = pMesh->mNormals[v];
+			vertex.Normal = glm::vec3(norm.x, norm.y, norm.z);
+		}
+
+		// Tangents and Bitangents
+		if (pMesh->HasTangentsAndBitangents())
+		{
+			aiVector3D& tan = pMesh->mTangents[v];
+			aiVector3D& bitan = pMesh->mBitangents[v];
+			vertex.Tangent = glm::vec3(tan.x, tan.y, tan.z);
+			vertex.Bitangent = glm::vec3(bitan.x, bitan.y, bitan.z);
+
+			// Check if they are correct!
+			vertex.Tangent = glm::normalize(vertex.Tangent - glm::dot(vertex.Tangent, vertex.Normal) * vertex.Normal);
+			vertex.Bitangent = glm::normalize(glm::cross(vertex.Normal, vertex.Tangent));
+
+			glm::vec3 bi = glm::normalize(glm::cross(vertex.Normal, vertex.Tangent));
+			glm::vec3 diff = glm::abs(bi) - glm::abs(glm::normalize(vertex.Bitangent));
+			if (glm::all(glm::greaterThan(diff, glm::vec3(FLT_EPSILON))))
+			{
+				LOG_WARNING("TANGENT & BITANGENT are wrong!");
+			}
+		}
+
+		// UVs
+		if (pMesh->HasTextureCoords(0))
+		{
+			aiVector3D& uvw = pMesh->mTextureCoords[0][v];
+			vertex.UV = glm::vec2(uvw.x, uvw.y);
+		}
+	}
+
+	// Add indices
+	// The face will always have three vertices because of triangulation and the primitive removal configuration.
+	outMesh.NumIndices = pMesh->mNumFaces * 3;
+	outMesh.Indices.resize((uint64)outMesh.NumIndices);
+	for (uint32 f = 0; f < pMesh->mNumFaces; f++)
+	{
+		uint32 index = f * 3;
+		aiFace& face = pMesh->mFaces[f];
+		outMesh.Indices[(uint64)index + 0] = face.mIndices[0];
+		outMesh.Indices[(uint64)index + 1] = face.mIndices[1];
+		outMesh.Indices[(uint64)index + 2] = face.mIndices[2];
+	}
+
+	// Add bounding box
+	outMesh.BoundingBox.min = glm::vec3(pMesh->mAABB.mMin.x, pMesh->mAABB.mMin.y, pMesh->mAABB.mMin.z);
+	outMesh.BoundingBox.max = glm::vec3(pMesh->mAABB.mMax.x, pMesh->mAABB.mMax.y, pMesh->mAABB.mMax.z);
+}
+
+void ModelImporter::LoadMaterial(const aiScene* pScene, uint32 materialIndex, ImportedMaterial& outMaterial, ImportedModel& outModel)
+{
+	aiMaterial* pMaterial = pScene->mMaterials[materialIndex];
+
+	aiString name;
+	pMaterial->Get(AI_MATKEY_NAME, name);
+	outMaterial.Name = std::string(name.C_Str());
+
+	// Load albedo
+	{
+		ImportedTextureRef& ref = outMaterial.Textures[ImportedMaterial::SLOT_ALBEDO];
+		if (!GetTextureRef(aiTextureType_DIFFUSE, 0, pScene, pMaterial, outModel, ref))
+			if (!GetTextureRef(aiTextureType_BASE_COLOR, 0, pScene, pMaterial, outModel, ref))
+				GetTextureRef(AI_MATKEY_GLTF_PBRMETALLICROUGHNESS_BASE_COLOR_TEXTURE, pScene, pMaterial, outModel, ref);
+	}
+
+	// Load normal map
+	{
+		ImportedTextureRef& ref = outMaterial.Textures[ImportedMaterial::SLOT_NORMAL];
+		if (!GetTextureRef(aiTextureType_NORMALS, 0, pScene, pMaterial, outModel, ref))
+			if (!GetTextureRef(aiTextureType_NORMAL_CAMERA, 0, pScene, pMaterial, outModel, ref))
+				GetTextureRef(aiTextureType_HEIGHT, 0, pScene, pMaterial, outModel, ref);
+	}
+
+	// Load AO
+	{
+		ImportedTextureRef& ref = outMaterial.Textures[ImportedMaterial::SLOT_AO];
+		if (!GetTextureRef(aiTextureType_AMBIENT_OCCLUSION, 0, pScene, pMaterial, outModel, ref))
+			GetTextureRef(aiTextureType_AMBIENT, 0, pScene, pMaterial, outModel, ref);
+	}
+
+	// Load Metallic
+	bool hasMetallic = false;
+	{
+		ImportedTextureRef& ref = outMaterial.Textures[ImportedMaterial::SLOT_METALLIC];
+		hasMetallic = GetTextureRef(aiTextureType_METALNESS, 0, pScene, pMaterial, outModel, ref);
+		if (!hasMetallic)
+			hasMetallic = GetTextureRef(aiTextureType_REFLECTION, 0, pScene, pMaterial, outModel, ref);
+	}
+
+	// Load Roughness
+	bool hasRoughness = false;
+	{
+		ImportedTextureRef& ref = outMaterial.Textures[ImportedMaterial::SLOT_ROUGHNESS];
+		hasRoughness = GetTextureRef(aiTextureType_DIFFUSE_ROUGHNESS, 0, pScene, pMaterial, outModel, ref);
+		if (!hasRoughness)
+			hasRoughness = GetTextureRef(aiTextureType_SHININESS, 0, pScene, pMaterial, outModel, ref);
+	}
+
+	// Load combined Metallic and Roughness
+	outMaterial.UseCombinedMetallicRoughness = !hasMetallic && !hasRoughness;
+	if (outMaterial.UseCombinedMetallicRoughness)
+		GetTextureRef(AI_MATKEY_GLTF_PBRMETALLICROUGHNESS_METALLICROUGHNESS_TEXTURE, pScene, pMaterial, outModel, outMaterial.Textures[ImportedMaterial::SLOT_METALLIC_ROUGHNESS]);
+}
+
+bool ModelImporter::GetTextureRef(aiTextureType type, uint32 index, const aiScene* pScene, aiMaterial* pMaterial, ImportedModel& outModel, ImportedTextureRef& outRef)
+{
+	outRef = ImportedTextureRef();
+	if (pMaterial->GetTextureCount(type) <= index)
+		return false;
+
+	aiString path;
+	pMaterial->GetTexture(type, index, &path); // Only take One Texture
+	const aiTexture* pEmbeddedTexture = pScene->GetEmbeddedTexture(path.C_Str());
+	if (pEmbeddedTexture)
+	{
+		// Only compressed embedded textures are supported (mHeight is zero and mWidth is the size in bytes).
+		if (pEmbeddedTexture->mHeight != 0 ||
+			(std::strcmp(pEmbeddedTexture->achFormatHint, "png") != 0 && std::strcmp(pEmbeddedTexture->achFormatHint, "jpg") != 0))
+		{
+			LOG_WARNING("Embedded format not supported!");
+			return false;
+		}
+
+		std::string name = std::string(path.C_Str());
+		auto it = std::find_if(outModel.EmbeddedTextures.begin(), outModel.EmbeddedTextures.end(), [&](const ImportedEmbeddedTexture& t) { return t.Name == name; });
+		if (it == outModel.EmbeddedTextures.end())
+		{
+			ImportedEmbeddedTexture texture;
+			texture.Name = name;
+			const uint8* pData = &pEmbeddedTexture->pcData[0].b;
+			texture.Data.assign(pData, pData + pEmbeddedTexture->mWidth);
+			outModel.EmbeddedTextures.push_back(std::move(texture));
+			it = outModel.EmbeddedTextures.end() - 1;
+		}
+		outRef.EmbeddedIndex = (int32)(it - outModel.EmbeddedTextures.begin());
+	}
+	else
+	{
+		outRef.Path = std::string(path.C_Str());
+		std::replace(outRef.Path.begin(), outRef.Path.end(), '\\', '/');
+	}
+	return true;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "Resources/Resources.h"
+#include "Core/ResourceManagerDefines.h"
+
+#include <assimp/material.h>
+
+struct aiMesh;
+struct aiNode;
+struct aiScene;
+namespace RS
+{
+	/*
+	* A texture used by a material. It is either a file relative to the folder of the model or an embedded texture.
+	*/
+	struct ImportedTextureRef
+	{
+		std::string	Path			= "";
+		int32		EmbeddedIndex	= -1;
+
+		bool IsValid() const { return !Path.empty() || EmbeddedIndex >= 0; }
+	};
+
+	struct ImportedMaterial
+	{
+		enum Slot : uint32
+		{
+			SLOT_ALBEDO = 0,
+			SLOT_NORMAL,
+			SLOT_AO,
+			SLOT_METALLIC,
+			SLOT_ROUGHNESS,
+			SLOT_METALLIC_ROUGHNESS,
+			SLOT_COUNT
+		};
+
+		std::string			Name							= "";
+		ImportedTextureRef	Textures[SLOT_COUNT];
+		bool				UseCombinedMetallicRoughness	= false;
+	};
+
+	/*
+	* The compressed file data (png or jpg) of a texture which is stored inside the model file.
+	*/
+	struct ImportedEmbeddedTexture
+	{
+		std::string			Name = ""; // The path Assimp uses for the texture, it is used as the key of the texture.
+		std::vector<uint8>	Data;
+	};
+
+	/*
+	* The CPU side of a model, before any resources have been created for it.
+	* The MaterialHandler of the meshes is the index into Materials and not a ResourceID.
+	*/
+	struct ImportedModel
+	{
+		ModelResource							Root;
+		std::vector<ImportedMaterial>			Materials;
+		std::vector<ImportedEmbeddedTexture>	EmbeddedTextures;
+	};
+
+	/*
+	* Imports a model with Assimp without touching the ResourceManager or the GPU. This is shared by the ModelLoader and the Cooker.
+	*/
+	class ModelImporter
+	{
+	public:
+		RS_DEFAULT_ABSTRACT_CLASS(ModelImporter);
+
+		/*
+		* Only the flags in IMPORT_FLAGS_MASK changes the result of the import.
+		* If pOpenedFiles is set, the normalized path of every file Assimp opened is added to it.
+		*/
+		static bool ImportWithAssimp(const std::string& filePath, ModelLoadDesc::LoaderFlags flags, ImportedModel& outModel, std::vector<std::string>* pOpenedFiles = nullptr);
+
+		static const ModelLoadDesc::LoaderFlags IMPORT_FLAGS_MASK = ModelLoadDesc::LOADER_FLAG_WINDING_ORDER_CW | ModelLoadDesc::LOADER_FLAG_USE_UV_TOP_LEFT;
+
+	private:
+		static void RecursiveLoadMeshes(const aiScene* pScene, aiNode* pNode, ModelResource* pParent, glm::mat4 accTransform);
+		static void FillMesh(MeshObject& outMesh, aiMesh* pMesh);
+		static void LoadMaterial(const aiScene* pScene, uint32 materialIndex, ImportedMaterial& outMaterial, ImportedModel& outModel);
+		static bool GetTextureRef(aiTextureType type, uint32 index, const aiScene* pScene, aiMaterial* pMaterial, ImportedModel& outModel, ImportedTextureRef& outRef);
+	};
+}
@@ -8,10 +8,8 @@
 #define TINYOBJLOADER_IMPLEMENTATION
 #include <tiny_obj_loader.h>
 
-#include <assimp/Importer.hpp>
-#include <assimp/scene.h>
-#include <assimp/postprocess.h>
-#include <assimp/pbrmaterial.h>
+#include "Loaders/CookedAssets.h"
+#include "Core/VirtualFileSystem.h"
 
 #pragma warning( push )
 #pragma warning( disable : 6011 )
@@ -25,6 +23,35 @@
 
 using namespace RS;
 
+namespace
+{
+    /*
+    * The name after the first mtllib statement, which is at the start of a line. Comments and other statements which contain "mtllib " are skipped.
+    * Returns an empty string if there is none.
+    */
+    std::string FindMaterialLibrary(const std::string& objText)
+    {
+        const char* pWhitespace = " \t\r";
+        for (size_t lineStart = 0; lineStart < objText.size();)
+        {
+            size_t lineEnd = objText.find('\n', lineStart);
+            if (lineEnd == std::string::npos)
+                lineEnd = objText.size();
+
+            size_t first = objText.find_first_not_of(pWhitespace, lineStart);
+            if (first < lineEnd && objText.compare(first, 6, "mtllib") == 0 && first + 6 < lineEnd && (objText[first + 6] == ' ' || objText[first + 6] == '\t'))
+            {
+                size_t nameStart = objText.find_first_not_of(pWhitespace, first + 6);
+                size_t nameEnd = objText.find_last_not_of(pWhitespace, lineEnd - 1);
+                if (nameStart < lineEnd && nameEnd != std::string::npos && nameEnd >= nameStart)
+                    return objText.substr(nameStart, nameEnd - nameStart + 1);
+            }
+            lineStart = lineEnd + 1;
+        }
+        return "";
+    }
+}
+
 bool ModelLoader::Load(const std::string& filePath, ModelResource*& outModel, ModelLoadDesc::LoaderFlags flags)
 {
     std::string path = std::string(RS_MODEL_PATH) + filePath;
@@ -33,7 +60,27 @@ bool ModelLoader::Load(const std::string& filePath, ModelResource*& outModel, Mo
 
     tinyobj::ObjReader reader;
 
-    if (!reader.ParseFromFile(path, reader_config))
+    // Read the obj and its material library through the virtual file system. Tinyobj needs them as strings.
+    FileView objView;
+    if (!VirtualFileSystem::Get()->Read(path, objView))
+    {
+        LOG_ERROR("TinyObjReader: Failed to read file {}!", path.c_str());
+        return false;
+    }
+    std::string objText = objView.ToString();
+
+    std::string mtlText;
+    std::string mtlName = FindMaterialLibrary(objText);
+    if (!mtlName.empty())
+    {
+        FileView mtlView;
+        if (VirtualFileSystem::Get()->Read(reader_config.mtl_search_path + mtlName, mtlView))
+            mtlText = mtlView.ToString();
+        else
+            LOG_WARNING("TinyObjReader: Failed to read material library {}!", mtlName.c_str());
+    }
+
+    if (!reader.ParseFromString(objText, mtlText, reader_config))
     {
         if (!reader.Error().empty())
             LOG_ERROR("TinyObjReader: %s", reader.Error());
@@ -172,194 +219,77 @@ bool ModelLoader::LoadWithAssimp(const std::string& filePath, ModelResource* out
 {
     std::string path = std::string(RS_MODEL_PATH) + filePath;
 
-    static const bool s_UseLH = false;
-    Assimp::Importer importer;
-
-    // Remove the line and point primitives. This ensure the mesh always contains only triangles together with the aiProcess_Triangulate flag.
-    importer.SetPropertyInteger(AI_CONFIG_PP_SBP_REMOVE, aiPrimitiveType_LINE | aiPrimitiveType_POINT);
-
-    int assimpFlags = aiProcess_CalcTangentSpace | aiProcess_Triangulate | aiProcess_JoinIdenticalVertices | aiProcess_SortByPType;
-    if (flags & ModelLoadDesc::LoaderFlag::LOADER_FLAG_WINDING_ORDER_CW)
-        assimpFlags |= aiProcess_FlipWindingOrder;
-    if (s_UseLH)
-        assimpFlags |= aiProcess_MakeLeftHanded;
-    if (flags & ModelLoadDesc::LoaderFlag::LOADER_FLAG_USE_UV_TOP_LEFT)
-        assimpFlags |= aiProcess_FlipUVs;
-    if (flags & ModelLoadDesc::LoaderFlag::LOADER_FLAG_GENERATE_BOUNDING_BOX)
-        assimpFlags |= aiProcess_GenBoundingBoxes;
-    const aiScene* pScene = importer.ReadFile(path.c_str(), assimpFlags);
-
-    if (!pScene)
+    // Use the cooked model if there is one, otherwise import the source with Assimp.
+    ImportedModel importedModel;
+    if (!CookedAssets::ReadModel(path, flags, importedModel))
     {
-        LOG_ERROR("Assimp Errror: %s", importer.GetErrorString());
-        return false;
+        if (!ModelImporter::ImportWithAssimp(path, flags, importedModel))
+            return false;
     }
 
-    return RecursiveLoadMeshes(pScene, pScene->mRootNode, outModel, glm::mat4(1.f), flags, path);
+    return CreateModel(importedModel, outModel, flags, path);
 }
 
-bool ModelLoader::RecursiveLoadMeshes(const aiScene*& pScene, aiNode* pNode, ModelResource* pParent, glm::mat4 accTransform, ModelLoadDesc::LoaderFlags flags, const std::string& modelPath)
+bool ModelLoader::CreateModel(ImportedModel& importedModel, ModelResource* outModel, ModelLoadDesc::LoaderFlags flags, const std::string& modelPath)
 {
-    bool succeeded = true;
-    ModelResource* pTargetParent = nullptr;
-
-    glm::mat4 transform = glm::make_mat4x4(&pNode->mTransformation.a1);
-    transform = glm::transpose(transform);
-
-    if (pParent->pParent == nullptr)
-    {
-        pParent->BoundingBox.min = glm::vec3(FLT_MAX);
-        pParent->BoundingBox.max = glm::vec3(FLT_MIN);
-    }
+    // Materials are only created for the meshes which uses them.
+    std::vector<ResourceID> materialIDs(importedModel.Materials.size(), NULL_RESOURCE);
+    RecursiveCreateMeshes(importedModel.Root, importedModel, materialIDs, flags, modelPath);
+
+    // The root is owned by the ResourceManager, only move the content of the imported root into it.
+    ModelResource& root = importedModel.Root;
+    outModel->Name          = root.Name;
+    outModel->Transform     = root.Transform;
+    outModel->BoundingBox   = root.BoundingBox;
+    outModel->Meshes        = std::move(root.Meshes);
+    outModel->Children      = std::move(root.Children);
+    SetParents(outModel);
+    return true;
+}
 
-    // Only add models which have meshes.
-    if (pNode->mNumMeshes > 0)
+void ModelLoader::RecursiveCreateMeshes(ModelResource& model, const ImportedModel& importedModel, std::vector<ResourceID>& materialIDs, ModelLoadDesc::LoaderFlags flags, const std::string& modelPath)
+{
+    for (MeshObject& mesh : model.Meshes)
     {
-        // Create an AABB that encompasses all of the messhes' individual AABBs.
-        AABB modelAABB;
-        modelAABB.min = glm::vec3(FLT_MAX);
-        modelAABB.max = glm::vec3(FLT_MIN);
-        
-        pParent->Children.push_back(ModelResource());
-        ModelResource* pNewModel = &pParent->Children.back();
-        pNewModel->pParent = pParent;
-
-        pNewModel->Meshes.resize((size_t)pNode->mNumMeshes);
-        for (uint32 m = 0; m < pNode->mNumMeshes; m++)
+        // The importer stores the index of the material in the handler.
+        uint32 materialIndex = mesh.MaterialHandler;
+        mesh.MaterialHandler = NULL_RESOURCE;
+        if (materialIndex < (uint32)materialIDs.size())
         {
-            uint32 meshIndex    = pNode->mMeshes[m];
-            aiMesh* pMesh       = pScene->mMeshes[meshIndex];
-            MeshObject& mesh  = pNewModel->Meshes[m];
-            FillMesh(pScene, mesh, pMesh, flags, modelPath);
-
-            // Expand the bounding box of this model to fit all meshes inside it.
-            modelAABB.min = Maths::GetMinElements(mesh.BoundingBox.min, modelAABB.min);
-            modelAABB.max = Maths::GetMaxElements(mesh.BoundingBox.max, modelAABB.max);
+            if (materialIDs[materialIndex] == NULL_RESOURCE)
+                materialIDs[materialIndex] = LoadMaterial(importedModel, materialIndex, modelPath);
+            mesh.MaterialHandler = materialIDs[materialIndex];
         }
-
-        // Add transform.
-        pNewModel->Transform = transform;
-        transform = glm::mat4(1.f); // Reset the accumulated transform for its children.
-
-        // Add an AABB that encompasses all meshes this node has.
-        pNewModel->BoundingBox = modelAABB;
-
-        pNewModel->Name = std::string(pNode->mName.C_Str());
-
-        pTargetParent = pNewModel;
-    }
-    else
-    {
-        // Skip saving this node and go to the next nodes instead. However, save the transform.
-        pTargetParent = pParent;
-        transform = accTransform * transform;
-    }
-
-    // Add children if this node has any.
-    if (pNode->mNumChildren > 0)
-    {
-        for (uint32 i = 0; i < pNode->mNumChildren; i++)
+        else
         {
-            aiNode* pChild = pNode->mChildren[(size_t)i];
-            succeeded &= RecursiveLoadMeshes(pScene, pChild, pTargetParent, transform, flags, modelPath);
+            LOG_WARNING("Mesh in model {} uses a material which does not exist!", modelPath.c_str());
         }
-    }
 
-    // Expand Bounding box of the model to fit all child models inside it.
-    for (ModelResource& child : pTargetParent->Children)
-    {
-        // Expand the bounding box
-        pTargetParent->BoundingBox.min = Maths::GetMinElements(child.BoundingBox.min, pTargetParent->BoundingBox.min);
-        pTargetParent->BoundingBox.max = Maths::GetMaxElements(child.BoundingBox.max, pTargetParent->BoundingBox.max);
-    }
-
-    if (pParent->pParent == nullptr)
-    {
-        pParent->Name = std::string(pNode->mName.C_Str());
+        UploadMesh(mesh, flags);
     }
 
-    return succeeded;
+    for (ModelResource& child : model.Children)
+        RecursiveCreateMeshes(child, importedModel, materialIDs, flags, modelPath);
 }
 
-void ModelLoader::FillMesh(const aiScene*& pScene, MeshObject& outMesh, aiMesh*& pMesh, ModelLoadDesc::LoaderFlags flags, const std::string& modelPath)
+void ModelLoader::SetParents(ModelResource* pModel)
 {
-    // Add Materials
-    // TODO: Add default material if the mesh is missing one!
-    LoadMaterial(pScene, outMesh, pMesh, flags, modelPath);
-
-    // Add vertices
-    outMesh.NumVertices = pMesh->mNumVertices;
-    outMesh.Vertices.resize((uint64)outMesh.NumVertices);
-    for (uint32 v = 0; v < outMesh.NumVertices; v++)
+    for (ModelResource& child : pModel->Children)
     {
-        MeshObject::Vertex& vertex = outMesh.Vertices[v];
-
-        // Position
-        aiVector3D& pos = pMesh->mVertices[v];
-        vertex.Position = glm::vec3(pos.x, pos.y, pos.z);
-
-        // Normals
-        if (pMesh->HasNormals())
-        {
-            aiVector3D& norm = pMesh->mNormals[v];
-            vertex.Normal = glm::vec3(norm.x, norm.y, norm.z);
-        }
-
-        // Tangents and Bitangents
-        if (pMesh->HasTangentsAndBitangents())
-        {
-            aiVector3D& tan = pMesh->mTangents[v];
-            aiVector3D& bitan = pMesh->mBitangents[v];
-            vertex.Tangent = glm::vec3(tan.x, tan.y, tan.z);
-            vertex.Bitangent = glm::vec3(bitan.x, bitan.y, bitan.z);
-
-            // Check if they are correct!
-            vertex.Tangent = glm::normalize(vertex.Tangent - glm::dot(vertex.Tangent, vertex.Normal) * vertex.Normal);
-            vertex.Bitangent = glm::normalize(glm::cross(vertex.Normal, vertex.Tangent));
-
-            glm::vec3 bi = glm::normalize(glm::cross(vertex.Normal, vertex.Tangent));
-            //vertex.Bitangent = bi;
-            glm::vec3 tan2 = glm::normalize(glm::cross(vertex.Bitangent, vertex.Normal));
-            //vertex.Tangent = tan2;
-            glm::vec3 diff = glm::abs(bi) - glm::abs(glm::normalize(vertex.Bitangent));
-            if (glm::all(glm::greaterThan(diff, glm::vec3(FLT_EPSILON))))
-            {
-                LOG_WARNING("TANGENT & BITANGENT are wrong!");
-            }
-        }
-
-        // UVs
-        if (pMesh->HasTextureCoords(0))
-        {
-            aiVector3D& uvw = pMesh->mTextureCoords[0][v];
-            vertex.UV = glm::vec2(uvw.x, uvw.y);
-        }
-    }
-
-    // Add indices
-    // The face will always have three vertices because of triangulation and the primitive removal configuration.
-    outMesh.NumIndices = pMesh->mNumFaces * 3;
-    outMesh.Indices.resize((uint64)outMesh.NumIndices);
-    for (uint32 f = 0; f < pMesh->mNumFaces; f++)
-    {
-        uint32 index = f * 3;
-        aiFace& face = pMesh->mFaces[f];
-        outMesh.Indices[(uint64)index + 0] = face.mIndices[0];
-        outMesh.Indices[(uint64)index + 1] = face.mIndices[1];
-        outMesh.Indices[(uint64)index + 2] = face.mIndices[2];
+        child.pParent = pModel;
+        SetParents(&child);
     }
+}
 
-    // Add bounding box
-    outMesh.BoundingBox.min = glm::vec3(pMesh->mAABB.mMin.x, pMesh->mAABB.mMin.y, pMesh->mAABB.mMin.z);
-    outMesh.BoundingBox.max = glm::vec3(pMesh->mAABB.mMax.x, pMesh->mAABB.mMax.y, pMesh->mAABB.mMax.z);
-
+void ModelLoader::UploadMesh(MeshObject& mesh, ModelLoadDesc::LoaderFlags flags)
+{
     // Upload data to the GUP
     if (flags & ModelLoadDesc::LoaderFlag::LOADER_FLAG_UPLOAD_MESH_DATA_TO_GUP)
     {
         // Create the vertex buffer.
         {
             D3D11_BUFFER_DESC bufferDesc = {};
-            bufferDesc.ByteWidth = (UINT)(sizeof(MeshObject::Vertex) * outMesh.Vertices.size());
+            bufferDesc.ByteWidth = (UINT)(sizeof(MeshObject::Vertex) * mesh.Vertices.size());
             bufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
             bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
             bufferDesc.CPUAccessFlags = 0;
@@ -367,18 +297,18 @@ void ModelLoader::FillMesh(const aiScene*& pScene, MeshObject& outMesh, aiMesh*&
             bufferDesc.StructureByteStride = 0;
 
             D3D11_SUBRESOURCE_DATA data;
-            data.pSysMem = outMesh.Vertices.data();
+            data.pSysMem = mesh.Vertices.data();
             data.SysMemPitch = 0;
             data.SysMemSlicePitch = 0;
 
-            HRESULT result = RenderAPI::Get()->GetDevice()->CreateBuffer(&bufferDesc, &data, &outMesh.pVertexBuffer);
+            HRESULT result = RenderAPI::Get()->GetDevice()->CreateBuffer(&bufferDesc, &data, &mesh.pVertexBuffer);
             RS_D311_ASSERT_CHECK(result, "Failed to create vertex buffer!");
         }
 
         // Create the index buffer.
         {
             D3D11_BUFFER_DESC bufferDesc = {};
-            bufferDesc.ByteWidth            = (UINT)(sizeof(uint32) * outMesh.Indices.size());
+            bufferDesc.ByteWidth            = (UINT)(sizeof(uint32) * mesh.Indices.size());
             bufferDesc.Usage                = D3D11_USAGE_IMMUTABLE;
             bufferDesc.BindFlags            = D3D11_BIND_INDEX_BUFFER;
             bufferDesc.CPUAccessFlags       = 0;
@@ -386,11 +316,11 @@ void ModelLoader::FillMesh(const aiScene*& pScene, MeshObject& outMesh, aiMesh*&
             bufferDesc.StructureByteStride  = 0;
 
             D3D11_SUBRESOURCE_DATA data;
-            data.pSysMem            = outMesh.Indices.data();
+            data.pSysMem            = mesh.Indices.data();
             data.SysMemPitch        = 0;
             data.SysMemSlicePitch   = 0;
 
-            HRESULT result = RenderAPI::Get()->GetDevice()->CreateBuffer(&bufferDesc, &data, &outMesh.pIndexBuffer);
+            HRESULT result = RenderAPI::Get()->GetDevice()->CreateBuffer(&bufferDesc, &data, &mesh.pIndexBuffer);
             RS_D311_ASSERT_CHECK(result, "Failed to create index buffer!");
         }
 
@@ -410,7 +340,7 @@ void ModelLoader::FillMesh(const aiScene*& pScene, MeshObject& outMesh, aiMesh*&
             data.SysMemPitch        = 0;
             data.SysMemSlicePitch   = 0;
 
-            HRESULT result = RenderAPI::Get()->GetDevice()->CreateBuffer(&bufferDesc, &data, &outMesh.pMeshBuffer);
+            HRESULT result = RenderAPI::Get()->GetDevice()->CreateBuffer(&bufferDesc, &data, &mesh.pMeshBuffer);
             RS_D311_ASSERT_CHECK(result, "Failed to create constant buffer!");
         }
     }
@@ -418,177 +348,109 @@ void ModelLoader::FillMesh(const aiScene*& pScene, MeshObject& outMesh, aiMesh*&
     // Clear the vertices and indices buffers if the flag was set.
     if (flags & ModelLoadDesc::LoaderFlag::LOADER_FLAG_NO_MESH_DATA_IN_RAM)
     {
-        outMesh.Vertices.clear();
-        outMesh.Indices.clear();
+        mesh.Vertices.clear();
+        mesh.Indices.clear();
     }
 }
 
-void ModelLoader::LoadMaterial(const aiScene*& pScene, MeshObject& outMesh, aiMesh*& pMesh, ModelLoadDesc::LoaderFlags flags, const std::string& modelPath)
+ResourceID ModelLoader::LoadMaterial(const ImportedModel& importedModel, uint32 materialIndex, const std::string& modelPath)
 {
-    RS_UNREFERENCED_VARIABLE(flags);
-
     auto pResourceManager = ResourceManager::Get();
-    uint32 materialIndex = pMesh->mMaterialIndex;
-    if(materialIndex >= 0)
-    {
-        std::string key = modelPath + "_Material_" + std::to_string(materialIndex);
-        ResourceID materialID = pResourceManager->GetIDFromString(key);
-        if (materialID == 0)
-        {
-            // Add a new material if it does not exist!
-            auto [pMaterialResource, newMaterialID] = pResourceManager->AddResource<MaterialResource>(Resource::Type::MATERIAL);
-            pResourceManager->AddStringToIDAssociation(key, newMaterialID);
-            materialID = newMaterialID;
-
-            aiMaterial* pMaterial = pScene->mMaterials[materialIndex];
-
-            aiString name;
-            pMaterial->Get(AI_MATKEY_NAME, name);
-            pMaterialResource->Name = std::string(name.C_Str());
-
-            pMaterialResource->InfoBuffer = {};
-
-            std::string folderPath = modelPath.substr(0, modelPath.find_last_of("\\/")) + "/";
-
-            bool succeeded = false;
-            // Load albedo
-            {
-                pMaterialResource->AlbedoTextureHandler = LoadTextureResource(aiTextureType_DIFFUSE, 0, pScene, pMaterial, pResourceManager->DefaultTextureOnePixelWhite, folderPath, succeeded);
-                if (!succeeded)
-                    pMaterialResource->AlbedoTextureHandler = LoadTextureResource(aiTextureType_BASE_COLOR, 0, pScene, pMaterial, pResourceManager->DefaultTextureOnePixelWhite, folderPath, succeeded);
-                if (!succeeded)
-                    pMaterialResource->AlbedoTextureHandler = LoadTextureResource(AI_MATKEY_GLTF_PBRMETALLICROUGHNESS_BASE_COLOR_TEXTURE, pScene, pMaterial, pResourceManager->DefaultTextureOnePixelWhite, folderPath, succeeded);
-            }
-
-            // Load normal map
-            {
-                pMaterialResource->NormalTextureHandler = LoadTextureResource(aiTextureType_NORMALS, 0, pScene, pMaterial, pResourceManager->DefaultTextureOnePixelNormal, folderPath, succeeded);
-                if (!succeeded)
-                    pMaterialResource->NormalTextureHandler = LoadTextureResource(aiTextureType_NORMAL_CAMERA, 0, pScene, pMaterial, pResourceManager->DefaultTextureOnePixelNormal, folderPath, succeeded);
-                if (!succeeded)
-                    pMaterialResource->NormalTextureHandler = LoadTextureResource(aiTextureType_HEIGHT, 0, pScene, pMaterial, pResourceManager->DefaultTextureOnePixelNormal, folderPath, succeeded);
-            }
-
-            // Load AO
-            {
-                pMaterialResource->AOTextureHandler = LoadTextureResource(aiTextureType_AMBIENT_OCCLUSION, 0, pScene, pMaterial, pResourceManager->DefaultTextureOnePixelWhite, folderPath, succeeded);
-                if (!succeeded)
-                    pMaterialResource->AOTextureHandler = LoadTextureResource(aiTextureType_AMBIENT, 0, pScene, pMaterial, pResourceManager->DefaultTextureOnePixelWhite, folderPath, succeeded);
-            }
+    std::string key = modelPath + "_Material_" + std::to_string(materialIndex);
+    ResourceID materialID = pResourceManager->GetIDFromString(key);
+    if (materialID != 0)
+        return materialID;
 
-            bool hasMetallic = false;
-            // Load Metallic
-            {
-                pMaterialResource->MetallicTextureHandler = LoadTextureResource(aiTextureType_METALNESS, 0, pScene, pMaterial, pResourceManager->DefaultTextureOnePixelBlack, folderPath, hasMetallic);
-                if (!hasMetallic)
-                    pMaterialResource->MetallicTextureHandler = LoadTextureResource(aiTextureType_REFLECTION, 0, pScene, pMaterial, pResourceManager->DefaultTextureOnePixelBlack, folderPath, hasMetallic);
-            }
+    // Add a new material if it does not exist!
+    auto [pMaterialResource, newMaterialID] = pResourceManager->AddResource<MaterialResource>(Resource::Type::MATERIAL);
+    pResourceManager->AddStringToIDAssociation(key, newMaterialID);
+    materialID = newMaterialID;
 
-            bool hasRoughness = false;
-            // Load Roughness
-            {
-                pMaterialResource->RoughnessTextureHandler = LoadTextureResource(aiTextureType_DIFFUSE_ROUGHNESS, 0, pScene, pMaterial, pResourceManager->DefaultTextureOnePixelWhite, folderPath, hasRoughness);
-                if (!hasRoughness)
-                    pMaterialResource->RoughnessTextureHandler = LoadTextureResource(aiTextureType_SHININESS, 0, pScene, pMaterial, pResourceManager->DefaultTextureOnePixelWhite, folderPath, hasRoughness);
-            }
+    const ImportedMaterial& material = importedModel.Materials[materialIndex];
+    pMaterialResource->Name = material.Name;
+    pMaterialResource->InfoBuffer = {};
 
-            // Load combined Metallic and Roughness
-            if(!hasMetallic && !hasRoughness)
-            {
-                pMaterialResource->MetallicRoughnessTextureHandler = LoadTextureResource(AI_MATKEY_GLTF_PBRMETALLICROUGHNESS_METALLICROUGHNESS_TEXTURE, pScene, pMaterial, pResourceManager->DefaultTextureOnePixelBlack, folderPath, succeeded);
-                pMaterialResource->InfoBuffer.Info.x = 1.f;
-            }
-            else
-            {
-                pMaterialResource->MetallicRoughnessTextureHandler = pResourceManager->DefaultTextureOnePixelBlack;
-                pMaterialResource->InfoBuffer.Info.x = 0.f;
-            }
+    std::string folderPath = modelPath.substr(0, modelPath.find_last_of("\\/")) + "/";
 
-            // Create the constant buffer
-            {
-                D3D11_BUFFER_DESC bufferDesc = {};
-                bufferDesc.ByteWidth = sizeof(MaterialBuffer);
-                bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
-                bufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-                bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-                bufferDesc.MiscFlags = 0;
-                bufferDesc.StructureByteStride = 0;
-
-                D3D11_SUBRESOURCE_DATA data;
-                data.pSysMem = &pMaterialResource->InfoBuffer;
-                data.SysMemPitch = 0;
-                data.SysMemSlicePitch = 0;
-
-                HRESULT result = RenderAPI::Get()->GetDevice()->CreateBuffer(&bufferDesc, &data, &pMaterialResource->pConstantBuffer);
-                RS_D311_ASSERT_CHECK(result, "Failed to create constant buffer for material \"{}\"!", pMaterialResource->Name.c_str());
-            }
-        }
+    auto LoadSlot = [&](ImportedMaterial::Slot slot, ResourceID defaultTextureID)->ResourceID
+    {
+        return LoadTextureResource(material.Textures[slot], importedModel, defaultTextureID, folderPath);
+    };
+    pMaterialResource->AlbedoTextureHandler     = LoadSlot(ImportedMaterial::SLOT_ALBEDO, pResourceManager->DefaultTextureOnePixelWhite);
+    pMaterialResource->NormalTextureHandler     = LoadSlot(ImportedMaterial::SLOT_NORMAL, pResourceManager->DefaultTextureOnePixelNormal);
+    pMaterialResource->AOTextureHandler         = LoadSlot(ImportedMaterial::SLOT_AO, pResourceManager->DefaultTextureOnePixelWhite);
+    pMaterialResource->MetallicTextureHandler   = LoadSlot(ImportedMaterial::SLOT_METALLIC, pResourceManager->DefaultTextureOnePixelBlack);
+    pMaterialResource->RoughnessTextureHandler  = LoadSlot(ImportedMaterial::SLOT_ROUGHNESS, pResourceManager->DefaultTextureOnePixelWhite);
+
+    // Load combined Metallic and Roughness
+    if (material.UseCombinedMetallicRoughness)
+    {
+        pMaterialResource->MetallicRoughnessTextureHandler = LoadSlot(ImportedMaterial::SLOT_METALLIC_ROUGHNESS, pResourceManager->DefaultTextureOnePixelBlack);
+        pMaterialResource->InfoBuffer.Info.x = 1.f;
+    }
+    else
+    {
+        pMaterialResource->MetallicRoughnessTextureHandler = pResourceManager->DefaultTextureOnePixelBlack;
+        pMaterialResource->InfoBuffer.Info.x = 0.f;
+    }
 
-        outMesh.MaterialHandler = materialID;
+    // Create the constant buffer
+    {
+        D3D11_BUFFER_DESC bufferDesc = {};
+        bufferDesc.ByteWidth = sizeof(MaterialBuffer);
+        bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+        bufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+        bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+        bufferDesc.MiscFlags = 0;
+        bufferDesc.StructureByteStride = 0;
+
+        D3D11_SUBRESOURCE_DATA data;
+        data.pSysMem = &pMaterialResource->InfoBuffer;
+        data.SysMemPitch = 0;
+        data.SysMemSlicePitch = 0;
+
+        HRESULT result = RenderAPI::Get()->GetDevice()->CreateBuffer(&bufferDesc, &data, &pMaterialResource->pConstantBuffer);
+        RS_D311_ASSERT_CHECK(result, "Failed to create constant buffer for material \"{}\"!", pMaterialResource->Name.c_str());
     }
+
+    return materialID;
 }
 
-ResourceID ModelLoader::LoadTextureResource(aiTextureType type, uint32 index, const aiScene*& pScene, aiMaterial* pMaterial, ResourceID defaultTextureID, const std::string& folderPath, bool& succeeded)
+ResourceID ModelLoader::LoadTextureResource(const ImportedTextureRef& textureRef, const ImportedModel& importedModel, ResourceID defaultTextureID, const std::string& folderPath)
 {
     auto pResourceManager = ResourceManager::Get();
-    ResourceID textureID = 0;
 
-    if (pMaterial->GetTextureCount(type) > index)
+    if (textureRef.EmbeddedIndex >= 0 && textureRef.EmbeddedIndex < (int32)importedModel.EmbeddedTextures.size())
     {
-        aiString path;
-        pMaterial->GetTexture(type, index, &path); // Only take One Texture
-        const aiTexture* pEmbeddedTexture = pScene->GetEmbeddedTexture(path.C_Str());
-        if (pEmbeddedTexture)
-        {
-            // The texture is an embedded texture, load it from memory!
-            if (std::strcmp(pEmbeddedTexture->achFormatHint, "png") == 0 ||
-                std::strcmp(pEmbeddedTexture->achFormatHint, "jpg") == 0)
-            {
-                TextureLoadDesc loadDesc = {};
-                loadDesc.ImageDesc.Memory.pData         = &pEmbeddedTexture->pcData[0].b;
-                loadDesc.ImageDesc.Memory.Size          = pEmbeddedTexture->mWidth;
-                loadDesc.ImageDesc.Memory.IsCompressed  = true;
-                loadDesc.ImageDesc.IsFromFile           = false;
-                loadDesc.ImageDesc.NumChannels          = ImageLoadDesc::Channels::RGBA;
-                loadDesc.ImageDesc.Name                 = std::string(path.C_Str()); // Use the path as a key!
-                loadDesc.GenerateMipmaps                = true;
-                auto [pTexture, ID] = pResourceManager->LoadTextureResource(loadDesc);
-                textureID = ID;
-                succeeded = true;
-            }
-            else
-            {
-                LOG_WARNING("Embedded format not supported!");
-                pResourceManager->LoadTextureResource(defaultTextureID);
-                textureID = defaultTextureID;
-                succeeded = false;
-            }
-        }
-        else
-        {
-            std::string newPath = std::string(path.C_Str());
-            std::replace(newPath.begin(), newPath.end(), '\\', '/');
-
-            // Load Texture with ResourceManger!
-            TextureLoadDesc loadDesc = {};
-            loadDesc.ImageDesc.IsFromFile               = true;
-            loadDesc.ImageDesc.File.Path                = folderPath + newPath;
-            loadDesc.ImageDesc.File.UseDefaultFolder    = false; // Use the same folder as the model.
-            loadDesc.ImageDesc.Name                     = loadDesc.ImageDesc.File.Path;
-            loadDesc.ImageDesc.NumChannels              = ImageLoadDesc::Channels::RGBA;
-            loadDesc.GenerateMipmaps                    = true;
-            auto [pTexture, ID] = ResourceManager::Get()->LoadTextureResource(loadDesc);
-            RS_UNREFERENCED_VARIABLE(pTexture);
-            textureID = ID;
-            succeeded = true;
-        }
+        // The texture is an embedded texture, load it from memory!
+        const ImportedEmbeddedTexture& embeddedTexture = importedModel.EmbeddedTextures[textureRef.EmbeddedIndex];
+        TextureLoadDesc loadDesc = {};
+        loadDesc.ImageDesc.Memory.pData         = embeddedTexture.Data.data();
+        loadDesc.ImageDesc.Memory.Size          = (uint32)embeddedTexture.Data.size();
+        loadDesc.ImageDesc.Memory.IsCompressed  = true;
+        loadDesc.ImageDesc.IsFromFile           = false;
+        loadDesc.ImageDesc.NumChannels          = ImageLoadDesc::Channels::RGBA;
+        loadDesc.ImageDesc.Name                 = embeddedTexture.Name; // Use the path as a key!
+        loadDesc.GenerateMipmaps                = true;
+        auto [pTexture, ID] = pResourceManager->LoadTextureResource(loadDesc);
+        RS_UNREFERENCED_VARIABLE(pTexture);
+        return ID;
     }
-    else
+    else if (!textureRef.Path.empty())
     {
-        pResourceManager->LoadTextureResource(defaultTextureID);
-        textureID = defaultTextureID;
-        succeeded = false;
+        // Load Texture with ResourceManger!
+        TextureLoadDesc loadDesc = {};
+        loadDesc.ImageDesc.IsFromFile               = true;
+        loadDesc.ImageDesc.File.Path                = folderPath + textureRef.Path;
+        loadDesc.ImageDesc.File.UseDefaultFolder    = false; // Use the same folder as the model.
+        loadDesc.ImageDesc.Name                     = loadDesc.ImageDesc.File.Path;
+        loadDesc.ImageDesc.NumChannels              = ImageLoadDesc::Channels::RGBA;
+        loadDesc.GenerateMipmaps                    = true;
+        auto [pTexture, ID] = pResourceManager->LoadTextureResource(loadDesc);
+        RS_UNREFERENCED_VARIABLE(pTexture);
+        return ID;
     }
 
-    return textureID;
+    pResourceManager->LoadTextureResource(defaultTextureID);
+    return defaultTextureID;
 }
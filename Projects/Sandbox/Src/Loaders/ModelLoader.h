@@ -5,11 +5,8 @@
 #include "Core/ResourceManager.h"
 #include "Core/ResourceManagerDefines.h"
 
-#include <assimp/material.h>
+#include "Loaders/ModelImporter.h"
 
-struct aiMesh;
-struct aiNode;
-struct aiScene;
 namespace RS
 {
 	class ModelLoader
@@ -19,12 +16,20 @@ namespace RS
 
 		static bool Load(const std::string& filePath, ModelResource*& outModel, ModelLoadDesc::LoaderFlags flags);
 
+		/*
+		* Loads the cooked model if it exists (See CookedAssets), otherwise it is imported with Assimp.
+		*/
 		static bool LoadWithAssimp(const std::string& filePath, ModelResource* outModel, ModelLoadDesc::LoaderFlags flags);
 
 	private:
-		static bool RecursiveLoadMeshes(const aiScene*& pScene, aiNode* pNode, ModelResource* pParent, glm::mat4 accTransform, ModelLoadDesc::LoaderFlags flags, const std::string& modelPath);
-		static void FillMesh(const aiScene*& pScene, MeshObject& outMesh, aiMesh*& pMesh, ModelLoadDesc::LoaderFlags flags, const std::string& modelPath);
-		static void LoadMaterial(const aiScene*& pScene, MeshObject& outMesh, aiMesh*& pMesh, ModelLoadDesc::LoaderFlags flags, const std::string& modelPath);
-		static ResourceID LoadTextureResource(aiTextureType type, uint32 index, const aiScene*& pScene, aiMaterial* pMaterial, ResourceID defaultTextureID, const std::string& folderPath, bool& succeeded);
+		/*
+		* Creates the materials, textures and GPU buffers of the imported model and moves the hierarchy into outModel.
+		*/
+		static bool CreateModel(ImportedModel& importedModel, ModelResource* outModel, ModelLoadDesc::LoaderFlags flags, const std::string& modelPath);
+		static void RecursiveCreateMeshes(ModelResource& model, const ImportedModel& importedModel, std::vector<ResourceID>& materialIDs, ModelLoadDesc::LoaderFlags flags, const std::string& modelPath);
+		static void SetParents(ModelResource* pModel);
+		static void UploadMesh(MeshObject& mesh, ModelLoadDesc::LoaderFlags flags);
+		static ResourceID LoadMaterial(const ImportedModel& importedModel, uint32 materialIndex, const std::string& modelPath);
+		static ResourceID LoadTextureResource(const ImportedTextureRef& textureRef, const ImportedModel& importedModel, ResourceID defaultTextureID, const std::string& folderPath);
 	};
-}
\ No newline at end of file
+}
@@ -12,6 +12,8 @@
 #pragma warning( pop )
 
 #include "Renderer/RenderUtils.h"
+#include "Core/VirtualFileSystem.h"
+#include "Loaders/CookedAssets.h"
 
 using namespace RS;
 
@@ -43,20 +45,38 @@ void ResourceLoader::LoadImageFromFile(ImageResource*& outImage, ImageLoadDesc&
 	std::string path = imageDescription.File.Path;
 	if (imageDescription.File.UseDefaultFolder)
 		path = std::string(RS_TEXTURE_PATH) + imageDescription.File.Path;
+
+	// Use the cooked image if there is one, it is already decoded.
+	CookedAssets::CookedImage cookedImage;
+	if (nChannels >= 0 && nChannels <= 4 && CookedAssets::ReadImage(path, nChannels, cookedImage))
+	{
+		outImage->Data		= std::move(cookedImage.Data);
+		outImage->Width		= cookedImage.Width;
+		outImage->Height	= cookedImage.Height;
+		outImage->Format	= cookedImage.IsHDR ? DXGI_FORMAT_R32G32B32A32_FLOAT : GetFormatFromChannelCount((int)cookedImage.NumChannels);
+		return;
+	}
+
 	int width = 0, height = 0, channelCount = 0;
+	FileView fileView;
 	if (nChannels < 0 || nChannels > 4)
 	{
 		outImage->Data.clear();
 		LOG_WARNING("Unable to load image [{0}]: Requested number of channels is not supported! Requested {1}.", path.c_str(), nChannels);
 	}
+	else if (!VirtualFileSystem::Get()->Read(path, fileView))
+	{
+		outImage->Data.clear();
+		LOG_WARNING("Unable to load image [{0}]: File not found!", path.c_str());
+	}
 	else
 	{
 		if (isHDR)
 		{
 			// Loading HDR images will ignore channelCount and instead always use a R16G16B16A16_FLOAT format.
-			float* pPixels = stbi_loadf(path.c_str(), &width, &height, &channelCount, 4);
+			float* pPixels = stbi_loadf_from_memory(fileView.pData, (int)fileView.Size, &width, &height, &channelCount, 4);
 			if (!pPixels)
-				LOG_WARNING("Unable to load HDR image [{0}]: File not found!", path.c_str());
+				LOG_WARNING("Unable to load HDR image [{0}]: {1}", path.c_str(), stbi_failure_reason());
 			else
 			{
 				outImage->Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
@@ -69,18 +89,23 @@ void ResourceLoader::LoadImageFromFile(ImageResource*& outImage, ImageLoadDesc&
 		}
 		else
 		{
-			uint8* pPixels = (uint8*)stbi_load(path.c_str(), &width, &height, &channelCount, nChannels);
+			// Decoded with the channels of the file and converted the same way as a cooked image.
+			uint8* pPixels = (uint8*)stbi_load_from_memory(fileView.pData, (int)fileView.Size, &width, &height, &channelCount, 0);
 			if (!pPixels)
-				LOG_WARNING("Unable to load image [{0}]: File not found!", path.c_str());
+				LOG_WARNING("Unable to load image [{0}]: {1}", path.c_str(), stbi_failure_reason());
 			else
 			{
-				size_t size = (size_t)width * (size_t)height * (size_t)(nChannels == 0 ? channelCount : nChannels);
-				outImage->Data.resize(size, 0);
-				memcpy(outImage->Data.data(), pPixels, size);
+				CookedAssets::CookedImage image;
+				image.Width			= (uint32)width;
+				image.Height		= (uint32)height;
+				image.NumChannels	= (uint32)channelCount;
+				image.Data.assign(pPixels, pPixels + (size_t)width * (size_t)height * (size_t)channelCount);
 				stbi_image_free(pPixels);
 				pPixels = nullptr;
 
-				outImage->Format = GetFormatFromChannelCount(nChannels == 0 ? channelCount : nChannels);
+				CookedAssets::ConvertToTextureChannels(image, nChannels);
+				outImage->Data		= std::move(image.Data);
+				outImage->Format	= GetFormatFromChannelCount((int)image.NumChannels);
 			}
 		}
 	}
@@ -110,16 +135,22 @@ void ResourceLoader::LoadImageFromMemory(ImageResource*& outImage, ImageLoadDesc
 	{
 		if (imageDescription.Memory.IsCompressed)
 		{
-			pPixels = (uint8*)stbi_load_from_memory(imageDescription.Memory.pData, imageDescription.Memory.Size, &width, &height, &channelCount, nChannels);
+			pPixels = (uint8*)stbi_load_from_memory(imageDescription.Memory.pData, imageDescription.Memory.Size, &width, &height, &channelCount, 0);
 			if (!pPixels)
 				LOG_WARNING("Unable to load image from memory: Something went wrong!");
 			else
 			{
-				size_t size = (size_t)(width * height * (nChannels == 0 ? channelCount : nChannels));
-				outImage->Data.resize(size, 0);
-				memcpy(outImage->Data.data(), pPixels, size);
+				CookedAssets::CookedImage image;
+				image.Width			= (uint32)width;
+				image.Height		= (uint32)height;
+				image.NumChannels	= (uint32)channelCount;
+				image.Data.assign(pPixels, pPixels + (size_t)width * (size_t)height * (size_t)channelCount);
 				stbi_image_free(pPixels);
 				pPixels = nullptr;
+
+				CookedAssets::ConvertToTextureChannels(image, nChannels);
+				outImage->Data	= std::move(image.Data);
+				nChannels		= (int)image.NumChannels;
 			}
 		}
 		else
@@ -6,6 +6,7 @@
 #include "Scenes/TessellationScene.h"
 #include "Scenes/PBRScene.h"
 #include "Scenes/HatchingScene.h"
+#include "Scenes/TerrainScene.h"
 
 int main(int argc, char* argv[])
 {
@@ -23,6 +24,7 @@ int main(int argc, char* argv[])
     application.AddScene(new RS::TessellationScene());
     application.AddScene(new RS::PBRScene());
     application.AddScene(new RS::HatchingScene());
+    application.AddScene(new RS::TerrainScene());
     application.SelectScene(4);
     application.Run();
     application.Release();
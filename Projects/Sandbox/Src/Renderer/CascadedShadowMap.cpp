@@ -0,0 +1,272 @@
+#include "PreCompiled.h"
+#include "CascadedShadowMap.h"
+
+#include "Renderer/StateCache.h"
+#include "Renderer/ShaderHotReloader.h"
+#include "Utils/Config.h"
+
+using namespace RS;
+
+void CascadedShadowMap::Init()
+{
+	Config* config = Config::Get();
+	m_Cascades.Init(config->Fetch<uint32>("Shadows/Cascades", 4), config->Fetch<uint32>("Shadows/Resolution", 2048),
+		config->Fetch<float>("Shadows/SplitLambda", 0.75f), config->Fetch<float>("Shadows/Distance", 30.f));
+	m_DepthBias = config->Fetch<float>("Shadows/DepthBias", 0.001f);
+
+	ID3D11Device* pDevice = RenderAPI::Get()->GetDevice();
+	uint32 resolution = m_Cascades.GetResolution();
+	uint32 numCascades = m_Cascades.GetNumCascades();
+
+	{
+		D3D11_TEXTURE2D_DESC textureDesc = {};
+		textureDesc.Width				= resolution;
+		textureDesc.Height				= resolution;
+		textureDesc.MipLevels			= 1;
+		textureDesc.ArraySize			= numCascades;
+		textureDesc.Format				= DXGI_FORMAT_R32_TYPELESS;
+		textureDesc.SampleDesc.Count	= 1;
+		textureDesc.Usage				= D3D11_USAGE_DEFAULT;
+		textureDesc.BindFlags			= D3D11_BIND_DEPTH_STENCIL | D3D11_BIND_SHADER_RESOURCE;
+		HRESULT result = pDevice->CreateTexture2D(&textureDesc, nullptr, &m_pShadowMap);
+		RS_D311_ASSERT_CHECK(result, "Failed to create the shadow map!");
+
+		for (uint32 i = 0; i < numCascades; i++)
+		{
+			D3D11_DEPTH_STENCIL_VIEW_DESC dsvDesc = {};
+			dsvDesc.Format							= DXGI_FORMAT_D32_FLOAT;
+			dsvDesc.ViewDimension					= D3D11_DSV_DIMENSION_TEXTURE2DARRAY;
+			dsvDesc.Texture2DArray.FirstArraySlice	= i;
+			dsvDesc.Texture2DArray.ArraySize		= 1;
+			result = pDevice->CreateDepthStencilView(m_pShadowMap, &dsvDesc, &m_pDSVs[i]);
+			RS_D311_ASSERT_CHECK(result, "Failed to create the depth stencil view of cascade {}!", i);
+		}
+
+		D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+		srvDesc.Format							= DXGI_FORMAT_R32_FLOAT;
+		srvDesc.ViewDimension					= D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+		srvDesc.Texture2DArray.MipLevels		= 1;
+		srvDesc.Texture2DArray.ArraySize		= numCascades;
+		result = pDevice->CreateShaderResourceView(m_pShadowMap, &srvDesc, &m_pSRV);
+		RS_D311_ASSERT_CHECK(result, "Failed to create the shader resource view of the shadow map!");
+	}
+
+	{
+		// Outside of the shadow map is lit.
+		D3D11_SAMPLER_DESC samplerDesc = {};
+		samplerDesc.Filter			= D3D11_FILTER_COMPARISON_MIN_MAG_LINEAR_MIP_POINT;
+		samplerDesc.AddressU		= D3D11_TEXTURE_ADDRESS_BORDER;
+		samplerDesc.AddressV		= D3D11_TEXTURE_ADDRESS_BORDER;
+		samplerDesc.AddressW		= D3D11_TEXTURE_ADDRESS_CLAMP;
+		samplerDesc.ComparisonFunc	= D3D11_COMPARISON_LESS_EQUAL;
+		samplerDesc.BorderColor[0]	= 1.f;
+		samplerDesc.BorderColor[1]	= 1.f;
+		samplerDesc.BorderColor[2]	= 1.f;
+		samplerDesc.BorderColor[3]	= 1.f;
+		samplerDesc.MaxLOD			= D3D11_FLOAT32_MAX;
+		HRESULT result = pDevice->CreateSamplerState(&samplerDesc, &m_pSampler);
+		RS_D311_ASSERT_CHECK(result, "Failed to create the shadow sampler!");
+	}
+
+	{
+		D3D11_BUFFER_DESC bufferDesc = {};
+		bufferDesc.ByteWidth		= sizeof(glm::mat4);
+		bufferDesc.Usage			= D3D11_USAGE_DYNAMIC;
+		bufferDesc.BindFlags		= D3D11_BIND_CONSTANT_BUFFER;
+		bufferDesc.CPUAccessFlags	= D3D11_CPU_ACCESS_WRITE;
+		HRESULT result = pDevice->CreateBuffer(&bufferDesc, nullptr, &m_pCascadeBuffer);
+		RS_D311_ASSERT_CHECK(result, "Failed to create cascade constant buffer!");
+
+		bufferDesc.ByteWidth = sizeof(ShadowData);
+		result = pDevice->CreateBuffer(&bufferDesc, nullptr, &m_pShadowDataBuffer);
+		RS_D311_ASSERT_CHECK(result, "Failed to create shadow constant buffer!");
+	}
+
+	{
+		// Same layout as the meshes, the shader only reads the position.
+		AttributeLayout layout;
+		layout.Push(DXGI_FORMAT_R32G32B32_FLOAT, "POSITION", 0);
+		layout.Push(DXGI_FORMAT_R32G32B32_FLOAT, "NORMAL", 0);
+		layout.Push(DXGI_FORMAT_R32G32B32_FLOAT, "TANGENT", 0);
+		layout.Push(DXGI_FORMAT_R32G32B32_FLOAT, "BITANGENT", 0);
+		layout.Push(DXGI_FORMAT_R32G32_FLOAT, "TEXCOORD", 0);
+		Shader::Descriptor shaderDesc = {};
+		shaderDesc.Vertex = "Utils/ShadowDepthVert.hlsl";
+		m_DepthShader.Load(shaderDesc, layout);
+		ShaderHotReloader::AddShader(&m_DepthShader);
+	}
+
+	// Thin geometry casts from both sides, and casters in front of the cascade are flattened onto its near plane instead of being clipped.
+	m_Pipeline.Init();
+	D3D11_RASTERIZER_DESC rasterizerDesc = {};
+	rasterizerDesc.CullMode					= D3D11_CULL_NONE;
+	rasterizerDesc.FillMode					= D3D11_FILL_SOLID;
+	rasterizerDesc.DepthBias				= config->Fetch<int32>("Shadows/RasterDepthBias", 100);
+	rasterizerDesc.SlopeScaledDepthBias		= config->Fetch<float>("Shadows/SlopeScaledDepthBias", 2.f);
+	rasterizerDesc.DepthBiasClamp			= 0.f;
+	rasterizerDesc.DepthClipEnable			= false;
+	m_Pipeline.SetRasterState(rasterizerDesc);
+}
+
+void CascadedShadowMap::Release()
+{
+	m_Pipeline.Release();
+	ShaderHotReloader::RemoveShader(&m_DepthShader);
+	m_DepthShader.Release();
+	ClearCasters();
+
+	for (ID3D11DepthStencilView*& pDSV : m_pDSVs)
+	{
+		if (pDSV)
+		{
+			pDSV->Release();
+			pDSV = nullptr;
+		}
+	}
+
+	if (m_pSRV)
+	{
+		m_pSRV->Release();
+		m_pSRV = nullptr;
+	}
+
+	if (m_pShadowMap)
+	{
+		m_pShadowMap->Release();
+		m_pShadowMap = nullptr;
+	}
+
+	if (m_pSampler)
+	{
+		m_pSampler->Release();
+		m_pSampler = nullptr;
+	}
+
+	if (m_pCascadeBuffer)
+	{
+		m_pCascadeBuffer->Release();
+		m_pCascadeBuffer = nullptr;
+	}
+
+	if (m_pShadowDataBuffer)
+	{
+		m_pShadowDataBuffer->Release();
+		m_pShadowDataBuffer = nullptr;
+	}
+}
+
+void CascadedShadowMap::AddCaster(ModelResource& model, const glm::mat4& transform)
+{
+	glm::mat4 world = transform * model.Transform;
+	for (MeshObject& mesh : model.Meshes)
+	{
+		Caster caster;
+		caster.pMesh	= &mesh;
+		caster.World	= world;
+		m_Casters.push_back(caster);
+		m_CasterBounds.push_back(AABB::Transform(mesh.BoundingBox, world));
+	}
+
+	for (ModelResource& child : model.Children)
+		AddCaster(child, world);
+}
+
+void CascadedShadowMap::ClearCasters()
+{
+	m_Casters.clear();
+	m_CasterBounds.clear();
+}
+
+void CascadedShadowMap::Render(const glm::mat4& view, const glm::mat4& proj, float nearPlane, float farPlane, const glm::vec3& lightDir, float lightIntensity)
+{
+	m_Cascades.Update(view, proj, nearPlane, farPlane, lightDir);
+	m_Cascades.CullCasters(m_CasterBounds);
+
+	std::shared_ptr<StateCache> stateCache = StateCache::Get();
+	ID3D11DeviceContext* pContext = RenderAPI::Get()->GetDeviceContext();
+
+	// The shadow map can not be read while it is written to.
+	if (m_BoundStage != ShaderTypeFlag::NONE)
+	{
+		ID3D11ShaderResourceView* pNullSRV = nullptr;
+		stateCache->SetShaderResources(m_BoundStage, m_BoundSlot, 1, &pNullSRV);
+		m_BoundStage = ShaderTypeFlag::NONE;
+	}
+
+	m_DepthShader.Bind();
+	m_Pipeline.BindRasterState();
+	m_Pipeline.BindDepthStencilState();
+
+	D3D11_VIEWPORT viewport = {};
+	viewport.Width		= (float)m_Cascades.GetResolution();
+	viewport.Height		= (float)m_Cascades.GetResolution();
+	viewport.MaxDepth	= 1.f;
+	stateCache->SetViewport(viewport);
+	stateCache->SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+	ShadowData shadowData;
+	for (uint32 i = 0; i < m_Cascades.GetNumCascades(); i++)
+	{
+		const ShadowCascades::Cascade& cascade = m_Cascades.GetCascade(i);
+		shadowData.CascadeViewProj[i] = cascade.ViewProj;
+		shadowData.CascadeSplits[i] = cascade.FarSplit;
+
+		pContext->ClearDepthStencilView(m_pDSVs[i], D3D11_CLEAR_DEPTH, 1.f, 0);
+		stateCache->SetRenderTargets(0, nullptr, m_pDSVs[i]);
+		UpdateBuffer(m_pCascadeBuffer, &cascade.ViewProj, sizeof(glm::mat4));
+		stateCache->SetConstantBuffers(ShaderTypeFlag::VERTEX, 1, 1, &m_pCascadeBuffer);
+
+		for (uint32 casterIndex : cascade.Casters)
+		{
+			const Caster& caster = m_Casters[casterIndex];
+			MeshObject* pMesh = caster.pMesh;
+			MeshObject::MeshData meshData;
+			meshData.world = caster.World;
+			UpdateBuffer(pMesh->pMeshBuffer, &meshData, sizeof(meshData));
+
+			UINT stride = sizeof(MeshObject::Vertex);
+			UINT offset = 0;
+			stateCache->SetVertexBuffers(0, 1, &pMesh->pVertexBuffer, &stride, &offset);
+			stateCache->SetIndexBuffer(pMesh->pIndexBuffer, DXGI_FORMAT_R32_UINT, 0);
+			stateCache->SetConstantBuffers(ShaderTypeFlag::VERTEX, 0, 1, &pMesh->pMeshBuffer);
+			stateCache->DrawIndexed(pMesh->NumIndices, 0, 0);
+		}
+	}
+
+	// The views were bound without a pipeline, unbind them such that the shadow map can be read.
+	stateCache->SetRenderTargets(0, nullptr, nullptr);
+
+	shadowData.LightDirection	= glm::vec4(glm::normalize(lightDir), lightIntensity);
+	shadowData.Params			= glm::vec4(1.f / (float)m_Cascades.GetResolution(), (float)m_Cascades.GetNumCascades(), m_DepthBias, 0.f);
+	UpdateBuffer(m_pShadowDataBuffer, &shadowData, sizeof(ShadowData));
+}
+
+void CascadedShadowMap::Bind(ShaderTypeFlag stage, uint32 constantBufferSlot, uint32 resourceSlot, uint32 samplerSlot)
+{
+	std::shared_ptr<StateCache> stateCache = StateCache::Get();
+	stateCache->SetConstantBuffers(stage, constantBufferSlot, 1, &m_pShadowDataBuffer);
+	stateCache->SetShaderResources(stage, resourceSlot, 1, &m_pSRV);
+	stateCache->SetSamplers(stage, samplerSlot, 1, &m_pSampler);
+	m_BoundStage	= stage;
+	m_BoundSlot		= resourceSlot;
+}
+
+const ShadowCascades& CascadedShadowMap::GetCascades() const
+{
+	return m_Cascades;
+}
+
+uint32 CascadedShadowMap::GetNumCasters() const
+{
+	return (uint32)m_Casters.size();
+}
+
+void CascadedShadowMap::UpdateBuffer(ID3D11Buffer* pBuffer, const void* pData, uint32 size)
+{
+	ID3D11DeviceContext* pContext = RenderAPI::Get()->GetDeviceContext();
+	D3D11_MAPPED_SUBRESOURCE mappedResource;
+	HRESULT result = pContext->Map(pBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+	RS_D311_ASSERT_CHECK(result, "Failed to map shadow constant buffer!");
+	memcpy(mappedResource.pData, pData, size);
+	pContext->Unmap(pBuffer, 0);
+}
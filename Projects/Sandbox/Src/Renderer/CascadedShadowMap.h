@@ -0,0 +1,92 @@
+#pragma once
+
+#include "Renderer/RenderAPI.h"
+#include "Renderer/Pipeline.h"
+#include "Renderer/Shader.h"
+#include "Renderer/ShadowCascades.h"
+#include "Resources/Resources.h"
+
+namespace RS
+{
+	/*
+	* Shadows of a directional light, rendered into one slice of a texture array for each cascade (See ShadowCascades).
+	* The casters are the meshes of the models which are added, each mesh is only drawn into the cascades it is inside of.
+	* Utils/CascadedShadows.hlsl samples the shadow map.
+	* Example:
+	*	shadowMap.Init();
+	*	shadowMap.AddCaster(*pModel, transform);
+	*	shadowMap.Render(camera.GetView(), camera.GetProj(), camera.GetNearPlane(), camera.GetFarPlane(), lightDir, 1.f);
+	*	... bind the pipeline of the scene again ...
+	*	shadowMap.Bind(ShaderTypeFlag::FRAGMENT, 3, 12, 1);
+	*/
+	class CascadedShadowMap
+	{
+	public:
+		// The layout matches the ShadowData constant buffer in Utils/CascadedShadows.hlsl.
+		struct ShadowData
+		{
+			glm::mat4	CascadeViewProj[ShadowCascades::MAX_CASCADES];
+			glm::vec4	CascadeSplits	= glm::vec4(0.f); // The far split of each cascade.
+			glm::vec4	LightDirection	= glm::vec4(0.f); // w: The intensity of the light.
+			glm::vec4	Params			= glm::vec4(0.f); // x: Size of a texel, y: Number of cascades, z: Depth bias.
+		};
+
+	public:
+		RS_DEFAULT_CLASS(CascadedShadowMap);
+
+		/*
+		* The settings are read from the Shadows section of the config.
+		*/
+		void Init();
+		void Release();
+
+		/*
+		* The meshes of the model and its children become casters. The model has to be alive until the casters are cleared.
+		*/
+		void AddCaster(ModelResource& model, const glm::mat4& transform);
+		void ClearCasters();
+
+		/*
+		* Fit the cascades to the camera, cull the casters and render them. This binds its own views and viewport.
+		* lightDir: The direction the light travels in.
+		*/
+		void Render(const glm::mat4& view, const glm::mat4& proj, float nearPlane, float farPlane, const glm::vec3& lightDir, float lightIntensity);
+
+		/*
+		* Bind the constant buffer, the shadow map and the comparison sampler.
+		*/
+		void Bind(ShaderTypeFlag stage, uint32 constantBufferSlot, uint32 resourceSlot, uint32 samplerSlot);
+
+		const ShadowCascades& GetCascades() const;
+		uint32 GetNumCasters() const;
+
+	private:
+		struct Caster
+		{
+			MeshObject*	pMesh	= nullptr;
+			glm::mat4	World	= glm::mat4(1.f);
+		};
+
+		static void UpdateBuffer(ID3D11Buffer* pBuffer, const void* pData, uint32 size);
+
+	private:
+		ShadowCascades				m_Cascades;
+		std::vector<Caster>			m_Casters;
+		std::vector<AABB>			m_CasterBounds;
+		float						m_DepthBias			= 0.f;
+
+		Shader						m_DepthShader;
+		Pipeline					m_Pipeline; // Only the rasterizer state, with depth bias and without depth clipping.
+
+		ID3D11Texture2D*			m_pShadowMap		= nullptr;
+		ID3D11DepthStencilView*		m_pDSVs[ShadowCascades::MAX_CASCADES]	= { nullptr };
+		ID3D11ShaderResourceView*	m_pSRV				= nullptr;
+		ID3D11SamplerState*			m_pSampler			= nullptr;
+		ID3D11Buffer*				m_pCascadeBuffer	= nullptr;
+		ID3D11Buffer*				m_pShadowDataBuffer	= nullptr;
+
+		// Where the shadow map was bound, it has to be unbound before it is rendered to.
+		ShaderTypeFlag				m_BoundStage		= ShaderTypeFlag::NONE;
+		uint32						m_BoundSlot			= 0;
+	};
+}
@@ -0,0 +1,258 @@
+#include "PreCompiled.h"
+#include "DebugFont.h"
+
+#pragma warning( push )
+#pragma warning( disable : 6011 )
+#pragma warning( disable : 6262 )
+#pragma warning( disable : 6308 )
+#pragma warning( disable : 6387 )
+#pragma warning( disable : 26451 )
+#pragma warning( disable : 28182 )
+#define STB_TRUETYPE_IMPLEMENTATION
+#include <stb_truetype.h>
+#pragma warning( pop )
+
+#include "Core/VirtualFileSystem.h"
+#include "Utils/Timer.h"
+
+#include <filesystem>
+#include <fstream>
+
+using namespace RS;
+
+bool DebugFont::Load(const std::string& fontPath, float pixelHeight, uint32 atlasSize, const std::string& cacheFolder)
+{
+	Timer timer;
+
+	// The cache belongs to the font file as it was when the cache was written.
+	CacheHeader expected;
+	expected.PixelHeight	= pixelHeight;
+	expected.AtlasWidth		= atlasSize;
+	FileView fontData;
+	bool hasFont = VirtualFileSystem::Get()->Exists(fontPath) && VirtualFileSystem::Get()->Read(fontPath, fontData);
+	if (hasFont)
+	{
+		// FNV-1a
+		expected.FontHash = 14695981039346656037ull;
+		for (uint64 i = 0; i < fontData.Size; i++)
+		{
+			expected.FontHash ^= fontData.pData[i];
+			expected.FontHash *= 1099511628211ull;
+		}
+		expected.FontFileSize = fontData.Size;
+	}
+
+	std::string cachePath = cacheFolder + std::filesystem::path(fontPath).stem().string() + "." + std::to_string((uint32)pixelHeight) + ".rsfnt";
+	if (ReadCache(cachePath, expected, hasFont))
+	{
+		LOG_INFO("Loaded debug font [{}] from the cache in {:.2f} ms.", fontPath.c_str(), timer.Stop().GetDeltaTimeMS());
+		return true;
+	}
+
+	if (!hasFont)
+	{
+		LOG_WARNING("Debug font [{}] was not found and is not cached!", fontPath.c_str());
+		return false;
+	}
+
+	if (!Rasterize(fontData, pixelHeight, atlasSize))
+		return false;
+
+	expected.LineHeight		= m_LineHeight;
+	expected.AtlasHeight	= m_AtlasHeight;
+	std::error_code error;
+	std::filesystem::create_directories(cacheFolder, error);
+	WriteCache(cachePath, expected);
+
+	LOG_INFO("Rasterized debug font [{}] into a {}x{} atlas in {:.2f} ms.", fontPath.c_str(), m_AtlasWidth, m_AtlasHeight, timer.Stop().GetDeltaTimeMS());
+	return true;
+}
+
+void DebugFont::InitMonospace(float advance, float lineHeight)
+{
+	for (uint32 i = 0; i < NUM_CHARS; i++)
+	{
+		Glyph& glyph = m_Glyphs[i];
+		glyph = Glyph();
+		glyph.Advance	= advance;
+		glyph.Size		= i == GetIndex(' ') ? glm::vec2(0.f) : glm::vec2(advance, lineHeight);
+	}
+	std::fill(m_Kerning.begin(), m_Kerning.end(), 0.f);
+
+	m_LineHeight	= lineHeight;
+	m_PixelHeight	= lineHeight;
+	m_Atlas.clear();
+	m_AtlasWidth	= 0;
+	m_AtlasHeight	= 0;
+	m_IsLoaded		= false;
+}
+
+void DebugFont::SetKerning(char first, char second, float kerning)
+{
+	m_Kerning[GetIndex(first) * NUM_CHARS + GetIndex(second)] = kerning;
+}
+
+float DebugFont::GetKerning(char first, char second) const
+{
+	return m_Kerning[GetIndex(first) * NUM_CHARS + GetIndex(second)];
+}
+
+float DebugFont::GetLineHeight() const
+{
+	return m_LineHeight;
+}
+
+float DebugFont::GetPixelHeight() const
+{
+	return m_PixelHeight;
+}
+
+uint32 DebugFont::GetAtlasWidth() const
+{
+	return m_AtlasWidth;
+}
+
+uint32 DebugFont::GetAtlasHeight() const
+{
+	return m_AtlasHeight;
+}
+
+const std::vector<uint8>& DebugFont::GetAtlas() const
+{
+	return m_Atlas;
+}
+
+bool DebugFont::IsLoaded() const
+{
+	return m_IsLoaded;
+}
+
+uint32 DebugFont::GetIndex(char c)
+{
+	uint32 index = (uint32)(uint8)c - FIRST_CHAR;
+	return index < NUM_CHARS ? index : (uint32)('?' - FIRST_CHAR);
+}
+
+bool DebugFont::Rasterize(const FileView& fontData, float pixelHeight, uint32 atlasSize)
+{
+	stbtt_fontinfo info;
+	if (fontData.Size == 0 || !stbtt_InitFont(&info, fontData.pData, stbtt_GetFontOffsetForIndex(fontData.pData, 0)))
+	{
+		LOG_WARNING("Failed to parse the debug font!");
+		return false;
+	}
+
+	float scale = stbtt_ScaleForPixelHeight(&info, pixelHeight);
+	int ascent = 0, descent = 0, lineGap = 0;
+	stbtt_GetFontVMetrics(&info, &ascent, &descent, &lineGap);
+	float baseline	= (float)ascent * scale;
+	m_LineHeight	= (float)(ascent - descent + lineGap) * scale;
+	m_PixelHeight	= pixelHeight;
+
+	// The glyphs are packed in rows, with a texel between them such that they do not bleed into each other when filtered.
+	m_Atlas.assign((size_t)atlasSize * atlasSize, 0);
+	m_AtlasWidth = atlasSize;
+	uint32 x = 1, y = 1, rowHeight = 0;
+	for (uint32 i = 0; i < NUM_CHARS; i++)
+	{
+		int codepoint = (int)(FIRST_CHAR + i);
+		int advance = 0, leftSideBearing = 0;
+		stbtt_GetCodepointHMetrics(&info, codepoint, &advance, &leftSideBearing);
+		int x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+		stbtt_GetCodepointBitmapBox(&info, codepoint, scale, scale, &x0, &y0, &x1, &y1);
+
+		Glyph& glyph = m_Glyphs[i];
+		glyph = Glyph();
+		glyph.Advance = (float)advance * scale;
+
+		uint32 width = (uint32)(x1 - x0), height = (uint32)(y1 - y0);
+		if (x1 <= x0 || y1 <= y0)
+			continue;
+
+		if (x + width + 1 > atlasSize)
+		{
+			x = 1;
+			y += rowHeight + 1;
+			rowHeight = 0;
+		}
+
+		if (y + height + 1 > atlasSize)
+		{
+			LOG_WARNING("The debug font atlas of {}x{} is too small for a line height of {} pixels!", atlasSize, atlasSize, pixelHeight);
+			m_Atlas.clear();
+			return false;
+		}
+
+		stbtt_MakeCodepointBitmap(&info, &m_Atlas[(size_t)y * atlasSize + x], (int)width, (int)height, (int)atlasSize, scale, scale, codepoint);
+		glyph.Offset		= glm::vec2((float)x0, baseline + (float)y0);
+		glyph.Size			= glm::vec2((float)width, (float)height);
+		glyph.AtlasMin[0]	= (uint16)x;
+		glyph.AtlasMin[1]	= (uint16)y;
+		glyph.AtlasMax[0]	= (uint16)(x + width);
+		glyph.AtlasMax[1]	= (uint16)(y + height);
+		x += width + 1;
+		rowHeight = std::max(rowHeight, height);
+	}
+
+	// Only keep the rows which are used.
+	m_AtlasHeight = 1;
+	while (m_AtlasHeight < y + rowHeight + 1)
+		m_AtlasHeight *= 2;
+	m_Atlas.resize((size_t)m_AtlasWidth * m_AtlasHeight);
+
+	for (uint32 first = 0; first < NUM_CHARS; first++)
+	{
+		for (uint32 second = 0; second < NUM_CHARS; second++)
+			m_Kerning[first * NUM_CHARS + second] = (float)stbtt_GetCodepointKernAdvance(&info, (int)(FIRST_CHAR + first), (int)(FIRST_CHAR + second)) * scale;
+	}
+
+	m_IsLoaded = true;
+	return true;
+}
+
+bool DebugFont::ReadCache(const std::string& path, const CacheHeader& expected, bool hasFont)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open())
+		return false;
+
+	CacheHeader header;
+	file.read((char*)&header, sizeof(CacheHeader));
+	bool isValid = file.good() && header.Magic == MAGIC && header.Version == VERSION && header.PixelHeight == expected.PixelHeight && header.AtlasWidth == expected.AtlasWidth;
+	if (isValid && hasFont)
+		isValid = header.FontFileSize == expected.FontFileSize && header.FontHash == expected.FontHash;
+	if (!isValid)
+		return false;
+
+	m_Atlas.resize((size_t)header.AtlasWidth * header.AtlasHeight);
+	file.read((char*)m_Glyphs, sizeof(m_Glyphs));
+	file.read((char*)m_Kerning.data(), (std::streamsize)(m_Kerning.size() * sizeof(float)));
+	file.read((char*)m_Atlas.data(), (std::streamsize)m_Atlas.size());
+	if (!file.good())
+	{
+		LOG_WARNING("Debug font cache [{}] is corrupt, the font is rasterized again.", path.c_str());
+		return false;
+	}
+
+	m_LineHeight	= header.LineHeight;
+	m_PixelHeight	= header.PixelHeight;
+	m_AtlasWidth	= header.AtlasWidth;
+	m_AtlasHeight	= header.AtlasHeight;
+	m_IsLoaded		= true;
+	return true;
+}
+
+void DebugFont::WriteCache(const std::string& path, const CacheHeader& header) const
+{
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		LOG_WARNING("Failed to write debug font cache [{}]!", path.c_str());
+		return;
+	}
+
+	file.write((const char*)&header, sizeof(CacheHeader));
+	file.write((const char*)m_Glyphs, sizeof(m_Glyphs));
+	file.write((const char*)m_Kerning.data(), (std::streamsize)(m_Kerning.size() * sizeof(float)));
+	file.write((const char*)m_Atlas.data(), (std::streamsize)m_Atlas.size());
+}
@@ -0,0 +1,181 @@
+#pragma once
+
+#include "Core/FileView.h"
+#include "Utils/Maths.h"
+
+#include <algorithm>
+#include <string_view>
+#include <vector>
+
+namespace RS
+{
+	/*
+	* The CPU side of the text of DebugRenderer, it does not use the device.
+	*	- The printable ASCII characters of a TrueType font are rasterized once into a single channel atlas.
+	*	- The font is read through the VirtualFileSystem, the engine ships Source Code Pro in Assets/Fonts.
+	*	- The atlas and the metrics are cached to disk, such that the font is only rasterized again when it changes.
+	*	- Strings are laid out in pixels with the kerning of the font, and are wrapped at spaces to fit a width.
+	* Example:
+	*	font.Load("Fonts/SourceCodePro-Regular.ttf", 32.f, 512, RS_COOKED_PATH "Fonts/");
+	*	font.Layout("Hello world", 0.f, [&](const DebugFont::Quad& quad) { ... });
+	*/
+	class DebugFont
+	{
+	public:
+		static const uint32 VERSION		= 2;
+		static const uint32 MAGIC		= 0x54465352; // "RSFT"
+		static const uint32 FIRST_CHAR	= 32;
+		static const uint32 NUM_CHARS	= 95; // Up to and including '~'.
+
+		struct Glyph
+		{
+			glm::vec2	Offset		= glm::vec2(0.f); // Pixels from the pen position at the top of the line to the top left of the bitmap.
+			glm::vec2	Size		= glm::vec2(0.f); // Pixels.
+			uint16		AtlasMin[2]	= { 0, 0 }; // Texels.
+			uint16		AtlasMax[2]	= { 0, 0 };
+			float		Advance		= 0.f;
+		};
+
+		/*
+		* A glyph which was laid out, in pixels from the top left of the text.
+		*/
+		struct Quad
+		{
+			glm::vec2		Min			= glm::vec2(0.f);
+			glm::vec2		Max			= glm::vec2(0.f);
+			const Glyph*	pGlyph		= nullptr;
+		};
+
+	public:
+		RS_DEFAULT_CLASS(DebugFont);
+
+		/*
+		* Read the atlas from the cache folder, or rasterize the font and write it there. The font file is not needed when the cache exists.
+		* fontPath: Read through the VirtualFileSystem, relative to the asset folder.
+		* pixelHeight: The height of a line in the atlas, the text can be drawn at other sizes.
+		*/
+		bool Load(const std::string& fontPath, float pixelHeight, uint32 atlasSize, const std::string& cacheFolder);
+
+		/*
+		* Metrics where each glyph is a box with the same advance, without an atlas. Used to test the layout.
+		*/
+		void InitMonospace(float advance, float lineHeight);
+
+		void SetKerning(char first, char second, float kerning);
+		float GetKerning(char first, char second) const;
+
+		/*
+		* Call onQuad for each visible glyph of the text, and return the size of the text.
+		* maxWidth: Lines are broken at the spaces before the words which do not fit, and words which are wider than a line are broken anywhere. Zero does not wrap.
+		* Line feeds start a new line, characters which are not in the font are drawn as '?'.
+		*/
+		template<typename Function>
+		glm::vec2 Layout(std::string_view text, float maxWidth, Function onQuad) const;
+
+		float GetLineHeight() const;
+		float GetPixelHeight() const;
+		uint32 GetAtlasWidth() const;
+		uint32 GetAtlasHeight() const;
+		const std::vector<uint8>& GetAtlas() const;
+		bool IsLoaded() const;
+
+	private:
+		struct CacheHeader
+		{
+			uint32	Magic			= MAGIC;
+			uint32	Version			= VERSION;
+			float	PixelHeight		= 0.f;
+			float	LineHeight		= 0.f;
+			uint32	AtlasWidth		= 0;
+			uint32	AtlasHeight		= 0;
+			uint64	FontFileSize	= 0;
+			uint64	FontHash		= 0; // FNV-1a of the font file, the VirtualFileSystem has no write times.
+		};
+
+		static uint32 GetIndex(char c);
+
+		bool Rasterize(const FileView& fontData, float pixelHeight, uint32 atlasSize);
+		bool ReadCache(const std::string& path, const CacheHeader& expected, bool hasFont);
+		void WriteCache(const std::string& path, const CacheHeader& header) const;
+
+	private:
+		Glyph					m_Glyphs[NUM_CHARS];
+		std::vector<float>		m_Kerning		= std::vector<float>(NUM_CHARS * NUM_CHARS, 0.f); // Indexed by the first character times NUM_CHARS plus the second.
+		float					m_LineHeight	= 0.f;
+		float					m_PixelHeight	= 0.f;
+
+		std::vector<uint8>		m_Atlas;
+		uint32					m_AtlasWidth	= 0;
+		uint32					m_AtlasHeight	= 0;
+		bool					m_IsLoaded		= false;
+	};
+
+	template<typename Function>
+	glm::vec2 DebugFont::Layout(std::string_view text, float maxWidth, Function onQuad) const
+	{
+		glm::vec2 pen(0.f);
+		glm::vec2 size(0.f, text.empty() ? 0.f : m_LineHeight);
+		uint32 previous = UINT32_MAX;
+		auto NewLine = [&]()
+		{
+			pen.x = 0.f;
+			pen.y += m_LineHeight;
+			size.y = pen.y + m_LineHeight;
+			previous = UINT32_MAX;
+		};
+
+		for (size_t i = 0; i < text.size(); i++)
+		{
+			char c = text[i];
+			if (c == '\n')
+			{
+				NewLine();
+				continue;
+			}
+
+			uint32 index = GetIndex(c);
+			if (maxWidth > 0.f)
+			{
+				if (c == ' ')
+				{
+					// A space at the end of a line is dropped with the line break.
+					if (pen.x + m_Glyphs[index].Advance > maxWidth)
+					{
+						NewLine();
+						continue;
+					}
+				}
+				else if (pen.x > 0.f)
+				{
+					// Break before a word which does not fit, or inside a word which does not fit on a line of its own.
+					float width = m_Glyphs[index].Advance;
+					if (i == 0 || text[i - 1] == ' ')
+					{
+						for (size_t j = i + 1; j < text.size() && text[j] != ' ' && text[j] != '\n'; j++)
+							width += m_Glyphs[GetIndex(text[j])].Advance;
+					}
+					if (pen.x + width > maxWidth)
+						NewLine();
+				}
+			}
+
+			if (previous != UINT32_MAX)
+				pen.x += m_Kerning[previous * NUM_CHARS + index];
+
+			const Glyph& glyph = m_Glyphs[index];
+			if (glyph.Size.x > 0.f && glyph.Size.y > 0.f)
+			{
+				Quad quad;
+				quad.Min	= pen + glyph.Offset;
+				quad.Max	= quad.Min + glyph.Size;
+				quad.pGlyph	= &glyph;
+				onQuad(quad);
+			}
+
+			pen.x += glyph.Advance;
+			size.x = std::max(size.x, pen.x);
+			previous = index;
+		}
+		return size;
+	}
+}
@@ -0,0 +1,277 @@
+#pragma once
+
+#include "Renderer/RenderAPI.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+namespace RS
+{
+	/*
+	* The groups of one type of primitive of DebugRenderer, which share a vertex buffer, or a structured buffer for the shapes.
+	*	- Each id is a group with its own range in the buffer, only the elements which changed are uploaded.
+	*	- Static groups get no space to grow in. Dynamic groups get extra space, such that they can be rewritten in place.
+	*	- Groups which outgrow their range get a new one at the end. The buffer is compacted when it is too small or more than half of it is unused.
+	*	- The groups which are next to each other are drawn with one call.
+	* Example:
+	*	DebugPrimitiveBuffer<Vertex>::Group& group = buffer.Groups[id];
+	*	group.Elements.push_back(vertex);
+	*	buffer.MarkDirty(group, (uint32)group.Elements.size() - 1);
+	*	buffer.Update();
+	*	for (const DebugPrimitiveBuffer<Vertex>::DrawRange& range : buffer.DrawRanges) ... draw range.Count elements from range.Start ...
+	*/
+	template<typename Element>
+	struct DebugPrimitiveBuffer
+	{
+		static constexpr uint32 ELEMENT_SIZE = (uint32)sizeof(Element);
+
+		struct Group
+		{
+			std::vector<Element> Elements;
+			uint32 ID = 0u;
+			bool IsStatic = false;
+
+			// Range in the buffer, in elements.
+			uint32 Offset		= 0u;
+			uint32 Capacity		= 0u;
+			// Elements which changed since they were uploaded.
+			uint32 DirtyBegin	= UINT32_MAX;
+			uint32 DirtyEnd		= 0u;
+		};
+
+		struct DrawRange
+		{
+			uint32 Start = 0u;
+			uint32 Count = 0u;
+		};
+
+		std::unordered_map<uint32, Group>	Groups;
+		std::vector<DrawRange>				DrawRanges;
+		ID3D11Buffer*				pBuffer				= nullptr;
+		ID3D11ShaderResourceView*	pSRV				= nullptr; // Only for structured buffers.
+		uint32						Size				= 0u; // In elements.
+		uint32						End					= 0u; // The elements after this are not used by a group.
+		uint32						NumFree				= 0u; // Elements before the end which no group uses.
+		uint32						NumElements			= 0u;
+		uint32						UploadedBytes		= 0u; // In the last Update.
+		bool						IsDirty				= false;
+		bool						IsStructured		= true; // Read by the vertex shader through pSRV, or else a vertex buffer.
+		bool						ShouldClearDefault	= true; // The default id is cleared by the first push after Update.
+
+		DebugPrimitiveBuffer() = default;
+		explicit DebugPrimitiveBuffer(bool isStructured) : IsStructured(isStructured) {}
+
+		/*
+		* Mark the elements from begin to the end of the group as changed.
+		*/
+		void MarkDirty(Group& group, uint32 begin);
+
+		/*
+		* Give the groups which outgrew their range a new one, compact the buffer if it is too small or fragmented and upload the changed elements.
+		*/
+		void Update();
+
+		/*
+		* Remove a group, its range is reused when the buffer is compacted.
+		*/
+		void RemoveGroup(uint32 id);
+
+		/*
+		* Release the buffer and remove all groups.
+		*/
+		void Release();
+
+	private:
+		void Compact();
+	};
+
+	template<typename Element>
+	void DebugPrimitiveBuffer<Element>::MarkDirty(Group& group, uint32 begin)
+	{
+		group.DirtyBegin	= std::min(group.DirtyBegin, begin);
+		group.DirtyEnd		= (uint32)group.Elements.size();
+		IsDirty				= true;
+	}
+
+	template<typename Element>
+	void DebugPrimitiveBuffer<Element>::Update()
+	{
+		UploadedBytes = 0u;
+		if (IsDirty == false)
+			return;
+		IsDirty = false;
+
+		// Groups which outgrew their range get a new one at the end, dynamic groups get room to grow.
+		NumElements = 0u;
+		for (auto& [id, group] : Groups)
+		{
+			uint32 count = (uint32)group.Elements.size();
+			NumElements += count;
+			if (count > group.Capacity)
+			{
+				NumFree				+= group.Capacity;
+				group.Capacity		= group.IsStatic ? count : std::max(count + count / 2, 64u);
+				group.Offset		= End;
+				group.DirtyBegin	= 0u;
+				group.DirtyEnd		= count;
+				End					+= group.Capacity;
+			}
+		}
+
+		if (End > Size || NumFree > End / 2)
+			Compact();
+
+		if (End > Size)
+		{
+			if (pSRV)
+			{
+				pSRV->Release();
+				pSRV = nullptr;
+			}
+
+			if (pBuffer)
+			{
+				pBuffer->Release();
+				pBuffer = nullptr;
+			}
+
+			Size = End + End / 2;
+			D3D11_BUFFER_DESC bufferDesc = {};
+			bufferDesc.ByteWidth = (UINT)(ELEMENT_SIZE * Size);
+			bufferDesc.Usage = D3D11_USAGE_DEFAULT;
+			bufferDesc.BindFlags = IsStructured ? D3D11_BIND_SHADER_RESOURCE : D3D11_BIND_VERTEX_BUFFER;
+			bufferDesc.CPUAccessFlags = 0;
+			bufferDesc.MiscFlags = IsStructured ? D3D11_RESOURCE_MISC_BUFFER_STRUCTURED : 0;
+			bufferDesc.StructureByteStride = IsStructured ? ELEMENT_SIZE : 0;
+
+			ID3D11Device* pDevice = RenderAPI::Get()->GetDevice();
+			HRESULT result = pDevice->CreateBuffer(&bufferDesc, nullptr, &pBuffer);
+			RS_D311_CHECK(result, "Failed to create debug buffer!");
+			if (SUCCEEDED(result) && IsStructured)
+			{
+				D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+				srvDesc.Format				= DXGI_FORMAT_UNKNOWN;
+				srvDesc.ViewDimension		= D3D11_SRV_DIMENSION_BUFFER;
+				srvDesc.Buffer.FirstElement	= 0;
+				srvDesc.Buffer.NumElements	= Size;
+				result = pDevice->CreateShaderResourceView(pBuffer, &srvDesc, &pSRV);
+				RS_D311_CHECK(result, "Failed to create the view of a debug buffer!");
+			}
+
+			if (FAILED(result))
+			{
+				if (pBuffer)
+					pBuffer->Release();
+				pBuffer	= nullptr;
+				pSRV	= nullptr;
+				Size	= 0u;
+				DrawRanges.clear();
+				return;
+			}
+
+			for (auto& [id, group] : Groups)
+			{
+				group.DirtyBegin	= 0u;
+				group.DirtyEnd		= (uint32)group.Elements.size();
+			}
+		}
+
+		// Upload the changed elements of each group, and draw the groups which are next to each other with one call.
+		ID3D11DeviceContext* pContext = RenderAPI::Get()->GetDeviceContext();
+		DrawRanges.clear();
+		for (auto& [id, group] : Groups)
+		{
+			uint32 count = (uint32)group.Elements.size();
+			uint32 dirtyEnd = std::min(group.DirtyEnd, count);
+			if (group.DirtyBegin < dirtyEnd)
+			{
+				D3D11_BOX box = {};
+				box.left	= (UINT)(ELEMENT_SIZE * (group.Offset + group.DirtyBegin));
+				box.right	= (UINT)(ELEMENT_SIZE * (group.Offset + dirtyEnd));
+				box.bottom	= 1;
+				box.back	= 1;
+				pContext->UpdateSubresource(pBuffer, 0, &box, &group.Elements[group.DirtyBegin], 0, 0);
+				UploadedBytes += box.right - box.left;
+			}
+			group.DirtyBegin	= UINT32_MAX;
+			group.DirtyEnd		= 0u;
+
+			if (count > 0)
+				DrawRanges.push_back({ group.Offset, count });
+		}
+
+		std::sort(DrawRanges.begin(), DrawRanges.end(), [](const DrawRange& a, const DrawRange& b) { return a.Start < b.Start; });
+		uint32 numRanges = 0;
+		for (const DrawRange& range : DrawRanges)
+		{
+			DrawRange& previous = DrawRanges[numRanges == 0 ? 0 : numRanges - 1];
+			if (numRanges > 0 && previous.Start + previous.Count == range.Start)
+				previous.Count += range.Count;
+			else
+				DrawRanges[numRanges++] = range;
+		}
+		DrawRanges.resize(numRanges);
+	}
+
+	template<typename Element>
+	void DebugPrimitiveBuffer<Element>::RemoveGroup(uint32 id)
+	{
+		auto it = Groups.find(id);
+		if (it == Groups.end())
+			return;
+
+		// The range is reused when the buffer is compacted.
+		NumFree += it->second.Capacity;
+		Groups.erase(it);
+		IsDirty = true;
+	}
+
+	template<typename Element>
+	void DebugPrimitiveBuffer<Element>::Release()
+	{
+		if (pSRV)
+		{
+			pSRV->Release();
+			pSRV = nullptr;
+		}
+
+		if (pBuffer)
+		{
+			pBuffer->Release();
+			pBuffer = nullptr;
+		}
+
+		Groups.clear();
+		DrawRanges.clear();
+		Size		= 0u;
+		End			= 0u;
+		NumFree		= 0u;
+		NumElements	= 0u;
+		IsDirty		= false;
+	}
+
+	template<typename Element>
+	void DebugPrimitiveBuffer<Element>::Compact()
+	{
+		// Static groups first, they are rarely moved again.
+		End = 0u;
+		for (bool isStatic : { true, false })
+		{
+			for (auto& [id, group] : Groups)
+			{
+				if (group.IsStatic != isStatic)
+					continue;
+
+				if (group.Offset != End)
+				{
+					group.Offset		= End;
+					group.DirtyBegin	= 0u;
+					group.DirtyEnd		= (uint32)group.Elements.size();
+				}
+				End += group.Capacity;
+			}
+		}
+		NumFree = 0u;
+	}
+}
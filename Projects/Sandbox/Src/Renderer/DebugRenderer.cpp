@@ -5,17 +5,131 @@
 #include "Core/Display.h"
 
 #include "Renderer/ShaderHotReloader.h"
+#include "Renderer/StateCache.h"
+#include "Utils/Config.h"
+#include "Utils/Timer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
 
 using namespace RS;
 
+// Number of vertices of each unit shape, these have to match DebugRenderer/ShapeVert.hlsl.
+static const uint32 s_BoxVertexCount		= 24;	// 12 edges.
+static const uint32 s_SphereVertexCount		= 192;	// Three circles of 32 segments.
+static const uint32 s_AxesVertexCount		= 6;
+
 std::shared_ptr<DebugRenderer> DebugRenderer::Get()
 {
 	static std::shared_ptr<DebugRenderer> s_DebugRenderer = std::make_shared<DebugRenderer>();
 	return s_DebugRenderer;
 }
 
+template<typename Element>
+DebugRenderer::Group<Element>& DebugRenderer::GetGroup(PrimitiveBuffer<Element>& buffer, uint32 id)
+{
+	auto it = buffer.Groups.find(id);
+	if (it != buffer.Groups.end())
+		return it->second;
+
+	Group<Element>& group = buffer.Groups[id];
+	group.ID = id;
+	group.IsStatic = (id & (s_TimedIDBase | s_StaticIDFlag)) == s_StaticIDFlag && id != s_OneFrameID;
+	return group;
+}
+
+template<typename Element>
+DebugRenderer::Group<Element>& DebugRenderer::GetPushGroup(PrimitiveBuffer<Element>& buffer, uint32 id, bool shouldClear, float lifetime)
+{
+	if (lifetime < 0.f)
+	{
+		Group<Element>& group = GetGroup(buffer, id);
+
+		// The default ids are cleared by the first push of each frame, whatever shouldClear is.
+		bool isDefaultID = id == s_DefaultLinesID || id == s_DefaultPointsID;
+		if (isDefaultID ? buffer.ShouldClearDefault : shouldClear)
+			group.Elements.clear();
+		if (isDefaultID)
+			buffer.ShouldClearDefault = false;
+		return group;
+	}
+
+	if (lifetime == LIFETIME_ONE_FRAME)
+		return GetGroup(buffer, s_OneFrameID);
+
+	// Rounded up, such that the primitive lives at least as long as it was asked for.
+	uint64 tick = (uint64)std::ceil((m_Time + (double)lifetime) * TIMED_BUCKETS_PER_SECOND);
+	m_ExpiryTicks.insert(tick);
+	return GetGroup(buffer, s_TimedIDBase | (uint32)(tick & ~s_TimedIDBase));
+}
+
+template<typename Element>
+DebugRenderer::PushTarget<Element> DebugRenderer::BeginPush(PrimitiveBuffer<Element>& buffer, Type type, uint32 id, bool shouldClear, float lifetime, uint32& outID)
+{
+	outID = lifetime < 0.f ? ProcessID(id, type) : 0;
+
+	// Other threads only append to their own command buffer, the push is applied to the group in Render.
+	if (ThreadCommands* pCommands = GetThreadCommands())
+	{
+		std::vector<Element>* pElements = nullptr;
+		if constexpr (std::is_same_v<Element, ShapeInstance>)
+			pElements = &pCommands->Shapes;
+		else if constexpr (std::is_same_v<Element, GlyphInstance>)
+			pElements = &pCommands->Glyphs;
+		else if constexpr (std::is_same_v<Element, Point>)
+			pElements = &pCommands->Points;
+		else if constexpr (std::is_same_v<Element, MeshInstance>)
+			pElements = &pCommands->Meshes;
+		else
+			pElements = &pCommands->Vertices;
+
+		ThreadCommand& command = pCommands->Commands.emplace_back();
+		command.PrimitiveType	= type;
+		command.ID				= outID;
+		command.Lifetime		= lifetime;
+		command.First			= (uint32)pElements->size();
+		command.ShouldClear		= shouldClear;
+		return PushTarget<Element>{ *pElements, nullptr, &command, command.First };
+	}
+
+	Group<Element>& group = GetPushGroup(buffer, outID, shouldClear, lifetime);
+	return PushTarget<Element>{ group.Elements, &group, nullptr, (uint32)group.Elements.size() };
+}
+
+template<typename Element>
+void DebugRenderer::EndPush(PrimitiveBuffer<Element>& buffer, PushTarget<Element>& target)
+{
+	if (target.pGroup)
+		buffer.MarkDirty(*target.pGroup, target.First);
+	else
+		target.pCommand->Count = (uint32)target.Elements.size() - target.First;
+}
+
+template<typename Element>
+void DebugRenderer::ApplyThreadCommand(PrimitiveBuffer<Element>& buffer, const ThreadCommand& command, const std::vector<Element>& elements)
+{
+	Group<Element>& group = GetPushGroup(buffer, command.ID, command.ShouldClear, command.Lifetime);
+	uint32 first = (uint32)group.Elements.size();
+	group.Elements.insert(group.Elements.end(), elements.begin() + command.First, elements.begin() + command.First + command.Count);
+	buffer.MarkDirty(group, first);
+}
+
+template<typename Function>
+void DebugRenderer::ForEachBuffer(Function function)
+{
+	function(m_Lines);
+	function(m_Points);
+	function(m_Boxes);
+	function(m_Spheres);
+	function(m_Axes);
+	function(m_Text);
+	function(m_Meshes);
+}
+
 void DebugRenderer::Init()
 {
+	m_RenderThreadID = std::this_thread::get_id();
 	m_Pipeline.Init();
 
 	D3D11_RASTERIZER_DESC rasterizerDesc = {};
@@ -33,7 +147,7 @@ void DebugRenderer::Init()
 
 	{
 		D3D11_BUFFER_DESC bufferDesc = {};
-		bufferDesc.ByteWidth = sizeof(glm::mat4);
+		bufferDesc.ByteWidth = sizeof(FrameData);
 		bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
 		bufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
 		bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
@@ -43,12 +157,56 @@ void DebugRenderer::Init()
 		HRESULT result = RenderAPI::Get()->GetDevice()->CreateBuffer(&bufferDesc, nullptr, &m_pVPBuffer);
 		RS_D311_ASSERT_CHECK(result, "Failed to create constant buffer for the VP!");
 
-		result = RenderAPI::Get()->GetDevice()->CreateBuffer(&bufferDesc, nullptr, &m_pViewBuffer);
-		RS_D311_ASSERT_CHECK(result, "Failed to create constant buffer for the View!");
+		bufferDesc.ByteWidth = sizeof(ShapeData);
+		result = RenderAPI::Get()->GetDevice()->CreateBuffer(&bufferDesc, nullptr, &m_pShapeBuffer);
+		RS_D311_ASSERT_CHECK(result, "Failed to create constant buffer for the shapes!");
+
+		bufferDesc.ByteWidth = sizeof(TextData);
+		result = RenderAPI::Get()->GetDevice()->CreateBuffer(&bufferDesc, nullptr, &m_pTextBuffer);
+		RS_D311_ASSERT_CHECK(result, "Failed to create constant buffer for the text!");
+	}
+
+	Config* config = Config::Get();
+	m_Wireframes.SetMaxVertices(config->Fetch<uint32>("DebugRenderer/MaxWireframeVertices", DebugWireframe::DEFAULT_MAX_VERTICES));
 
-		bufferDesc.ByteWidth = sizeof(GFrameData);
-		result = RenderAPI::Get()->GetDevice()->CreateBuffer(&bufferDesc, nullptr, &m_pGeomBuffer);
-		RS_D311_ASSERT_CHECK(result, "Failed to create constant buffer for the Proj!");
+	// The text is not drawn if the font could not be loaded, it is still laid out such that the pushes behave the same.
+	bool isFontLoaded = m_Font.Load(config->Fetch<std::string>("DebugText/Font", "Fonts/SourceCodePro-Regular.ttf"), config->Fetch<float>("DebugText/PixelHeight", 32.f),
+		config->Fetch<uint32>("DebugText/AtlasSize", 512), std::string(RS_COOKED_PATH) + "Fonts/");
+	if (isFontLoaded)
+	{
+		D3D11_TEXTURE2D_DESC textureDesc = {};
+		textureDesc.Width				= m_Font.GetAtlasWidth();
+		textureDesc.Height				= m_Font.GetAtlasHeight();
+		textureDesc.MipLevels			= 1;
+		textureDesc.ArraySize			= 1;
+		textureDesc.Format				= DXGI_FORMAT_R8_UNORM;
+		textureDesc.SampleDesc.Count	= 1;
+		textureDesc.Usage				= D3D11_USAGE_IMMUTABLE;
+		textureDesc.BindFlags			= D3D11_BIND_SHADER_RESOURCE;
+
+		D3D11_SUBRESOURCE_DATA data = {};
+		data.pSysMem		= m_Font.GetAtlas().data();
+		data.SysMemPitch	= m_Font.GetAtlasWidth();
+
+		ID3D11Device* pDevice = RenderAPI::Get()->GetDevice();
+		HRESULT result = pDevice->CreateTexture2D(&textureDesc, &data, &m_pFontAtlas);
+		RS_D311_ASSERT_CHECK(result, "Failed to create the debug font atlas!");
+		result = pDevice->CreateShaderResourceView(m_pFontAtlas, nullptr, &m_pFontAtlasSRV);
+		RS_D311_ASSERT_CHECK(result, "Failed to create the view of the debug font atlas!");
+
+		D3D11_SAMPLER_DESC samplerDesc = {};
+		samplerDesc.Filter			= D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+		samplerDesc.AddressU		= D3D11_TEXTURE_ADDRESS_CLAMP;
+		samplerDesc.AddressV		= D3D11_TEXTURE_ADDRESS_CLAMP;
+		samplerDesc.AddressW		= D3D11_TEXTURE_ADDRESS_CLAMP;
+		samplerDesc.ComparisonFunc	= D3D11_COMPARISON_NEVER;
+		samplerDesc.MaxLOD			= D3D11_FLOAT32_MAX;
+		result = pDevice->CreateSamplerState(&samplerDesc, &m_pFontSampler);
+		RS_D311_ASSERT_CHECK(result, "Failed to create the sampler of the debug font!");
+	}
+	else
+	{
+		m_Font.InitMonospace(0.5f * 32.f, 32.f);
 	}
 
 	{
@@ -65,29 +223,61 @@ void DebugRenderer::Init()
 	{
 		Shader::Descriptor shaderDesc;
 		shaderDesc.Fragment		= "DebugRenderer/Frag.hlsl";
-		shaderDesc.Vertex		= "DebugRenderer/GVert.hlsl";
-		shaderDesc.Geometry		= "DebugRenderer/Geom.hlsl";
+		shaderDesc.Vertex		= "DebugRenderer/PointVert.hlsl";
 		AttributeLayout layout;
-		layout.Push(DXGI_FORMAT_R32G32B32_FLOAT, "POSITION", 0);
-		layout.Push(DXGI_FORMAT_R32G32B32_FLOAT, "COLOR", 0);
+		layout.Push(DXGI_FORMAT_R32G32_FLOAT, "POSITION", 0);
 		m_PointShader.Load(shaderDesc, layout);
 		ShaderHotReloader::AddShader(&m_PointShader);
 	}
-}
 
-void DebugRenderer::Release()
-{
-	if (m_pLinesVertexBuffer)
 	{
-		m_pLinesVertexBuffer->Release();
-		m_pLinesVertexBuffer = nullptr;
+		Shader::Descriptor shaderDesc;
+		shaderDesc.Fragment		= "DebugRenderer/Frag.hlsl";
+		shaderDesc.Vertex		= "DebugRenderer/ShapeVert.hlsl";
+		AttributeLayout layout;
+		layout.Push(DXGI_FORMAT_R32G32_FLOAT, "POSITION", 0);
+		m_ShapeShader.Load(shaderDesc, layout);
+		ShaderHotReloader::AddShader(&m_ShapeShader);
 	}
 
-	if (m_pPointsVertexBuffer)
 	{
-		m_pPointsVertexBuffer->Release();
-		m_pPointsVertexBuffer = nullptr;
+		Shader::Descriptor shaderDesc;
+		shaderDesc.Fragment		= "DebugRenderer/TextFrag.hlsl";
+		shaderDesc.Vertex		= "DebugRenderer/TextVert.hlsl";
+		AttributeLayout layout;
+		layout.Push(DXGI_FORMAT_R32G32_FLOAT, "POSITION", 0);
+		m_TextShader.Load(shaderDesc, layout);
+		ShaderHotReloader::AddShader(&m_TextShader);
+	}
+
+	{
+		Shader::Descriptor shaderDesc;
+		shaderDesc.Fragment		= "DebugRenderer/Frag.hlsl";
+		shaderDesc.Vertex		= "DebugRenderer/MeshVert.hlsl";
+		AttributeLayout layout;
+		layout.Push(DXGI_FORMAT_R32G32B32_FLOAT, "POSITION", 0);
+		m_MeshShader.Load(shaderDesc, layout);
+		ShaderHotReloader::AddShader(&m_MeshShader);
 	}
+}
+
+DebugRenderer::DebugRenderer()
+{
+	// Text which is pushed before Init is laid out the same as when the font cannot be loaded.
+	m_Font.InitMonospace(0.5f * 32.f, 32.f);
+}
+
+DebugRenderer::~DebugRenderer()
+{
+	// The recorders of the threads which are still alive must not submit to a destroyed renderer.
+	DropThreadCommands();
+}
+
+void DebugRenderer::Release()
+{
+	ForEachBuffer([](auto& buffer) { buffer.Release(); });
+	m_ExpiryTicks.clear();
+	DropThreadCommands();
 
 	if (m_pVPBuffer)
 	{
@@ -95,20 +285,50 @@ void DebugRenderer::Release()
 		m_pVPBuffer = nullptr;
 	}
 
-	if (m_pViewBuffer)
+	if (m_pShapeBuffer)
+	{
+		m_pShapeBuffer->Release();
+		m_pShapeBuffer = nullptr;
+	}
+
+	if (m_pTextBuffer)
+	{
+		m_pTextBuffer->Release();
+		m_pTextBuffer = nullptr;
+	}
+
+	if (m_pFontSampler)
+	{
+		m_pFontSampler->Release();
+		m_pFontSampler = nullptr;
+	}
+
+	if (m_pFontAtlasSRV)
 	{
-		m_pViewBuffer->Release();
-		m_pViewBuffer = nullptr;
+		m_pFontAtlasSRV->Release();
+		m_pFontAtlasSRV = nullptr;
 	}
 
-	if (m_pGeomBuffer)
+	if (m_pFontAtlas)
 	{
-		m_pGeomBuffer->Release();
-		m_pGeomBuffer = nullptr;
+		m_pFontAtlas->Release();
+		m_pFontAtlas = nullptr;
 	}
 
+	if (m_pWireframeBuffer)
+	{
+		m_pWireframeBuffer->Release();
+		m_pWireframeBuffer = nullptr;
+	}
+	m_NumWireframeVertices = 0u;
+	m_WireframeVersion = 0u;
+	m_Wireframes.Clear();
+
 	m_LineShader.Release();
 	m_PointShader.Release();
+	m_ShapeShader.Release();
+	m_TextShader.Release();
+	m_MeshShader.Release();
 	m_Pipeline.Release();
 
 	m_IsCameraSet = false;
@@ -118,55 +338,65 @@ void DebugRenderer::UpdateCamera(const glm::mat4& view, const glm::mat4& proj)
 {
 	m_IsCameraSet = true;
 
-	glm::mat4 data = proj * view;
+	// The size of the screen is used to give the points and the glyphs their size in pixels.
+	FrameData data;
+	data.ViewProj		= proj * view;
+	data.InvScreenSize	= 1.f / glm::vec2((float)Display::Get()->GetWidth(), (float)Display::Get()->GetHeight());
+
 	auto context = RenderAPI::Get()->GetDeviceContext();
 	D3D11_MAPPED_SUBRESOURCE resource;
-
-	// Proj * View
 	context->Map(m_pVPBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &resource);
-	memcpy(resource.pData, &data, sizeof(glm::mat4));
+	memcpy(resource.pData, &data, sizeof(FrameData));
 	context->Unmap(m_pVPBuffer, 0);
+}
+
+void DebugRenderer::NewFrame(float dt)
+{
+	m_Time += (double)dt;
 
-	// View
-	context->Map(m_pViewBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &resource);
-	memcpy(resource.pData, &view, sizeof(glm::mat4));
-	context->Unmap(m_pViewBuffer, 0);
+	// The primitives of one frame have been drawn, their group keeps its range for the next frame.
+	Clear(s_OneFrameID);
 
-	// Geometry Frame data
-	float w = (float)Display::Get()->GetWidth();
-	m_GeomFrameData.PointSize = 50.f/w; // 50 pixels in width.
-	m_GeomFrameData.Proj = proj;
-	context->Map(m_pGeomBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &resource);
-	memcpy(resource.pData, &m_GeomFrameData, sizeof(GFrameData));
-	context->Unmap(m_pGeomBuffer, 0);
+	// Remove each group which has expired, the primitives in it are not visited.
+	uint32 numExpired = 0;
+	uint64 tick = (uint64)(m_Time * TIMED_BUCKETS_PER_SECOND);
+	while (m_ExpiryTicks.empty() == false && *m_ExpiryTicks.begin() <= tick)
+	{
+		uint32 bucketID = s_TimedIDBase | (uint32)(*m_ExpiryTicks.begin() & ~s_TimedIDBase);
+		ForEachBuffer([&](auto& buffer)
+		{
+			auto it = buffer.Groups.find(bucketID);
+			if (it != buffer.Groups.end())
+				numExpired += (uint32)it->second.Elements.size();
+			buffer.RemoveGroup(bucketID);
+		});
+		m_ExpiryTicks.erase(m_ExpiryTicks.begin());
+	}
+	m_Stats.NumberOfExpiredVertices	= numExpired;
+	m_Stats.NumberOfTimedBuckets	= (uint32)m_ExpiryTicks.size();
 }
 
-uint32 DebugRenderer::PushLine(const glm::vec3& p1, const glm::vec3& p2, const Color& color, uint32 id, bool shouldClear)
+uint32 DebugRenderer::PushLine(const glm::vec3& p1, const glm::vec3& p2, const Color& color, uint32 id, bool shouldClear, float lifetime)
 {
-	uint32 newID = ProcessID(id, Type::LINES);
-	DataPoints& lines = m_IDLinesMap[newID];
-	if(ShouldClearLines(newID, shouldClear))
-		lines.m_Vertices.clear();
+	uint32 newID = 0;
+	PushTarget<Vertex> lines = BeginPush(m_Lines, Type::LINES, id, shouldClear, lifetime, newID);
 
 	Vertex v;
 	v.Position = p1;
 	v.Color = color;
-	lines.m_Vertices.push_back(v);
+	lines.Elements.push_back(v);
 	v.Position = p2;
-	lines.m_Vertices.push_back(v);
-	lines.ID = newID;
+	lines.Elements.push_back(v);
 
-	m_ShouldBakeLines = true;
+	EndPush(m_Lines, lines);
 
 	return newID;
 }
 
-uint32 DebugRenderer::PushLines(const std::vector<glm::vec3>& points, const Color& color, uint32 id, bool shouldClear)
+uint32 DebugRenderer::PushLines(const std::vector<glm::vec3>& points, const Color& color, uint32 id, bool shouldClear, float lifetime)
 {
-	uint32 newID = ProcessID(id, Type::LINES);
-	DataPoints& lines = m_IDLinesMap[newID];
-	if (ShouldClearLines(newID, shouldClear))
-		lines.m_Vertices.clear();
+	uint32 newID = 0;
+	PushTarget<Vertex> lines = BeginPush(m_Lines, Type::LINES, id, shouldClear, lifetime, newID);
 
 	for (uint32 i = 1; i < points.size(); i++)
 	{
@@ -174,150 +404,238 @@ uint32 DebugRenderer::PushLines(const std::vector<glm::vec3>& points, const Colo
 		Vertex v;
 		v.Position = point1;
 		v.Color = color;
-		lines.m_Vertices.push_back(v);
+		lines.Elements.push_back(v);
 
 		glm::vec3 point2 = points[i];
 		v.Position = point2;
-		lines.m_Vertices.push_back(v);
+		lines.Elements.push_back(v);
 	}
 
-	m_ShouldBakeLines = true;
+	EndPush(m_Lines, lines);
 
 	return newID;
 }
 
-uint32 DebugRenderer::PushBox(const glm::vec3& min, const glm::vec3& max, const Color& color, uint32 id, bool shouldClear)
+uint32 DebugRenderer::PushMesh(const ModelResource* pModel, const Color& color, glm::vec3 offset, uint32 id, bool shouldClear, float lifetime)
+{
+	return PushMesh(pModel, glm::translate(offset), color, id, shouldClear, lifetime);
+}
+
+uint32 DebugRenderer::PushMesh(const ModelResource* pModel, const glm::mat4& transform, const Color& color, uint32 id, bool shouldClear, float lifetime)
 {
-	uint32 newID = ProcessID(id, Type::LINES);
+	uint32 newID = 0;
+	PushTarget<MeshInstance> meshes = BeginPush(m_Meshes, Type::MESHES, id, shouldClear, lifetime, newID);
 
-	std::vector<glm::vec3> points;
-	points.push_back(glm::vec3(min.x, min.y, min.z));
-	points.push_back(glm::vec3(min.x, min.y, max.z));
-	points.push_back(glm::vec3(min.x, max.y, max.z));
-	points.push_back(glm::vec3(min.x, max.y, min.z));
-	points.push_back(glm::vec3(min.x, min.y, min.z));
-	PushLines(points, color, newID, shouldClear);
-	points.clear();
-	points.push_back(glm::vec3(max.x, min.y, min.z));
-	points.push_back(glm::vec3(max.x, min.y, max.z));
-	points.push_back(glm::vec3(max.x, max.y, max.z));
-	points.push_back(glm::vec3(max.x, max.y, min.z));
-	points.push_back(glm::vec3(max.x, min.y, min.z));
-	PushLines(points, color, newID, false);
+	PushMeshInternal(pModel, PackColor(color), transform, meshes.Elements);
 
-	PushLine(glm::vec3(min.x, min.y, min.z), glm::vec3(max.x, min.y, min.z), color, newID, false);
-	PushLine(glm::vec3(min.x, min.y, max.z), glm::vec3(max.x, min.y, max.z), color, newID, false);
-	PushLine(glm::vec3(min.x, max.y, max.z), glm::vec3(max.x, max.y, max.z), color, newID, false);
-	PushLine(glm::vec3(min.x, max.y, min.z), glm::vec3(max.x, max.y, min.z), color, newID, false);
-	PushLine(glm::vec3(min.x, min.y, min.z), glm::vec3(max.x, min.y, min.z), color, newID, false);
+	EndPush(m_Meshes, meshes);
 
 	return newID;
 }
 
-uint32 DebugRenderer::PushBox(const AABB& box, const Color& color, uint32 id, bool shouldClear)
+void DebugRenderer::RemoveMesh(const ModelResource* pModel)
 {
-	return PushBox(box.min, box.max, color, id, shouldClear);
+	for (const MeshObject& mesh : pModel->Meshes)
+		m_Wireframes.Remove(mesh);
+
+	for (const ModelResource& child : pModel->Children)
+		RemoveMesh(&child);
 }
 
-uint32 DebugRenderer::PushMesh(ModelResource* pModel, const Color& color, glm::vec3 offset, uint32 id, bool shouldClear)
+uint32 DebugRenderer::PushPoint(const glm::vec3& p, const Color& color, uint32 id, bool shouldClear, float lifetime, float size)
 {
-	uint32 newID = ProcessID(id, Type::LINES);
+	uint32 newID = 0;
+	PushTarget<Point> points = BeginPush(m_Points, Type::POINTS, id, shouldClear, lifetime, newID);
+
+	Point point;
+	point.Position = p;
+	point.ColorAndSize = PackPoint(color, size);
+	points.Elements.push_back(point);
 
-	glm::mat4 transform = glm::translate(offset);
-	PushMeshInternal(pModel, color, newID, shouldClear, transform);
+	EndPush(m_Points, points);
 
 	return newID;
 }
 
-uint32 DebugRenderer::PushPoint(const glm::vec3& p, const Color& color, uint32 id, bool shouldClear)
+uint32 DebugRenderer::PushPoints(const std::vector<glm::vec3>& points, const Color& color, uint32 id, bool shouldClear, float lifetime, float size)
 {
-	uint32 newID = ProcessID(id, Type::POINTS);
-	DataPoints& points = m_IDPointsMap[newID];
-	if (ShouldClearPoints(newID, shouldClear))
-		points.m_Vertices.clear();
+	uint32 newID = 0;
+	PushTarget<Point> pointsData = BeginPush(m_Points, Type::POINTS, id, shouldClear, lifetime, newID);
 
-	Vertex v;
-	v.Position = p;
-	v.Color = color;
-	points.m_Vertices.push_back(v);
-	points.ID = newID;
+	Point point;
+	point.ColorAndSize = PackPoint(color, size);
+	pointsData.Elements.reserve(pointsData.Elements.size() + points.size());
+	for (uint32 i = 0; i < points.size(); i++)
+	{
+		point.Position = points[i];
+		pointsData.Elements.push_back(point);
+	}
 
-	m_ShouldBakePoints = true;
+	EndPush(m_Points, pointsData);
 
 	return newID;
 }
 
-uint32 DebugRenderer::PushPoints(const std::vector<glm::vec3>& points, const Color& color, uint32 id, bool shouldClear)
+uint32 DebugRenderer::PushBox(const glm::vec3& min, const glm::vec3& max, const Color& color, uint32 id, bool shouldClear, float lifetime)
 {
-	uint32 newID = ProcessID(id, Type::POINTS);
-	DataPoints& pointsData = m_IDPointsMap[newID];
-	if (ShouldClearPoints(newID, shouldClear))
-		pointsData.m_Vertices.clear();
+	glm::mat4 transform = glm::translate((min + max) * 0.5f) * glm::scale((max - min) * 0.5f);
+	return PushShape(m_Boxes, Type::BOXES, transform, color, id, shouldClear, lifetime);
+}
 
-	for (uint32 i = 0; i < points.size(); i++)
+uint32 DebugRenderer::PushBox(const AABB& box, const Color& color, uint32 id, bool shouldClear, float lifetime)
+{
+	return PushBox(box.min, box.max, color, id, shouldClear, lifetime);
+}
+
+uint32 DebugRenderer::PushBoxes(std::span<const AABB> boxes, const Color& color, uint32 id, bool shouldClear, float lifetime)
+{
+	uint32 newID = 0;
+	PushTarget<ShapeInstance> shapes = BeginPush(m_Boxes, Type::BOXES, id, shouldClear, lifetime, newID);
+
+	ShapeInstance shape;
+	shape.Transform = glm::mat4(1.f);
+	shape.Color = PackColor(color);
+	shapes.Elements.reserve(shapes.Elements.size() + boxes.size());
+	for (const AABB& box : boxes)
 	{
-		Vertex v;
-		v.Position = points[i];
-		v.Color = color;
-		pointsData.m_Vertices.push_back(v);
+		// Only the scale and the translation of the transform differ between the boxes.
+		glm::vec3 center = (box.min + box.max) * 0.5f;
+		glm::vec3 halfSize = (box.max - box.min) * 0.5f;
+		shape.Transform[0][0] = halfSize.x;
+		shape.Transform[1][1] = halfSize.y;
+		shape.Transform[2][2] = halfSize.z;
+		shape.Transform[3] = glm::vec4(center, 1.f);
+		shapes.Elements.push_back(shape);
 	}
 
-	m_ShouldBakePoints = true;
+	EndPush(m_Boxes, shapes);
 
 	return newID;
 }
 
+uint32 DebugRenderer::PushOBB(const glm::mat4& transform, const glm::vec3& halfExtents, const Color& color, uint32 id, bool shouldClear, float lifetime)
+{
+	return PushShape(m_Boxes, Type::BOXES, transform * glm::scale(halfExtents), color, id, shouldClear, lifetime);
+}
+
+uint32 DebugRenderer::PushSphere(const glm::vec3& center, float radius, const Color& color, uint32 id, bool shouldClear, float lifetime)
+{
+	glm::mat4 transform = glm::translate(center) * glm::scale(glm::vec3(radius));
+	return PushShape(m_Spheres, Type::SPHERES, transform, color, id, shouldClear, lifetime);
+}
+
+uint32 DebugRenderer::PushFrustum(const glm::mat4& viewProj, const Color& color, uint32 id, bool shouldClear, float lifetime)
+{
+	// The unit box goes from -1 to 1 in z, the depth of the frustum from 0 to 1.
+	glm::mat4 transform = glm::inverse(viewProj) * glm::translate(glm::vec3(0.f, 0.f, 0.5f)) * glm::scale(glm::vec3(1.f, 1.f, 0.5f));
+	return PushShape(m_Boxes, Type::BOXES, transform, color, id, shouldClear, lifetime);
+}
+
+uint32 DebugRenderer::PushAxes(const glm::mat4& transform, float size, uint32 id, bool shouldClear, float lifetime)
+{
+	return PushShape(m_Axes, Type::AXES, transform * glm::scale(glm::vec3(size)), Color::WHITE, id, shouldClear, lifetime);
+}
+
+uint32 DebugRenderer::PushText(std::string_view text, const glm::vec3& position, const Color& color, float size, float maxWidth, uint32 id, bool shouldClear, float lifetime)
+{
+	return PushTextInternal(text, position, false, color, size, maxWidth, id, shouldClear, lifetime);
+}
+
+uint32 DebugRenderer::PushScreenText(std::string_view text, const glm::vec2& position, const Color& color, float size, float maxWidth, uint32 id, bool shouldClear, float lifetime)
+{
+	return PushTextInternal(text, glm::vec3(position, 0.f), true, color, size, maxWidth, id, shouldClear, lifetime);
+}
+
 void DebugRenderer::Clear(uint32 id)
 {
-	// Clear all points and colors from the list of lines.
+	if (ThreadCommands* pCommands = GetThreadCommands())
 	{
-		auto it = m_IDLinesMap.find(id);
-		if (it != m_IDLinesMap.end())
-			it->second.m_Vertices.clear();
+		ThreadCommand& command = pCommands->Commands.emplace_back();
+		command.ID		= id;
+		command.IsClear	= true;
+		return;
 	}
 
-	// Clear all points and colors from the list of points.
+	// Clear the primitives of the id in each buffer. The groups keep their ranges in the buffers.
+	ForEachBuffer([&](auto& buffer)
 	{
-		auto it = m_IDPointsMap.find(id);
-		if (it != m_IDPointsMap.end())
-			it->second.m_Vertices.clear();
-	}
-
-	m_ShouldBakeLines = true;
-	m_ShouldBakePoints = true;
+		auto it = buffer.Groups.find(id);
+		if (it != buffer.Groups.end() && it->second.Elements.empty() == false)
+		{
+			it->second.Elements.clear();
+			buffer.IsDirty = true;
+		}
+	});
 }
 
 void DebugRenderer::Clear()
 {
-	m_IDLinesMap.clear();
-	m_IDPointsMap.clear();
-
-	m_ShouldBakeLines = true;
-	m_ShouldBakePoints = true;
+	RS_ASSERT(std::this_thread::get_id() == m_RenderThreadID, "The debug renderer can only be cleared completely from the render thread!");
+	ForEachBuffer([](auto& buffer)
+	{
+		buffer.Groups.clear();
+		buffer.End		= 0u;
+		buffer.NumFree	= 0u;
+		buffer.IsDirty	= true;
+	});
+	m_ExpiryTicks.clear();
 }
 
-void DebugRenderer::Render()
+void DebugRenderer::Update()
 {
-	if (m_ShouldBakeLines || m_ShouldBakePoints)
+	Timer timer;
+	MergeThreadCommands();
+
+	uint32 numDrawCalls = 0, numUploadedBytes = UpdateWireframeBuffer(), numBufferBytes = 0;
+	ForEachBuffer([&](auto& buffer)
 	{
-		BakeLines();
-		BakePoints();
+		buffer.Update();
+		numDrawCalls		+= (uint32)buffer.DrawRanges.size();
+		numUploadedBytes	+= buffer.UploadedBytes;
+		numBufferBytes		+= buffer.Size * buffer.ELEMENT_SIZE;
+		buffer.ShouldClearDefault = true;
+	});
+	numBufferBytes += m_NumWireframeVertices * (uint32)sizeof(glm::vec3);
+
+	// Update stats
+	m_Stats.NumberOfLineVertices	= m_Lines.NumElements;
+	m_Stats.NumberOfPoints			= m_Points.NumElements;
+	m_Stats.NumberOfShapes			= m_Boxes.NumElements + m_Spheres.NumElements + m_Axes.NumElements;
+	m_Stats.NumberOfGlyphs			= m_Text.NumElements;
+	m_Stats.NumberOfMeshes			= m_Meshes.NumElements;
+	m_Stats.NumberOfWireframeVertices	= m_NumWireframeVertices;
+	m_Stats.NumberOfIDs				= s_IDGenerator;
+	m_Stats.NumberOfDrawCalls		= numDrawCalls;
+	m_Stats.NumberOfUploadedBytes	= numUploadedBytes;
+	m_Stats.NumberOfBufferBytes		= numBufferBytes;
+	m_Stats.UpdateTimeMS			= timer.Stop().GetDeltaTimeMS();
+}
 
-		// Update stats
-		m_Stats.NumberOfLineVertices	= m_PreviousLinesBufferSize;
-		m_Stats.NumberOfPointVertices	= m_PreviousPointsBufferSize;
-		m_Stats.NumberOfIDs				= s_IDGenerator;
-	}
-	
+void DebugRenderer::Render()
+{
+	Update();
 	if (m_IsCameraSet)
 	{
 		// Only bind the raster state, use the default depth state and view. Same for the RTV
 		m_Pipeline.BindRasterState();
 
-		auto renderAPI = RenderAPI::Get();
-		ID3D11DeviceContext* pContext = renderAPI->GetDeviceContext();
-		DrawLines(pContext);
-		DrawPoints(pContext);
+		DrawLines();
+		DrawPoints();
+
+		if (m_Boxes.DrawRanges.empty() == false || m_Spheres.DrawRanges.empty() == false || m_Axes.DrawRanges.empty() == false)
+		{
+			std::shared_ptr<StateCache> stateCache = StateCache::Get();
+			m_ShapeShader.Bind();
+			stateCache->SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_LINELIST);
+			stateCache->SetConstantBuffers(ShaderTypeFlag::VERTEX, 0, 1, &m_pVPBuffer);
+			stateCache->SetConstantBuffers(ShaderTypeFlag::VERTEX, 1, 1, &m_pShapeBuffer);
+			DrawShapes(m_Boxes, Type::BOXES, s_BoxVertexCount);
+			DrawShapes(m_Spheres, Type::SPHERES, s_SphereVertexCount);
+			DrawShapes(m_Axes, Type::AXES, s_AxesVertexCount);
+		}
+
+		DrawMeshes();
+		DrawGlyphs();
 	}
 	else
 	{
@@ -325,9 +643,21 @@ void DebugRenderer::Render()
 	}
 }
 
-uint32 DebugRenderer::GenID()
+void DebugRenderer::SubmitThreadCommands(uint32 sortKey)
+{
+	if (std::this_thread::get_id() == m_RenderThreadID)
+		return;
+
+	ThreadRecorder& recorder = GetThreadRecorder();
+	if (recorder.pOwner == this)
+		recorder.Submit(sortKey);
+}
+
+uint32 DebugRenderer::GenID(bool isStatic)
 {
-	return ++s_IDGenerator;
+	uint32 id = ++s_IDGenerator;
+	RS_ASSERT(id < s_StaticIDFlag, "Out of debug renderer ids!");
+	return isStatic ? id | s_StaticIDFlag : id;
 }
 
 const DebugRenderer::Stats& DebugRenderer::GetStats() const
@@ -335,6 +665,19 @@ const DebugRenderer::Stats& DebugRenderer::GetStats() const
 	return m_Stats;
 }
 
+std::vector<glm::vec3> DebugRenderer::GetLinePositions(uint32 id) const
+{
+	std::vector<glm::vec3> positions;
+	auto it = m_Lines.Groups.find(id);
+	if (it != m_Lines.Groups.end())
+	{
+		positions.reserve(it->second.Elements.size());
+		for (const Vertex& vertex : it->second.Elements)
+			positions.push_back(vertex.Position);
+	}
+	return positions;
+}
+
 uint32 DebugRenderer::ProcessID(uint32 id, Type type)
 {
 	uint32 newID = id;
@@ -343,6 +686,11 @@ uint32 DebugRenderer::ProcessID(uint32 id, Type type)
 		switch (type)
 		{
 		case RS::DebugRenderer::LINES:
+		case RS::DebugRenderer::BOXES:
+		case RS::DebugRenderer::SPHERES:
+		case RS::DebugRenderer::AXES:
+		case RS::DebugRenderer::TEXT:
+		case RS::DebugRenderer::MESHES:
 			newID = s_DefaultLinesID;
 			break;
 		case RS::DebugRenderer::POINTS:
@@ -356,269 +704,381 @@ uint32 DebugRenderer::ProcessID(uint32 id, Type type)
 	return newID;
 }
 
-void DebugRenderer::DrawLines(ID3D11DeviceContext* pContext)
+uint32 DebugRenderer::PushShape(PrimitiveBuffer<ShapeInstance>& buffer, Type type, const glm::mat4& transform, const Color& color, uint32 id, bool shouldClear, float lifetime)
+{
+	uint32 newID = 0;
+	PushTarget<ShapeInstance> shapes = BeginPush(buffer, type, id, shouldClear, lifetime, newID);
+
+	ShapeInstance shape;
+	shape.Transform = transform;
+	shape.Color = PackColor(color);
+	shapes.Elements.push_back(shape);
+
+	EndPush(buffer, shapes);
+
+	return newID;
+}
+
+DebugRenderer::ThreadRecorder::~ThreadRecorder()
 {
-	if (m_pLinesVertexBuffer)
+	std::lock_guard<std::mutex> lock(s_ThreadRecorderMutex);
+	SetOwner(nullptr);
+}
+
+void DebugRenderer::ThreadRecorder::Submit(uint32 sortKey)
+{
+	if (pOwner == nullptr || pCommands == nullptr)
+		return;
+
+	// Push the buffer onto the list of the owner, Render takes the whole list at once.
+	pCommands->SortKey	= sortKey;
+	pCommands->Sequence	= pOwner->m_SubmitSequence++;
+	pCommands->pNext	= pOwner->m_pSubmittedCommands.load(std::memory_order_relaxed);
+	while (pOwner->m_pSubmittedCommands.compare_exchange_weak(pCommands->pNext, pCommands, std::memory_order_release, std::memory_order_relaxed) == false);
+	pCommands = nullptr;
+}
+
+void DebugRenderer::ThreadRecorder::SetOwner(DebugRenderer* pNewOwner)
+{
+	if (pOwner)
 	{
-		if (m_PreviousLinesBufferSize > 0)
-		{
-			m_LineShader.Bind();
-			UINT stride = sizeof(Vertex);
-			UINT offset = 0;
-			pContext->IASetVertexBuffers(0, 1, &m_pLinesVertexBuffer, &stride, &offset);
-			pContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_LINELIST);
-			pContext->VSSetConstantBuffers(0, 1, &m_pVPBuffer);
-			pContext->Draw((UINT)m_PreviousLinesBufferSize, 0);
-		}
+		Submit(UINT32_MAX);
+		std::vector<ThreadRecorder*>& recorders = pOwner->m_ThreadRecorders;
+		recorders.erase(std::remove(recorders.begin(), recorders.end(), this), recorders.end());
+	}
+
+	pOwner = pNewOwner;
+	if (pOwner)
+		pOwner->m_ThreadRecorders.push_back(this);
+}
+
+DebugRenderer::ThreadRecorder& DebugRenderer::GetThreadRecorder()
+{
+	static thread_local ThreadRecorder s_Recorder;
+	return s_Recorder;
+}
 
-		m_LinesFirstCall = true;
+DebugRenderer::ThreadCommands* DebugRenderer::GetThreadCommands()
+{
+	if (std::this_thread::get_id() == m_RenderThreadID)
+		return nullptr;
+
+	// A thread which pushes to another renderer submits what it has for the previous one first.
+	ThreadRecorder& recorder = GetThreadRecorder();
+	if (recorder.pOwner != this)
+	{
+		std::lock_guard<std::mutex> lock(s_ThreadRecorderMutex);
+		recorder.SetOwner(this);
 	}
+
+	if (recorder.pCommands == nullptr)
+		recorder.pCommands = new ThreadCommands();
+	return recorder.pCommands;
 }
 
-void DebugRenderer::DrawPoints(ID3D11DeviceContext* pContext)
+void DebugRenderer::DropThreadCommands()
 {
-	if (m_pPointsVertexBuffer)
 	{
-		if (m_PreviousPointsBufferSize > 0)
+		std::lock_guard<std::mutex> lock(s_ThreadRecorderMutex);
+		for (ThreadRecorder* pRecorder : m_ThreadRecorders)
 		{
-			m_PointShader.Bind();
-			UINT stride = sizeof(Vertex);
-			UINT offset = 0;
-			pContext->IASetVertexBuffers(0, 1, &m_pPointsVertexBuffer, &stride, &offset);
-			pContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_POINTLIST);
-			pContext->VSSetConstantBuffers(0, 1, &m_pViewBuffer);
-			pContext->GSSetConstantBuffers(0, 1, &m_pGeomBuffer);
-			pContext->Draw((UINT)m_PreviousPointsBufferSize, 0);
+			delete pRecorder->pCommands;
+			pRecorder->pCommands	= nullptr;
+			pRecorder->pOwner		= nullptr;
 		}
+		m_ThreadRecorders.clear();
+	}
 
-		m_PointsFirstCall = true;
+	// Commands which were submitted after the last Render are dropped.
+	ThreadCommands* pCommands = m_pSubmittedCommands.exchange(nullptr);
+	while (pCommands)
+	{
+		ThreadCommands* pNext = pCommands->pNext;
+		delete pCommands;
+		pCommands = pNext;
 	}
 }
 
-void DebugRenderer::BakeLines()
+void DebugRenderer::MergeThreadCommands()
 {
-	if (m_ShouldBakeLines)
+	std::vector<ThreadCommands*> submitted;
+	for (ThreadCommands* pCommands = m_pSubmittedCommands.exchange(nullptr, std::memory_order_acquire); pCommands; pCommands = pCommands->pNext)
+		submitted.push_back(pCommands);
+
+	std::sort(submitted.begin(), submitted.end(), [](const ThreadCommands* a, const ThreadCommands* b)
 	{
-		m_LinesToRender.m_Vertices.clear();
+		return a->SortKey != b->SortKey ? a->SortKey < b->SortKey : a->Sequence < b->Sequence;
+	});
 
-		for (auto it = m_IDLinesMap.begin(); it != m_IDLinesMap.end(); it++)
+	uint32 numCommands = 0;
+	for (ThreadCommands* pCommands : submitted)
+	{
+		for (const ThreadCommand& command : pCommands->Commands)
 		{
-			DataPoints& lines = it->second;
-			uint32 nPoints = (uint32)lines.m_Vertices.size();
-			for (uint32 i = 0; i < nPoints; i++)
-				m_LinesToRender.m_Vertices.push_back(lines.m_Vertices[i]);
+			if (command.IsClear)
+			{
+				Clear(command.ID);
+				continue;
+			}
+
+			switch (command.PrimitiveType)
+			{
+			case Type::LINES:	ApplyThreadCommand(m_Lines, command, pCommands->Vertices); break;
+			case Type::POINTS:	ApplyThreadCommand(m_Points, command, pCommands->Points); break;
+			case Type::BOXES:	ApplyThreadCommand(m_Boxes, command, pCommands->Shapes); break;
+			case Type::SPHERES:	ApplyThreadCommand(m_Spheres, command, pCommands->Shapes); break;
+			case Type::AXES:	ApplyThreadCommand(m_Axes, command, pCommands->Shapes); break;
+			case Type::TEXT:	ApplyThreadCommand(m_Text, command, pCommands->Glyphs); break;
+			case Type::MESHES:	ApplyThreadCommand(m_Meshes, command, pCommands->Meshes); break;
+			}
 		}
-
-		UpdateLinesDrawBuffer();
-
-		m_ShouldBakeLines = false;
+		numCommands += (uint32)pCommands->Commands.size();
+		delete pCommands;
 	}
+	m_Stats.NumberOfThreadCommands = numCommands;
 }
 
-void DebugRenderer::BakePoints()
+uint32 DebugRenderer::PushTextInternal(std::string_view text, const glm::vec3& position, bool isScreenSpace, const Color& color, float size, float maxWidth, uint32 id, bool shouldClear, float lifetime)
 {
-	if (m_ShouldBakePoints)
+	uint32 newID = 0;
+	PushTarget<GlyphInstance> glyphs = BeginPush(m_Text, Type::TEXT, id, shouldClear, lifetime, newID);
+
+	// The font is laid out at the height it was rasterized at, and scaled to the size.
+	float scale = m_Font.GetLineHeight() > 0.f ? size / m_Font.GetLineHeight() : 1.f;
+	GlyphInstance glyph;
+	glyph.Position		= position;
+	glyph.Color			= PackColor(color);
+	glyph.IsScreenSpace	= isScreenSpace ? 1u : 0u;
+	m_Font.Layout(text, maxWidth / scale, [&](const DebugFont::Quad& quad)
 	{
-		m_PointsToRender.m_Vertices.clear();
+		glyph.Offset	= quad.Min * scale;
+		glyph.Size		= (quad.Max - quad.Min) * scale;
+		glyph.AtlasMin	= (uint32)quad.pGlyph->AtlasMin[0] | ((uint32)quad.pGlyph->AtlasMin[1] << 16);
+		glyph.AtlasMax	= (uint32)quad.pGlyph->AtlasMax[0] | ((uint32)quad.pGlyph->AtlasMax[1] << 16);
+		glyphs.Elements.push_back(glyph);
+	});
 
-		for (auto it = m_IDPointsMap.begin(); it != m_IDPointsMap.end(); it++)
-		{
-			DataPoints& points = it->second;
-			uint32 nPoints = (uint32)points.m_Vertices.size();
-			for (uint32 i = 0; i < nPoints; i++)
-				m_PointsToRender.m_Vertices.push_back(points.m_Vertices[i]);
-		}
+	EndPush(m_Text, glyphs);
 
-		UpdatePointsDrawBuffer();
+	return newID;
+}
 
-		m_ShouldBakePoints = false;
+void DebugRenderer::DrawLines()
+{
+	std::shared_ptr<StateCache> stateCache = StateCache::Get();
+	if (m_Lines.pBuffer && m_Lines.DrawRanges.empty() == false)
+	{
+		m_LineShader.Bind();
+		UINT stride = sizeof(Vertex);
+		UINT offset = 0;
+		stateCache->SetVertexBuffers(0, 1, &m_Lines.pBuffer, &stride, &offset);
+		stateCache->SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_LINELIST);
+		stateCache->SetConstantBuffers(ShaderTypeFlag::VERTEX, 0, 1, &m_pVPBuffer);
+		for (const auto& range : m_Lines.DrawRanges)
+			stateCache->Draw(range.Count, range.Start);
 	}
 }
 
-void DebugRenderer::UpdateLinesDrawBuffer()
+void DebugRenderer::DrawPoints()
 {
-	if (m_pLinesVertexBuffer == nullptr)
+	std::shared_ptr<StateCache> stateCache = StateCache::Get();
+	if (m_Points.pSRV && m_Points.DrawRanges.empty() == false)
 	{
-		if (m_LinesToRender.m_Vertices.empty() == false)
-		{
-			D3D11_BUFFER_DESC bufferDesc = {};
-			bufferDesc.ByteWidth = (UINT)(sizeof(Vertex) * m_LinesToRender.m_Vertices.size());
-			bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
-			bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-			bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-			bufferDesc.MiscFlags = 0;
-			bufferDesc.StructureByteStride = 0;
-
-			D3D11_SUBRESOURCE_DATA data;
-			data.pSysMem = m_LinesToRender.m_Vertices.data();
-			data.SysMemPitch = 0;
-			data.SysMemSlicePitch = 0;
-			
-			HRESULT result = RenderAPI::Get()->GetDevice()->CreateBuffer(&bufferDesc, &data, &m_pLinesVertexBuffer);
-			RS_D311_CHECK(result, "Failed to create lines vertex buffer!");
-		}
+		// Each point is a quad of six vertices, the vertex shader reads the point of its vertex id from the buffer.
+		m_PointShader.Bind();
+		stateCache->SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+		stateCache->SetConstantBuffers(ShaderTypeFlag::VERTEX, 0, 1, &m_pVPBuffer);
+		stateCache->SetShaderResources(ShaderTypeFlag::VERTEX, 0, 1, &m_Points.pSRV);
+		for (const auto& range : m_Points.DrawRanges)
+			stateCache->Draw(range.Count * 6, range.Start * 6);
 	}
-	else
+}
+
+void DebugRenderer::DrawShapes(PrimitiveBuffer<ShapeInstance>& buffer, Type type, uint32 vertexCount)
+{
+	if (buffer.pSRV == nullptr || buffer.DrawRanges.empty())
+		return;
+
+	std::shared_ptr<StateCache> stateCache = StateCache::Get();
+	ID3D11DeviceContext* pContext = RenderAPI::Get()->GetDeviceContext();
+	stateCache->SetShaderResources(ShaderTypeFlag::VERTEX, 0, 1, &buffer.pSRV);
+	for (const auto& range : buffer.DrawRanges)
 	{
-		// Recreate the buffer if the size if too small.
-		if (m_PreviousLinesBufferSize < (uint32)m_LinesToRender.m_Vertices.size())
-		{
-			m_pLinesVertexBuffer->Release();
-
-			D3D11_BUFFER_DESC bufferDesc = {};
-			bufferDesc.ByteWidth = (UINT)(sizeof(Vertex) * m_LinesToRender.m_Vertices.size());
-			bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
-			bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-			bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-			bufferDesc.MiscFlags = 0;
-			bufferDesc.StructureByteStride = 0;
-
-			D3D11_SUBRESOURCE_DATA data;
-			data.pSysMem = m_LinesToRender.m_Vertices.data();
-			data.SysMemPitch = 0;
-			data.SysMemSlicePitch = 0;
-
-			HRESULT result = RenderAPI::Get()->GetDevice()->CreateBuffer(&bufferDesc, &data, &m_pLinesVertexBuffer);
-			RS_D311_CHECK(result, "Failed to recreate lines vertex buffer!");
-		}
+		ShapeData shapeData;
+		shapeData.FirstInstance = range.Start;
+		shapeData.ShapeType		= (uint32)(type - Type::BOXES);
 
-		auto context = RenderAPI::Get()->GetDeviceContext();
 		D3D11_MAPPED_SUBRESOURCE resource;
-		context->Map(m_pLinesVertexBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &resource);
-		size_t size = sizeof(Vertex) * m_LinesToRender.m_Vertices.size();
-		memcpy(resource.pData, m_LinesToRender.m_Vertices.data(), size);
-		context->Unmap(m_pLinesVertexBuffer, 0);
-	}
+		pContext->Map(m_pShapeBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &resource);
+		memcpy(resource.pData, &shapeData, sizeof(ShapeData));
+		pContext->Unmap(m_pShapeBuffer, 0);
 
-	m_PreviousLinesBufferSize = (uint32)m_LinesToRender.m_Vertices.size();
+		stateCache->DrawInstanced(vertexCount, range.Count, 0, 0);
+	}
 }
 
-void RS::DebugRenderer::UpdatePointsDrawBuffer()
+void DebugRenderer::DrawGlyphs()
 {
-	if (m_pPointsVertexBuffer == nullptr)
-	{
-		if (m_PointsToRender.m_Vertices.empty() == false)
-		{
-			D3D11_BUFFER_DESC bufferDesc = {};
-			bufferDesc.ByteWidth = (UINT)(sizeof(Vertex) * m_PointsToRender.m_Vertices.size());
-			bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
-			bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-			bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-			bufferDesc.MiscFlags = 0;
-			bufferDesc.StructureByteStride = 0;
-
-			D3D11_SUBRESOURCE_DATA data;
-			data.pSysMem = m_PointsToRender.m_Vertices.data();
-			data.SysMemPitch = 0;
-			data.SysMemSlicePitch = 0;
-
-			HRESULT result = RenderAPI::Get()->GetDevice()->CreateBuffer(&bufferDesc, &data, &m_pPointsVertexBuffer);
-			RS_D311_CHECK(result, "Failed to recreate points vertex buffer!");
-		}
-	}
-	else
+	if (m_Text.pSRV == nullptr || m_Text.DrawRanges.empty() || m_pFontAtlasSRV == nullptr)
+		return;
+
+	std::shared_ptr<StateCache> stateCache = StateCache::Get();
+	ID3D11DeviceContext* pContext = RenderAPI::Get()->GetDeviceContext();
+	m_TextShader.Bind();
+	stateCache->SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	stateCache->SetConstantBuffers(ShaderTypeFlag::VERTEX, 0, 1, &m_pVPBuffer);
+	stateCache->SetConstantBuffers(ShaderTypeFlag::VERTEX, 1, 1, &m_pTextBuffer);
+	stateCache->SetShaderResources(ShaderTypeFlag::VERTEX, 0, 1, &m_Text.pSRV);
+	stateCache->SetShaderResources(ShaderTypeFlag::FRAGMENT, 0, 1, &m_pFontAtlasSRV);
+	stateCache->SetSamplers(ShaderTypeFlag::FRAGMENT, 0, 1, &m_pFontSampler);
+
+	// All glyphs are one range unless the groups are spread out in the buffer.
+	for (const auto& range : m_Text.DrawRanges)
 	{
-		// Recreate the buffer if the size if too small.
-		if (m_PreviousPointsBufferSize < (uint32)m_PointsToRender.m_Vertices.size())
-		{
-			m_pPointsVertexBuffer->Release();
-
-			D3D11_BUFFER_DESC bufferDesc = {};
-			bufferDesc.ByteWidth = (UINT)(sizeof(Vertex) * m_PointsToRender.m_Vertices.size());
-			bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
-			bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-			bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-			bufferDesc.MiscFlags = 0;
-			bufferDesc.StructureByteStride = 0;
-
-			D3D11_SUBRESOURCE_DATA data;
-			data.pSysMem = m_PointsToRender.m_Vertices.data();
-			data.SysMemPitch = 0;
-			data.SysMemSlicePitch = 0;
-
-			HRESULT result = RenderAPI::Get()->GetDevice()->CreateBuffer(&bufferDesc, &data, &m_pPointsVertexBuffer);
-			RS_D311_CHECK(result, "Failed to create points vertex buffer!");
-		}
+		TextData textData;
+		textData.FirstInstance	= range.Start;
+		textData.InvAtlasSize	= 1.f / glm::vec2((float)m_Font.GetAtlasWidth(), (float)m_Font.GetAtlasHeight());
 
-		auto context = RenderAPI::Get()->GetDeviceContext();
 		D3D11_MAPPED_SUBRESOURCE resource;
-		context->Map(m_pPointsVertexBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &resource);
-		size_t size = sizeof(Vertex) * m_PointsToRender.m_Vertices.size();
-		memcpy(resource.pData, m_PointsToRender.m_Vertices.data(), size);
-		context->Unmap(m_pPointsVertexBuffer, 0);
-	}
+		pContext->Map(m_pTextBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &resource);
+		memcpy(resource.pData, &textData, sizeof(TextData));
+		pContext->Unmap(m_pTextBuffer, 0);
 
-	m_PreviousPointsBufferSize = (uint32)m_PointsToRender.m_Vertices.size();
+		stateCache->DrawInstanced(6, range.Count, 0, 0);
+	}
 }
 
-bool DebugRenderer::ShouldClearPoints(uint32 id, bool shouldClear)
+void DebugRenderer::DrawMeshes()
 {
-	bool res = shouldClear;
-	if (id == s_DefaultPointsID)
+	if (m_Meshes.pSRV == nullptr || m_Meshes.DrawRanges.empty() || m_pWireframeBuffer == nullptr)
+		return;
+
+	std::shared_ptr<StateCache> stateCache = StateCache::Get();
+	ID3D11DeviceContext* pContext = RenderAPI::Get()->GetDeviceContext();
+	m_MeshShader.Bind();
+	UINT stride = sizeof(glm::vec3);
+	UINT offset = 0;
+	stateCache->SetVertexBuffers(0, 1, &m_pWireframeBuffer, &stride, &offset);
+	stateCache->SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_LINELIST);
+	stateCache->SetConstantBuffers(ShaderTypeFlag::VERTEX, 0, 1, &m_pVPBuffer);
+	stateCache->SetConstantBuffers(ShaderTypeFlag::VERTEX, 1, 1, &m_pShapeBuffer);
+	stateCache->SetShaderResources(ShaderTypeFlag::VERTEX, 0, 1, &m_Meshes.pSRV);
+
+	// The lines of a mesh are drawn once for each instance, instances of the same mesh which are next to each other are one draw call.
+	for (auto& [id, group] : m_Meshes.Groups)
 	{
-		if (m_PointsFirstCall)
+		uint32 count = (uint32)group.Elements.size();
+		for (uint32 first = 0, last = 0; first < count; first = last)
 		{
-			res = true;
-			m_PointsFirstCall = false;
-		}
-		else
-		{
-			res = false;
+			const MeshInstance& instance = group.Elements[first];
+			for (last = first + 1; last < count && group.Elements[last].WireframeID == instance.WireframeID; last++);
+			const DebugWireframe::Range lines = m_Wireframes.GetRange(instance.WireframeID);
+			if (lines.NumVertices == 0 || lines.FirstVertex + lines.NumVertices > m_NumWireframeVertices)
+				continue;
+
+			ShapeData shapeData;
+			shapeData.FirstInstance = group.Offset + first;
+
+			D3D11_MAPPED_SUBRESOURCE resource;
+			pContext->Map(m_pShapeBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &resource);
+			memcpy(resource.pData, &shapeData, sizeof(ShapeData));
+			pContext->Unmap(m_pShapeBuffer, 0);
+
+			stateCache->DrawInstanced(lines.NumVertices, last - first, lines.FirstVertex, 0);
 		}
 	}
-	
-	return res;
 }
 
-bool RS::DebugRenderer::ShouldClearLines(uint32 id, bool shouldClear)
+uint32 DebugRenderer::UpdateWireframeBuffer()
 {
-	bool res = shouldClear;
-	if (id == s_DefaultLinesID)
+	// The meshes which are drawn in this frame are kept, the others can be forgotten if the wireframes are over their budget.
+	std::vector<uint32> drawnIDs;
+	for (const auto& [id, group] : m_Meshes.Groups)
 	{
-		if (m_LinesFirstCall)
-		{
-			res = true;
-			m_LinesFirstCall = false;
-		}
-		else
+		for (const MeshInstance& instance : group.Elements)
 		{
-			res = false;
+			if (drawnIDs.empty() || drawnIDs.back() != instance.WireframeID)
+				drawnIDs.push_back(instance.WireframeID);
 		}
 	}
+	std::sort(drawnIDs.begin(), drawnIDs.end());
+	drawnIDs.erase(std::unique(drawnIDs.begin(), drawnIDs.end()), drawnIDs.end());
+	m_Wireframes.Trim(drawnIDs);
+	if (m_Wireframes.GetVersion() == m_WireframeVersion)
+		return 0u;
+
+	// The list only changes when meshes are added or it is compacted, so the buffer is made again with all of it instead of leaving room to grow.
+	std::vector<glm::vec3> vertices;
+	const uint32 version = m_Wireframes.CopyVertices(vertices);
+
+	if (m_pWireframeBuffer)
+	{
+		m_pWireframeBuffer->Release();
+		m_pWireframeBuffer = nullptr;
+	}
+	m_NumWireframeVertices = 0u;
+	if (vertices.empty())
+	{
+		m_WireframeVersion = version;
+		return 0u;
+	}
+
+	D3D11_BUFFER_DESC bufferDesc = {};
+	bufferDesc.ByteWidth = (UINT)(sizeof(glm::vec3) * vertices.size());
+	bufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
+	bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+	bufferDesc.CPUAccessFlags = 0;
+	bufferDesc.MiscFlags = 0;
+	bufferDesc.StructureByteStride = 0;
+
+	D3D11_SUBRESOURCE_DATA data = {};
+	data.pSysMem = vertices.data();
+
+	HRESULT result = RenderAPI::Get()->GetDevice()->CreateBuffer(&bufferDesc, &data, &m_pWireframeBuffer);
+	RS_D311_CHECK(result, "Failed to create the debug wireframe buffer!");
+	if (FAILED(result))
+	{
+		m_pWireframeBuffer = nullptr;
+		return 0u;
+	}
+
+	m_NumWireframeVertices = (uint32)vertices.size();
+	m_WireframeVersion = version;
+	return bufferDesc.ByteWidth;
+}
 
-	return res;
+uint32 DebugRenderer::PackColor(const Color& color)
+{
+	uint32 r = (uint32)(glm::clamp(color.r, 0.f, 1.f) * 255.f + 0.5f);
+	uint32 g = (uint32)(glm::clamp(color.g, 0.f, 1.f) * 255.f + 0.5f);
+	uint32 b = (uint32)(glm::clamp(color.b, 0.f, 1.f) * 255.f + 0.5f);
+	return r | (g << 8) | (b << 16) | (255u << 24);
 }
 
-void DebugRenderer::PushMeshInternal(ModelResource* model, const Color& color, uint32 id, bool shouldClear, const glm::mat4& accTransform)
+uint32 DebugRenderer::PackPoint(const Color& color, float size)
 {
-	glm::mat4 transform(1.f);
-	std::vector<glm::vec3> points;
-	points.resize(4);
-	transform = model->Transform * accTransform;
-	for (MeshObject& mesh : model->Meshes)
+	uint32 pixels = (uint32)(glm::clamp(size, 1.f, 255.f) + 0.5f);
+	return (PackColor(color) & 0x00FFFFFFu) | (pixels << 24);
+}
+
+void DebugRenderer::PushMeshInternal(const ModelResource* pModel, uint32 color, const glm::mat4& accTransform, std::vector<MeshInstance>& instances)
+{
+	// The transform of a model is relative to its parent.
+	glm::mat4 transform = accTransform * pModel->Transform;
+	for (const MeshObject& mesh : pModel->Meshes)
 	{
-		for (uint32 i = 0; i < mesh.Indices.size(); i += 3)
-		{
-			MeshObject::Vertex v = mesh.Vertices[mesh.Indices[i]];
-			glm::vec4 transformedPos = glm::vec4(v.Position, 1.f);
-			transformedPos = transformedPos * transform;
-			points[0] = (glm::vec3)transformedPos;
-
-			v = mesh.Vertices[mesh.Indices[(size_t)i + 1]];
-			transformedPos = glm::vec4(v.Position, 1.f);
-			transformedPos = transformedPos * transform;
-			points[1] = (glm::vec3)transformedPos;
-
-			v = mesh.Vertices[mesh.Indices[(size_t)i + 2]];
-			transformedPos = glm::vec4(v.Position, 1.f);
-			transformedPos = transformedPos * transform;
-			points[2] = (glm::vec3)transformedPos;
-
-			points[3] = points[0];
-			PushLines(points, color, id, i == 0 ? shouldClear : false);
-		}
+		uint32 wireframeID = m_Wireframes.Get(mesh);
+		if (wireframeID == DebugWireframe::INVALID_ID)
+			continue;
+
+		MeshInstance instance;
+		instance.Transform		= transform;
+		instance.Color			= color;
+		instance.WireframeID	= wireframeID;
+		instance._Padding		= 0u;
+		instances.push_back(instance);
 	}
 
-	for (ModelResource& child : model->Children)
-		PushMeshInternal(&child, color, id, shouldClear, transform);
+	for (const ModelResource& child : pModel->Children)
+		PushMeshInternal(&child, color, transform, instances);
 }
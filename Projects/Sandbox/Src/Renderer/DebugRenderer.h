@@ -3,18 +3,20 @@
 #include "Utils/Maths.h"
 #include "Renderer/Color.h"
 
+#include "Renderer/DebugFont.h"
+#include "Renderer/DebugPrimitiveBuffer.h"
+#include "Renderer/DebugWireframe.h"
 #include "Renderer/Pipeline.h"
 #include "Renderer/Shader.h"
 
 #include "Structures/AABB.h"
 
-/*
-* TODO: Add support for static and dynamic rendering.
-*	Reason: Do not want to rebuild the vertices buffers every time one element is added.
-* TODO: Add support for timed rendering and text rendering.
-*	Timed rendering: If you only want to render a line/box etc. for a spesific time and after that time it should be removed.
-*	Text rendering: Be able to render text in different sizes and colors.
-*/
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <span>
+#include <string_view>
+#include <thread>
 
 namespace RS
 {
@@ -25,25 +27,101 @@ namespace RS
 		struct Stats
 		{
 			uint32 NumberOfLineVertices		= 0;
-			uint32 NumberOfPointVertices	= 0;
+			uint32 NumberOfPoints			= 0;
+			uint32 NumberOfShapes			= 0;
+			uint32 NumberOfGlyphs			= 0;
+			uint32 NumberOfMeshes			= 0;
+			uint32 NumberOfWireframeVertices	= 0; // The edges of the meshes which have been pushed and are not forgotten, uploaded when they change.
 			uint32 NumberOfIDs				= 0;
+			uint32 NumberOfDrawCalls		= 0;
+			uint32 NumberOfUploadedBytes	= 0; // Uploaded in the last frame.
+			uint32 NumberOfBufferBytes		= 0; // Size of the vertex, instance and wireframe buffers.
+			float UpdateTimeMS				= 0.f;
+			uint32 NumberOfTimedBuckets		= 0;
+			uint32 NumberOfExpiredVertices	= 0; // Vertices and shapes removed in the last frame.
+			uint32 NumberOfThreadCommands	= 0; // Pushes from other threads merged in the last frame.
 		};
 
+		/*
+		* The lifetime of pushed primitives, a positive lifetime is in seconds.
+		* Primitives with a lifetime are not part of an id, the id and shouldClear are not used and zero is returned.
+		* They are removed in the first NewFrame after the time has passed, which can be up to 1/TIMED_BUCKETS_PER_SECOND seconds later.
+		*/
+		static constexpr float LIFETIME_PERSISTENT	= -1.f; // Kept until the id is cleared.
+		static constexpr float LIFETIME_ONE_FRAME	= 0.f;	// Drawn in the next Render only.
+		static const uint32 TIMED_BUCKETS_PER_SECOND	= 16u;
+
+		// The width of a point in pixels, from 1 to 255.
+		static constexpr float POINT_SIZE			= 10.f;
+
 	public:
 		static std::shared_ptr<DebugRenderer> Get();
 
+		DebugRenderer();
+		~DebugRenderer();
+
 		void Init();
+
+		/*
+		* Release the GPU objects and drop the commands of the other threads which were not rendered yet.
+		* The threads which pushed to this renderer are detached from it, and no other thread may push while it is released or destroyed.
+		*/
 		void Release();
 
 		void UpdateCamera(const glm::mat4& view, const glm::mat4& proj);
 
-		uint32 PushLine(const glm::vec3& p1, const glm::vec3& p2, const Color& color = Color::RED, uint32 id = 0, bool shouldClear = true);
-		uint32 PushLines(const std::vector<glm::vec3>& points, const Color& color = Color::RED, uint32 id = 0, bool shouldClear = true);
-		uint32 PushBox(const glm::vec3& min, const glm::vec3& max, const Color& color = Color::RED, uint32 id = 0, bool shouldClear = true);
-		uint32 PushBox(const AABB& box, const Color& color = Color::RED, uint32 id = 0, bool shouldClear = true);
-		uint32 PushMesh(ModelResource* pModel, const Color& color = Color::RED, glm::vec3 offset = glm::vec3(0.f), uint32 id = 0, bool shouldClear = true);
-		uint32 PushPoint(const glm::vec3& p, const Color& color = Color::RED, uint32 id = 0, bool shouldClear = true);
-		uint32 PushPoints(const std::vector<glm::vec3>& points, const Color& color = Color::RED, uint32 id = 0, bool shouldClear = true);
+		/*
+		* Advance the time of the timed primitives, remove the expired ones and the ones which were pushed for one frame.
+		*/
+		void NewFrame(float dt);
+
+		/*
+		* Push* and Clear(id) can be called from any thread. Calls from a thread other than the one which called Init are recorded
+		* into a command buffer of that thread, without locks, and are applied in the next Render after the buffer is submitted.
+		* The other functions have to be called from the render thread.
+		*/
+		uint32 PushLine(const glm::vec3& p1, const glm::vec3& p2, const Color& color = Color::RED, uint32 id = 0, bool shouldClear = true, float lifetime = LIFETIME_PERSISTENT);
+		uint32 PushLines(const std::vector<glm::vec3>& points, const Color& color = Color::RED, uint32 id = 0, bool shouldClear = true, float lifetime = LIFETIME_PERSISTENT);
+		uint32 PushPoint(const glm::vec3& p, const Color& color = Color::RED, uint32 id = 0, bool shouldClear = true, float lifetime = LIFETIME_PERSISTENT, float size = POINT_SIZE);
+		uint32 PushPoints(const std::vector<glm::vec3>& points, const Color& color = Color::RED, uint32 id = 0, bool shouldClear = true, float lifetime = LIFETIME_PERSISTENT, float size = POINT_SIZE);
+
+		/*
+		* Shapes are stored as one transform and color each, and are drawn as instances of a unit shape with one draw call for each type of shape.
+		*/
+		uint32 PushBox(const glm::vec3& min, const glm::vec3& max, const Color& color = Color::RED, uint32 id = 0, bool shouldClear = true, float lifetime = LIFETIME_PERSISTENT);
+		uint32 PushBox(const AABB& box, const Color& color = Color::RED, uint32 id = 0, bool shouldClear = true, float lifetime = LIFETIME_PERSISTENT);
+		uint32 PushBoxes(std::span<const AABB> boxes, const Color& color = Color::RED, uint32 id = 0, bool shouldClear = true, float lifetime = LIFETIME_PERSISTENT);
+		// The box from -halfExtents to halfExtents, transformed by the transform.
+		uint32 PushOBB(const glm::mat4& transform, const glm::vec3& halfExtents, const Color& color = Color::RED, uint32 id = 0, bool shouldClear = true, float lifetime = LIFETIME_PERSISTENT);
+		uint32 PushSphere(const glm::vec3& center, float radius, const Color& color = Color::RED, uint32 id = 0, bool shouldClear = true, float lifetime = LIFETIME_PERSISTENT);
+		// The frustum of a camera with the depth range [0, 1], such as Camera::GetProj() * Camera::GetView().
+		uint32 PushFrustum(const glm::mat4& viewProj, const Color& color = Color::RED, uint32 id = 0, bool shouldClear = true, float lifetime = LIFETIME_PERSISTENT);
+		// The x, y and z axes of the transform in red, green and blue.
+		uint32 PushAxes(const glm::mat4& transform, float size = 1.f, uint32 id = 0, bool shouldClear = true, float lifetime = LIFETIME_PERSISTENT);
+
+		/*
+		* The unique edges of each mesh of the model and its children, with the transforms of the hierarchy.
+		* The edges of a mesh are found the first time it is pushed and are kept on the GPU, each push only adds one transform and color for each mesh.
+		* The model has to be loaded without LOADER_FLAG_NO_MESH_DATA_IN_RAM. The edges are kept under DebugRenderer/MaxWireframeVertices, the meshes which were
+		* drawn least recently are forgotten first and their pushes are not drawn anymore.
+		*/
+		uint32 PushMesh(const ModelResource* pModel, const Color& color = Color::RED, glm::vec3 offset = glm::vec3(0.f), uint32 id = 0, bool shouldClear = true, float lifetime = LIFETIME_PERSISTENT);
+		uint32 PushMesh(const ModelResource* pModel, const glm::mat4& transform, const Color& color = Color::RED, uint32 id = 0, bool shouldClear = true, float lifetime = LIFETIME_PERSISTENT);
+
+		/*
+		* Forget the edges of the meshes of a model which is freed, the ResourceManager calls this when it frees a model. This can be called from any thread.
+		*/
+		void RemoveMesh(const ModelResource* pModel);
+
+		/*
+		* Text is laid out with the debug font when it is pushed, each glyph is an instance of a quad and all text is drawn with one call.
+		* size: The height of a line in pixels.
+		* maxWidth: The lines are wrapped at spaces to fit in the width in pixels, zero does not wrap.
+		*/
+		// The top left of the text is at the world position, and the text faces the screen.
+		uint32 PushText(std::string_view text, const glm::vec3& position, const Color& color = Color::WHITE, float size = 16.f, float maxWidth = 0.f, uint32 id = 0, bool shouldClear = true, float lifetime = LIFETIME_PERSISTENT);
+		// The position is in pixels from the top left corner of the screen.
+		uint32 PushScreenText(std::string_view text, const glm::vec2& position, const Color& color = Color::WHITE, float size = 16.f, float maxWidth = 0.f, uint32 id = 0, bool shouldClear = true, float lifetime = LIFETIME_PERSISTENT);
 
 		/*
 		* Clear the data for a specific id.
@@ -55,12 +133,35 @@ namespace RS
 		*/
 		void Clear();
 
+		/*
+		* Apply the pushes of the other threads, upload the primitives which changed and update the stats. Render calls this before it draws.
+		*/
+		void Update();
+
 		void Render();
 
-		uint32 GenID();
+		/*
+		* Hand the commands this thread recorded to the renderer, they are applied in the next Render.
+		* The buffers of the threads are applied in the order of their sort key, give each job its own key, such as its index, for the same output on each run.
+		* Buffers with the same key are applied in the order they were submitted. A thread submits what is left with the key UINT32_MAX when it exits.
+		* This does nothing on the render thread.
+		*/
+		void SubmitThreadCommands(uint32 sortKey = UINT32_MAX);
+
+		/*
+		* Each id is a group with its own range in the vertex buffer, only the vertices which changed are uploaded.
+		* isStatic: The group is seldom changed, it gets no space to grow in. Dynamic groups get extra space, such that they can be rewritten in place.
+		* This can be called from any thread.
+		*/
+		uint32 GenID(bool isStatic = false);
 
 		const Stats& GetStats() const;
 
+		/*
+		* The positions of the line vertices of an id, in the order they are drawn. The pushes of other threads are in it after the next Update.
+		*/
+		std::vector<glm::vec3> GetLinePositions(uint32 id) const;
+
 	private:
 		struct Vertex
 		{
@@ -68,64 +169,240 @@ namespace RS
 			glm::vec3 Color;
 		};
 
-		struct DataPoints
+		// Same layout as DebugPoint in DebugRenderer/PointVert.hlsl.
+		struct Point
+		{
+			glm::vec3	Position;
+			uint32		ColorAndSize; // RGB8, and the size in pixels in the high 8 bits.
+		};
+
+		// Same layout as ShapeInstance in DebugRenderer/ShapeVert.hlsl.
+		struct ShapeInstance
 		{
-			std::vector<Vertex> m_Vertices;
-			uint32 ID = 0u;
+			glm::mat4	Transform;
+			uint32		Color; // RGBA8
 		};
 
-		struct GFrameData
+		// Same layout as MeshInstance in DebugRenderer/MeshVert.hlsl.
+		struct MeshInstance
 		{
-			glm::mat4	Proj		= glm::mat4(1.f);
-			float		PointSize	= 0.1f;
-			glm::vec3	_Padding	= glm::vec3(0.f);
+			glm::mat4	Transform;
+			uint32		Color;			// RGBA8
+			uint32		WireframeID;	// The lines of the mesh in the wireframe buffer, from DebugWireframe::GetRange.
+			uint32		_Padding;
+		};
+
+		// Same layout as GlyphInstance in DebugRenderer/TextVert.hlsl.
+		struct GlyphInstance
+		{
+			glm::vec3	Position;		// World position of the text, or pixels on the screen.
+			uint32		Color;			// RGBA8
+			glm::vec2	Offset;			// Pixels from the position to the top left of the glyph.
+			glm::vec2	Size;			// Pixels.
+			uint32		AtlasMin;		// Texels, x in the low and y in the high 16 bits.
+			uint32		AtlasMax;
+			uint32		IsScreenSpace;
+		};
+
+		template<typename Element>
+		using PrimitiveBuffer = DebugPrimitiveBuffer<Element>;
+
+		template<typename Element>
+		using Group = typename DebugPrimitiveBuffer<Element>::Group;
+
+		struct FrameData
+		{
+			glm::mat4	ViewProj		= glm::mat4(1.f);
+			glm::vec2	InvScreenSize	= glm::vec2(0.f);
+			glm::vec2	_Padding		= glm::vec2(0.f);
+		};
+
+		struct ShapeData
+		{
+			uint32		FirstInstance	= 0u;
+			uint32		ShapeType		= 0u;
+			uint32		_Padding[2]		= { 0u, 0u };
+		};
+
+		struct TextData
+		{
+			uint32		FirstInstance	= 0u;
+			uint32		_Padding		= 0u;
+			glm::vec2	InvAtlasSize	= glm::vec2(0.f);
 		};
 
 		enum Type
 		{
 			LINES,
-			POINTS
+			POINTS,
+			BOXES,
+			SPHERES,
+			AXES,
+			TEXT,
+			MESHES
+		};
+
+		/*
+		* A push or a Clear(id) from another thread, its elements are in the command buffer of that thread.
+		*/
+		struct ThreadCommand
+		{
+			Type	PrimitiveType	= Type::LINES;
+			uint32	ID				= 0u;	// Already processed.
+			float	Lifetime		= LIFETIME_PERSISTENT;
+			uint32	First			= 0u;
+			uint32	Count			= 0u;
+			bool	ShouldClear		= true;
+			bool	IsClear			= false; // Clear the id in all buffers.
+		};
+
+		struct ThreadCommands
+		{
+			std::vector<ThreadCommand>	Commands;
+			std::vector<Vertex>			Vertices;
+			std::vector<Point>			Points;
+			std::vector<ShapeInstance>	Shapes;
+			std::vector<GlyphInstance>	Glyphs;
+			std::vector<MeshInstance>	Meshes;
+			uint32						SortKey		= UINT32_MAX;
+			uint32						Sequence	= 0u; // Order of submission.
+			ThreadCommands*				pNext		= nullptr;
+		};
+
+		/*
+		* The command buffer of a thread, which is submitted to its renderer when the thread exits.
+		* The renderer keeps a list of the recorders which point to it, and detaches them when it is released or destroyed.
+		*/
+		struct ThreadRecorder
+		{
+			DebugRenderer*		pOwner		= nullptr;
+			ThreadCommands*		pCommands	= nullptr;
+
+			~ThreadRecorder();
+			void Submit(uint32 sortKey);
+
+			// Submit to the current owner and register with the new one, s_ThreadRecorderMutex has to be locked.
+			void SetOwner(DebugRenderer* pNewOwner);
+		};
+
+		/*
+		* Where a push writes its elements, the group on the render thread or the command buffer of another thread.
+		*/
+		template<typename Element>
+		struct PushTarget
+		{
+			std::vector<Element>&	Elements;
+			Group<Element>*			pGroup		= nullptr;
+			ThreadCommand*			pCommand	= nullptr;
+			uint32					First		= 0u;
 		};
 
 		uint32 ProcessID(uint32 id, Type type);
 
-		void DrawLines(ID3D11DeviceContext* pContext);
-		void DrawPoints(ID3D11DeviceContext* pContext);
+		template<typename Element>
+		Group<Element>& GetGroup(PrimitiveBuffer<Element>& buffer, uint32 id);
+
+		/*
+		* The group to push primitives to, which is cleared first if it should be. id has to be processed.
+		*/
+		template<typename Element>
+		Group<Element>& GetPushGroup(PrimitiveBuffer<Element>& buffer, uint32 id, bool shouldClear, float lifetime);
+
+		/*
+		* Where to push primitives to, EndPush has to be called after the elements are added. outID is the id returned by the push.
+		*/
+		template<typename Element>
+		PushTarget<Element> BeginPush(PrimitiveBuffer<Element>& buffer, Type type, uint32 id, bool shouldClear, float lifetime, uint32& outID);
 
-		void BakeLines();
-		void BakePoints();
+		template<typename Element>
+		void EndPush(PrimitiveBuffer<Element>& buffer, PushTarget<Element>& target);
 
-		void UpdateLinesDrawBuffer();
-		void UpdatePointsDrawBuffer();
+		static ThreadRecorder& GetThreadRecorder();
 
-		bool ShouldClearPoints(uint32 id, bool shouldClear);
-		bool ShouldClearLines(uint32 id, bool shouldClear);
+		/*
+		* The command buffer of this thread, or nullptr on the render thread.
+		*/
+		ThreadCommands* GetThreadCommands();
 
-		void PushMeshInternal(ModelResource* model, const Color& color, uint32 id, bool shouldClear, const glm::mat4& accTransform);
+		/*
+		* Delete the unsubmitted commands of the recorders which point to this renderer and the submitted commands, and detach the recorders.
+		*/
+		void DropThreadCommands();
+
+		/*
+		* Apply the submitted commands of the other threads, in the order of their sort keys.
+		*/
+		void MergeThreadCommands();
+
+		template<typename Element>
+		void ApplyThreadCommand(PrimitiveBuffer<Element>& buffer, const ThreadCommand& command, const std::vector<Element>& elements);
+
+		uint32 PushShape(PrimitiveBuffer<ShapeInstance>& buffer, Type type, const glm::mat4& transform, const Color& color, uint32 id, bool shouldClear, float lifetime);
+		uint32 PushTextInternal(std::string_view text, const glm::vec3& position, bool isScreenSpace, const Color& color, float size, float maxWidth, uint32 id, bool shouldClear, float lifetime);
+
+		/*
+		* Call the function with each primitive buffer.
+		*/
+		template<typename Function>
+		void ForEachBuffer(Function function);
+
+		void DrawLines();
+		void DrawPoints();
+		void DrawShapes(PrimitiveBuffer<ShapeInstance>& buffer, Type type, uint32 vertexCount);
+		void DrawGlyphs();
+		void DrawMeshes();
+
+		/*
+		* Trim the wireframes with the meshes which are drawn, and make the wireframe buffer again if they changed since it was made.
+		* Returns the number of uploaded bytes.
+		*/
+		uint32 UpdateWireframeBuffer();
+
+		static uint32 PackColor(const Color& color);
+		static uint32 PackPoint(const Color& color, float size);
+
+		void PushMeshInternal(const ModelResource* pModel, uint32 color, const glm::mat4& accTransform, std::vector<MeshInstance>& instances);
 
 	private:
 		// Holds data of the different types.
-		std::unordered_map<uint32, DataPoints>	m_IDLinesMap;
-		std::unordered_map<uint32, DataPoints>	m_IDPointsMap;
-		DataPoints				m_LinesToRender;
-		DataPoints				m_PointsToRender;
-		bool					m_ShouldBakeLines				= false;
-		bool					m_ShouldBakePoints				= false;
+		PrimitiveBuffer<Vertex>			m_Lines				= PrimitiveBuffer<Vertex>(false);
+		PrimitiveBuffer<Point>			m_Points;
+		PrimitiveBuffer<ShapeInstance>	m_Boxes; // Axis aligned and oriented boxes, and frusta.
+		PrimitiveBuffer<ShapeInstance>	m_Spheres;
+		PrimitiveBuffer<ShapeInstance>	m_Axes;
+		PrimitiveBuffer<GlyphInstance>	m_Text;
+		PrimitiveBuffer<MeshInstance>	m_Meshes;
+		DebugFont						m_Font;
+		DebugWireframe					m_Wireframes;
+
+		// Command buffers submitted by other threads, a lock-free list which is taken as a whole by Render.
+		std::atomic<ThreadCommands*>	m_pSubmittedCommands		= nullptr;
+		std::atomic<uint32>				m_SubmitSequence			= 0u;
+		std::thread::id					m_RenderThreadID			= std::this_thread::get_id();
+		std::vector<ThreadRecorder*>	m_ThreadRecorders; // Of the threads which pushed to this renderer, guarded by s_ThreadRecorderMutex.
+		inline static std::mutex		s_ThreadRecorderMutex;
+
+		// Timed primitives are grouped by the tick they expire at, and the groups are removed as a whole.
+		double					m_Time						= 0.0;
+		std::set<uint64>		m_ExpiryTicks;
 
 		// Rendering objects.
 		Pipeline				m_Pipeline;
-		ID3D11Buffer*			m_pLinesVertexBuffer		= nullptr;
-		uint32					m_PreviousLinesBufferSize	= 0u;
-		ID3D11Buffer*			m_pPointsVertexBuffer		= nullptr;
-		uint32					m_PreviousPointsBufferSize	= 0u;
-		// Holds data of view and projection matrices.
+		// Holds the view projection matrix and the size of the screen (FrameData).
 		ID3D11Buffer*			m_pVPBuffer					= nullptr;
-		ID3D11Buffer*			m_pViewBuffer				= nullptr;
-		ID3D11Buffer*			m_pGeomBuffer				= nullptr;
+		ID3D11Buffer*			m_pShapeBuffer				= nullptr;
+		ID3D11Buffer*			m_pTextBuffer				= nullptr;
+		ID3D11Texture2D*		m_pFontAtlas				= nullptr;
+		ID3D11ShaderResourceView*	m_pFontAtlasSRV			= nullptr;
+		ID3D11SamplerState*		m_pFontSampler				= nullptr;
+		ID3D11Buffer*			m_pWireframeBuffer			= nullptr;
+		uint32					m_NumWireframeVertices		= 0u;
+		uint32					m_WireframeVersion			= 0u; // Of the wireframes in the buffer.
 		Shader					m_LineShader;
 		Shader					m_PointShader;
-
-		GFrameData				m_GeomFrameData;
+		Shader					m_ShapeShader;
+		Shader					m_TextShader;
+		Shader					m_MeshShader;
 
 		// Statistics for debugging.
 		Stats					m_Stats;
@@ -133,13 +410,12 @@ namespace RS
 		// Safe guard.
 		bool					m_IsCameraSet				= false;
 
-		// Variables to prevent the default push to clear each time its called.
-		bool					m_LinesFirstCall			= true;
-		bool					m_PointsFirstCall			= true;
-
 		// ID related variables.
 		static const uint32		s_DefaultLinesID			= 1u;
 		static const uint32		s_DefaultPointsID			= s_DefaultLinesID+1;
-		inline static uint32	s_IDGenerator				= s_DefaultPointsID;
+		inline static std::atomic<uint32>	s_IDGenerator	= s_DefaultPointsID;
+		static const uint32		s_StaticIDFlag				= 0x40000000u; // Set in the ids made by GenID(true).
+		static const uint32		s_OneFrameID				= 0x7FFFFFFFu;
+		static const uint32		s_TimedIDBase				= 0x80000000u; // The id of a timed group is the base with the low bits of its tick.
 	};
-}
\ No newline at end of file
+}
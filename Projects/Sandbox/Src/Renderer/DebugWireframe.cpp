@@ -0,0 +1,336 @@
+#include "PreCompiled.h"
+#include "DebugWireframe.h"
+
+#include "Utils/ParallelFor.h"
+#include "Utils/Timer.h"
+
+#include <algorithm>
+#include <bit>
+#include <thread>
+#include <unordered_set>
+
+using namespace RS;
+
+namespace
+{
+	// The work is split into chunks of a fixed size, such that the order of the buckets does not depend on the number of threads.
+	const uint32 VERTICES_PER_CHUNK		= 8192;
+	const uint32 TRIANGLES_PER_CHUNK	= 4096;
+
+	struct PositionKey
+	{
+		uint32 Bits[3];
+
+		bool operator==(const PositionKey& other) const
+		{
+			return Bits[0] == other.Bits[0] && Bits[1] == other.Bits[1] && Bits[2] == other.Bits[2];
+		}
+	};
+
+	PositionKey GetPositionKey(const glm::vec3& position)
+	{
+		// Adding zero turns -0 into 0, such that both are the same position.
+		return { std::bit_cast<uint32>(position.x + 0.f), std::bit_cast<uint32>(position.y + 0.f), std::bit_cast<uint32>(position.z + 0.f) };
+	}
+
+	uint64 HashPosition(const PositionKey& key)
+	{
+		uint64 hash = (((uint64)key.Bits[0] << 32) | key.Bits[1]) * 0x9E3779B97F4A7C15ull;
+		hash = (hash ^ key.Bits[2]) * 0xC2B2AE3D27D4EB4Full;
+		return hash ^ (hash >> 32);
+	}
+
+	struct PositionKeyHash
+	{
+		size_t operator()(const PositionKey& key) const { return (size_t)HashPosition(key); }
+	};
+
+	uint32 GetBucket(uint64 hash)
+	{
+		// The high bits of the product depend on all bits of the hash.
+		return (uint32)((hash * 0x9E3779B97F4A7C15ull) >> (64 - DebugWireframe::BUCKET_BITS));
+	}
+
+	uint32 GetNumChunks(uint32 count, uint32 chunkSize)
+	{
+		return (count + chunkSize - 1) / chunkSize;
+	}
+}
+
+uint32 DebugWireframe::Get(const MeshObject& mesh)
+{
+	auto FindCurrentEntry = [&]() -> Entry*
+	{
+		auto it = m_Entries.find(&mesh);
+		bool isCurrent = it != m_Entries.end() && it->second.NumVertices == mesh.Vertices.size() && it->second.NumIndices == mesh.Indices.size();
+		return isCurrent ? &it->second : nullptr;
+	};
+	auto UseEntry = [&](Entry& entry)
+	{
+		entry.LastUse = m_NumTrims;
+		return entry.Lines.NumVertices > 0 ? entry.ID : INVALID_ID;
+	};
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		if (Entry* pEntry = FindCurrentEntry())
+			return UseEntry(*pEntry);
+	}
+
+	if (mesh.Indices.empty() && mesh.NumIndices > 0)
+		LOG_WARNING("A debug mesh has no vertices in RAM, it has to be loaded without LOADER_FLAG_NO_MESH_DATA_IN_RAM to be drawn!");
+
+	// The edges are found without the lock, such that the other threads can push and draw meanwhile.
+	Timer timer;
+	std::vector<Edge> edges;
+	ExtractEdges(mesh.Vertices, mesh.Indices, std::max(std::thread::hardware_concurrency(), 1u), edges);
+
+	// A mesh which was pushed from several threads at once is kept from the thread which finished first.
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	if (Entry* pEntry = FindCurrentEntry())
+		return UseEntry(*pEntry);
+
+	// A mesh which changed keeps its id, its old lines are unused until the list is compacted.
+	Entry& entry = m_Entries[&mesh];
+	if (entry.ID == INVALID_ID)
+	{
+		entry.ID = m_NextID++;
+		m_Meshes[entry.ID] = &mesh;
+	}
+	m_NumUsedVertices		-= entry.Lines.NumVertices;
+	entry.Lines.FirstVertex	= (uint32)m_Vertices.size();
+	entry.Lines.NumVertices	= (uint32)edges.size() * 2;
+	entry.NumVertices		= mesh.Vertices.size();
+	entry.NumIndices		= mesh.Indices.size();
+	entry.LastUse			= m_NumTrims;
+	m_NumUsedVertices		+= entry.Lines.NumVertices;
+
+	m_Vertices.reserve(m_Vertices.size() + edges.size() * 2);
+	for (const Edge& edge : edges)
+	{
+		m_Vertices.push_back(mesh.Vertices[edge.First].Position);
+		m_Vertices.push_back(mesh.Vertices[edge.Second].Position);
+	}
+
+	if (edges.empty())
+		return INVALID_ID;
+
+	m_Version++;
+	LOG_INFO("Found the {} edges of a debug mesh with {} triangles in {:.2f} ms.", edges.size(), mesh.Indices.size() / 3, timer.Stop().GetDeltaTimeMS());
+	return entry.ID;
+}
+
+DebugWireframe::Range DebugWireframe::GetRange(uint32 id) const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	auto it = m_Meshes.find(id);
+	return it != m_Meshes.end() ? m_Entries.at(it->second).Lines : Range();
+}
+
+void DebugWireframe::Remove(const MeshObject& mesh)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	RemoveEntry(&mesh);
+}
+
+void DebugWireframe::Trim(std::span<const uint32> usedIDs)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_NumTrims++;
+	for (uint32 id : usedIDs)
+	{
+		auto it = m_Meshes.find(id);
+		if (it != m_Meshes.end())
+			m_Entries.at(it->second).LastUse = m_NumTrims;
+	}
+
+	if (m_NumUsedVertices > m_MaxVertices)
+	{
+		// The meshes which were not used in this frame, from the one which was used least recently.
+		std::vector<std::pair<uint64, const MeshObject*>> candidates;
+		for (const auto& [pMesh, entry] : m_Entries)
+		{
+			if (entry.LastUse < m_NumTrims && entry.Lines.NumVertices > 0)
+				candidates.emplace_back(entry.LastUse, pMesh);
+		}
+		std::sort(candidates.begin(), candidates.end());
+
+		uint32 numForgotten = 0;
+		for (size_t i = 0; i < candidates.size() && m_NumUsedVertices > m_MaxVertices; i++, numForgotten++)
+			RemoveEntry(candidates[i].second);
+		if (m_NumUsedVertices > m_MaxVertices)
+			LOG_WARNING("The debug meshes of this frame have {} line vertices, which is more than the budget of {}!", m_NumUsedVertices, m_MaxVertices);
+		else
+			LOG_INFO("Forgot the lines of {} debug meshes to keep them under the budget of {} vertices.", numForgotten, m_MaxVertices);
+	}
+
+	if (m_Vertices.size() - m_NumUsedVertices > m_NumUsedVertices)
+		Compact();
+}
+
+void DebugWireframe::SetMaxVertices(uint32 maxVertices)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_MaxVertices = maxVertices;
+}
+
+uint32 DebugWireframe::GetMaxVertices() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_MaxVertices;
+}
+
+uint32 DebugWireframe::GetNumVertices() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return (uint32)m_Vertices.size();
+}
+
+uint32 DebugWireframe::GetVersion() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_Version;
+}
+
+uint32 DebugWireframe::CopyVertices(std::vector<glm::vec3>& outVertices) const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	outVertices = m_Vertices;
+	return m_Version;
+}
+
+void DebugWireframe::Clear()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Entries.clear();
+	m_Meshes.clear();
+	m_Vertices.clear();
+	m_Vertices.shrink_to_fit();
+	m_NumUsedVertices = 0u;
+	m_Version++;
+}
+
+void DebugWireframe::RemoveEntry(const MeshObject* pMesh)
+{
+	auto it = m_Entries.find(pMesh);
+	if (it == m_Entries.end())
+		return;
+
+	m_NumUsedVertices -= it->second.Lines.NumVertices;
+	m_Meshes.erase(it->second.ID);
+	m_Entries.erase(it);
+}
+
+void DebugWireframe::Compact()
+{
+	// The lines keep their order, and the list is copied such that its capacity shrinks with it.
+	std::vector<Entry*> entries;
+	entries.reserve(m_Entries.size());
+	for (auto& [pMesh, entry] : m_Entries)
+		entries.push_back(&entry);
+	std::sort(entries.begin(), entries.end(), [](const Entry* a, const Entry* b) { return a->Lines.FirstVertex < b->Lines.FirstVertex; });
+
+	std::vector<glm::vec3> vertices;
+	vertices.reserve(m_NumUsedVertices);
+	for (Entry* pEntry : entries)
+	{
+		const uint32 first = pEntry->Lines.FirstVertex;
+		pEntry->Lines.FirstVertex = (uint32)vertices.size();
+		vertices.insert(vertices.end(), m_Vertices.begin() + first, m_Vertices.begin() + first + pEntry->Lines.NumVertices);
+	}
+	m_Vertices.swap(vertices);
+	m_Version++;
+}
+
+void DebugWireframe::ExtractEdges(std::span<const MeshObject::Vertex> vertices, std::span<const uint32> indices, uint32 numThreads, std::vector<Edge>& outEdges)
+{
+	outEdges.clear();
+	const uint32 numVertices	= (uint32)vertices.size();
+	const uint32 numTriangles	= (uint32)(indices.size() / 3);
+	if (numVertices == 0 || numTriangles == 0)
+		return;
+
+	// Each vertex is welded to the first vertex with its position. The vertices are scattered into buckets by the hash of their position,
+	// then each bucket maps its positions to the first vertex with it. A position is only in one bucket, so the buckets do not share any vertices.
+	std::vector<uint32> welded(numVertices);
+	{
+		const uint32 numChunks = GetNumChunks(numVertices, VERTICES_PER_CHUNK);
+		std::vector<std::vector<uint32>> chunkBuckets((size_t)numChunks * NUM_BUCKETS);
+		ParallelFor(std::min(numThreads, numChunks), numChunks, [&](uint32 chunk, uint32)
+		{
+			std::vector<uint32>* pBuckets = &chunkBuckets[(size_t)chunk * NUM_BUCKETS];
+			uint32 end = std::min(numVertices, (chunk + 1) * VERTICES_PER_CHUNK);
+			for (uint32 v = chunk * VERTICES_PER_CHUNK; v < end; v++)
+				pBuckets[GetBucket(HashPosition(GetPositionKey(vertices[v].Position)))].push_back(v);
+		});
+
+		ParallelFor(std::min(numThreads, NUM_BUCKETS), NUM_BUCKETS, [&](uint32 bucket, uint32)
+		{
+			size_t numBucketVertices = 0;
+			for (uint32 chunk = 0; chunk < numChunks; chunk++)
+				numBucketVertices += chunkBuckets[(size_t)chunk * NUM_BUCKETS + bucket].size();
+
+			std::unordered_map<PositionKey, uint32, PositionKeyHash> firstVertices;
+			firstVertices.reserve(numBucketVertices);
+			for (uint32 chunk = 0; chunk < numChunks; chunk++)
+			{
+				for (uint32 v : chunkBuckets[(size_t)chunk * NUM_BUCKETS + bucket])
+					welded[v] = firstVertices.try_emplace(GetPositionKey(vertices[v].Position), v).first->second;
+			}
+		});
+	}
+
+	// The same for the edges, with the welded ends of an edge as its key. Each bucket keeps its edges in the order of the triangles which first use them.
+	const uint32 numChunks = GetNumChunks(numTriangles, TRIANGLES_PER_CHUNK);
+	std::vector<std::vector<uint64>> chunkBuckets((size_t)numChunks * NUM_BUCKETS);
+	ParallelFor(std::min(numThreads, numChunks), numChunks, [&](uint32 chunk, uint32)
+	{
+		std::vector<uint64>* pBuckets = &chunkBuckets[(size_t)chunk * NUM_BUCKETS];
+		uint32 end = std::min(numTriangles, (chunk + 1) * TRIANGLES_PER_CHUNK);
+		for (uint32 t = chunk * TRIANGLES_PER_CHUNK; t < end; t++)
+		{
+			const uint32* pTriangle = &indices[(size_t)t * 3];
+			if (pTriangle[0] >= numVertices || pTriangle[1] >= numVertices || pTriangle[2] >= numVertices)
+				continue;
+
+			for (uint32 e = 0; e < 3; e++)
+			{
+				uint32 a = welded[pTriangle[e]];
+				uint32 b = welded[pTriangle[(e + 1) % 3]];
+				if (a == b)
+					continue;
+
+				uint64 key = ((uint64)std::min(a, b) << 32) | std::max(a, b);
+				pBuckets[GetBucket(key)].push_back(key);
+			}
+		}
+	});
+
+	std::vector<std::vector<Edge>> bucketEdges(NUM_BUCKETS);
+	ParallelFor(std::min(numThreads, NUM_BUCKETS), NUM_BUCKETS, [&](uint32 bucket, uint32)
+	{
+		size_t numBucketKeys = 0;
+		for (uint32 chunk = 0; chunk < numChunks; chunk++)
+			numBucketKeys += chunkBuckets[(size_t)chunk * NUM_BUCKETS + bucket].size();
+
+		// Most edges are shared by two triangles.
+		std::unordered_set<uint64> keys;
+		keys.reserve(numBucketKeys / 2);
+		bucketEdges[bucket].reserve(numBucketKeys / 2);
+		for (uint32 chunk = 0; chunk < numChunks; chunk++)
+		{
+			for (uint64 key : chunkBuckets[(size_t)chunk * NUM_BUCKETS + bucket])
+			{
+				if (keys.insert(key).second)
+					bucketEdges[bucket].push_back({ (uint32)(key >> 32), (uint32)key });
+			}
+		}
+	});
+
+	size_t numEdges = 0;
+	for (const std::vector<Edge>& edges : bucketEdges)
+		numEdges += edges.size();
+	outEdges.reserve(numEdges);
+	for (const std::vector<Edge>& edges : bucketEdges)
+		outEdges.insert(outEdges.end(), edges.begin(), edges.end());
+}
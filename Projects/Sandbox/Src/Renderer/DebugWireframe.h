@@ -0,0 +1,122 @@
+#pragma once
+
+#include "Utils/Maths.h"
+#include "Resources/Resources.h"
+
+#include <mutex>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace RS
+{
+	/*
+	* The CPU side of the meshes of DebugRenderer, it does not use the device.
+	*	- The unique edges of a mesh are found once, the first time it is used, and are kept as a line list in the space of the mesh.
+	*	- Vertices with the same position are welded first, such that the edge between two faces with split normals or UVs is found once.
+	*	- The lines of all meshes are in one list, a mesh is drawn as instances of its range in the list. The range is looked up by the id of the mesh
+	*	  when it is drawn, such that the list can be compacted.
+	*	- Meshes are forgotten when their model is freed, and the ones which were used least recently when the list is over its budget of vertices.
+	*	  The list is compacted by Trim once more than half of it is unused.
+	* Example:
+	*	uint32 id = wireframes.Get(mesh);
+	*	wireframes.Trim(drawnIDs);
+	*	DebugWireframe::Range range = wireframes.GetRange(id);
+	*	stateCache->DrawInstanced(range.NumVertices, numInstances, range.FirstVertex, 0);
+	*/
+	class DebugWireframe
+	{
+	public:
+		static constexpr uint32 BUCKET_BITS				= 6;
+		static constexpr uint32 NUM_BUCKETS				= 1u << BUCKET_BITS;
+		static constexpr uint32 INVALID_ID				= 0u;
+		static constexpr uint32 DEFAULT_MAX_VERTICES	= 1u << 22; // 48 MB of lines.
+
+		struct Range
+		{
+			uint32 FirstVertex	= 0u;
+			uint32 NumVertices	= 0u; // Two for each edge.
+		};
+
+		// Indices of the first vertex with the position of each end, First is less than Second.
+		struct Edge
+		{
+			uint32 First	= 0u;
+			uint32 Second	= 0u;
+		};
+
+	public:
+		RS_DEFAULT_CLASS(DebugWireframe);
+
+		/*
+		* The id of the lines of the mesh, the edges are found if the mesh has not been used before or if its number of vertices or indices changed.
+		* Meshes which were loaded with LOADER_FLAG_NO_MESH_DATA_IN_RAM have no lines, and INVALID_ID is returned for them.
+		* This can be called from any thread.
+		*/
+		uint32 Get(const MeshObject& mesh);
+
+		/*
+		* The lines of an id from Get in the list, they are empty if the mesh was forgotten. This can be called from any thread.
+		*/
+		Range GetRange(uint32 id) const;
+
+		/*
+		* Forget a mesh which is freed, such that a new mesh at the same address is not drawn with its lines. This can be called from any thread.
+		*/
+		void Remove(const MeshObject& mesh);
+
+		/*
+		* Forget the meshes which were used least recently until the lines fit in the budget, and compact the list if more than half of it is unused.
+		* The meshes of usedIDs are used now and are kept, even if they do not fit. The ranges which were returned before are not valid after this.
+		*/
+		void Trim(std::span<const uint32> usedIDs);
+
+		void SetMaxVertices(uint32 maxVertices);
+		uint32 GetMaxVertices() const;
+
+		/*
+		* The lines of all meshes, the ranges from GetRange index into them. The version changes each time the list changes.
+		* These can be called from any thread, CopyVertices returns the version of the copy.
+		*/
+		uint32 GetNumVertices() const;
+		uint32 GetVersion() const;
+		uint32 CopyVertices(std::vector<glm::vec3>& outVertices) const;
+
+		/*
+		* Forget all meshes, the ids which were returned before are not valid after this.
+		*/
+		void Clear();
+
+		/*
+		* The unique edges of an indexed triangle list, in an order which does not depend on the number of threads.
+		* The vertices and then the edges are spread over NUM_BUCKETS buckets by their hash, and each bucket is made unique on its own thread.
+		* Triangles with an index outside of the vertices are skipped, as are the edges of degenerate triangles which have the same ends.
+		*/
+		static void ExtractEdges(std::span<const MeshObject::Vertex> vertices, std::span<const uint32> indices, uint32 numThreads, std::vector<Edge>& outEdges);
+
+	private:
+		struct Entry
+		{
+			uint32	ID			= INVALID_ID;
+			Range	Lines;
+			size_t	NumVertices	= 0u; // Of the mesh when its edges were found.
+			size_t	NumIndices	= 0u;
+			uint64	LastUse		= 0u; // The number of calls to Trim before the mesh was last used.
+		};
+
+		// The mutex has to be locked.
+		void RemoveEntry(const MeshObject* pMesh);
+		void Compact();
+
+	private:
+		std::unordered_map<const MeshObject*, Entry>	m_Entries;
+		std::unordered_map<uint32, const MeshObject*>	m_Meshes; // The mesh of each id.
+		std::vector<glm::vec3>							m_Vertices;
+		uint32											m_NumUsedVertices	= 0u; // The vertices of the meshes which are not forgotten.
+		uint32											m_MaxVertices		= DEFAULT_MAX_VERTICES;
+		uint32											m_NextID			= INVALID_ID + 1;
+		uint32											m_Version			= 0u;
+		uint64											m_NumTrims			= 0u;
+		mutable std::mutex								m_Mutex;
+	};
+}
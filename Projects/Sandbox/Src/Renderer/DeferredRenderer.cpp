@@ -0,0 +1,149 @@
+#include "PreCompiled.h"
+#include "DeferredRenderer.h"
+
+#include "Renderer/StateCache.h"
+
+#include <algorithm>
+
+using namespace RS;
+
+void DeferredRenderer::Init(uint32 gridX, uint32 gridY, uint32 gridZ)
+{
+	m_Clusters.Init(gridX, gridY, gridZ);
+
+	D3D11_BUFFER_DESC bufferDesc = {};
+	bufferDesc.ByteWidth		= sizeof(ClusterData);
+	bufferDesc.Usage			= D3D11_USAGE_DYNAMIC;
+	bufferDesc.BindFlags		= D3D11_BIND_CONSTANT_BUFFER;
+	bufferDesc.CPUAccessFlags	= D3D11_CPU_ACCESS_WRITE;
+	HRESULT result = RenderAPI::Get()->GetDevice()->CreateBuffer(&bufferDesc, nullptr, &m_pConstantBuffer);
+	RS_D311_ASSERT_CHECK(result, "Failed to create cluster constant buffer!");
+}
+
+void DeferredRenderer::Release()
+{
+	if (m_pConstantBuffer)
+	{
+		m_pConstantBuffer->Release();
+		m_pConstantBuffer = nullptr;
+	}
+	ReleaseBuffer(m_LightBuffer);
+	ReleaseBuffer(m_ClusterBuffer);
+	ReleaseBuffer(m_IndexBuffer);
+	m_Lights.clear();
+}
+
+void DeferredRenderer::SetLights(const std::vector<LightClusters::Light>& lights)
+{
+	m_Lights = lights;
+}
+
+const std::vector<LightClusters::Light>& DeferredRenderer::GetLights() const
+{
+	return m_Lights;
+}
+
+void DeferredRenderer::Update(const glm::mat4& view, const glm::mat4& proj, float nearPlane, float farPlane, uint32 width, uint32 height)
+{
+	m_Clusters.Build(m_Lights, view, proj, nearPlane, farPlane);
+
+	Upload(m_LightBuffer, m_Lights.data(), sizeof(LightClusters::Light), (uint32)m_Lights.size());
+	Upload(m_ClusterBuffer, m_Clusters.GetClusters().data(), sizeof(LightClusters::Cluster), (uint32)m_Clusters.GetClusters().size());
+	Upload(m_IndexBuffer, m_Clusters.GetLightIndices().data(), sizeof(uint32), (uint32)m_Clusters.GetLightIndices().size());
+
+	ClusterData clusterData;
+	clusterData.GridX		= m_Clusters.GetGridX();
+	clusterData.GridY		= m_Clusters.GetGridY();
+	clusterData.GridZ		= m_Clusters.GetGridZ();
+	clusterData.NumLights	= (uint32)m_Lights.size();
+	clusterData.SliceScale	= m_Clusters.GetSliceScale();
+	clusterData.SliceBias	= m_Clusters.GetSliceBias();
+	clusterData.TileScale	= glm::vec2((float)clusterData.GridX / (float)std::max(width, 1u), (float)clusterData.GridY / (float)std::max(height, 1u));
+
+	ID3D11DeviceContext* pContext = RenderAPI::Get()->GetDeviceContext();
+	D3D11_MAPPED_SUBRESOURCE mappedResource;
+	HRESULT result = pContext->Map(m_pConstantBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+	RS_D311_ASSERT_CHECK(result, "Failed to map cluster constant buffer!");
+	memcpy(mappedResource.pData, &clusterData, sizeof(ClusterData));
+	pContext->Unmap(m_pConstantBuffer, 0);
+}
+
+void DeferredRenderer::Bind(ShaderTypeFlag stage, uint32 constantBufferSlot, uint32 startResourceSlot)
+{
+	std::shared_ptr<StateCache> stateCache = StateCache::Get();
+	ID3D11ShaderResourceView* views[3] = { m_LightBuffer.pSRV, m_ClusterBuffer.pSRV, m_IndexBuffer.pSRV };
+	stateCache->SetConstantBuffers(stage, constantBufferSlot, 1, &m_pConstantBuffer);
+	stateCache->SetShaderResources(stage, startResourceSlot, 3, views);
+}
+
+const LightClusters& DeferredRenderer::GetClusters() const
+{
+	return m_Clusters;
+}
+
+bool DeferredRenderer::Upload(StructuredBuffer& buffer, const void* pData, uint32 stride, uint32 count)
+{
+	ID3D11Device* pDevice = RenderAPI::Get()->GetDevice();
+	ID3D11DeviceContext* pContext = RenderAPI::Get()->GetDeviceContext();
+
+	// An empty buffer can not be created, keep at least one element such that the view is always valid.
+	if (count > buffer.Capacity || buffer.pBuffer == nullptr)
+	{
+		uint32 capacity = std::max({ count, buffer.Capacity * 2, 1u });
+		ReleaseBuffer(buffer);
+
+		D3D11_BUFFER_DESC bufferDesc = {};
+		bufferDesc.ByteWidth			= capacity * stride;
+		bufferDesc.Usage				= D3D11_USAGE_DYNAMIC;
+		bufferDesc.BindFlags			= D3D11_BIND_SHADER_RESOURCE;
+		bufferDesc.CPUAccessFlags		= D3D11_CPU_ACCESS_WRITE;
+		bufferDesc.MiscFlags			= D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+		bufferDesc.StructureByteStride	= stride;
+		if (FAILED(pDevice->CreateBuffer(&bufferDesc, nullptr, &buffer.pBuffer)))
+		{
+			LOG_ERROR("Failed to create a structured buffer of {} elements!", capacity);
+			return false;
+		}
+
+		D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+		srvDesc.Format				= DXGI_FORMAT_UNKNOWN;
+		srvDesc.ViewDimension		= D3D11_SRV_DIMENSION_BUFFER;
+		srvDesc.Buffer.FirstElement	= 0;
+		srvDesc.Buffer.NumElements	= capacity;
+		if (FAILED(pDevice->CreateShaderResourceView(buffer.pBuffer, &srvDesc, &buffer.pSRV)))
+		{
+			LOG_ERROR("Failed to create the view of a structured buffer!");
+			ReleaseBuffer(buffer);
+			return false;
+		}
+		buffer.Capacity = capacity;
+	}
+
+	if (count == 0)
+		return true;
+
+	D3D11_MAPPED_SUBRESOURCE mappedResource;
+	if (FAILED(pContext->Map(buffer.pBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource)))
+	{
+		LOG_ERROR("Failed to map a structured buffer!");
+		return false;
+	}
+	memcpy(mappedResource.pData, pData, (size_t)count * stride);
+	pContext->Unmap(buffer.pBuffer, 0);
+	return true;
+}
+
+void DeferredRenderer::ReleaseBuffer(StructuredBuffer& buffer)
+{
+	if (buffer.pSRV)
+	{
+		buffer.pSRV->Release();
+		buffer.pSRV = nullptr;
+	}
+	if (buffer.pBuffer)
+	{
+		buffer.pBuffer->Release();
+		buffer.pBuffer = nullptr;
+	}
+	buffer.Capacity = 0;
+}
@@ -1,9 +1,77 @@
 #pragma once
 
+#include "Renderer/RenderAPI.h"
+#include "Renderer/ShaderDefines.h"
+#include "Renderer/LightClusters.h"
+
 namespace RS
 {
+	/*
+	* The light data of the clustered lighting path. The lights are binned into the clusters of the camera on the CPU (See LightClusters),
+	* and the lights, the clusters and the light index list are uploaded as structured buffers which Utils/ClusteredLights.hlsl reads.
+	* Example:
+	*	deferredRenderer.Init();
+	*	deferredRenderer.SetLights(lights);
+	*	deferredRenderer.Update(camera.GetView(), camera.GetProj(), camera.GetNearPlane(), camera.GetFarPlane(), width, height);
+	*	deferredRenderer.Bind(ShaderTypeFlag::FRAGMENT, 2, 9);
+	*/
 	class DeferredRenderer
 	{
+	public:
+		// The layout matches the ClusterData constant buffer in Utils/ClusteredLights.hlsl.
+		struct ClusterData
+		{
+			uint32		GridX		= 0;
+			uint32		GridY		= 0;
+			uint32		GridZ		= 0;
+			uint32		NumLights	= 0;
+			float		SliceScale	= 0.f;
+			float		SliceBias	= 0.f;
+			glm::vec2	TileScale	= glm::vec2(0.f); // Pixels to tiles.
+		};
+
+	public:
+		RS_DEFAULT_CLASS(DeferredRenderer);
+
+		void Init(uint32 gridX = 16, uint32 gridY = 9, uint32 gridZ = 24);
+		void Release();
+
+		void SetLights(const std::vector<LightClusters::Light>& lights);
+		const std::vector<LightClusters::Light>& GetLights() const;
+
+		/*
+		* Bin the lights for the camera and upload the result.
+		*/
+		void Update(const glm::mat4& view, const glm::mat4& proj, float nearPlane, float farPlane, uint32 width, uint32 height);
+
+		/*
+		* Bind the constant buffer, and the lights, clusters and light indices to the three shader resource slots from startResourceSlot.
+		*/
+		void Bind(ShaderTypeFlag stage, uint32 constantBufferSlot, uint32 startResourceSlot);
+
+		const LightClusters& GetClusters() const;
+
+	private:
+		struct StructuredBuffer
+		{
+			ID3D11Buffer*				pBuffer		= nullptr;
+			ID3D11ShaderResourceView*	pSRV		= nullptr;
+			uint32						Capacity	= 0; // In elements.
+		};
+
+		/*
+		* The buffer is recreated with twice the size when the data does not fit.
+		*/
+		static bool Upload(StructuredBuffer& buffer, const void* pData, uint32 stride, uint32 count);
+		static void ReleaseBuffer(StructuredBuffer& buffer);
+
+	private:
+		LightClusters						m_Clusters;
+		std::vector<LightClusters::Light>	m_Lights;
 
+		ID3D11Buffer*						m_pConstantBuffer	= nullptr;
+		StructuredBuffer					m_LightBuffer;
+		StructuredBuffer					m_ClusterBuffer;
+		StructuredBuffer					m_IndexBuffer;
 	};
-}
\ No newline at end of file
+}
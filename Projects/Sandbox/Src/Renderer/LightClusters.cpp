@@ -0,0 +1,389 @@
+#include "PreCompiled.h"
+#include "LightClusters.h"
+
+#include "Utils/Config.h"
+#include "Utils/Timer.h"
+
+#include <algorithm>
+#include <bit>
+#include <cfloat>
+#include <thread>
+#include <xmmintrin.h>
+
+using namespace RS;
+
+namespace
+{
+	// Mask of the lanes which hold lights, for the last group of four.
+	int GetLaneMask(uint32 i, uint32 count)
+	{
+		uint32 remaining = count - i;
+		return remaining >= 4 ? 0xF : (1 << remaining) - 1;
+	}
+
+	/*
+	* Returns a bit for each of the four lights at i whose sphere touches the box.
+	*/
+	int TestSpheres(const std::vector<float>& x, const std::vector<float>& y, const std::vector<float>& z, const std::vector<float>& radius, uint32 i, const AABB& box)
+	{
+		const __m128 zero = _mm_setzero_ps();
+		__m128 px = _mm_loadu_ps(&x[i]);
+		__m128 py = _mm_loadu_ps(&y[i]);
+		__m128 pz = _mm_loadu_ps(&z[i]);
+		__m128 r = _mm_loadu_ps(&radius[i]);
+
+		// Distance from the center to the box along each axis, zero when inside.
+		__m128 dx = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_set1_ps(box.min.x), px), zero), _mm_max_ps(_mm_sub_ps(px, _mm_set1_ps(box.max.x)), zero));
+		__m128 dy = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_set1_ps(box.min.y), py), zero), _mm_max_ps(_mm_sub_ps(py, _mm_set1_ps(box.max.y)), zero));
+		__m128 dz = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_set1_ps(box.min.z), pz), zero), _mm_max_ps(_mm_sub_ps(pz, _mm_set1_ps(box.max.z)), zero));
+		__m128 distSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+		return _mm_movemask_ps(_mm_cmple_ps(distSq, _mm_mul_ps(r, r)));
+	}
+
+	/*
+	* Returns a bit for each of the four lights at i whose cone touches the sphere (xyz: center, w: radius).
+	* Point lights have no direction and an angle of 180 degrees, which always passes.
+	* A cone of more than 90 degrees reaches behind its apex, it is not rejected for spheres behind the light.
+	*/
+	int TestCones(const std::vector<float>& x, const std::vector<float>& y, const std::vector<float>& z, const std::vector<float>& radius,
+		const std::vector<float>& dirX, const std::vector<float>& dirY, const std::vector<float>& dirZ, const std::vector<float>& cosAngle, const std::vector<float>& sinAngle,
+		uint32 i, const glm::vec4& sphere)
+	{
+		__m128 vx = _mm_sub_ps(_mm_set1_ps(sphere.x), _mm_loadu_ps(&x[i]));
+		__m128 vy = _mm_sub_ps(_mm_set1_ps(sphere.y), _mm_loadu_ps(&y[i]));
+		__m128 vz = _mm_sub_ps(_mm_set1_ps(sphere.z), _mm_loadu_ps(&z[i]));
+		__m128 lengthSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz));
+		__m128 alongAxis = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, _mm_loadu_ps(&dirX[i])), _mm_mul_ps(vy, _mm_loadu_ps(&dirY[i]))), _mm_mul_ps(vz, _mm_loadu_ps(&dirZ[i])));
+		__m128 fromAxis = _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(lengthSq, _mm_mul_ps(alongAxis, alongAxis)), _mm_setzero_ps()));
+
+		// Distance from the center of the sphere to the side of the cone.
+		__m128 angleCos = _mm_loadu_ps(&cosAngle[i]);
+		__m128 distToCone = _mm_sub_ps(_mm_mul_ps(angleCos, fromAxis), _mm_mul_ps(alongAxis, _mm_loadu_ps(&sinAngle[i])));
+
+		__m128 sphereRadius = _mm_set1_ps(sphere.w);
+		__m128 inAngle = _mm_cmple_ps(distToCone, sphereRadius);
+		__m128 inFront = _mm_cmple_ps(alongAxis, _mm_add_ps(sphereRadius, _mm_loadu_ps(&radius[i])));
+		__m128 inBack = _mm_or_ps(_mm_cmpge_ps(alongAxis, _mm_sub_ps(_mm_setzero_ps(), sphereRadius)), _mm_cmplt_ps(angleCos, _mm_setzero_ps()));
+		return _mm_movemask_ps(_mm_and_ps(_mm_and_ps(inAngle, inFront), inBack));
+	}
+}
+
+void LightClusters::LightSet::Resize(uint32 count)
+{
+	Count = count;
+	uint32 paddedCount = (count + 3) & ~3u;
+	for (std::vector<float>* pValues : { &X, &Y, &Z, &Radius, &DirX, &DirY, &DirZ, &CosAngle, &SinAngle })
+		pValues->assign(paddedCount, 0.f);
+	Indices.assign(paddedCount, 0);
+}
+
+void LightClusters::LightSet::Clear()
+{
+	Count = 0;
+	for (std::vector<float>* pValues : { &X, &Y, &Z, &Radius, &DirX, &DirY, &DirZ, &CosAngle, &SinAngle })
+		pValues->clear();
+	Indices.clear();
+}
+
+void LightClusters::LightSet::Push(const LightSet& other, uint32 i)
+{
+	X.push_back(other.X[i]);
+	Y.push_back(other.Y[i]);
+	Z.push_back(other.Z[i]);
+	Radius.push_back(other.Radius[i]);
+	DirX.push_back(other.DirX[i]);
+	DirY.push_back(other.DirY[i]);
+	DirZ.push_back(other.DirZ[i]);
+	CosAngle.push_back(other.CosAngle[i]);
+	SinAngle.push_back(other.SinAngle[i]);
+	Indices.push_back(other.Indices[i]);
+	Count++;
+}
+
+void LightClusters::LightSet::Pad()
+{
+	uint32 paddedCount = (Count + 3) & ~3u;
+	for (std::vector<float>* pValues : { &X, &Y, &Z, &Radius, &DirX, &DirY, &DirZ, &CosAngle, &SinAngle })
+		pValues->resize(paddedCount, 0.f);
+	Indices.resize(paddedCount, 0);
+}
+
+void LightClusters::Init(uint32 gridX, uint32 gridY, uint32 gridZ)
+{
+	m_GridX = std::max(gridX, 1u);
+	m_GridY = std::max(gridY, 1u);
+	m_GridZ = std::max(gridZ, 1u);
+
+	uint32 numClusters = m_GridX * m_GridY * m_GridZ;
+	m_ClusterBounds.assign(numClusters, AABB());
+	m_ClusterSpheres.assign(numClusters, glm::vec4(0.f));
+	m_SliceBounds.assign(m_GridZ, AABB());
+	m_SliceIndices.assign(m_GridZ, std::vector<uint32>());
+	m_Clusters.assign(numClusters, Cluster());
+	m_LightIndices.clear();
+	m_BoundsProj = glm::mat4(0.f);
+}
+
+void LightClusters::Build(const std::vector<Light>& lights, const glm::mat4& view, const glm::mat4& proj, float nearPlane, float farPlane, uint32 numThreads)
+{
+	Timer timer;
+	timer.Start();
+
+	if (m_Clusters.empty())
+	{
+		LOG_WARNING("The light clusters have to be initialized before they are built!");
+		return;
+	}
+
+	if (proj != m_BoundsProj || nearPlane != m_BoundsNear || farPlane != m_BoundsFar)
+		ComputeClusterBounds(proj, nearPlane, farPlane);
+
+	if (numThreads == 0)
+		numThreads = Config::Get()->Fetch<uint32>("Renderer/LightBinningThreads", 0);
+	if (numThreads == 0)
+		numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	numThreads = std::clamp(numThreads, 1u, m_GridZ);
+
+	PrepareLights(lights, view, numThreads);
+
+	m_Scratch.resize(numThreads * 2);
+	m_Workers.ParallelFor(numThreads, m_GridZ, [&](uint32 z, uint32 threadIndex)
+	{
+		BinSlice(z, m_Scratch[threadIndex * 2], m_Scratch[threadIndex * 2 + 1]);
+	});
+
+	// Put the lists of the slices after each other, the offsets of the clusters are relative to their slice until now.
+	uint32 numIndices = 0;
+	for (const std::vector<uint32>& indices : m_SliceIndices)
+		numIndices += (uint32)indices.size();
+	m_LightIndices.resize(numIndices);
+
+	uint32 clustersPerSlice = m_GridX * m_GridY;
+	uint32 sliceOffset = 0;
+	m_Stats.MaxLightsPerCluster = 0;
+	for (uint32 z = 0; z < m_GridZ; z++)
+	{
+		const std::vector<uint32>& indices = m_SliceIndices[z];
+		std::copy(indices.begin(), indices.end(), m_LightIndices.begin() + sliceOffset);
+		for (uint32 cluster = z * clustersPerSlice; cluster < (z + 1) * clustersPerSlice; cluster++)
+		{
+			m_Clusters[cluster].Offset += sliceOffset;
+			m_Stats.MaxLightsPerCluster = std::max(m_Stats.MaxLightsPerCluster, m_Clusters[cluster].Count);
+		}
+		sliceOffset += (uint32)indices.size();
+	}
+
+	std::vector<bool> isVisible(lights.size(), false);
+	for (uint32 index : m_LightIndices)
+		isVisible[index] = true;
+
+	m_Stats.NumLights			= (uint32)lights.size();
+	m_Stats.NumVisibleLights	= (uint32)std::count(isVisible.begin(), isVisible.end(), true);
+	m_Stats.NumIndices			= numIndices;
+	m_Stats.NumThreads			= numThreads;
+	m_Stats.BuildTimeMS			= timer.Stop().GetDeltaTimeMS();
+}
+
+uint32 LightClusters::GetGridX() const
+{
+	return m_GridX;
+}
+
+uint32 LightClusters::GetGridY() const
+{
+	return m_GridY;
+}
+
+uint32 LightClusters::GetGridZ() const
+{
+	return m_GridZ;
+}
+
+uint32 LightClusters::GetClusterIndex(uint32 x, uint32 y, uint32 z) const
+{
+	return x + (y + z * m_GridY) * m_GridX;
+}
+
+float LightClusters::GetSliceScale() const
+{
+	return m_SliceScale;
+}
+
+float LightClusters::GetSliceBias() const
+{
+	return m_SliceBias;
+}
+
+const AABB& LightClusters::GetClusterBounds(uint32 cluster) const
+{
+	return m_ClusterBounds[cluster];
+}
+
+const std::vector<LightClusters::Cluster>& LightClusters::GetClusters() const
+{
+	return m_Clusters;
+}
+
+const std::vector<uint32>& LightClusters::GetLightIndices() const
+{
+	return m_LightIndices;
+}
+
+const LightClusters::Stats& LightClusters::GetStats() const
+{
+	return m_Stats;
+}
+
+void LightClusters::ComputeClusterBounds(const glm::mat4& proj, float nearPlane, float farPlane)
+{
+	m_BoundsProj	= proj;
+	m_BoundsNear	= nearPlane;
+	m_BoundsFar		= farPlane;
+
+	float depthRatio = glm::log2(farPlane / nearPlane);
+	m_SliceScale	= (float)m_GridZ / depthRatio;
+	m_SliceBias		= -(float)m_GridZ * glm::log2(nearPlane) / depthRatio;
+
+	// A point at the depth d (positive) and the normalized device coordinates (nx, ny) is (nx * d / proj[0][0], ny * d / proj[1][1], -d) in view space.
+	const float invScaleX = 1.f / proj[0][0];
+	const float invScaleY = 1.f / proj[1][1];
+	for (uint32 z = 0; z < m_GridZ; z++)
+	{
+		float depths[2] = {
+			nearPlane * glm::pow(farPlane / nearPlane, (float)z / (float)m_GridZ),
+			nearPlane * glm::pow(farPlane / nearPlane, (float)(z + 1) / (float)m_GridZ)
+		};
+
+		AABB& sliceBounds = m_SliceBounds[z];
+		sliceBounds.min = glm::vec3(FLT_MAX);
+		sliceBounds.max = glm::vec3(-FLT_MAX);
+		for (uint32 y = 0; y < m_GridY; y++)
+		{
+			float ndcY[2] = { 1.f - 2.f * (float)y / (float)m_GridY, 1.f - 2.f * (float)(y + 1) / (float)m_GridY };
+			for (uint32 x = 0; x < m_GridX; x++)
+			{
+				float ndcX[2] = { -1.f + 2.f * (float)x / (float)m_GridX, -1.f + 2.f * (float)(x + 1) / (float)m_GridX };
+
+				uint32 cluster = GetClusterIndex(x, y, z);
+				AABB& bounds = m_ClusterBounds[cluster];
+				bounds.min = glm::vec3(FLT_MAX);
+				bounds.max = glm::vec3(-FLT_MAX);
+				for (float depth : depths)
+				{
+					for (float nx : ndcX)
+					{
+						for (float ny : ndcY)
+						{
+							glm::vec3 corner(nx * depth * invScaleX, ny * depth * invScaleY, -depth);
+							bounds.min = Maths::GetMinElements(bounds.min, corner);
+							bounds.max = Maths::GetMaxElements(bounds.max, corner);
+						}
+					}
+				}
+
+				m_ClusterSpheres[cluster] = glm::vec4((bounds.min + bounds.max) * 0.5f, glm::length(bounds.max - bounds.min) * 0.5f);
+				sliceBounds.min = Maths::GetMinElements(sliceBounds.min, bounds.min);
+				sliceBounds.max = Maths::GetMaxElements(sliceBounds.max, bounds.max);
+			}
+		}
+	}
+}
+
+void LightClusters::PrepareLights(const std::vector<Light>& lights, const glm::mat4& view, uint32 numThreads)
+{
+	m_Lights.Resize((uint32)lights.size());
+
+	const uint32 chunkSize = 4096;
+	uint32 numChunks = ((uint32)lights.size() + chunkSize - 1) / chunkSize;
+	m_Workers.ParallelFor(std::min(numThreads, std::max(numChunks, 1u)), numChunks, [&](uint32 chunk, uint32 threadIndex)
+	{
+		uint32 end = std::min((chunk + 1) * chunkSize, (uint32)lights.size());
+		for (uint32 i = chunk * chunkSize; i < end; i++)
+		{
+			const Light& light = lights[i];
+			glm::vec3 position = glm::vec3(view * glm::vec4(light.Position, 1.f));
+			m_Lights.X[i]		= position.x;
+			m_Lights.Y[i]		= position.y;
+			m_Lights.Z[i]		= position.z;
+			m_Lights.Radius[i]	= light.Range;
+			m_Lights.Indices[i]	= i;
+
+			if (light.Type == LightType::SPOT)
+			{
+				glm::vec3 direction = glm::normalize(glm::mat3(view) * light.Direction);
+				float cosAngle = glm::clamp(light.CosOuterAngle, -1.f, 1.f);
+				m_Lights.DirX[i]		= direction.x;
+				m_Lights.DirY[i]		= direction.y;
+				m_Lights.DirZ[i]		= direction.z;
+				m_Lights.CosAngle[i]	= cosAngle;
+				m_Lights.SinAngle[i]	= glm::sqrt(1.f - cosAngle * cosAngle);
+			}
+			else
+			{
+				m_Lights.DirX[i]		= 0.f;
+				m_Lights.DirY[i]		= 0.f;
+				m_Lights.DirZ[i]		= 0.f;
+				m_Lights.CosAngle[i]	= -1.f;
+				m_Lights.SinAngle[i]	= 0.f;
+			}
+		}
+	});
+}
+
+void LightClusters::BinSlice(uint32 z, LightSet& sliceLights, LightSet& rowLights)
+{
+	sliceLights.Clear();
+	const AABB& sliceBounds = m_SliceBounds[z];
+	for (uint32 i = 0; i < m_Lights.Count; i += 4)
+	{
+		int mask = TestSpheres(m_Lights.X, m_Lights.Y, m_Lights.Z, m_Lights.Radius, i, sliceBounds) & GetLaneMask(i, m_Lights.Count);
+		for (; mask != 0; mask &= mask - 1)
+			sliceLights.Push(m_Lights, i + (uint32)std::countr_zero((uint32)mask));
+	}
+	sliceLights.Pad();
+
+	std::vector<uint32>& indices = m_SliceIndices[z];
+	indices.clear();
+	for (uint32 y = 0; y < m_GridY; y++)
+	{
+		AABB rowBounds;
+		rowBounds.min = glm::vec3(FLT_MAX);
+		rowBounds.max = glm::vec3(-FLT_MAX);
+		for (uint32 x = 0; x < m_GridX; x++)
+		{
+			const AABB& bounds = m_ClusterBounds[GetClusterIndex(x, y, z)];
+			rowBounds.min = Maths::GetMinElements(rowBounds.min, bounds.min);
+			rowBounds.max = Maths::GetMaxElements(rowBounds.max, bounds.max);
+		}
+
+		rowLights.Clear();
+		for (uint32 i = 0; i < sliceLights.Count; i += 4)
+		{
+			int mask = TestSpheres(sliceLights.X, sliceLights.Y, sliceLights.Z, sliceLights.Radius, i, rowBounds) & GetLaneMask(i, sliceLights.Count);
+			for (; mask != 0; mask &= mask - 1)
+				rowLights.Push(sliceLights, i + (uint32)std::countr_zero((uint32)mask));
+		}
+		rowLights.Pad();
+
+		for (uint32 x = 0; x < m_GridX; x++)
+		{
+			uint32 cluster = GetClusterIndex(x, y, z);
+			const AABB& bounds = m_ClusterBounds[cluster];
+			const glm::vec4& sphere = m_ClusterSpheres[cluster];
+
+			uint32 offset = (uint32)indices.size();
+			for (uint32 i = 0; i < rowLights.Count; i += 4)
+			{
+				int mask = TestSpheres(rowLights.X, rowLights.Y, rowLights.Z, rowLights.Radius, i, bounds) & GetLaneMask(i, rowLights.Count);
+				if (mask == 0)
+					continue;
+				mask &= TestCones(rowLights.X, rowLights.Y, rowLights.Z, rowLights.Radius, rowLights.DirX, rowLights.DirY, rowLights.DirZ, rowLights.CosAngle, rowLights.SinAngle, i, sphere);
+				for (; mask != 0; mask &= mask - 1)
+					indices.push_back(rowLights.Indices[i + (uint32)std::countr_zero((uint32)mask)]);
+			}
+
+			m_Clusters[cluster].Offset	= offset;
+			m_Clusters[cluster].Count	= (uint32)indices.size() - offset;
+		}
+	}
+}
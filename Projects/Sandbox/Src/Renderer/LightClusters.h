@@ -0,0 +1,132 @@
+#pragma once
+
+#include "Structures/AABB.h"
+#include "Utils/Maths.h"
+#include "Utils/WorkerPool.h"
+
+#include <vector>
+
+namespace RS
+{
+	/*
+	* Assigns point and spot lights to the clusters (froxels) of the view frustum, on the CPU.
+	* The frustum is split into GridX x GridY screen tiles and GridZ depth slices, where the slices grow exponentially with the depth.
+	* The lights are tested four at a time with SSE, first against each depth slice, then against each row of tiles and last against each cluster.
+	* The slices are binned on worker threads, which are kept between builds. Each slice lists its lights in the order of the input, so the result is the same for any number of threads.
+	* Example:
+	*	LightClusters clusters;
+	*	clusters.Init(16, 9, 24);
+	*	clusters.Build(lights, camera.GetView(), camera.GetProj(), camera.GetNearPlane(), camera.GetFarPlane());
+	*	const LightClusters::Cluster& cluster = clusters.GetClusters()[clusters.GetClusterIndex(x, y, z)];
+	*	for (uint32 i = 0; i < cluster.Count; i++) ... lights[clusters.GetLightIndices()[cluster.Offset + i]] ...
+	*/
+	class LightClusters
+	{
+	public:
+		enum class LightType : uint32
+		{
+			POINT = 0,
+			SPOT
+		};
+
+		// The layout matches the Light struct in Utils/ClusteredLights.hlsl.
+		struct Light
+		{
+			glm::vec3	Position		= glm::vec3(0.f);
+			float		Range			= 1.f;
+			glm::vec3	Color			= glm::vec3(1.f);
+			float		Intensity		= 1.f;
+			glm::vec3	Direction		= glm::vec3(0.f, -1.f, 0.f); // Only spot lights.
+			float		CosOuterAngle	= 0.f; // Only spot lights, a cone wider than 90 degrees (below zero) also reaches behind the light.
+			float		CosInnerAngle	= 0.f; // Only spot lights.
+			LightType	Type			= LightType::POINT;
+			float		Padding[2]		= { 0.f, 0.f };
+		};
+
+		struct Cluster
+		{
+			uint32	Offset	= 0; // First entry in the light index list.
+			uint32	Count	= 0;
+		};
+
+		struct Stats
+		{
+			uint32	NumLights				= 0;
+			uint32	NumVisibleLights		= 0; // Lights which are in at least one cluster.
+			uint32	NumIndices				= 0;
+			uint32	MaxLightsPerCluster		= 0;
+			uint32	NumThreads				= 0;
+			float	BuildTimeMS				= 0.f;
+		};
+
+	public:
+		RS_DEFAULT_CLASS(LightClusters);
+
+		void Init(uint32 gridX, uint32 gridY, uint32 gridZ);
+
+		/*
+		* Bin the lights for the camera, the matrices are the ones of Camera (right-handed and looking down -z).
+		* numThreads: Zero uses Renderer/LightBinningThreads from the config, or one for each hardware thread if that is zero as well.
+		*/
+		void Build(const std::vector<Light>& lights, const glm::mat4& view, const glm::mat4& proj, float nearPlane, float farPlane, uint32 numThreads = 0);
+
+		uint32 GetGridX() const;
+		uint32 GetGridY() const;
+		uint32 GetGridZ() const;
+		uint32 GetClusterIndex(uint32 x, uint32 y, uint32 z) const; // Tile row 0 is at the top of the screen.
+
+		/*
+		* The slice of a view depth (positive) is log2(depth) * scale + bias.
+		*/
+		float GetSliceScale() const;
+		float GetSliceBias() const;
+
+		const AABB& GetClusterBounds(uint32 cluster) const; // In view space.
+		const std::vector<Cluster>& GetClusters() const;
+		const std::vector<uint32>& GetLightIndices() const;
+		const Stats& GetStats() const;
+
+	private:
+		// The view space lights in structure of arrays, padded to a multiple of four.
+		struct LightSet
+		{
+			std::vector<float>	X, Y, Z, Radius;
+			std::vector<float>	DirX, DirY, DirZ, CosAngle, SinAngle;
+			std::vector<uint32>	Indices; // Index of the light in the input.
+			uint32				Count	= 0;
+
+			void Resize(uint32 count);
+			void Clear();
+			void Push(const LightSet& other, uint32 i);
+			void Pad();
+		};
+
+		void ComputeClusterBounds(const glm::mat4& proj, float nearPlane, float farPlane);
+		void PrepareLights(const std::vector<Light>& lights, const glm::mat4& view, uint32 numThreads);
+		void BinSlice(uint32 z, LightSet& sliceLights, LightSet& rowLights);
+
+	private:
+		uint32								m_GridX				= 0;
+		uint32								m_GridY				= 0;
+		uint32								m_GridZ				= 0;
+		float								m_SliceScale		= 0.f;
+		float								m_SliceBias			= 0.f;
+
+		// The cluster bounds only change with the projection.
+		glm::mat4							m_BoundsProj		= glm::mat4(0.f);
+		float								m_BoundsNear		= 0.f;
+		float								m_BoundsFar			= 0.f;
+		std::vector<AABB>					m_ClusterBounds;
+		std::vector<glm::vec4>				m_ClusterSpheres; // Bounding sphere of each cluster, for the spot light test.
+		std::vector<AABB>					m_SliceBounds;
+
+		LightSet							m_Lights;
+		std::vector<std::vector<uint32>>	m_SliceIndices;
+		std::vector<LightSet>				m_Scratch; // Two for each thread.
+		WorkerPool							m_Workers;
+
+		std::vector<Cluster>				m_Clusters;
+		std::vector<uint32>					m_LightIndices;
+		Stats								m_Stats;
+	};
+}
@@ -2,6 +2,7 @@
 #include "Pipeline.h"
 
 #include "Renderer/Renderer.h"
+#include "Renderer/StateCache.h"
 
 using namespace RS;
 
@@ -60,13 +61,9 @@ void Pipeline::Resize(uint32 width, uint32 height)
 		m_DepthStencilSave.depthBufferDesc.Width = width;
 		m_DepthStencilSave.depthBufferDesc.Height = height;
 		CreateDepthState();
-		m_ShouldBindDepthStencilState = true;
 		BindDepthStencilState();
 
-		m_ShouldBindDepthStencilView = true;
 		CreateDepthStencilView();
-
-		m_ShouldBindRTVs = true;
 		BindDepthAndRTVs(m_RTVAndDSVType);
 
 		SetViewport(0.f, 0.f, (float)width, (float)height);
@@ -82,118 +79,36 @@ void Pipeline::Bind(BindType bindType)
 
 void Pipeline::BindDepthStencilState()
 {
-	if (m_pDepthStencilState)
-	{
-		// Only bind depth stencil state if the current binded depth stencil state was not from the same pipeline or if it was updated.
-		if (s_CurrentBindedStates.DepthStencilStateID != m_ID || m_ShouldBindDepthStencilState)
-		{
-			m_pContext->OMSetDepthStencilState(m_pDepthStencilState, 1);
-			s_CurrentBindedStates.DepthStencilStateID = m_ID;
-			m_ShouldBindDepthStencilState = false;
-		}
-	}
-	else
-	{
-		// Only bind depth stencil state if the current binded depth stencil state was not from the same pipeline or if it was updated.
-		Pipeline* pDefaultPipeline = Renderer::Get()->GetDefaultPipeline();
-		ID3D11DepthStencilState* pDepthStencilState = pDefaultPipeline->GetDepthStencilState();
-		if (s_CurrentBindedStates.DepthStencilStateID != pDefaultPipeline->GetID() || pDefaultPipeline->m_ShouldBindDepthStencilState)
-		{
-			m_pContext->OMSetDepthStencilState(pDepthStencilState, 1);
-			s_CurrentBindedStates.DepthStencilStateID = pDefaultPipeline->GetID();
-			pDefaultPipeline->m_ShouldBindDepthStencilState = false;
-		}
-	}
+	// Redundant binds are filtered by the StateCache.
+	ID3D11DepthStencilState* pDepthStencilState = m_pDepthStencilState ? m_pDepthStencilState : Renderer::Get()->GetDefaultPipeline()->GetDepthStencilState();
+	StateCache::Get()->SetDepthStencilState(pDepthStencilState, 1);
 }
 
 void Pipeline::BindRasterState()
 {
-	if (m_pRasterizerState)
-	{
-		// Only bind rasterizer state if the current binded rasterizer state was not from the same pipeline or if it was updated.
-		if (s_CurrentBindedStates.RasterizerID != m_ID || m_ShouldBindRasterizerState)
-		{
-			m_pContext->RSSetState(m_pRasterizerState);
-			s_CurrentBindedStates.RasterizerID = m_ID;
-			m_ShouldBindRasterizerState = false;
-		}
-	}
-	else
-	{
-		// Only bind rasterizer state if the current binded rasterizer state was not from the same pipeline or if it was updated.
-		Pipeline* pDefaultPipeline = Renderer::Get()->GetDefaultPipeline();
-		ID3D11RasterizerState* pRasterizerState = pDefaultPipeline->GetRasterState();
-		if (s_CurrentBindedStates.RasterizerID != pDefaultPipeline->GetID() || pDefaultPipeline->m_ShouldBindRasterizerState)
-		{
-			m_pContext->RSSetState(pRasterizerState);
-			s_CurrentBindedStates.RasterizerID = pDefaultPipeline->GetID();
-			pDefaultPipeline->m_ShouldBindRasterizerState = false;
-		}
-	}
+	ID3D11RasterizerState* pRasterizerState = m_pRasterizerState ? m_pRasterizerState : Renderer::Get()->GetDefaultPipeline()->GetRasterState();
+	StateCache::Get()->SetRasterizerState(pRasterizerState);
 }
 
 void Pipeline::BindDepthAndRTVs(BindType bindType)
 {
 	m_RTVAndDSVType = bindType;
 
+	// Views which the pipeline does not have are taken from the default pipeline.
 	Pipeline* pDefaultPipeline = Renderer::Get()->GetDefaultPipeline();
-	if (m_RenderTargetViews.empty() == false)
-	{
-		if (m_pDepthStencilView)
-		{
-			// Only bind the RTVs if the current binded RTVs were not from the same pipeline or if they were updated.
-			if (s_CurrentBindedStates.RTVsID != m_ID || s_CurrentBindedStates.DepthStencilViewID != m_ID 
-				|| m_ShouldBindRTVs || m_ShouldBindDepthStencilView)
-			{
-				UINT						numRTVs = bindType != BindType::DEPTH_STENCIL_ONLY	? (UINT)m_RenderTargetViews.size()	: 0;
-				ID3D11RenderTargetView**	rtvs	= bindType != BindType::DEPTH_STENCIL_ONLY	? m_RenderTargetViews.data()		: nullptr;
-				ID3D11DepthStencilView*		dsv		= bindType != BindType::RTV_ONLY			? m_pDepthStencilView				: nullptr;
-				m_pContext->OMSetRenderTargets(numRTVs, rtvs, dsv);
-				s_CurrentBindedStates.RTVsID				= m_ID;
-				s_CurrentBindedStates.DepthStencilViewID	= m_ID;
-				m_ShouldBindRTVs							= false;
-				m_ShouldBindDepthStencilView				= false;
-			}
-		}
-		else
-		{
-			// Only bind the RTVs if the current binded RTVs were not from the same pipeline or if they were updated.
-			ID3D11DepthStencilView* pDefaultDepthStencilView = pDefaultPipeline->GetDepthStencilView();
-			if (s_CurrentBindedStates.RTVsID != m_ID || s_CurrentBindedStates.DepthStencilViewID != pDefaultPipeline->GetID()
-				|| m_ShouldBindRTVs || pDefaultPipeline->m_ShouldBindDepthStencilView)
-			{
-				UINT						numRTVs = bindType != BindType::DEPTH_STENCIL_ONLY	? (UINT)m_RenderTargetViews.size()	: 0;
-				ID3D11RenderTargetView**	rtvs	= bindType != BindType::DEPTH_STENCIL_ONLY	? m_RenderTargetViews.data()		: nullptr;
-				ID3D11DepthStencilView*		dsv		= bindType != BindType::RTV_ONLY			? pDefaultDepthStencilView			: nullptr;
-				m_pContext->OMSetRenderTargets(numRTVs, rtvs, dsv);
-				s_CurrentBindedStates.RTVsID					= m_ID;
-				s_CurrentBindedStates.DepthStencilViewID		= pDefaultPipeline->GetID();
-				m_ShouldBindRTVs								= false;
-				pDefaultPipeline->m_ShouldBindDepthStencilView	= false;
-			}
-		}
-	}
-	else if (m_pDepthStencilView)
-	{
-		// Only bind the RTVs if the current binded RTVs were not from the same pipeline or if they were updated.
-		std::vector<ID3D11RenderTargetView*> pDefaultRTVs = Renderer::Get()->GetDefaultPipeline()->GetRenderTargetViews();
-		if (s_CurrentBindedStates.RTVsID != pDefaultPipeline->GetID() || s_CurrentBindedStates.DepthStencilViewID != m_ID
-			|| pDefaultPipeline->m_ShouldBindRTVs || m_ShouldBindDepthStencilView)
-		{
-			UINT						numRTVs = bindType != BindType::DEPTH_STENCIL_ONLY	? (UINT)pDefaultRTVs.size()	: 0;
-			ID3D11RenderTargetView**	rtvs	= bindType != BindType::DEPTH_STENCIL_ONLY	? pDefaultRTVs.data()		: nullptr;
-			ID3D11DepthStencilView*		dsv		= bindType != BindType::RTV_ONLY			? m_pDepthStencilView		: nullptr;
-			m_pContext->OMSetRenderTargets(numRTVs, rtvs, dsv);
-			s_CurrentBindedStates.RTVsID = pDefaultPipeline->GetID();
-			s_CurrentBindedStates.DepthStencilViewID = m_ID;
-			pDefaultPipeline->m_ShouldBindRTVs = false;
-			m_ShouldBindDepthStencilView = false;
-		}
-	}
-	else
+	if (m_RenderTargetViews.empty() && m_pDepthStencilView == nullptr)
 	{
-		Renderer::Get()->GetDefaultPipeline()->BindDepthAndRTVs(bindType);
+		pDefaultPipeline->BindDepthAndRTVs(bindType);
+		return;
 	}
+
+	std::vector<ID3D11RenderTargetView*>& rtvs = m_RenderTargetViews.empty() ? pDefaultPipeline->GetRenderTargetViews() : m_RenderTargetViews;
+	ID3D11DepthStencilView* pDepthStencilView = m_pDepthStencilView ? m_pDepthStencilView : pDefaultPipeline->GetDepthStencilView();
+
+	UINT						numRTVs = bindType != BindType::DEPTH_STENCIL_ONLY	? (UINT)rtvs.size()	: 0;
+	ID3D11RenderTargetView**	ppRTVs	= bindType != BindType::DEPTH_STENCIL_ONLY	? rtvs.data()		: nullptr;
+	ID3D11DepthStencilView*		dsv		= bindType != BindType::RTV_ONLY			? pDepthStencilView	: nullptr;
+	StateCache::Get()->SetRenderTargets(numRTVs, ppRTVs, dsv);
 }
 
 void Pipeline::SetDepthStencilView(D3D11_DEPTH_STENCIL_VIEW_DESC depthStencilViewDesc)
@@ -204,7 +119,6 @@ void Pipeline::SetDepthStencilView(D3D11_DEPTH_STENCIL_VIEW_DESC depthStencilVie
 		return;
 	}
 
-	m_ShouldBindDepthStencilView = true;
 	m_DepthStencilSave.depthStencilViewDesc = depthStencilViewDesc;
 	CreateDepthStencilView();
 }
@@ -216,7 +130,6 @@ void Pipeline::SetDepthState(D3D11_DEPTH_STENCIL_DESC depthStencilDesc, D3D11_TE
 
 	CreateDepthState();
 
-	m_ShouldBindDepthStencilState = true;
 	BindDepthStencilState();
 }
 
@@ -231,23 +144,18 @@ void Pipeline::SetRasterState(D3D11_RASTERIZER_DESC rasterizerDesc)
 	HRESULT result = m_pDevice->CreateRasterizerState(&rasterizerDesc, &m_pRasterizerState);
 	RS_D311_ASSERT_CHECK(result, "Failed to create the rasterizer state!");
 
-	m_ShouldBindRasterizerState = true;
 	BindRasterState();
 }
 
 void RS::Pipeline::SetRenderTargetViews(std::vector<ID3D11RenderTargetView*> rtvs)
 {
 	m_RenderTargetViews = rtvs;
-
-	m_ShouldBindRTVs = true;
 }
 
 void Pipeline::SetRenderTargetView(ID3D11RenderTargetView* rtv)
 {
 	m_RenderTargetViews.clear();
 	m_RenderTargetViews.push_back(rtv);
-
-	m_ShouldBindRTVs = true;
 }
 
 void Pipeline::SetViewport(float x, float y, float width, float height)
@@ -259,7 +167,7 @@ void Pipeline::SetViewport(float x, float y, float width, float height)
 	viewport.Height = height;
 	viewport.MaxDepth = 1.f;
 	viewport.MinDepth = 0.f;
-	m_pContext->RSSetViewports(1, &viewport);
+	StateCache::Get()->SetViewport(viewport);
 }
 
 ID3D11DepthStencilView* Pipeline::GetDepthStencilView()
@@ -326,8 +234,6 @@ void Pipeline::CreateDepthStencilView()
 	// Create the depth stencil view.
 	HRESULT result = m_pDevice->CreateDepthStencilView(m_pDepthStencilBuffer, &m_DepthStencilSave.depthStencilViewDesc, &m_pDepthStencilView);
 	RS_D311_ASSERT_CHECK(result, "Could not initiate DirectX11: Failed to create the depth stencil view!");
-
-	m_ShouldBindDepthStencilView = true;
 }
 
 uint32 Pipeline::GenID()
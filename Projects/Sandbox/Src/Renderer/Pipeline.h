@@ -86,14 +86,6 @@ namespace RS
 			D3D11_TEXTURE2D_DESC			depthBufferDesc;
 		};
 
-		struct Binded
-		{
-			uint32 RasterizerID			= 0;
-			uint32 DepthStencilStateID	= 0;
-			uint32 DepthStencilViewID	= 0;
-			uint32 RTVsID				= 0;
-		};
-
 		void CreateDepthState();
 		void CreateDepthStencilView();
 
@@ -117,11 +109,6 @@ namespace RS
 
 		// Used for binding.
 		BindType					m_RTVAndDSVType					= BindType::BOTH;
-		bool						m_ShouldBindRasterizerState		= true;
-		bool						m_ShouldBindDepthStencilState	= true;
-		bool						m_ShouldBindDepthStencilView	= true;
-		bool						m_ShouldBindRTVs				= true;
 		uint32						m_ID							= 0;
-		inline static Binded		s_CurrentBindedStates;
 	};
 }
\ No newline at end of file
@@ -40,6 +40,23 @@ void RenderAPI::Init(DisplayDescription& displayDescriptor)
 	m_pFactory = nullptr;
 }
 
+void RenderAPI::InitWithoutDisplay()
+{
+	HRESULT result = CreateDXGIFactory(__uuidof(IDXGIFactory2), (void**)&m_pFactory);
+	RS_D311_ASSERT_CHECK(result, "Could not initiate DirectX11: Failed to create the DirectX factory object!");
+
+	std::vector <IDXGIAdapter*> adapters = EnumerateAdapters();
+	IDXGIAdapter* pAdapter = ChooseAdapter(adapters);
+	FillVideoCardInfo(pAdapter);
+
+	CreateDevice(pAdapter, D3D_DRIVER_TYPE::D3D_DRIVER_TYPE_UNKNOWN);
+
+	for (auto& ad : adapters)
+		ad->Release();
+	m_pFactory->Release();
+	m_pFactory = nullptr;
+}
+
 void RenderAPI::Release()
 {
 	// Before shutting down set to windowed mode or when you release the swap chain it will throw an exception.
@@ -32,6 +32,11 @@ namespace RS
 		static std::shared_ptr<RenderAPI> Get();
 
 		void Init(DisplayDescription& displayDescriptor);
+
+		/*
+		* Create the device on the same adapter as Init, without a swap chain, for tools which do not open a window.
+		*/
+		void InitWithoutDisplay();
 		void Release();
 
 		VideoCardInfo& GetVideoCardInfo();
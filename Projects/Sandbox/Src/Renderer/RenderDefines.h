@@ -12,4 +12,35 @@ namespace RS
 		RENDER_FLAG_METALLIC_TEXTURE			= FLAG(4),
 		RENDER_FLAG_ROUGHNESS_TEXTURE			= FLAG(5)
 	};
-}
\ No newline at end of file
+
+	/*
+	* The keywords of the material shader variants, see ShaderPermutations. The debug keywords are exclusive.
+	*/
+	using MaterialKeywords = uint32;
+	enum MaterialKeyword : MaterialKeywords
+	{
+		MATERIAL_KEYWORD_COMBINED_METALLIC_ROUGHNESS	= FLAG(0),
+		MATERIAL_KEYWORD_DIFFUSE_IBL					= FLAG(1),
+		MATERIAL_KEYWORD_SPECULAR_IBL					= FLAG(2),
+		MATERIAL_KEYWORD_DEBUG_ALBEDO					= FLAG(3),
+		MATERIAL_KEYWORD_DEBUG_NORMAL					= FLAG(4),
+		MATERIAL_KEYWORD_DEBUG_AO						= FLAG(5),
+		MATERIAL_KEYWORD_DEBUG_METALLIC					= FLAG(6),
+		MATERIAL_KEYWORD_DEBUG_ROUGHNESS				= FLAG(7),
+		MATERIAL_KEYWORD_DEBUG_METALLIC_ROUGHNESS		= FLAG(8)
+	};
+
+	// The defines in the shaders, in the same order as the bits of MaterialKeyword.
+	inline const std::vector<std::string> MATERIAL_KEYWORD_NAMES =
+	{
+		"COMBINED_METALLIC_ROUGHNESS",
+		"DIFFUSE_IBL",
+		"SPECULAR_IBL",
+		"DEBUG_ALBEDO",
+		"DEBUG_NORMAL",
+		"DEBUG_AO",
+		"DEBUG_METALLIC",
+		"DEBUG_ROUGHNESS",
+		"DEBUG_METALLIC_ROUGHNESS"
+	};
+}
@@ -0,0 +1,565 @@
+#include "PreCompiled.h"
+#include "RenderGraph.h"
+
+#include "Renderer/RenderUtils.h"
+#include "Renderer/StateCache.h"
+#include "Utils/Timer.h"
+
+#include <algorithm>
+
+using namespace RS;
+
+namespace
+{
+	bool Contains(const std::vector<uint32>& list, uint32 value)
+	{
+		return std::find(list.begin(), list.end(), value) != list.end();
+	}
+}
+
+void RenderGraph::Clear()
+{
+	ReleaseImportedViews();
+	ReleasePhysicalTextures();
+	m_Textures.clear();
+	m_Passes.clear();
+	m_PhysicalDescs.clear();
+	m_IsCompiled = false;
+}
+
+uint32 RenderGraph::CreateTexture(const std::string& name, const TextureDesc& desc)
+{
+	TextureNode node;
+	node.Name = name;
+	node.Desc = desc;
+	m_Textures.push_back(node);
+	m_IsCompiled = false;
+	return (uint32)m_Textures.size() - 1;
+}
+
+uint32 RenderGraph::ImportTexture(const std::string& name, ID3D11Texture2D* pTexture)
+{
+	TextureDesc desc;
+	if (pTexture)
+	{
+		D3D11_TEXTURE2D_DESC textureDesc = {};
+		pTexture->GetDesc(&textureDesc);
+		desc.Width		= textureDesc.Width;
+		desc.Height		= textureDesc.Height;
+		desc.Format		= textureDesc.Format;
+		desc.MipLevels	= textureDesc.MipLevels;
+		desc.ArraySize	= textureDesc.ArraySize;
+		desc.IsDepth	= (textureDesc.BindFlags & D3D11_BIND_DEPTH_STENCIL) != 0;
+
+		// Depth textures which are also read are typeless, the desc holds the format of the depth stencil view.
+		if (desc.IsDepth)
+			desc.Format = RenderUtils::GetDepthFormatFromTypeless(textureDesc.Format);
+	}
+	return ImportTexture(name, pTexture, desc);
+}
+
+uint32 RenderGraph::ImportTexture(const std::string& name, ID3D11Texture2D* pTexture, const TextureDesc& desc)
+{
+	TextureNode node;
+	node.Name		= name;
+	node.Desc		= desc;
+	node.pImported	= pTexture;
+	node.IsImported	= true;
+	m_Textures.push_back(node);
+	m_IsCompiled = false;
+	return (uint32)m_Textures.size() - 1;
+}
+
+uint32 RenderGraph::AddPass(const std::string& name, ExecuteFunc execute)
+{
+	PassNode node;
+	node.Name		= name;
+	node.Execute	= execute;
+	m_Passes.push_back(node);
+	m_IsCompiled = false;
+	return (uint32)m_Passes.size() - 1;
+}
+
+void RenderGraph::Read(uint32 pass, uint32 texture)
+{
+	if (!IsValidPass(pass) || !IsValidTexture(texture))
+		return;
+
+	if (!Contains(m_Passes[pass].Reads, texture))
+		m_Passes[pass].Reads.push_back(texture);
+	m_IsCompiled = false;
+}
+
+void RenderGraph::Write(uint32 pass, uint32 texture)
+{
+	if (!IsValidPass(pass) || !IsValidTexture(texture))
+		return;
+
+	if (!Contains(m_Passes[pass].Writes, texture))
+		m_Passes[pass].Writes.push_back(texture);
+	m_IsCompiled = false;
+}
+
+void RenderGraph::SetSideEffect(uint32 pass)
+{
+	if (!IsValidPass(pass))
+		return;
+
+	m_Passes[pass].HasSideEffect = true;
+	m_IsCompiled = false;
+}
+
+bool RenderGraph::Compile()
+{
+	Timer timer;
+	timer.Start();
+
+	m_IsCompiled = false;
+	m_Stats = Stats();
+	m_PhysicalDescs.clear();
+	for (TextureNode& texture : m_Textures)
+	{
+		texture.Physical	= INVALID_INDEX;
+		texture.FirstPass	= INVALID_INDEX;
+		texture.LastPass	= 0;
+	}
+
+	CullPasses();
+	if (!Validate())
+		return false;
+
+	ComputeLifetimes();
+	AliasTextures();
+	PlaceTransitions();
+	ComputeMemoryStats();
+
+	m_Stats.NumPasses		= (uint32)m_Passes.size();
+	m_Stats.CompileTimeMS	= timer.Stop().GetDeltaTimeMS();
+	m_IsCompiled = true;
+	return true;
+}
+
+bool RenderGraph::Execute()
+{
+	if (!m_IsCompiled)
+	{
+		LOG_WARNING("The render graph has to be compiled before it is executed!");
+		return false;
+	}
+
+	std::shared_ptr<RenderTargetPool> pool = RenderTargetPool::Get();
+	ReleasePhysicalTextures();
+	for (const TextureDesc& desc : m_PhysicalDescs)
+	{
+		RenderTargetPool::Desc poolDesc;
+		poolDesc.Width		= desc.Width;
+		poolDesc.Height		= desc.Height;
+		poolDesc.Format		= desc.Format;
+		poolDesc.BindFlags	= D3D11_BIND_SHADER_RESOURCE | (desc.IsDepth ? D3D11_BIND_DEPTH_STENCIL : D3D11_BIND_RENDER_TARGET);
+		poolDesc.MipLevels	= desc.MipLevels;
+		poolDesc.ArraySize	= desc.ArraySize;
+
+		RenderTargetPool::Target* pTarget = pool->Acquire(poolDesc);
+		if (pTarget == nullptr)
+		{
+			LOG_ERROR("Failed to get physical texture {} of the render graph!", (uint32)m_PhysicalTargets.size());
+			ReleasePhysicalTextures();
+			return false;
+		}
+		m_PhysicalTargets.push_back(pTarget);
+	}
+
+	ReleaseImportedViews();
+	for (uint32 textureIndex = 0; textureIndex < (uint32)m_Textures.size(); textureIndex++)
+	{
+		TextureNode& texture = m_Textures[textureIndex];
+		if (texture.IsImported)
+		{
+			if (texture.FirstPass == INVALID_INDEX || texture.pImported == nullptr)
+				continue;
+
+			bool read = false;
+			bool write = false;
+			for (const PassNode& pass : m_Passes)
+			{
+				if (pass.IsCulled)
+					continue;
+				read |= Contains(pass.Reads, textureIndex);
+				write |= Contains(pass.Writes, textureIndex);
+			}
+			if (!CreateViews(texture.pImported, texture.Desc, read, write, &texture.pSRV, &texture.pRTV, &texture.pDSV))
+			{
+				LOG_ERROR("Failed to create the views of imported texture {} in the render graph!", texture.Name.c_str());
+				ReleaseImportedViews();
+				ReleasePhysicalTextures();
+				return false;
+			}
+		}
+		else if (texture.Physical != INVALID_INDEX)
+		{
+			const RenderTargetPool::Target* pTarget = m_PhysicalTargets[texture.Physical];
+			texture.pSRV = pTarget->pSRV;
+			texture.pRTV = pTarget->pRTV;
+			texture.pDSV = pTarget->pDSV;
+		}
+	}
+
+	std::shared_ptr<StateCache> stateCache = StateCache::Get();
+	ID3D11RenderTargetView* nullRTVs = nullptr;
+	for (PassNode& pass : m_Passes)
+	{
+		if (pass.IsCulled)
+			continue;
+
+		// A texture which was written by an earlier pass might still be bound as a render target, the context would not bind it as a shader resource.
+		bool unbindTargets = std::any_of(pass.Transitions.begin(), pass.Transitions.end(), [](const Transition& transition)
+		{
+			return transition.Before == Access::WRITE && transition.After == Access::READ;
+		});
+		if (unbindTargets)
+			stateCache->SetRenderTargets(1, &nullRTVs, nullptr);
+
+		if (pass.Execute)
+			pass.Execute(*this);
+	}
+
+	// Reset render target
+	stateCache->SetRenderTargets(1, &nullRTVs, nullptr);
+	ReleaseImportedViews();
+	ReleasePhysicalTextures();
+	return true;
+}
+
+ID3D11Texture2D* RenderGraph::GetTexture(uint32 texture) const
+{
+	if (!IsValidTexture(texture))
+		return nullptr;
+
+	const TextureNode& node = m_Textures[texture];
+	if (node.IsImported)
+		return node.pImported;
+	return node.Physical < (uint32)m_PhysicalTargets.size() ? m_PhysicalTargets[node.Physical]->pTexture : nullptr;
+}
+
+ID3D11ShaderResourceView* RenderGraph::GetShaderResourceView(uint32 texture) const
+{
+	return IsValidTexture(texture) ? m_Textures[texture].pSRV : nullptr;
+}
+
+ID3D11RenderTargetView* RenderGraph::GetRenderTargetView(uint32 texture) const
+{
+	return IsValidTexture(texture) ? m_Textures[texture].pRTV : nullptr;
+}
+
+ID3D11DepthStencilView* RenderGraph::GetDepthStencilView(uint32 texture) const
+{
+	return IsValidTexture(texture) ? m_Textures[texture].pDSV : nullptr;
+}
+
+const RenderGraph::TextureDesc& RenderGraph::GetDesc(uint32 texture) const
+{
+	return m_Textures[texture].Desc;
+}
+
+bool RenderGraph::IsCulled(uint32 pass) const
+{
+	return IsValidPass(pass) && m_Passes[pass].IsCulled;
+}
+
+uint32 RenderGraph::GetPhysicalIndex(uint32 texture) const
+{
+	return IsValidTexture(texture) ? m_Textures[texture].Physical : INVALID_INDEX;
+}
+
+const std::vector<RenderGraph::Transition>& RenderGraph::GetTransitions(uint32 pass) const
+{
+	return m_Passes[pass].Transitions;
+}
+
+const RenderGraph::Stats& RenderGraph::GetStats() const
+{
+	return m_Stats;
+}
+
+bool RenderGraph::IsValidPass(uint32 pass) const
+{
+	if (pass < (uint32)m_Passes.size())
+		return true;
+
+	LOG_WARNING("Render graph pass {} does not exist!", pass);
+	return false;
+}
+
+bool RenderGraph::IsValidTexture(uint32 texture) const
+{
+	if (texture < (uint32)m_Textures.size())
+		return true;
+
+	LOG_WARNING("Render graph texture {} does not exist!", texture);
+	return false;
+}
+
+void RenderGraph::CullPasses()
+{
+	// Walk the passes backwards, a pass is needed if it writes to a texture which a later needed pass reads.
+	// A texture which is written by more than one pass keeps all of them, since each can write a part of it.
+	std::vector<bool> isRead(m_Textures.size(), false);
+	for (uint32 passIndex = (uint32)m_Passes.size(); passIndex-- > 0;)
+	{
+		PassNode& pass = m_Passes[passIndex];
+		bool isNeeded = pass.HasSideEffect;
+		for (uint32 texture : pass.Writes)
+			isNeeded |= m_Textures[texture].IsImported || isRead[texture];
+
+		pass.IsCulled = !isNeeded;
+		pass.Transitions.clear();
+		if (pass.IsCulled)
+		{
+			m_Stats.NumCulledPasses++;
+			continue;
+		}
+
+		for (uint32 texture : pass.Reads)
+			isRead[texture] = true;
+	}
+}
+
+bool RenderGraph::Validate() const
+{
+	bool isValid = true;
+	std::vector<bool> isWritten(m_Textures.size(), false);
+	for (const PassNode& pass : m_Passes)
+	{
+		if (pass.IsCulled)
+			continue;
+
+		for (uint32 texture : pass.Reads)
+		{
+			const TextureNode& node = m_Textures[texture];
+			if (Contains(pass.Writes, texture))
+			{
+				LOG_ERROR("Render graph pass {} reads and writes texture {}, a texture cannot be bound as a shader resource and a target at the same time!", pass.Name.c_str(), node.Name.c_str());
+				isValid = false;
+			}
+			else if (!node.IsImported && !isWritten[texture])
+			{
+				LOG_ERROR("Render graph pass {} reads transient texture {} before any pass writes to it!", pass.Name.c_str(), node.Name.c_str());
+				isValid = false;
+			}
+		}
+
+		for (uint32 texture : pass.Writes)
+			isWritten[texture] = true;
+	}
+	return isValid;
+}
+
+void RenderGraph::ComputeLifetimes()
+{
+	for (uint32 passIndex = 0; passIndex < (uint32)m_Passes.size(); passIndex++)
+	{
+		const PassNode& pass = m_Passes[passIndex];
+		if (pass.IsCulled)
+			continue;
+
+		auto Use = [&](uint32 texture)
+		{
+			TextureNode& node = m_Textures[texture];
+			node.FirstPass	= std::min(node.FirstPass, passIndex);
+			node.LastPass	= std::max(node.LastPass, passIndex);
+		};
+		std::for_each(pass.Reads.begin(), pass.Reads.end(), Use);
+		std::for_each(pass.Writes.begin(), pass.Writes.end(), Use);
+	}
+}
+
+void RenderGraph::AliasTextures()
+{
+	std::vector<uint32> transients;
+	for (uint32 texture = 0; texture < (uint32)m_Textures.size(); texture++)
+	{
+		if (!m_Textures[texture].IsImported && m_Textures[texture].FirstPass != INVALID_INDEX)
+			transients.push_back(texture);
+	}
+	std::stable_sort(transients.begin(), transients.end(), [&](uint32 a, uint32 b)
+	{
+		return m_Textures[a].FirstPass < m_Textures[b].FirstPass;
+	});
+
+	// Give each texture the physical texture which was free the longest, such that the reuse is spread out.
+	std::vector<uint32> physicalLastPass;
+	for (uint32 texture : transients)
+	{
+		TextureNode& node = m_Textures[texture];
+		uint32 bestPhysical = INVALID_INDEX;
+		for (uint32 physical = 0; physical < (uint32)m_PhysicalDescs.size(); physical++)
+		{
+			if (m_PhysicalDescs[physical] != node.Desc || physicalLastPass[physical] >= node.FirstPass)
+				continue;
+			if (bestPhysical == INVALID_INDEX || physicalLastPass[physical] < physicalLastPass[bestPhysical])
+				bestPhysical = physical;
+		}
+
+		if (bestPhysical == INVALID_INDEX)
+		{
+			bestPhysical = (uint32)m_PhysicalDescs.size();
+			m_PhysicalDescs.push_back(node.Desc);
+			physicalLastPass.push_back(0);
+		}
+
+		node.Physical = bestPhysical;
+		physicalLastPass[bestPhysical] = node.LastPass;
+	}
+
+	m_Stats.NumTransientTextures	= (uint32)transients.size();
+	m_Stats.NumPhysicalTextures		= (uint32)m_PhysicalDescs.size();
+}
+
+void RenderGraph::PlaceTransitions()
+{
+	std::vector<Access> state(m_Textures.size(), Access::NONE);
+	for (PassNode& pass : m_Passes)
+	{
+		if (pass.IsCulled)
+			continue;
+
+		auto Transit = [&](uint32 texture, Access access)
+		{
+			if (state[texture] == access)
+				return;
+			pass.Transitions.push_back({ texture, state[texture], access });
+			state[texture] = access;
+		};
+		for (uint32 texture : pass.Reads)
+			Transit(texture, Access::READ);
+		for (uint32 texture : pass.Writes)
+			Transit(texture, Access::WRITE);
+		m_Stats.NumTransitions += (uint32)pass.Transitions.size();
+	}
+}
+
+void RenderGraph::ComputeMemoryStats()
+{
+	auto GetSize = [](const TextureDesc& desc)->uint64
+	{
+		return RenderUtils::EstimateTextureSize(desc.Format, desc.Width, desc.Height, desc.MipLevels, desc.ArraySize);
+	};
+
+	// The change of live memory at each pass, a texture is alive from its first to its last pass.
+	std::vector<int64> liveDelta(m_Passes.size() + 1, 0);
+	for (const TextureNode& texture : m_Textures)
+	{
+		if (texture.Physical == INVALID_INDEX)
+			continue;
+
+		uint64 size = GetSize(texture.Desc);
+		m_Stats.NonAliasedBytes += size;
+		liveDelta[texture.FirstPass] += (int64)size;
+		liveDelta[texture.LastPass + 1] -= (int64)size;
+	}
+
+	int64 liveBytes = 0;
+	for (int64 delta : liveDelta)
+	{
+		liveBytes += delta;
+		m_Stats.PeakLiveBytes = std::max(m_Stats.PeakLiveBytes, (uint64)liveBytes);
+	}
+
+	for (const TextureDesc& desc : m_PhysicalDescs)
+		m_Stats.AliasedBytes += GetSize(desc);
+}
+
+void RenderGraph::ReleasePhysicalTextures()
+{
+	std::shared_ptr<RenderTargetPool> pool = RenderTargetPool::Get();
+	for (RenderTargetPool::Target* pTarget : m_PhysicalTargets)
+		pool->Release(pTarget);
+	m_PhysicalTargets.clear();
+}
+
+bool RenderGraph::CreateViews(ID3D11Texture2D* pTexture, const TextureDesc& desc, bool read, bool write,
+	ID3D11ShaderResourceView** ppSRV, ID3D11RenderTargetView** ppRTV, ID3D11DepthStencilView** ppDSV)
+{
+	ID3D11Device* pDevice = RenderAPI::Get()->GetDevice();
+	bool isArray = desc.ArraySize > 1;
+
+	DXGI_FORMAT shaderResourceFormat = desc.Format;
+	if (desc.IsDepth)
+	{
+		DXGI_FORMAT textureFormat;
+		if (!RenderUtils::GetDepthFormats(desc.Format, textureFormat, shaderResourceFormat))
+			read = false;
+	}
+
+	if (read)
+	{
+		D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+		srvDesc.Format = shaderResourceFormat;
+		if (isArray)
+		{
+			srvDesc.ViewDimension					= D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+			srvDesc.Texture2DArray.MipLevels		= desc.MipLevels;
+			srvDesc.Texture2DArray.ArraySize		= desc.ArraySize;
+		}
+		else
+		{
+			srvDesc.ViewDimension					= D3D11_SRV_DIMENSION_TEXTURE2D;
+			srvDesc.Texture2D.MipLevels				= desc.MipLevels;
+		}
+		if (FAILED(pDevice->CreateShaderResourceView(pTexture, &srvDesc, ppSRV)))
+			return false;
+	}
+
+	if (write && desc.IsDepth)
+	{
+		D3D11_DEPTH_STENCIL_VIEW_DESC dsvDesc = {};
+		dsvDesc.Format = desc.Format;
+		if (isArray)
+		{
+			dsvDesc.ViewDimension					= D3D11_DSV_DIMENSION_TEXTURE2DARRAY;
+			dsvDesc.Texture2DArray.ArraySize		= desc.ArraySize;
+		}
+		else
+		{
+			dsvDesc.ViewDimension					= D3D11_DSV_DIMENSION_TEXTURE2D;
+		}
+		if (FAILED(pDevice->CreateDepthStencilView(pTexture, &dsvDesc, ppDSV)))
+			return false;
+	}
+	else if (write)
+	{
+		D3D11_RENDER_TARGET_VIEW_DESC rtvDesc = {};
+		rtvDesc.Format = desc.Format;
+		if (isArray)
+		{
+			rtvDesc.ViewDimension					= D3D11_RTV_DIMENSION_TEXTURE2DARRAY;
+			rtvDesc.Texture2DArray.ArraySize		= desc.ArraySize;
+		}
+		else
+		{
+			rtvDesc.ViewDimension					= D3D11_RTV_DIMENSION_TEXTURE2D;
+		}
+		if (FAILED(pDevice->CreateRenderTargetView(pTexture, &rtvDesc, ppRTV)))
+			return false;
+	}
+	return true;
+}
+
+void RenderGraph::ReleaseImportedViews()
+{
+	for (TextureNode& texture : m_Textures)
+	{
+		if (texture.IsImported)
+		{
+			if (texture.pSRV)
+				texture.pSRV->Release();
+			if (texture.pRTV)
+				texture.pRTV->Release();
+			if (texture.pDSV)
+				texture.pDSV->Release();
+		}
+		texture.pSRV = nullptr;
+		texture.pRTV = nullptr;
+		texture.pDSV = nullptr;
+	}
+}
@@ -0,0 +1,182 @@
+#pragma once
+
+#include "Renderer/RenderAPI.h"
+#include "Renderer/RenderTargetPool.h"
+
+#include <functional>
+
+namespace RS
+{
+	/*
+	* A graph of the render passes of a frame, where each pass declares which textures it reads and writes.
+	* Compile works on the declarations only and does not use the device:
+	*	- Passes whose writes are never read are culled, unless they write to an imported texture or are marked with SetSideEffect.
+	*	- The transitions between reading and writing a texture are placed before the pass which needs them.
+	*	- Transient textures whose lifetimes do not overlap share the same physical texture, if their descriptions are the same.
+	* Execute takes the physical textures from the RenderTargetPool, runs the passes which were not culled in the order they were added and gives the textures back.
+	* Example:
+	*	RenderGraph renderGraph;
+	*	uint32 gBuffer = renderGraph.CreateTexture("GBuffer", { width, height, DXGI_FORMAT_R16G16B16A16_FLOAT });
+	*	uint32 output = renderGraph.ImportTexture("Output", pOutputTexture);
+	*	uint32 geometryPass = renderGraph.AddPass("Geometry", [&](RenderGraph& graph) { ... graph.GetRenderTargetView(gBuffer) ... });
+	*	renderGraph.Write(geometryPass, gBuffer);
+	*	uint32 lightPass = renderGraph.AddPass("Light", [&](RenderGraph& graph) { ... graph.GetShaderResourceView(gBuffer) ... });
+	*	renderGraph.Read(lightPass, gBuffer);
+	*	renderGraph.Write(lightPass, output);
+	*	if (renderGraph.Compile())
+	*		renderGraph.Execute();
+	*/
+	class RenderGraph
+	{
+	public:
+		static const uint32 INVALID_INDEX = UINT32_MAX;
+
+		enum class Access : uint32
+		{
+			NONE = 0,	// The content is not defined, the first use of a texture.
+			READ,		// Shader resource view.
+			WRITE		// Render target view or depth stencil view.
+		};
+
+		struct TextureDesc
+		{
+			uint32		Width		= 0;
+			uint32		Height		= 0;
+			DXGI_FORMAT	Format		= DXGI_FORMAT_R8G8B8A8_UNORM;
+			uint32		MipLevels	= 1;
+			uint32		ArraySize	= 1;
+			bool		IsDepth		= false; // Written through a depth stencil view instead of a render target view. The format is the format of the depth stencil view.
+
+			bool operator==(const TextureDesc& other) const = default;
+		};
+
+		struct Transition
+		{
+			uint32	Resource	= INVALID_INDEX;
+			Access	Before		= Access::NONE;
+			Access	After		= Access::NONE;
+		};
+
+		struct Stats
+		{
+			uint32	NumPasses				= 0;
+			uint32	NumCulledPasses			= 0;
+			uint32	NumTransientTextures	= 0; // Transient textures used by passes which were not culled.
+			uint32	NumPhysicalTextures		= 0;
+			uint32	NumTransitions			= 0;
+			uint64	NonAliasedBytes			= 0; // Memory of the transient textures if each had its own physical texture.
+			uint64	AliasedBytes			= 0; // Memory of the physical textures.
+			uint64	PeakLiveBytes			= 0; // The most memory of the transient textures which are alive at the same pass, the least aliasing could get to.
+			float	CompileTimeMS			= 0.f;
+		};
+
+		using ExecuteFunc = std::function<void(RenderGraph& graph)>;
+
+	public:
+		RS_DEFAULT_CLASS(RenderGraph);
+
+		/*
+		* Remove all passes and textures, to build the graph of a new frame.
+		*/
+		void Clear();
+
+		/*
+		* A texture which is only alive during the frame, it has no content before the first pass which writes to it.
+		* Returns the index of the texture.
+		*/
+		uint32 CreateTexture(const std::string& name, const TextureDesc& desc);
+
+		/*
+		* A texture which is owned outside of the graph. Passes which write to it are never culled, and it is never aliased.
+		* Returns the index of the texture.
+		*/
+		uint32 ImportTexture(const std::string& name, ID3D11Texture2D* pTexture);
+		uint32 ImportTexture(const std::string& name, ID3D11Texture2D* pTexture, const TextureDesc& desc);
+
+		/*
+		* Returns the index of the pass.
+		*/
+		uint32 AddPass(const std::string& name, ExecuteFunc execute);
+		void Read(uint32 pass, uint32 texture);
+		void Write(uint32 pass, uint32 texture);
+
+		/*
+		* The pass is never culled, for passes which write to something the graph does not know about.
+		*/
+		void SetSideEffect(uint32 pass);
+
+		/*
+		* Cull the passes, place the transitions and alias the transient textures.
+		* Returns false if the graph is not valid, a transient texture which is read before it is written or a texture which is read and written by the same pass.
+		*/
+		bool Compile();
+
+		/*
+		* Run the passes which were not culled, Compile has to be called first.
+		*/
+		bool Execute();
+
+		// Only valid in the execute function of a pass which uses the texture.
+		ID3D11Texture2D* GetTexture(uint32 texture) const;
+		ID3D11ShaderResourceView* GetShaderResourceView(uint32 texture) const;
+		ID3D11RenderTargetView* GetRenderTargetView(uint32 texture) const;
+		ID3D11DepthStencilView* GetDepthStencilView(uint32 texture) const;
+
+		const TextureDesc& GetDesc(uint32 texture) const;
+		bool IsCulled(uint32 pass) const;
+		uint32 GetPhysicalIndex(uint32 texture) const; // INVALID_INDEX for imported and unused textures.
+		const std::vector<Transition>& GetTransitions(uint32 pass) const;
+		const Stats& GetStats() const;
+
+	private:
+		struct TextureNode
+		{
+			std::string					Name;
+			TextureDesc					Desc;
+			ID3D11Texture2D*			pImported		= nullptr;
+			bool						IsImported		= false;
+			uint32						Physical		= INVALID_INDEX;
+			uint32						FirstPass		= INVALID_INDEX;
+			uint32						LastPass		= 0;
+
+			// The views used during Execute. They are owned by the node for imported textures, otherwise by the render target pool.
+			ID3D11ShaderResourceView*	pSRV			= nullptr;
+			ID3D11RenderTargetView*		pRTV			= nullptr;
+			ID3D11DepthStencilView*		pDSV			= nullptr;
+		};
+
+		struct PassNode
+		{
+			std::string				Name;
+			ExecuteFunc				Execute;
+			std::vector<uint32>		Reads;
+			std::vector<uint32>		Writes;
+			std::vector<Transition>	Transitions;
+			bool					HasSideEffect	= false;
+			bool					IsCulled		= false;
+		};
+
+		bool IsValidPass(uint32 pass) const;
+		bool IsValidTexture(uint32 texture) const;
+
+		void CullPasses();
+		bool Validate() const;
+		void ComputeLifetimes();
+		void AliasTextures();
+		void PlaceTransitions();
+		void ComputeMemoryStats();
+
+		void ReleasePhysicalTextures();
+		static bool CreateViews(ID3D11Texture2D* pTexture, const TextureDesc& desc, bool read, bool write,
+			ID3D11ShaderResourceView** ppSRV, ID3D11RenderTargetView** ppRTV, ID3D11DepthStencilView** ppDSV);
+		void ReleaseImportedViews();
+
+	private:
+		std::vector<TextureNode>				m_Textures;
+		std::vector<PassNode>					m_Passes;
+		std::vector<TextureDesc>				m_PhysicalDescs; // The physical textures the compiled graph needs.
+		std::vector<RenderTargetPool::Target*>	m_PhysicalTargets; // Only during Execute.
+		bool									m_IsCompiled	= false;
+		Stats									m_Stats;
+	};
+}
@@ -0,0 +1,264 @@
+#include "PreCompiled.h"
+#include "RenderTargetPool.h"
+
+#include "Renderer/RenderUtils.h"
+
+#include <algorithm>
+
+using namespace RS;
+
+std::shared_ptr<RenderTargetPool> RenderTargetPool::Get()
+{
+	static std::shared_ptr<RenderTargetPool> s_Pool = std::make_shared<RenderTargetPool>();
+	return s_Pool;
+}
+
+void RenderTargetPool::Init(ID3D11Device* pDevice, uint32 maxUnusedFrames, uint64 budgetBytes)
+{
+	m_pDevice				= pDevice;
+	m_MaxUnusedFrames		= maxUnusedFrames;
+	m_Stats.BudgetBytes		= budgetBytes;
+}
+
+void RenderTargetPool::Release()
+{
+	if (m_Stats.NumInUse > 0)
+		LOG_WARNING("Render target pool is released with {} targets still in use!", m_Stats.NumInUse);
+
+	LOG_INFO("Render target pool: {} hits, {} misses, {} evicted.", m_Stats.NumHits, m_Stats.NumMisses, m_Stats.NumEvicted);
+
+	for (Entry& entry : m_Entries)
+		ReleaseTarget(entry.Value);
+	m_Entries.clear();
+
+	uint64 budgetBytes = m_Stats.BudgetBytes;
+	m_Stats = Stats();
+	m_Stats.BudgetBytes = budgetBytes;
+	m_pDevice = nullptr;
+}
+
+void RenderTargetPool::NewFrame()
+{
+	m_FrameIndex++;
+	for (auto it = m_Entries.begin(); it != m_Entries.end();)
+	{
+		auto next = std::next(it);
+		if (!it->IsInUse && m_FrameIndex - it->LastUsedFrame > m_MaxUnusedFrames)
+			Evict(it);
+		it = next;
+	}
+}
+
+void RenderTargetPool::EvictFree()
+{
+	for (auto it = m_Entries.begin(); it != m_Entries.end();)
+	{
+		auto next = std::next(it);
+		if (!it->IsInUse)
+			Evict(it);
+		it = next;
+	}
+}
+
+RenderTargetPool::Target* RenderTargetPool::Acquire(const Desc& desc)
+{
+	// Take the free texture which was used last, such that the others can age out.
+	Entry* pBest = nullptr;
+	for (Entry& entry : m_Entries)
+	{
+		if (entry.IsInUse || !(entry.Value.Description == desc))
+			continue;
+		if (pBest == nullptr || entry.LastUsedFrame > pBest->LastUsedFrame)
+			pBest = &entry;
+	}
+
+	if (pBest)
+	{
+		pBest->IsInUse			= true;
+		pBest->LastUsedFrame	= m_FrameIndex;
+		m_Stats.NumHits++;
+		m_Stats.NumInUse++;
+		m_Stats.BytesInUse += pBest->Value.Bytes;
+		return &pBest->Value;
+	}
+
+	Entry entry;
+	if (!CreateTarget(entry.Value, desc))
+	{
+		ReleaseTarget(entry.Value);
+		LOG_ERROR("Failed to create a {}x{} {} texture for the render target pool!", desc.Width, desc.Height, RenderUtils::FormatToString(desc.Format).c_str());
+		return nullptr;
+	}
+
+	entry.IsInUse		= true;
+	entry.LastUsedFrame	= m_FrameIndex;
+	m_Entries.push_back(entry);
+	m_Stats.NumMisses++;
+	m_Stats.NumTargets++;
+	m_Stats.NumInUse++;
+	m_Stats.BytesHeld += entry.Value.Bytes;
+	m_Stats.BytesInUse += entry.Value.Bytes;
+
+	// The new texture is in use, so only the free ones can be released to get under the budget.
+	EnforceBudget();
+	return &m_Entries.back().Value;
+}
+
+void RenderTargetPool::Release(Target* pTarget)
+{
+	if (pTarget == nullptr)
+		return;
+
+	auto it = std::find_if(m_Entries.begin(), m_Entries.end(), [&](const Entry& entry) { return &entry.Value == pTarget; });
+	if (it == m_Entries.end() || !it->IsInUse)
+	{
+		LOG_WARNING("The target given back to the render target pool is not in use by the pool!");
+		return;
+	}
+
+	it->IsInUse			= false;
+	it->LastUsedFrame	= m_FrameIndex;
+	m_Stats.NumInUse--;
+	m_Stats.BytesInUse -= it->Value.Bytes;
+	EnforceBudget();
+}
+
+const RenderTargetPool::Stats& RenderTargetPool::GetStats() const
+{
+	return m_Stats;
+}
+
+bool RenderTargetPool::CreateTarget(Target& target, const Desc& desc)
+{
+	target.Description	= desc;
+	target.Bytes		= RenderUtils::EstimateTextureSize(desc.Format, desc.Width, desc.Height, desc.MipLevels, desc.ArraySize);
+	if (m_pDevice == nullptr)
+		return false;
+
+	bool isDepth = (desc.BindFlags & D3D11_BIND_DEPTH_STENCIL) != 0;
+	DXGI_FORMAT textureFormat = desc.Format;
+	DXGI_FORMAT shaderResourceFormat = desc.Format;
+	if (isDepth && (desc.BindFlags & D3D11_BIND_SHADER_RESOURCE) && !RenderUtils::GetDepthFormats(desc.Format, textureFormat, shaderResourceFormat))
+	{
+		LOG_ERROR("Depth format {} can not be read in shaders!", RenderUtils::FormatToString(desc.Format).c_str());
+		return false;
+	}
+
+	D3D11_TEXTURE2D_DESC textureDesc = {};
+	textureDesc.Width				= desc.Width;
+	textureDesc.Height				= desc.Height;
+	textureDesc.MipLevels			= desc.MipLevels;
+	textureDesc.ArraySize			= desc.ArraySize;
+	textureDesc.Format				= textureFormat;
+	textureDesc.SampleDesc.Count	= 1;
+	textureDesc.SampleDesc.Quality	= 0;
+	textureDesc.Usage				= D3D11_USAGE_DEFAULT;
+	textureDesc.BindFlags			= desc.BindFlags;
+	if (FAILED(m_pDevice->CreateTexture2D(&textureDesc, nullptr, &target.pTexture)))
+		return false;
+
+	bool isArray = desc.ArraySize > 1;
+	if (desc.BindFlags & D3D11_BIND_SHADER_RESOURCE)
+	{
+		D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+		srvDesc.Format = shaderResourceFormat;
+		if (isArray)
+		{
+			srvDesc.ViewDimension				= D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+			srvDesc.Texture2DArray.MipLevels	= desc.MipLevels;
+			srvDesc.Texture2DArray.ArraySize	= desc.ArraySize;
+		}
+		else
+		{
+			srvDesc.ViewDimension				= D3D11_SRV_DIMENSION_TEXTURE2D;
+			srvDesc.Texture2D.MipLevels			= desc.MipLevels;
+		}
+		if (FAILED(m_pDevice->CreateShaderResourceView(target.pTexture, &srvDesc, &target.pSRV)))
+			return false;
+	}
+
+	if (desc.BindFlags & D3D11_BIND_RENDER_TARGET)
+	{
+		D3D11_RENDER_TARGET_VIEW_DESC rtvDesc = {};
+		rtvDesc.Format = desc.Format;
+		if (isArray)
+		{
+			rtvDesc.ViewDimension				= D3D11_RTV_DIMENSION_TEXTURE2DARRAY;
+			rtvDesc.Texture2DArray.ArraySize	= desc.ArraySize;
+		}
+		else
+		{
+			rtvDesc.ViewDimension				= D3D11_RTV_DIMENSION_TEXTURE2D;
+		}
+		if (FAILED(m_pDevice->CreateRenderTargetView(target.pTexture, &rtvDesc, &target.pRTV)))
+			return false;
+	}
+
+	if (isDepth)
+	{
+		D3D11_DEPTH_STENCIL_VIEW_DESC dsvDesc = {};
+		dsvDesc.Format = desc.Format;
+		if (isArray)
+		{
+			dsvDesc.ViewDimension				= D3D11_DSV_DIMENSION_TEXTURE2DARRAY;
+			dsvDesc.Texture2DArray.ArraySize	= desc.ArraySize;
+		}
+		else
+		{
+			dsvDesc.ViewDimension				= D3D11_DSV_DIMENSION_TEXTURE2D;
+		}
+		if (FAILED(m_pDevice->CreateDepthStencilView(target.pTexture, &dsvDesc, &target.pDSV)))
+			return false;
+	}
+	return true;
+}
+
+void RenderTargetPool::ReleaseTarget(Target& target)
+{
+	if (target.pSRV)
+	{
+		target.pSRV->Release();
+		target.pSRV = nullptr;
+	}
+	if (target.pRTV)
+	{
+		target.pRTV->Release();
+		target.pRTV = nullptr;
+	}
+	if (target.pDSV)
+	{
+		target.pDSV->Release();
+		target.pDSV = nullptr;
+	}
+	if (target.pTexture)
+	{
+		target.pTexture->Release();
+		target.pTexture = nullptr;
+	}
+}
+
+void RenderTargetPool::Evict(std::list<Entry>::iterator it)
+{
+	m_Stats.NumEvicted++;
+	m_Stats.NumTargets--;
+	m_Stats.BytesHeld -= it->Value.Bytes;
+	ReleaseTarget(it->Value);
+	m_Entries.erase(it);
+}
+
+void RenderTargetPool::EnforceBudget()
+{
+	while (m_Stats.BytesHeld > m_Stats.BudgetBytes)
+	{
+		auto oldest = m_Entries.end();
+		for (auto it = m_Entries.begin(); it != m_Entries.end(); it++)
+		{
+			if (!it->IsInUse && (oldest == m_Entries.end() || it->LastUsedFrame < oldest->LastUsedFrame))
+				oldest = it;
+		}
+
+		if (oldest == m_Entries.end())
+			break;
+		Evict(oldest);
+	}
+}
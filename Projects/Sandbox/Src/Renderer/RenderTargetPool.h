@@ -0,0 +1,110 @@
+#pragma once
+
+#include "Renderer/RenderAPI.h"
+
+#include <list>
+
+namespace RS
+{
+	/*
+	* Hands out textures with their views by description, and recycles them when they are given back.
+	* A texture which has not been used for a number of frames is released, and the least recently used free textures are released when the pool holds more than its budget.
+	* The device is only used to create the textures and views, the pool can be run against a device created with D3D_DRIVER_TYPE_NULL.
+	* Example:
+	*	RenderTargetPool::Desc desc = { width, height, DXGI_FORMAT_R16G16B16A16_FLOAT };
+	*	RenderTargetPool::Target* pTarget = RenderTargetPool::Get()->Acquire(desc);
+	*	... pTarget->pRTV, pTarget->pSRV ...
+	*	RenderTargetPool::Get()->Release(pTarget);
+	*/
+	class RenderTargetPool
+	{
+	public:
+		struct Desc
+		{
+			uint32		Width		= 0;
+			uint32		Height		= 0;
+			DXGI_FORMAT	Format		= DXGI_FORMAT_R8G8B8A8_UNORM; // For depth textures this is the format of the depth stencil view.
+			uint32		BindFlags	= D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_RENDER_TARGET;
+			uint32		MipLevels	= 1;
+			uint32		ArraySize	= 1;
+
+			bool operator==(const Desc& other) const = default;
+		};
+
+		struct Target
+		{
+			Desc						Description;
+			ID3D11Texture2D*			pTexture	= nullptr;
+			ID3D11ShaderResourceView*	pSRV		= nullptr; // Only if the bind flags has D3D11_BIND_SHADER_RESOURCE.
+			ID3D11RenderTargetView*		pRTV		= nullptr; // Only if the bind flags has D3D11_BIND_RENDER_TARGET.
+			ID3D11DepthStencilView*		pDSV		= nullptr; // Only if the bind flags has D3D11_BIND_DEPTH_STENCIL.
+			uint64						Bytes		= 0;
+		};
+
+		struct Stats
+		{
+			uint32	NumHits			= 0;
+			uint32	NumMisses		= 0;
+			uint32	NumEvicted		= 0;
+			uint32	NumTargets		= 0;
+			uint32	NumInUse		= 0;
+			uint64	BytesHeld		= 0; // Memory of all textures in the pool, including the ones in use.
+			uint64	BytesInUse		= 0;
+			uint64	BudgetBytes		= 0;
+		};
+
+	public:
+		RS_DEFAULT_ABSTRACT_CLASS(RenderTargetPool);
+
+		static std::shared_ptr<RenderTargetPool> Get();
+
+		/*
+		* maxUnusedFrames: The number of frames a free texture is kept.
+		* budgetBytes: The free textures are released, least recently used first, while the pool holds more than this. Textures in use are never released.
+		*/
+		void Init(ID3D11Device* pDevice, uint32 maxUnusedFrames, uint64 budgetBytes);
+		void Release();
+
+		/*
+		* Release the textures which have been free for too long, this should be called once per frame.
+		*/
+		void NewFrame();
+
+		/*
+		* Release all textures which are not in use, for when the descriptions which were used will not be asked for again, like after the window is resized.
+		*/
+		void EvictFree();
+
+		/*
+		* Returns a free texture with the description, or creates a new one. Returns nullptr if it could not be created.
+		*/
+		Target* Acquire(const Desc& desc);
+
+		/*
+		* Give the texture back to the pool, the pointer should not be used after this.
+		*/
+		void Release(Target* pTarget);
+
+		const Stats& GetStats() const;
+
+	private:
+		struct Entry
+		{
+			Target	Value;
+			uint64	LastUsedFrame	= 0;
+			bool	IsInUse			= false;
+		};
+
+		bool CreateTarget(Target& target, const Desc& desc);
+		static void ReleaseTarget(Target& target);
+		void Evict(std::list<Entry>::iterator it);
+		void EnforceBudget();
+
+	private:
+		ID3D11Device*		m_pDevice			= nullptr;
+		uint32				m_MaxUnusedFrames	= 0;
+		uint64				m_FrameIndex		= 0;
+		std::list<Entry>	m_Entries; // A list to keep the pointers to the targets stable.
+		Stats				m_Stats;
+	};
+}
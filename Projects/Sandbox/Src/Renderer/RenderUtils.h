@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Renderer/RenderAPI.h"
+#include "Utils/Maths.h"
 
 namespace RS
 {
@@ -195,7 +196,7 @@ namespace RS
 			case DXGI_FORMAT_R10G10B10A2_TYPELESS:
 			case DXGI_FORMAT_R10G10B10A2_UNORM:
 			case DXGI_FORMAT_R10G10B10A2_UINT:
-				return 32;
+				return 4;
 				break;
 			case DXGI_FORMAT_R32G32B32_TYPELESS:
 			case DXGI_FORMAT_R32G32B32_FLOAT:
@@ -262,9 +263,11 @@ namespace RS
 			case DXGI_FORMAT_R24_UNORM_X8_TYPELESS:
 			case DXGI_FORMAT_X24_TYPELESS_G8_UINT:
 			case DXGI_FORMAT_R9G9B9E5_SHAREDEXP:
+				return 4;
+				break;
 			case DXGI_FORMAT_R8G8_B8G8_UNORM:
 			case DXGI_FORMAT_G8R8_G8B8_UNORM:
-				return 4;
+				return 2; // Four bytes are shared by two pixels.
 				break;
 			case DXGI_FORMAT_BC1_TYPELESS:
 			case DXGI_FORMAT_BC1_UNORM:
@@ -281,7 +284,7 @@ namespace RS
 			case DXGI_FORMAT_BC5_TYPELESS:
 			case DXGI_FORMAT_BC5_UNORM:
 			case DXGI_FORMAT_BC5_SNORM:
-				return 0;
+				return 0; // Block compressed formats do not have a size per pixel, use GetBlockSizeOfFormat.
 				break;
 			case DXGI_FORMAT_B5G6R5_UNORM:
 			case DXGI_FORMAT_B5G5R5A1_UNORM:
@@ -299,6 +302,113 @@ namespace RS
 			}
 		}
 
+		/*
+		* Returns true if the format stores its pixels in 4x4 blocks.
+		*/
+		static bool IsBlockCompressed(DXGI_FORMAT format)
+		{
+			return GetBlockSizeOfFormat(format) > 0;
+		}
+
+		/*
+		* Returns the size in bytes of a 4x4 block, 0 if the format is not block compressed.
+		*/
+		static uint32 GetBlockSizeOfFormat(DXGI_FORMAT format)
+		{
+			switch (format)
+			{
+			case DXGI_FORMAT_BC1_TYPELESS:
+			case DXGI_FORMAT_BC1_UNORM:
+			case DXGI_FORMAT_BC1_UNORM_SRGB:
+			case DXGI_FORMAT_BC4_TYPELESS:
+			case DXGI_FORMAT_BC4_UNORM:
+			case DXGI_FORMAT_BC4_SNORM:
+				return 8;
+				break;
+			case DXGI_FORMAT_BC2_TYPELESS:
+			case DXGI_FORMAT_BC2_UNORM:
+			case DXGI_FORMAT_BC2_UNORM_SRGB:
+			case DXGI_FORMAT_BC3_TYPELESS:
+			case DXGI_FORMAT_BC3_UNORM:
+			case DXGI_FORMAT_BC3_UNORM_SRGB:
+			case DXGI_FORMAT_BC5_TYPELESS:
+			case DXGI_FORMAT_BC5_UNORM:
+			case DXGI_FORMAT_BC5_SNORM:
+				return 16;
+				break;
+			default:
+				return 0;
+				break;
+			}
+		}
+
+		/*
+		* The formats of a depth texture which is also read in shaders. The texture has to be created with a typeless format,
+		* the depth stencil view uses the depth format and the shader resource view reads the depth channel.
+		* Returns false if the depth format is not supported.
+		*/
+		static bool GetDepthFormats(DXGI_FORMAT depthFormat, DXGI_FORMAT& textureFormat, DXGI_FORMAT& shaderResourceFormat)
+		{
+			switch (depthFormat)
+			{
+			case DXGI_FORMAT_D16_UNORM:
+				textureFormat			= DXGI_FORMAT_R16_TYPELESS;
+				shaderResourceFormat	= DXGI_FORMAT_R16_UNORM;
+				return true;
+			case DXGI_FORMAT_D24_UNORM_S8_UINT:
+				textureFormat			= DXGI_FORMAT_R24G8_TYPELESS;
+				shaderResourceFormat	= DXGI_FORMAT_R24_UNORM_X8_TYPELESS;
+				return true;
+			case DXGI_FORMAT_D32_FLOAT:
+				textureFormat			= DXGI_FORMAT_R32_TYPELESS;
+				shaderResourceFormat	= DXGI_FORMAT_R32_FLOAT;
+				return true;
+			default:
+				return false;
+			}
+		}
+
+		/*
+		* The depth format of a depth texture which was created with the typeless format of GetDepthFormats.
+		* Returns the format itself if it is not one of those typeless formats.
+		*/
+		static DXGI_FORMAT GetDepthFormatFromTypeless(DXGI_FORMAT textureFormat)
+		{
+			switch (textureFormat)
+			{
+			case DXGI_FORMAT_R16_TYPELESS:		return DXGI_FORMAT_D16_UNORM;
+			case DXGI_FORMAT_R24G8_TYPELESS:	return DXGI_FORMAT_D24_UNORM_S8_UINT;
+			case DXGI_FORMAT_R32_TYPELESS:		return DXGI_FORMAT_D32_FLOAT;
+			default:							return textureFormat;
+			}
+		}
+
+		/*
+		* Estimate how many bytes a texture uses on the device.
+		* Example:
+		*	A 256x256 DXGI_FORMAT_R8G8B8A8_UNORM texture with a full mip chain (9 levels) and one slice:
+		*		256*256*4 + 128*128*4 + ... + 1*1*4 = 349524 bytes
+		*	A 256x256 DXGI_FORMAT_BC1_UNORM texture with one mip level: (256/4)*(256/4)*8 = 32768 bytes
+		* PS: This does not include padding or alignment the driver might add.
+		*/
+		static uint64 EstimateTextureSize(DXGI_FORMAT format, uint32 width, uint32 height, uint32 mipLevels, uint32 arraySize)
+		{
+			uint32 blockSize = GetBlockSizeOfFormat(format);
+			uint32 pixelSize = blockSize > 0 ? 0 : GetSizeOfFormat(format);
+
+			uint64 sliceSize = 0;
+			for (uint32 mip = 0; mip < glm::max(mipLevels, 1u); mip++)
+			{
+				uint64 w = (uint64)glm::max(width >> mip, 1u);
+				uint64 h = (uint64)glm::max(height >> mip, 1u);
+				if (blockSize > 0)
+					sliceSize += ((w + 3) / 4) * ((h + 3) / 4) * (uint64)blockSize;
+				else
+					sliceSize += w * h * (uint64)pixelSize;
+			}
+			return sliceSize * (uint64)glm::max(arraySize, 1u);
+		}
+
 		static std::string FormatToString(DXGI_FORMAT format)
 		{
 			#define RS_FORMAT_CASE(format) case format: return #format; break;
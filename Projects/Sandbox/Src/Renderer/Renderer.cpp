@@ -5,13 +5,47 @@
 #include "Renderer/ImGuiRenderer.h"
 #include "Renderer/DebugRenderer.h"
 #include "Renderer/RenderUtils.h"
+#include "Renderer/RenderGraph.h"
+#include "Renderer/RenderTargetPool.h"
 #include "Renderer/ShaderHotReloader.h"
+#include "Renderer/ShaderBatch.h"
+#include "Renderer/StateCache.h"
 #include "Renderer/D3D11/D3D11Helper.h"
 
 #include "Utils/Config.h"
 
 using namespace RS;
 
+namespace
+{
+	// The resources of the material shaders, in the order of the binding table entries.
+	enum MaterialBinding : uint32
+	{
+		MATERIAL_BINDING_MESH_DATA = 0,
+		MATERIAL_BINDING_MATERIAL_DATA,
+		MATERIAL_BINDING_ALBEDO,
+		MATERIAL_BINDING_NORMAL,
+		MATERIAL_BINDING_AO,
+		MATERIAL_BINDING_METALLIC,
+		MATERIAL_BINDING_ROUGHNESS,
+		MATERIAL_BINDING_METALLIC_ROUGHNESS,
+		MATERIAL_BINDING_SAMPLER
+	};
+
+	const std::vector<std::string> MATERIAL_BINDING_NAMES =
+	{
+		"MeshData",
+		"MaterialData",
+		"albedoTexture",
+		"normalTexture",
+		"aoTexture",
+		"metallicTexture",
+		"roughnessTexture",
+		"metallicRoughnessTexture",
+		"linearSampler"
+	};
+}
+
 std::shared_ptr<Renderer> Renderer::Get()
 {
     static std::shared_ptr<Renderer> s_Renderer = std::make_shared<Renderer>();
@@ -21,6 +55,12 @@ std::shared_ptr<Renderer> Renderer::Get()
 void Renderer::Init(uint32 width, uint32 height, bool useBackBuffer)
 {
 	m_UseBackBuffer = useBackBuffer;
+
+	// All binds go through the state cache, so it has to be ready before the first pipeline is bound.
+	StateCache::Get()->Init(RenderAPI::Get()->GetDeviceContext(), Config::Get()->Fetch<bool>("Renderer/FilterRedundantBinds", true));
+	RenderTargetPool::Get()->Init(RenderAPI::Get()->GetDevice(),
+		Config::Get()->Fetch<uint32>("Renderer/RenderTargetPoolUnusedFrames", 120),
+		(uint64)Config::Get()->Fetch<uint32>("Renderer/RenderTargetPoolBudgetMB", 256) * 1024ull * 1024ull);
 	m_DefaultPipeline.Init();
 
 	// Fetch the device, device context and the swap chain from the DirectX api.
@@ -42,6 +82,9 @@ void Renderer::Init(uint32 width, uint32 height, bool useBackBuffer)
 
 	m_DefaultPipeline.SetViewport(0.f, 0.f, (float)width, (float)height);
 
+	// The shaders are compiled together on worker threads at the end of the function.
+	ShaderBatch shaderBatch;
+
 	// Texture format conversion resources.
 	{
 		m_TextureFormatConvertionPipeline.Init();
@@ -57,8 +100,7 @@ void Renderer::Init(uint32 width, uint32 height, bool useBackBuffer)
 		Shader::Descriptor shaderDesc	= {};
 		shaderDesc.Vertex				= "RenderTools/ScreenTriangleVert.hlsl";
 		shaderDesc.Fragment				= "RenderTools/FormatConverterFrag.hlsl";
-		m_TextureFormatConvertionShader.Load(shaderDesc, layout);
-		ShaderHotReloader::AddShader(&m_TextureFormatConvertionShader);
+		shaderBatch.Add(&m_TextureFormatConvertionShader, shaderDesc, layout);
 	}
 
 	// Equirectangular To Cubemap
@@ -76,8 +118,7 @@ void Renderer::Init(uint32 width, uint32 height, bool useBackBuffer)
 		Shader::Descriptor shaderDesc = {};
 		shaderDesc.Vertex = "RenderTools/ScreenCubeVert.hlsl";
 		shaderDesc.Fragment = "RenderTools/EquirectangularToCubemapFrag.hlsl";
-		m_EquirectangularToCubemapShader.Load(shaderDesc, layout);
-		ShaderHotReloader::AddShader(&m_EquirectangularToCubemapShader);
+		shaderBatch.Add(&m_EquirectangularToCubemapShader, shaderDesc, layout);
 
 		{
 			D3D11_BUFFER_DESC bufferDesc = {};
@@ -121,8 +162,7 @@ void Renderer::Init(uint32 width, uint32 height, bool useBackBuffer)
 		Shader::Descriptor shaderDesc = {};
 		shaderDesc.Vertex = "RenderTools/ScreenCubeVert.hlsl";
 		shaderDesc.Fragment = "PBRScene/IrradianceMapFrag.hlsl";
-		m_IrradianceMapShader.Load(shaderDesc, layout);
-		ShaderHotReloader::AddShader(&m_IrradianceMapShader);
+		shaderBatch.Add(&m_IrradianceMapShader, shaderDesc, layout);
 	}
 
 	// Pre-Filtered Environment Map
@@ -132,8 +172,7 @@ void Renderer::Init(uint32 width, uint32 height, bool useBackBuffer)
 		Shader::Descriptor shaderDesc = {};
 		shaderDesc.Vertex = "RenderTools/ScreenCubeVert.hlsl";
 		shaderDesc.Fragment = "PBRScene/PreFilteringFrag.hlsl";
-		m_PreFilteredMapShader.Load(shaderDesc, layout);
-		ShaderHotReloader::AddShader(&m_PreFilteredMapShader);
+		shaderBatch.Add(&m_PreFilteredMapShader, shaderDesc, layout);
 	}
 
 	// Pre-Computed BRDF
@@ -143,29 +182,24 @@ void Renderer::Init(uint32 width, uint32 height, bool useBackBuffer)
 		Shader::Descriptor shaderDesc = {};
 		shaderDesc.Vertex = "RenderTools/ScreenTriangleVert.hlsl";
 		shaderDesc.Fragment = "PBRScene/PreComputedBRDF.hlsl";
-		m_PreComputedBRDFShader.Load(shaderDesc, layout);
-		ShaderHotReloader::AddShader(&m_PreComputedBRDFShader);
+		shaderBatch.Add(&m_PreComputedBRDFShader, shaderDesc, layout);
 	}
+
+	shaderBatch.Load();
+	ShaderHotReloader::AddShader(&m_TextureFormatConvertionShader);
+	ShaderHotReloader::AddShader(&m_EquirectangularToCubemapShader);
+	ShaderHotReloader::AddShader(&m_IrradianceMapShader);
+	ShaderHotReloader::AddShader(&m_PreFilteredMapShader);
+	ShaderHotReloader::AddShader(&m_PreComputedBRDFShader);
 }
 
 void Renderer::Release()
 {
-	if (m_TextureFormatConvertionRTV)
-	{
-		m_TextureFormatConvertionRTV->Release();
-		m_TextureFormatConvertionRTV = nullptr;
-	}
+	m_MaterialBindingTables.clear();
+
 	m_TextureFormatConvertionShader.Release();
 	m_TextureFormatConvertionPipeline.Release();
 
-	for (auto& rtv : m_EquirectangularToCubemapRTVs)
-	{
-		if (rtv)
-		{
-			rtv->Release();
-			rtv = nullptr;
-		}
-	}
 	m_pEquirectangularToCubemapConstantBuffer->Release();
 	m_EquirectangularToCubemapShader.Release();
 	m_SolidNoneCullPipeline.Release();
@@ -193,15 +227,13 @@ void Renderer::Release()
 	m_pPreFilteredMapConstantBuffer->Release();
 	m_PreFilteredMapShader.Release();
 
-	if (m_PreComputedBRDFRTV)
-	{
-		m_PreComputedBRDFRTV->Release();
-		m_PreComputedBRDFRTV = nullptr;
-	}
 	m_PreComputedBRDFShader.Release();
 
 	m_DefaultPipeline.Release();
 	ClearRTV();
+
+	RenderTargetPool::Get()->Release();
+	StateCache::Get()->Release();
 }
 
 void Renderer::Resize(uint32 width, uint32 height)
@@ -214,6 +246,12 @@ void Renderer::Resize(uint32 width, uint32 height)
 
 		m_DefaultPipeline.Resize(width, height);
 
+		// The new views can reuse the addresses of the released ones.
+		StateCache::Get()->Invalidate();
+
+		// The free targets were sized for the old window and would only wait in the pool until they age out.
+		RenderTargetPool::Get()->EvictFree();
+
 		ImGuiRenderer::Resize();
 	}
 }
@@ -258,12 +296,37 @@ void Renderer::Render(ModelResource& model, const glm::mat4& transform, DebugInf
 	InternalRender(model, transform, pContext, debugInfo, flags);
 }
 
-void Renderer::RenderWithMaterial(ModelResource& model, const glm::mat4& transform, DebugInfo debugInfo)
+void Renderer::RenderWithMaterial(ModelResource& model, const glm::mat4& transform, DebugInfo debugInfo, ShaderPermutations* pPermutations)
 {
 	auto renderAPI = RenderAPI::Get();
 	ID3D11DeviceContext* pContext = renderAPI->GetDeviceContext();
 	DebugRenderer::Get()->Clear(debugInfo.ID);
-	InternalRenderWithMaterial(model, transform, pContext, debugInfo);
+	InternalRenderWithMaterial(model, transform, pContext, debugInfo, pPermutations);
+}
+
+MaterialKeywords Renderer::GetMaterialKeywords(const MaterialResource* pMaterial, const DebugInfo& debugInfo)
+{
+	static const MaterialKeywords s_DebugKeywords[] =
+	{
+		0,
+		MATERIAL_KEYWORD_DEBUG_ALBEDO,
+		MATERIAL_KEYWORD_DEBUG_NORMAL,
+		MATERIAL_KEYWORD_DEBUG_AO,
+		MATERIAL_KEYWORD_DEBUG_METALLIC,
+		MATERIAL_KEYWORD_DEBUG_ROUGHNESS,
+		MATERIAL_KEYWORD_DEBUG_METALLIC_ROUGHNESS,
+		0
+	};
+
+	// The low three bits of the render mode are the debug index, the bits above are the IBL flags.
+	MaterialKeywords keywords = s_DebugKeywords[debugInfo.RenderMode & 7];
+	if (pMaterial->InfoBuffer.Info.x > 0.5f)
+		keywords |= MATERIAL_KEYWORD_COMBINED_METALLIC_ROUGHNESS;
+	if (debugInfo.RenderMode & 8)
+		keywords |= MATERIAL_KEYWORD_DIFFUSE_IBL;
+	if (debugInfo.RenderMode & 16)
+		keywords |= MATERIAL_KEYWORD_SPECULAR_IBL;
+	return keywords;
 }
 
 ID3D11RenderTargetView* Renderer::GetRenderTarget()
@@ -289,13 +352,26 @@ void Renderer::ConvertTextureFormat(TextureResource* pTexture, DXGI_FORMAT newFo
 		return;
 	}
 
-	if (m_TextureFormatConvertionRTV != nullptr)
+	ImageResource* pImage = ResourceManager::Get()->GetResource<ImageResource>(pTexture->ImageHandler);
+	if (!ResourceManager::Get()->RequestImageData(pImage))
 	{
-		m_TextureFormatConvertionRTV->Release();
-		m_TextureFormatConvertionRTV = nullptr;
+		LOG_WARNING("Failed to convert texture format, from {} to {}, the image data is not available!", preFormatStr.c_str(), newFormatStr.c_str());
+		return;
+	}
+
+	// The conversion is drawn to a pooled target and copied to the first mip of the new texture, textures of the same size share the target.
+	RenderTargetPool::Desc targetDesc;
+	targetDesc.Width		= pImage->Width;
+	targetDesc.Height		= pImage->Height;
+	targetDesc.Format		= newFormat;
+	targetDesc.BindFlags	= D3D11_BIND_RENDER_TARGET;
+	std::shared_ptr<RenderTargetPool> pool = RenderTargetPool::Get();
+	RenderTargetPool::Target* pTarget = pool->Acquire(targetDesc);
+	if (pTarget == nullptr)
+	{
+		LOG_WARNING("Failed to convert texture format, from {} to {}, no render target was available!", preFormatStr.c_str(), newFormatStr.c_str());
+		return;
 	}
-	
-	ImageResource* pImage = ResourceManager::Get()->GetResource<ImageResource>(pTexture->ImageHandler);
 
 	ID3D11Texture2D* pNewTexture = nullptr;
 	ID3D11ShaderResourceView* pNewTextureSRV = nullptr;
@@ -315,6 +391,7 @@ void Renderer::ConvertTextureFormat(TextureResource* pTexture, DXGI_FORMAT newFo
 
 		HRESULT result = RenderAPI::Get()->GetDevice()->CreateTexture2D(&textureDesc, subData.data(), &pNewTexture);
 		RS_D311_ASSERT_CHECK(result, "Failed to create texture!");
+		ResourceManager::Get()->NotifyImageUploaded(pImage);
 
 		D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
 		srvDesc.Format = textureDesc.Format;
@@ -325,35 +402,28 @@ void Renderer::ConvertTextureFormat(TextureResource* pTexture, DXGI_FORMAT newFo
 		RS_D311_ASSERT_CHECK(result, "Failed to create texture RSV!");
 	}
 	
-	D3D11_RENDER_TARGET_VIEW_DESC desc = {};
-	desc.Format = newFormat;
-	desc.ViewDimension = D3D11_RTV_DIMENSION_TEXTURE2D;
-	desc.Texture2D.MipSlice = 0;
-	HRESULT hr = RenderAPI::Get()->GetDevice()->CreateRenderTargetView(pNewTexture, &desc, &m_TextureFormatConvertionRTV);
-	if (FAILED(hr))
-	{
-		LOG_WARNING("Failed to convert texture format, from {} to {}!", preFormatStr.c_str(), newFormatStr.c_str());
-		return;
-	}
-
-	// Use a pipeline and draw to the texture as a rendertarget.
-	m_TextureFormatConvertionPipeline.SetRenderTargetView(m_TextureFormatConvertionRTV);
-	m_TextureFormatConvertionPipeline.Bind(BindType::RTV_ONLY);
+	// Use a pipeline and draw to the pooled target, the view is bound directly such that the pipeline never holds it.
+	m_TextureFormatConvertionPipeline.BindDepthStencilState();
+	m_TextureFormatConvertionPipeline.BindRasterState();
 
 	SamplerResource* pSamplerResource = ResourceManager::Get()->GetResource<SamplerResource>(ResourceManager::Get()->DefaultSamplerLinear);
 
 	m_TextureFormatConvertionShader.Bind();
 	m_TextureFormatConvertionPipeline.SetViewport(0.f, 0.f, (float)pImage->Width, (float)pImage->Height);
 	ID3D11DeviceContext* pContext = RenderAPI::Get()->GetDeviceContext();
-	pContext->IASetVertexBuffers(0, 0, nullptr, nullptr, nullptr);
-	pContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-	pContext->PSSetSamplers(0, 1, &pSamplerResource->pSampler);
-	pContext->PSSetShaderResources(0, 1, &pTexture->pTextureSRV);
-	pContext->Draw(3, 0);
+	std::shared_ptr<StateCache> stateCache = StateCache::Get();
+	stateCache->SetRenderTargets(1, &pTarget->pRTV, nullptr);
+	stateCache->SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	stateCache->SetSamplers(ShaderTypeFlag::FRAGMENT, 0, 1, &pSamplerResource->pSampler);
+	stateCache->SetShaderResources(ShaderTypeFlag::FRAGMENT, 0, 1, &pTexture->pTextureSRV);
+	stateCache->Draw(3, 0);
 
 	// Reset render target
 	ID3D11RenderTargetView* nullRTVs = nullptr;
-	pContext->OMSetRenderTargets(1, &nullRTVs, nullptr);
+	stateCache->SetRenderTargets(1, &nullRTVs, nullptr);
+
+	pContext->CopySubresourceRegion(pNewTexture, 0, 0, 0, 0, pTarget->pTexture, 0, nullptr);
+	pool->Release(pTarget);
 	
 	// Generate mips from the newly created texture with a new format and make that the texture instead. Also create debug SRVs for it.
 	{
@@ -367,6 +437,7 @@ void Renderer::ConvertTextureFormat(TextureResource* pTexture, DXGI_FORMAT newFo
 		pTexture->Format		= newFormat;
 		pTexture->pTexture		= pNewTexture;
 		pTexture->pTextureSRV	= pNewTextureSRV;
+		ResourceManager::Get()->UpdateMemoryFootprint(pTexture);
 
 		// Remove the previous debug SRVs
 		for (auto srv : pTexture->DebugMipmapSRVs)
@@ -401,27 +472,23 @@ CubeMapResource* Renderer::ConvertEquirectangularToCubemap(TextureResource* pTex
 	cubemapLoadDesc.ImageDescs[0].Name = ResourceManager::Get()->GetResourceName(pTexture->key);
 	auto [pCubemap, id] = ResourceManager::Get()->LoadCubeMapResource(cubemapLoadDesc);
 
-	D3D11_RENDER_TARGET_VIEW_DESC desc	= {};
-	desc.Format							= cubemapLoadDesc.Format;
-	desc.ViewDimension					= D3D11_RTV_DIMENSION_TEXTURE2DARRAY;
-	desc.Texture2DArray.ArraySize		= 1;
-	desc.Texture2DArray.MipSlice		= 0;
-	for (uint32_t i = 0; i < 6; i++)
+	// Each side is drawn to the same pooled target and copied to the first mip of its slice.
+	RenderTargetPool::Desc targetDesc;
+	targetDesc.Width		= width;
+	targetDesc.Height		= height;
+	targetDesc.Format		= cubemapLoadDesc.Format;
+	targetDesc.BindFlags	= D3D11_BIND_RENDER_TARGET;
+	std::shared_ptr<RenderTargetPool> pool = RenderTargetPool::Get();
+	RenderTargetPool::Target* pTarget = pool->Acquire(targetDesc);
+	if (pTarget == nullptr)
 	{
-		desc.Texture2DArray.FirstArraySlice = i;
-		if (m_EquirectangularToCubemapRTVs[i])
-		{
-			m_EquirectangularToCubemapRTVs[i]->Release();
-			m_EquirectangularToCubemapRTVs[i] = nullptr;
-		}
-		HRESULT hr = RenderAPI::Get()->GetDevice()->CreateRenderTargetView(pCubemap->pTexture, &desc, &m_EquirectangularToCubemapRTVs[i]);
-		if (FAILED(hr))
-		{
-			LOG_WARNING("Failed to convert a equirectangular texture to a cubemap!");
-			return pCubemap;
-		}
+		LOG_WARNING("Failed to convert a equirectangular texture to a cubemap!");
+		return pCubemap;
 	}
 
+	D3D11_TEXTURE2D_DESC cubemapDesc = {};
+	pCubemap->pTexture->GetDesc(&cubemapDesc);
+
 	// Use a pipeline and draw to the texture as a rendertarget.
 	SamplerResource* pSamplerResource = ResourceManager::Get()->GetResource<SamplerResource>(ResourceManager::Get()->DefaultSamplerLinear);
 
@@ -430,15 +497,15 @@ CubeMapResource* Renderer::ConvertEquirectangularToCubemap(TextureResource* pTex
 	m_SolidNoneCullPipeline.BindDepthStencilState();
 	m_SolidNoneCullPipeline.BindRasterState();
 	ID3D11DeviceContext* pContext = RenderAPI::Get()->GetDeviceContext();
-	pContext->IASetVertexBuffers(0, 0, nullptr, nullptr, nullptr);
-	pContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-	pContext->PSSetSamplers(0, 1, &pSamplerResource->pSampler);
-	pContext->PSSetShaderResources(0, 1, &pTexture->pTextureSRV);
+	std::shared_ptr<StateCache> stateCache = StateCache::Get();
+	stateCache->SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	stateCache->SetSamplers(ShaderTypeFlag::FRAGMENT, 0, 1, &pSamplerResource->pSampler);
+	stateCache->SetShaderResources(ShaderTypeFlag::FRAGMENT, 0, 1, &pTexture->pTextureSRV);
+
+	stateCache->SetRenderTargets(1, &pTarget->pRTV, nullptr);
 
 	for (uint32_t i = 0; i < 6; i++)
 	{
-		m_SolidNoneCullPipeline.SetRenderTargetView(m_EquirectangularToCubemapRTVs[i]);
-		m_SolidNoneCullPipeline.BindDepthAndRTVs(BindType::RTV_ONLY);
 
 		m_CubemapFrameData.View = m_CubemapCaptureViews[i];
 		D3D11_MAPPED_SUBRESOURCE mappedResource;
@@ -448,12 +515,14 @@ CubeMapResource* Renderer::ConvertEquirectangularToCubemap(TextureResource* pTex
 			memcpy(mappedResource.pData, &m_CubemapFrameData, sizeof(CubemapFrameData));
 			pContext->Unmap(m_pEquirectangularToCubemapConstantBuffer, 0);
 		}
-		pContext->VSSetConstantBuffers(0, 1, &m_pEquirectangularToCubemapConstantBuffer);
-		pContext->Draw(3, 0);
+		stateCache->SetConstantBuffers(ShaderTypeFlag::VERTEX, 0, 1, &m_pEquirectangularToCubemapConstantBuffer);
+		stateCache->Draw(3, 0);
+		pContext->CopySubresourceRegion(pCubemap->pTexture, D3D11CalcSubresource(0, i, cubemapDesc.MipLevels), 0, 0, 0, pTarget->pTexture, 0, nullptr);
 	}
 
 	ID3D11RenderTargetView* nullRTVs = nullptr;
-	pContext->OMSetRenderTargets(1, &nullRTVs, nullptr);
+	stateCache->SetRenderTargets(1, &nullRTVs, nullptr);
+	pool->Release(pTarget);
 
 	if(cubemapLoadDesc.GenerateMipmaps)
 		ResourceManager::Get()->GenerateMipmaps(pCubemap);
@@ -533,10 +602,10 @@ CubeMapResource* Renderer::CreateIrradianceMapFromEnvironmentMap(CubeMapResource
 	m_SolidNoneCullPipeline.BindDepthStencilState();
 	m_SolidNoneCullPipeline.BindRasterState();
 	ID3D11DeviceContext* pContext = RenderAPI::Get()->GetDeviceContext();
-	pContext->IASetVertexBuffers(0, 0, nullptr, nullptr, nullptr);
-	pContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-	pContext->PSSetSamplers(0, 1, &pSamplerResource->pSampler);
-	pContext->PSSetShaderResources(0, 1, &pEnvironmentMap->pTextureSRV);
+	std::shared_ptr<StateCache> stateCache = StateCache::Get();
+	stateCache->SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	stateCache->SetSamplers(ShaderTypeFlag::FRAGMENT, 0, 1, &pSamplerResource->pSampler);
+	stateCache->SetShaderResources(ShaderTypeFlag::FRAGMENT, 0, 1, &pEnvironmentMap->pTextureSRV);
 
 	for (uint32_t i = 0; i < 6; i++)
 	{
@@ -551,12 +620,12 @@ CubeMapResource* Renderer::CreateIrradianceMapFromEnvironmentMap(CubeMapResource
 			memcpy(mappedResource.pData, &m_CubemapFrameData, sizeof(CubemapFrameData));
 			pContext->Unmap(m_pEquirectangularToCubemapConstantBuffer, 0);
 		}
-		pContext->VSSetConstantBuffers(0, 1, &m_pEquirectangularToCubemapConstantBuffer);
-		pContext->Draw(3, 0);
+		stateCache->SetConstantBuffers(ShaderTypeFlag::VERTEX, 0, 1, &m_pEquirectangularToCubemapConstantBuffer);
+		stateCache->Draw(3, 0);
 	}
 
 	ID3D11RenderTargetView* nullRTVs = nullptr;
-	pContext->OMSetRenderTargets(1, &nullRTVs, nullptr);
+	stateCache->SetRenderTargets(1, &nullRTVs, nullptr);
 
 	if (cubemapLoadDesc.GenerateMipmaps)
 		ResourceManager::Get()->GenerateMipmaps(pCubemap);
@@ -645,10 +714,10 @@ CubeMapResource* Renderer::CreatePreFilteredEnvironmentMap(CubeMapResource* pEnv
 	m_SolidNoneCullPipeline.BindDepthStencilState();
 	m_SolidNoneCullPipeline.BindRasterState();
 	ID3D11DeviceContext* pContext = RenderAPI::Get()->GetDeviceContext();
-	pContext->IASetVertexBuffers(0, 0, nullptr, nullptr, nullptr);
-	pContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-	pContext->PSSetSamplers(0, 1, &pSamplerResource->pSampler);
-	pContext->PSSetShaderResources(0, 1, &pEnvironmentMap->pTextureSRV);
+	std::shared_ptr<StateCache> stateCache = StateCache::Get();
+	stateCache->SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	stateCache->SetSamplers(ShaderTypeFlag::FRAGMENT, 0, 1, &pSamplerResource->pSampler);
+	stateCache->SetShaderResources(ShaderTypeFlag::FRAGMENT, 0, 1, &pEnvironmentMap->pTextureSRV);
 
 	for (uint32_t i = 0; i < 6; i++)
 	{
@@ -669,7 +738,7 @@ CubeMapResource* Renderer::CreatePreFilteredEnvironmentMap(CubeMapResource* pEnv
 			m_SolidNoneCullPipeline.BindDepthAndRTVs(BindType::RTV_ONLY);
 			m_SolidNoneCullPipeline.SetViewport(0.f, 0.f, w, h);
 
-			pContext->VSSetConstantBuffers(0, 1, &m_pEquirectangularToCubemapConstantBuffer);
+			stateCache->SetConstantBuffers(ShaderTypeFlag::VERTEX, 0, 1, &m_pEquirectangularToCubemapConstantBuffer);
 			{
 				HRESULT result = pContext->Map(m_pPreFilteredMapConstantBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
 				RS_D311_ASSERT_CHECK(result, "Failed to map PreFilteredMap constant buffer!");
@@ -678,8 +747,8 @@ CubeMapResource* Renderer::CreatePreFilteredEnvironmentMap(CubeMapResource* pEnv
 				memcpy(mappedResource.pData, &roughness, sizeof(glm::vec4));
 				pContext->Unmap(m_pPreFilteredMapConstantBuffer, 0);
 			}
-			pContext->PSSetConstantBuffers(0, 1, &m_pPreFilteredMapConstantBuffer);
-			pContext->Draw(3, 0);
+			stateCache->SetConstantBuffers(ShaderTypeFlag::FRAGMENT, 0, 1, &m_pPreFilteredMapConstantBuffer);
+			stateCache->Draw(3, 0);
 
 			w *= 0.5f;
 			h *= 0.5f;
@@ -687,7 +756,7 @@ CubeMapResource* Renderer::CreatePreFilteredEnvironmentMap(CubeMapResource* pEnv
 	}
 
 	ID3D11RenderTargetView* nullRTVs = nullptr;
-	pContext->OMSetRenderTargets(1, &nullRTVs, nullptr);
+	stateCache->SetRenderTargets(1, &nullRTVs, nullptr);
 
 	{
 		// Debug SRVs for each side of the cube and for each mip level.
@@ -737,36 +806,35 @@ TextureResource* Renderer::CreatePreComputedBRDF(uint32_t width, uint32_t height
 	textureLoadDesc.UseAsRTV = true;
 	auto [pTexture, id] = ResourceManager::Get()->LoadTextureResource(textureLoadDesc);
 
-	D3D11_RENDER_TARGET_VIEW_DESC desc = {};
-	desc.Format				= pTexture->Format;
-	desc.ViewDimension		= D3D11_RTV_DIMENSION_TEXTURE2D;
-	desc.Texture2D.MipSlice = 0;
-
-	if (m_PreComputedBRDFRTV)
+	// The BRDF is drawn to a transient texture from the render target pool and copied to the resource, the graph owns the views while the passes are executed.
+	RenderGraph renderGraph;
+	uint32 outputTexture = renderGraph.ImportTexture(textureLoadDesc.ImageDesc.Name, pTexture->pTexture);
+	uint32 brdfTexture = renderGraph.CreateTexture("PreComputedBRDF", renderGraph.GetDesc(outputTexture));
+	uint32 brdfPass = renderGraph.AddPass("PreComputedBRDF", [&](RenderGraph& graph)
 	{
-		m_PreComputedBRDFRTV->Release();
-		m_PreComputedBRDFRTV = nullptr;
-	}
-	HRESULT hr = RenderAPI::Get()->GetDevice()->CreateRenderTargetView(pTexture->pTexture, &desc, &m_PreComputedBRDFRTV);
-	if (FAILED(hr))
+		m_PreComputedBRDFShader.Bind();
+		m_SolidNoneCullPipeline.BindDepthStencilState();
+		m_SolidNoneCullPipeline.BindRasterState();
+		m_SolidNoneCullPipeline.SetViewport(0.f, 0.f, width, height);
+
+		// The view is only alive during the pass, it is bound directly such that the persistent pipeline never holds it.
+		std::shared_ptr<StateCache> stateCache = StateCache::Get();
+		ID3D11RenderTargetView* pRTV = graph.GetRenderTargetView(brdfTexture);
+		stateCache->SetRenderTargets(1, &pRTV, nullptr);
+		stateCache->SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+		stateCache->Draw(3, 0);
+	});
+	renderGraph.Write(brdfPass, brdfTexture);
+
+	uint32 copyPass = renderGraph.AddPass("CopyPreComputedBRDF", [&](RenderGraph& graph)
 	{
-		LOG_WARNING("Failed to create the PreComputedBRDF!");
-		return pTexture;
-	}
+		m_pContext->CopyResource(graph.GetTexture(outputTexture), graph.GetTexture(brdfTexture));
+	});
+	renderGraph.Read(copyPass, brdfTexture);
+	renderGraph.Write(copyPass, outputTexture);
 
-	m_PreComputedBRDFShader.Bind();
-	m_SolidNoneCullPipeline.SetRenderTargetView(m_PreComputedBRDFRTV);
-	m_SolidNoneCullPipeline.BindDepthAndRTVs(BindType::RTV_ONLY);
-	m_SolidNoneCullPipeline.BindDepthStencilState();
-	m_SolidNoneCullPipeline.BindRasterState();
-	m_SolidNoneCullPipeline.SetViewport(0.f, 0.f, width, height);
-	ID3D11DeviceContext* pContext = RenderAPI::Get()->GetDeviceContext();
-	pContext->IASetVertexBuffers(0, 0, nullptr, nullptr, nullptr);
-	pContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-	pContext->Draw(3, 0);
-
-	ID3D11RenderTargetView* nullRTVs = nullptr;
-	pContext->OMSetRenderTargets(1, &nullRTVs, nullptr);
+	if (!renderGraph.Compile() || !renderGraph.Execute())
+		LOG_WARNING("Failed to create the PreComputedBRDF!");
 
 	return pTexture;
 }
@@ -821,6 +889,7 @@ void Renderer::CreateRTV(uint32 width, uint32 height)
 		srvDesc.Texture2D.MipLevels			= 1;
 		result = RenderAPI::Get()->GetDevice()->CreateShaderResourceView(pTexture->pTexture, &srvDesc, &pTexture->pTextureSRV);
 		RS_D311_ASSERT_CHECK(result, "Failed to create texture SVR!");
+		ResourceManager::Get()->UpdateMemoryFootprint(pTexture);
 	}
 
 	// Create the render target view with the back buffer pointer.
@@ -879,12 +948,13 @@ void Renderer::CreateRasterizer()
 
 void Renderer::InternalRender(ModelResource& model, const glm::mat4& transform, ID3D11DeviceContext* pContext, DebugInfo debugInfo, RenderFlags flags)
 {
+	std::shared_ptr<StateCache> stateCache = StateCache::Get();
 	auto SetPSSRV = [&](uint32& slot, ResourceID handler, RenderFlag flag)->void
 	{
 		if (flags & flag)
 		{
 			TextureResource* pTexture = ResourceManager::Get()->GetResource<TextureResource>(handler);
-			pContext->PSSetShaderResources(slot++, 1, &pTexture->pTextureSRV);
+			stateCache->SetShaderResources(ShaderTypeFlag::FRAGMENT, slot++, 1, &pTexture->pTextureSRV);
 		}
 	};
 
@@ -905,10 +975,10 @@ void Renderer::InternalRender(ModelResource& model, const glm::mat4& transform,
 
 		UINT stride = sizeof(MeshObject::Vertex);
 		UINT offset = 0;
-		pContext->IASetVertexBuffers(0, 1, &mesh.pVertexBuffer, &stride, &offset);
-		pContext->IASetIndexBuffer(mesh.pIndexBuffer, DXGI_FORMAT_R32_UINT, 0);
-		pContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-		pContext->VSSetConstantBuffers(0, 1, &mesh.pMeshBuffer);
+		stateCache->SetVertexBuffers(0, 1, &mesh.pVertexBuffer, &stride, &offset);
+		stateCache->SetIndexBuffer(mesh.pIndexBuffer, DXGI_FORMAT_R32_UINT, 0);
+		stateCache->SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+		stateCache->SetConstantBuffers(ShaderTypeFlag::VERTEX, 0, 1, &mesh.pMeshBuffer);
 
 		uint32 textureSlot = 0;
 		SetPSSRV(textureSlot, pMaterial->AlbedoTextureHandler,				RenderFlag::RENDER_FLAG_ALBEDO_TEXTURE);
@@ -917,8 +987,8 @@ void Renderer::InternalRender(ModelResource& model, const glm::mat4& transform,
 		SetPSSRV(textureSlot, pMaterial->MetallicTextureHandler,			RenderFlag::RENDER_FLAG_METALLIC_TEXTURE);
 		SetPSSRV(textureSlot, pMaterial->RoughnessTextureHandler,			RenderFlag::RENDER_FLAG_ROUGHNESS_TEXTURE);
 		if(textureSlot != 0)
-			pContext->PSSetSamplers(0, 1, &pSampler->pSampler);
-		pContext->DrawIndexed((UINT)mesh.NumIndices, 0, 0);
+			stateCache->SetSamplers(ShaderTypeFlag::FRAGMENT, 0, 1, &pSampler->pSampler);
+		stateCache->DrawIndexed((UINT)mesh.NumIndices, 0, 0);
 
 		if (debugInfo.DrawAABBs)
 		{
@@ -939,8 +1009,9 @@ void Renderer::InternalRender(ModelResource& model, const glm::mat4& transform,
 		InternalRender(child, meshData.world, pContext, debugInfo, flags);
 }
 
-void Renderer::InternalRenderWithMaterial(ModelResource& model, const glm::mat4& transform, ID3D11DeviceContext* pContext, DebugInfo debugInfo)
+void Renderer::InternalRenderWithMaterial(ModelResource& model, const glm::mat4& transform, ID3D11DeviceContext* pContext, DebugInfo debugInfo, ShaderPermutations* pPermutations)
 {
+	std::shared_ptr<StateCache> stateCache = StateCache::Get();
 	MeshObject::MeshData meshData;
 	meshData.world = transform * model.Transform;
 	for (MeshObject& mesh : model.Meshes)
@@ -975,19 +1046,47 @@ void Renderer::InternalRenderWithMaterial(ModelResource& model, const glm::mat4&
 
 		UINT stride = sizeof(MeshObject::Vertex);
 		UINT offset = 0;
-		pContext->IASetVertexBuffers(0, 1, &mesh.pVertexBuffer, &stride, &offset);
-		pContext->IASetIndexBuffer(mesh.pIndexBuffer, DXGI_FORMAT_R32_UINT, 0);
-		pContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-		pContext->VSSetConstantBuffers(0, 1, &mesh.pMeshBuffer);
-		pContext->PSSetShaderResources(0, 1, &pAlbedoTexture->pTextureSRV);
-		pContext->PSSetShaderResources(1, 1, &pNormalTexture->pTextureSRV);
-		pContext->PSSetShaderResources(2, 1, &pAOTexture->pTextureSRV);
-		pContext->PSSetShaderResources(3, 1, &pMetallicTexture->pTextureSRV);
-		pContext->PSSetShaderResources(4, 1, &pRoughnessTexture->pTextureSRV);
-		pContext->PSSetShaderResources(5, 1, &pMetallicRoughnessTexture->pTextureSRV);
-		pContext->PSSetSamplers(0, 1, &pSampler->pSampler);
-		pContext->PSSetConstantBuffers(0, 1, &pMaterial->pConstantBuffer);
-		pContext->DrawIndexed((UINT)mesh.NumIndices, 0, 0);
+		stateCache->SetVertexBuffers(0, 1, &mesh.pVertexBuffer, &stride, &offset);
+		stateCache->SetIndexBuffer(mesh.pIndexBuffer, DXGI_FORMAT_R32_UINT, 0);
+		stateCache->SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+		if (pPermutations)
+		{
+			// Meshes with a variant which failed to compile are skipped, instead of being drawn with the shader of the previous mesh.
+			Shader* pShader = pPermutations->GetVariant(GetMaterialKeywords(pMaterial, debugInfo));
+			if (pShader == nullptr)
+				continue;
+			pShader->Bind();
+
+			// The slots are looked up once for each variant, a variant does not have the resources it does not use.
+			ShaderBindingTable& bindingTable = m_MaterialBindingTables[pShader];
+			if (!bindingTable.IsBuiltFrom(pShader->GetBindingLayout()))
+				bindingTable.Init(pShader->GetBindingLayout(), MATERIAL_BINDING_NAMES);
+
+			bindingTable.SetConstantBuffer(MATERIAL_BINDING_MESH_DATA, mesh.pMeshBuffer);
+			bindingTable.SetConstantBuffer(MATERIAL_BINDING_MATERIAL_DATA, pMaterial->pConstantBuffer);
+			bindingTable.SetShaderResource(MATERIAL_BINDING_ALBEDO, pAlbedoTexture->pTextureSRV);
+			bindingTable.SetShaderResource(MATERIAL_BINDING_NORMAL, pNormalTexture->pTextureSRV);
+			bindingTable.SetShaderResource(MATERIAL_BINDING_AO, pAOTexture->pTextureSRV);
+			bindingTable.SetShaderResource(MATERIAL_BINDING_METALLIC, pMetallicTexture->pTextureSRV);
+			bindingTable.SetShaderResource(MATERIAL_BINDING_ROUGHNESS, pRoughnessTexture->pTextureSRV);
+			bindingTable.SetShaderResource(MATERIAL_BINDING_METALLIC_ROUGHNESS, pMetallicRoughnessTexture->pTextureSRV);
+			bindingTable.SetSampler(MATERIAL_BINDING_SAMPLER, pSampler->pSampler);
+			bindingTable.Apply();
+		}
+		else
+		{
+			stateCache->SetConstantBuffers(ShaderTypeFlag::VERTEX, 0, 1, &mesh.pMeshBuffer);
+			stateCache->SetShaderResources(ShaderTypeFlag::FRAGMENT, 0, 1, &pAlbedoTexture->pTextureSRV);
+			stateCache->SetShaderResources(ShaderTypeFlag::FRAGMENT, 1, 1, &pNormalTexture->pTextureSRV);
+			stateCache->SetShaderResources(ShaderTypeFlag::FRAGMENT, 2, 1, &pAOTexture->pTextureSRV);
+			stateCache->SetShaderResources(ShaderTypeFlag::FRAGMENT, 3, 1, &pMetallicTexture->pTextureSRV);
+			stateCache->SetShaderResources(ShaderTypeFlag::FRAGMENT, 4, 1, &pRoughnessTexture->pTextureSRV);
+			stateCache->SetShaderResources(ShaderTypeFlag::FRAGMENT, 5, 1, &pMetallicRoughnessTexture->pTextureSRV);
+			stateCache->SetSamplers(ShaderTypeFlag::FRAGMENT, 0, 1, &pSampler->pSampler);
+			stateCache->SetConstantBuffers(ShaderTypeFlag::FRAGMENT, 0, 1, &pMaterial->pConstantBuffer);
+		}
+		stateCache->DrawIndexed((UINT)mesh.NumIndices, 0, 0);
 
 		if (debugInfo.DrawAABBs)
 		{
@@ -1005,5 +1104,5 @@ void Renderer::InternalRenderWithMaterial(ModelResource& model, const glm::mat4&
 	}
 
 	for (ModelResource& child : model.Children)
-		InternalRenderWithMaterial(child, meshData.world, pContext, debugInfo);
+		InternalRenderWithMaterial(child, meshData.world, pContext, debugInfo, pPermutations);
 }
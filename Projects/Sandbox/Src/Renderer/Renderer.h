@@ -4,6 +4,8 @@
 
 #include "Renderer/Pipeline.h"
 #include "Renderer/Shader.h"
+#include "Renderer/ShaderPermutations.h"
+#include "Renderer/ShaderBindingTable.h"
 
 #include "Core/ResourceManager.h"
 
@@ -37,7 +39,13 @@ namespace RS
 			uint32	PreFilterMaxLOD = 0;
 		};
 		void Render(ModelResource& model, const glm::mat4& transform, DebugInfo debugInfo, RenderFlags flags);
-		void RenderWithMaterial(ModelResource& model, const glm::mat4& transform, DebugInfo debugInfo);
+
+		/*
+		* pPermutations: If not nullptr, the variant which matches the material and the render mode of each mesh is bound before it is drawn. The keywords are MATERIAL_KEYWORD_NAMES.
+		*/
+		void RenderWithMaterial(ModelResource& model, const glm::mat4& transform, DebugInfo debugInfo, ShaderPermutations* pPermutations = nullptr);
+
+		static MaterialKeywords GetMaterialKeywords(const MaterialResource* pMaterial, const DebugInfo& debugInfo);
 
 		ID3D11RenderTargetView* GetRenderTarget();
 
@@ -58,7 +66,7 @@ namespace RS
 		void CreateRasterizer();
 
 		void InternalRender(ModelResource& model, const glm::mat4& transform, ID3D11DeviceContext* pContext, DebugInfo debugInfo, RenderFlags flags);
-		void InternalRenderWithMaterial(ModelResource& model, const glm::mat4& transform, ID3D11DeviceContext* pContext, DebugInfo debugInfo);
+		void InternalRenderWithMaterial(ModelResource& model, const glm::mat4& transform, ID3D11DeviceContext* pContext, DebugInfo debugInfo, ShaderPermutations* pPermutations);
 
 		struct CubemapFrameData
 		{
@@ -80,14 +88,12 @@ namespace RS
 
 		Pipeline								m_TextureFormatConvertionPipeline;
 		Shader									m_TextureFormatConvertionShader;
-		ID3D11RenderTargetView*					m_TextureFormatConvertionRTV				= nullptr;
 
 		CubemapFrameData						m_CubemapFrameData;
 		glm::mat4								m_CubemapCaptureViews[6];
 		Pipeline								m_SolidNoneCullPipeline;
 
 		Shader									m_EquirectangularToCubemapShader;
-		ID3D11RenderTargetView*					m_EquirectangularToCubemapRTVs[6]			= { nullptr };
 		ID3D11Buffer*							m_pEquirectangularToCubemapConstantBuffer	= nullptr;
 
 		Shader									m_IrradianceMapShader;
@@ -98,6 +104,8 @@ namespace RS
 		std::vector< std::vector<ID3D11RenderTargetView*>>	m_PreFilteredMapRTVs;
 
 		Shader									m_PreComputedBRDFShader;
-		ID3D11RenderTargetView*					m_PreComputedBRDFRTV			= nullptr;
+
+		// The binding tables of the material shaders, they are rebuilt when the layout of the shader changes.
+		std::unordered_map<const Shader*, ShaderBindingTable>	m_MaterialBindingTables;
 	};
 }
\ No newline at end of file
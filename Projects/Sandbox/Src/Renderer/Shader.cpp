@@ -1,6 +1,10 @@
 #include "PreCompiled.h"
 #include "Shader.h"
 
+#include "Renderer/StateCache.h"
+
+#include <algorithm>
+
 using namespace RS;
 
 void Shader::Release()
@@ -100,50 +104,18 @@ bool Shader::Load(const std::string& fileName, ShaderTypeFlags types, const Attr
         descriptor.Hull = finalPath + ".hs";
     if (types & ShaderTypeFlag::TESS_DOMAIN)
         descriptor.Domain = finalPath + ".ds";
-    m_ShaderTypes = types;
     return InitAndReload(descriptor, layout);
 }
 
 bool Shader::Load(const Descriptor& shaderDescriptor, const AttributeLayout& layout)
 {
-    Descriptor descriptor = {};
-    std::string finalPath = std::string(RS_SHADER_PATH);
-    if (!shaderDescriptor.Vertex.empty())
-    {
-        descriptor.Vertex = finalPath + shaderDescriptor.Vertex;
-        m_ShaderTypes = ShaderTypeFlag::VERTEX;
-    }
-    if (!shaderDescriptor.Fragment.empty())
-    {
-        descriptor.Fragment = finalPath + shaderDescriptor.Fragment;
-        m_ShaderTypes |= ShaderTypeFlag::FRAGMENT;
-    }
-    if (!shaderDescriptor.Geometry.empty())
-    {
-        descriptor.Geometry = finalPath + shaderDescriptor.Geometry;
-        m_ShaderTypes |= ShaderTypeFlag::GEOMETRY;
-    }
-    if (!shaderDescriptor.Compute.empty())
-    {
-        descriptor.Compute = finalPath + shaderDescriptor.Compute;
-        m_ShaderTypes |= ShaderTypeFlag::COMPUTE;
-    }
-    if (!shaderDescriptor.Hull.empty())
-    {
-        descriptor.Hull = finalPath + shaderDescriptor.Hull;
-        m_ShaderTypes |= ShaderTypeFlag::TESS_HULL;
-    }
-    if (!shaderDescriptor.Domain.empty())
-    {
-        descriptor.Domain = finalPath + shaderDescriptor.Domain;
-        m_ShaderTypes |= ShaderTypeFlag::TESS_DOMAIN;
-    }
-    return InitAndReload(descriptor, layout);
+    return InitAndReload(GetFullDescriptor(shaderDescriptor), layout);
 }
 
 bool Shader::Reload()
 {
     Descriptor descriptor = {};
+    descriptor.Defines = m_Defines;
     for (uint32 i = 0; i < m_Files.size(); i++)
     {
         std::string filePath    = m_Files[i];
@@ -181,38 +153,15 @@ bool Shader::Reload()
 
 void Shader::Bind()
 {
-    ID3D11DeviceContext* pContext = RenderAPI::Get()->GetDeviceContext();
-    pContext->IASetInputLayout(m_pLayout);
-
-    if (m_ShaderTypes & ShaderTypeFlag::VERTEX)
-        pContext->VSSetShader(m_pVShader, nullptr, 0);
-    else
-        pContext->VSSetShader(nullptr, nullptr, 0);
-
-    if (m_ShaderTypes & ShaderTypeFlag::FRAGMENT)
-        pContext->PSSetShader(m_pPShader, nullptr, 0);
-    else
-        pContext->PSSetShader(nullptr, nullptr, 0);
-
-    if (m_ShaderTypes & ShaderTypeFlag::COMPUTE)
-        pContext->CSSetShader(m_pCShader, nullptr, 0);
-    else
-        pContext->CSSetShader(nullptr, nullptr, 0);
-
-    if (m_ShaderTypes & ShaderTypeFlag::GEOMETRY)
-        pContext->GSSetShader(m_pGShader, nullptr, 0);
-    else
-        pContext->GSSetShader(nullptr, nullptr, 0);
-
-    if (m_ShaderTypes & ShaderTypeFlag::TESS_HULL)
-        pContext->HSSetShader(m_pHShader, nullptr, 0);
-    else
-        pContext->HSSetShader(nullptr, nullptr, 0);
-
-    if (m_ShaderTypes & ShaderTypeFlag::TESS_DOMAIN)
-        pContext->DSSetShader(m_pDShader, nullptr, 0);
-    else
-        pContext->DSSetShader(nullptr, nullptr, 0);
+    // Stages which are not in the shader are unbound, the state cache filters the ones which already are.
+    std::shared_ptr<StateCache> stateCache = StateCache::Get();
+    stateCache->SetInputLayout(m_pLayout);
+    stateCache->SetVertexShader((m_ShaderTypes & ShaderTypeFlag::VERTEX) ? m_pVShader : nullptr);
+    stateCache->SetPixelShader((m_ShaderTypes & ShaderTypeFlag::FRAGMENT) ? m_pPShader : nullptr);
+    stateCache->SetComputeShader((m_ShaderTypes & ShaderTypeFlag::COMPUTE) ? m_pCShader : nullptr);
+    stateCache->SetGeometryShader((m_ShaderTypes & ShaderTypeFlag::GEOMETRY) ? m_pGShader : nullptr);
+    stateCache->SetHullShader((m_ShaderTypes & ShaderTypeFlag::TESS_HULL) ? m_pHShader : nullptr);
+    stateCache->SetDomainShader((m_ShaderTypes & ShaderTypeFlag::TESS_DOMAIN) ? m_pDShader : nullptr);
 }
 
 const std::vector<std::string>& Shader::GetFiles()
@@ -220,31 +169,79 @@ const std::vector<std::string>& Shader::GetFiles()
     return m_Files;
 }
 
-bool Shader::InitAndReload(const Descriptor& shaderDescriptor, const AttributeLayout& layout)
+const std::unordered_map<std::string, std::vector<std::string>>& Shader::GetIncludes()
 {
+    return m_Includes;
+}
+
+const ShaderBindingLayout& Shader::GetBindingLayout() const
+{
+    return m_BindingLayout;
+}
+
+bool Shader::LoadCompiled(const std::vector<Stage>& stages, const AttributeLayout& layout, std::string* pOutErrors)
+{
+    auto ReportError = [&](const std::string& message)
+    {
+        if (pOutErrors)
+            *pOutErrors += message + "\n";
+        else
+            LOG_ERROR(message);
+    };
+
     bool result = true;
+    bool hasVertexShader = false;
 
     Shader newShader;
-    ID3DBlob* pBlob = nullptr;
     ID3DBlob* pVertexShaderBuffer = nullptr;
-    if (!shaderDescriptor.Vertex.empty())
-        result &= newShader.CreateAndCompileShaderPart(shaderDescriptor.Vertex, ShaderTypeFlag::VERTEX, (void**)&newShader.m_pVShader, newShader.m_pVReflector, pVertexShaderBuffer, false);
-    else
+    for (const Stage& stage : stages)
     {
-        result = false;
-        LOG_ERROR("Failed to create shaders! Missing vertex shader!");
+        // Keep the includes of a failed compile as well, such that fixing an included file reloads the shader.
+        AddIncludes(stage.Result.Includes);
+
+        if (!stage.Compiled)
+        {
+            ReportError("Failed to compile shader " + stage.FilePath + "!");
+            if (!stage.Result.Errors.empty())
+                ReportError(stage.Result.Errors);
+            result = false;
+            continue;
+        }
+
+        ID3DBlob* pBlob = nullptr;
+        switch (stage.Type)
+        {
+        case ShaderTypeFlag::VERTEX:
+            result &= newShader.CreateShaderPart(stage, (void**)&newShader.m_pVShader, newShader.m_pVReflector, pVertexShaderBuffer, false);
+            hasVertexShader = true;
+            break;
+        case ShaderTypeFlag::FRAGMENT:
+            result &= newShader.CreateShaderPart(stage, (void**)&newShader.m_pPShader, newShader.m_pPReflector, pBlob, true);
+            break;
+        case ShaderTypeFlag::GEOMETRY:
+            result &= newShader.CreateShaderPart(stage, (void**)&newShader.m_pGShader, newShader.m_pGReflector, pBlob, true);
+            break;
+        case ShaderTypeFlag::COMPUTE:
+            result &= newShader.CreateShaderPart(stage, (void**)&newShader.m_pCShader, newShader.m_pCReflector, pBlob, true);
+            break;
+        case ShaderTypeFlag::TESS_HULL:
+            result &= newShader.CreateShaderPart(stage, (void**)&newShader.m_pHShader, newShader.m_pHReflector, pBlob, true);
+            break;
+        case ShaderTypeFlag::TESS_DOMAIN:
+            result &= newShader.CreateShaderPart(stage, (void**)&newShader.m_pDShader, newShader.m_pDReflector, pBlob, true);
+            break;
+        default:
+            ReportError("Failed to create shader " + stage.FilePath + "! Shader type not supported!");
+            result = false;
+            break;
+        }
     }
 
-    if (!shaderDescriptor.Fragment.empty())
-        result &= newShader.CreateAndCompileShaderPart(shaderDescriptor.Fragment, ShaderTypeFlag::FRAGMENT, (void**)&newShader.m_pPShader, newShader.m_pPReflector, pBlob, true);
-    if (!shaderDescriptor.Geometry.empty())
-        result &= newShader.CreateAndCompileShaderPart(shaderDescriptor.Geometry, ShaderTypeFlag::GEOMETRY, (void**)&newShader.m_pGShader, newShader.m_pGReflector, pBlob, true);
-    if (!shaderDescriptor.Compute.empty())
-        result &= newShader.CreateAndCompileShaderPart(shaderDescriptor.Compute, ShaderTypeFlag::COMPUTE, (void**)&newShader.m_pCShader, newShader.m_pCReflector, pBlob, true);
-    if (!shaderDescriptor.Hull.empty())
-        result &= newShader.CreateAndCompileShaderPart(shaderDescriptor.Hull, ShaderTypeFlag::TESS_HULL, (void**)&newShader.m_pHShader, newShader.m_pHReflector, pBlob, true);
-    if (!shaderDescriptor.Domain.empty())
-        result &= newShader.CreateAndCompileShaderPart(shaderDescriptor.Domain, ShaderTypeFlag::TESS_DOMAIN, (void**)&newShader.m_pDShader, newShader.m_pDReflector, pBlob, true);
+    if (!hasVertexShader)
+    {
+        result = false;
+        ReportError("Failed to create shaders! Missing vertex shader!");
+    }
 
     result &= CreateLayout(pVertexShaderBuffer, layout, newShader.m_pLayout);
 
@@ -260,8 +257,18 @@ bool Shader::InitAndReload(const Descriptor& shaderDescriptor, const AttributeLa
     // Copy data over to this instance.
     m_Files     = newShader.m_Files;
     m_FileTypes = newShader.m_FileTypes;
+    m_Defines   = stages.empty() ? std::vector<std::pair<std::string, std::string>>() : stages.front().Defines;
+
+    // The reflection data comes from the compiler or the cache, it is the same in both cases.
+    m_BindingLayout.Clear();
+    for (const Stage& stage : stages)
+        m_BindingLayout.AddStage(stage.Type, stage.Result.Reflection);
     m_pLayout   = newShader.m_pLayout;
 
+    m_ShaderTypes = ShaderTypeFlag::NONE;
+    for (ShaderTypeFlag type : m_FileTypes)
+        m_ShaderTypes |= type;
+
     m_pVShader = newShader.m_pVShader;
     m_pPShader = newShader.m_pPShader;
     m_pGShader = newShader.m_pGShader;
@@ -281,40 +288,78 @@ bool Shader::InitAndReload(const Descriptor& shaderDescriptor, const AttributeLa
     return result;
 }
 
-bool Shader::CreateAndCompileShaderPart(const std::string& filePath, ShaderTypeFlag type, void** pShader, ID3D11ShaderReflection*& pReflection, ID3DBlob*& pByteCode, bool releaseBlob)
+Shader::Descriptor Shader::GetFullDescriptor(const Descriptor& shaderDescriptor)
 {
-    HRESULT result;
-    ID3DBlob* pErrorMessageBlob = nullptr;
-    std::wstring p = Utils::Str2WStr(filePath);
-    LPCWSTR pathW = p.c_str();
+    Descriptor descriptor = {};
+    std::string finalPath = std::string(RS_SHADER_PATH);
+    if (!shaderDescriptor.Vertex.empty())
+        descriptor.Vertex = finalPath + shaderDescriptor.Vertex;
+    if (!shaderDescriptor.Fragment.empty())
+        descriptor.Fragment = finalPath + shaderDescriptor.Fragment;
+    if (!shaderDescriptor.Geometry.empty())
+        descriptor.Geometry = finalPath + shaderDescriptor.Geometry;
+    if (!shaderDescriptor.Compute.empty())
+        descriptor.Compute = finalPath + shaderDescriptor.Compute;
+    if (!shaderDescriptor.Hull.empty())
+        descriptor.Hull = finalPath + shaderDescriptor.Hull;
+    if (!shaderDescriptor.Domain.empty())
+        descriptor.Domain = finalPath + shaderDescriptor.Domain;
+    descriptor.Defines = shaderDescriptor.Defines;
+    return descriptor;
+}
 
-    std::string target = ShaderTypeToTarget(type);
-    result = D3DCompileFromFile(pathW, NULL, NULL, "main", target.c_str(), D3DCOMPILE_ENABLE_STRICTNESS, 0, &pByteCode, &pErrorMessageBlob);
-    if (FAILED(result))
+void Shader::GetStages(const Descriptor& fullDescriptor, std::vector<Stage>& outStages)
+{
+    auto AddStage = [&](const std::string& filePath, ShaderTypeFlag type)
     {
-        if (pErrorMessageBlob)
-        {
-            // Get a pointer to the error message text buffer.
-            char* compileErrors = (char*)(pErrorMessageBlob->GetBufferPointer());
+        if (filePath.empty())
+            return;
+        Stage stage;
+        stage.FilePath  = filePath;
+        stage.Type      = type;
+        stage.Defines   = fullDescriptor.Defines;
+        outStages.push_back(stage);
+    };
+
+    AddStage(fullDescriptor.Vertex, ShaderTypeFlag::VERTEX);
+    AddStage(fullDescriptor.Fragment, ShaderTypeFlag::FRAGMENT);
+    AddStage(fullDescriptor.Geometry, ShaderTypeFlag::GEOMETRY);
+    AddStage(fullDescriptor.Compute, ShaderTypeFlag::COMPUTE);
+    AddStage(fullDescriptor.Hull, ShaderTypeFlag::TESS_HULL);
+    AddStage(fullDescriptor.Domain, ShaderTypeFlag::TESS_DOMAIN);
+}
 
-            // Write out the error message.
-            LOG_ERROR("Failed to compile shader!");
-            LOG_ERROR(compileErrors);
+bool Shader::CompileStage(Stage& stage, ShaderCache& cache)
+{
+    ShaderCompileDesc desc;
+    desc.FilePath   = stage.FilePath;
+    desc.Target     = ShaderTypeToTarget(stage.Type);
+    desc.Flags      = D3DCOMPILE_ENABLE_STRICTNESS;
+    desc.Defines    = stage.Defines;
+
+    // The cache preprocesses the shader and only compiles it when the bytecode is not already stored.
+    stage.Compiled = cache.Compile(desc, stage.Result);
+    return stage.Compiled;
+}
 
-            // Release the error message.
-            pErrorMessageBlob->Release();
-            pErrorMessageBlob = nullptr;
+bool Shader::InitAndReload(const Descriptor& shaderDescriptor, const AttributeLayout& layout)
+{
+    std::vector<Stage> stages;
+    GetStages(shaderDescriptor, stages);
+    for (Stage& stage : stages)
+        CompileStage(stage, *ShaderCache::Get());
+    return LoadCompiled(stages, layout);
+}
 
-            return false;
-        }
-        else
-        {
-            LOG_ERROR("Failed to compile pixel shader: Missing file: {0}", filePath.c_str());
-            return false;
-        }
-    }
+bool Shader::CreateShaderPart(const Stage& stage, void** pShader, ID3D11ShaderReflection*& pReflection, ID3DBlob*& pByteCode, bool releaseBlob)
+{
+    HRESULT result = D3DCreateBlob(stage.Result.ByteCode.size(), &pByteCode);
+    RS_D311_CHECK(result, "Failed to create shader blob!");
+    if (FAILED(result))
+        return false;
+    memcpy(pByteCode->GetBufferPointer(), stage.Result.ByteCode.data(), stage.Result.ByteCode.size());
 
-    if (!CreateShader(type, pShader, pByteCode, pReflection))
+    if (!CreateShader(stage.Type, pShader, pByteCode, pReflection))
         return false;
 
     if (releaseBlob)
@@ -323,12 +368,25 @@ bool Shader::CreateAndCompileShaderPart(const std::string& filePath, ShaderTypeF
         pByteCode = nullptr;
     }
 
-    m_Files.push_back(filePath);
-    m_FileTypes.push_back(type);
+    m_Files.push_back(stage.FilePath);
+    m_FileTypes.push_back(stage.Type);
 
     return true;
 }
 
+void Shader::AddIncludes(const std::unordered_map<std::string, std::vector<std::string>>& includes)
+{
+    for (auto& [includerPath, fileIncludes] : includes)
+    {
+        std::vector<std::string>& currentIncludes = m_Includes[includerPath];
+        for (const std::string& include : fileIncludes)
+        {
+            if (std::find(currentIncludes.begin(), currentIncludes.end(), include) == currentIncludes.end())
+                currentIncludes.push_back(include);
+        }
+    }
+}
+
 bool Shader::CreateShader(ShaderTypeFlag type, void** pShader, ID3DBlob*& pByteCode, ID3D11ShaderReflection*& pReflection)
 {
     HRESULT result;
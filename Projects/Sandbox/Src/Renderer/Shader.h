@@ -3,9 +3,13 @@
 #include "Renderer/RenderAPI.h"
 #include "Renderer/ShaderDefines.h"
 #include "Renderer/AttributeLayout.h"
+#include "Renderer/ShaderBindingLayout.h"
+#include "Renderer/ShaderCache.h"
 
 #include "Utils/Utils.h"
 
+#include <unordered_map>
+
 namespace RS
 {
 	class Shader
@@ -19,6 +23,19 @@ namespace RS
 			std::string Compute;
 			std::string Hull;
 			std::string Domain;
+			std::vector<std::pair<std::string, std::string>> Defines; // Name and value, used by all stages.
+		};
+
+		/*
+		* One file of a shader. The compile step does not use the device, such that it can run on any thread.
+		*/
+		struct Stage
+		{
+			std::string			FilePath	= "";
+			ShaderTypeFlag		Type		= ShaderTypeFlag::NONE;
+			std::vector<std::pair<std::string, std::string>> Defines;
+			bool				Compiled	= false;
+			ShaderCompileResult	Result;
 		};
 
 	public:
@@ -30,22 +47,53 @@ namespace RS
 		bool Load(const Descriptor& shaderDescriptor, const AttributeLayout& layout);
 		bool Reload();
 
+		/*
+		* Create the shader from stages which have been compiled with CompileStage. This has to be called on the thread which owns the device.
+		* If pOutErrors is not nullptr, the errors are added to it instead of being logged.
+		*/
+		bool LoadCompiled(const std::vector<Stage>& stages, const AttributeLayout& layout, std::string* pOutErrors = nullptr);
+
+		/*
+		* Add RS_SHADER_PATH to the file paths of the descriptor.
+		*/
+		static Descriptor GetFullDescriptor(const Descriptor& shaderDescriptor);
+		static void GetStages(const Descriptor& fullDescriptor, std::vector<Stage>& outStages);
+
+		/*
+		* Compile a stage through the cache. This is thread safe.
+		*/
+		static bool CompileStage(Stage& stage, ShaderCache& cache);
+
 		void Bind();
 
 		const std::vector<std::string>& GetFiles();
 
+		/*
+		* The files each shader file or include file included directly, the key is the including file. See ShaderIncludeHandler.
+		*/
+		const std::unordered_map<std::string, std::vector<std::string>>& GetIncludes();
+
+		/*
+		* The resources of all stages, built from the reflection data when the shader was loaded. See ShaderBindingTable.
+		*/
+		const ShaderBindingLayout& GetBindingLayout() const;
+
 	private:
 		bool InitAndReload(const Descriptor& shaderDescriptor, const AttributeLayout& layout);
 
-		bool CreateAndCompileShaderPart(const std::string& filePath, ShaderTypeFlag type, void** pShader, ID3D11ShaderReflection*& pReflection, ID3DBlob*& pByteCode, bool releaseBlob);
+		bool CreateShaderPart(const Stage& stage, void** pShader, ID3D11ShaderReflection*& pReflection, ID3DBlob*& pByteCode, bool releaseBlob);
 		bool CreateShader(ShaderTypeFlag type, void** pShader, ID3DBlob*& pByteCode, ID3D11ShaderReflection*& pReflection);
 		bool CreateLayout(ID3DBlob*& pVertexShaderByteCode, const AttributeLayout& layout, ID3D11InputLayout*& pInputLayout);
+		void AddIncludes(const std::unordered_map<std::string, std::vector<std::string>>& includes);
 
 	private:
 		std::vector<std::string>		m_Files;
 		std::vector<ShaderTypeFlag>		m_FileTypes; // This is in the same order as m_Files.
+		std::vector<std::pair<std::string, std::string>> m_Defines;
+		std::unordered_map<std::string, std::vector<std::string>> m_Includes;
+		ShaderBindingLayout				m_BindingLayout;
 
-		ShaderTypeFlags		m_ShaderTypes;
+		ShaderTypeFlags		m_ShaderTypes	= ShaderTypeFlag::NONE;
 
 		// Shaders
 		ID3D11VertexShader*		m_pVShader	= nullptr;
@@ -0,0 +1,122 @@
+#include "PreCompiled.h"
+#include "ShaderBatch.h"
+
+#include "Utils/Config.h"
+#include "Utils/ParallelFor.h"
+#include "Utils/Timer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+using namespace RS;
+
+ShaderBatch::ShaderBatch(std::shared_ptr<ShaderCache> pCache) : m_pCache(pCache ? pCache : ShaderCache::Get())
+{
+}
+
+void ShaderBatch::Add(Shader* pShader, const Shader::Descriptor& descriptor, const AttributeLayout& layout)
+{
+	if (pShader == nullptr)
+	{
+		LOG_WARNING("The shader pointer cannot be a nullptr");
+		return;
+	}
+
+	Item item;
+	item.pShader	= pShader;
+	item.Layout		= layout;
+	Shader::GetStages(Shader::GetFullDescriptor(descriptor), item.Stages);
+	m_Items.push_back(item);
+}
+
+bool ShaderBatch::Load(uint32 numThreads)
+{
+	Compile(numThreads);
+	bool succeeded = Create();
+
+	LOG_INFO("Loaded {} shaders ({} stages) on {} threads. Compile: {:.1f} ms ({:.1f} ms on one thread, {:.2f}x), Create: {:.1f} ms.",
+		m_Stats.NumShaders, m_Stats.NumStages, m_Stats.NumThreads, m_Stats.CompileTimeMS, m_Stats.SerialCompileTimeMS,
+		m_Stats.CompileTimeMS > 0.f ? m_Stats.SerialCompileTimeMS / m_Stats.CompileTimeMS : 1.f, m_Stats.CreateTimeMS);
+	return succeeded;
+}
+
+void ShaderBatch::Compile(uint32 numThreads)
+{
+	Timer timer;
+	timer.Start();
+
+	std::vector<Shader::Stage*> stages;
+	for (Item& item : m_Items)
+	{
+		for (Shader::Stage& stage : item.Stages)
+			stages.push_back(&stage);
+	}
+
+	if (numThreads == 0)
+		numThreads = Config::Get()->Fetch<uint32>("Shaders/CompileThreads", 0);
+	if (numThreads == 0)
+		numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	numThreads = std::clamp(numThreads, 1u, std::max((uint32)stages.size(), 1u));
+
+	// Each thread takes the next stage which has not been started, such that a slow stage does not hold up the others.
+	std::atomic<uint64> serialTimeUS = 0;
+	ParallelFor(numThreads, (uint32)stages.size(), [&](uint32 index, uint32)
+	{
+		Timer stageTimer;
+		Shader::CompileStage(*stages[index], *m_pCache);
+		serialTimeUS += (uint64)(stageTimer.Stop().GetDeltaTimeMS() * 1000.f);
+	});
+
+	m_Stats.NumShaders			= (uint32)m_Items.size();
+	m_Stats.NumStages			= (uint32)stages.size();
+	m_Stats.NumThreads			= numThreads;
+	m_Stats.SerialCompileTimeMS	= (float)serialTimeUS / 1000.f;
+	m_Stats.CompileTimeMS		= timer.Stop().GetDeltaTimeMS();
+}
+
+bool ShaderBatch::Create()
+{
+	Timer timer;
+	timer.Start();
+
+	// The errors are collected, such that all failed shaders are reported together.
+	std::string report;
+	m_Stats.NumFailed = 0;
+	for (Item& item : m_Items)
+	{
+		std::string errors;
+		if (item.pShader->LoadCompiled(item.Stages, item.Layout, &errors))
+			continue;
+
+		m_Stats.NumFailed++;
+		report += "\n";
+		for (const Shader::Stage& stage : item.Stages)
+			report += "[" + stage.FilePath + "] ";
+		report += "\n" + errors;
+	}
+	m_Items.clear();
+	m_Stats.CreateTimeMS = timer.Stop().GetDeltaTimeMS();
+
+	if (m_Stats.NumFailed > 0)
+	{
+		LOG_ERROR("Failed to load {} of {} shaders:{}", m_Stats.NumFailed, m_Stats.NumShaders, report.c_str());
+		return false;
+	}
+	return true;
+}
+
+const std::vector<Shader::Stage>& ShaderBatch::GetStages(uint32 shaderIndex) const
+{
+	return m_Items[shaderIndex].Stages;
+}
+
+uint32 ShaderBatch::GetNumShaders() const
+{
+	return (uint32)m_Items.size();
+}
+
+const ShaderBatch::Stats& ShaderBatch::GetStats() const
+{
+	return m_Stats;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "Renderer/Shader.h"
+
+#include <memory>
+
+namespace RS
+{
+	/*
+	* Loads many shaders at once. The stages of all queued shaders are compiled on worker threads, after which the device objects are created on the calling thread.
+	* Example:
+	*	ShaderBatch batch;
+	*	batch.Add(&m_Shader, shaderDesc, layout);
+	*	batch.Add(&m_SkyboxShader, skyboxShaderDesc, skyboxLayout);
+	*	batch.Load();
+	*/
+	class ShaderBatch
+	{
+	public:
+		struct Stats
+		{
+			uint32	NumShaders			= 0;
+			uint32	NumStages			= 0;
+			uint32	NumFailed			= 0; // Number of shaders which failed to load.
+			uint32	NumThreads			= 0;
+			float	CompileTimeMS		= 0.f; // Wall-clock time of the compile step.
+			float	SerialCompileTimeMS	= 0.f; // Sum of the compile times of all stages, which is what the compile step would take on one thread.
+			float	CreateTimeMS		= 0.f;
+		};
+
+	public:
+		/*
+		* pCache: The cache to compile through, ShaderCache::Get() is used if it is nullptr.
+		*/
+		ShaderBatch(std::shared_ptr<ShaderCache> pCache = nullptr);
+
+		/*
+		* The paths in the descriptor are relative to RS_SHADER_PATH, like in Shader::Load.
+		*/
+		void Add(Shader* pShader, const Shader::Descriptor& descriptor, const AttributeLayout& layout);
+
+		/*
+		* Compile and create all queued shaders, this has to be called on the thread which owns the device.
+		* numThreads: The number of threads to compile on. Zero uses Shaders/CompileThreads from the config, or one for each hardware thread if that is zero as well.
+		* Returns false if any shader failed, the errors of all shaders are logged together.
+		*/
+		bool Load(uint32 numThreads = 0);
+
+		/*
+		* The compile step of Load, it does not use the device.
+		*/
+		void Compile(uint32 numThreads);
+
+		/*
+		* The create step of Load, it removes all queued shaders.
+		*/
+		bool Create();
+
+		const std::vector<Shader::Stage>& GetStages(uint32 shaderIndex) const;
+		uint32 GetNumShaders() const;
+		const Stats& GetStats() const;
+
+	private:
+		struct Item
+		{
+			Shader*						pShader	= nullptr;
+			AttributeLayout				Layout;
+			std::vector<Shader::Stage>	Stages;
+		};
+
+	private:
+		std::shared_ptr<ShaderCache>	m_pCache;
+		std::vector<Item>				m_Items;
+		Stats							m_Stats;
+	};
+}
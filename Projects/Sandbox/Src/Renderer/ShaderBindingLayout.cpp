@@ -0,0 +1,156 @@
+#include "PreCompiled.h"
+#include "ShaderBindingLayout.h"
+
+#include "Renderer/RenderAPI.h"
+
+#include <atomic>
+
+using namespace RS;
+
+namespace
+{
+	uint64 GenerateLayoutID()
+	{
+		static std::atomic<uint64> s_NextID = 1;
+		return s_NextID++;
+	}
+
+	bool GetResourceType(uint32 inputType, ShaderBindingLayout::ResourceType& outType)
+	{
+		switch ((D3D_SHADER_INPUT_TYPE)inputType)
+		{
+		case D3D_SIT_CBUFFER:
+			outType = ShaderBindingLayout::ResourceType::CONSTANT_BUFFER;
+			return true;
+		case D3D_SIT_TBUFFER:
+		case D3D_SIT_TEXTURE:
+		case D3D_SIT_STRUCTURED:
+		case D3D_SIT_BYTEADDRESS:
+			outType = ShaderBindingLayout::ResourceType::SHADER_RESOURCE;
+			return true;
+		case D3D_SIT_SAMPLER:
+			outType = ShaderBindingLayout::ResourceType::SAMPLER;
+			return true;
+		case D3D_SIT_UAV_RWTYPED:
+		case D3D_SIT_UAV_RWSTRUCTURED:
+		case D3D_SIT_UAV_RWBYTEADDRESS:
+		case D3D_SIT_UAV_APPEND_STRUCTURED:
+		case D3D_SIT_UAV_CONSUME_STRUCTURED:
+		case D3D_SIT_UAV_RWSTRUCTURED_WITH_COUNTER:
+			outType = ShaderBindingLayout::ResourceType::UNORDERED_ACCESS;
+			return true;
+		default:
+			return false;
+		}
+	}
+}
+
+void ShaderBindingLayout::AddStage(ShaderTypeFlag type, const ShaderReflectionData& reflection)
+{
+	uint32 stageIndex = GetStageIndex(type);
+	if (stageIndex >= NUM_STAGES)
+	{
+		LOG_WARNING("Shader [{}] type not supported by the binding layout!", (uint32)type);
+		return;
+	}
+
+	for (const ShaderReflectionData::Binding& binding : reflection.Bindings)
+	{
+		ResourceType resourceType;
+		if (!GetResourceType(binding.Type, resourceType))
+			continue;
+
+		auto it = m_ResourceIndices.find(binding.Name);
+		if (it != m_ResourceIndices.end() && m_Resources[it->second].Type != resourceType)
+		{
+			LOG_WARNING("Shader resource {} has different types in different stages, only the first is used!", binding.Name.c_str());
+			continue;
+		}
+
+		if (it == m_ResourceIndices.end())
+		{
+			Resource resource;
+			resource.Name		= binding.Name;
+			resource.Type		= resourceType;
+			resource.Count		= std::max(binding.BindCount, 1u);
+			resource.Size		= binding.Size;
+			resource.Variables	= binding.Variables;
+			it = m_ResourceIndices.emplace(binding.Name, (uint32)m_Resources.size()).first;
+			m_Resources.push_back(resource);
+		}
+
+		m_Resources[it->second].Slots[stageIndex] = binding.BindPoint;
+	}
+
+	m_ID = GenerateLayoutID();
+}
+
+void ShaderBindingLayout::Clear()
+{
+	m_Resources.clear();
+	m_ResourceIndices.clear();
+	m_ID = GenerateLayoutID();
+}
+
+int32 ShaderBindingLayout::GetResourceIndex(const std::string& name) const
+{
+	auto it = m_ResourceIndices.find(name);
+	return it == m_ResourceIndices.end() ? -1 : (int32)it->second;
+}
+
+const ShaderReflectionData::Variable* ShaderBindingLayout::FindVariable(const std::string& bufferName, const std::string& variableName) const
+{
+	int32 index = GetResourceIndex(bufferName);
+	if (index < 0)
+		return nullptr;
+
+	for (const ShaderReflectionData::Variable& variable : m_Resources[index].Variables)
+	{
+		if (variable.Name == variableName)
+			return &variable;
+	}
+	return nullptr;
+}
+
+const ShaderBindingLayout::Resource& ShaderBindingLayout::GetResource(uint32 index) const
+{
+	return m_Resources[index];
+}
+
+uint32 ShaderBindingLayout::GetNumResources() const
+{
+	return (uint32)m_Resources.size();
+}
+
+uint64 ShaderBindingLayout::GetID() const
+{
+	return m_ID;
+}
+
+uint32 ShaderBindingLayout::GetStageIndex(ShaderTypeFlag type)
+{
+	switch (type)
+	{
+	case ShaderTypeFlag::VERTEX:		return 0;
+	case ShaderTypeFlag::FRAGMENT:		return 1;
+	case ShaderTypeFlag::GEOMETRY:		return 2;
+	case ShaderTypeFlag::COMPUTE:		return 3;
+	case ShaderTypeFlag::TESS_HULL:		return 4;
+	case ShaderTypeFlag::TESS_DOMAIN:	return 5;
+	default:							return NUM_STAGES;
+	}
+}
+
+ShaderTypeFlag ShaderBindingLayout::GetStageType(uint32 stageIndex)
+{
+	switch (stageIndex)
+	{
+	case 0:		return ShaderTypeFlag::VERTEX;
+	case 1:		return ShaderTypeFlag::FRAGMENT;
+	case 2:		return ShaderTypeFlag::GEOMETRY;
+	case 3:		return ShaderTypeFlag::COMPUTE;
+	case 4:		return ShaderTypeFlag::TESS_HULL;
+	case 5:		return ShaderTypeFlag::TESS_DOMAIN;
+	default:	return ShaderTypeFlag::NONE;
+	}
+}
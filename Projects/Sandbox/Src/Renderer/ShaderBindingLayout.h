@@ -0,0 +1,72 @@
+#pragma once
+
+#include "Renderer/ShaderCompiler.h"
+#include "Renderer/ShaderDefines.h"
+
+namespace RS
+{
+	/*
+	* The named resources of a shader and the slots they are bound to in each stage.
+	* It is built from the ShaderReflectionData of the stages, which is stored in the ShaderCache. Building it does therefore not need a device or the bytecode.
+	*/
+	class ShaderBindingLayout
+	{
+	public:
+		static const uint32 NUM_STAGES		= 6; // One for each ShaderTypeFlag.
+		static const uint32 INVALID_SLOT	= UINT32_MAX;
+
+		enum class ResourceType : uint8
+		{
+			CONSTANT_BUFFER = 0,
+			SHADER_RESOURCE,
+			SAMPLER,
+			UNORDERED_ACCESS,
+			COUNT
+		};
+
+		struct Resource
+		{
+			std::string				Name				= "";
+			ResourceType			Type				= ResourceType::SHADER_RESOURCE;
+			uint32					Slots[NUM_STAGES]	= { INVALID_SLOT, INVALID_SLOT, INVALID_SLOT, INVALID_SLOT, INVALID_SLOT, INVALID_SLOT }; // INVALID_SLOT in the stages which do not use the resource.
+			uint32					Count				= 1; // Number of slots, larger than one for arrays.
+			uint32					Size				= 0; // Size in bytes of a constant buffer.
+			std::vector<ShaderReflectionData::Variable> Variables;
+		};
+
+	public:
+		RS_DEFAULT_CLASS(ShaderBindingLayout);
+
+		/*
+		* Add the resources of one stage. A resource with the same name and type in several stages is one resource with a slot in each.
+		*/
+		void AddStage(ShaderTypeFlag type, const ShaderReflectionData& reflection);
+		void Clear();
+
+		/*
+		* Returns the index of the resource, or -1 if the shader does not use it.
+		*/
+		int32 GetResourceIndex(const std::string& name) const;
+
+		/*
+		* Find a member of a constant buffer, returns nullptr if it does not exist.
+		*/
+		const ShaderReflectionData::Variable* FindVariable(const std::string& bufferName, const std::string& variableName) const;
+
+		const Resource& GetResource(uint32 index) const;
+		uint32 GetNumResources() const;
+
+		/*
+		* A new ID is given to the layout each time it changes, such that a ShaderBindingTable can tell if it has to be rebuilt.
+		*/
+		uint64 GetID() const;
+
+		static uint32 GetStageIndex(ShaderTypeFlag type);
+		static ShaderTypeFlag GetStageType(uint32 stageIndex);
+
+	private:
+		std::vector<Resource>					m_Resources;
+		std::unordered_map<std::string, uint32>	m_ResourceIndices;
+		uint64									m_ID = 0;
+	};
+}
@@ -0,0 +1,198 @@
+#include "PreCompiled.h"
+#include "ShaderBindingTable.h"
+
+#include "Renderer/StateCache.h"
+
+#include <algorithm>
+
+using namespace RS;
+
+namespace
+{
+	const uint32 COMPUTE_STAGE = ShaderBindingLayout::GetStageIndex(ShaderTypeFlag::COMPUTE);
+}
+
+void ShaderBindingTable::Init(const ShaderBindingLayout& layout, const std::vector<std::string>& names)
+{
+	struct SlotBinding
+	{
+		uint32 Stage	= 0;
+		uint32 Type		= 0;
+		uint32 Slot		= 0;
+		uint32 Entry	= 0;
+		uint32 Element	= 0;
+	};
+
+	m_Entries.clear();
+	m_Entries.resize(names.size());
+	m_Ranges.clear();
+	m_ConstantBuffers.clear();
+	m_ShaderResources.clear();
+	m_Samplers.clear();
+	m_UnorderedAccess.clear();
+	m_LayoutID = layout.GetID();
+
+	std::vector<SlotBinding> slots;
+	for (uint32 entryIndex = 0; entryIndex < (uint32)names.size(); entryIndex++)
+	{
+		// The compiler removes unused resources, so a name can be missing in some variants of a shader.
+		int32 resourceIndex = layout.GetResourceIndex(names[entryIndex]);
+		if (resourceIndex < 0)
+			continue;
+
+		const ShaderBindingLayout::Resource& resource = layout.GetResource((uint32)resourceIndex);
+		Entry& entry = m_Entries[entryIndex];
+		entry.Type	= resource.Type;
+		entry.Count	= resource.Count;
+		for (uint32 stage = 0; stage < ShaderBindingLayout::NUM_STAGES; stage++)
+		{
+			if (resource.Slots[stage] == ShaderBindingLayout::INVALID_SLOT)
+				continue;
+			if (resource.Type == ResourceType::UNORDERED_ACCESS && stage != COMPUTE_STAGE)
+			{
+				LOG_WARNING("Shader resource {} is an unordered access view outside of a compute shader, it is not supported by the binding table!", names[entryIndex].c_str());
+				continue;
+			}
+
+			for (uint32 element = 0; element < resource.Count; element++)
+				slots.push_back({ stage, (uint32)resource.Type, resource.Slots[stage] + element, entryIndex, element });
+		}
+	}
+
+	std::sort(slots.begin(), slots.end(), [](const SlotBinding& a, const SlotBinding& b)
+	{
+		if (a.Stage != b.Stage)
+			return a.Stage < b.Stage;
+		if (a.Type != b.Type)
+			return a.Type < b.Type;
+		return a.Slot < b.Slot;
+	});
+
+	// Merge the slots into ranges, each range is one call in Apply.
+	uint32 typeSizes[(uint32)ResourceType::COUNT] = {};
+	for (uint32 i = 0; i < (uint32)slots.size(); i++)
+	{
+		const SlotBinding& slot = slots[i];
+		bool extendsRange = !m_Ranges.empty()
+			&& m_Ranges.back().Stage == slot.Stage
+			&& (uint32)m_Ranges.back().Type == slot.Type
+			&& m_Ranges.back().StartSlot + m_Ranges.back().Count == slot.Slot;
+
+		uint32 offset = typeSizes[slot.Type]++;
+		if (extendsRange)
+		{
+			m_Ranges.back().Count++;
+		}
+		else
+		{
+			Range range;
+			range.Stage		= slot.Stage;
+			range.Type		= (ResourceType)slot.Type;
+			range.StartSlot	= slot.Slot;
+			range.Count		= 1;
+			range.Offset	= offset;
+			m_Ranges.push_back(range);
+		}
+
+		// Elements of an array are in contiguous slots, only the offset of the first is needed.
+		if (slot.Element == 0)
+			m_Entries[slot.Entry].Offsets.push_back(offset);
+	}
+
+	m_ConstantBuffers.resize(typeSizes[(uint32)ResourceType::CONSTANT_BUFFER], nullptr);
+	m_ShaderResources.resize(typeSizes[(uint32)ResourceType::SHADER_RESOURCE], nullptr);
+	m_Samplers.resize(typeSizes[(uint32)ResourceType::SAMPLER], nullptr);
+	m_UnorderedAccess.resize(typeSizes[(uint32)ResourceType::UNORDERED_ACCESS], nullptr);
+}
+
+bool ShaderBindingTable::IsBuiltFrom(const ShaderBindingLayout& layout) const
+{
+	return m_LayoutID != 0 && m_LayoutID == layout.GetID();
+}
+
+template<typename T>
+void ShaderBindingTable::Set(uint32 index, ResourceType type, std::vector<T*>& resources, T* pResource, uint32 element)
+{
+	if (index >= (uint32)m_Entries.size())
+	{
+		LOG_WARNING("Binding table index {} is out of range!", index);
+		return;
+	}
+
+	const Entry& entry = m_Entries[index];
+	if (entry.Offsets.empty() || element >= entry.Count)
+		return;
+
+	if (entry.Type != type)
+	{
+		LOG_WARNING("Binding table entry {} was set with the wrong resource type!", index);
+		return;
+	}
+
+	for (uint32 offset : entry.Offsets)
+		resources[offset + element] = pResource;
+}
+
+void ShaderBindingTable::SetConstantBuffer(uint32 index, ID3D11Buffer* pBuffer, uint32 element)
+{
+	Set(index, ResourceType::CONSTANT_BUFFER, m_ConstantBuffers, pBuffer, element);
+}
+
+void ShaderBindingTable::SetShaderResource(uint32 index, ID3D11ShaderResourceView* pView, uint32 element)
+{
+	Set(index, ResourceType::SHADER_RESOURCE, m_ShaderResources, pView, element);
+}
+
+void ShaderBindingTable::SetSampler(uint32 index, ID3D11SamplerState* pSampler, uint32 element)
+{
+	Set(index, ResourceType::SAMPLER, m_Samplers, pSampler, element);
+}
+
+void ShaderBindingTable::SetUnorderedAccess(uint32 index, ID3D11UnorderedAccessView* pView, uint32 element)
+{
+	Set(index, ResourceType::UNORDERED_ACCESS, m_UnorderedAccess, pView, element);
+}
+
+bool ShaderBindingTable::IsUsed(uint32 index) const
+{
+	return index < (uint32)m_Entries.size() && !m_Entries[index].Offsets.empty();
+}
+
+void ShaderBindingTable::Apply()
+{
+	std::shared_ptr<StateCache> stateCache = StateCache::Get();
+	for (const Range& range : m_Ranges)
+	{
+		ShaderTypeFlag stage = ShaderBindingLayout::GetStageType(range.Stage);
+		switch (range.Type)
+		{
+		case ResourceType::CONSTANT_BUFFER:
+			stateCache->SetConstantBuffers(stage, range.StartSlot, range.Count, &m_ConstantBuffers[range.Offset]);
+			break;
+		case ResourceType::SHADER_RESOURCE:
+			stateCache->SetShaderResources(stage, range.StartSlot, range.Count, &m_ShaderResources[range.Offset]);
+			break;
+		case ResourceType::SAMPLER:
+			stateCache->SetSamplers(stage, range.StartSlot, range.Count, &m_Samplers[range.Offset]);
+			break;
+		case ResourceType::UNORDERED_ACCESS:
+			stateCache->SetUnorderedAccessViews(range.StartSlot, range.Count, &m_UnorderedAccess[range.Offset]);
+			break;
+		default:
+			break;
+		}
+		m_Stats.NumBindings += range.Count;
+	}
+	m_Stats.NumCalls += (uint32)m_Ranges.size();
+	m_Stats.NumApplies++;
+}
+
+uint32 ShaderBindingTable::GetNumRanges() const
+{
+	return (uint32)m_Ranges.size();
+}
+
+const ShaderBindingTable::Stats& ShaderBindingTable::GetStats() const
+{
+	return m_Stats;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "Renderer/RenderAPI.h"
+#include "Renderer/ShaderBindingLayout.h"
+
+namespace RS
+{
+	/*
+	* The resources to bind for a shader, set by index instead of by slot.
+	* The names are resolved against the ShaderBindingLayout once in Init. Resources which are in contiguous slots of the same stage and type are then bound with one call in Apply.
+	* Example:
+	*	table.Init(pShader->GetBindingLayout(), { "albedoTexture", "normalTexture", "linearSampler" });
+	*	table.SetShaderResource(0, pAlbedoSRV);
+	*	table.SetShaderResource(1, pNormalSRV);
+	*	table.SetSampler(2, pSampler);
+	*	table.Apply();
+	*/
+	class ShaderBindingTable
+	{
+	public:
+		struct Stats
+		{
+			uint32	NumApplies	= 0;
+			uint32	NumCalls	= 0; // Number of bind calls made by Apply.
+			uint32	NumBindings	= 0; // Number of slots bound by Apply, which would be the number of calls without the coalescing.
+		};
+
+	public:
+		RS_DEFAULT_CLASS(ShaderBindingTable);
+
+		/*
+		* Entry i of the table is the resource names[i]. Names which the shader does not use are allowed, setting them does nothing.
+		* This can be called again to rebuild the table, it clears all set resources.
+		*/
+		void Init(const ShaderBindingLayout& layout, const std::vector<std::string>& names);
+
+		/*
+		* Returns true if the table was built from the current state of the layout.
+		*/
+		bool IsBuiltFrom(const ShaderBindingLayout& layout) const;
+
+		/*
+		* element: The element of an array resource.
+		*/
+		void SetConstantBuffer(uint32 index, ID3D11Buffer* pBuffer, uint32 element = 0);
+		void SetShaderResource(uint32 index, ID3D11ShaderResourceView* pView, uint32 element = 0);
+		void SetSampler(uint32 index, ID3D11SamplerState* pSampler, uint32 element = 0);
+		void SetUnorderedAccess(uint32 index, ID3D11UnorderedAccessView* pView, uint32 element = 0); // Only compute shaders.
+
+		bool IsUsed(uint32 index) const;
+
+		/*
+		* Bind the resources through the StateCache, which also filters the ones which are already bound.
+		*/
+		void Apply();
+
+		uint32 GetNumRanges() const;
+		const Stats& GetStats() const;
+
+	private:
+		using ResourceType = ShaderBindingLayout::ResourceType;
+
+		struct Entry
+		{
+			ResourceType		Type	= ResourceType::SHADER_RESOURCE;
+			uint32				Count	= 0;
+			std::vector<uint32>	Offsets; // Offset of element 0 in the array of the type, one for each stage which uses the resource.
+		};
+
+		struct Range
+		{
+			uint32			Stage		= 0;
+			ResourceType	Type		= ResourceType::SHADER_RESOURCE;
+			uint32			StartSlot	= 0;
+			uint32			Count		= 0;
+			uint32			Offset		= 0;
+		};
+
+		template<typename T>
+		void Set(uint32 index, ResourceType type, std::vector<T*>& resources, T* pResource, uint32 element);
+
+	private:
+		std::vector<Entry>						m_Entries;
+		std::vector<Range>						m_Ranges;
+		std::vector<ID3D11Buffer*>				m_ConstantBuffers;
+		std::vector<ID3D11ShaderResourceView*>	m_ShaderResources;
+		std::vector<ID3D11SamplerState*>		m_Samplers;
+		std::vector<ID3D11UnorderedAccessView*>	m_UnorderedAccess;
+		uint64									m_LayoutID	= 0;
+		Stats									m_Stats;
+	};
+}
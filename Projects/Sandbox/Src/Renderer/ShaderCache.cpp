@@ -0,0 +1,373 @@
+#include "PreCompiled.h"
+#include "ShaderCache.h"
+
+#include "Utils/Timer.h"
+
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+using namespace RS;
+
+namespace
+{
+	const char* ENTRY_EXTENSION = ".rsshd";
+
+	// FNV-1a
+	void HashBytes(uint64& hash, const void* pData, size_t size)
+	{
+		const uint8* pBytes = (const uint8*)pData;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= pBytes[i];
+			hash *= 1099511628211ull;
+		}
+	}
+
+	void HashString(uint64& hash, const std::string& str)
+	{
+		// The length is included, such that "ab" + "c" and "a" + "bc" give different keys.
+		uint64 size = (uint64)str.size();
+		HashBytes(hash, &size, sizeof(size));
+		HashBytes(hash, str.data(), str.size());
+	}
+
+	template<typename T>
+	void Write(std::vector<uint8>& data, const T& value)
+	{
+		const uint8* pBytes = (const uint8*)&value;
+		data.insert(data.end(), pBytes, pBytes + sizeof(T));
+	}
+
+	template<typename T>
+	bool Read(const std::vector<uint8>& data, uint64& offset, T& outValue)
+	{
+		if (offset + sizeof(T) > data.size())
+			return false;
+		std::memcpy(&outValue, data.data() + offset, sizeof(T));
+		offset += sizeof(T);
+		return true;
+	}
+}
+
+std::shared_ptr<ShaderCache> ShaderCache::Get()
+{
+	static std::shared_ptr<ShaderCache> s_ShaderCache = std::make_shared<ShaderCache>();
+	return s_ShaderCache;
+}
+
+void ShaderCache::Init(const std::string& folderPath, uint64 maxSizeBytes, bool enabled, std::shared_ptr<IShaderCompiler> pCompiler)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_FolderPath	= folderPath;
+	m_MaxSizeBytes	= maxSizeBytes;
+	m_Enabled		= enabled;
+	m_pCompiler		= pCompiler ? pCompiler : std::make_shared<D3DShaderCompiler>();
+	m_Entries.clear();
+	m_Stats			= Stats();
+
+	if (!m_Enabled)
+		return;
+
+	std::error_code error;
+	std::filesystem::create_directories(m_FolderPath, error);
+
+	// The write time of an entry is updated when it is used, such that the least recently used entries can be found after a restart.
+	for (const auto& dirEntry : std::filesystem::directory_iterator(m_FolderPath, error))
+	{
+		const std::filesystem::path& path = dirEntry.path();
+		if (!dirEntry.is_regular_file(error) || path.extension() != ENTRY_EXTENSION)
+			continue;
+
+		std::string name = path.stem().string();
+		uint64 key = 0;
+		auto [pEnd, parseError] = std::from_chars(name.data(), name.data() + name.size(), key, 16);
+		if (parseError != std::errc() || pEnd != name.data() + name.size())
+			continue;
+
+		Entry entry;
+		entry.Size		= (uint64)dirEntry.file_size(error);
+		entry.LastUsed	= dirEntry.last_write_time(error);
+		m_Entries[key] = entry;
+		m_Stats.SizeBytes += entry.Size;
+	}
+	m_Stats.NumEntries = (uint32)m_Entries.size();
+
+	// The max size might have been lowered since the last run.
+	Evict(0);
+}
+
+void ShaderCache::Release()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	LOG_INFO("Shader cache: {} hits, {} misses, {} failed, {} evicted. Preprocess: {:.1f} ms, Compile: {:.1f} ms, Load: {:.1f} ms. {} entries, {:.2f} MB.",
+		m_Stats.NumHits, m_Stats.NumMisses, m_Stats.NumFailed, m_Stats.NumEvicted, m_Stats.PreprocessTimeMS, m_Stats.CompileTimeMS, m_Stats.LoadTimeMS,
+		m_Stats.NumEntries, (float)m_Stats.SizeBytes / (1024.f * 1024.f));
+	m_Entries.clear();
+	m_pCompiler.reset();
+}
+
+bool ShaderCache::Compile(const ShaderCompileDesc& desc, ShaderCompileResult& outResult)
+{
+	std::shared_ptr<IShaderCompiler> pCompiler;
+	bool enabled = false;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		pCompiler	= m_pCompiler ? m_pCompiler : std::make_shared<D3DShaderCompiler>();
+		enabled		= m_Enabled;
+	}
+
+	// The preprocessed source is needed for the key, it also gives the includes for the hot reloading.
+	Timer timer;
+	timer.Start();
+	std::string source;
+	bool succeeded = pCompiler->Preprocess(desc, source, outResult);
+	float preprocessTimeMS = timer.CalcDelta().GetDeltaTimeMS();
+	if (!succeeded)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Stats.PreprocessTimeMS += preprocessTimeMS;
+		m_Stats.NumFailed++;
+		return false;
+	}
+
+	uint64 key = ComputeKey(desc, source, pCompiler->GetName());
+	if (enabled && ReadEntry(key, outResult))
+	{
+		float loadTimeMS = timer.Stop().GetDeltaTimeMS();
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Stats.PreprocessTimeMS += preprocessTimeMS;
+		m_Stats.LoadTimeMS += loadTimeMS;
+		m_Stats.NumHits++;
+		return true;
+	}
+
+	succeeded = pCompiler->Compile(desc, source, outResult);
+	if (succeeded && enabled)
+		WriteEntry(key, outResult);
+
+	float compileTimeMS = timer.Stop().GetDeltaTimeMS();
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Stats.PreprocessTimeMS += preprocessTimeMS;
+	m_Stats.CompileTimeMS += compileTimeMS;
+	m_Stats.NumMisses++;
+	m_Stats.NumFailed += succeeded ? 0 : 1;
+	return succeeded;
+}
+
+ShaderCache::Stats ShaderCache::GetStats()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_Stats;
+}
+
+uint64 ShaderCache::ComputeKey(const ShaderCompileDesc& desc, const std::string& preprocessedSource, const std::string& compilerName)
+{
+	uint64 hash = 14695981039346656037ull;
+	uint32 version = VERSION;
+	HashBytes(hash, &version, sizeof(version));
+	HashString(hash, compilerName);
+	HashString(hash, desc.EntryPoint);
+	HashString(hash, desc.Target);
+	HashBytes(hash, &desc.Flags, sizeof(desc.Flags));
+	for (auto& [name, value] : desc.Defines)
+	{
+		HashString(hash, name);
+		HashString(hash, value);
+	}
+	HashString(hash, preprocessedSource);
+	return hash;
+}
+
+void ShaderCache::SerializeEntry(uint64 key, const ShaderCompileResult& result, std::vector<uint8>& outData)
+{
+	EntryHeader header;
+	header.Key			= key;
+	header.ByteCodeSize	= (uint64)result.ByteCode.size();
+	header.NumBindings	= (uint32)result.Reflection.Bindings.size();
+
+	outData.clear();
+	Write(outData, header);
+	outData.insert(outData.end(), result.ByteCode.begin(), result.ByteCode.end());
+	for (const ShaderReflectionData::Binding& binding : result.Reflection.Bindings)
+	{
+		Write(outData, (uint32)binding.Name.size());
+		outData.insert(outData.end(), binding.Name.begin(), binding.Name.end());
+		Write(outData, binding.Type);
+		Write(outData, binding.BindPoint);
+		Write(outData, binding.BindCount);
+		Write(outData, binding.Size);
+		Write(outData, (uint32)binding.Variables.size());
+		for (const ShaderReflectionData::Variable& variable : binding.Variables)
+		{
+			Write(outData, (uint32)variable.Name.size());
+			outData.insert(outData.end(), variable.Name.begin(), variable.Name.end());
+			Write(outData, variable.Offset);
+			Write(outData, variable.Size);
+		}
+	}
+}
+
+bool ShaderCache::DeserializeEntry(uint64 key, const std::vector<uint8>& data, ShaderCompileResult& outResult)
+{
+	uint64 offset = 0;
+	EntryHeader header;
+	if (!Read(data, offset, header) || header.Magic != MAGIC || header.Version != VERSION || header.Key != key)
+		return false;
+	if (offset + header.ByteCodeSize > data.size())
+		return false;
+
+	std::vector<uint8> byteCode(data.begin() + offset, data.begin() + offset + header.ByteCodeSize);
+	offset += header.ByteCodeSize;
+
+	// Each binding takes at least 24 bytes, this stops a broken header from allocating too much.
+	if ((uint64)header.NumBindings * 24 > data.size() - offset)
+		return false;
+
+	ShaderReflectionData reflection;
+	reflection.Bindings.resize(header.NumBindings);
+	for (ShaderReflectionData::Binding& binding : reflection.Bindings)
+	{
+		uint32 nameLength = 0;
+		if (!Read(data, offset, nameLength) || offset + nameLength > data.size())
+			return false;
+		binding.Name.assign((const char*)data.data() + offset, nameLength);
+		offset += nameLength;
+
+		if (!Read(data, offset, binding.Type) || !Read(data, offset, binding.BindPoint) || !Read(data, offset, binding.BindCount) || !Read(data, offset, binding.Size))
+			return false;
+
+		// Each variable takes at least 12 bytes.
+		uint32 numVariables = 0;
+		if (!Read(data, offset, numVariables) || (uint64)numVariables * 12 > data.size() - offset)
+			return false;
+
+		binding.Variables.resize(numVariables);
+		for (ShaderReflectionData::Variable& variable : binding.Variables)
+		{
+			if (!Read(data, offset, nameLength) || offset + nameLength > data.size())
+				return false;
+			variable.Name.assign((const char*)data.data() + offset, nameLength);
+			offset += nameLength;
+
+			if (!Read(data, offset, variable.Offset) || !Read(data, offset, variable.Size))
+				return false;
+		}
+	}
+
+	outResult.ByteCode		= std::move(byteCode);
+	outResult.Reflection	= std::move(reflection);
+	outResult.FromCache		= true;
+	return true;
+}
+
+bool ShaderCache::ReadEntry(uint64 key, ShaderCompileResult& outResult)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		if (!m_Entries.contains(key))
+			return false;
+	}
+
+	std::filesystem::path path = GetEntryPath(key);
+	std::ifstream file(path, std::ios::binary);
+	std::vector<uint8> data;
+	if (file.is_open())
+		data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	file.close();
+
+	std::error_code error;
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	if (!DeserializeEntry(key, data, outResult))
+	{
+		// Remove a broken entry, it is written again after the shader has been compiled.
+		LOG_WARNING("Shader cache entry {} is invalid and will be replaced!", path.string().c_str());
+		auto it = m_Entries.find(key);
+		if (it != m_Entries.end())
+		{
+			m_Stats.SizeBytes -= it->second.Size;
+			m_Entries.erase(it);
+			m_Stats.NumEntries = (uint32)m_Entries.size();
+		}
+		std::filesystem::remove(path, error);
+		return false;
+	}
+
+	// Mark the entry as used, on disk as well.
+	std::filesystem::file_time_type now = std::filesystem::file_time_type::clock::now();
+	auto it = m_Entries.find(key);
+	if (it != m_Entries.end())
+		it->second.LastUsed = now;
+	std::filesystem::last_write_time(path, now, error);
+	return true;
+}
+
+void ShaderCache::WriteEntry(uint64 key, const ShaderCompileResult& result)
+{
+	std::vector<uint8> data;
+	SerializeEntry(key, result, data);
+
+	// Write to a temporary file first, such that another thread or a crash never leaves a partial entry.
+	std::filesystem::path path = GetEntryPath(key);
+	std::filesystem::path tempPath = path;
+	tempPath += "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+	std::error_code error;
+	{
+		// Writing to a file which did not open fails as well, the temporary file is removed on each failure.
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		file.write((const char*)data.data(), (std::streamsize)data.size());
+		file.close();
+		if (file.fail())
+		{
+			LOG_WARNING("Failed to write shader cache entry {}!", path.string().c_str());
+			std::filesystem::remove(tempPath, error);
+			return;
+		}
+	}
+
+	std::filesystem::rename(tempPath, path, error);
+	if (error)
+	{
+		std::filesystem::remove(tempPath, error);
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	Entry& entry = m_Entries[key];
+	m_Stats.SizeBytes	-= entry.Size;
+	entry.Size			= (uint64)data.size();
+	entry.LastUsed		= std::filesystem::file_time_type::clock::now();
+	m_Stats.SizeBytes	+= entry.Size;
+	m_Stats.NumEntries	= (uint32)m_Entries.size();
+	Evict(key);
+}
+
+void ShaderCache::Evict(uint64 keepKey)
+{
+	std::error_code error;
+	while (m_Stats.SizeBytes > m_MaxSizeBytes)
+	{
+		auto oldestIt = m_Entries.end();
+		for (auto it = m_Entries.begin(); it != m_Entries.end(); it++)
+		{
+			if (it->first != keepKey && (oldestIt == m_Entries.end() || it->second.LastUsed < oldestIt->second.LastUsed))
+				oldestIt = it;
+		}
+		if (oldestIt == m_Entries.end())
+			break;
+
+		std::filesystem::remove(GetEntryPath(oldestIt->first), error);
+		m_Stats.SizeBytes -= oldestIt->second.Size;
+		m_Entries.erase(oldestIt);
+		m_Stats.NumEvicted++;
+	}
+	m_Stats.NumEntries = (uint32)m_Entries.size();
+}
+
+std::filesystem::path ShaderCache::GetEntryPath(uint64 key) const
+{
+	char name[17] = {};
+	std::to_chars(name, name + 16, key, 16);
+	return std::filesystem::path(m_FolderPath) / (std::string(name) + ENTRY_EXTENSION);
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "Renderer/ShaderCompiler.h"
+
+#include <filesystem>
+#include <memory>
+#include <mutex>
+
+namespace RS
+{
+	/*
+	* Stores compiled shaders on disk, such that they do not have to be compiled again the next time the application starts.
+	* The key is a hash of the preprocessed source, the entry point, target, flags, defines and the compiler name. A file which is included therefore also changes the key.
+	* When the cache grows larger than its max size, the entries which were used least recently are removed.
+	*/
+	class ShaderCache
+	{
+	public:
+		static const uint32 VERSION	= 2;
+		static const uint32 MAGIC	= 0x48535352; // "RSSH"
+
+		struct EntryHeader
+		{
+			uint32	Magic			= MAGIC;
+			uint32	Version			= VERSION;
+			uint64	Key				= 0;
+			uint64	ByteCodeSize	= 0;
+			uint32	NumBindings		= 0;
+			uint32	_Padding		= 0;
+		};
+
+		struct Stats
+		{
+			uint32	NumHits				= 0;
+			uint32	NumMisses			= 0;
+			uint32	NumFailed			= 0;
+			uint32	NumEvicted			= 0;
+			uint32	NumEntries			= 0;
+			uint64	SizeBytes			= 0;
+			float	PreprocessTimeMS	= 0.f;
+			float	CompileTimeMS		= 0.f; // Only the misses.
+			float	LoadTimeMS			= 0.f; // Only the hits.
+		};
+
+	public:
+		RS_DEFAULT_ABSTRACT_CLASS(ShaderCache);
+
+		static std::shared_ptr<ShaderCache> Get();
+
+		/*
+		* folderPath: Where the entries are stored, it is created if it does not exist.
+		* enabled: When false, every shader is compiled and nothing is read or written.
+		* pCompiler: The compiler to use on a miss, a D3DShaderCompiler is used if it is nullptr.
+		*/
+		void Init(const std::string& folderPath, uint64 maxSizeBytes, bool enabled, std::shared_ptr<IShaderCompiler> pCompiler = nullptr);
+		void Release();
+
+		/*
+		* Preprocess the shader and read the bytecode from the cache, or compile it and store it if it is not there.
+		* This is thread safe.
+		*/
+		bool Compile(const ShaderCompileDesc& desc, ShaderCompileResult& outResult);
+
+		Stats GetStats();
+
+		static uint64 ComputeKey(const ShaderCompileDesc& desc, const std::string& preprocessedSource, const std::string& compilerName);
+
+		static void SerializeEntry(uint64 key, const ShaderCompileResult& result, std::vector<uint8>& outData);
+		static bool DeserializeEntry(uint64 key, const std::vector<uint8>& data, ShaderCompileResult& outResult);
+
+	private:
+		struct Entry
+		{
+			uint64								Size		= 0;
+			std::filesystem::file_time_type		LastUsed;
+		};
+
+		bool ReadEntry(uint64 key, ShaderCompileResult& outResult);
+		void WriteEntry(uint64 key, const ShaderCompileResult& result);
+
+		// m_Mutex needs to be locked.
+		void Evict(uint64 keepKey);
+
+		std::filesystem::path GetEntryPath(uint64 key) const;
+
+	private:
+		std::mutex							m_Mutex;
+		std::string							m_FolderPath;
+		uint64								m_MaxSizeBytes	= 0;
+		bool								m_Enabled		= false;
+		std::shared_ptr<IShaderCompiler>	m_pCompiler;
+		std::unordered_map<uint64, Entry>	m_Entries;
+		Stats								m_Stats;
+	};
+}
@@ -0,0 +1,138 @@
+#include "PreCompiled.h"
+#include "ShaderCompiler.h"
+
+#include "Renderer/RenderAPI.h"
+#include "Renderer/ShaderIncludeHandler.h"
+
+#include <cstring>
+
+using namespace RS;
+
+namespace
+{
+	std::string BlobToString(ID3DBlob* pBlob)
+	{
+		if (pBlob == nullptr)
+			return "";
+		const char* pText = (const char*)pBlob->GetBufferPointer();
+		return std::string(pText, strnlen(pText, pBlob->GetBufferSize()));
+	}
+}
+
+bool D3DShaderCompiler::Preprocess(const ShaderCompileDesc& desc, std::string& outSource, ShaderCompileResult& outResult)
+{
+	std::string source;
+	if (!ShaderIncludeHandler::ReadFile(desc.FilePath, source))
+	{
+		outResult.Errors = "Missing file: " + desc.FilePath;
+		return false;
+	}
+
+	std::vector<D3D_SHADER_MACRO> macros;
+	for (auto& [name, value] : desc.Defines)
+		macros.push_back({ name.c_str(), value.c_str() });
+	macros.push_back({ nullptr, nullptr });
+
+	ID3DBlob* pText = nullptr;
+	ID3DBlob* pErrors = nullptr;
+	ShaderIncludeHandler includeHandler(desc.FilePath);
+	HRESULT result = D3DPreprocess(source.data(), source.size(), desc.FilePath.c_str(), macros.data(), &includeHandler, &pText, &pErrors);
+	outResult.Includes = includeHandler.GetIncludes();
+	outResult.Errors = BlobToString(pErrors);
+	if (pErrors)
+		pErrors->Release();
+
+	if (FAILED(result) || pText == nullptr)
+	{
+		if (pText)
+			pText->Release();
+		return false;
+	}
+
+	// The text keeps the #line directives, such that errors still point to the original files.
+	outSource = BlobToString(pText);
+	pText->Release();
+	return true;
+}
+
+bool D3DShaderCompiler::Compile(const ShaderCompileDesc& desc, const std::string& preprocessedSource, ShaderCompileResult& outResult)
+{
+	// The defines and includes were already resolved when preprocessing.
+	ID3DBlob* pByteCode = nullptr;
+	ID3DBlob* pErrors = nullptr;
+	HRESULT result = D3DCompile(preprocessedSource.data(), preprocessedSource.size(), desc.FilePath.c_str(), nullptr, nullptr,
+		desc.EntryPoint.c_str(), desc.Target.c_str(), desc.Flags, 0, &pByteCode, &pErrors);
+	outResult.Errors = BlobToString(pErrors);
+	if (pErrors)
+		pErrors->Release();
+
+	if (FAILED(result) || pByteCode == nullptr)
+	{
+		if (pByteCode)
+			pByteCode->Release();
+		return false;
+	}
+
+	const uint8* pData = (const uint8*)pByteCode->GetBufferPointer();
+	outResult.ByteCode.assign(pData, pData + pByteCode->GetBufferSize());
+	pByteCode->Release();
+
+	return Reflect(outResult.ByteCode, outResult.Reflection);
+}
+
+std::string D3DShaderCompiler::GetName() const
+{
+	return "D3DCompiler_" + std::to_string(D3D_COMPILER_VERSION);
+}
+
+bool D3DShaderCompiler::Reflect(const std::vector<uint8>& byteCode, ShaderReflectionData& outReflection)
+{
+	ID3D11ShaderReflection* pReflection = nullptr;
+	HRESULT result = D3DReflect(byteCode.data(), byteCode.size(), IID_ID3D11ShaderReflection, (void**)&pReflection);
+	RS_D311_CHECK(result, "Failed to create shader reflection!");
+	if (FAILED(result))
+		return false;
+
+	D3D11_SHADER_DESC shaderDesc = {};
+	pReflection->GetDesc(&shaderDesc);
+
+	outReflection.Bindings.clear();
+	for (UINT i = 0; i < shaderDesc.BoundResources; i++)
+	{
+		D3D11_SHADER_INPUT_BIND_DESC bindDesc = {};
+		if (FAILED(pReflection->GetResourceBindingDesc(i, &bindDesc)))
+			continue;
+
+		ShaderReflectionData::Binding binding;
+		binding.Name		= bindDesc.Name;
+		binding.Type		= (uint32)bindDesc.Type;
+		binding.BindPoint	= bindDesc.BindPoint;
+		binding.BindCount	= bindDesc.BindCount;
+		if (bindDesc.Type == D3D_SIT_CBUFFER)
+		{
+			D3D11_SHADER_BUFFER_DESC bufferDesc = {};
+			ID3D11ShaderReflectionConstantBuffer* pBuffer = pReflection->GetConstantBufferByName(bindDesc.Name);
+			if (pBuffer && SUCCEEDED(pBuffer->GetDesc(&bufferDesc)))
+			{
+				binding.Size = bufferDesc.Size;
+				for (UINT j = 0; j < bufferDesc.Variables; j++)
+				{
+					D3D11_SHADER_VARIABLE_DESC variableDesc = {};
+					ID3D11ShaderReflectionVariable* pVariable = pBuffer->GetVariableByIndex(j);
+					if (pVariable == nullptr || FAILED(pVariable->GetDesc(&variableDesc)))
+						continue;
+
+					ShaderReflectionData::Variable variable;
+					variable.Name	= variableDesc.Name;
+					variable.Offset	= variableDesc.StartOffset;
+					variable.Size	= variableDesc.Size;
+					binding.Variables.push_back(variable);
+				}
+			}
+		}
+		outReflection.Bindings.push_back(binding);
+	}
+
+	pReflection->Release();
+	return true;
+}
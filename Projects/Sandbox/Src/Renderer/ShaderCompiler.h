@@ -0,0 +1,87 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace RS
+{
+	/*
+	* The resources a compiled shader binds, read from the D3D reflection and stored with the bytecode in the ShaderCache.
+	*/
+	struct ShaderReflectionData
+	{
+		struct Variable
+		{
+			std::string	Name	= "";
+			uint32		Offset	= 0; // Offset in bytes from the start of the constant buffer.
+			uint32		Size	= 0;
+		};
+
+		struct Binding
+		{
+			std::string				Name		= "";
+			uint32					Type		= 0; // D3D_SHADER_INPUT_TYPE
+			uint32					BindPoint	= 0;
+			uint32					BindCount	= 0;
+			uint32					Size		= 0; // Size in bytes of a constant buffer, zero for other types.
+			std::vector<Variable>	Variables;		 // The members of a constant buffer.
+		};
+
+		std::vector<Binding> Bindings;
+	};
+
+	struct ShaderCompileDesc
+	{
+		std::string											FilePath	= "";
+		std::string											EntryPoint	= "main";
+		std::string											Target		= "";
+		uint32												Flags		= 0; // D3DCOMPILE_* flags
+		std::vector<std::pair<std::string, std::string>>	Defines;
+	};
+
+	struct ShaderCompileResult
+	{
+		std::vector<uint8>											ByteCode;
+		ShaderReflectionData										Reflection;
+		std::unordered_map<std::string, std::vector<std::string>>	Includes;	// The files each file included directly, see ShaderIncludeHandler.
+		std::string													Errors		= "";
+		bool														FromCache	= false;
+	};
+
+	/*
+	* Turns HLSL into bytecode in two steps, such that the ShaderCache can look for the preprocessed source before compiling it.
+	*/
+	class IShaderCompiler
+	{
+	public:
+		RS_DEFAULT_ABSTRACT_CLASS(IShaderCompiler);
+
+		/*
+		* Read the file and resolve all includes and defines. The includes are added to outResult.
+		* The preprocessed source has to contain everything which can change the bytecode, except for what is in the descriptor.
+		*/
+		virtual bool Preprocess(const ShaderCompileDesc& desc, std::string& outSource, ShaderCompileResult& outResult) = 0;
+
+		/*
+		* Compile the preprocessed source and fill in the bytecode and reflection of outResult.
+		*/
+		virtual bool Compile(const ShaderCompileDesc& desc, const std::string& preprocessedSource, ShaderCompileResult& outResult) = 0;
+
+		/*
+		* Part of the cache key, change it when the compiler changes its output.
+		*/
+		virtual std::string GetName() const = 0;
+	};
+
+	class D3DShaderCompiler : public IShaderCompiler
+	{
+	public:
+		bool Preprocess(const ShaderCompileDesc& desc, std::string& outSource, ShaderCompileResult& outResult) override;
+		bool Compile(const ShaderCompileDesc& desc, const std::string& preprocessedSource, ShaderCompileResult& outResult) override;
+		std::string GetName() const override;
+
+	private:
+		static bool Reflect(const std::vector<uint8>& byteCode, ShaderReflectionData& outReflection);
+	};
+}
@@ -1,34 +1,65 @@
 #include "PreCompiled.h"
 #include "ShaderHotReloader.h"
 
+#include "Utils/Timer.h"
+
+#include <algorithm>
+#include <unordered_set>
+
 using namespace RS;
 
 FileWatcher								ShaderHotReloader::s_fileWatcher;
 std::vector<std::pair<Shader*, bool>>	ShaderHotReloader::s_Shaders;
+ShaderIncludeGraph						ShaderHotReloader::s_IncludeGraph;
 std::mutex								ShaderHotReloader::s_Mutex;
 bool									ShaderHotReloader::s_ShouldUpdate;
+std::filesystem::file_time_type			ShaderHotReloader::s_FirstChangeTime;
+ShaderHotReloader::Stats				ShaderHotReloader::s_Stats;
 
 void ShaderHotReloader::Init()
 {
-	// Check for update each second
-	s_fileWatcher.Init(1000);
+	// Wait for change notifications, and only poll (each second) if they are not available.
+	// Changes are collected for 50 ms such that a save which writes the file several times only reloads once.
+	s_fileWatcher.Init(1000, FileWatcher::Backend::EVENTS, 50);
 
 	// Add a callback function which checks for shaders which should be reloaded.
 	FileWatcher::FileCallback callback;
 	callback.callback = [](std::vector<std::string> files)
 	{
 		std::lock_guard<std::mutex> lock(s_Mutex);
-		s_ShouldUpdate = true;
 
+		// The modified files and every file which includes them, directly or through other includes.
+		std::unordered_set<std::string> affectedFiles;
+		s_IncludeGraph.GetDependents(files, affectedFiles);
+
+		bool hasMarkedShaders = false;
 		for (auto& shader : s_Shaders)
 		{
 			auto& shaderFiles = shader.first->GetFiles();
-			for (auto shaderFile : shaderFiles)
+			for (auto& shaderFile : shaderFiles)
 			{
-				if (std::count(files.begin(), files.end(), shaderFile))
+				if (affectedFiles.contains(ShaderIncludeGraph::NormalizePath(shaderFile)))
+				{
 					shader.second = true;
+					hasMarkedShaders = true;
+				}
 			}
 		}
+
+		if (!hasMarkedShaders)
+			return;
+
+		// Remember when the first file was saved, to measure the time until the new shaders are used.
+		if (!s_ShouldUpdate)
+			s_FirstChangeTime = std::filesystem::file_time_type::clock::now();
+		for (auto& file : files)
+		{
+			std::error_code error;
+			std::filesystem::file_time_type writeTime = std::filesystem::last_write_time(file, error);
+			if (!error)
+				s_FirstChangeTime = std::min(s_FirstChangeTime, writeTime);
+		}
+		s_ShouldUpdate = true;
 	};
 	s_fileWatcher.AddCallBack(callback);
 }
@@ -43,11 +74,13 @@ void ShaderHotReloader::AddShader(Shader* shader)
 	// Add a shader to the watcher.
 	if (shader != nullptr)
 	{
+		std::lock_guard<std::mutex> lock(s_Mutex);
 		auto& files = shader->GetFiles();
 		for (auto& file : files)
 		{
 			s_fileWatcher.AddFile(file);
 		}
+		AddIncludes(shader);
 
 		s_Shaders.push_back(std::make_pair(shader, false));
 	}
@@ -57,21 +90,74 @@ void ShaderHotReloader::AddShader(Shader* shader)
 	}
 }
 
-void ShaderHotReloader::Update()
+void ShaderHotReloader::RemoveShader(Shader* shader)
 {
-	// If shaders sould be updated, reload them.
+	// The files stay watched, they might be used by other shaders.
 	std::lock_guard<std::mutex> lock(s_Mutex);
-	if (s_ShouldUpdate)
+	s_Shaders.erase(std::remove_if(s_Shaders.begin(), s_Shaders.end(), [&](auto& pair) { return pair.first == shader; }), s_Shaders.end());
+}
+
+void ShaderHotReloader::Update()
+{
+	// Take the shaders which should be reloaded, and reload them without holding the lock such that the watcher thread is not blocked by the compiles.
+	// Shaders are only removed from the main thread, the same one which calls Update, so they stay alive while reloading.
+	std::vector<Shader*> shadersToReload;
+	std::filesystem::file_time_type firstChangeTime;
+	uint32 numShaders = 0;
 	{
+		std::lock_guard<std::mutex> lock(s_Mutex);
+		if (!s_ShouldUpdate)
+			return;
+
 		for (auto& shader : s_Shaders)
 		{
 			if (shader.second)
 			{
 				shader.second = false;
-				shader.first->Reload();
+				shadersToReload.push_back(shader.first);
 			}
 		}
+		firstChangeTime	= s_FirstChangeTime;
+		numShaders		= (uint32)s_Shaders.size();
+		s_ShouldUpdate	= false;
+	}
+
+	Timer timer;
+	timer.Start();
+	for (Shader* pShader : shadersToReload)
+		pShader->Reload();
+	const float compileTimeMS = timer.Stop().GetDeltaTimeMS();
+
+	std::lock_guard<std::mutex> lock(s_Mutex);
+
+	// The shaders might include new files.
+	for (Shader* pShader : shadersToReload)
+		AddIncludes(pShader);
+
+	const uint32 numReloadedShaders = (uint32)shadersToReload.size();
+	s_Stats.NumReloads++;
+	s_Stats.NumReloadedShaders		+= numReloadedShaders;
+	s_Stats.LastNumReloadedShaders	= numReloadedShaders;
+	s_Stats.LastCompileTimeMS		= compileTimeMS;
+	s_Stats.LastLatencyMS			= std::chrono::duration<float, std::milli>(std::filesystem::file_time_type::clock::now() - firstChangeTime).count();
+	LOG_INFO("Reloaded {} of {} shaders in {:.1f} ms, {:.1f} ms after the file was saved.", numReloadedShaders, numShaders,
+		s_Stats.LastCompileTimeMS, s_Stats.LastLatencyMS);
+}
+
+ShaderHotReloader::Stats ShaderHotReloader::GetStats()
+{
+	std::lock_guard<std::mutex> lock(s_Mutex);
+	return s_Stats;
+}
+
+void ShaderHotReloader::AddIncludes(Shader* shader)
+{
+	for (auto& [includerPath, includes] : shader->GetIncludes())
+	{
+		s_IncludeGraph.AddIncludes(includerPath, includes);
 
-		s_ShouldUpdate = false;
+		// Watching a file twice is ignored by the file watcher.
+		for (auto& include : includes)
+			s_fileWatcher.AddFile(include);
 	}
 }
@@ -1,26 +1,52 @@
 #pragma once
 
 #include "Renderer/Shader.h"
+#include "Renderer/ShaderIncludeGraph.h"
 #include "Utils/FileWatcher.h"
 
+#include <filesystem>
 #include <mutex>
 
 namespace RS
 {
+	/*
+	* Reloads shaders when one of their files, or a file they include, is modified.
+	* Only the shaders which depend on a modified file, directly or through other includes, are reloaded.
+	*/
 	class ShaderHotReloader
 	{
+	public:
+		struct Stats
+		{
+			uint32	NumReloads				= 0; // Number of times any shader was reloaded.
+			uint32	NumReloadedShaders		= 0;
+			uint32	LastNumReloadedShaders	= 0;
+			float	LastCompileTimeMS		= 0.f; // Time it took to reload the shaders the last time.
+			float	LastLatencyMS			= 0.f; // Time from when the first modified file was saved until the new shaders were in use.
+		};
+
 	public:
 		static void Init();
 		static void Release();
 
 		static void AddShader(Shader* shader);
+		static void RemoveShader(Shader* shader);
 
 		static void Update();
 
+		static Stats GetStats();
+
+	private:
+		// s_Mutex needs to be locked.
+		static void AddIncludes(Shader* shader);
+
 	private:
 		static FileWatcher								s_fileWatcher;
 		static std::vector<std::pair<Shader*, bool>>	s_Shaders;
+		static ShaderIncludeGraph						s_IncludeGraph;
 		static std::mutex								s_Mutex;
 		static bool										s_ShouldUpdate;
+		static std::filesystem::file_time_type			s_FirstChangeTime;
+		static Stats									s_Stats;
 	};
-}
\ No newline at end of file
+}
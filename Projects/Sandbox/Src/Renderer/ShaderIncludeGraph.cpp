@@ -0,0 +1,92 @@
+#include "PreCompiled.h"
+#include "ShaderIncludeGraph.h"
+
+#include <filesystem>
+
+using namespace RS;
+
+void ShaderIncludeGraph::AddIncludes(const std::string& filePath, const std::vector<std::string>& includes)
+{
+	std::string file = NormalizePath(filePath);
+	std::unordered_set<std::string>& fileIncludes = m_Includes[file];
+	for (const std::string& includePath : includes)
+	{
+		std::string include = NormalizePath(includePath);
+		fileIncludes.insert(include);
+		m_IncludedBy[include].insert(file);
+	}
+}
+
+void ShaderIncludeGraph::GetDependents(const std::vector<std::string>& changedFiles, std::unordered_set<std::string>& outFiles) const
+{
+	// Walk the reverse edges, the visited set also stops include cycles.
+	std::vector<std::string> stack;
+	for (const std::string& changedFile : changedFiles)
+	{
+		std::string file = NormalizePath(changedFile);
+		if (outFiles.insert(file).second)
+			stack.push_back(file);
+	}
+
+	while (!stack.empty())
+	{
+		std::string file = stack.back();
+		stack.pop_back();
+
+		auto it = m_IncludedBy.find(file);
+		if (it == m_IncludedBy.end())
+			continue;
+
+		for (const std::string& includer : it->second)
+		{
+			if (outFiles.insert(includer).second)
+				stack.push_back(includer);
+		}
+	}
+}
+
+std::vector<std::string> ShaderIncludeGraph::GetIncludedFiles() const
+{
+	std::vector<std::string> files;
+	files.reserve(m_IncludedBy.size());
+	for (auto& [file, includers] : m_IncludedBy)
+		files.push_back(file);
+	return files;
+}
+
+uint32 ShaderIncludeGraph::GetNumFiles() const
+{
+	std::unordered_set<std::string> files;
+	for (auto& [file, includes] : m_Includes)
+		files.insert(file);
+	for (auto& [file, includers] : m_IncludedBy)
+		files.insert(file);
+	return (uint32)files.size();
+}
+
+void ShaderIncludeGraph::Clear()
+{
+	m_Includes.clear();
+	m_IncludedBy.clear();
+}
+
+std::string ShaderIncludeGraph::NormalizePath(const std::string& path)
+{
+	return std::filesystem::path(path).lexically_normal().generic_string();
+}
+
+std::string ShaderIncludeGraph::ResolveInclude(const std::string& includerPath, const std::string& includeName, bool isSystem, const std::string& shaderFolder,
+	const std::function<bool(const std::string&)>& fileExists)
+{
+	if (!isSystem)
+	{
+		std::string localPath = NormalizePath((std::filesystem::path(includerPath).parent_path() / includeName).generic_string());
+		if (fileExists(localPath))
+			return localPath;
+	}
+
+	std::string folderPath = NormalizePath((std::filesystem::path(shaderFolder) / includeName).generic_string());
+	if (fileExists(folderPath))
+		return folderPath;
+	return "";
+}
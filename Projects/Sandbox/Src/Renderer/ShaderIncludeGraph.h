@@ -0,0 +1,52 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace RS
+{
+	/*
+	* Keeps track of which shader files include which, across all shaders, such that a changed file can be mapped to every file which depends on it.
+	* It does not depend on D3D, the includes are reported by the ShaderIncludeHandler when a shader is compiled.
+	* All paths are normalized with NormalizePath.
+	*/
+	class ShaderIncludeGraph
+	{
+	public:
+		/*
+		* Add the files which filePath includes directly.
+		* Includes are only added, one which was removed stays until Clear is called. At worst this reloads a shader which did not need it.
+		*/
+		void AddIncludes(const std::string& filePath, const std::vector<std::string>& includes);
+
+		/*
+		* Fill outFiles with the changed files and every file which includes any of them, directly or through other files.
+		*/
+		void GetDependents(const std::vector<std::string>& changedFiles, std::unordered_set<std::string>& outFiles) const;
+
+		/*
+		* All files which are included by another file.
+		*/
+		std::vector<std::string> GetIncludedFiles() const;
+
+		uint32 GetNumFiles() const;
+		void Clear();
+
+		static std::string NormalizePath(const std::string& path);
+
+		/*
+		* Find the file an #include directive refers to.
+		* A local include ("file") is first searched for relative to the including file and then relative to the shader folder. A system include (<file>) is only searched for in the shader folder.
+		* Returns an empty string if no file was found.
+		*/
+		static std::string ResolveInclude(const std::string& includerPath, const std::string& includeName, bool isSystem, const std::string& shaderFolder,
+			const std::function<bool(const std::string&)>& fileExists);
+
+	private:
+		std::unordered_map<std::string, std::unordered_set<std::string>> m_Includes;	// File -> The files it includes.
+		std::unordered_map<std::string, std::unordered_set<std::string>> m_IncludedBy;	// File -> The files which include it.
+	};
+}
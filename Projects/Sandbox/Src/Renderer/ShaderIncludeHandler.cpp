@@ -0,0 +1,77 @@
+#include "PreCompiled.h"
+#include "ShaderIncludeHandler.h"
+
+#include "Renderer/ShaderIncludeGraph.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+using namespace RS;
+
+ShaderIncludeHandler::ShaderIncludeHandler(const std::string& rootFilePath) : m_RootFilePath(ShaderIncludeGraph::NormalizePath(rootFilePath))
+{
+}
+
+HRESULT __stdcall ShaderIncludeHandler::Open(D3D_INCLUDE_TYPE includeType, LPCSTR pFileName, LPCVOID pParentData, LPCVOID* ppData, UINT* pBytes)
+{
+	// Includes in the root file have no parent data.
+	std::string includerPath = m_RootFilePath;
+	auto parentIt = m_OpenFiles.find(pParentData);
+	if (pParentData != nullptr && parentIt != m_OpenFiles.end())
+		includerPath = parentIt->second->Path;
+
+	auto FileExists = [](const std::string& path)
+	{
+		std::error_code error;
+		return std::filesystem::is_regular_file(path, error);
+	};
+	std::string path = ShaderIncludeGraph::ResolveInclude(includerPath, pFileName, includeType == D3D_INCLUDE_SYSTEM, RS_SHADER_PATH, FileExists);
+	if (path.empty())
+	{
+		LOG_ERROR("Failed to find include {} in {}!", pFileName, includerPath.c_str());
+		return E_FAIL;
+	}
+
+	// Record the include before reading it, such that a file which fails to compile is still reloaded when it is fixed.
+	std::vector<std::string>& includes = m_Includes[includerPath];
+	if (std::find(includes.begin(), includes.end(), path) == includes.end())
+		includes.push_back(path);
+
+	auto pFile = std::make_unique<OpenFile>();
+	pFile->Path = path;
+	if (!ReadFile(path, pFile->Source))
+	{
+		LOG_ERROR("Failed to read include {}!", path.c_str());
+		return E_FAIL;
+	}
+
+	*ppData = pFile->Source.data();
+	*pBytes = (UINT)pFile->Source.size();
+	m_OpenFiles[*ppData] = std::move(pFile);
+	return S_OK;
+}
+
+HRESULT __stdcall ShaderIncludeHandler::Close(LPCVOID pData)
+{
+	m_OpenFiles.erase(pData);
+	return S_OK;
+}
+
+const std::unordered_map<std::string, std::vector<std::string>>& ShaderIncludeHandler::GetIncludes() const
+{
+	return m_Includes;
+}
+
+bool ShaderIncludeHandler::ReadFile(const std::string& filePath, std::string& outSource)
+{
+	std::ifstream file(filePath, std::ios::binary);
+	if (!file.is_open())
+		return false;
+
+	std::stringstream stream;
+	stream << file.rdbuf();
+	outSource = stream.str();
+	return true;
+}
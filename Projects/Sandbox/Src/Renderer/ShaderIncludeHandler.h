@@ -0,0 +1,43 @@
+#pragma once
+
+#include "Renderer/RenderAPI.h"
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace RS
+{
+	/*
+	* Resolves the #include directives of a shader while it is compiled, and records which file included which.
+	* Includes are searched for relative to the including file and then relative to RS_SHADER_PATH, see ShaderIncludeGraph::ResolveInclude.
+	*/
+	class ShaderIncludeHandler : public ID3DInclude
+	{
+	public:
+		ShaderIncludeHandler(const std::string& rootFilePath);
+
+		HRESULT __stdcall Open(D3D_INCLUDE_TYPE includeType, LPCSTR pFileName, LPCVOID pParentData, LPCVOID* ppData, UINT* pBytes) override;
+		HRESULT __stdcall Close(LPCVOID pData) override;
+
+		/*
+		* The files each file included directly, the key is the including file. The paths are normalized.
+		*/
+		const std::unordered_map<std::string, std::vector<std::string>>& GetIncludes() const;
+
+		static bool ReadFile(const std::string& filePath, std::string& outSource);
+
+	private:
+		struct OpenFile
+		{
+			std::string	Path	= "";
+			std::string	Source	= "";
+		};
+
+	private:
+		std::string												m_RootFilePath;
+		std::unordered_map<const void*, std::unique_ptr<OpenFile>>	m_OpenFiles; // Key is the data given to the compiler, which is passed back as the parent data.
+		std::unordered_map<std::string, std::vector<std::string>>	m_Includes;
+	};
+}
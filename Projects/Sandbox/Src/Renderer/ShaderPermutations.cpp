@@ -0,0 +1,178 @@
+#include "PreCompiled.h"
+#include "ShaderPermutations.h"
+
+#include "Renderer/ShaderBatch.h"
+#include "Renderer/ShaderHotReloader.h"
+#include "Utils/Timer.h"
+
+using namespace RS;
+
+void ShaderPermutations::Init(const Shader::Descriptor& descriptor, const AttributeLayout& layout, const std::vector<std::string>& keywords, uint32 maxVariants)
+{
+	RS_ASSERT(keywords.size() <= MAX_KEYWORDS, "A shader can have at most {} keywords, got {}!", MAX_KEYWORDS, (uint32)keywords.size());
+
+	m_Descriptor	= descriptor;
+	m_Layout		= layout;
+	m_Keywords		= keywords;
+	m_Keywords.resize(std::min((uint32)keywords.size(), MAX_KEYWORDS));
+	m_ValidMask		= (ShaderKeywordMask)((1u << m_Keywords.size()) - 1);
+	m_MaxVariants	= maxVariants;
+	m_Stats			= Stats();
+	m_Variants.clear();
+	m_Variants.resize((size_t)1 << m_Keywords.size());
+}
+
+void ShaderPermutations::Release()
+{
+	for (Variant& variant : m_Variants)
+	{
+		if (!variant.pShader)
+			continue;
+		ShaderHotReloader::RemoveShader(variant.pShader.get());
+		variant.pShader->Release();
+	}
+
+	if (m_Stats.NumVariants > 0 || m_Stats.NumFailed > 0)
+	{
+		LOG_INFO("Shader permutations of {}: {} variants compiled in {:.1f} ms, {} failed, {} rejected by the limit of {}.",
+			m_Descriptor.Fragment.c_str(), m_Stats.NumVariants, m_Stats.CompileTimeMS, m_Stats.NumFailed, m_Stats.NumRejected, m_MaxVariants);
+	}
+	m_Variants.clear();
+}
+
+Shader* ShaderPermutations::GetVariant(ShaderKeywordMask mask)
+{
+	mask &= m_ValidMask;
+	if (mask >= (ShaderKeywordMask)m_Variants.size())
+		return nullptr;
+
+	Variant& variant = m_Variants[mask];
+	if (variant.State == VariantState::COMPILED)
+		return variant.pShader.get();
+	if (variant.State == VariantState::FAILED || !CanCompile(mask))
+		return nullptr;
+
+	Timer timer;
+	timer.Start();
+	variant.pShader = std::make_unique<Shader>();
+	bool succeeded = variant.pShader->Load(GetVariantDescriptor(mask), m_Layout);
+	float timeMS = timer.Stop().GetDeltaTimeMS();
+	m_Stats.CompileTimeMS += timeMS;
+
+	if (!succeeded)
+	{
+		// Failed variants are not tried again, such that a broken shader does not compile every frame.
+		variant.State = VariantState::FAILED;
+		variant.pShader.reset();
+		m_Stats.NumFailed++;
+		return nullptr;
+	}
+
+	LOG_INFO("Compiled shader variant [{}] in {:.1f} ms.", GetKeywordString(mask).c_str(), timeMS);
+	variant.State = VariantState::COMPILED;
+	m_Stats.NumVariants++;
+	ShaderHotReloader::AddShader(variant.pShader.get());
+	return variant.pShader.get();
+}
+
+void ShaderPermutations::Precompile(const std::vector<ShaderKeywordMask>& masks)
+{
+	Timer timer;
+	timer.Start();
+
+	ShaderBatch batch;
+	std::vector<ShaderKeywordMask> batchMasks;
+	for (ShaderKeywordMask mask : masks)
+	{
+		mask &= m_ValidMask;
+		Variant& variant = m_Variants[mask];
+		if (variant.State != VariantState::NOT_COMPILED || variant.pShader || !CanCompile(mask))
+			continue;
+
+		variant.pShader = std::make_unique<Shader>();
+		batch.Add(variant.pShader.get(), GetVariantDescriptor(mask), m_Layout);
+		batchMasks.push_back(mask);
+	}
+
+	if (batchMasks.empty())
+		return;
+
+	batch.Load();
+	for (ShaderKeywordMask mask : batchMasks)
+	{
+		// A shader which failed to load has no files.
+		Variant& variant = m_Variants[mask];
+		if (variant.pShader->GetFiles().empty())
+		{
+			variant.State = VariantState::FAILED;
+			variant.pShader.reset();
+			m_Stats.NumFailed++;
+			continue;
+		}
+
+		variant.State = VariantState::COMPILED;
+		m_Stats.NumVariants++;
+		ShaderHotReloader::AddShader(variant.pShader.get());
+	}
+	m_Stats.CompileTimeMS += timer.Stop().GetDeltaTimeMS();
+}
+
+ShaderKeywordMask ShaderPermutations::GetKeywordMask(const std::string& keyword) const
+{
+	for (uint32 i = 0; i < (uint32)m_Keywords.size(); i++)
+	{
+		if (m_Keywords[i] == keyword)
+			return (ShaderKeywordMask)FLAG(i);
+	}
+	LOG_WARNING("Shader keyword {} does not exist!", keyword.c_str());
+	return 0;
+}
+
+std::string ShaderPermutations::GetKeywordString(ShaderKeywordMask mask) const
+{
+	std::string str;
+	for (uint32 i = 0; i < (uint32)m_Keywords.size(); i++)
+	{
+		if ((mask & FLAG(i)) == 0)
+			continue;
+		if (!str.empty())
+			str += " ";
+		str += m_Keywords[i];
+	}
+	return str;
+}
+
+const ShaderPermutations::Stats& ShaderPermutations::GetStats() const
+{
+	return m_Stats;
+}
+
+Shader::Descriptor ShaderPermutations::GetVariantDescriptor(ShaderKeywordMask mask) const
+{
+	Shader::Descriptor descriptor = m_Descriptor;
+	for (uint32 i = 0; i < (uint32)m_Keywords.size(); i++)
+	{
+		if (mask & FLAG(i))
+			descriptor.Defines.emplace_back(m_Keywords[i], "1");
+	}
+	return descriptor;
+}
+
+bool ShaderPermutations::CanCompile(ShaderKeywordMask mask)
+{
+	uint32 numPending = 0;
+	for (Variant& variant : m_Variants)
+		numPending += (variant.State == VariantState::NOT_COMPILED && variant.pShader) ? 1 : 0;
+
+	if (m_Stats.NumVariants + m_Stats.NumFailed + numPending < m_MaxVariants)
+		return true;
+
+	// Only warn once for each variant.
+	if (m_Variants[mask].State == VariantState::NOT_COMPILED)
+	{
+		LOG_WARNING("Reached the limit of {} shader variants, [{}] will not be compiled!", m_MaxVariants, GetKeywordString(mask).c_str());
+		m_Variants[mask].State = VariantState::FAILED;
+	}
+	m_Stats.NumRejected++;
+	return false;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "Renderer/Shader.h"
+
+#include <memory>
+
+namespace RS
+{
+	using ShaderKeywordMask = uint32;
+
+	/*
+	* A shader which is compiled once for each combination of keywords it is used with, instead of branching on them at runtime.
+	* Keyword i is bit i of the mask, and is defined to 1 in the variants which have the bit set.
+	* Variants are compiled the first time they are asked for, or up front with Precompile. They are stored in a table indexed by the mask.
+	*/
+	class ShaderPermutations
+	{
+	public:
+		static const uint32 MAX_KEYWORDS = 12; // The table has 2^NumKeywords entries.
+
+		struct Stats
+		{
+			uint32	NumVariants		= 0; // Number of variants which have been compiled.
+			uint32	NumFailed		= 0;
+			uint32	NumRejected		= 0; // Number of requests for a new variant after the limit was reached.
+			float	CompileTimeMS	= 0.f;
+		};
+
+	public:
+		RS_DEFAULT_CLASS(ShaderPermutations);
+
+		/*
+		* The paths in the descriptor are relative to RS_SHADER_PATH, like in Shader::Load.
+		* maxVariants: No more variants than this are compiled, GetVariant returns nullptr for a new mask after that.
+		*/
+		void Init(const Shader::Descriptor& descriptor, const AttributeLayout& layout, const std::vector<std::string>& keywords, uint32 maxVariants = 64);
+		void Release();
+
+		/*
+		* Return the variant of the mask, it is compiled if it has not been used before.
+		* Returns nullptr if it failed to compile or the variant limit has been reached.
+		*/
+		Shader* GetVariant(ShaderKeywordMask mask);
+
+		/*
+		* Compile many variants at once with a ShaderBatch, such that they do not stall the first frame they are used in.
+		*/
+		void Precompile(const std::vector<ShaderKeywordMask>& masks);
+
+		ShaderKeywordMask GetKeywordMask(const std::string& keyword) const;
+		std::string GetKeywordString(ShaderKeywordMask mask) const;
+
+		const Stats& GetStats() const;
+
+	private:
+		enum class VariantState : uint8
+		{
+			NOT_COMPILED = 0,
+			COMPILED,
+			FAILED
+		};
+
+		struct Variant
+		{
+			VariantState			State	= VariantState::NOT_COMPILED;
+			std::unique_ptr<Shader>	pShader;
+		};
+
+		Shader::Descriptor GetVariantDescriptor(ShaderKeywordMask mask) const;
+		bool CanCompile(ShaderKeywordMask mask);
+
+	private:
+		Shader::Descriptor			m_Descriptor;
+		AttributeLayout				m_Layout;
+		std::vector<std::string>	m_Keywords;
+		std::vector<Variant>		m_Variants;
+		ShaderKeywordMask			m_ValidMask		= 0;
+		uint32						m_MaxVariants	= 0;
+		Stats						m_Stats;
+	};
+}
@@ -0,0 +1,125 @@
+#include "PreCompiled.h"
+#include "ShadowCascades.h"
+
+#include <algorithm>
+
+using namespace RS;
+
+void ShadowCascades::Init(uint32 numCascades, uint32 resolution, float splitLambda, float shadowDistance)
+{
+	m_NumCascades		= std::clamp(numCascades, 1u, MAX_CASCADES);
+	m_Resolution		= std::max(resolution, 1u);
+	m_SplitLambda		= glm::clamp(splitLambda, 0.f, 1.f);
+	m_ShadowDistance	= shadowDistance;
+}
+
+void ShadowCascades::Update(const glm::mat4& view, const glm::mat4& proj, float nearPlane, float farPlane, const glm::vec3& lightDir)
+{
+	float splits[MAX_CASCADES + 1];
+	float shadowFar = m_ShadowDistance > nearPlane ? std::min(m_ShadowDistance, farPlane) : farPlane;
+	ComputeSplits(nearPlane, shadowFar, m_NumCascades, m_SplitLambda, splits);
+
+	// The projection of Camera is symmetric, so the half angles can be read from its scale.
+	const float tanHalfFovX = 1.f / proj[0][0];
+	const float tanHalfFovY = 1.f / proj[1][1];
+	const glm::mat4 invView = glm::inverse(view);
+	const glm::vec3 direction = glm::normalize(lightDir);
+	for (uint32 i = 0; i < m_NumCascades; i++)
+	{
+		Cascade& cascade = m_Cascades[i];
+		cascade.NearSplit	= splits[i];
+		cascade.FarSplit	= splits[i + 1];
+		FitCascade(cascade, invView, tanHalfFovX, tanHalfFovY, direction);
+	}
+}
+
+void ShadowCascades::CullCasters(const std::vector<AABB>& casterBounds)
+{
+	for (uint32 i = 0; i < m_NumCascades; i++)
+	{
+		Cascade& cascade = m_Cascades[i];
+		cascade.Casters.clear();
+		for (uint32 caster = 0; caster < (uint32)casterBounds.size(); caster++)
+		{
+			if (IsInCascade(cascade, casterBounds[caster]))
+				cascade.Casters.push_back(caster);
+		}
+		cascade.NumCulled = (uint32)(casterBounds.size() - cascade.Casters.size());
+	}
+}
+
+void ShadowCascades::ComputeSplits(float nearPlane, float farPlane, uint32 numCascades, float lambda, float* pOutSplits)
+{
+	pOutSplits[0] = nearPlane;
+	for (uint32 i = 1; i < numCascades; i++)
+	{
+		float t = (float)i / (float)numCascades;
+		float logSplit = nearPlane * glm::pow(farPlane / nearPlane, t);
+		float uniformSplit = nearPlane + (farPlane - nearPlane) * t;
+		pOutSplits[i] = glm::mix(uniformSplit, logSplit, lambda);
+	}
+	pOutSplits[numCascades] = farPlane;
+}
+
+glm::vec4 ShadowCascades::ComputeBoundingSphere(float tanHalfFovX, float tanHalfFovY, float nearSplit, float farSplit)
+{
+	// The corners at depth d are d * k from the view axis. The center on the axis which is as far from the near corners as from the far corners is at depth (n + f)(1 + k^2) / 2.
+	float kSq = tanHalfFovX * tanHalfFovX + tanHalfFovY * tanHalfFovY;
+	float centerDepth = 0.5f * (nearSplit + farSplit) * (1.f + kSq);
+	if (centerDepth >= farSplit)
+		return glm::vec4(0.f, 0.f, -farSplit, farSplit * glm::sqrt(kSq)); // A wide frustum, the sphere around the far corners holds the near ones as well.
+
+	float nearDist = centerDepth - nearSplit;
+	return glm::vec4(0.f, 0.f, -centerDepth, glm::sqrt(nearDist * nearDist + nearSplit * nearSplit * kSq));
+}
+
+bool ShadowCascades::IsInCascade(const Cascade& cascade, const AABB& bounds)
+{
+	AABB lightBounds = AABB::Transform(bounds, cascade.View);
+
+	// The light looks down -z from the near plane at zero, the receivers are inside the sphere which ends at -2r.
+	float radius = cascade.BoundingSphere.w;
+	if (lightBounds.max.x < -radius || lightBounds.min.x > radius)
+		return false;
+	if (lightBounds.max.y < -radius || lightBounds.min.y > radius)
+		return false;
+	return lightBounds.max.z >= -2.f * radius;
+}
+
+uint32 ShadowCascades::GetNumCascades() const
+{
+	return m_NumCascades;
+}
+
+uint32 ShadowCascades::GetResolution() const
+{
+	return m_Resolution;
+}
+
+const ShadowCascades::Cascade& ShadowCascades::GetCascade(uint32 index) const
+{
+	return m_Cascades[index];
+}
+
+void ShadowCascades::FitCascade(Cascade& cascade, const glm::mat4& invView, float tanHalfFovX, float tanHalfFovY, const glm::vec3& lightDir)
+{
+	glm::vec4 sphere = ComputeBoundingSphere(tanHalfFovX, tanHalfFovY, cascade.NearSplit, cascade.FarSplit);
+	glm::vec3 center = glm::vec3(invView * glm::vec4(glm::vec3(sphere), 1.f));
+
+	// Round the radius up, such that float errors do not change the size of the texels from frame to frame.
+	float radius = glm::ceil(sphere.w * 16.f) / 16.f;
+	cascade.BoundingSphere = glm::vec4(center, radius);
+
+	glm::vec3 up = glm::abs(lightDir.y) > 0.99f ? glm::vec3(0.f, 0.f, 1.f) : glm::vec3(0.f, 1.f, 0.f);
+	cascade.View = glm::lookAtRH(center - lightDir * radius, center, up);
+	cascade.Proj = glm::orthoRH(-radius, radius, -radius, radius, 0.f, 2.f * radius);
+
+	// Move the projection such that the world origin lands on a whole texel, then every point keeps its place within its texel when the camera moves.
+	glm::mat4 viewProj = cascade.Proj * cascade.View;
+	float halfResolution = (float)m_Resolution * 0.5f;
+	glm::vec2 origin = glm::vec2(viewProj * glm::vec4(0.f, 0.f, 0.f, 1.f)) * halfResolution;
+	glm::vec2 offset = (glm::round(origin) - origin) / halfResolution;
+	cascade.Proj[3][0] += offset.x;
+	cascade.Proj[3][1] += offset.y;
+	cascade.ViewProj = cascade.Proj * cascade.View;
+}
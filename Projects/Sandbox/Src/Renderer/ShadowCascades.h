@@ -0,0 +1,87 @@
+#pragma once
+
+#include "Structures/AABB.h"
+#include "Utils/Maths.h"
+
+#include <vector>
+
+namespace RS
+{
+	/*
+	* The CPU side of cascaded shadow maps for a directional light, it does not use the device.
+	*	- The view frustum is split with the practical split scheme, a blend between logarithmic and uniform splits.
+	*	- Each cascade is fitted to the bounding sphere of its part of the frustum. The sphere does not change when the camera rotates,
+	*	  and the projection is snapped to whole shadow map texels, so the shadows do not shimmer when the camera moves.
+	*	- The shadow casters, given as world space AABBs, are culled against each cascade.
+	* Example:
+	*	cascades.Init(4, 2048, 0.75f, 30.f);
+	*	cascades.Update(camera.GetView(), camera.GetProj(), camera.GetNearPlane(), camera.GetFarPlane(), lightDir);
+	*	cascades.CullCasters(casterBounds);
+	*	for (uint32 caster : cascades.GetCascade(0).Casters) ...
+	*/
+	class ShadowCascades
+	{
+	public:
+		static const uint32 MAX_CASCADES = 4;
+
+		struct Cascade
+		{
+			float					NearSplit		= 0.f; // View depth where the cascade starts.
+			float					FarSplit		= 0.f;
+			glm::vec4				BoundingSphere	= glm::vec4(0.f); // World space, w is the radius.
+			glm::mat4				View			= glm::mat4(1.f);
+			glm::mat4				Proj			= glm::mat4(1.f);
+			glm::mat4				ViewProj		= glm::mat4(1.f);
+			std::vector<uint32>		Casters; // Index of the casters which are inside the cascade.
+			uint32					NumCulled		= 0;
+		};
+
+	public:
+		RS_DEFAULT_CLASS(ShadowCascades);
+
+		/*
+		* splitLambda: 0 gives uniform splits and 1 logarithmic splits.
+		* shadowDistance: The cascades end at this view depth, or at the far plane of the camera if it is closer.
+		*/
+		void Init(uint32 numCascades, uint32 resolution, float splitLambda, float shadowDistance);
+
+		/*
+		* Fit the cascades to the camera, the matrices are the ones of Camera (right-handed and looking down -z).
+		* lightDir: The direction the light travels in, from the light towards the scene.
+		*/
+		void Update(const glm::mat4& view, const glm::mat4& proj, float nearPlane, float farPlane, const glm::vec3& lightDir);
+
+		/*
+		* Find the casters of each cascade, the bounds are in world space.
+		* Casters between the light and a cascade are kept, they are flattened onto the near plane when rendered without depth clipping.
+		*/
+		void CullCasters(const std::vector<AABB>& casterBounds);
+
+		/*
+		* pOutSplits gets numCascades + 1 view depths, from the near plane to the far plane.
+		*/
+		static void ComputeSplits(float nearPlane, float farPlane, uint32 numCascades, float lambda, float* pOutSplits);
+
+		/*
+		* The smallest sphere around the part of a symmetric frustum between two view depths, in view space.
+		* tanHalfFovX, tanHalfFovY: The tangents of the half angles of the frustum.
+		*/
+		static glm::vec4 ComputeBoundingSphere(float tanHalfFovX, float tanHalfFovY, float nearSplit, float farSplit);
+
+		static bool IsInCascade(const Cascade& cascade, const AABB& bounds);
+
+		uint32 GetNumCascades() const;
+		uint32 GetResolution() const;
+		const Cascade& GetCascade(uint32 index) const;
+
+	private:
+		void FitCascade(Cascade& cascade, const glm::mat4& invView, float tanHalfFovX, float tanHalfFovY, const glm::vec3& lightDir);
+
+	private:
+		uint32		m_NumCascades		= 0;
+		uint32		m_Resolution		= 0;
+		float		m_SplitLambda		= 0.f;
+		float		m_ShadowDistance	= 0.f;
+		Cascade		m_Cascades[MAX_CASCADES];
+	};
+}
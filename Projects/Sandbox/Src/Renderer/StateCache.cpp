@@ -0,0 +1,489 @@
+#include "PreCompiled.h"
+#include "StateCache.h"
+
+#include <cstring>
+
+using namespace RS;
+
+namespace
+{
+	// A pointer which is never bound, it is used for the state which is not known after Invalidate.
+	template<typename T>
+	T* GetUnknown()
+	{
+		return reinterpret_cast<T*>(~(uintptr_t)0);
+	}
+
+	uint32 GetStageIndex(ShaderTypeFlag stage)
+	{
+		switch (stage)
+		{
+		case ShaderTypeFlag::VERTEX:		return 0;
+		case ShaderTypeFlag::FRAGMENT:		return 1;
+		case ShaderTypeFlag::GEOMETRY:		return 2;
+		case ShaderTypeFlag::COMPUTE:		return 3;
+		case ShaderTypeFlag::TESS_HULL:		return 4;
+		case ShaderTypeFlag::TESS_DOMAIN:	return 5;
+		default:
+			RS_ASSERT(false, "Shader [{}] type not supported by the state cache!", (uint32)stage);
+			return 0;
+		}
+	}
+}
+
+template<typename T, uint32 Size>
+void StateCache::SetSlots(SlotArray<T, Size>& slots, uint32 startSlot, uint32 count, T* const* ppResources)
+{
+	if (count == 0)
+		return;
+	RS_ASSERT(startSlot + count <= Size, "Slots [{}, {}) are out of range, there are {} slots!", startSlot, startSlot + count, Size);
+
+	m_CurrentStats.NumRequested++;
+	m_TotalStats.NumRequested++;
+
+	for (uint32 i = 0; i < count; i++)
+	{
+		slots.Pending[startSlot + i]	= ppResources[i];
+		slots.Dirty[startSlot + i]		= true;
+	}
+	slots.DirtyBegin	= std::min(slots.DirtyBegin, startSlot);
+	slots.DirtyEnd		= std::max(slots.DirtyEnd, startSlot + count);
+	slots.NumSets++;
+
+	if (!m_Filter)
+		FlushBindings();
+}
+
+template<typename T, uint32 Size, typename Func>
+void StateCache::FlushSlots(SlotArray<T, Size>& slots, Func setFunc)
+{
+	if (slots.DirtyBegin >= slots.DirtyEnd)
+		return;
+
+	// Bind runs of changed slots. A slot which was not changed can be part of a run if it is known to hold the same resource, since binding it again does nothing.
+	uint32 numCalls = 0;
+	uint32 runBegin = Size;
+	uint32 runEnd = 0;
+	auto BindRun = [&]()
+	{
+		if (runBegin < runEnd)
+		{
+			setFunc(runBegin, runEnd - runBegin, &slots.Pending[runBegin]);
+			for (uint32 i = runBegin; i < runEnd; i++)
+				slots.Bound[i] = slots.Pending[i];
+			numCalls++;
+		}
+		runBegin = Size;
+		runEnd = 0;
+	};
+
+	for (uint32 i = slots.DirtyBegin; i < slots.DirtyEnd; i++)
+	{
+		bool same = slots.Bound[i] == slots.Pending[i];
+		bool changed = slots.Dirty[i] && (!m_Filter || !same);
+		if (changed)
+		{
+			runBegin = std::min(runBegin, i);
+			runEnd = i + 1;
+		}
+		else if (!same)
+		{
+			BindRun();
+		}
+		slots.Dirty[i] = false;
+	}
+	BindRun();
+
+	AddIssued(numCalls);
+	if (numCalls == 0)
+	{
+		AddFiltered(slots.NumSets);
+	}
+	else
+	{
+		m_CurrentStats.NumCoalesced += slots.NumSets - numCalls;
+		m_TotalStats.NumCoalesced += slots.NumSets - numCalls;
+	}
+
+	slots.DirtyBegin	= Size;
+	slots.DirtyEnd		= 0;
+	slots.NumSets		= 0;
+}
+
+template<typename T, uint32 Size>
+void StateCache::InvalidateSlots(SlotArray<T, Size>& slots)
+{
+	for (uint32 i = 0; i < Size; i++)
+		slots.Bound[i] = GetUnknown<T>();
+}
+
+template<typename T>
+bool StateCache::ShouldSet(T& current, const T& value)
+{
+	m_CurrentStats.NumRequested++;
+	m_TotalStats.NumRequested++;
+	if (m_Filter && current == value)
+	{
+		AddFiltered(1);
+		return false;
+	}
+
+	current = value;
+	AddIssued(1);
+	return true;
+}
+
+std::shared_ptr<StateCache> StateCache::Get()
+{
+	static std::shared_ptr<StateCache> s_StateCache = std::make_shared<StateCache>();
+	return s_StateCache;
+}
+
+void StateCache::Init(ID3D11DeviceContext* pContext, bool filter)
+{
+	m_pContext	= pContext;
+	m_Filter	= filter;
+	Invalidate();
+}
+
+void StateCache::Release()
+{
+	if (m_TotalStats.NumRequested > 0)
+	{
+		LOG_INFO("State cache: {} binds requested, {} calls issued, {} filtered, {} coalesced over {} draws.",
+			m_TotalStats.NumRequested, m_TotalStats.NumIssued, m_TotalStats.NumFiltered, m_TotalStats.NumCoalesced, m_TotalStats.NumDraws);
+	}
+	m_pContext = nullptr;
+}
+
+void StateCache::Invalidate()
+{
+	for (uint32 stage = 0; stage < NUM_STAGES; stage++)
+	{
+		m_Shaders[stage] = GetUnknown<void>();
+		InvalidateSlots(m_ConstantBuffers[stage]);
+		InvalidateSlots(m_ShaderResources[stage]);
+		InvalidateSlots(m_Samplers[stage]);
+	}
+	InvalidateSlots(m_UnorderedAccess);
+
+	m_pInputLayout	= GetUnknown<ID3D11InputLayout>();
+	m_Topology		= (D3D11_PRIMITIVE_TOPOLOGY)-1;
+	m_pIndexBuffer	= GetUnknown<ID3D11Buffer>();
+	for (uint32 i = 0; i < MAX_VERTEX_BUFFERS; i++)
+		m_VertexBuffers[i] = GetUnknown<ID3D11Buffer>();
+
+	m_pRasterizerState		= GetUnknown<ID3D11RasterizerState>();
+	m_Viewport.Width		= -1.f;
+	m_pDepthStencilState	= GetUnknown<ID3D11DepthStencilState>();
+	m_NumRenderTargets		= UINT32_MAX;
+}
+
+void StateCache::NewFrame()
+{
+	m_FrameStats	= m_CurrentStats;
+	m_CurrentStats	= Stats();
+}
+
+void StateCache::SetVertexShader(ID3D11VertexShader* pShader)
+{
+	if (ShouldSet(m_Shaders[0], (void*)pShader))
+		m_pContext->VSSetShader(pShader, nullptr, 0);
+}
+
+void StateCache::SetPixelShader(ID3D11PixelShader* pShader)
+{
+	if (ShouldSet(m_Shaders[1], (void*)pShader))
+		m_pContext->PSSetShader(pShader, nullptr, 0);
+}
+
+void StateCache::SetGeometryShader(ID3D11GeometryShader* pShader)
+{
+	if (ShouldSet(m_Shaders[2], (void*)pShader))
+		m_pContext->GSSetShader(pShader, nullptr, 0);
+}
+
+void StateCache::SetComputeShader(ID3D11ComputeShader* pShader)
+{
+	if (ShouldSet(m_Shaders[3], (void*)pShader))
+		m_pContext->CSSetShader(pShader, nullptr, 0);
+}
+
+void StateCache::SetHullShader(ID3D11HullShader* pShader)
+{
+	if (ShouldSet(m_Shaders[4], (void*)pShader))
+		m_pContext->HSSetShader(pShader, nullptr, 0);
+}
+
+void StateCache::SetDomainShader(ID3D11DomainShader* pShader)
+{
+	if (ShouldSet(m_Shaders[5], (void*)pShader))
+		m_pContext->DSSetShader(pShader, nullptr, 0);
+}
+
+void StateCache::SetInputLayout(ID3D11InputLayout* pLayout)
+{
+	if (ShouldSet(m_pInputLayout, pLayout))
+		m_pContext->IASetInputLayout(pLayout);
+}
+
+void StateCache::SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology)
+{
+	if (ShouldSet(m_Topology, topology))
+		m_pContext->IASetPrimitiveTopology(topology);
+}
+
+void StateCache::SetVertexBuffers(uint32 startSlot, uint32 count, ID3D11Buffer* const* ppBuffers, const UINT* pStrides, const UINT* pOffsets)
+{
+	if (count == 0)
+		return;
+	RS_ASSERT(startSlot + count <= MAX_VERTEX_BUFFERS, "Vertex buffer slots [{}, {}) are out of range!", startSlot, startSlot + count);
+
+	m_CurrentStats.NumRequested++;
+	m_TotalStats.NumRequested++;
+
+	bool changed = !m_Filter;
+	for (uint32 i = 0; i < count && !changed; i++)
+	{
+		uint32 slot = startSlot + i;
+		changed = m_VertexBuffers[slot] != ppBuffers[i] || m_VertexStrides[slot] != pStrides[i] || m_VertexOffsets[slot] != pOffsets[i];
+	}
+
+	if (!changed)
+	{
+		AddFiltered(1);
+		return;
+	}
+
+	for (uint32 i = 0; i < count; i++)
+	{
+		m_VertexBuffers[startSlot + i]	= ppBuffers[i];
+		m_VertexStrides[startSlot + i]	= pStrides[i];
+		m_VertexOffsets[startSlot + i]	= pOffsets[i];
+	}
+	m_pContext->IASetVertexBuffers(startSlot, count, ppBuffers, pStrides, pOffsets);
+	AddIssued(1);
+}
+
+void StateCache::SetIndexBuffer(ID3D11Buffer* pBuffer, DXGI_FORMAT format, uint32 offset)
+{
+	m_CurrentStats.NumRequested++;
+	m_TotalStats.NumRequested++;
+	if (m_Filter && m_pIndexBuffer == pBuffer && m_IndexFormat == format && m_IndexOffset == offset)
+	{
+		AddFiltered(1);
+		return;
+	}
+
+	m_pIndexBuffer	= pBuffer;
+	m_IndexFormat	= format;
+	m_IndexOffset	= offset;
+	m_pContext->IASetIndexBuffer(pBuffer, format, offset);
+	AddIssued(1);
+}
+
+void StateCache::SetConstantBuffers(ShaderTypeFlag stage, uint32 startSlot, uint32 count, ID3D11Buffer* const* ppBuffers)
+{
+	SetSlots(m_ConstantBuffers[GetStageIndex(stage)], startSlot, count, ppBuffers);
+}
+
+void StateCache::SetShaderResources(ShaderTypeFlag stage, uint32 startSlot, uint32 count, ID3D11ShaderResourceView* const* ppViews)
+{
+	SetSlots(m_ShaderResources[GetStageIndex(stage)], startSlot, count, ppViews);
+}
+
+void StateCache::SetSamplers(ShaderTypeFlag stage, uint32 startSlot, uint32 count, ID3D11SamplerState* const* ppSamplers)
+{
+	SetSlots(m_Samplers[GetStageIndex(stage)], startSlot, count, ppSamplers);
+}
+
+void StateCache::SetUnorderedAccessViews(uint32 startSlot, uint32 count, ID3D11UnorderedAccessView* const* ppViews)
+{
+	SetSlots(m_UnorderedAccess, startSlot, count, ppViews);
+}
+
+void StateCache::SetRasterizerState(ID3D11RasterizerState* pState)
+{
+	if (ShouldSet(m_pRasterizerState, pState))
+		m_pContext->RSSetState(pState);
+}
+
+void StateCache::SetViewport(const D3D11_VIEWPORT& viewport)
+{
+	m_CurrentStats.NumRequested++;
+	m_TotalStats.NumRequested++;
+	if (m_Filter && memcmp(&m_Viewport, &viewport, sizeof(D3D11_VIEWPORT)) == 0)
+	{
+		AddFiltered(1);
+		return;
+	}
+
+	m_Viewport = viewport;
+	m_pContext->RSSetViewports(1, &viewport);
+	AddIssued(1);
+}
+
+void StateCache::SetDepthStencilState(ID3D11DepthStencilState* pState, uint32 stencilRef)
+{
+	m_CurrentStats.NumRequested++;
+	m_TotalStats.NumRequested++;
+	if (m_Filter && m_pDepthStencilState == pState && m_StencilRef == stencilRef)
+	{
+		AddFiltered(1);
+		return;
+	}
+
+	m_pDepthStencilState	= pState;
+	m_StencilRef			= stencilRef;
+	m_pContext->OMSetDepthStencilState(pState, stencilRef);
+	AddIssued(1);
+}
+
+void StateCache::SetRenderTargets(uint32 count, ID3D11RenderTargetView* const* ppViews, ID3D11DepthStencilView* pDepthStencilView)
+{
+	RS_ASSERT(count <= MAX_RENDER_TARGETS, "Too many render targets, {} is more than {}!", count, MAX_RENDER_TARGETS);
+
+	m_CurrentStats.NumRequested++;
+	m_TotalStats.NumRequested++;
+
+	bool changed = !m_Filter || m_NumRenderTargets != count || m_pDepthStencilView != pDepthStencilView;
+	for (uint32 i = 0; i < count && !changed; i++)
+		changed = m_RenderTargets[i] != ppViews[i];
+
+	if (!changed)
+	{
+		AddFiltered(1);
+		return;
+	}
+
+	m_NumRenderTargets	= count;
+	m_pDepthStencilView	= pDepthStencilView;
+	for (uint32 i = 0; i < count; i++)
+		m_RenderTargets[i] = ppViews[i];
+	m_pContext->OMSetRenderTargets(count, ppViews, pDepthStencilView);
+	AddIssued(1);
+
+	// The context unbinds the shader resources of a texture which is bound as a render target, the cache cannot tell which those were.
+	for (uint32 stage = 0; stage < NUM_STAGES; stage++)
+		InvalidateSlots(m_ShaderResources[stage]);
+}
+
+void StateCache::FlushBindings()
+{
+	// The unordered access views go first, such that a resource which moves from an unordered access view to a shader resource in the same flush
+	// is unbound as the former before it is bound as the latter, otherwise the context would drop the shader resource.
+	// Binding an unordered access view unbinds the shader resources of the same resource, which the cache cannot tell.
+	bool unorderedAccessChanged = m_UnorderedAccess.DirtyBegin < m_UnorderedAccess.DirtyEnd;
+	FlushSlots(m_UnorderedAccess, [&](UINT s, UINT n, ID3D11UnorderedAccessView* const* p) { m_pContext->CSSetUnorderedAccessViews(s, n, p, nullptr); });
+	if (unorderedAccessChanged)
+		InvalidateSlots(m_ShaderResources[3]);
+
+	for (uint32 stage = 0; stage < NUM_STAGES; stage++)
+	{
+		SlotArray<ID3D11Buffer, MAX_CONSTANT_BUFFERS>& constantBuffers = m_ConstantBuffers[stage];
+		SlotArray<ID3D11ShaderResourceView, MAX_SHADER_RESOURCES>& shaderResources = m_ShaderResources[stage];
+		SlotArray<ID3D11SamplerState, MAX_SAMPLERS>& samplers = m_Samplers[stage];
+		switch (stage)
+		{
+		case 0:
+			FlushSlots(constantBuffers, [&](UINT s, UINT n, ID3D11Buffer* const* p) { m_pContext->VSSetConstantBuffers(s, n, p); });
+			FlushSlots(shaderResources, [&](UINT s, UINT n, ID3D11ShaderResourceView* const* p) { m_pContext->VSSetShaderResources(s, n, p); });
+			FlushSlots(samplers, [&](UINT s, UINT n, ID3D11SamplerState* const* p) { m_pContext->VSSetSamplers(s, n, p); });
+			break;
+		case 1:
+			FlushSlots(constantBuffers, [&](UINT s, UINT n, ID3D11Buffer* const* p) { m_pContext->PSSetConstantBuffers(s, n, p); });
+			FlushSlots(shaderResources, [&](UINT s, UINT n, ID3D11ShaderResourceView* const* p) { m_pContext->PSSetShaderResources(s, n, p); });
+			FlushSlots(samplers, [&](UINT s, UINT n, ID3D11SamplerState* const* p) { m_pContext->PSSetSamplers(s, n, p); });
+			break;
+		case 2:
+			FlushSlots(constantBuffers, [&](UINT s, UINT n, ID3D11Buffer* const* p) { m_pContext->GSSetConstantBuffers(s, n, p); });
+			FlushSlots(shaderResources, [&](UINT s, UINT n, ID3D11ShaderResourceView* const* p) { m_pContext->GSSetShaderResources(s, n, p); });
+			FlushSlots(samplers, [&](UINT s, UINT n, ID3D11SamplerState* const* p) { m_pContext->GSSetSamplers(s, n, p); });
+			break;
+		case 3:
+			FlushSlots(constantBuffers, [&](UINT s, UINT n, ID3D11Buffer* const* p) { m_pContext->CSSetConstantBuffers(s, n, p); });
+			FlushSlots(shaderResources, [&](UINT s, UINT n, ID3D11ShaderResourceView* const* p) { m_pContext->CSSetShaderResources(s, n, p); });
+			FlushSlots(samplers, [&](UINT s, UINT n, ID3D11SamplerState* const* p) { m_pContext->CSSetSamplers(s, n, p); });
+			break;
+		case 4:
+			FlushSlots(constantBuffers, [&](UINT s, UINT n, ID3D11Buffer* const* p) { m_pContext->HSSetConstantBuffers(s, n, p); });
+			FlushSlots(shaderResources, [&](UINT s, UINT n, ID3D11ShaderResourceView* const* p) { m_pContext->HSSetShaderResources(s, n, p); });
+			FlushSlots(samplers, [&](UINT s, UINT n, ID3D11SamplerState* const* p) { m_pContext->HSSetSamplers(s, n, p); });
+			break;
+		case 5:
+			FlushSlots(constantBuffers, [&](UINT s, UINT n, ID3D11Buffer* const* p) { m_pContext->DSSetConstantBuffers(s, n, p); });
+			FlushSlots(shaderResources, [&](UINT s, UINT n, ID3D11ShaderResourceView* const* p) { m_pContext->DSSetShaderResources(s, n, p); });
+			FlushSlots(samplers, [&](UINT s, UINT n, ID3D11SamplerState* const* p) { m_pContext->DSSetSamplers(s, n, p); });
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+void StateCache::Draw(uint32 vertexCount, uint32 startVertex)
+{
+	FlushBindings();
+	m_pContext->Draw(vertexCount, startVertex);
+	m_CurrentStats.NumDraws++;
+	m_TotalStats.NumDraws++;
+}
+
+void StateCache::DrawIndexed(uint32 indexCount, uint32 startIndex, int32 baseVertex)
+{
+	FlushBindings();
+	m_pContext->DrawIndexed(indexCount, startIndex, baseVertex);
+	m_CurrentStats.NumDraws++;
+	m_TotalStats.NumDraws++;
+}
+
+void StateCache::DrawInstanced(uint32 vertexCountPerInstance, uint32 instanceCount, uint32 startVertex, uint32 startInstance)
+{
+	FlushBindings();
+	m_pContext->DrawInstanced(vertexCountPerInstance, instanceCount, startVertex, startInstance);
+	m_CurrentStats.NumDraws++;
+	m_TotalStats.NumDraws++;
+}
+
+void StateCache::DrawIndexedInstanced(uint32 indexCountPerInstance, uint32 instanceCount, uint32 startIndex, int32 baseVertex, uint32 startInstance)
+{
+	FlushBindings();
+	m_pContext->DrawIndexedInstanced(indexCountPerInstance, instanceCount, startIndex, baseVertex, startInstance);
+	m_CurrentStats.NumDraws++;
+	m_TotalStats.NumDraws++;
+}
+
+void StateCache::Dispatch(uint32 x, uint32 y, uint32 z)
+{
+	FlushBindings();
+	m_pContext->Dispatch(x, y, z);
+	m_CurrentStats.NumDraws++;
+	m_TotalStats.NumDraws++;
+}
+
+const StateCache::Stats& StateCache::GetFrameStats() const
+{
+	return m_FrameStats;
+}
+
+const StateCache::Stats& StateCache::GetTotalStats() const
+{
+	return m_TotalStats;
+}
+
+bool StateCache::IsFiltering() const
+{
+	return m_Filter;
+}
+
+void StateCache::AddIssued(uint32 numCalls)
+{
+	m_CurrentStats.NumIssued += numCalls;
+	m_TotalStats.NumIssued += numCalls;
+}
+
+void StateCache::AddFiltered(uint32 numBinds)
+{
+	m_CurrentStats.NumFiltered += numBinds;
+	m_TotalStats.NumFiltered += numBinds;
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+#include "Renderer/RenderAPI.h"
+#include "Renderer/ShaderDefines.h"
+
+namespace RS
+{
+	/*
+	* A shadow copy of the state of the device context, all binds should go through it instead of the context.
+	* Binds which would not change the state are filtered out. The slot bindings (constant buffers, shader resources, samplers and unordered access views) are kept until the next draw or dispatch,
+	* where the changed slots of each stage and type are bound with one call.
+	* The shadow copy does not know about binds made directly on the context, call Invalidate after such code.
+	*/
+	class StateCache
+	{
+	public:
+		static const uint32 NUM_STAGES				= 6; // In the order of ShaderBindingLayout::GetStageIndex.
+		static const uint32 MAX_CONSTANT_BUFFERS	= D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT;
+		static const uint32 MAX_SHADER_RESOURCES	= D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT;
+		static const uint32 MAX_SAMPLERS			= D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT;
+		static const uint32 MAX_UNORDERED_ACCESS	= D3D11_PS_CS_UAV_REGISTER_COUNT;
+		static const uint32 MAX_VERTEX_BUFFERS		= D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT;
+		static const uint32 MAX_RENDER_TARGETS		= D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT;
+
+		struct Stats
+		{
+			uint32	NumRequested	= 0; // Number of binds which were asked for, which is what the context would get without the cache.
+			uint32	NumIssued		= 0; // Number of calls made to the context.
+			uint32	NumFiltered		= 0; // Binds which did not change the state.
+			uint32	NumCoalesced	= 0; // Binds which were merged into the call of another bind.
+			uint32	NumDraws		= 0;
+		};
+
+	public:
+		RS_DEFAULT_ABSTRACT_CLASS(StateCache);
+
+		static std::shared_ptr<StateCache> Get();
+
+		/*
+		* filter: When false, every bind is sent to the context right away, without filtering or coalescing. The stats are still counted, which makes it possible to compare the number of calls with and without the cache.
+		*/
+		void Init(ID3D11DeviceContext* pContext, bool filter);
+		void Release();
+
+		/*
+		* Forget the shadow copy, the next bind of each state is sent to the context.
+		*/
+		void Invalidate();
+
+		/*
+		* Start counting the stats of a new frame, the stats of the previous frame are kept in GetFrameStats.
+		*/
+		void NewFrame();
+
+		// Shaders and input assembler
+		void SetVertexShader(ID3D11VertexShader* pShader);
+		void SetPixelShader(ID3D11PixelShader* pShader);
+		void SetGeometryShader(ID3D11GeometryShader* pShader);
+		void SetComputeShader(ID3D11ComputeShader* pShader);
+		void SetHullShader(ID3D11HullShader* pShader);
+		void SetDomainShader(ID3D11DomainShader* pShader);
+		void SetInputLayout(ID3D11InputLayout* pLayout);
+		void SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology);
+		void SetVertexBuffers(uint32 startSlot, uint32 count, ID3D11Buffer* const* ppBuffers, const UINT* pStrides, const UINT* pOffsets);
+		void SetIndexBuffer(ID3D11Buffer* pBuffer, DXGI_FORMAT format, uint32 offset);
+
+		// Slot bindings, these are sent to the context at the next draw or dispatch.
+		void SetConstantBuffers(ShaderTypeFlag stage, uint32 startSlot, uint32 count, ID3D11Buffer* const* ppBuffers);
+		void SetShaderResources(ShaderTypeFlag stage, uint32 startSlot, uint32 count, ID3D11ShaderResourceView* const* ppViews);
+		void SetSamplers(ShaderTypeFlag stage, uint32 startSlot, uint32 count, ID3D11SamplerState* const* ppSamplers);
+		void SetUnorderedAccessViews(uint32 startSlot, uint32 count, ID3D11UnorderedAccessView* const* ppViews); // Compute shader only.
+
+		// Rasterizer and output merger
+		void SetRasterizerState(ID3D11RasterizerState* pState);
+		void SetViewport(const D3D11_VIEWPORT& viewport);
+		void SetDepthStencilState(ID3D11DepthStencilState* pState, uint32 stencilRef);
+		void SetRenderTargets(uint32 count, ID3D11RenderTargetView* const* ppViews, ID3D11DepthStencilView* pDepthStencilView);
+
+		/*
+		* Send the changed slot bindings to the context. The draw functions call this.
+		*/
+		void FlushBindings();
+
+		void Draw(uint32 vertexCount, uint32 startVertex);
+		void DrawIndexed(uint32 indexCount, uint32 startIndex, int32 baseVertex);
+		void DrawInstanced(uint32 vertexCountPerInstance, uint32 instanceCount, uint32 startVertex, uint32 startInstance);
+		void DrawIndexedInstanced(uint32 indexCountPerInstance, uint32 instanceCount, uint32 startIndex, int32 baseVertex, uint32 startInstance);
+		void Dispatch(uint32 x, uint32 y, uint32 z);
+
+		const Stats& GetFrameStats() const; // The stats of the previous frame.
+		const Stats& GetTotalStats() const;
+		bool IsFiltering() const;
+
+	private:
+		/*
+		* The bound and pending pointers of one type of slot in one stage.
+		* [DirtyBegin, DirtyEnd) contains all slots which have been set since the last flush.
+		*/
+		template<typename T, uint32 Size>
+		struct SlotArray
+		{
+			T*		Bound[Size]		= {};
+			T*		Pending[Size]	= {};
+			bool	Dirty[Size]		= {};
+			uint32	DirtyBegin		= Size;
+			uint32	DirtyEnd		= 0;
+			uint32	NumSets			= 0;
+		};
+
+		template<typename T, uint32 Size>
+		void SetSlots(SlotArray<T, Size>& slots, uint32 startSlot, uint32 count, T* const* ppResources);
+
+		template<typename T, uint32 Size, typename Func>
+		void FlushSlots(SlotArray<T, Size>& slots, Func setFunc);
+
+		template<typename T, uint32 Size>
+		void InvalidateSlots(SlotArray<T, Size>& slots);
+
+		/*
+		* Returns true if the bind has to be sent to the context, and updates the shadow copy and the stats.
+		*/
+		template<typename T>
+		bool ShouldSet(T& current, const T& value);
+
+		void AddIssued(uint32 numCalls);
+		void AddFiltered(uint32 numBinds);
+
+	private:
+		ID3D11DeviceContext*		m_pContext		= nullptr;
+		bool						m_Filter		= true;
+
+		void*						m_Shaders[NUM_STAGES]	= {};
+		ID3D11InputLayout*			m_pInputLayout			= nullptr;
+		D3D11_PRIMITIVE_TOPOLOGY	m_Topology				= D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED;
+		ID3D11Buffer*				m_pIndexBuffer			= nullptr;
+		DXGI_FORMAT					m_IndexFormat			= DXGI_FORMAT_UNKNOWN;
+		uint32						m_IndexOffset			= 0;
+
+		ID3D11Buffer*				m_VertexBuffers[MAX_VERTEX_BUFFERS]	= {};
+		UINT						m_VertexStrides[MAX_VERTEX_BUFFERS]	= {};
+		UINT						m_VertexOffsets[MAX_VERTEX_BUFFERS]	= {};
+
+		SlotArray<ID3D11Buffer, MAX_CONSTANT_BUFFERS>				m_ConstantBuffers[NUM_STAGES];
+		SlotArray<ID3D11ShaderResourceView, MAX_SHADER_RESOURCES>	m_ShaderResources[NUM_STAGES];
+		SlotArray<ID3D11SamplerState, MAX_SAMPLERS>					m_Samplers[NUM_STAGES];
+		SlotArray<ID3D11UnorderedAccessView, MAX_UNORDERED_ACCESS>	m_UnorderedAccess;
+
+		ID3D11RasterizerState*		m_pRasterizerState		= nullptr;
+		D3D11_VIEWPORT				m_Viewport				= {};
+		ID3D11DepthStencilState*	m_pDepthStencilState	= nullptr;
+		uint32						m_StencilRef			= 0;
+		ID3D11RenderTargetView*		m_RenderTargets[MAX_RENDER_TARGETS]	= {};
+		uint32						m_NumRenderTargets		= 0;
+		ID3D11DepthStencilView*		m_pDepthStencilView		= nullptr;
+
+		Stats						m_CurrentStats;
+		Stats						m_FrameStats;
+		Stats						m_TotalStats;
+	};
+}
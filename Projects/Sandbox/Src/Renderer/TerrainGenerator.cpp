@@ -0,0 +1,487 @@
+#include "PreCompiled.h"
+#include "TerrainGenerator.h"
+
+#include "Utils/ParallelFor.h"
+#include "Utils/Timer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <emmintrin.h>
+#include <thread>
+
+using namespace RS;
+
+namespace
+{
+	const uint32 NUM_WARP_OCTAVES	= 4;
+	const uint32 OCTAVE_SEED_STEP	= 0x9E3779B9u;
+	const uint32 WARP_X_SEED		= 0x68E31DA4u;
+	const uint32 WARP_Z_SEED		= 0xB5297A4Du;
+	const float OCTAVE_ROTATION		= 0.6f; // Radians between the octaves, such that the lattices of the octaves do not line up.
+
+	const uint32 HASH_X = 0x27D4EB2Du;
+	const uint32 HASH_Z = 0x165667B1u;
+
+	// Hash of a point of the integer lattice, the multiplications wrap around.
+	uint32 Hash(int32 x, int32 z, uint32 seed)
+	{
+		uint32 hash = ((uint32)x * HASH_X) ^ ((uint32)z * HASH_Z) ^ seed;
+		hash ^= hash >> 16;
+		hash *= 0x7FEB352Du;
+		hash ^= hash >> 15;
+		hash *= 0x846CA68Bu;
+		hash ^= hash >> 16;
+		return hash;
+	}
+
+	float Fade(float t)
+	{
+		return t * t * t * (t * (t * 6.f - 15.f) + 10.f);
+	}
+
+	// The gradient is one of the four diagonals, picked by the two lowest bits of the hash.
+	float Grad(uint32 hash, float x, float z)
+	{
+		return ((hash & 1) ? -x : x) + ((hash & 2) ? -z : z);
+	}
+
+	float Noise(float x, float z, uint32 seed)
+	{
+		const float floorX = std::floor(x);
+		const float floorZ = std::floor(z);
+		const int32 ix = (int32)floorX;
+		const int32 iz = (int32)floorZ;
+		const float fx = x - floorX;
+		const float fz = z - floorZ;
+		const float u = Fade(fx);
+		const float v = Fade(fz);
+		const float n00 = Grad(Hash(ix, iz, seed), fx, fz);
+		const float n10 = Grad(Hash(ix + 1, iz, seed), fx - 1.f, fz);
+		const float n01 = Grad(Hash(ix, iz + 1, seed), fx, fz - 1.f);
+		const float n11 = Grad(Hash(ix + 1, iz + 1, seed), fx - 1.f, fz - 1.f);
+		const float n0 = n00 + (n10 - n00) * u;
+		const float n1 = n01 + (n11 - n01) * u;
+		return n0 + (n1 - n0) * v;
+	}
+
+	// The step from one octave to the next, a rotation scaled by the lacunarity.
+	void GetOctaveStep(const TerrainGenerator::Settings& settings, float& outCos, float& outSin)
+	{
+		outCos = std::cos(OCTAVE_ROTATION) * settings.Lacunarity;
+		outSin = std::sin(OCTAVE_ROTATION) * settings.Lacunarity;
+	}
+
+	float GetAmplitudeSum(uint32 numOctaves, float gain)
+	{
+		float sum = 0.f, amplitude = 1.f;
+		for (uint32 octave = 0; octave < numOctaves; octave++, amplitude *= gain)
+			sum += amplitude;
+		return sum;
+	}
+
+	float Fbm(float x, float z, uint32 seed, uint32 numOctaves, const TerrainGenerator::Settings& settings, float invAmplitudeSum)
+	{
+		float stepCos = 0.f, stepSin = 0.f;
+		GetOctaveStep(settings, stepCos, stepSin);
+		float sum = 0.f, amplitude = 1.f;
+		for (uint32 octave = 0; octave < numOctaves; octave++)
+		{
+			sum += Noise(x, z, seed + octave * OCTAVE_SEED_STEP) * amplitude;
+			amplitude *= settings.Gain;
+			const float nextX = x * stepCos - z * stepSin;
+			z = x * stepSin + z * stepCos;
+			x = nextX;
+		}
+		return sum * invAmplitudeSum;
+	}
+
+	// SSE2 has no 32 bit multiplication which keeps the low bits, the even and odd lanes are multiplied into 64 bits and the low halves put together again.
+	__m128i MulLo(__m128i a, __m128i b)
+	{
+		const __m128i even = _mm_mul_epu32(a, b);
+		const __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+		return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+	}
+
+	/*
+	* The functions below are the ones above for four samples, with the same operations in the same order such that the results are the same.
+	* Hash4 takes the products of the lattice coordinates, which Noise4 computes once for the two columns and the two rows around the samples.
+	*/
+	__m128i Hash4(__m128i xProduct, __m128i zProduct, __m128i seed)
+	{
+		__m128i hash = _mm_xor_si128(_mm_xor_si128(xProduct, zProduct), seed);
+		hash = _mm_xor_si128(hash, _mm_srli_epi32(hash, 16));
+		hash = MulLo(hash, _mm_set1_epi32(0x7FEB352D));
+		hash = _mm_xor_si128(hash, _mm_srli_epi32(hash, 15));
+		hash = MulLo(hash, _mm_set1_epi32((int)0x846CA68Bu));
+		hash = _mm_xor_si128(hash, _mm_srli_epi32(hash, 16));
+		return hash;
+	}
+
+	__m128 Fade4(__m128 t)
+	{
+		const __m128 inner = _mm_add_ps(_mm_mul_ps(t, _mm_sub_ps(_mm_mul_ps(t, _mm_set1_ps(6.f)), _mm_set1_ps(15.f))), _mm_set1_ps(10.f));
+		return _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(t, t), t), inner);
+	}
+
+	// The two lowest bits of the hash are moved into the sign bits, flipping them is the same as the negations of Grad.
+	__m128 Grad4(__m128i hash, __m128 x, __m128 z)
+	{
+		const __m128 signX = _mm_castsi128_ps(_mm_slli_epi32(hash, 31));
+		const __m128 signZ = _mm_castsi128_ps(_mm_and_si128(_mm_slli_epi32(hash, 30), _mm_set1_epi32((int)0x80000000u)));
+		return _mm_add_ps(_mm_xor_ps(x, signX), _mm_xor_ps(z, signZ));
+	}
+
+	// Without SSE4.1, the truncation is one too high for negative numbers with a fraction.
+	__m128 Floor4(__m128 x)
+	{
+		const __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+		return _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, x), _mm_set1_ps(1.f)));
+	}
+
+	__m128 Noise4(__m128 x, __m128 z, uint32 seed)
+	{
+		const __m128 one = _mm_set1_ps(1.f);
+		const __m128 floorX = Floor4(x);
+		const __m128 floorZ = Floor4(z);
+		// (x + 1) * HASH_X wraps around the same way as x * HASH_X + HASH_X.
+		const __m128i hashX = _mm_set1_epi32((int)HASH_X);
+		const __m128i hashZ = _mm_set1_epi32((int)HASH_Z);
+		const __m128i x0 = MulLo(_mm_cvttps_epi32(floorX), hashX);
+		const __m128i z0 = MulLo(_mm_cvttps_epi32(floorZ), hashZ);
+		const __m128i x1 = _mm_add_epi32(x0, hashX);
+		const __m128i z1 = _mm_add_epi32(z0, hashZ);
+		const __m128i seed4 = _mm_set1_epi32((int)seed);
+		const __m128 fx = _mm_sub_ps(x, floorX);
+		const __m128 fz = _mm_sub_ps(z, floorZ);
+		const __m128 fx1 = _mm_sub_ps(fx, one);
+		const __m128 fz1 = _mm_sub_ps(fz, one);
+		const __m128 u = Fade4(fx);
+		const __m128 v = Fade4(fz);
+		const __m128 n00 = Grad4(Hash4(x0, z0, seed4), fx, fz);
+		const __m128 n10 = Grad4(Hash4(x1, z0, seed4), fx1, fz);
+		const __m128 n01 = Grad4(Hash4(x0, z1, seed4), fx, fz1);
+		const __m128 n11 = Grad4(Hash4(x1, z1, seed4), fx1, fz1);
+		const __m128 n0 = _mm_add_ps(n00, _mm_mul_ps(_mm_sub_ps(n10, n00), u));
+		const __m128 n1 = _mm_add_ps(n01, _mm_mul_ps(_mm_sub_ps(n11, n01), u));
+		return _mm_add_ps(n0, _mm_mul_ps(_mm_sub_ps(n1, n0), v));
+	}
+
+	__m128 Fbm4(__m128 x, __m128 z, uint32 seed, uint32 numOctaves, const TerrainGenerator::Settings& settings, float invAmplitudeSum)
+	{
+		float stepCos = 0.f, stepSin = 0.f;
+		GetOctaveStep(settings, stepCos, stepSin);
+		const __m128 gain = _mm_set1_ps(settings.Gain);
+		const __m128 cos4 = _mm_set1_ps(stepCos);
+		const __m128 sin4 = _mm_set1_ps(stepSin);
+		__m128 sum = _mm_setzero_ps();
+		__m128 amplitude = _mm_set1_ps(1.f);
+		for (uint32 octave = 0; octave < numOctaves; octave++)
+		{
+			sum = _mm_add_ps(sum, _mm_mul_ps(Noise4(x, z, seed + octave * OCTAVE_SEED_STEP), amplitude));
+			amplitude = _mm_mul_ps(amplitude, gain);
+			const __m128 nextX = _mm_sub_ps(_mm_mul_ps(x, cos4), _mm_mul_ps(z, sin4));
+			z = _mm_add_ps(_mm_mul_ps(x, sin4), _mm_mul_ps(z, cos4));
+			x = nextX;
+		}
+		return _mm_mul_ps(sum, _mm_set1_ps(invAmplitudeSum));
+	}
+}
+
+void TerrainGenerator::Generate(uint32 size, const Settings& settings, std::vector<uint16>& outHeights, uint32 numThreads)
+{
+	Timer timer;
+	if (numThreads == 0)
+		numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+
+	const uint32 tileSize = std::max(settings.TileSize, 1u);
+	const uint32 numTilesPerSide = (size + tileSize - 1) / tileSize;
+	const uint32 numTiles = numTilesPerSide * numTilesPerSide;
+	numThreads = std::clamp(numThreads, 1u, std::max(numTiles, 1u));
+	outHeights.resize((size_t)size * size);
+
+	// Each thread has its own scratch memory and stats, the tiles write straight into their part of the heights.
+	std::vector<std::vector<float>> scratch(numThreads);
+	std::vector<Stats> threadStats(numThreads);
+	ParallelFor(numThreads, numTiles, [&](uint32 tile, uint32 threadIndex)
+		{
+			const uint32 x = (tile % numTilesPerSide) * tileSize;
+			const uint32 z = (tile / numTilesPerSide) * tileSize;
+			const uint32 width = std::min(tileSize, size - x);
+			const uint32 height = std::min(tileSize, size - z);
+			GenerateTile(size, settings, x, z, width, height, outHeights.data() + (size_t)z * size + x, size, scratch[threadIndex], threadStats[threadIndex]);
+		});
+
+	m_Stats = Stats();
+	m_Stats.Size		= size;
+	m_Stats.NumTiles	= numTiles;
+	m_Stats.NumThreads	= numThreads;
+	for (const Stats& stats : threadStats)
+	{
+		m_Stats.NumNoiseSamples	+= stats.NumNoiseSamples;
+		m_Stats.NoiseTimeMS		+= stats.NoiseTimeMS;
+		m_Stats.ErosionTimeMS	+= stats.ErosionTimeMS;
+	}
+	m_Stats.TotalTimeMS = timer.Stop().GetDeltaTimeMS();
+}
+
+void TerrainGenerator::GenerateRegion(uint32 size, const Settings& settings, uint32 x, uint32 z, uint32 width, uint32 height, uint16* pOut)
+{
+	std::vector<float> scratch;
+	Stats stats;
+	GenerateTile(size, settings, x, z, width, height, pOut, width, scratch, stats);
+}
+
+float TerrainGenerator::SampleHeight(uint32 size, const Settings& settings, float x, float z)
+{
+	const float scale = 1.f / (float)size;
+	const float u = x * scale;
+	const float v = z * scale;
+
+	// The warp moves the position by up to WarpStrength terrain sizes, which bends the ridges.
+	const float warpU = u * settings.WarpFrequency;
+	const float warpV = v * settings.WarpFrequency;
+	const float invWarpSum = 1.f / GetAmplitudeSum(NUM_WARP_OCTAVES, settings.Gain);
+	const float warpX = Fbm(warpU, warpV, settings.Seed ^ WARP_X_SEED, NUM_WARP_OCTAVES, settings, invWarpSum);
+	const float warpZ = Fbm(warpU, warpV, settings.Seed ^ WARP_Z_SEED, NUM_WARP_OCTAVES, settings, invWarpSum);
+	float px = (u + warpX * settings.WarpStrength) * settings.Frequency;
+	float pz = (v + warpZ * settings.WarpStrength) * settings.Frequency;
+
+	// The same octaves make the fBm and the ridged noise, which is high where the noise crosses zero.
+	float stepCos = 0.f, stepSin = 0.f;
+	GetOctaveStep(settings, stepCos, stepSin);
+	float fbm = 0.f, ridged = 0.f, amplitude = 1.f;
+	for (uint32 octave = 0; octave < settings.NumOctaves; octave++)
+	{
+		const float noise = Noise(px, pz, settings.Seed + octave * OCTAVE_SEED_STEP);
+		const float ridge = 1.f - std::abs(noise);
+		fbm += noise * amplitude;
+		ridged += ridge * ridge * amplitude;
+		amplitude *= settings.Gain;
+		const float nextX = px * stepCos - pz * stepSin;
+		pz = px * stepSin + pz * stepCos;
+		px = nextX;
+	}
+
+	const float invSum = 1.f / GetAmplitudeSum(settings.NumOctaves, settings.Gain);
+	fbm = fbm * invSum * 0.5f + 0.5f;
+	ridged = ridged * invSum;
+	return std::clamp(fbm + (ridged - fbm) * settings.RidgedWeight, 0.f, 1.f);
+}
+
+void TerrainGenerator::ComputeNormals(const uint16* pHeights, uint32 size, float sampleSpacing, float heightScale, std::vector<uint8>& outNormals, uint32 numThreads)
+{
+	if (numThreads == 0)
+		numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+
+	const float scale = heightScale / (float)UINT16_MAX;
+	outNormals.resize((size_t)size * size * 4);
+	ParallelFor(numThreads, size, [&](uint32 z, uint32)
+		{
+			const size_t back = (size_t)(z > 0 ? z - 1 : 0) * size;
+			const size_t front = (size_t)std::min(z + 1, size - 1) * size;
+			for (uint32 x = 0; x < size; x++)
+			{
+				const uint32 left = x > 0 ? x - 1 : 0;
+				const uint32 right = std::min(x + 1, size - 1);
+				const float heightLeft = pHeights[(size_t)z * size + left] * scale;
+				const float heightRight = pHeights[(size_t)z * size + right] * scale;
+				const float heightBack = pHeights[back + x] * scale;
+				const float heightFront = pHeights[front + x] * scale;
+				const glm::vec3 normal = glm::normalize(glm::vec3(heightLeft - heightRight, 2.f * sampleSpacing, heightBack - heightFront));
+
+				uint8* pNormal = &outNormals[((size_t)z * size + x) * 4];
+				pNormal[0] = (uint8)std::lround((normal.x * 0.5f + 0.5f) * 255.f);
+				pNormal[1] = (uint8)std::lround((normal.y * 0.5f + 0.5f) * 255.f);
+				pNormal[2] = (uint8)std::lround((normal.z * 0.5f + 0.5f) * 255.f);
+				pNormal[3] = 255;
+			}
+		});
+}
+
+void TerrainGenerator::ComputeSplat(const uint16* pHeights, const uint8* pNormals, uint32 size, std::vector<uint8>& outSplat, uint32 numThreads)
+{
+	if (numThreads == 0)
+		numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+
+	// The weights add up to 255, grass takes what the others leave.
+	outSplat.resize((size_t)size * size * 4);
+	ParallelFor(numThreads, size, [&](uint32 z, uint32)
+		{
+			for (uint32 x = 0; x < size; x++)
+			{
+				const size_t index = (size_t)z * size + x;
+				const float height = (float)pHeights[index] / (float)UINT16_MAX;
+				const float normalY = (float)pNormals[index * 4 + 1] / 255.f * 2.f - 1.f;
+				const float rock = glm::smoothstep(0.1f, 0.3f, 1.f - normalY);
+				const float sand = (1.f - glm::smoothstep(0.3f, 0.36f, height)) * (1.f - rock);
+				const float snow = glm::smoothstep(0.62f, 0.7f, height) * (1.f - rock);
+
+				uint8* pWeights = &outSplat[index * 4];
+				pWeights[0] = (uint8)std::lround(sand * 255.f);
+				pWeights[2] = (uint8)std::lround(rock * 255.f);
+				pWeights[3] = (uint8)std::lround(snow * 255.f);
+				pWeights[1] = (uint8)std::max(255 - pWeights[0] - pWeights[2] - pWeights[3], 0);
+			}
+		});
+}
+
+const TerrainGenerator::Stats& TerrainGenerator::GetStats() const
+{
+	return m_Stats;
+}
+
+void TerrainGenerator::GenerateTile(uint32 size, const Settings& settings, uint32 x, uint32 z, uint32 width, uint32 height, uint16* pOut, uint32 outPitch,
+	std::vector<float>& scratch, Stats& outStats)
+{
+	// The erosion moves material by one sample in each iteration, the samples of the tile do not depend on anything beyond the margin.
+	const uint32 margin = settings.NumErosionIterations;
+	const uint32 firstX = x - std::min(x, margin);
+	const uint32 firstZ = z - std::min(z, margin);
+	const uint32 regionWidth = std::min(x + width + margin, size) - firstX;
+	const uint32 regionHeight = std::min(z + height + margin, size) - firstZ;
+	const size_t regionSize = (size_t)regionWidth * regionHeight;
+	scratch.resize(regionSize * 2);
+	float* pHeights = scratch.data();
+	float* pNext = pHeights + regionSize;
+
+	Timer noiseTimer;
+	GenerateNoise(size, settings, firstX, firstZ, regionWidth, regionHeight, pHeights);
+	outStats.NoiseTimeMS += noiseTimer.Stop().GetDeltaTimeMS();
+	outStats.NumNoiseSamples += regionSize;
+
+	// All samples exchange material with their four neighbours at once, from the heights of the last iteration.
+	// The flow between two samples only depends on their two heights, both see the same amount in the other direction.
+	// The samples which have all four neighbours are done four at a time, with the same operations as the scalar ones at the edges.
+	Timer erosionTimer;
+	const float talus = settings.Talus / (float)size;
+	const float rate = settings.ErosionRate;
+	const __m128 talus4 = _mm_set1_ps(talus);
+	const __m128 rate4 = _mm_set1_ps(rate);
+	auto Flow = [talus, rate](float from, float to)
+	{
+		const float excess = from - to - talus;
+		return excess > 0.f ? excess * rate : 0.f;
+	};
+	auto Flow4 = [talus4, rate4](__m128 from, __m128 to)
+	{
+		return _mm_mul_ps(_mm_max_ps(_mm_sub_ps(_mm_sub_ps(from, to), talus4), _mm_setzero_ps()), rate4);
+	};
+	for (uint32 iteration = 0; iteration < settings.NumErosionIterations; iteration++)
+	{
+		for (uint32 row = 0; row < regionHeight; row++)
+		{
+			const bool isInnerRow = row > 0 && row + 1 < regionHeight;
+			for (uint32 column = 0; column < regionWidth;)
+			{
+				const size_t index = (size_t)row * regionWidth + column;
+				if (isInnerRow && column > 0 && column + 4 < regionWidth)
+				{
+					const __m128 sample = _mm_loadu_ps(pHeights + index);
+					const __m128 left = _mm_loadu_ps(pHeights + index - 1);
+					const __m128 right = _mm_loadu_ps(pHeights + index + 1);
+					const __m128 back = _mm_loadu_ps(pHeights + index - regionWidth);
+					const __m128 front = _mm_loadu_ps(pHeights + index + regionWidth);
+					__m128 change = _mm_setzero_ps();
+					change = _mm_add_ps(change, _mm_sub_ps(Flow4(left, sample), Flow4(sample, left)));
+					change = _mm_add_ps(change, _mm_sub_ps(Flow4(right, sample), Flow4(sample, right)));
+					change = _mm_add_ps(change, _mm_sub_ps(Flow4(back, sample), Flow4(sample, back)));
+					change = _mm_add_ps(change, _mm_sub_ps(Flow4(front, sample), Flow4(sample, front)));
+					_mm_storeu_ps(pNext + index, _mm_add_ps(sample, change));
+					column += 4;
+					continue;
+				}
+
+				const float sample = pHeights[index];
+				float change = 0.f;
+				if (column > 0)
+					change += Flow(pHeights[index - 1], sample) - Flow(sample, pHeights[index - 1]);
+				if (column + 1 < regionWidth)
+					change += Flow(pHeights[index + 1], sample) - Flow(sample, pHeights[index + 1]);
+				if (row > 0)
+					change += Flow(pHeights[index - regionWidth], sample) - Flow(sample, pHeights[index - regionWidth]);
+				if (row + 1 < regionHeight)
+					change += Flow(pHeights[index + regionWidth], sample) - Flow(sample, pHeights[index + regionWidth]);
+				pNext[index] = sample + change;
+				column++;
+			}
+		}
+		std::swap(pHeights, pNext);
+	}
+
+	for (uint32 row = 0; row < height; row++)
+	{
+		const float* pRow = pHeights + (size_t)(z - firstZ + row) * regionWidth + (x - firstX);
+		for (uint32 column = 0; column < width; column++)
+			pOut[(size_t)row * outPitch + column] = (uint16)(std::clamp(pRow[column], 0.f, 1.f) * UINT16_MAX + 0.5f);
+	}
+	outStats.ErosionTimeMS += erosionTimer.Stop().GetDeltaTimeMS();
+}
+
+void TerrainGenerator::GenerateNoise(uint32 size, const Settings& settings, uint32 x, uint32 z, uint32 width, uint32 height, float* pOut)
+{
+	const __m128 scale = _mm_set1_ps(1.f / (float)size);
+	const __m128 laneOffsets = _mm_set_ps(3.f, 2.f, 1.f, 0.f);
+	const __m128 warpFrequency = _mm_set1_ps(settings.WarpFrequency);
+	const __m128 warpStrength = _mm_set1_ps(settings.WarpStrength);
+	const __m128 frequency = _mm_set1_ps(settings.Frequency);
+	const __m128 gain = _mm_set1_ps(settings.Gain);
+	const __m128 one = _mm_set1_ps(1.f);
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32((int)0x80000000u));
+	const float invWarpSum = 1.f / GetAmplitudeSum(NUM_WARP_OCTAVES, settings.Gain);
+	const __m128 invSum = _mm_set1_ps(1.f / GetAmplitudeSum(settings.NumOctaves, settings.Gain));
+	float stepCos = 0.f, stepSin = 0.f;
+	GetOctaveStep(settings, stepCos, stepSin);
+	const __m128 cos4 = _mm_set1_ps(stepCos);
+	const __m128 sin4 = _mm_set1_ps(stepSin);
+
+	for (uint32 row = 0; row < height; row++)
+	{
+		const __m128 v = _mm_mul_ps(_mm_set1_ps((float)(z + row)), scale);
+		float* pRow = pOut + (size_t)row * width;
+		for (uint32 column = 0; column < width; column += 4)
+		{
+			const __m128 u = _mm_mul_ps(_mm_add_ps(_mm_set1_ps((float)(x + column)), laneOffsets), scale);
+
+			const __m128 warpU = _mm_mul_ps(u, warpFrequency);
+			const __m128 warpV = _mm_mul_ps(v, warpFrequency);
+			const __m128 warpX = Fbm4(warpU, warpV, settings.Seed ^ WARP_X_SEED, NUM_WARP_OCTAVES, settings, invWarpSum);
+			const __m128 warpZ = Fbm4(warpU, warpV, settings.Seed ^ WARP_Z_SEED, NUM_WARP_OCTAVES, settings, invWarpSum);
+			__m128 px = _mm_mul_ps(_mm_add_ps(u, _mm_mul_ps(warpX, warpStrength)), frequency);
+			__m128 pz = _mm_mul_ps(_mm_add_ps(v, _mm_mul_ps(warpZ, warpStrength)), frequency);
+
+			__m128 fbm = _mm_setzero_ps();
+			__m128 ridged = _mm_setzero_ps();
+			__m128 amplitude = one;
+			for (uint32 octave = 0; octave < settings.NumOctaves; octave++)
+			{
+				const __m128 noise = Noise4(px, pz, settings.Seed + octave * OCTAVE_SEED_STEP);
+				const __m128 ridge = _mm_sub_ps(one, _mm_andnot_ps(signMask, noise));
+				fbm = _mm_add_ps(fbm, _mm_mul_ps(noise, amplitude));
+				ridged = _mm_add_ps(ridged, _mm_mul_ps(_mm_mul_ps(ridge, ridge), amplitude));
+				amplitude = _mm_mul_ps(amplitude, gain);
+				const __m128 nextX = _mm_sub_ps(_mm_mul_ps(px, cos4), _mm_mul_ps(pz, sin4));
+				pz = _mm_add_ps(_mm_mul_ps(px, sin4), _mm_mul_ps(pz, cos4));
+				px = nextX;
+			}
+
+			fbm = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(fbm, invSum), half), half);
+			ridged = _mm_mul_ps(ridged, invSum);
+			__m128 result = _mm_add_ps(fbm, _mm_mul_ps(_mm_sub_ps(ridged, fbm), _mm_set1_ps(settings.RidgedWeight)));
+			result = _mm_min_ps(_mm_max_ps(result, _mm_setzero_ps()), one);
+
+			// The lanes past the end of the row are computed and dropped.
+			if (column + 4 <= width)
+			{
+				_mm_storeu_ps(pRow + column, result);
+			}
+			else
+			{
+				alignas(16) float values[4];
+				_mm_store_ps(values, result);
+				std::copy(values, values + (width - column), pRow + column);
+			}
+		}
+	}
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "Utils/Maths.h"
+
+#include <vector>
+
+namespace RS
+{
+	/*
+	* Generates the heights of a terrain from noise, without any source data.
+	*	- Gradient noise summed in octaves, both as fBm and as ridged noise, at positions which are warped by two more fBm fields.
+	*	- Thermal erosion moves material from a sample to each neighbour which is lower by more than the talus.
+	*	- The noise is evaluated for four samples at a time with SSE2. SampleHeight is the scalar version, with the same operations in the same order.
+	*	- A height only depends on the seed and its position. The terrain is generated in tiles on worker threads, and each tile erodes a margin of one
+	*	  sample per iteration around it, such that the tiles meet without seams wherever the terrain is cut.
+	* Example:
+	*	TerrainGenerator generator;
+	*	generator.Generate(2048, settings, heights);
+	*	TerrainGenerator::ComputeNormals(heights.data(), 2048, sampleSpacing, heightScale, normals);
+	*	TerrainGenerator::ComputeSplat(heights.data(), normals.data(), 2048, splat);
+	*	CookedAssets::CookTerrain(heights.data(), splat.data(), 2048, 256, 32, data);
+	*/
+	class TerrainGenerator
+	{
+	public:
+		struct Settings
+		{
+			uint32	Seed					= 1337;
+			uint32	NumOctaves				= 8;
+			float	Frequency				= 3.f;	// Cycles of the first octave across the terrain.
+			float	Lacunarity				= 2.f;
+			float	Gain					= 0.5f;
+			float	RidgedWeight			= 0.6f;	// Zero is only fBm, one is only ridged noise.
+			float	WarpStrength			= 0.08f; // In terrain sizes.
+			float	WarpFrequency			= 2.f;
+			uint32	NumErosionIterations	= 24;
+			float	Talus					= 4.f;	// The largest stable height difference between neighbours, in heights per terrain size.
+			float	ErosionRate				= 0.2f;	// Share of the height above the talus which moves in one iteration, at most 0.25.
+			uint32	TileSize				= 256;	// Samples along a side of the tiles which are generated on the worker threads.
+		};
+
+		struct Stats
+		{
+			uint32	Size				= 0;
+			uint32	NumTiles			= 0;
+			uint32	NumThreads			= 0;
+			uint64	NumNoiseSamples		= 0; // Including the erosion margins of the tiles.
+			float	NoiseTimeMS			= 0.f; // Summed over the threads.
+			float	ErosionTimeMS		= 0.f; // Summed over the threads.
+			float	TotalTimeMS			= 0.f;
+		};
+
+	public:
+		RS_DEFAULT_CLASS(TerrainGenerator);
+
+		/*
+		* Generate size x size heights in rows of increasing z.
+		* numThreads: Zero uses one for each hardware thread. The result is the same for any number of threads and any tile size.
+		*/
+		void Generate(uint32 size, const Settings& settings, std::vector<uint16>& outHeights, uint32 numThreads = 0);
+
+		/*
+		* Generate width x height samples of a size x size terrain, starting at the sample (x, z), in rows of width.
+		* They are the same as the samples of Generate, such that a terrain can be generated one tile at a time.
+		*/
+		static void GenerateRegion(uint32 size, const Settings& settings, uint32 x, uint32 z, uint32 width, uint32 height, uint16* pOut);
+
+		/*
+		* The height of the sample (x, z) of a size x size terrain before the erosion, in [0, 1].
+		*/
+		static float SampleHeight(uint32 size, const Settings& settings, float x, float z);
+
+		/*
+		* The same as SampleHeight for width x height samples starting at the sample (x, z), in rows of width. Four samples are evaluated at a time with SSE2.
+		*/
+		static void GenerateNoise(uint32 size, const Settings& settings, uint32 x, uint32 z, uint32 width, uint32 height, float* pOut);
+
+		/*
+		* RGBA8 normals (xyz * 0.5 + 0.5) from the neighbouring heights, the same way as the terrain shader.
+		*/
+		static void ComputeNormals(const uint16* pHeights, uint32 size, float sampleSpacing, float heightScale, std::vector<uint8>& outNormals, uint32 numThreads = 0);
+
+		/*
+		* RGBA8 splat weights for CookedAssets::CookTerrain, sand at the bottom, then grass, rock on the slopes and snow on the flat peaks.
+		*/
+		static void ComputeSplat(const uint16* pHeights, const uint8* pNormals, uint32 size, std::vector<uint8>& outSplat, uint32 numThreads = 0);
+
+		const Stats& GetStats() const;
+
+	private:
+		static void GenerateTile(uint32 size, const Settings& settings, uint32 x, uint32 z, uint32 width, uint32 height, uint16* pOut, uint32 outPitch,
+			std::vector<float>& scratch, Stats& outStats);
+
+	private:
+		Stats	m_Stats;
+	};
+}
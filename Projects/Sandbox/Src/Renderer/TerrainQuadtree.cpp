@@ -0,0 +1,227 @@
+#include "PreCompiled.h"
+#include "TerrainQuadtree.h"
+
+#include <cmath>
+
+using namespace RS;
+
+namespace
+{
+	bool IntersectsSphere(const AABB& aabb, const glm::vec3& center, float radius)
+	{
+		const glm::vec3 closest = Maths::GetMaxElements(aabb.min, Maths::GetMinElements(center, aabb.max));
+		const glm::vec3 delta = closest - center;
+		return glm::dot(delta, delta) <= radius * radius;
+	}
+}
+
+bool TerrainQuadtree::Build(const uint16* pHeights, uint32 size, const Settings& settings, uint32 numThreads)
+{
+	return Build(size, settings, [pHeights, size](uint32 x, uint32 z) { return pHeights[(size_t)z * size + x]; }, numThreads);
+}
+
+bool TerrainQuadtree::Build(const MinMax* pLeaves, uint32 size, const Settings& settings)
+{
+	Timer timer;
+	if (!Validate(size, settings))
+		return false;
+
+	const uint32 numLeaves = GetLevelWidth(0);
+	m_Levels[0].assign(pLeaves, pLeaves + (size_t)numLeaves * numLeaves);
+	BuildLevels();
+	m_Stats.BuildTimeMS = timer.Stop().GetDeltaTimeMS();
+	return true;
+}
+
+void TerrainQuadtree::Select(const glm::vec3& cameraPos, const glm::mat4& viewProj)
+{
+	Timer timer;
+	m_Patches.clear();
+	const float buildTimeMS = m_Stats.BuildTimeMS;
+	m_Stats = Stats();
+	m_Stats.BuildTimeMS = buildTimeMS;
+	if (m_NumLods == 0)
+		return;
+
+	const Frustum frustum = Frustum::FromViewProj(viewProj);
+	const uint32 topLevel = m_NumLods - 1;
+	const uint32 width = GetLevelWidth(topLevel);
+	for (uint32 z = 0; z < width; z++)
+	{
+		for (uint32 x = 0; x < width; x++)
+			SelectNode(topLevel, x, z, cameraPos, frustum);
+	}
+
+	m_Stats.NumPatches = (uint32)m_Patches.size();
+	m_Stats.SelectTimeMS = timer.Stop().GetDeltaTimeMS();
+}
+
+glm::vec2 TerrainQuadtree::GetMorphRange(uint32 lod) const
+{
+	const float start = lod > 0 ? m_Ranges[lod - 1] : 0.f;
+	return glm::vec2(glm::mix(start, m_Ranges[lod], m_Settings.MorphRatio), m_Ranges[lod]);
+}
+
+AABB TerrainQuadtree::GetPatchBounds(const Patch& patch) const
+{
+	const uint32 quadrantSize = GetMeshSize() << patch.Lod;
+	const uint32 x = (uint32)std::lround(patch.Offset.x / m_Settings.SampleSpacing) / quadrantSize;
+	const uint32 z = (uint32)std::lround(patch.Offset.y / m_Settings.SampleSpacing) / quadrantSize;
+	return GetQuadrantBounds(patch.Lod, x, z);
+}
+
+uint32 TerrainQuadtree::GetSize() const
+{
+	return m_Size;
+}
+
+uint32 TerrainQuadtree::GetNumLods() const
+{
+	return m_NumLods;
+}
+
+uint32 TerrainQuadtree::GetMeshSize() const
+{
+	return m_Settings.LeafSize / 2;
+}
+
+const TerrainQuadtree::Settings& TerrainQuadtree::GetSettings() const
+{
+	return m_Settings;
+}
+
+const std::vector<TerrainQuadtree::Patch>& TerrainQuadtree::GetPatches() const
+{
+	return m_Patches;
+}
+
+const TerrainQuadtree::Stats& TerrainQuadtree::GetStats() const
+{
+	return m_Stats;
+}
+
+bool TerrainQuadtree::Validate(uint32 size, const Settings& settings)
+{
+	if (settings.LeafSize < 4 || !std::has_single_bit(settings.LeafSize))
+	{
+		LOG_ERROR("Terrain quadtree leaf size {} is not a power of two of at least four!", settings.LeafSize);
+		return false;
+	}
+	if (size < settings.LeafSize || !std::has_single_bit(size))
+	{
+		LOG_ERROR("Terrain quadtree size {} is not a power of two of at least the leaf size {}!", size, settings.LeafSize);
+		return false;
+	}
+
+	m_Settings = settings;
+	m_Size = size;
+	m_NumLods = std::min({ std::max(settings.NumLods, 1u), (uint32)std::countr_zero(size / settings.LeafSize) + 1, MAX_LODS });
+	m_Levels.assign(m_NumLods, std::vector<MinMax>());
+	m_Patches.clear();
+	m_Stats = Stats();
+
+	for (uint32 lod = 0; lod < m_NumLods; lod++)
+		m_Ranges[lod] = settings.Lod0Range * (float)(1u << lod);
+	return true;
+}
+
+void TerrainQuadtree::BuildLevels()
+{
+	for (uint32 level = 1; level < m_NumLods; level++)
+	{
+		const uint32 width = GetLevelWidth(level);
+		const uint32 childWidth = width * 2;
+		const std::vector<MinMax>& children = m_Levels[level - 1];
+		std::vector<MinMax>& nodes = m_Levels[level];
+		nodes.resize((size_t)width * width);
+		for (uint32 z = 0; z < width; z++)
+		{
+			for (uint32 x = 0; x < width; x++)
+			{
+				const size_t first = (size_t)z * 2 * childWidth + x * 2;
+				const MinMax& a = children[first];
+				const MinMax& b = children[first + 1];
+				const MinMax& c = children[first + childWidth];
+				const MinMax& d = children[first + childWidth + 1];
+				nodes[(size_t)z * width + x] = { std::min({ a.Min, b.Min, c.Min, d.Min }), std::max({ a.Max, b.Max, c.Max, d.Max }) };
+			}
+		}
+	}
+}
+
+const TerrainQuadtree::MinMax& TerrainQuadtree::GetNodeHeights(uint32 level, uint32 x, uint32 z) const
+{
+	return m_Levels[level][(size_t)z * GetLevelWidth(level) + x];
+}
+
+uint32 TerrainQuadtree::GetLevelWidth(uint32 level) const
+{
+	return (m_Size / m_Settings.LeafSize) >> level;
+}
+
+AABB TerrainQuadtree::GetNodeBounds(uint32 level, uint32 x, uint32 z) const
+{
+	const MinMax& minMax = GetNodeHeights(level, x, z);
+	const float nodeSize = (float)(m_Settings.LeafSize << level) * m_Settings.SampleSpacing;
+	const float heightScale = m_Settings.HeightScale / (float)UINT16_MAX;
+
+	AABB aabb;
+	aabb.min = glm::vec3(x * nodeSize, minMax.Min * heightScale, z * nodeSize);
+	aabb.max = glm::vec3((x + 1) * nodeSize, minMax.Max * heightScale, (z + 1) * nodeSize);
+	return aabb;
+}
+
+AABB TerrainQuadtree::GetQuadrantBounds(uint32 level, uint32 x, uint32 z) const
+{
+	if (level > 0)
+		return GetNodeBounds(level - 1, x, z);
+
+	// The leaves have no children, their quadrants use the heights of the whole leaf.
+	AABB aabb = GetNodeBounds(0, x / 2, z / 2);
+	const float quadrantSize = (float)GetMeshSize() * m_Settings.SampleSpacing;
+	aabb.min.x = x * quadrantSize;
+	aabb.min.z = z * quadrantSize;
+	aabb.max.x = (x + 1) * quadrantSize;
+	aabb.max.z = (z + 1) * quadrantSize;
+	return aabb;
+}
+
+void TerrainQuadtree::SelectNode(uint32 level, uint32 x, uint32 z, const glm::vec3& cameraPos, const Frustum& frustum)
+{
+	m_Stats.NumVisitedNodes++;
+	const AABB bounds = GetNodeBounds(level, x, z);
+	if (!frustum.Intersects(bounds))
+	{
+		m_Stats.NumCulledNodes++;
+		return;
+	}
+
+	// The quadrants which are within the range of the next finer LOD are split further, the others are drawn with the LOD of this level.
+	const bool canSplit = level > 0 && IntersectsSphere(bounds, cameraPos, m_Ranges[level - 1]);
+	for (uint32 quadrant = 0; quadrant < 4; quadrant++)
+	{
+		const uint32 childX = x * 2 + (quadrant & 1);
+		const uint32 childZ = z * 2 + (quadrant >> 1);
+		if (canSplit && IntersectsSphere(GetNodeBounds(level - 1, childX, childZ), cameraPos, m_Ranges[level - 1]))
+			SelectNode(level - 1, childX, childZ, cameraPos, frustum);
+		else
+			AddPatch(level, childX, childZ, frustum);
+	}
+}
+
+void TerrainQuadtree::AddPatch(uint32 level, uint32 x, uint32 z, const Frustum& frustum)
+{
+	const AABB bounds = GetQuadrantBounds(level, x, z);
+	if (!frustum.Intersects(bounds))
+	{
+		m_Stats.NumCulledNodes++;
+		return;
+	}
+
+	Patch patch;
+	patch.Offset	= glm::vec2(bounds.min.x, bounds.min.z);
+	patch.Size		= bounds.max.x - bounds.min.x;
+	patch.Lod		= level;
+	m_Patches.push_back(patch);
+	m_Stats.PatchesPerLod[level]++;
+}
@@ -0,0 +1,172 @@
+#pragma once
+
+#include "Structures/AABB.h"
+#include "Structures/Frustum.h"
+#include "Utils/Maths.h"
+#include "Utils/ParallelFor.h"
+#include "Utils/Timer.h"
+
+#include <algorithm>
+#include <bit>
+#include <thread>
+#include <vector>
+
+namespace RS
+{
+	/*
+	* The CPU side of a CDLOD terrain (continuous distance-dependent level of detail), it does not use the device.
+	*	- A quadtree covers the heightmap, each node keeps the lowest and highest height under it such that it can be culled as a box.
+	*	- Each frame the nodes are selected from the top. A node is split where it is within the range of the next finer LOD, the range of each LOD is twice the one before.
+	*	- A selected node is drawn as its four quadrants, each quadrant is one instance of the same grid mesh of GetMeshSize() x GetMeshSize() quads.
+	*	- The vertices morph into the grid of the next LOD towards the end of the range of their LOD, such that neighbouring patches meet without cracks.
+	* Example:
+	*	TerrainQuadtree quadtree;
+	*	quadtree.Build(heights.data(), 4096, settings);
+	*	quadtree.Select(camera.GetPos(), camera.GetProj() * camera.GetView());
+	*	for (const TerrainQuadtree::Patch& patch : quadtree.GetPatches()) ... quadtree.GetMorphRange(patch.Lod) ...
+	*/
+	class TerrainQuadtree
+	{
+	public:
+		static constexpr uint32 MAX_LODS = 16;
+
+		struct Settings
+		{
+			uint32	LeafSize		= 32;		// Heightmap quads along the side of the smallest node, a power of two of at least four.
+			uint32	NumLods			= 8;		// Fewer are used if the heightmap is too small for this many levels.
+			float	SampleSpacing	= 1.f;		// World units between two heightmap samples.
+			float	HeightScale		= 100.f;	// World height of the largest height value.
+			float	Lod0Range		= 96.f;		// World distance where the finest LOD ends, below 2.5 times the world size of a leaf neighbours can crack.
+			float	MorphRatio		= 0.7f;		// Part of the range of a LOD after which its vertices start to morph into the next LOD.
+		};
+
+		// The layout matches TerrainPatch in TerrainScene/TerrainVert.hlsl.
+		struct Patch
+		{
+			glm::vec2	Offset	= glm::vec2(0.f); // World xz of the corner with the lowest coordinates.
+			float		Size	= 0.f; // World size of a side.
+			uint32		Lod		= 0;
+		};
+
+		// The layout matches the min/max map of a cooked terrain (See CookedAssets::TerrainHeader).
+		struct MinMax
+		{
+			uint16	Min	= 0;
+			uint16	Max	= 0;
+		};
+
+		struct Stats
+		{
+			uint32	NumPatches				= 0;
+			uint32	NumVisitedNodes			= 0;
+			uint32	NumCulledNodes			= 0; // Nodes and patches outside of the frustum.
+			uint32	PatchesPerLod[MAX_LODS]	= {};
+			float	BuildTimeMS				= 0.f;
+			float	SelectTimeMS			= 0.f;
+		};
+
+	public:
+		RS_DEFAULT_CLASS(TerrainQuadtree);
+
+		/*
+		* Find the lowest and highest height of each node, then the LOD ranges.
+		* The terrain is size x size quads, where size is a power of two and a multiple of the leaf size.
+		* The heights are size x size samples in rows of increasing z, the quads past the last sample use the last sample again.
+		* numThreads: Zero uses one for each hardware thread.
+		* Returns false if the sizes are not supported.
+		*/
+		bool Build(const uint16* pHeights, uint32 size, const Settings& settings, uint32 numThreads = 0);
+
+		/*
+		* The same as above, where getHeight(x, z) returns the uint16 height of a sample. It is called from several threads.
+		*/
+		template<typename Function>
+		bool Build(uint32 size, const Settings& settings, Function getHeight, uint32 numThreads = 0);
+
+		/*
+		* The same as above from the lowest and highest height of each leaf, (size / LeafSize)^2 of them in rows of increasing z.
+		* Each leaf includes the first row and column of its neighbours, the min/max map of a cooked terrain can be used when it has the same leaf size.
+		*/
+		bool Build(const MinMax* pLeaves, uint32 size, const Settings& settings);
+
+		/*
+		* Select the patches for the camera, the matrix is the one of Camera (depth range [0, 1]).
+		* Patches outside of the frustum are skipped, patches further away than the range of the coarsest LOD are drawn with that LOD.
+		*/
+		void Select(const glm::vec3& cameraPos, const glm::mat4& viewProj);
+
+		/*
+		* The world distances where the vertices of a LOD start and end to morph into the next LOD.
+		*/
+		glm::vec2 GetMorphRange(uint32 lod) const;
+
+		/*
+		* The box of a patch, with the heights of the node it is made from.
+		*/
+		AABB GetPatchBounds(const Patch& patch) const;
+
+		/*
+		* The lowest and highest height under a node, level 0 are the leaves. A level is (size / LeafSize) >> level nodes wide.
+		*/
+		const MinMax& GetNodeHeights(uint32 level, uint32 x, uint32 z) const;
+
+		uint32 GetSize() const;
+		uint32 GetNumLods() const;
+		uint32 GetMeshSize() const; // Quads along the side of the patch mesh, half of the leaf size.
+		const Settings& GetSettings() const;
+		const std::vector<Patch>& GetPatches() const;
+		const Stats& GetStats() const;
+
+	private:
+		bool Validate(uint32 size, const Settings& settings);
+		void BuildLevels();
+		uint32 GetLevelWidth(uint32 level) const;
+		AABB GetNodeBounds(uint32 level, uint32 x, uint32 z) const;
+		AABB GetQuadrantBounds(uint32 level, uint32 x, uint32 z) const; // x and z are in the nodes of the level below.
+		void SelectNode(uint32 level, uint32 x, uint32 z, const glm::vec3& cameraPos, const Frustum& frustum);
+		void AddPatch(uint32 level, uint32 x, uint32 z, const Frustum& frustum);
+
+	private:
+		Settings							m_Settings;
+		uint32								m_Size		= 0;
+		uint32								m_NumLods	= 0;
+		std::vector<std::vector<MinMax>>	m_Levels; // Level 0 are the leaves, each level is GetLevelWidth(level) nodes wide in rows of increasing z.
+		float								m_Ranges[MAX_LODS]	= {};
+		std::vector<Patch>					m_Patches;
+		Stats								m_Stats;
+	};
+
+	template<typename Function>
+	bool TerrainQuadtree::Build(uint32 size, const Settings& settings, Function getHeight, uint32 numThreads)
+	{
+		Timer timer;
+		if (!Validate(size, settings))
+			return false;
+
+		// Each row of leaves on its own thread, a leaf also reads the first row and column of its neighbours since its quads end there.
+		const uint32 leafSize = m_Settings.LeafSize;
+		const uint32 numLeaves = GetLevelWidth(0);
+		m_Levels[0].assign((size_t)numLeaves * numLeaves, MinMax());
+		ParallelFor(numThreads > 0 ? numThreads : std::max(std::thread::hardware_concurrency(), 1u), numLeaves, [&](uint32 leafZ, uint32)
+			{
+				for (uint32 leafX = 0; leafX < numLeaves; leafX++)
+				{
+					MinMax minMax = { UINT16_MAX, 0 };
+					for (uint32 z = leafZ * leafSize; z <= leafZ * leafSize + leafSize; z++)
+					{
+						for (uint32 x = leafX * leafSize; x <= leafX * leafSize + leafSize; x++)
+						{
+							const uint16 height = getHeight(std::min(x, size - 1), std::min(z, size - 1));
+							minMax.Min = std::min(minMax.Min, height);
+							minMax.Max = std::max(minMax.Max, height);
+						}
+					}
+					m_Levels[0][(size_t)leafZ * numLeaves + leafX] = minMax;
+				}
+			});
+
+		BuildLevels();
+		m_Stats.BuildTimeMS = timer.Stop().GetDeltaTimeMS();
+		return true;
+	}
+}
@@ -0,0 +1,302 @@
+#include "PreCompiled.h"
+#include "TerrainStreamer.h"
+
+#include "Core/VirtualFileSystem.h"
+#include "Utils/Timer.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace RS;
+
+TerrainStreamer::~TerrainStreamer()
+{
+	Close();
+}
+
+bool TerrainStreamer::Open(const std::string& path, const Settings& settings)
+{
+	FileView view;
+	if (!VirtualFileSystem::Get()->Read(path, view))
+	{
+		LOG_ERROR("Failed to read the terrain [{}]!", path.c_str());
+		return false;
+	}
+	return Open(std::move(view), settings);
+}
+
+bool TerrainStreamer::Open(FileView view, const Settings& settings)
+{
+	Close();
+	if (!CookedAssets::ReadTerrainHeader(view, m_Header))
+		return false;
+
+	m_View		= std::move(view);
+	m_Settings	= settings;
+	m_Settings.NumSlots = std::max(settings.NumSlots, 1u);
+
+	// A slot holds the data of a tile without the padding after it.
+	const uint32 tileSize = m_Header.TileSize;
+	m_SlotBytes = m_Header.SplatOffset + (uint64)(tileSize + 1) * (tileSize + 1) * 4;
+	m_SlotMemory.assign((size_t)(m_SlotBytes * m_Settings.NumSlots), 0);
+	m_Slots.assign(m_Settings.NumSlots, Slot());
+	m_TileSlots.clear();
+	m_TileSlots.reserve(m_Settings.NumSlots);
+	m_Requests.clear();
+	m_LoadedSlots.clear();
+	m_NewSlots.clear();
+	m_Frame = 0;
+
+	m_Stats = Stats();
+	m_Stats.NumSlots	= m_Settings.NumSlots;
+	m_Stats.CacheBytes	= (uint64)m_SlotMemory.size();
+
+	m_ShouldStop = false;
+	m_Thread = std::thread(&TerrainStreamer::Stream, this);
+	return true;
+}
+
+void TerrainStreamer::Close()
+{
+	if (!m_Thread.joinable())
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_ShouldStop = true;
+	}
+	m_RequestCondition.notify_all();
+	m_Thread.join();
+
+	LOG_INFO("Terrain streaming stats: {} wanted tiles, {} hits, {} misses, {} loads, {} evictions, {:.1f} MB read in {:.1f} ms.",
+		m_Stats.NumWantedTiles, m_Stats.NumHits, m_Stats.NumMisses, m_Stats.NumLoads, m_Stats.NumEvictions, (float)m_Stats.BytesLoaded / (1024.f * 1024.f), m_Stats.LoadTimeMS);
+
+	m_View = FileView();
+	m_SlotMemory = std::vector<uint8>();
+	m_Slots.clear();
+	m_TileSlots.clear();
+	m_Requests.clear();
+	m_LoadedSlots.clear();
+	m_NewSlots.clear();
+}
+
+void TerrainStreamer::SetLodRange(float lodRange)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Settings.LodRange = lodRange;
+}
+
+void TerrainStreamer::Update(const glm::vec3& cameraPos)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Frame++;
+
+		// The loaded tiles are marked as used, such that they are not taken again before they have been uploaded.
+		m_NewSlots.swap(m_LoadedSlots);
+		m_LoadedSlots.clear();
+		for (uint32 slot : m_NewSlots)
+		{
+			m_Slots[slot].State			= SlotState::RESIDENT;
+			m_Slots[slot].LastUsedFrame	= m_Frame;
+		}
+
+		m_Requests.clear();
+		const glm::vec2 cameraXZ(cameraPos.x, cameraPos.z);
+		for (uint32 level = 0; level < m_Header.NumLevels; level++)
+		{
+			const uint32 numTiles = CookedAssets::GetNumTerrainTiles(m_Header, level);
+			const float tileWorldSize = (float)(m_Header.TileSize << level) * m_Settings.SampleSpacing;
+			const bool isLastLevel = level + 1 == m_Header.NumLevels;
+			const float range = m_Settings.LodRange * (float)(1u << level) * m_Settings.PrefetchRatio;
+
+			// The tiles in the square around the range, the last level is always wanted as a fallback for every position.
+			auto GetFirst = [&](float position) { return isLastLevel ? 0 : (uint32)std::clamp(std::floor((position - range) / tileWorldSize), 0.f, (float)numTiles - 1.f); };
+			auto GetLast = [&](float position) { return isLastLevel ? numTiles - 1 : (uint32)std::clamp(std::floor((position + range) / tileWorldSize), 0.f, (float)numTiles - 1.f); };
+			for (uint32 z = GetFirst(cameraXZ.y); z <= GetLast(cameraXZ.y); z++)
+			{
+				for (uint32 x = GetFirst(cameraXZ.x); x <= GetLast(cameraXZ.x); x++)
+				{
+					const glm::vec2 tileMin = glm::vec2((float)x, (float)z) * tileWorldSize;
+					const glm::vec2 delta = glm::max(glm::max(tileMin - cameraXZ, cameraXZ - tileMin - tileWorldSize), glm::vec2(0.f));
+					const float distance = glm::length(delta);
+					if (!isLastLevel && distance > range)
+						continue;
+
+					m_Stats.NumWantedTiles++;
+					const uint64 key = GetKey(level, x, z);
+					auto it = m_TileSlots.find(key);
+					if (it != m_TileSlots.end())
+					{
+						Slot& slot = m_Slots[it->second];
+						slot.LastUsedFrame = m_Frame;
+						if (slot.State == SlotState::RESIDENT)
+							m_Stats.NumHits++;
+						else
+							m_Stats.NumMisses++;
+						continue;
+					}
+
+					// The distance in tiles of the level, such that the coarse tiles around the camera come before the fine tiles further away.
+					m_Stats.NumMisses++;
+					m_Requests.push_back({ key, distance / tileWorldSize });
+				}
+			}
+		}
+
+		// Only as many requests as there are slots can be loaded before the next update, the least important ones are dropped.
+		std::sort(m_Requests.begin(), m_Requests.end(), [](const Request& a, const Request& b) { return a.Priority > b.Priority; });
+		if (m_Requests.size() > m_Slots.size())
+			m_Requests.erase(m_Requests.begin(), m_Requests.end() - m_Slots.size());
+
+		m_Stats.NumResidentTiles	= (uint32)m_TileSlots.size();
+		m_Stats.NumPendingRequests	= (uint32)m_Requests.size();
+	}
+	m_RequestCondition.notify_one();
+}
+
+bool TerrainStreamer::FindTile(uint32 level, const glm::vec2& worldXZ, Tile& outTile)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	for (level = std::min(level, m_Header.NumLevels - 1); level < m_Header.NumLevels; level++)
+	{
+		const uint32 numTiles = CookedAssets::GetNumTerrainTiles(m_Header, level);
+		const float tileWorldSize = (float)(m_Header.TileSize << level) * m_Settings.SampleSpacing;
+		const uint32 x = (uint32)std::clamp(std::floor(worldXZ.x / tileWorldSize), 0.f, (float)numTiles - 1.f);
+		const uint32 z = (uint32)std::clamp(std::floor(worldXZ.y / tileWorldSize), 0.f, (float)numTiles - 1.f);
+
+		const uint64 key = GetKey(level, x, z);
+		auto it = m_TileSlots.find(key);
+		if (it != m_TileSlots.end() && m_Slots[it->second].State == SlotState::RESIDENT)
+		{
+			m_Slots[it->second].LastUsedFrame = m_Frame;
+			FillTile(key, it->second, outTile);
+			return true;
+		}
+	}
+	return false;
+}
+
+const std::vector<uint32>& TerrainStreamer::GetNewSlots() const
+{
+	return m_NewSlots;
+}
+
+const uint16* TerrainStreamer::GetSlotHeights(uint32 slot) const
+{
+	return (const uint16*)(m_SlotMemory.data() + slot * m_SlotBytes);
+}
+
+const uint8* TerrainStreamer::GetSlotSplat(uint32 slot) const
+{
+	return m_SlotMemory.data() + slot * m_SlotBytes + m_Header.SplatOffset;
+}
+
+const uint16* TerrainStreamer::GetLeafMinMax() const
+{
+	return (const uint16*)(m_View.pData + m_Header.MinMaxOffset);
+}
+
+bool TerrainStreamer::IsOpen() const
+{
+	return m_Thread.joinable();
+}
+
+const CookedAssets::TerrainHeader& TerrainStreamer::GetHeader() const
+{
+	return m_Header;
+}
+
+TerrainStreamer::Stats TerrainStreamer::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_Stats;
+}
+
+uint64 TerrainStreamer::GetKey(uint32 level, uint32 x, uint32 z)
+{
+	return ((uint64)level << 48) | ((uint64)z << 24) | (uint64)x;
+}
+
+void TerrainStreamer::Stream()
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	while (true)
+	{
+		m_RequestCondition.wait(lock, [this]() { return m_ShouldStop || !m_Requests.empty(); });
+		if (m_ShouldStop)
+			break;
+
+		const Request request = m_Requests.back();
+		m_Requests.pop_back();
+		if (m_TileSlots.contains(request.Key))
+			continue;
+
+		// Every slot holds a tile which is used in this frame, the next update requests the missing tiles again.
+		uint32 slotIndex = 0;
+		if (!FindFreeSlot(slotIndex))
+		{
+			m_Requests.clear();
+			continue;
+		}
+
+		Slot& slot = m_Slots[slotIndex];
+		if (slot.State == SlotState::RESIDENT)
+		{
+			m_TileSlots.erase(slot.Key);
+			m_Stats.NumEvictions++;
+		}
+		slot.Key	= request.Key;
+		slot.State	= SlotState::LOADING;
+		m_TileSlots[request.Key] = slotIndex;
+		lock.unlock();
+
+		// Reading the mapped file is where the pages of the tile are read from the disk.
+		Timer timer;
+		const uint32 level = (uint32)(request.Key >> 48), z = (uint32)(request.Key >> 24) & 0xFFFFFF, x = (uint32)request.Key & 0xFFFFFF;
+		memcpy(m_SlotMemory.data() + slotIndex * m_SlotBytes, m_View.pData + CookedAssets::GetTerrainTileOffset(m_Header, level, x, z), (size_t)m_SlotBytes);
+		const float loadTimeMS = timer.Stop().GetDeltaTimeMS();
+
+		lock.lock();
+		m_Slots[slotIndex].State = SlotState::LOADED;
+		m_LoadedSlots.push_back(slotIndex);
+		m_Stats.NumLoads++;
+		m_Stats.BytesLoaded += m_SlotBytes;
+		m_Stats.LoadTimeMS += loadTimeMS;
+	}
+}
+
+bool TerrainStreamer::FindFreeSlot(uint32& outSlot)
+{
+	// A free slot, or else the resident tile which was used the longest time ago and not in this frame.
+	uint64 oldestFrame = m_Frame;
+	bool hasFound = false;
+	for (uint32 i = 0; i < (uint32)m_Slots.size(); i++)
+	{
+		const Slot& slot = m_Slots[i];
+		if (slot.State == SlotState::FREE)
+		{
+			outSlot = i;
+			return true;
+		}
+		if (slot.State == SlotState::RESIDENT && slot.LastUsedFrame < oldestFrame)
+		{
+			oldestFrame = slot.LastUsedFrame;
+			outSlot = i;
+			hasFound = true;
+		}
+	}
+	return hasFound;
+}
+
+void TerrainStreamer::FillTile(uint64 key, uint32 slot, Tile& outTile) const
+{
+	outTile.Level		= (uint32)(key >> 48);
+	outTile.Z			= (uint32)(key >> 24) & 0xFFFFFF;
+	outTile.X			= (uint32)key & 0xFFFFFF;
+	outTile.Slot		= slot;
+	outTile.Spacing		= m_Settings.SampleSpacing * (float)(1u << outTile.Level);
+	outTile.Origin		= glm::vec2((float)outTile.X, (float)outTile.Z) * (float)m_Header.TileSize * outTile.Spacing;
+	outTile.pHeights	= GetSlotHeights(slot);
+	outTile.pSplat		= GetSlotSplat(slot);
+}
@@ -0,0 +1,163 @@
+#pragma once
+
+#include "Core/FileView.h"
+#include "Loaders/CookedAssets.h"
+#include "Utils/Maths.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace RS
+{
+	/*
+	* Streams the tiles of a cooked terrain (See CookedAssets::TerrainHeader) into a cache of a fixed number of slots, it does not use the device.
+	*	- Each frame the tiles of level k within LodRange * 2^k of the camera are wanted, the same distances as the LODs of TerrainQuadtree. The last level is always wanted.
+	*	- The missing tiles are requested by their distance in tiles of their level, so the coarse tiles and the tiles under the camera come first.
+	*	- A background thread copies the requested tiles from the mapped file into the slots, when the cache is full it takes the least recently used slot.
+	*	  Tiles which were used in the current frame are never taken, the request waits until a slot is free.
+	*	- The memory of the slots is allocated when the terrain is opened and never grows.
+	* Example:
+	*	streamer.Open(CookedAssets::GetCookedTerrainPath("Terrains/Valley.r16"), settings);
+	*	streamer.Update(camera.GetPos());
+	*	for (uint32 slot : streamer.GetNewSlots()) ... upload streamer.GetSlotHeights(slot) ...
+	*	TerrainStreamer::Tile tile;
+	*	if (streamer.FindTile(patch.Lod, patchCenter, tile)) ... draw the patch with tile.Slot ...
+	*/
+	class TerrainStreamer
+	{
+	public:
+		struct Settings
+		{
+			uint32	NumSlots		= 64;
+			float	SampleSpacing	= 1.f;	// World units between two samples of level 0.
+			float	LodRange		= 96.f;	// World distance where the tiles of level 0 are wanted, each level reaches twice as far as the one before.
+			float	PrefetchRatio	= 1.25f; // Scales the distances, such that the tiles are loaded before their LOD is reached.
+		};
+
+		struct Tile
+		{
+			uint32			Level		= 0;
+			uint32			X			= 0;
+			uint32			Z			= 0;
+			uint32			Slot		= 0;
+			glm::vec2		Origin		= glm::vec2(0.f); // World xz of the first sample, without the apron.
+			float			Spacing		= 0.f; // World units between two samples of the tile.
+			const uint16*	pHeights	= nullptr; // (TileSize + 3)^2, starting with the apron sample before the origin.
+			const uint8*	pSplat		= nullptr; // (TileSize + 1)^2 RGBA8, starting at the origin.
+		};
+
+		struct Stats
+		{
+			uint32	NumSlots				= 0;
+			uint32	NumResidentTiles		= 0;
+			uint32	NumPendingRequests		= 0;
+			uint64	CacheBytes				= 0;
+			uint64	NumWantedTiles			= 0; // Summed over the frames, each is either a hit or a miss.
+			uint64	NumHits					= 0;
+			uint64	NumMisses				= 0;
+			uint64	NumLoads				= 0;
+			uint64	NumEvictions			= 0;
+			uint64	BytesLoaded				= 0;
+			float	LoadTimeMS				= 0.f; // Time the streaming thread spent reading tiles.
+		};
+
+	public:
+		RS_NO_COPY_AND_MOVE(TerrainStreamer);
+		TerrainStreamer() = default;
+		~TerrainStreamer();
+
+		/*
+		* Open a cooked terrain through the VirtualFileSystem, allocate the slots and start the streaming thread.
+		*/
+		bool Open(const std::string& path, const Settings& settings);
+
+		/*
+		* The same as above with a view which is already open, the view is kept until Close.
+		*/
+		bool Open(FileView view, const Settings& settings);
+		void Close();
+
+		/*
+		* Follow a change of TerrainQuadtree::Settings::Lod0Range, it is used from the next Update.
+		*/
+		void SetLodRange(float lodRange);
+
+		/*
+		* Call this once each frame from the main thread, before FindTile and GetNewSlots.
+		* Marks the wanted tiles around the camera as used, requests the missing ones and hands out the tiles which were loaded since the last update.
+		*/
+		void Update(const glm::vec3& cameraPos);
+
+		/*
+		* The resident tile of the finest level, starting at level, which holds the world position. It is marked as used in this frame.
+		* The data of a tile which is used in this frame stays valid until the next Update.
+		* Returns false if not even the tile of the last level is resident yet.
+		*/
+		bool FindTile(uint32 level, const glm::vec2& worldXZ, Tile& outTile);
+
+		/*
+		* The slots which received a tile in the last Update, their data should be uploaded before the next Update.
+		*/
+		const std::vector<uint32>& GetNewSlots() const;
+		const uint16* GetSlotHeights(uint32 slot) const;
+		const uint8* GetSlotSplat(uint32 slot) const;
+
+		/*
+		* The lowest and highest height of each leaf of the terrain, for TerrainQuadtree::Build.
+		*/
+		const uint16* GetLeafMinMax() const;
+
+		bool IsOpen() const;
+		const CookedAssets::TerrainHeader& GetHeader() const;
+		Stats GetStats() const;
+
+	private:
+		enum class SlotState : uint32
+		{
+			FREE = 0,
+			LOADING,	// The streaming thread is copying into it.
+			LOADED,		// Handed out in the next Update.
+			RESIDENT
+		};
+
+		struct Slot
+		{
+			uint64		Key				= 0;
+			uint64		LastUsedFrame	= 0;
+			SlotState	State			= SlotState::FREE;
+		};
+
+		struct Request
+		{
+			uint64	Key			= 0;
+			float	Priority	= 0.f; // Lower is more important.
+		};
+
+		static uint64 GetKey(uint32 level, uint32 x, uint32 z);
+		void Stream();
+		bool FindFreeSlot(uint32& outSlot); // Expects the mutex to be locked.
+		void FillTile(uint64 key, uint32 slot, Tile& outTile) const;
+
+	private:
+		FileView							m_View;
+		CookedAssets::TerrainHeader			m_Header;
+		Settings							m_Settings;
+		uint64								m_SlotBytes			= 0;
+		std::vector<uint8>					m_SlotMemory;
+
+		mutable std::mutex					m_Mutex;
+		std::condition_variable				m_RequestCondition;
+		std::thread							m_Thread;
+		bool								m_ShouldStop		= false;
+		uint64								m_Frame				= 0;
+		std::vector<Slot>					m_Slots;
+		std::unordered_map<uint64, uint32>	m_TileSlots;		// Tiles which are in a slot, in any state but FREE.
+		std::vector<Request>				m_Requests;			// The most important one is last.
+		std::vector<uint32>					m_LoadedSlots;
+		std::vector<uint32>					m_NewSlots;
+		Stats								m_Stats;
+	};
+}
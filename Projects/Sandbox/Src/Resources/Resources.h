@@ -2,6 +2,7 @@
 
 #include "Renderer/RenderAPI.h"
 #include "Resources/RefObject.h"
+#include "Core/ResourceManagerDefines.h"
 
 #include "Utils/Maths.h"
 #include "Structures/AABB.h"
@@ -31,6 +32,11 @@ namespace RS
 
 		Type		type;
 		ResourceID	key = NULL_RESOURCE;
+
+		// Memory footprint of the data owned by this resource (Not the resources it points to).
+		// This is updated by the ResourceManager, the GPU size is an estimate and does not include driver padding.
+		uint64		CPUBytes = 0;
+		uint64		GPUBytes = 0;
 	};
 
 	struct ImageResource : public Resource
@@ -39,6 +45,12 @@ namespace RS
 		uint32				Width	= 0;
 		uint32				Height	= 0;
 		DXGI_FORMAT			Format	= DXGI_FORMAT_UNKNOWN;
+
+		// Residency (See ImageResidency). Width, Height and Format are kept when the data is evicted.
+		bool				IsResident		= true;
+		bool				IsReloadable	= false;	// Only images loaded from a file can be reloaded.
+		ImageLoadDesc		Source;						// The description used to reload the data, without the memory pointer.
+		uint32				PinCount		= 0;		// The budget does not evict pinned images, the ResourceManager pins them while they are uploaded.
 	};
 
 	struct TextureResource : public Resource
@@ -3,6 +3,7 @@
 
 #include "Renderer/ShaderHotReloader.h"
 #include "Renderer/Renderer.h"
+#include "Renderer/StateCache.h"
 #include "Renderer/DebugRenderer.h"
 #include "Renderer/ImGuiRenderer.h"
 #include "Core/Display.h"
@@ -146,6 +147,7 @@ void RS::HatchingScene::Tick(float dt)
 	auto renderer = Renderer::Get();
 	auto renderAPI = RenderAPI::Get();
 	ID3D11DeviceContext* pContext = renderAPI->GetDeviceContext();
+	std::shared_ptr<StateCache> stateCache = StateCache::Get();
 	renderer->BeginScene(1.0f, 1.0f, 1.0f, 1.0f);
 
 	m_HatchingShader.Bind();
@@ -182,11 +184,11 @@ void RS::HatchingScene::Tick(float dt)
 	// Draw assimp model
 	{
 		glm::mat4 transform = glm::translate(glm::vec3(0.f, 1.f, 0.f)) * glm::scale(glm::vec3(2.f)) * glm::rotate(glm::pi<float>(), glm::vec3(0.f, 1.f, 0.f));
-		pContext->VSSetConstantBuffers(1, 1, &m_pConstantBufferFrame);
-		pContext->PSSetConstantBuffers(1, 1, &m_pConstantBufferCamera);
+		stateCache->SetConstantBuffers(ShaderTypeFlag::VERTEX, 1, 1, &m_pConstantBufferFrame);
+		stateCache->SetConstantBuffers(ShaderTypeFlag::FRAGMENT, 1, 1, &m_pConstantBufferCamera);
 		// Begin fs at slot 6!
 		for(uint32 i = 0; i < s_NumHatches; i++)
-			pContext->PSSetShaderResources(6+i, 1, &m_pHatches[i]->pTextureSRV);
+			stateCache->SetShaderResources(ShaderTypeFlag::FRAGMENT, 6+i, 1, &m_pHatches[i]->pTextureSRV);
 		Renderer::DebugInfo debugInfo = {};
 		debugInfo.DrawAABBs = false;
 		static uint32 debugInfoID = DebugRenderer::Get()->GenID();
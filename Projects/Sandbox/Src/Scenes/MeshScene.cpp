@@ -3,6 +3,7 @@
 
 #include "Renderer/ShaderHotReloader.h"
 #include "Renderer/Renderer.h"
+#include "Renderer/StateCache.h"
 #include "Renderer/DebugRenderer.h"
 #include "Renderer/ImGuiRenderer.h"
 #include "Core/Display.h"
@@ -185,6 +186,7 @@ void MeshScene::Tick(float dt)
 	auto renderer = Renderer::Get();
 	auto renderAPI = RenderAPI::Get();
 	ID3D11DeviceContext* pContext = renderAPI->GetDeviceContext();
+	std::shared_ptr<StateCache> stateCache = StateCache::Get();
 	renderer->BeginScene(0.2f, 0.2f, 0.2f, 1.0f);
 
 	DebugRenderer::Get()->PushPoint(glm::vec3(0.f, 0.6f, 0.f), Color(1.0f, 0.2f, 0.2f));
@@ -232,20 +234,20 @@ void MeshScene::Tick(float dt)
 
 	UINT stride = sizeof(MeshObject::Vertex);
 	UINT offset = 0;
-	pContext->IASetVertexBuffers(0, 1, &m_pVertexBuffer, &stride, &offset);
-	pContext->IASetIndexBuffer(m_pIndexBuffer, DXGI_FORMAT_R32_UINT, 0);
-	pContext->VSSetConstantBuffers(0, 1, &m_pConstantBufferMesh);
-	pContext->VSSetConstantBuffers(1, 1, &m_pConstantBufferFrame);
-	pContext->PSSetShaderResources(0, 1, &pAlbedoTexture->pTextureSRV);
-	pContext->PSSetShaderResources(1, 1, &pNormalTexture->pTextureSRV);
-	pContext->PSSetSamplers(0, 1, &pSampler->pSampler);
-	pContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-	pContext->DrawIndexed((UINT)m_pModel->Meshes[0].Indices.size(), 0, 0);
+	stateCache->SetVertexBuffers(0, 1, &m_pVertexBuffer, &stride, &offset);
+	stateCache->SetIndexBuffer(m_pIndexBuffer, DXGI_FORMAT_R32_UINT, 0);
+	stateCache->SetConstantBuffers(ShaderTypeFlag::VERTEX, 0, 1, &m_pConstantBufferMesh);
+	stateCache->SetConstantBuffers(ShaderTypeFlag::VERTEX, 1, 1, &m_pConstantBufferFrame);
+	stateCache->SetShaderResources(ShaderTypeFlag::FRAGMENT, 0, 1, &pAlbedoTexture->pTextureSRV);
+	stateCache->SetShaderResources(ShaderTypeFlag::FRAGMENT, 1, 1, &pNormalTexture->pTextureSRV);
+	stateCache->SetSamplers(ShaderTypeFlag::FRAGMENT, 0, 1, &pSampler->pSampler);
+	stateCache->SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	stateCache->DrawIndexed((UINT)m_pModel->Meshes[0].Indices.size(), 0, 0);
 
 	// Draw assimp model
 	{
 		glm::mat4 transform = glm::translate(glm::vec3(1.5f, 0.f, 0.f)) * glm::scale(glm::vec3(0.01f));
-		pContext->VSSetConstantBuffers(1, 1, &m_pConstantBufferFrame);
+		stateCache->SetConstantBuffers(ShaderTypeFlag::VERTEX, 1, 1, &m_pConstantBufferFrame);
 		Renderer::DebugInfo debugInfo = {};
 		debugInfo.DrawAABBs = true;
 		static uint32 debugInfoID = DebugRenderer::Get()->GenID();
@@ -256,7 +258,7 @@ void MeshScene::Tick(float dt)
 	// Draw assimp model
 	{
 		glm::mat4 transform = glm::translate(glm::vec3(-1.5f, 0.f, 0.f)) * glm::scale(glm::vec3(0.005f));
-		pContext->VSSetConstantBuffers(1, 1, &m_pConstantBufferFrame);
+		stateCache->SetConstantBuffers(ShaderTypeFlag::VERTEX, 1, 1, &m_pConstantBufferFrame);
 		Renderer::DebugInfo debugInfo = {};
 		debugInfo.DrawAABBs = true;
 		static uint32 debugInfoID = DebugRenderer::Get()->GenID();
@@ -2,16 +2,21 @@
 #include "PBRScene.h"
 
 #include "Renderer/ShaderHotReloader.h"
+#include "Renderer/ShaderBatch.h"
 #include "Renderer/Renderer.h"
+#include "Renderer/StateCache.h"
 #include "Renderer/DebugRenderer.h"
 #include "Renderer/ImGuiRenderer.h"
 #include "Core/Display.h"
 #include "Core/Input.h"
 
+#include "Utils/Config.h"
 #include "Utils/Maths.h"
 
 #include "Scenes/CameraUtils.h"
 
+#include <random>
+
 using namespace RS;
 
 PBRScene::PBRScene() : Scene("PBR Scene")
@@ -26,6 +31,7 @@ void PBRScene::Start()
 	float nearPlane = 0.01f, farPlane = 100.f;
 	m_Camera.Init(camPos, camDir, glm::vec3{ 0.f, 1.f, 0.f }, nearPlane, farPlane, fov);
 
+	ShaderBatch shaderBatch;
 	{
 		AttributeLayout layout;
 		layout.Push(DXGI_FORMAT_R32G32B32_FLOAT, "POSITION", 0);
@@ -36,8 +42,7 @@ void PBRScene::Start()
 		Shader::Descriptor shaderDesc = {};
 		shaderDesc.Vertex = "PBRScene/PBRVert.hlsl";
 		shaderDesc.Fragment = "PBRScene/PBRFrag.hlsl";
-		m_Shader.Load(shaderDesc, layout);
-		ShaderHotReloader::AddShader(&m_Shader);
+		m_ShaderPermutations.Init(shaderDesc, layout, MATERIAL_KEYWORD_NAMES);
 	}
 
 	{
@@ -50,10 +55,16 @@ void PBRScene::Start()
 		Shader::Descriptor shaderDesc = {};
 		shaderDesc.Vertex = "Utils/SkyboxVert.hlsl";
 		shaderDesc.Fragment = "Utils/SkyboxGammaCorrectionFrag.hlsl";
-		m_SkyboxShader.Load(shaderDesc, layout);
-		ShaderHotReloader::AddShader(&m_SkyboxShader);
+		shaderBatch.Add(&m_SkyboxShader, shaderDesc, layout);
 	}
 
+	shaderBatch.Load();
+	ShaderHotReloader::AddShader(&m_SkyboxShader);
+
+	// The default render mode uses both IBL terms, the debug variants are compiled when they are selected.
+	const ShaderKeywordMask iblKeywords = MATERIAL_KEYWORD_DIFFUSE_IBL | MATERIAL_KEYWORD_SPECULAR_IBL;
+	m_ShaderPermutations.Precompile({ iblKeywords, iblKeywords | MATERIAL_KEYWORD_COMBINED_METALLIC_ROUGHNESS });
+
 	// Load a model with assimp.
 	{
 		ModelLoadDesc modelLoadDesc = {};
@@ -90,6 +101,7 @@ void PBRScene::Start()
 	}
 
 	RS_ASSERT(m_pModel != nullptr, "Could not load model!");
+	m_ModelTransform = glm::translate(glm::vec3(0.f, 1.f, 0.f)) * glm::scale(glm::vec3(2.f)) * glm::rotate(glm::pi<float>(), glm::vec3(0.f, 1.f, 0.f));
 
 	{
 		D3D11_BUFFER_DESC bufferDesc = {};
@@ -121,6 +133,13 @@ void PBRScene::Start()
 
 	m_Pipeline.Init();
 
+	m_DeferredRenderer.Init();
+	m_NumClusteredLights = Config::Get()->Fetch<int32>("Renderer/ClusteredLights", 256);
+	CreateClusteredLights((uint32)m_NumClusteredLights);
+
+	m_ShadowMap.Init();
+	m_ShadowMap.AddCaster(*m_pModel, m_ModelTransform);
+
 	D3D11_RASTERIZER_DESC rasterizerDesc = {};
 	rasterizerDesc.AntialiasedLineEnable = false;
 	rasterizerDesc.CullMode = D3D11_CULL_BACK;
@@ -150,8 +169,10 @@ void PBRScene::Unselected()
 void PBRScene::End()
 {
 	m_Pipeline.Release();
+	m_DeferredRenderer.Release();
+	m_ShadowMap.Release();
 
-	m_Shader.Release();
+	m_ShaderPermutations.Release();
 	m_SkyboxShader.Release();
 	m_pConstantBufferFrame->Release();
 	m_pConstantBufferCamera->Release();
@@ -170,16 +191,18 @@ void PBRScene::Tick(float dt)
 	//CameraUtils::UpdateOrbitCamera(m_Camera);
 	DebugRenderer::Get()->UpdateCamera(m_Camera.GetView(), m_Camera.GetProj());
 
+	auto display = Display::Get();
+	m_ShadowMap.Render(m_Camera.GetView(), m_Camera.GetProj(), m_Camera.GetNearPlane(), m_Camera.GetFarPlane(), m_SunDirection, m_SunIntensity);
+
 	m_Pipeline.Bind(BindType::BOTH);
+	m_Pipeline.SetViewport(0.f, 0.f, (float)display->GetWidth(), (float)display->GetHeight());
 
-	auto display = Display::Get();
 	auto renderer = Renderer::Get();
 	auto renderAPI = RenderAPI::Get();
 	ID3D11DeviceContext* pContext = renderAPI->GetDeviceContext();
+	std::shared_ptr<StateCache> stateCache = StateCache::Get();
 	renderer->BeginScene(0.2f, 0.2f, 0.2f, 1.0f);
 
-	m_Shader.Bind();
-
 	// Update data
 	{
 		m_FrameData.view = m_Camera.GetView();
@@ -207,23 +230,26 @@ void PBRScene::Tick(float dt)
 			memcpy(data, &m_CameraData, sizeof(CameraData));
 			pContext->Unmap(m_pConstantBufferCamera, 0);
 		}
+
+		m_DeferredRenderer.Update(m_Camera.GetView(), m_Camera.GetProj(), m_Camera.GetNearPlane(), m_Camera.GetFarPlane(), display->GetWidth(), display->GetHeight());
 	}
 
 	// Draw assimp model
 	{
-		glm::mat4 transform = glm::translate(glm::vec3(0.f, 1.f, 0.f)) * glm::scale(glm::vec3(2.f)) * glm::rotate(glm::pi<float>(), glm::vec3(0.f, 1.f, 0.f));
-		pContext->VSSetConstantBuffers(1, 1, &m_pConstantBufferFrame);
-		pContext->PSSetConstantBuffers(1, 1, &m_pConstantBufferCamera);
-		pContext->PSSetShaderResources(6, 1, &m_pIrradianceMap->pTextureSRV);
-		pContext->PSSetShaderResources(7, 1, &m_pPreFilteredEnvMap->pTextureSRV);
-		pContext->PSSetShaderResources(8, 1, &m_pPreComputedBRDF->pTextureSRV);
+		stateCache->SetConstantBuffers(ShaderTypeFlag::VERTEX, 1, 1, &m_pConstantBufferFrame);
+		stateCache->SetConstantBuffers(ShaderTypeFlag::FRAGMENT, 1, 1, &m_pConstantBufferCamera);
+		stateCache->SetShaderResources(ShaderTypeFlag::FRAGMENT, 6, 1, &m_pIrradianceMap->pTextureSRV);
+		stateCache->SetShaderResources(ShaderTypeFlag::FRAGMENT, 7, 1, &m_pPreFilteredEnvMap->pTextureSRV);
+		stateCache->SetShaderResources(ShaderTypeFlag::FRAGMENT, 8, 1, &m_pPreComputedBRDF->pTextureSRV);
+		m_DeferredRenderer.Bind(ShaderTypeFlag::FRAGMENT, 2, 9);
+		m_ShadowMap.Bind(ShaderTypeFlag::FRAGMENT, 3, 12, 1);
 		Renderer::DebugInfo debugInfo = {};
 		debugInfo.DrawAABBs = false;
 		static uint32 debugInfoID = DebugRenderer::Get()->GenID();
 		debugInfo.ID = debugInfoID;
 		debugInfo.RenderMode = (uint32)m_RenderMode;
 		debugInfo.PreFilterMaxLOD = m_PreFilterMaxLOD;
-		renderer->RenderWithMaterial(*m_pModel, transform, debugInfo);
+		renderer->RenderWithMaterial(*m_pModel, m_ModelTransform, debugInfo, &m_ShaderPermutations);
 	}
 
 	// Draw skybox
@@ -240,9 +266,9 @@ void PBRScene::Tick(float dt)
 		pContext->Unmap(m_pConstantBufferSkybox, 0);
 
 		SamplerResource* pSampler = ResourceManager::Get()->GetResource<SamplerResource>(ResourceManager::Get()->DefaultSamplerLinear);
-		pContext->VSSetConstantBuffers(1, 1, &m_pConstantBufferSkybox);
-		pContext->PSSetShaderResources(0, 1, &m_pCubemap->pTextureSRV);
-		pContext->PSSetSamplers(0, 1, &pSampler->pSampler);
+		stateCache->SetConstantBuffers(ShaderTypeFlag::VERTEX, 1, 1, &m_pConstantBufferSkybox);
+		stateCache->SetShaderResources(ShaderTypeFlag::FRAGMENT, 0, 1, &m_pCubemap->pTextureSRV);
+		stateCache->SetSamplers(ShaderTypeFlag::FRAGMENT, 0, 1, &pSampler->pSampler);
 
 		glm::mat4 transform(1.f);
 		Renderer::DebugInfo debugInfo = {};
@@ -283,7 +309,64 @@ void PBRScene::DrawImGui()
 			}
 
 			m_RenderMode = renderMode | iblFlag;
+
+			if (ImGui::TreeNode("Shader variants"))
+			{
+				const ShaderPermutations::Stats& stats = m_ShaderPermutations.GetStats();
+				ImGui::Text("Compiled: %u", stats.NumVariants);
+				ImGui::Text("Failed: %u", stats.NumFailed);
+				ImGui::Text("Rejected: %u", stats.NumRejected);
+				ImGui::Text("Compile time: %.1f ms", stats.CompileTimeMS);
+				ImGui::TreePop();
+			}
+
+			if (ImGui::TreeNode("Clustered lights"))
+			{
+				if (ImGui::SliderInt("Lights", &m_NumClusteredLights, 0, 10000))
+					CreateClusteredLights((uint32)m_NumClusteredLights);
+
+				const LightClusters::Stats& stats = m_DeferredRenderer.GetClusters().GetStats();
+				ImGui::Text("Visible: %u", stats.NumVisibleLights);
+				ImGui::Text("Indices: %u (at most %u in a cluster)", stats.NumIndices, stats.MaxLightsPerCluster);
+				ImGui::Text("Binning: %.3f ms on %u threads", stats.BuildTimeMS, stats.NumThreads);
+				ImGui::TreePop();
+			}
+
+			if (ImGui::TreeNode("Shadows"))
+			{
+				if (ImGui::SliderFloat3("Sun direction", &m_SunDirection.x, -1.f, 1.f) && glm::length(m_SunDirection) > 0.001f)
+					m_SunDirection = glm::normalize(m_SunDirection);
+				ImGui::SliderFloat("Sun intensity", &m_SunIntensity, 0.f, 10.f);
+
+				ImGui::Text("Casters: %u", m_ShadowMap.GetNumCasters());
+				const ShadowCascades& cascades = m_ShadowMap.GetCascades();
+				for (uint32 i = 0; i < cascades.GetNumCascades(); i++)
+				{
+					const ShadowCascades::Cascade& cascade = cascades.GetCascade(i);
+					ImGui::Text("Cascade %u: %.2f - %.2f, %u casters, %u culled", i, cascade.NearSplit, cascade.FarSplit, (uint32)cascade.Casters.size(), cascade.NumCulled);
+				}
+				ImGui::TreePop();
+			}
 		}
 		ImGui::End();
 	});
 }
+
+void PBRScene::CreateClusteredLights(uint32 numLights)
+{
+	std::mt19937 generator(42);
+	std::uniform_real_distribution<float> unit(0.f, 1.f);
+	std::vector<LightClusters::Light> lights(numLights);
+	for (LightClusters::Light& light : lights)
+	{
+		light.Position		= glm::vec3(unit(generator) * 6.f - 3.f, unit(generator) * 3.f, unit(generator) * 6.f - 3.f);
+		light.Range			= 0.5f + unit(generator);
+		light.Color			= glm::vec3(unit(generator), unit(generator), unit(generator));
+		light.Intensity		= 0.5f;
+		light.Type			= unit(generator) < 0.5f ? LightClusters::LightType::POINT : LightClusters::LightType::SPOT;
+		light.Direction		= glm::normalize(glm::vec3(0.f, 1.f, 0.f) - light.Position + glm::vec3(0.f, 0.f, 0.001f));
+		light.CosOuterAngle	= glm::cos(0.5f);
+		light.CosInnerAngle	= glm::cos(0.3f);
+	}
+	m_DeferredRenderer.SetLights(lights);
+}
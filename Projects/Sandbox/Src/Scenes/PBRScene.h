@@ -4,11 +4,14 @@
 
 #include "Loaders/ModelLoader.h"
 #include "Renderer/Shader.h"
+#include "Renderer/ShaderPermutations.h"
 #include "Utils/Maths.h"
 
 #include "Scenes/Camera.h"
 
 #include "Renderer/Pipeline.h"
+#include "Renderer/DeferredRenderer.h"
+#include "Renderer/CascadedShadowMap.h"
 #include "Resources/Resources.h"
 
 namespace RS
@@ -54,8 +57,13 @@ namespace RS
 	private:
 		void DrawImGui();
 
+		/*
+		* Place random point and spot lights around the model, with a fixed seed.
+		*/
+		void CreateClusteredLights(uint32 numLights);
+
 	private:
-		Shader				m_Shader;
+		ShaderPermutations	m_ShaderPermutations;
 		Shader				m_SkyboxShader;
 
 		ID3D11Buffer*		m_pConstantBufferFrame = nullptr;
@@ -73,6 +81,14 @@ namespace RS
 
 		Pipeline			m_Pipeline;
 
+		DeferredRenderer	m_DeferredRenderer;
+		int32				m_NumClusteredLights	= 0;
+
+		CascadedShadowMap	m_ShadowMap;
+		glm::vec3			m_SunDirection			= glm::normalize(glm::vec3(-1.f, -2.f, -0.5f));
+		float				m_SunIntensity			= 2.f;
+		glm::mat4			m_ModelTransform		= glm::mat4(1.f);
+
 		// IBL textures
 		uint32				m_PreFilterMaxLOD		= 0;
 		TextureResource*	m_pPreComputedBRDF		= nullptr;
@@ -1,6 +1,19 @@
 #include "PreCompiled.h"
 #include "TerrainScene.h"
 
+#include "Renderer/DebugRenderer.h"
+#include "Renderer/ShaderHotReloader.h"
+#include "Renderer/ShaderBatch.h"
+#include "Renderer/Renderer.h"
+#include "Renderer/StateCache.h"
+#include "Renderer/ImGuiRenderer.h"
+
+#include "Loaders/CookedAssets.h"
+
+#include "Utils/Config.h"
+
+#include "Scenes/CameraUtils.h"
+
 using namespace RS;
 
 TerrainScene::TerrainScene() : Scene("TerrainScene")
@@ -9,6 +22,56 @@ TerrainScene::TerrainScene() : Scene("TerrainScene")
 
 void TerrainScene::Start()
 {
+	Config* config = Config::Get();
+	m_HeightmapSize				= config->Fetch<uint32>("Terrain/HeightmapSize", 2048);
+	m_Settings.LeafSize			= config->Fetch<uint32>("Terrain/LeafSize", 32);
+	m_Settings.NumLods			= config->Fetch<uint32>("Terrain/NumLods", 6);
+	m_Settings.SampleSpacing	= config->Fetch<float>("Terrain/SampleSpacing", 0.02f);
+	m_Settings.HeightScale		= config->Fetch<float>("Terrain/HeightScale", 4.f);
+	OpenTerrain();
+
+	const float terrainSize = m_HeightmapSize * m_Settings.SampleSpacing;
+	glm::vec3 camPos(terrainSize * 0.5f, m_Settings.HeightScale * 1.2f, terrainSize * 0.75f);
+	glm::vec3 camDir = glm::normalize(glm::vec3(0.f, -0.3f, -1.f));
+	constexpr float fov = glm::pi<float>() / 4.f;
+	float nearPlane = 0.01f, farPlane = terrainSize * 2.f;
+	m_Camera.Init(camPos, camDir, glm::vec3{ 0.f, 1.f, 0.f }, nearPlane, farPlane, fov);
+
+	ShaderBatch shaderBatch;
+	AttributeLayout layout;
+	layout.Push(DXGI_FORMAT_R32G32_FLOAT, "POSITION", 0);
+	{
+		Shader::Descriptor shaderDesc = {};
+		shaderDesc.Vertex = "TerrainScene/TerrainVert.hlsl";
+		shaderDesc.Fragment = "TerrainScene/TerrainFrag.hlsl";
+		shaderBatch.Add(&m_Shader, shaderDesc, layout);
+	}
+	shaderBatch.Load();
+	ShaderHotReloader::AddShader(&m_Shader);
+
+	CreateTileTextures();
+	CreatePatchMesh();
+
+	{
+		D3D11_BUFFER_DESC bufferDesc = {};
+		bufferDesc.ByteWidth = sizeof(FrameData);
+		bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+		bufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+		bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+		bufferDesc.MiscFlags = 0;
+		bufferDesc.StructureByteStride = 0;
+
+		D3D11_SUBRESOURCE_DATA data;
+		data.pSysMem = &m_FrameData;
+		data.SysMemPitch = 0;
+		data.SysMemSlicePitch = 0;
+
+		HRESULT result = RenderAPI::Get()->GetDevice()->CreateBuffer(&bufferDesc, &data, &m_pConstantBuffer);
+		RS_D311_ASSERT_CHECK(result, "Failed to create terrain constant buffer!");
+	}
+
+	m_Pipeline.Init();
+	SetWireframe(m_IsWireframeEnabled);
 }
 
 void TerrainScene::Selected()
@@ -21,6 +84,27 @@ void TerrainScene::Unselected()
 
 void TerrainScene::End()
 {
+	m_Pipeline.Release();
+	m_Streamer.Close();
+
+	m_Shader.Release();
+	m_pVertexBuffer->Release();
+	m_pIndexBuffer->Release();
+	m_pConstantBuffer->Release();
+	if (m_pPatchBuffer)
+	{
+		m_pPatchBuffer->Release();
+		m_pPatchBufferSRV->Release();
+	}
+
+	if (m_pHeightTiles)
+	{
+		m_pHeightTiles->Release();
+		m_pHeightTilesSRV->Release();
+		m_pSplatTiles->Release();
+		m_pSplatTilesSRV->Release();
+	}
+	m_pSampler->Release();
 }
 
 void TerrainScene::FixedTick()
@@ -29,5 +113,385 @@ void TerrainScene::FixedTick()
 
 void TerrainScene::Tick(float dt)
 {
-	RS_UNREFERENCED_VARIABLE(dt);
+	DrawImGui();
+
+	CameraUtils::UpdateFPSCamera(dt, m_Camera);
+	DebugRenderer::Get()->UpdateCamera(m_Camera.GetView(), m_Camera.GetProj());
+
+	// The tiles are streamed around the camera even when the selection is frozen, such that the cache can be watched while moving.
+	m_Streamer.Update(m_Camera.GetPos());
+	UploadNewTiles();
+
+	const glm::mat4 viewProj = m_Camera.GetProj() * m_Camera.GetView();
+	if (!m_IsSelectionFrozen)
+		m_Quadtree.Select(m_Camera.GetPos(), viewProj);
+
+	const std::vector<TerrainQuadtree::Patch>& patches = m_Quadtree.GetPatches();
+	if (m_ShowPatchBounds)
+	{
+		std::vector<AABB> bounds(patches.size());
+		for (size_t i = 0; i < patches.size(); i++)
+			bounds[i] = m_Quadtree.GetPatchBounds(patches[i]);
+		DebugRenderer::Get()->PushBoxes(bounds, Color::GREEN, 0, true, DebugRenderer::LIFETIME_ONE_FRAME);
+	}
+
+	UpdatePatchBuffer();
+
+	m_Pipeline.Bind(BindType::BOTH);
+
+	auto renderer = Renderer::Get();
+	ID3D11DeviceContext* pContext = RenderAPI::Get()->GetDeviceContext();
+	std::shared_ptr<StateCache> stateCache = StateCache::Get();
+	renderer->BeginScene(0.55f, 0.7f, 0.9f, 1.0f);
+
+	// Update data
+	{
+		m_FrameData.viewProj	= viewProj;
+		m_FrameData.cameraPos	= glm::vec4(m_Camera.GetPos(), 1.f);
+		m_FrameData.info		= glm::vec4(m_Settings.SampleSpacing, m_Settings.HeightScale, (float)m_Streamer.GetHeader().TileSize, (float)m_Quadtree.GetMeshSize());
+		m_FrameData.debug		= glm::vec4(m_ShowLods ? 1.f : 0.f, 0.f, 0.f, 0.f);
+		for (uint32 lod = 0; lod < m_Quadtree.GetNumLods(); lod++)
+			m_FrameData.morphRanges[lod] = glm::vec4(m_Quadtree.GetMorphRange(lod), 0.f, 0.f);
+
+		D3D11_MAPPED_SUBRESOURCE mappedResource;
+		HRESULT result = pContext->Map(m_pConstantBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+		RS_D311_ASSERT_CHECK(result, "Failed to map terrain constant buffer!");
+		memcpy(mappedResource.pData, &m_FrameData, sizeof(FrameData));
+		pContext->Unmap(m_pConstantBuffer, 0);
+	}
+
+	if (m_PatchData.empty())
+		return;
+
+	// Every patch is an instance of the same grid.
+	m_Shader.Bind();
+	UINT stride = sizeof(Vertex);
+	UINT offset = 0;
+	stateCache->SetVertexBuffers(0, 1, &m_pVertexBuffer, &stride, &offset);
+	stateCache->SetIndexBuffer(m_pIndexBuffer, DXGI_FORMAT_R32_UINT, 0);
+	stateCache->SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	stateCache->SetConstantBuffers(ShaderTypeFlag::VERTEX, 0, 1, &m_pConstantBuffer);
+	stateCache->SetShaderResources(ShaderTypeFlag::VERTEX, 0, 1, &m_pPatchBufferSRV);
+	stateCache->SetShaderResources(ShaderTypeFlag::VERTEX, 1, 1, &m_pHeightTilesSRV);
+	stateCache->SetSamplers(ShaderTypeFlag::VERTEX, 0, 1, &m_pSampler);
+	stateCache->SetConstantBuffers(ShaderTypeFlag::FRAGMENT, 0, 1, &m_pConstantBuffer);
+	stateCache->SetShaderResources(ShaderTypeFlag::FRAGMENT, 1, 1, &m_pHeightTilesSRV);
+	stateCache->SetShaderResources(ShaderTypeFlag::FRAGMENT, 2, 1, &m_pSplatTilesSRV);
+	stateCache->SetSamplers(ShaderTypeFlag::FRAGMENT, 0, 1, &m_pSampler);
+	stateCache->DrawIndexedInstanced(m_NumIndices, (uint32)m_PatchData.size(), 0, 0, 0);
+}
+
+void TerrainScene::CreateHeightmap()
+{
+	Config* config = Config::Get();
+	TerrainGenerator::Settings generatorSettings;
+	generatorSettings.Seed					= config->Fetch<uint32>("Terrain/Seed", 1337);
+	generatorSettings.NumErosionIterations	= config->Fetch<uint32>("Terrain/ErosionIterations", 24);
+	m_Generator.Generate(m_HeightmapSize, generatorSettings, m_Heights);
+
+	// The splat weights follow the slopes of the normals of the world heights.
+	std::vector<uint8> normals;
+	TerrainGenerator::ComputeNormals(m_Heights.data(), m_HeightmapSize, m_Settings.SampleSpacing, m_Settings.HeightScale, normals);
+	TerrainGenerator::ComputeSplat(m_Heights.data(), normals.data(), m_HeightmapSize, m_Splat);
+}
+
+void TerrainScene::OpenTerrain()
+{
+	Config* config = Config::Get();
+	TerrainStreamer::Settings streamerSettings;
+	streamerSettings.NumSlots		= config->Fetch<uint32>("Terrain/CacheSlots", 64);
+	streamerSettings.SampleSpacing	= m_Settings.SampleSpacing;
+
+	// A cooked terrain if there is one, else the procedural heights are cooked in memory and streamed the same way.
+	const std::string cookedPath = config->Fetch<std::string>("Terrain/CookedPath", "");
+	bool isOpen = !cookedPath.empty() && m_Streamer.Open(cookedPath, streamerSettings);
+	if (!isOpen)
+	{
+		if (!cookedPath.empty())
+			LOG_WARNING("Failed to open the cooked terrain [{}], a procedural terrain is used instead.", cookedPath.c_str());
+
+		CreateHeightmap();
+		const uint32 tileSize = std::min(config->Fetch<uint32>("Terrain/TileSize", 256), m_HeightmapSize);
+		std::shared_ptr<std::vector<uint8>> pData = std::make_shared<std::vector<uint8>>();
+		if (CookedAssets::CookTerrain(m_Heights.data(), m_Splat.data(), m_HeightmapSize, tileSize, std::min(m_Settings.LeafSize, tileSize), *pData))
+		{
+			FileView view;
+			view.pData	= pData->data();
+			view.Size	= (uint64)pData->size();
+			view.pOwner	= pData;
+			isOpen = m_Streamer.Open(std::move(view), streamerSettings);
+		}
+		m_Heights = std::vector<uint16>();
+		m_Splat = std::vector<uint8>();
+	}
+
+	if (!isOpen)
+	{
+		LOG_ERROR("Failed to open the terrain, check Terrain/HeightmapSize, Terrain/TileSize and Terrain/LeafSize in the config!");
+		return;
+	}
+
+	// The leaves of the quadtree are the ones of the min/max map of the terrain.
+	const CookedAssets::TerrainHeader& header = m_Streamer.GetHeader();
+	m_HeightmapSize			= header.Size;
+	m_Settings.LeafSize		= header.LeafSize;
+	m_Settings.Lod0Range	= 3.f * m_Settings.LeafSize * m_Settings.SampleSpacing;
+	m_Streamer.SetLodRange(m_Settings.Lod0Range);
+	if (!m_Quadtree.Build((const TerrainQuadtree::MinMax*)m_Streamer.GetLeafMinMax(), m_HeightmapSize, m_Settings))
+		LOG_ERROR("Failed to build the terrain quadtree, check Terrain/NumLods in the config!");
+}
+
+void TerrainScene::CreateTileTextures()
+{
+	// At least one slice, such that the views are valid when the terrain could not be opened.
+	const uint32 tileSize = m_Streamer.GetHeader().TileSize;
+	const uint32 numSlots = std::max(m_Streamer.GetStats().NumSlots, 1u);
+	ID3D11Device* pDevice = RenderAPI::Get()->GetDevice();
+
+	auto CreateTileArray = [&](uint32 width, DXGI_FORMAT format, ID3D11Texture2D** ppTexture, ID3D11ShaderResourceView** ppSRV)
+	{
+		D3D11_TEXTURE2D_DESC textureDesc = {};
+		textureDesc.Width				= width;
+		textureDesc.Height				= width;
+		textureDesc.Format				= format;
+		textureDesc.MipLevels			= 1;
+		textureDesc.ArraySize			= numSlots;
+		textureDesc.SampleDesc.Count	= 1;
+		textureDesc.SampleDesc.Quality	= 0;
+		textureDesc.Usage				= D3D11_USAGE_DEFAULT;
+		textureDesc.CPUAccessFlags		= 0;
+		textureDesc.BindFlags			= D3D11_BIND_SHADER_RESOURCE;
+		textureDesc.MiscFlags			= 0;
+		HRESULT result = pDevice->CreateTexture2D(&textureDesc, nullptr, ppTexture);
+		RS_D311_ASSERT_CHECK(result, "Failed to create a terrain tile texture array!");
+
+		D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+		srvDesc.Format							= format;
+		srvDesc.ViewDimension					= D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+		srvDesc.Texture2DArray.MostDetailedMip	= 0;
+		srvDesc.Texture2DArray.MipLevels		= 1;
+		srvDesc.Texture2DArray.FirstArraySlice	= 0;
+		srvDesc.Texture2DArray.ArraySize		= numSlots;
+		result = pDevice->CreateShaderResourceView(*ppTexture, &srvDesc, ppSRV);
+		RS_D311_ASSERT_CHECK(result, "Failed to create a terrain tile texture array RSV!");
+	};
+
+	// The heights have the apron around them, the splat weights do not.
+	CreateTileArray(tileSize + 3, DXGI_FORMAT_R16_UNORM, &m_pHeightTiles, &m_pHeightTilesSRV);
+	CreateTileArray(tileSize + 1, DXGI_FORMAT_R8G8B8A8_UNORM, &m_pSplatTiles, &m_pSplatTilesSRV);
+
+	// Clamped, a vertex never samples outside of the samples of its tile.
+	D3D11_SAMPLER_DESC samplerDesc = {};
+	samplerDesc.Filter			= D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+	samplerDesc.AddressU		= D3D11_TEXTURE_ADDRESS_CLAMP;
+	samplerDesc.AddressV		= D3D11_TEXTURE_ADDRESS_CLAMP;
+	samplerDesc.AddressW		= D3D11_TEXTURE_ADDRESS_CLAMP;
+	samplerDesc.MipLODBias		= 0.f;
+	samplerDesc.MaxAnisotropy	= 1;
+	samplerDesc.ComparisonFunc	= D3D11_COMPARISON_NEVER;
+	samplerDesc.MinLOD			= 0.f;
+	samplerDesc.MaxLOD			= D3D11_FLOAT32_MAX;
+
+	HRESULT result = pDevice->CreateSamplerState(&samplerDesc, &m_pSampler);
+	RS_D311_ASSERT_CHECK(result, "Failed to create terrain tile sampler!");
+}
+
+void TerrainScene::UploadNewTiles()
+{
+	const uint32 tileSize = m_Streamer.GetHeader().TileSize;
+	ID3D11DeviceContext* pContext = RenderAPI::Get()->GetDeviceContext();
+	for (uint32 slot : m_Streamer.GetNewSlots())
+	{
+		const UINT subresource = D3D11CalcSubresource(0, slot, 1);
+		pContext->UpdateSubresource(m_pHeightTiles, subresource, nullptr, m_Streamer.GetSlotHeights(slot), (tileSize + 3) * sizeof(uint16), 0);
+		pContext->UpdateSubresource(m_pSplatTiles, subresource, nullptr, m_Streamer.GetSlotSplat(slot), (tileSize + 1) * 4, 0);
+	}
+}
+
+void TerrainScene::CreatePatchMesh()
+{
+	const uint32 meshSize = m_Quadtree.GetMeshSize();
+	std::vector<Vertex> vertices;
+	vertices.reserve((size_t)(meshSize + 1) * (meshSize + 1));
+	for (uint32 z = 0; z <= meshSize; z++)
+	{
+		for (uint32 x = 0; x <= meshSize; x++)
+			vertices.push_back({ glm::vec2((float)x, (float)z) });
+	}
+
+	// Front faces are clockwise seen from above, with z towards the viewer.
+	std::vector<uint32> indices;
+	indices.reserve((size_t)meshSize * meshSize * 6);
+	for (uint32 z = 0; z < meshSize; z++)
+	{
+		for (uint32 x = 0; x < meshSize; x++)
+		{
+			const uint32 first = z * (meshSize + 1) + x;
+			const uint32 next = first + meshSize + 1;
+			for (uint32 index : { first, first + 1, next, next, first + 1, next + 1 })
+				indices.push_back(index);
+		}
+	}
+	m_NumIndices = (uint32)indices.size();
+
+	{
+		D3D11_BUFFER_DESC bufferDesc = {};
+		bufferDesc.ByteWidth = (UINT)(sizeof(Vertex) * vertices.size());
+		bufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
+		bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+		bufferDesc.CPUAccessFlags = 0;
+		bufferDesc.MiscFlags = 0;
+		bufferDesc.StructureByteStride = 0;
+
+		D3D11_SUBRESOURCE_DATA data;
+		data.pSysMem = vertices.data();
+		data.SysMemPitch = 0;
+		data.SysMemSlicePitch = 0;
+
+		HRESULT result = RenderAPI::Get()->GetDevice()->CreateBuffer(&bufferDesc, &data, &m_pVertexBuffer);
+		RS_D311_ASSERT_CHECK(result, "Failed to create terrain vertex buffer!");
+	}
+
+	{
+		D3D11_BUFFER_DESC bufferDesc = {};
+		bufferDesc.ByteWidth = (UINT)(sizeof(uint32) * indices.size());
+		bufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
+		bufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+		bufferDesc.CPUAccessFlags = 0;
+		bufferDesc.MiscFlags = 0;
+		bufferDesc.StructureByteStride = 0;
+
+		D3D11_SUBRESOURCE_DATA data;
+		data.pSysMem = indices.data();
+		data.SysMemPitch = 0;
+		data.SysMemSlicePitch = 0;
+
+		HRESULT result = RenderAPI::Get()->GetDevice()->CreateBuffer(&bufferDesc, &data, &m_pIndexBuffer);
+		RS_D311_ASSERT_CHECK(result, "Failed to create terrain index buffer!");
+	}
+}
+
+void TerrainScene::UpdatePatchBuffer()
+{
+	// A patch of LOD k uses the tile of level k, or a coarser one while it is loaded. Patches without any tile are not drawn.
+	const std::vector<TerrainQuadtree::Patch>& patches = m_Quadtree.GetPatches();
+	const uint32 lastLevel = std::max(m_Streamer.GetHeader().NumLevels, 1u) - 1;
+	m_PatchData.clear();
+	m_NumPatchesWithoutTile = 0;
+	for (const TerrainQuadtree::Patch& patch : patches)
+	{
+		TerrainStreamer::Tile tile;
+		if (!m_Streamer.FindTile(std::min(patch.Lod, lastLevel), patch.Offset + glm::vec2(patch.Size * 0.5f), tile))
+		{
+			m_NumPatchesWithoutTile++;
+			continue;
+		}
+		m_PatchData.push_back({ patch.Offset, patch.Size, patch.Lod, tile.Origin, tile.Spacing, tile.Slot });
+	}
+
+	const uint32 count = (uint32)m_PatchData.size();
+	ID3D11Device* pDevice = RenderAPI::Get()->GetDevice();
+	ID3D11DeviceContext* pContext = RenderAPI::Get()->GetDeviceContext();
+
+	// An empty buffer can not be created, keep at least one element such that the view is always valid.
+	if (count > m_PatchBufferCapacity || m_pPatchBuffer == nullptr)
+	{
+		const uint32 capacity = std::max({ count, m_PatchBufferCapacity * 2, 1u });
+		if (m_pPatchBuffer)
+		{
+			m_pPatchBuffer->Release();
+			m_pPatchBufferSRV->Release();
+		}
+
+		D3D11_BUFFER_DESC bufferDesc = {};
+		bufferDesc.ByteWidth			= capacity * sizeof(PatchData);
+		bufferDesc.Usage				= D3D11_USAGE_DYNAMIC;
+		bufferDesc.BindFlags			= D3D11_BIND_SHADER_RESOURCE;
+		bufferDesc.CPUAccessFlags		= D3D11_CPU_ACCESS_WRITE;
+		bufferDesc.MiscFlags			= D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+		bufferDesc.StructureByteStride	= sizeof(PatchData);
+		HRESULT result = pDevice->CreateBuffer(&bufferDesc, nullptr, &m_pPatchBuffer);
+		RS_D311_ASSERT_CHECK(result, "Failed to create terrain patch buffer!");
+
+		D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+		srvDesc.Format				= DXGI_FORMAT_UNKNOWN;
+		srvDesc.ViewDimension		= D3D11_SRV_DIMENSION_BUFFER;
+		srvDesc.Buffer.FirstElement	= 0;
+		srvDesc.Buffer.NumElements	= capacity;
+		result = pDevice->CreateShaderResourceView(m_pPatchBuffer, &srvDesc, &m_pPatchBufferSRV);
+		RS_D311_ASSERT_CHECK(result, "Failed to create terrain patch buffer RSV!");
+		m_PatchBufferCapacity = capacity;
+	}
+
+	if (count == 0)
+		return;
+
+	D3D11_MAPPED_SUBRESOURCE mappedResource;
+	HRESULT result = pContext->Map(m_pPatchBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+	RS_D311_ASSERT_CHECK(result, "Failed to map terrain patch buffer!");
+	memcpy(mappedResource.pData, m_PatchData.data(), count * sizeof(PatchData));
+	pContext->Unmap(m_pPatchBuffer, 0);
+}
+
+void TerrainScene::SetWireframe(bool isWireframeEnabled)
+{
+	m_IsWireframeEnabled = isWireframeEnabled;
+
+	D3D11_RASTERIZER_DESC rasterizerDesc = {};
+	rasterizerDesc.AntialiasedLineEnable = false;
+	rasterizerDesc.CullMode = m_IsWireframeEnabled ? D3D11_CULL_NONE : D3D11_CULL_BACK;
+	rasterizerDesc.DepthBias = 0;
+	rasterizerDesc.DepthBiasClamp = 0.0f;
+	rasterizerDesc.DepthClipEnable = true;
+	rasterizerDesc.FillMode = m_IsWireframeEnabled ? D3D11_FILL_WIREFRAME : D3D11_FILL_SOLID;
+	rasterizerDesc.FrontCounterClockwise = false;
+	rasterizerDesc.MultisampleEnable = false;
+	rasterizerDesc.ScissorEnable = false;
+	rasterizerDesc.SlopeScaledDepthBias = 0.0f;
+	m_Pipeline.SetRasterState(rasterizerDesc);
+}
+
+void TerrainScene::DrawImGui()
+{
+	static bool s_TerrainWindow = true;
+	ImGuiRenderer::Draw([&]()
+	{
+		if (ImGui::Begin("Terrain", &s_TerrainWindow))
+		{
+			const TerrainQuadtree::Stats& stats = m_Quadtree.GetStats();
+			ImGui::Text("Heightmap: %u x %u, %u LODs", m_HeightmapSize, m_HeightmapSize, m_Quadtree.GetNumLods());
+			ImGui::Text("Patches: %u (%u nodes visited, %u culled)", stats.NumPatches, stats.NumVisitedNodes, stats.NumCulledNodes);
+			for (uint32 lod = 0; lod < m_Quadtree.GetNumLods(); lod++)
+				ImGui::Text("    LOD %u: %u", lod, stats.PatchesPerLod[lod]);
+			ImGui::Text("Selection: %.3f ms, build: %.1f ms", stats.SelectTimeMS, stats.BuildTimeMS);
+			const TerrainGenerator::Stats& generatorStats = m_Generator.GetStats();
+			if (generatorStats.Size > 0)
+				ImGui::Text("Generated: %.1f ms on %u threads (%.1f ms noise, %.1f ms erosion)", generatorStats.TotalTimeMS, generatorStats.NumThreads, generatorStats.NoiseTimeMS, generatorStats.ErosionTimeMS);
+
+			const TerrainStreamer::Stats streamStats = m_Streamer.GetStats();
+			const float hitRate = streamStats.NumWantedTiles > 0 ? 100.f * streamStats.NumHits / streamStats.NumWantedTiles : 0.f;
+			ImGui::Text("Tiles: %u / %u slots (%.1f MB), %u requests, %u patches without a tile", streamStats.NumResidentTiles, streamStats.NumSlots,
+				(float)streamStats.CacheBytes / (1024.f * 1024.f), streamStats.NumPendingRequests, m_NumPatchesWithoutTile);
+			ImGui::Text("Streaming: %.1f%% hits, %llu loads, %llu evictions, %.1f MB read", hitRate, streamStats.NumLoads, streamStats.NumEvictions,
+				(float)streamStats.BytesLoaded / (1024.f * 1024.f));
+
+			ImGui::Checkbox("Freeze selection", &m_IsSelectionFrozen);
+			ImGui::Checkbox("Color LODs", &m_ShowLods);
+			ImGui::Checkbox("Show patch bounds", &m_ShowPatchBounds);
+			bool isWireframeEnabled = m_IsWireframeEnabled;
+			if (ImGui::Checkbox("Wireframe", &isWireframeEnabled))
+				SetWireframe(isWireframeEnabled);
+
+			// The ranges are set when the quadtree is built, the min/max map of the terrain stays mapped such that it can be built again.
+			const float leafSize = m_Settings.LeafSize * m_Settings.SampleSpacing;
+			bool shouldRebuild = ImGui::SliderFloat("LOD 0 range", &m_Settings.Lod0Range, leafSize * 2.5f, leafSize * 16.f);
+			shouldRebuild |= ImGui::SliderFloat("Morph ratio", &m_Settings.MorphRatio, 0.3f, 0.7f);
+			if (shouldRebuild && m_Streamer.IsOpen())
+			{
+				m_Quadtree.Build((const TerrainQuadtree::MinMax*)m_Streamer.GetLeafMinMax(), m_HeightmapSize, m_Settings);
+				m_Streamer.SetLodRange(m_Settings.Lod0Range);
+			}
+		}
+		ImGui::End();
+	});
 }
@@ -2,9 +2,15 @@
 
 #include "Core/Scene.h"
 
+#include "Renderer/Pipeline.h"
 #include "Renderer/Shader.h"
+#include "Renderer/TerrainGenerator.h"
+#include "Renderer/TerrainQuadtree.h"
+#include "Renderer/TerrainStreamer.h"
 #include "Utils/Maths.h"
 
+#include "Scenes/Camera.h"
+
 namespace RS
 {
 	class TerrainScene : public Scene
@@ -12,16 +18,27 @@ namespace RS
 	public:
 		struct Vertex
 		{
-			glm::vec4 position;
-			glm::vec4 normal;
-			glm::vec2 uv;
+			glm::vec2 GridPos; // In quads of the patch mesh.
 		};
 
 		struct FrameData
 		{
-			glm::mat4 world = glm::mat4(1.f);
-			glm::mat4 view = glm::mat4(1.f);
-			glm::mat4 proj = glm::mat4(1.f);
+			glm::mat4 viewProj								= glm::mat4(1.f);
+			glm::vec4 cameraPos								= glm::vec4(0.f);
+			glm::vec4 info									= glm::vec4(0.f); // x: Sample spacing, y: Height scale, z: Tile size, w: Patch mesh size.
+			glm::vec4 debug									= glm::vec4(0.f); // x: One to color the patches by their LOD.
+			glm::vec4 morphRanges[TerrainQuadtree::MAX_LODS]	= {}; // x: Morph start, y: Morph end.
+		};
+
+		// A TerrainQuadtree::Patch with the streamed tile which holds its heights.
+		struct PatchData
+		{
+			glm::vec2	Offset		= glm::vec2(0.f);
+			float		Size		= 0.f;
+			uint32		Lod			= 0;
+			glm::vec2	TileOrigin	= glm::vec2(0.f);
+			float		TileSpacing	= 0.f;
+			uint32		TileSlot	= 0;
 		};
 
 	public:
@@ -41,16 +58,52 @@ namespace RS
 		void Tick(float dt) override;
 
 	private:
-		Shader m_Shader;
+		void CreateHeightmap();
+		void OpenTerrain();
+		void CreateTileTextures();
+		void UploadNewTiles();
+		void CreatePatchMesh();
+		void UpdatePatchBuffer();
+		void SetWireframe(bool isWireframeEnabled);
+		void DrawImGui();
+
+	private:
+		Shader						m_Shader;
+		Pipeline					m_Pipeline;
+		Camera						m_Camera;
+
+		ID3D11Buffer*				m_pVertexBuffer			= nullptr;
+		ID3D11Buffer*				m_pIndexBuffer			= nullptr;
+		ID3D11Buffer*				m_pConstantBuffer		= nullptr;
+		uint32						m_NumIndices			= 0;
+
+		// One PatchData for each instance, it grows when more patches are selected.
+		ID3D11Buffer*				m_pPatchBuffer			= nullptr;
+		ID3D11ShaderResourceView*	m_pPatchBufferSRV		= nullptr;
+		uint32						m_PatchBufferCapacity	= 0;
+		std::vector<PatchData>		m_PatchData;
+
+		// One slice for each slot of the streamer, the slices of the new tiles are updated each frame.
+		ID3D11Texture2D*			m_pHeightTiles			= nullptr;
+		ID3D11ShaderResourceView*	m_pHeightTilesSRV		= nullptr;
+		ID3D11Texture2D*			m_pSplatTiles			= nullptr;
+		ID3D11ShaderResourceView*	m_pSplatTilesSRV		= nullptr;
+		ID3D11SamplerState*			m_pSampler				= nullptr;
 
-		ID3D11Buffer* m_pVertexBuffer = nullptr;
-		ID3D11Buffer* m_pIndexBuffer = nullptr;
-		ID3D11Buffer* m_pConstantBuffer = nullptr;
+		FrameData					m_FrameData;
 
-		ID3D11Texture2D* m_pTexture = nullptr;
-		ID3D11ShaderResourceView* m_pTextureSRV = nullptr;
-		ID3D11SamplerState* m_pSampler = nullptr;
+		TerrainGenerator			m_Generator;
+		std::vector<uint16>			m_Heights; // Only while the procedural terrain is cooked.
+		std::vector<uint8>			m_Splat;
+		uint32						m_HeightmapSize			= 0;
+		TerrainStreamer				m_Streamer;
+		TerrainQuadtree				m_Quadtree;
+		TerrainQuadtree::Settings	m_Settings;
+		uint32						m_NumPatchesWithoutTile	= 0;
 
-		FrameData m_FrameData;
+		bool						m_IsSelectionFrozen		= false;
+		bool						m_IsWireframeEnabled	= false;
+		bool						m_ShowLods				= false;
+		bool						m_ShowPatchBounds		= false;
 	};
-}
\ No newline at end of file
+}
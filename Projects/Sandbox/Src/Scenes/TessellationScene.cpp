@@ -3,7 +3,9 @@
 
 #include "Renderer/DebugRenderer.h"
 #include "Renderer/ShaderHotReloader.h"
+#include "Renderer/ShaderBatch.h"
 #include "Renderer/Renderer.h"
+#include "Renderer/StateCache.h"
 #include "Renderer/ImGuiRenderer.h"
 
 #include "Core/Display.h"
@@ -30,6 +32,8 @@ void TessellationScene::Start()
 	float nearPlane = 0.01f, farPlane = 100.f;
 	m_Camera.Init(camPos, camDir, glm::vec3{ 0.f, 1.f, 0.f }, nearPlane, farPlane, fov);
 
+	ShaderBatch shaderBatch;
+
 	AttributeLayout layout;
 	layout.Push(DXGI_FORMAT_R32G32B32_FLOAT, "POSITION", 0);
 	layout.Push(DXGI_FORMAT_R32G32B32_FLOAT, "NORMAL", 0);
@@ -41,8 +45,7 @@ void TessellationScene::Start()
 		shaderDesc.Hull = "TessellationScene/TessTriHull.hlsl";
 		shaderDesc.Domain = "TessellationScene/TessTriDomain.hlsl";
 		shaderDesc.Fragment = "TessellationScene/TessFrag.hlsl";
-		m_TriShader.Load(shaderDesc, layout);
-		ShaderHotReloader::AddShader(&m_TriShader);
+		shaderBatch.Add(&m_TriShader, shaderDesc, layout);
 	}
 	{
 		Shader::Descriptor shaderDesc = {};
@@ -50,10 +53,13 @@ void TessellationScene::Start()
 		shaderDesc.Hull = "TessellationScene/TessQuadHull.hlsl";
 		shaderDesc.Domain = "TessellationScene/TessQuadDomain.hlsl";
 		shaderDesc.Fragment = "TessellationScene/TessFrag.hlsl";
-		m_QuadShader.Load(shaderDesc, layout);
-		ShaderHotReloader::AddShader(&m_QuadShader);
+		shaderBatch.Add(&m_QuadShader, shaderDesc, layout);
 	}
 
+	shaderBatch.Load();
+	ShaderHotReloader::AddShader(&m_TriShader);
+	ShaderHotReloader::AddShader(&m_QuadShader);
+
 	static const float H = 1.f;
 	static const float W = 1.f;
 	static const float D = 1.f;
@@ -251,6 +257,7 @@ void TessellationScene::Tick(float dt)
 	auto renderer = Renderer::Get();
 	auto renderAPI = RenderAPI::Get();
 	ID3D11DeviceContext* pContext = renderAPI->GetDeviceContext();
+	std::shared_ptr<StateCache> stateCache = StateCache::Get();
 	renderer->BeginScene(0.2f, 0.2f, 0.2f, 1.0f);
 
 	static uint32 id = DebugRenderer::Get()->GenID();
@@ -336,19 +343,19 @@ void TessellationScene::Tick(float dt)
 	UINT stride = sizeof(Vertex);
 	UINT offset = 0;
 	{
-		pContext->IASetVertexBuffers(0, 1, &m_pVertexBuffer, &stride, &offset);
-		pContext->IASetIndexBuffer(m_pTriIndexBuffer, DXGI_FORMAT_R32_UINT, 0);
-		pContext->VSSetConstantBuffers(0, 1, &m_pVSConstantBuffer);
-		pContext->HSSetConstantBuffers(0, 1, &m_pHSConstantBuffer);
-		pContext->DSSetConstantBuffers(0, 1, &m_pDSConstantBuffer);
-		pContext->DSSetSamplers(0, 1, &m_pSampler);
-		pContext->DSSetShaderResources(0, 1, &m_pDisplacementTextureView);
-		pContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_3_CONTROL_POINT_PATCHLIST);
-		pContext->PSSetSamplers(0, 1, &m_pSampler);
-		pContext->PSSetShaderResources(0, 1, &m_pNormalTextureView);
-		pContext->PSSetShaderResources(1, 1, &m_pAlbedoTextureView);
-		pContext->PSSetConstantBuffers(0, 1, &m_pPSConstantBuffer);
-		pContext->DrawIndexed((UINT)m_NumTriIndices, 0, 0);
+		stateCache->SetVertexBuffers(0, 1, &m_pVertexBuffer, &stride, &offset);
+		stateCache->SetIndexBuffer(m_pTriIndexBuffer, DXGI_FORMAT_R32_UINT, 0);
+		stateCache->SetConstantBuffers(ShaderTypeFlag::VERTEX, 0, 1, &m_pVSConstantBuffer);
+		stateCache->SetConstantBuffers(ShaderTypeFlag::TESS_HULL, 0, 1, &m_pHSConstantBuffer);
+		stateCache->SetConstantBuffers(ShaderTypeFlag::TESS_DOMAIN, 0, 1, &m_pDSConstantBuffer);
+		stateCache->SetSamplers(ShaderTypeFlag::TESS_DOMAIN, 0, 1, &m_pSampler);
+		stateCache->SetShaderResources(ShaderTypeFlag::TESS_DOMAIN, 0, 1, &m_pDisplacementTextureView);
+		stateCache->SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_3_CONTROL_POINT_PATCHLIST);
+		stateCache->SetSamplers(ShaderTypeFlag::FRAGMENT, 0, 1, &m_pSampler);
+		stateCache->SetShaderResources(ShaderTypeFlag::FRAGMENT, 0, 1, &m_pNormalTextureView);
+		stateCache->SetShaderResources(ShaderTypeFlag::FRAGMENT, 1, 1, &m_pAlbedoTextureView);
+		stateCache->SetConstantBuffers(ShaderTypeFlag::FRAGMENT, 0, 1, &m_pPSConstantBuffer);
+		stateCache->DrawIndexed((UINT)m_NumTriIndices, 0, 0);
 	}
 	
 	{ // Shift the model to the Left
@@ -369,19 +376,19 @@ void TessellationScene::Tick(float dt)
 	
 	m_QuadShader.Bind();
 	{
-		pContext->IASetVertexBuffers(0, 1, &m_pVertexBuffer, &stride, &offset);
-		pContext->IASetIndexBuffer(m_pQuadIndexBuffer, DXGI_FORMAT_R32_UINT, 0);
-		pContext->VSSetConstantBuffers(0, 1, &m_pVSConstantBuffer);
-		pContext->HSSetConstantBuffers(0, 1, &m_pHSConstantBuffer);
-		pContext->DSSetConstantBuffers(0, 1, &m_pDSConstantBuffer);
-		pContext->DSSetSamplers(0, 1, &m_pSampler);
-		pContext->DSSetShaderResources(0, 1, &m_pDisplacementTextureView);
-		pContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_4_CONTROL_POINT_PATCHLIST);
-		pContext->PSSetSamplers(0, 1, &m_pSampler);
-		pContext->PSSetShaderResources(0, 1, &m_pNormalTextureView);
-		pContext->PSSetShaderResources(1, 1, &m_pAlbedoTextureView);
-		pContext->PSSetConstantBuffers(0, 1, &m_pPSConstantBuffer);
-		pContext->DrawIndexed((UINT)m_NumQuadIndices, 0, 0);
+		stateCache->SetVertexBuffers(0, 1, &m_pVertexBuffer, &stride, &offset);
+		stateCache->SetIndexBuffer(m_pQuadIndexBuffer, DXGI_FORMAT_R32_UINT, 0);
+		stateCache->SetConstantBuffers(ShaderTypeFlag::VERTEX, 0, 1, &m_pVSConstantBuffer);
+		stateCache->SetConstantBuffers(ShaderTypeFlag::TESS_HULL, 0, 1, &m_pHSConstantBuffer);
+		stateCache->SetConstantBuffers(ShaderTypeFlag::TESS_DOMAIN, 0, 1, &m_pDSConstantBuffer);
+		stateCache->SetSamplers(ShaderTypeFlag::TESS_DOMAIN, 0, 1, &m_pSampler);
+		stateCache->SetShaderResources(ShaderTypeFlag::TESS_DOMAIN, 0, 1, &m_pDisplacementTextureView);
+		stateCache->SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_4_CONTROL_POINT_PATCHLIST);
+		stateCache->SetSamplers(ShaderTypeFlag::FRAGMENT, 0, 1, &m_pSampler);
+		stateCache->SetShaderResources(ShaderTypeFlag::FRAGMENT, 0, 1, &m_pNormalTextureView);
+		stateCache->SetShaderResources(ShaderTypeFlag::FRAGMENT, 1, 1, &m_pAlbedoTextureView);
+		stateCache->SetConstantBuffers(ShaderTypeFlag::FRAGMENT, 0, 1, &m_pPSConstantBuffer);
+		stateCache->DrawIndexed((UINT)m_NumQuadIndices, 0, 0);
 	}
 }
 
@@ -2,7 +2,9 @@
 #include "TextureScene.h"
 
 #include "Renderer/ShaderHotReloader.h"
+#include "Renderer/ShaderBatch.h"
 #include "Renderer/Renderer.h"
+#include "Renderer/StateCache.h"
 #include "Core/Display.h"
 
 #include "Utils/Maths.h"
@@ -25,6 +27,7 @@ void TextureScene::Start()
 	float nearPlane = 0.01f, farPlane = 100.f;
 	m_Camera.Init(camPos, camDir, glm::vec3{ 0.f, 1.f, 0.f }, nearPlane, farPlane, fov);
 
+	ShaderBatch shaderBatch;
 	{
 		AttributeLayout layout;
 		layout.Push(DXGI_FORMAT_R32G32B32A32_FLOAT, "POSITION", 0);
@@ -33,8 +36,7 @@ void TextureScene::Start()
 		Shader::Descriptor shaderDesc = {};
 		shaderDesc.Vertex = "TextureScene/SandboxVert.hlsl";
 		shaderDesc.Fragment = "TextureScene/SandboxFrag.hlsl";
-		m_Shader.Load(shaderDesc, layout);
-		ShaderHotReloader::AddShader(&m_Shader);
+		shaderBatch.Add(&m_Shader, shaderDesc, layout);
 	}
 
 	{
@@ -47,9 +49,12 @@ void TextureScene::Start()
 		Shader::Descriptor shaderDesc = {};
 		shaderDesc.Vertex = "TextureScene/SkyboxVert.hlsl";
 		shaderDesc.Fragment = "TextureScene/SkyboxFrag.hlsl";
-		m_SkyboxShader.Load(shaderDesc, layout);
-		ShaderHotReloader::AddShader(&m_SkyboxShader);
+		shaderBatch.Add(&m_SkyboxShader, shaderDesc, layout);
 	}
+
+	shaderBatch.Load();
+	ShaderHotReloader::AddShader(&m_Shader);
+	ShaderHotReloader::AddShader(&m_SkyboxShader);
 	
 	std::vector<Vertex> vertices =
 	{
@@ -257,6 +262,7 @@ void TextureScene::Tick(float dt)
 	auto renderer = Renderer::Get();
 	auto renderAPI = RenderAPI::Get();
 	ID3D11DeviceContext* pContext = renderAPI->GetDeviceContext();
+	std::shared_ptr<StateCache> stateCache = StateCache::Get();
 	renderer->BeginScene(0.0f, 0.2f, 0.2f, 1.0f);
 
 	m_Shader.Bind();
@@ -280,13 +286,13 @@ void TextureScene::Tick(float dt)
 
 	UINT stride = sizeof(Vertex);
 	UINT offset = 0;
-	pContext->IASetVertexBuffers(0, 1, &m_pVertexBuffer, &stride, &offset);
-	pContext->IASetIndexBuffer(m_pIndexBuffer, DXGI_FORMAT_R32_UINT, 0);
-	pContext->VSSetConstantBuffers(0, 1, &m_pConstantBuffer);
-	pContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-	pContext->PSSetShaderResources(0, 1, &m_pTextureSRV);
-	pContext->PSSetSamplers(0, 1, &m_pSampler);
-	pContext->DrawIndexed(6, 0, 0);
+	stateCache->SetVertexBuffers(0, 1, &m_pVertexBuffer, &stride, &offset);
+	stateCache->SetIndexBuffer(m_pIndexBuffer, DXGI_FORMAT_R32_UINT, 0);
+	stateCache->SetConstantBuffers(ShaderTypeFlag::VERTEX, 0, 1, &m_pConstantBuffer);
+	stateCache->SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	stateCache->SetShaderResources(ShaderTypeFlag::FRAGMENT, 0, 1, &m_pTextureSRV);
+	stateCache->SetSamplers(ShaderTypeFlag::FRAGMENT, 0, 1, &m_pSampler);
+	stateCache->DrawIndexed(6, 0, 0);
 	
 	{
 		m_SkyboxShader.Bind();
@@ -301,9 +307,9 @@ void TextureScene::Tick(float dt)
 		pContext->Unmap(m_pConstantBuffer, 0);
 
 		SamplerResource* pSampler = ResourceManager::Get()->GetResource<SamplerResource>(ResourceManager::Get()->DefaultSamplerLinear);
-		pContext->VSSetConstantBuffers(1, 1, &m_pConstantBuffer);
-		pContext->PSSetShaderResources(0, 1, &m_pCubeMap->pTextureSRV);
-		pContext->PSSetSamplers(0, 1, &pSampler->pSampler);
+		stateCache->SetConstantBuffers(ShaderTypeFlag::VERTEX, 1, 1, &m_pConstantBuffer);
+		stateCache->SetShaderResources(ShaderTypeFlag::FRAGMENT, 0, 1, &m_pCubeMap->pTextureSRV);
+		stateCache->SetSamplers(ShaderTypeFlag::FRAGMENT, 0, 1, &pSampler->pSampler);
 
 		glm::mat4 transform(1.f);
 		Renderer::DebugInfo debugInfo = {};
@@ -2,6 +2,8 @@
 
 #include "Utils/Maths.h"
 
+#include <cfloat>
+
 namespace RS
 {
 	struct AABB
@@ -9,14 +11,22 @@ namespace RS
 		glm::vec3 min = glm::vec3(0.f);
 		glm::vec3 max = glm::vec3(0.f);
 
+		/*
+		* The box around the eight transformed corners, which also holds the box when the transform rotates it.
+		*/
 		static AABB Transform(const AABB& aabb, const glm::mat4& transform)
 		{
-			glm::vec4 minT = transform * glm::vec4(aabb.min, 1.f);
-			glm::vec4 maxT = transform * glm::vec4(aabb.max, 1.f);
 			AABB result;
-			result.min = (glm::vec3)minT;
-			result.max = (glm::vec3)maxT;
+			result.min = glm::vec3(FLT_MAX);
+			result.max = glm::vec3(-FLT_MAX);
+			for (uint32 corner = 0; corner < 8; corner++)
+			{
+				glm::vec3 p((corner & 1) ? aabb.max.x : aabb.min.x, (corner & 2) ? aabb.max.y : aabb.min.y, (corner & 4) ? aabb.max.z : aabb.min.z);
+				glm::vec3 pT = (glm::vec3)(transform * glm::vec4(p, 1.f));
+				result.min = Maths::GetMinElements(result.min, pT);
+				result.max = Maths::GetMaxElements(result.max, pT);
+			}
 			return result;
 		}
 	};
-}
\ No newline at end of file
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Structures/AABB.h"
+#include "Utils/Maths.h"
+
+namespace RS
+{
+	struct Frustum
+	{
+		// Left, right, bottom, top, near and far. A point p is inside a plane when dot(plane.xyz, p) + plane.w >= 0.
+		glm::vec4 planes[6];
+
+		/*
+		* The planes of a view projection matrix with the depth range [0, 1], in the space the matrix transforms from.
+		*/
+		static Frustum FromViewProj(const glm::mat4& viewProj)
+		{
+			glm::vec4 rows[4];
+			for (uint32 i = 0; i < 4; i++)
+				rows[i] = glm::vec4(viewProj[0][i], viewProj[1][i], viewProj[2][i], viewProj[3][i]);
+
+			Frustum frustum;
+			frustum.planes[0] = rows[3] + rows[0];
+			frustum.planes[1] = rows[3] - rows[0];
+			frustum.planes[2] = rows[3] + rows[1];
+			frustum.planes[3] = rows[3] - rows[1];
+			frustum.planes[4] = rows[2];
+			frustum.planes[5] = rows[3] - rows[2];
+			for (glm::vec4& plane : frustum.planes)
+				plane /= glm::length(glm::vec3(plane));
+			return frustum;
+		}
+
+		/*
+		* False if the box is fully outside of one of the planes. Boxes near the corners of the frustum can be outside of it and still pass.
+		*/
+		bool Intersects(const AABB& aabb) const
+		{
+			for (const glm::vec4& plane : planes)
+			{
+				// The corner which is the furthest along the normal of the plane.
+				glm::vec3 corner(plane.x >= 0.f ? aabb.max.x : aabb.min.x, plane.y >= 0.f ? aabb.max.y : aabb.min.y, plane.z >= 0.f ? aabb.max.z : aabb.min.z);
+				if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.f)
+					return false;
+			}
+			return true;
+		}
+	};
+}
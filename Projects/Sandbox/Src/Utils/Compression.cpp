@@ -0,0 +1,163 @@
+#include "PreCompiled.h"
+#include "Compression.h"
+
+#include <algorithm>
+
+using namespace RS;
+
+namespace
+{
+	/*
+	* Every sequence starts with a token. The high four bits holds the number of literals and the low four bits the match length (minus MIN_MATCH).
+	* If any of them are 15, the length continues in the following bytes, adding 255 for each 0xFF byte until a byte which is less than 0xFF.
+	* The token is followed by the literals, a 16 bit offset and the extended match length.
+	* The last sequence only contains literals and ends the stream.
+	*/
+	constexpr uint64 MIN_MATCH	= 4;
+	constexpr uint64 MAX_OFFSET	= 0xFFFF;
+	constexpr uint32 HASH_BITS	= 16;
+
+	inline uint32 Read32(const uint8* p)
+	{
+		uint32 v;
+		memcpy(&v, p, sizeof(uint32));
+		return v;
+	}
+
+	inline uint32 Hash(uint32 v)
+	{
+		return (v * 2654435761u) >> (32 - HASH_BITS);
+	}
+
+	inline void WriteLength(std::vector<uint8>& out, uint64 length)
+	{
+		while (length >= 255)
+		{
+			out.push_back(255);
+			length -= 255;
+		}
+		out.push_back((uint8)length);
+	}
+
+	inline bool ReadLength(const uint8*& ip, const uint8* pEnd, uint64& length)
+	{
+		uint8 b = 0;
+		do
+		{
+			if (ip >= pEnd)
+				return false;
+			b = *ip++;
+			length += b;
+		} while (b == 255);
+		return true;
+	}
+}
+
+std::vector<uint8> Compression::CompressLZ(const uint8* pData, uint64 size)
+{
+	std::vector<uint8> out;
+	out.reserve((size_t)size);
+
+	std::vector<int64> table((size_t)1 << HASH_BITS, -1);
+	uint64 anchor	= 0;
+	uint64 pos		= 0;
+
+	auto EmitSequence = [&](uint64 literalLength, uint64 offset, uint64 matchLength)
+	{
+		uint64 extraMatch = matchLength > 0 ? matchLength - MIN_MATCH : 0;
+		uint8 token = (uint8)((std::min(literalLength, (uint64)15) << 4) | std::min(extraMatch, (uint64)15));
+		out.push_back(token);
+		if (literalLength >= 15)
+			WriteLength(out, literalLength - 15);
+		out.insert(out.end(), pData + anchor, pData + anchor + literalLength);
+
+		if (matchLength > 0)
+		{
+			out.push_back((uint8)(offset & 0xFF));
+			out.push_back((uint8)(offset >> 8));
+			if (extraMatch >= 15)
+				WriteLength(out, extraMatch - 15);
+		}
+	};
+
+	while (pos + MIN_MATCH <= size)
+	{
+		uint32 sequence		= Read32(pData + pos);
+		uint32 hash			= Hash(sequence);
+		int64 candidate		= table[hash];
+		table[hash]			= (int64)pos;
+
+		if (candidate >= 0 && pos - (uint64)candidate <= MAX_OFFSET && Read32(pData + candidate) == sequence)
+		{
+			uint64 matchLength = MIN_MATCH;
+			while (pos + matchLength < size && pData[candidate + matchLength] == pData[pos + matchLength])
+				matchLength++;
+
+			EmitSequence(pos - anchor, pos - (uint64)candidate, matchLength);
+			pos		+= matchLength;
+			anchor	= pos;
+
+			// Give up early if it will not be smaller.
+			if ((uint64)out.size() >= size)
+				return {};
+		}
+		else
+		{
+			pos++;
+		}
+	}
+
+	EmitSequence(size - anchor, 0, 0);
+	if ((uint64)out.size() >= size)
+		return {};
+	return out;
+}
+
+bool Compression::DecompressLZ(const uint8* pSrc, uint64 srcSize, uint8* pDst, uint64 dstSize)
+{
+	const uint8* ip		= pSrc;
+	const uint8* pEnd	= pSrc + srcSize;
+	uint64 op			= 0;
+
+	while (ip < pEnd)
+	{
+		uint8 token = *ip++;
+
+		// Literals
+		uint64 literalLength = token >> 4;
+		if (literalLength == 15 && !ReadLength(ip, pEnd, literalLength))
+			return false;
+		if (literalLength > (uint64)(pEnd - ip) || op + literalLength > dstSize)
+			return false;
+		memcpy(pDst + op, ip, (size_t)literalLength);
+		ip += literalLength;
+		op += literalLength;
+
+		// The last sequence does not have a match.
+		if (ip == pEnd)
+			break;
+
+		// Match
+		if (pEnd - ip < 2)
+			return false;
+		uint64 offset = (uint64)ip[0] | ((uint64)ip[1] << 8);
+		ip += 2;
+		if (offset == 0 || offset > op)
+			return false;
+
+		uint64 matchLength = token & 15;
+		if (matchLength == 15 && !ReadLength(ip, pEnd, matchLength))
+			return false;
+		matchLength += MIN_MATCH;
+		if (op + matchLength > dstSize)
+			return false;
+
+		// The match can overlap the output, copy byte by byte.
+		const uint8* pMatch = pDst + op - offset;
+		for (uint64 i = 0; i < matchLength; i++)
+			pDst[op + i] = pMatch[i];
+		op += matchLength;
+	}
+
+	return op == dstSize;
+}
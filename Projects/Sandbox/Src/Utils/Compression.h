@@ -0,0 +1,22 @@
+#pragma once
+
+namespace RS
+{
+	class Compression
+	{
+	public:
+		RS_DEFAULT_ABSTRACT_CLASS(Compression);
+
+		/*
+		* Compress the data with a fast byte oriented LZ77 compression (Similar to the LZ4 block format).
+		* Returns an empty vector if the compressed data would not be smaller than the input.
+		*/
+		static std::vector<uint8> CompressLZ(const uint8* pData, uint64 size);
+
+		/*
+		* Decompress data which was compressed with CompressLZ. The size of the decompressed data must be known.
+		* Returns false if the data is corrupt or does not decompress to exactly dstSize bytes.
+		*/
+		static bool DecompressLZ(const uint8* pSrc, uint64 srcSize, uint8* pDst, uint64 dstSize);
+	};
+}
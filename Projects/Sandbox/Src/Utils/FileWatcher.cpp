@@ -1,9 +1,19 @@
 #include "PreCompiled.h"
 #include "FileWatcher.h"
 
+#include <algorithm>
+
 using namespace RS;
 
-FileWatcher::FileWatcher() : m_DelayDuration(std::chrono::milliseconds(1000))
+namespace
+{
+	// Completion key used to wake up the event watcher, directory watches use their address as key.
+	const ULONG_PTR WAKE_UP_KEY		= 0;
+	const DWORD NOTIFY_FILTER		= FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE;
+	const DWORD NOTIFY_BUFFER_SIZE	= 64 * 1024;
+}
+
+FileWatcher::FileWatcher() : m_DelayDuration(std::chrono::milliseconds(1000)), m_DebounceDuration(std::chrono::milliseconds(50))
 {
 }
 
@@ -15,19 +25,76 @@ FileWatcher::~FileWatcher()
 
 void FileWatcher::AddFile(const std::string& filePath)
 {
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	std::string key = GetKey(filePath);
+	if (m_WatchList.contains(key))
+		return;
+
+	WatchedFile file;
+	file.Path		= filePath;
+	file.WriteTime	= GetWriteTime(filePath);
+	m_WatchList[key] = file;
+	m_Stats.NumWatchedFiles = (uint32)m_WatchList.size();
+
+	std::error_code error;
+	RequestDirectoryWatch(std::filesystem::absolute(filePath, error).lexically_normal().parent_path(), false);
+}
+
+void FileWatcher::AddDirectory(const std::string& directoryPath, bool recursive)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	std::error_code error;
+	WatchedDirectory directory;
+	directory.Path			= directoryPath;
+	directory.AbsolutePath	= std::filesystem::absolute(directoryPath, error).lexically_normal();
+	directory.Key			= GetKey(directory.AbsolutePath);
+	directory.Recursive		= recursive;
+
+	// The current write times are needed to find changes when polling.
+	auto AddFileTime = [&](const std::filesystem::directory_entry& entry)
 	{
-		std::lock_guard<std::mutex> lock(m_Mutex);
-		std::filesystem::file_time_type fileTime = std::filesystem::last_write_time(std::filesystem::path(filePath));
-		m_WatchList[filePath] = fileTime;
+		if (entry.is_regular_file(error))
+			directory.FileTimes[GetKey(entry.path())] = GetWriteTime(entry.path());
+	};
+	if (recursive)
+	{
+		for (const auto& entry : std::filesystem::recursive_directory_iterator(directory.AbsolutePath, error))
+			AddFileTime(entry);
 	}
+	else
+	{
+		for (const auto& entry : std::filesystem::directory_iterator(directory.AbsolutePath, error))
+			AddFileTime(entry);
+	}
+
+	m_WatchedDirectories.push_back(directory);
+	RequestDirectoryWatch(directory.AbsolutePath, recursive);
 }
 
-void FileWatcher::Init(uint32_t delay)
+void FileWatcher::Init(uint32_t delay, Backend backend, uint32_t debounce)
 {
 	m_ShouldRelease = true;
 	m_RequestStop = false;
 	m_DelayDuration = std::chrono::milliseconds(delay);
-	m_pWatcherThread = new std::thread(&FileWatcher::Watcher, this);
+	m_DebounceDuration = std::chrono::milliseconds(debounce);
+
+	m_Backend = backend;
+	if (m_Backend == Backend::EVENTS)
+	{
+		m_CompletionPort = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 1);
+		if (m_CompletionPort == NULL)
+		{
+			LOG_WARNING("Failed to create a completion port for the file watcher, falling back to polling!");
+			m_Backend = Backend::POLLING;
+		}
+	}
+	m_Stats.ActiveBackend = m_Backend;
+
+	if (m_Backend == Backend::EVENTS)
+		m_pWatcherThread = new std::thread(&FileWatcher::EventWatcher, this);
+	else
+		m_pWatcherThread = new std::thread(&FileWatcher::Watcher, this);
 }
 
 void FileWatcher::Release()
@@ -38,9 +105,21 @@ void FileWatcher::Release()
 			std::lock_guard<std::mutex> lock(m_Mutex);
 			m_RequestStop = true;
 		}
+		m_StopCondition.notify_all();
+		if (m_CompletionPort != NULL)
+			PostQueuedCompletionStatus(m_CompletionPort, 0, WAKE_UP_KEY, nullptr);
 
 		m_pWatcherThread->join();
 		m_ShouldRelease = false;
+
+		LOG_INFO("File watcher stats: {} files, {} directories, {} wake ups, {} events, {} callbacks, last latency {:.1f} ms.",
+			m_Stats.NumWatchedFiles, m_Stats.NumWatchedDirectories, m_Stats.NumWakeUps, m_Stats.NumEvents, m_Stats.NumCallbacks, m_Stats.LastLatencyMS);
+	}
+
+	if (m_CompletionPort != NULL)
+	{
+		CloseHandle(m_CompletionPort);
+		m_CompletionPort = NULL;
 	}
 
 	delete m_pWatcherThread;
@@ -55,49 +134,371 @@ void FileWatcher::AddCallBack(FileCallback callback)
 	}
 }
 
+FileWatcher::Stats FileWatcher::GetStats()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_Stats;
+}
+
 void FileWatcher::Watcher()
 {
-	bool shouldStop = false;
-	while (!shouldStop)
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	while (!m_RequestStop)
+	{
+		m_StopCondition.wait_for(lock, m_DelayDuration, [&]() { return m_RequestStop; });
+		if (m_RequestStop)
+			break;
+
+		m_Stats.NumWakeUps++;
+		std::vector<std::string> modifiedFiles;
+		PollFiles(lock, modifiedFiles);
+		if (m_RequestStop)
+			break;
+		m_Stats.NumEvents += (uint64)modifiedFiles.size();
+		m_Stats.LastLatencyMS = modifiedFiles.empty() ? m_Stats.LastLatencyMS : (float)m_DelayDuration.count(); // Upper bound, the write time is not compared to the clock.
+		CallCallbacks(modifiedFiles, lock);
+	}
+
+	LOG_INFO("Thread Watcher has closed.");
+}
+
+void FileWatcher::EventWatcher()
+{
+	using Clock = std::chrono::steady_clock;
+	std::unordered_map<std::string, PendingChange> pending;
+	Clock::time_point firstChangeTime;
+	Clock::time_point lastChangeTime;
+
+	while (true)
 	{
-		std::this_thread::sleep_for(m_DelayDuration);
+		bool hasFailedWatches = StartDirectoryWatches();
 
-		for (auto& [filePath, type] : m_WatchListThread)
+		// Sleep until something happens, or until the debounce window of the pending changes has passed.
+		// Directories which could not be watched are polled instead.
+		DWORD timeout = hasFailedWatches ? (DWORD)m_DelayDuration.count() : INFINITE;
+		if (!pending.empty())
 		{
-			// Check if the file was modified, if that was the case, add it to the modified list.
-			auto path = std::filesystem::path(filePath);
-			auto currentType = std::filesystem::last_write_time(path);
-			if (type != currentType)
+			auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - lastChangeTime);
+			timeout = std::min(timeout, (DWORD)std::max<int64>((int64)m_DebounceDuration.count() - (int64)elapsed.count(), 0));
+		}
+
+		DWORD numBytes = 0;
+		ULONG_PTR key = WAKE_UP_KEY;
+		OVERLAPPED* pOverlapped = nullptr;
+		BOOL result = GetQueuedCompletionStatus(m_CompletionPort, &numBytes, &key, &pOverlapped, timeout);
+
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		if (m_RequestStop)
+			break;
+		m_Stats.NumWakeUps++;
+
+		if (pOverlapped != nullptr && key != WAKE_UP_KEY)
+		{
+			DirectoryWatch* pWatch = (DirectoryWatch*)key;
+			bool wasEmpty = pending.empty();
+			if (result && ProcessNotifications(pWatch, numBytes, pending))
 			{
-				type = currentType;
-				m_ModifiedFiles.push_back(filePath);
+				// Every new change extends the debounce window.
+				if (wasEmpty)
+					firstChangeTime = Clock::now();
+				lastChangeTime = Clock::now();
 			}
+
+			if (!IssueRead(pWatch))
+				LOG_WARNING("Stopped watching directory {}, it will be polled instead!", pWatch->AbsolutePath.string().c_str());
 		}
 
-		{
-			std::lock_guard<std::mutex> lock(m_Mutex);
-			if (m_RequestStop)
-				shouldStop = true;
+		std::vector<std::string> modifiedFiles;
+		if (hasFailedWatches)
+			PollFiles(lock, modifiedFiles);
 
-			// Add new files to watch.
-			for (auto& [filePath, type] : m_WatchList)
+		if (!pending.empty() && Clock::now() - lastChangeTime >= m_DebounceDuration)
+		{
+			// Only report files which actually were modified, the same write can give several notifications.
+			for (auto& [changeKey, change] : pending)
 			{
-				if (m_WatchListThread.contains(filePath) == false)
+				if (change.IsFile)
 				{
-					m_WatchListThread[filePath] = type;
+					auto it = m_WatchList.find(changeKey);
+					std::filesystem::file_time_type writeTime = GetWriteTime(it->second.Path);
+					if (writeTime == std::filesystem::file_time_type::min() || writeTime == it->second.WriteTime)
+						continue;
+					it->second.WriteTime = writeTime;
 				}
+				modifiedFiles.push_back(change.Path);
 			}
+			pending.clear();
 
-			// Call all callers, clear the list and start over.
-			std::for_each(m_CallbackList.begin(), m_CallbackList.end(),
-				[&](auto fCallBack) {
-					fCallBack.callback(m_ModifiedFiles);
-				}
-			);
-
-			m_ModifiedFiles.clear();
+			m_Stats.LastLatencyMS = std::chrono::duration<float, std::milli>(Clock::now() - firstChangeTime).count();
 		}
+
+		CallCallbacks(modifiedFiles, lock);
 	}
 
+	CloseDirectoryWatches();
 	LOG_INFO("Thread Watcher has closed.");
 }
+
+void FileWatcher::RequestDirectoryWatch(const std::filesystem::path& absolutePath, bool recursive)
+{
+	std::string key = GetKey(absolutePath);
+	for (auto& pWatch : m_DirectoryWatches)
+	{
+		// Already covered by this or a recursive parent directory.
+		if (pWatch->Key == key && (pWatch->Recursive || !recursive))
+			return;
+		if (pWatch->Recursive && key.compare(0, pWatch->Key.size() + 1, pWatch->Key + "/") == 0)
+			return;
+	}
+
+	auto pWatch = std::make_unique<DirectoryWatch>();
+	pWatch->AbsolutePath	= absolutePath;
+	pWatch->Key				= key;
+	pWatch->Recursive		= recursive;
+	m_DirectoryWatches.push_back(std::move(pWatch));
+	m_Stats.NumWatchedDirectories = (uint32)m_DirectoryWatches.size();
+
+	// The watcher thread opens the directory, such that all the IO is done on the same thread.
+	if (m_CompletionPort != NULL)
+		PostQueuedCompletionStatus(m_CompletionPort, 0, WAKE_UP_KEY, nullptr);
+}
+
+bool FileWatcher::StartDirectoryWatches()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	bool hasFailedWatches = false;
+	for (auto& pWatch : m_DirectoryWatches)
+	{
+		hasFailedWatches |= pWatch->HasFailed;
+		if (pWatch->Handle != INVALID_HANDLE_VALUE || pWatch->HasFailed)
+			continue;
+
+		pWatch->Handle = CreateFileW(pWatch->AbsolutePath.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+			NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+		if (pWatch->Handle == INVALID_HANDLE_VALUE || CreateIoCompletionPort(pWatch->Handle, m_CompletionPort, (ULONG_PTR)pWatch.get(), 0) == NULL)
+		{
+			LOG_WARNING("Failed to watch directory {}!", pWatch->AbsolutePath.string().c_str());
+			if (pWatch->Handle != INVALID_HANDLE_VALUE)
+				CloseHandle(pWatch->Handle);
+			pWatch->Handle = INVALID_HANDLE_VALUE;
+			pWatch->HasFailed = true;
+			hasFailedWatches = true;
+			continue;
+		}
+
+		pWatch->Buffer.resize(NOTIFY_BUFFER_SIZE);
+		hasFailedWatches |= !IssueRead(pWatch.get());
+	}
+	return hasFailedWatches;
+}
+
+bool FileWatcher::IssueRead(DirectoryWatch* pWatch)
+{
+	pWatch->Overlapped = {};
+	BOOL result = ReadDirectoryChangesW(pWatch->Handle, pWatch->Buffer.data(), (DWORD)pWatch->Buffer.size(), pWatch->Recursive ? TRUE : FALSE,
+		NOTIFY_FILTER, NULL, &pWatch->Overlapped, NULL);
+	if (!result)
+		pWatch->HasFailed = true;
+	return result;
+}
+
+bool FileWatcher::ProcessNotifications(DirectoryWatch* pWatch, DWORD numBytes, std::unordered_map<std::string, PendingChange>& pending)
+{
+	// The buffer overflowed and the changes are lost, check all files and watched directories which the directory handle covers instead.
+	bool hasChanges = false;
+	if (numBytes == 0)
+	{
+		auto IsUnder = [](const std::string& key, const std::string& parentKey, bool recursive)
+		{
+			if (key.compare(0, parentKey.size() + 1, parentKey + "/") != 0)
+				return false;
+			return recursive || key.find('/', parentKey.size() + 1) == std::string::npos;
+		};
+
+		for (auto& [key, file] : m_WatchList)
+		{
+			if (IsUnder(key, pWatch->Key, pWatch->Recursive))
+			{
+				pending[key] = { file.Path, true };
+				hasChanges = true;
+			}
+		}
+
+		std::vector<std::filesystem::path> modifiedFiles;
+		for (WatchedDirectory& directory : m_WatchedDirectories)
+		{
+			bool isCovered = directory.Key == pWatch->Key || IsUnder(directory.Key, pWatch->Key, pWatch->Recursive) || IsUnder(pWatch->Key, directory.Key, directory.Recursive);
+			if (isCovered)
+				ScanDirectory(directory, modifiedFiles);
+		}
+		for (const std::filesystem::path& path : modifiedFiles)
+			hasChanges |= AddPendingChange(path, pending);
+		return hasChanges;
+	}
+
+	const uint8* pData = pWatch->Buffer.data();
+	while (true)
+	{
+		const FILE_NOTIFY_INFORMATION* pInfo = (const FILE_NOTIFY_INFORMATION*)pData;
+		m_Stats.NumEvents++;
+		if (pInfo->Action == FILE_ACTION_MODIFIED || pInfo->Action == FILE_ACTION_ADDED || pInfo->Action == FILE_ACTION_RENAMED_NEW_NAME)
+		{
+			std::wstring name(pInfo->FileName, pInfo->FileNameLength / sizeof(WCHAR));
+			hasChanges |= AddPendingChange((pWatch->AbsolutePath / name).lexically_normal(), pending);
+		}
+
+		if (pInfo->NextEntryOffset == 0)
+			break;
+		pData += pInfo->NextEntryOffset;
+	}
+	return hasChanges;
+}
+
+bool FileWatcher::AddPendingChange(const std::filesystem::path& absolutePath, std::unordered_map<std::string, PendingChange>& pending)
+{
+	std::string key = GetKey(absolutePath);
+	auto it = m_WatchList.find(key);
+	if (it != m_WatchList.end())
+	{
+		pending[key] = { it->second.Path, true };
+		return true;
+	}
+
+	std::error_code error;
+	for (WatchedDirectory& directory : m_WatchedDirectories)
+	{
+		if (key.compare(0, directory.Key.size() + 1, directory.Key + "/") != 0)
+			continue;
+		if (!directory.Recursive && key.find('/', directory.Key.size() + 1) != std::string::npos)
+			continue;
+		if (!std::filesystem::is_regular_file(absolutePath, error))
+			continue;
+
+		// Remembered such that a rescan after lost notifications only finds files which were not reported yet.
+		directory.FileTimes[key] = GetWriteTime(absolutePath);
+		std::filesystem::path relativePath = absolutePath.lexically_relative(directory.AbsolutePath);
+		pending[key] = { (std::filesystem::path(directory.Path) / relativePath).generic_string(), false };
+		return true;
+	}
+	return false;
+}
+
+void FileWatcher::CloseDirectoryWatches()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	for (auto& pWatch : m_DirectoryWatches)
+	{
+		if (pWatch->Handle == INVALID_HANDLE_VALUE)
+			continue;
+
+		// Wait for the cancelled read before the buffer is freed.
+		DWORD numBytes = 0;
+		if (CancelIoEx(pWatch->Handle, &pWatch->Overlapped) || GetLastError() != ERROR_NOT_FOUND)
+			GetOverlappedResult(pWatch->Handle, &pWatch->Overlapped, &numBytes, TRUE);
+		CloseHandle(pWatch->Handle);
+		pWatch->Handle = INVALID_HANDLE_VALUE;
+	}
+	m_DirectoryWatches.clear();
+}
+
+void FileWatcher::PollFiles(std::unique_lock<std::mutex>& lock, std::vector<std::string>& outModifiedFiles)
+{
+	// Files are copied, such that AddFile can be called while polling. The directories are only read by the watcher thread and can be moved out,
+	// directories which are added while polling are put after them.
+	std::vector<std::pair<std::string, WatchedFile>> files(m_WatchList.begin(), m_WatchList.end());
+	std::vector<WatchedDirectory> directories = std::move(m_WatchedDirectories);
+	m_WatchedDirectories.clear();
+	lock.unlock();
+
+	std::vector<std::pair<std::string, WatchedFile>> modifiedFiles;
+	for (auto& [key, file] : files)
+	{
+		// Check if the file was modified, if that was the case, add it to the modified list.
+		std::filesystem::file_time_type writeTime = GetWriteTime(file.Path);
+		if (writeTime != std::filesystem::file_time_type::min() && writeTime != file.WriteTime)
+		{
+			file.WriteTime = writeTime;
+			modifiedFiles.emplace_back(key, file);
+		}
+	}
+
+	std::vector<std::filesystem::path> modifiedPaths;
+	for (WatchedDirectory& directory : directories)
+	{
+		modifiedPaths.clear();
+		ScanDirectory(directory, modifiedPaths);
+		for (const std::filesystem::path& path : modifiedPaths)
+			outModifiedFiles.push_back((std::filesystem::path(directory.Path) / path.lexically_relative(directory.AbsolutePath)).generic_string());
+	}
+
+	lock.lock();
+	for (auto& [key, file] : modifiedFiles)
+	{
+		auto it = m_WatchList.find(key);
+		if (it != m_WatchList.end())
+			it->second.WriteTime = file.WriteTime;
+		outModifiedFiles.push_back(file.Path);
+	}
+	directories.insert(directories.end(), std::make_move_iterator(m_WatchedDirectories.begin()), std::make_move_iterator(m_WatchedDirectories.end()));
+	m_WatchedDirectories = std::move(directories);
+}
+
+void FileWatcher::ScanDirectory(WatchedDirectory& directory, std::vector<std::filesystem::path>& outModifiedFiles)
+{
+	std::error_code error;
+	auto CheckFile = [&](const std::filesystem::directory_entry& entry)
+	{
+		if (!entry.is_regular_file(error))
+			return;
+
+		std::filesystem::file_time_type writeTime = GetWriteTime(entry.path());
+		auto [it, isNew] = directory.FileTimes.try_emplace(GetKey(entry.path()), writeTime);
+		if (isNew || it->second != writeTime)
+		{
+			it->second = writeTime;
+			outModifiedFiles.push_back(entry.path().lexically_normal());
+		}
+	};
+
+	if (directory.Recursive)
+	{
+		for (const auto& entry : std::filesystem::recursive_directory_iterator(directory.AbsolutePath, error))
+			CheckFile(entry);
+	}
+	else
+	{
+		for (const auto& entry : std::filesystem::directory_iterator(directory.AbsolutePath, error))
+			CheckFile(entry);
+	}
+}
+
+void FileWatcher::CallCallbacks(std::vector<std::string>& modifiedFiles, std::unique_lock<std::mutex>& lock)
+{
+	if (modifiedFiles.empty())
+		return;
+
+	// Call the callbacks without holding the lock, such that they can add files.
+	m_Stats.NumCallbacks++;
+	std::vector<FileCallback> callbacks = m_CallbackList;
+	lock.unlock();
+	for (FileCallback& fCallBack : callbacks)
+		fCallBack.callback(modifiedFiles);
+	lock.lock();
+}
+
+std::string FileWatcher::GetKey(const std::filesystem::path& path)
+{
+	// Paths on Windows are not case sensitive.
+	std::error_code error;
+	std::string key = std::filesystem::absolute(path, error).lexically_normal().generic_string();
+	std::transform(key.begin(), key.end(), key.begin(), [](char c) { return (char)std::tolower((unsigned char)c); });
+	return key;
+}
+
+std::filesystem::file_time_type FileWatcher::GetWriteTime(const std::filesystem::path& path)
+{
+	// Editors can remove the file for a moment when saving, it is then treated as unchanged.
+	std::error_code error;
+	std::filesystem::file_time_type writeTime = std::filesystem::last_write_time(path, error);
+	return error ? std::filesystem::file_time_type::min() : writeTime;
+}
@@ -5,10 +5,15 @@
 #include <vector>
 #include <unordered_map>
 #include <mutex>
+#include <condition_variable>
 #include <functional>
 
 namespace RS
 {
+	/*
+	* Watches files and directories on a background thread and calls the callbacks with the files which were modified.
+	* The callbacks are only called when something has changed, and they are called from the watcher thread.
+	*/
 	class FileWatcher
 	{
 	public:
@@ -17,29 +22,125 @@ namespace RS
 			std::function<void(std::vector<std::string>)> callback;
 		};
 
+		enum class Backend : uint32
+		{
+			/*
+				Checks the write time of every watched file each delay.
+			*/
+			POLLING = 0,
+			/*
+				Waits for change notifications from the OS (ReadDirectoryChangesW), one for each watched directory.
+				Falls back to POLLING if the notifications could not be set up.
+			*/
+			EVENTS
+		};
+
+		struct Stats
+		{
+			Backend	ActiveBackend			= Backend::POLLING;
+			uint32	NumWatchedFiles			= 0;
+			uint32	NumWatchedDirectories	= 0;
+			uint64	NumWakeUps				= 0; // Number of times the watcher thread did any work.
+			uint64	NumEvents				= 0; // Number of changes reported by the OS or found when polling, before debouncing.
+			uint64	NumCallbacks			= 0; // Number of batches of modified files passed to the callbacks.
+			float	LastLatencyMS			= 0.f; // Time from the first change of the last batch until the callbacks were called.
+		};
+
 	public:
 		FileWatcher();
 		~FileWatcher();
 
 		void AddFile(const std::string& filePath);
 
-		void Init(uint32_t delay);
+		/*
+		* Watch all files in the directory. The reported path of a modified file is the directory path followed by the relative path of the file.
+		*/
+		void AddDirectory(const std::string& directoryPath, bool recursive);
+
+		/*
+		* delay: The time between each check when polling.
+		* debounce: Changes are collected until no new changes have been seen for this long, such that an editor which writes a file in several steps only triggers one callback.
+		*/
+		void Init(uint32_t delay, Backend backend = Backend::EVENTS, uint32_t debounce = 50);
 		void Release();
 
 		void AddCallBack(FileCallback callback);
 
+		Stats GetStats();
+
 	private:
+		struct WatchedFile
+		{
+			std::string							Path		= "";
+			std::filesystem::file_time_type		WriteTime;
+		};
+
+		struct WatchedDirectory
+		{
+			std::string							Path		= "";
+			std::filesystem::path				AbsolutePath;
+			std::string							Key			= "";
+			bool								Recursive	= false;
+			std::unordered_map<std::string, std::filesystem::file_time_type> FileTimes; // Last seen write times, used when polling and to rescan after lost notifications.
+		};
+
+		/*
+		* A directory handle which receives change notifications, one for each directory which contains watched files.
+		*/
+		struct DirectoryWatch
+		{
+			std::filesystem::path				AbsolutePath;
+			std::string							Key			= "";
+			bool								Recursive	= false;
+			bool								HasFailed	= false;
+			HANDLE								Handle		= INVALID_HANDLE_VALUE;
+			OVERLAPPED							Overlapped	= {};
+			std::vector<uint8>					Buffer;
+		};
+
+		struct PendingChange
+		{
+			std::string							Path		= "";
+			bool								IsFile		= false; // The change belongs to a file added with AddFile, otherwise a watched directory.
+		};
+
 		void Watcher();
+		void EventWatcher();
+
+		// Event backend
+		void RequestDirectoryWatch(const std::filesystem::path& absolutePath, bool recursive);
+		bool StartDirectoryWatches(); // Returns true if any directory could not be watched.
+		bool IssueRead(DirectoryWatch* pWatch);
+		bool ProcessNotifications(DirectoryWatch* pWatch, DWORD numBytes, std::unordered_map<std::string, PendingChange>& pending);
+		bool AddPendingChange(const std::filesystem::path& absolutePath, std::unordered_map<std::string, PendingChange>& pending);
+		void CloseDirectoryWatches();
+
+		// Polling
+		/*
+		* The file system is checked without holding the lock, the watched files and directories are taken out of the lists for the duration.
+		*/
+		void PollFiles(std::unique_lock<std::mutex>& lock, std::vector<std::string>& outModifiedFiles);
+		void ScanDirectory(WatchedDirectory& directory, std::vector<std::filesystem::path>& outModifiedFiles);
+
+		void CallCallbacks(std::vector<std::string>& modifiedFiles, std::unique_lock<std::mutex>& lock);
+
+		static std::string GetKey(const std::filesystem::path& path);
+		static std::filesystem::file_time_type GetWriteTime(const std::filesystem::path& path);
 
 	private:
-		std::mutex															m_Mutex;
-		bool																m_ShouldRelease = false;
-		bool																m_RequestStop = false;
-		std::thread* m_pWatcherThread = nullptr;
-		std::vector<FileCallback>											m_CallbackList;
-		std::unordered_map<std::string, std::filesystem::file_time_type>	m_WatchList;
-		std::unordered_map<std::string, std::filesystem::file_time_type>	m_WatchListThread;
-		std::vector<std::string>											m_ModifiedFiles;
-		std::chrono::duration<uint32_t, std::milli>							m_DelayDuration;
+		std::mutex												m_Mutex;
+		std::condition_variable									m_StopCondition;
+		bool													m_ShouldRelease		= false;
+		bool													m_RequestStop		= false;
+		std::thread*											m_pWatcherThread	= nullptr;
+		std::vector<FileCallback>								m_CallbackList;
+		std::unordered_map<std::string, WatchedFile>			m_WatchList;		// Key is from GetKey.
+		std::vector<WatchedDirectory>							m_WatchedDirectories;
+		std::vector<std::unique_ptr<DirectoryWatch>>			m_DirectoryWatches;
+		HANDLE													m_CompletionPort	= NULL;
+		Backend													m_Backend			= Backend::POLLING;
+		std::chrono::duration<uint32_t, std::milli>				m_DelayDuration;
+		std::chrono::duration<uint32_t, std::milli>				m_DebounceDuration;
+		Stats													m_Stats;
 	};
-}
\ No newline at end of file
+}
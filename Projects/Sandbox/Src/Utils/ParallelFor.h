@@ -0,0 +1,30 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace RS
+{
+	/*
+	* Call func(index, threadIndex) for each index in [0, count), each thread takes the next index which has not been started.
+	* The calling thread is thread 0, numThreads of one runs everything on the calling thread.
+	*/
+	template<typename Func>
+	void ParallelFor(uint32 numThreads, uint32 count, Func func)
+	{
+		std::atomic<uint32> nextIndex = 0;
+		auto Worker = [&](uint32 threadIndex)
+		{
+			for (uint32 index = nextIndex++; index < count; index = nextIndex++)
+				func(index, threadIndex);
+		};
+
+		std::vector<std::thread> threads;
+		for (uint32 i = 1; i < numThreads; i++)
+			threads.emplace_back(Worker, i);
+		Worker(0);
+		for (std::thread& thread : threads)
+			thread.join();
+	}
+}
@@ -0,0 +1,81 @@
+#include "PreCompiled.h"
+#include "WorkerPool.h"
+
+#include <algorithm>
+
+using namespace RS;
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_ShouldStop = true;
+	}
+	m_StartCondition.notify_all();
+	for (std::thread& thread : m_Threads)
+		thread.join();
+}
+
+void WorkerPool::ParallelFor(uint32 numThreads, uint32 count, const std::function<void(uint32, uint32)>& func)
+{
+	numThreads = std::min(numThreads, count);
+	if (numThreads <= 1)
+	{
+		for (uint32 index = 0; index < count; index++)
+			func(index, 0);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		// New workers wait for the next call, such that they do not take part in one which has already finished.
+		for (uint32 threadIndex = (uint32)m_Threads.size() + 1; threadIndex < numThreads; threadIndex++)
+			m_Threads.emplace_back(&WorkerPool::WorkerMain, this, threadIndex, m_Generation);
+
+		m_pFunc			= &func;
+		m_Count			= count;
+		m_NextIndex		= 0;
+		m_NumActive		= numThreads;
+		m_NumRunning	= numThreads - 1;
+		m_Generation++;
+	}
+	m_StartCondition.notify_all();
+
+	for (uint32 index = m_NextIndex++; index < count; index = m_NextIndex++)
+		func(index, 0);
+
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	m_DoneCondition.wait(lock, [this]() { return m_NumRunning == 0; });
+	m_pFunc = nullptr;
+}
+
+uint32 WorkerPool::GetNumThreads() const
+{
+	return (uint32)m_Threads.size() + 1;
+}
+
+void WorkerPool::WorkerMain(uint32 threadIndex, uint64 generation)
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	while (true)
+	{
+		m_StartCondition.wait(lock, [&]() { return m_ShouldStop || m_Generation != generation; });
+		if (m_ShouldStop)
+			return;
+
+		// A call which asked for fewer threads is skipped.
+		generation = m_Generation;
+		if (threadIndex >= m_NumActive)
+			continue;
+
+		const std::function<void(uint32, uint32)>& func = *m_pFunc;
+		const uint32 count = m_Count;
+		lock.unlock();
+		for (uint32 index = m_NextIndex++; index < count; index = m_NextIndex++)
+			func(index, threadIndex);
+		lock.lock();
+
+		if (--m_NumRunning == 0)
+			m_DoneCondition.notify_one();
+	}
+}
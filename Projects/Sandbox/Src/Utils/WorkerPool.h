@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace RS
+{
+	/*
+	* Runs ParallelFor on threads which are started on the first call and then wait for the next one, for work which is split up every frame.
+	* The calling thread is thread 0. One call runs at a time, the pool is not thread safe.
+	* Example:
+	*	WorkerPool workers;
+	*	workers.ParallelFor(4, 100, [&](uint32 index, uint32 threadIndex) { ... });
+	*/
+	class WorkerPool
+	{
+	public:
+		RS_NO_COPY_AND_MOVE(WorkerPool);
+		WorkerPool() = default;
+		~WorkerPool();
+
+		/*
+		* Call func(index, threadIndex) for each index in [0, count), the same as ParallelFor in Utils/ParallelFor.h.
+		* Threads are only added when more are asked for than before, one thread runs everything on the calling thread.
+		*/
+		void ParallelFor(uint32 numThreads, uint32 count, const std::function<void(uint32, uint32)>& func);
+
+		uint32 GetNumThreads() const; // Including the calling thread.
+
+	private:
+		void WorkerMain(uint32 threadIndex, uint64 generation);
+
+	private:
+		std::vector<std::thread>					m_Threads;
+		std::mutex									m_Mutex;
+		std::condition_variable						m_StartCondition;
+		std::condition_variable						m_DoneCondition;
+		const std::function<void(uint32, uint32)>*	m_pFunc			= nullptr;
+		uint32										m_Count			= 0;
+		std::atomic<uint32>							m_NextIndex		= 0;
+		uint32										m_NumActive		= 0; // Threads with a lower index take part in the current call.
+		uint32										m_NumRunning	= 0; // Workers which have not finished the current call.
+		uint64										m_Generation	= 0; // Increased by each call.
+		bool										m_ShouldStop	= false;
+	};
+}
@@ -0,0 +1,161 @@
+#include "PreCompiled.h"
+#include "Test.h"
+
+#include "AssetCooker.h"
+#include "Core/VirtualFileSystem.h"
+#include "Loaders/CookedAssets.h"
+
+#include <filesystem>
+#include <fstream>
+
+using namespace RS;
+
+namespace
+{
+	const uint32 TERRAIN_SIZE = 64;
+
+	void WriteTerrain(const std::filesystem::path& path, uint16 firstHeight)
+	{
+		std::vector<uint16> heights((size_t)TERRAIN_SIZE * TERRAIN_SIZE);
+		for (uint32 i = 0; i < (uint32)heights.size(); i++)
+			heights[i] = (uint16)(i * 7);
+		heights[0] = firstHeight;
+
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		file.write((const char*)heights.data(), (std::streamsize)(heights.size() * sizeof(uint16)));
+	}
+
+	// Makes an asset folder with one image and one terrain, which the cooker reads through the file system, like the Cooker tool.
+	std::filesystem::path MakeAssetFolder()
+	{
+		std::filesystem::path folder = std::filesystem::temp_directory_path() / "RSAssetCookerTests";
+		std::error_code error;
+		std::filesystem::remove_all(folder, error);
+		std::filesystem::create_directories(folder / "Textures");
+		std::filesystem::create_directories(folder / "Terrains");
+		std::filesystem::copy_file(std::filesystem::path(RS_MODEL_PATH) / "FlightHelmet/FlightHelmet_normal2.png", folder / "Textures/Normal.png");
+		WriteTerrain(folder / "Terrains/Flat.r16", 0);
+
+		VirtualFileSystem::Get()->UnmountAll();
+		VirtualFileSystem::Get()->MountLooseFiles(folder.string());
+		return folder;
+	}
+
+	void RemoveAssetFolder(const std::filesystem::path& folder)
+	{
+		VirtualFileSystem::Get()->UnmountAll();
+		VirtualFileSystem::Get()->MountLooseFiles(RS_ASSET_PATH);
+		std::error_code error;
+		std::filesystem::remove_all(folder, error);
+	}
+
+	// Each cook is done by a new cooker, such that the dependency database is loaded from the disk like a new run of the tool.
+	AssetCooker::Stats Cook(const std::filesystem::path& folder, bool force)
+	{
+		AssetCooker cooker(folder.string());
+		AssetCooker::Stats stats;
+		bool succeeded = cooker.Cook(2, force, stats);
+		RS_CHECK(succeeded, "The cook failed with {} failed assets", stats.NumFailed);
+		return stats;
+	}
+}
+
+RS_TEST(AssetCookerCooksAllAssets)
+{
+	std::filesystem::path folder = MakeAssetFolder();
+	AssetCooker::Stats stats = Cook(folder, false);
+	RS_CHECK(stats.NumAssets == 2 && stats.NumCooked == 2 && stats.NumUpToDate == 0, "Cooked {} and skipped {} of {} assets", stats.NumCooked, stats.NumUpToDate, stats.NumAssets);
+	RS_CHECK(stats.CookedBytes > 0 && stats.SourceBytes > 0, "Cooked {} bytes from {} bytes", stats.CookedBytes, stats.SourceBytes);
+
+	const std::string cookedTerrainPath = VirtualFileSystem::NormalizePath(CookedAssets::GetCookedTerrainPath("Terrains/Flat.r16"));
+	RS_CHECK(std::filesystem::exists(folder / cookedTerrainPath), "{} was not written", cookedTerrainPath);
+	RS_CHECK(std::filesystem::exists(folder / "Cooked/CookDatabase.json"), "The dependency database was not written");
+
+	CookedAssets::CookedImage image;
+	bool readImage = CookedAssets::ReadImage("Textures/Normal.png", 4, image);
+	RS_CHECK(readImage && image.Width > 0 && image.Height > 0, "The cooked image could not be read back ({} x {})", image.Width, image.Height);
+
+	// A source which was changed after the cook is loaded instead of the cooked file.
+	{
+		std::ofstream source(folder / "Textures/Normal.png", std::ios::binary | std::ios::app);
+		source.put(0);
+	}
+	readImage = CookedAssets::ReadImage("Textures/Normal.png", 4, image);
+	RS_CHECK(readImage == false, "The cooked image was read after its source was changed");
+
+	RemoveAssetFolder(folder);
+}
+
+RS_TEST(AssetCookerSkipsUnchangedAssets)
+{
+	std::filesystem::path folder = MakeAssetFolder();
+	Cook(folder, false);
+
+	// Nothing changed, the sizes and write times are enough to know that.
+	AssetCooker::Stats stats = Cook(folder, false);
+	RS_CHECK(stats.NumCooked == 0 && stats.NumUpToDate == 2, "Cooked {} and skipped {} unchanged assets", stats.NumCooked, stats.NumUpToDate);
+	RS_CHECK(stats.NumHashedFiles == 0, "Hashed {} files which were not written to", stats.NumHashedFiles);
+
+	// Written with the same content, the file is hashed once and the new write time is remembered.
+	const std::filesystem::file_time_type writeTime = std::filesystem::last_write_time(folder / "Terrains/Flat.r16");
+	WriteTerrain(folder / "Terrains/Flat.r16", 0);
+	std::filesystem::last_write_time(folder / "Terrains/Flat.r16", writeTime + std::chrono::seconds(2));
+	stats = Cook(folder, false);
+	RS_CHECK(stats.NumCooked == 0 && stats.NumUpToDate == 2 && stats.NumHashedFiles == 1, "Cooked {}, skipped {} and hashed {} files after a touch",
+		stats.NumCooked, stats.NumUpToDate, stats.NumHashedFiles);
+	stats = Cook(folder, false);
+	RS_CHECK(stats.NumHashedFiles == 0, "Hashed {} files after the write time was remembered", stats.NumHashedFiles);
+
+	// A changed height has the same size, only the hash finds it.
+	WriteTerrain(folder / "Terrains/Flat.r16", 1);
+	std::filesystem::last_write_time(folder / "Terrains/Flat.r16", writeTime + std::chrono::seconds(4));
+	stats = Cook(folder, false);
+	RS_CHECK(stats.NumCooked == 1 && stats.NumUpToDate == 1, "Cooked {} and skipped {} assets after one was changed", stats.NumCooked, stats.NumUpToDate);
+
+	// A missing output is cooked again.
+	std::filesystem::remove(folder / VirtualFileSystem::NormalizePath(CookedAssets::GetCookedImagePath("Textures/Normal.png")));
+	stats = Cook(folder, false);
+	RS_CHECK(stats.NumCooked == 1 && stats.NumUpToDate == 1, "Cooked {} and skipped {} assets after an output was removed", stats.NumCooked, stats.NumUpToDate);
+
+	// Force cooks everything.
+	stats = Cook(folder, true);
+	RS_CHECK(stats.NumCooked == 2 && stats.NumUpToDate == 0, "Cooked {} and skipped {} assets when forced", stats.NumCooked, stats.NumUpToDate);
+
+	RemoveAssetFolder(folder);
+}
+
+RS_TEST(CookDatabaseDiscardsOtherToolVersions)
+{
+	std::filesystem::path folder = MakeAssetFolder();
+	Cook(folder, false);
+
+	const std::string databasePath = (folder / "Cooked/CookDatabase.json").string();
+	CookDatabase database(folder.string());
+	RS_CHECK(database.Load(databasePath, CookedAssets::VERSION), "The database of this version could not be loaded");
+	RS_CHECK(database.IsUpToDate("Textures/Normal.png", "Image"), "The image is not up to date in the database of this version");
+	RS_CHECK(database.IsUpToDate("Textures/Normal.png", "Image Mips") == false, "The image is up to date with other options");
+
+	CookDatabase newerDatabase(folder.string());
+	RS_CHECK(newerDatabase.Load(databasePath, CookedAssets::VERSION + 1) == false, "The database of another version was loaded");
+	RS_CHECK(newerDatabase.IsUpToDate("Textures/Normal.png", "Image") == false, "An entry of another version is up to date");
+
+	RemoveAssetFolder(folder);
+}
+
+RS_TEST(CookedAssetsExpandsThreeChannels)
+{
+	// The source images are converted with the same function as the cooked images, three channels become four either way.
+	CookedAssets::CookedImage image;
+	image.Width			= 2;
+	image.Height		= 1;
+	image.NumChannels	= 3;
+	image.Data			= { 10, 20, 30, 40, 50, 60 };
+	CookedAssets::CookedImage requested = image;
+
+	CookedAssets::ConvertToTextureChannels(image, 0);
+	CookedAssets::ConvertToTextureChannels(requested, 3);
+	const std::vector<uint8> expected = { 10, 20, 30, 255, 40, 50, 60, 255 };
+	RS_CHECK(image.NumChannels == 4 && image.Data == expected, "The image kept {} channels with {} bytes", image.NumChannels, image.Data.size());
+	RS_CHECK(requested.NumChannels == 4 && requested.Data == expected, "Three requested channels gave {} channels with {} bytes",
+		requested.NumChannels, requested.Data.size());
+}
@@ -0,0 +1,110 @@
+#include "PreCompiled.h"
+#include "Test.h"
+
+#include "Renderer/DebugFont.h"
+#include "Utils/Timer.h"
+
+#include <algorithm>
+#include <filesystem>
+
+using namespace RS;
+
+namespace
+{
+	const float ADVANCE		= 10.f;
+	const float LINE_HEIGHT	= 20.f;
+
+	// A font which does not depend on the fonts on the machine, each glyph is a box of one advance by one line.
+	DebugFont MakeMonospaceFont()
+	{
+		DebugFont font;
+		font.InitMonospace(ADVANCE, LINE_HEIGHT);
+		font.SetKerning('A', 'V', -2.f);
+		return font;
+	}
+}
+
+RS_TEST(DebugFontLaysOutText)
+{
+	struct Case
+	{
+		std::string_view		Text;
+		float					MaxWidth = 0.f;
+		std::vector<glm::vec2>	Positions; // Top left of each quad.
+		glm::vec2				Size;
+	};
+
+	const Case cases[] =
+	{
+		{ "ab",			0.f,	{ { 0.f, 0.f }, { 10.f, 0.f } },											{ 20.f, 20.f } },
+		{ "a b",		0.f,	{ { 0.f, 0.f }, { 20.f, 0.f } },											{ 30.f, 20.f } },
+		{ "ab\ncd",		0.f,	{ { 0.f, 0.f }, { 10.f, 0.f }, { 0.f, 20.f }, { 10.f, 20.f } },				{ 20.f, 40.f } },
+		{ "AV",			0.f,	{ { 0.f, 0.f }, { 8.f, 0.f } },												{ 18.f, 20.f } },
+		// The second word does not fit after the first one.
+		{ "aaa bbb",	50.f,	{ { 0.f, 0.f }, { 10.f, 0.f }, { 20.f, 0.f }, { 0.f, 20.f }, { 10.f, 20.f }, { 20.f, 20.f } }, { 40.f, 40.f } },
+		// The space at the end of the line is dropped.
+		{ "aaa bb",		30.f,	{ { 0.f, 0.f }, { 10.f, 0.f }, { 20.f, 0.f }, { 0.f, 20.f }, { 10.f, 20.f } },	{ 30.f, 40.f } },
+		// A word which is wider than a line.
+		{ "abcdefg",	30.f,	{ { 0.f, 0.f }, { 10.f, 0.f }, { 20.f, 0.f }, { 0.f, 20.f }, { 10.f, 20.f }, { 20.f, 20.f }, { 0.f, 40.f } }, { 30.f, 60.f } },
+	};
+
+	DebugFont font = MakeMonospaceFont();
+	std::vector<DebugFont::Quad> quads;
+	for (const Case& testCase : cases)
+	{
+		quads.clear();
+		glm::vec2 size = font.Layout(testCase.Text, testCase.MaxWidth, [&](const DebugFont::Quad& quad) { quads.push_back(quad); });
+
+		bool isSame = size == testCase.Size && quads.size() == testCase.Positions.size();
+		for (size_t i = 0; isSame && i < quads.size(); i++)
+			isSame = quads[i].Min == testCase.Positions[i] && quads[i].Max == testCase.Positions[i] + glm::vec2(ADVANCE, LINE_HEIGHT);
+		RS_CHECK(isSame, "The layout of \"{}\" with a width of {} is wrong", testCase.Text, testCase.MaxWidth);
+	}
+}
+
+RS_TEST(DebugFontLaysOutLabels)
+{
+	// The layout of the labels of a busy frame.
+	const uint32 numLabels = 50000;
+	std::vector<std::string> labels(numLabels);
+	for (uint32 i = 0; i < numLabels; i++)
+		labels[i] = "Object " + std::to_string(i) + " (" + std::to_string(i % 97) + " children)";
+
+	DebugFont font = MakeMonospaceFont();
+	uint32 numQuads = 0;
+	size_t numVisible = 0;
+	Timer timer;
+	for (const std::string& label : labels)
+		font.Layout(label, 0.f, [&](const DebugFont::Quad&) { numQuads++; });
+	float timeMS = timer.Stop().GetDeltaTimeMS();
+
+	LOG_INFO("Debug text layout of {} labels: {:.3f} ms for {} glyphs.", numLabels, timeMS, numQuads);
+	for (const std::string& label : labels)
+		numVisible += label.size() - std::count(label.begin(), label.end(), ' ');
+	RS_CHECK(numQuads == numVisible, "{} glyphs were laid out for {} visible characters", numQuads, numVisible);
+}
+
+RS_TEST(DebugFontLoadsTheShippedFont)
+{
+	// The font in the asset folder, rasterized into an empty cache folder and then read back from it.
+	const std::filesystem::path cacheFolder = std::filesystem::temp_directory_path() / "RSDebugFontTests";
+	std::error_code error;
+	std::filesystem::remove_all(cacheFolder, error);
+	const std::string fontPath = "Fonts/SourceCodePro-Regular.ttf";
+
+	DebugFont rasterized, cached;
+	const bool isRasterized = rasterized.Load(fontPath, 32.f, 512, cacheFolder.string() + "/");
+	const bool isCached = cached.Load(fontPath, 32.f, 512, cacheFolder.string() + "/");
+	RS_CHECK(isRasterized && isCached, "[{}] could not be {}", fontPath, isRasterized ? "read from the cache" : "rasterized");
+	if (isRasterized && isCached)
+	{
+		RS_CHECK(rasterized.GetAtlas() == cached.GetAtlas() && rasterized.GetLineHeight() == cached.GetLineHeight(), "The cached atlas differs from the rasterized one");
+
+		// A monospace font, each character has the same advance.
+		const glm::vec2 narrow = cached.Layout("iiii", 0.f, [](const DebugFont::Quad&) {});
+		const glm::vec2 wide = cached.Layout("MMMM", 0.f, [](const DebugFont::Quad&) {});
+		RS_CHECK(narrow.x > 0.f && narrow.x == wide.x, "\"iiii\" is {} pixels wide and \"MMMM\" is {}", narrow.x, wide.x);
+	}
+
+	std::filesystem::remove_all(cacheFolder, error);
+}
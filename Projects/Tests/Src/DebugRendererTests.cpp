@@ -0,0 +1,551 @@
+#include "PreCompiled.h"
+#include "Test.h"
+
+#include "Renderer/DebugRenderer.h"
+#include "Loaders/CookedAssets.h"
+#include "Utils/Timer.h"
+
+#include <algorithm>
+#include <future>
+#include <memory>
+#include <random>
+#include <thread>
+
+using namespace RS;
+
+/*
+* The checks and benchmarks of DebugRenderer. The renderers are not initialized, so nothing is drawn, but the buffers are uploaded to the device.
+*/
+namespace
+{
+	// The same layout as the line vertices of DebugRenderer.
+	struct Vertex
+	{
+		glm::vec3 Position;
+		glm::vec3 Color;
+	};
+
+	using LineBuffer	= DebugPrimitiveBuffer<Vertex>;
+	using LineGroup		= LineBuffer::Group;
+
+	const uint32 NUM_FRAMES = 60;
+
+	float ToMB(uint64 bytes)
+	{
+		return (float)bytes / (1024.f * 1024.f);
+	}
+}
+
+RS_DEVICE_TEST(DebugRendererUploadsOnlyChangedGroups)
+{
+	// 1M static lines and 10k lines which change each frame.
+	const uint32 numStaticLines		= 1000000;
+	const uint32 numDynamicLines	= 10000;
+
+	auto AppendLines = [](std::vector<Vertex>& vertices, uint32 numLines, uint32 frame)
+	{
+		Vertex v;
+		v.Color = glm::vec3(1.f, 0.f, 0.f);
+		for (uint32 i = 0; i < numLines; i++)
+		{
+			v.Position = glm::vec3((float)(i % 1000), (float)frame, (float)(i / 1000)) * 0.1f;
+			vertices.push_back(v);
+			v.Position.y += 1.f;
+			vertices.push_back(v);
+		}
+	};
+
+	// The static lines are their own group, only the dynamic group is rewritten each frame.
+	LineBuffer retained(false);
+	LineGroup& staticGroup = retained.Groups[1];
+	staticGroup.IsStatic = true;
+	AppendLines(staticGroup.Elements, numStaticLines, 0);
+	retained.MarkDirty(staticGroup, 0);
+	LineGroup& dynamicGroup = retained.Groups[2];
+	retained.Update();
+
+	float retainedTimeMS = 0.f;
+	uint64 retainedBytes = 0;
+	for (uint32 frame = 0; frame < NUM_FRAMES; frame++)
+	{
+		Timer timer;
+		dynamicGroup.Elements.clear();
+		AppendLines(dynamicGroup.Elements, numDynamicLines, frame);
+		retained.MarkDirty(dynamicGroup, 0);
+		retained.Update();
+		retainedTimeMS += timer.Stop().GetDeltaTimeMS();
+		retainedBytes += retained.UploadedBytes;
+	}
+
+	// All lines gathered into one list and uploaded each frame, as it was done before the groups.
+	LineBuffer rebuilt(false);
+	LineGroup& allGroup = rebuilt.Groups[1];
+	float rebuiltTimeMS = 0.f;
+	uint64 rebuiltBytes = 0;
+	for (uint32 frame = 0; frame < NUM_FRAMES; frame++)
+	{
+		Timer timer;
+		allGroup.Elements.clear();
+		allGroup.Elements.insert(allGroup.Elements.end(), staticGroup.Elements.begin(), staticGroup.Elements.end());
+		AppendLines(allGroup.Elements, numDynamicLines, frame);
+		rebuilt.MarkDirty(allGroup, 0);
+		rebuilt.Update();
+		rebuiltTimeMS += timer.Stop().GetDeltaTimeMS();
+		rebuiltBytes += rebuilt.UploadedBytes;
+	}
+
+	LOG_INFO("Debug lines, {} static and {} changing each frame: {:.3f} ms and {:.2f} MB uploaded per frame with groups, {:.3f} ms and {:.2f} MB when rebuilt ({:.1f}x).",
+		numStaticLines, numDynamicLines, retainedTimeMS / NUM_FRAMES, ToMB(retainedBytes) / NUM_FRAMES,
+		rebuiltTimeMS / NUM_FRAMES, ToMB(rebuiltBytes) / NUM_FRAMES, retainedTimeMS > 0.f ? rebuiltTimeMS / retainedTimeMS : 1.f);
+	RS_CHECK(retained.NumElements == rebuilt.NumElements, "The groups hold {} vertices, the rebuilt list {}", retained.NumElements, rebuilt.NumElements);
+	RS_CHECK(retainedBytes < rebuiltBytes / 10, "The groups uploaded {} bytes, rebuilding uploaded {} bytes", retainedBytes, rebuiltBytes);
+
+	retained.Release();
+	rebuilt.Release();
+}
+
+RS_DEVICE_TEST(DebugRendererUploadsMovedGroups)
+{
+	auto AddGroup = [](PrimitiveBuffer<Vertex>& buffer, uint32 id, bool isStatic, uint32 numVertices) -> LineGroup&
+	{
+		LineGroup& group = buffer.Groups[id];
+		group.IsStatic = isStatic;
+		Vertex v;
+		v.Color = glm::vec3(0.f, 1.f, 0.f);
+		for (uint32 i = 0; i < numVertices; i++)
+		{
+			v.Position = glm::vec3((float)i, (float)id, 0.f);
+			group.Elements.push_back(v);
+		}
+		buffer.MarkDirty(group, 0);
+		return group;
+	};
+
+	// A static group which is not changed again. A dynamic group which does not fit makes the buffer be created again,
+	// and the static group has to be uploaded into the new buffer.
+	LineBuffer buffer(false);
+	LineGroup& staticGroup = AddGroup(buffer, 1, true, 200);
+	buffer.Update();
+	uint32 previousSize = buffer.Size;
+	AddGroup(buffer, 2, false, 100);
+	buffer.Update();
+	RS_CHECK(buffer.Size > previousSize && staticGroup.Offset == 0, "The buffer of {} vertices was not created again", previousSize);
+	RS_CHECK(buffer.UploadedBytes == LineBuffer::ELEMENT_SIZE * 300, "{} bytes uploaded after the buffer was created again, expected {}",
+		buffer.UploadedBytes, LineBuffer::ELEMENT_SIZE * 300);
+	buffer.Release();
+
+	// A static group behind a dynamic group. Removing the dynamic group leaves most of the buffer unused, so it is compacted
+	// and the static group is moved to the front, without creating the buffer again.
+	AddGroup(buffer, 1, false, 1000);
+	buffer.Update();
+	LineGroup& movedGroup = AddGroup(buffer, 2, true, 200);
+	buffer.Update();
+	previousSize = buffer.Size;
+	uint32 previousOffset = movedGroup.Offset;
+	buffer.RemoveGroup(1);
+	buffer.Update();
+	RS_CHECK(buffer.Size == previousSize && movedGroup.Offset != previousOffset, "The static group was not moved, it is at {} in a buffer of {} vertices",
+		movedGroup.Offset, buffer.Size);
+	RS_CHECK(buffer.UploadedBytes == LineBuffer::ELEMENT_SIZE * 200, "{} bytes uploaded after the compaction, expected {}",
+		buffer.UploadedBytes, LineBuffer::ELEMENT_SIZE * 200);
+
+	buffer.Release();
+}
+
+RS_DEVICE_TEST(DebugRendererPushesBoxesAsShapes)
+{
+	// Boxes as shapes, against boxes made of line vertices the way PushBox made them before (26 vertices, one edge twice).
+	const uint32 numBoxes = 100000;
+	std::vector<AABB> boxes(numBoxes);
+	for (uint32 i = 0; i < numBoxes; i++)
+	{
+		boxes[i].min = glm::vec3((float)(i % 100), (float)(i / 100 % 100), (float)(i / 10000));
+		boxes[i].max = boxes[i].min + glm::vec3(0.5f);
+	}
+
+	DebugRenderer shapeRenderer;
+	Timer shapeTimer;
+	shapeRenderer.PushBoxes(boxes);
+	shapeRenderer.Update();
+	float shapeTimeMS = shapeTimer.Stop().GetDeltaTimeMS();
+	const DebugRenderer::Stats& shapeStats = shapeRenderer.GetStats();
+	uint32 shapeBytes = shapeStats.NumberOfUploadedBytes;
+
+	DebugRenderer lineRenderer;
+	Timer lineTimer;
+	for (const AABB& box : boxes)
+	{
+		const glm::vec3& min = box.min;
+		const glm::vec3& max = box.max;
+		lineRenderer.PushLines({ min, glm::vec3(min.x, min.y, max.z), glm::vec3(min.x, max.y, max.z), glm::vec3(min.x, max.y, min.z), min }, Color::RED, 0, false);
+		lineRenderer.PushLines({ glm::vec3(max.x, min.y, min.z), glm::vec3(max.x, min.y, max.z), max, glm::vec3(max.x, max.y, min.z), glm::vec3(max.x, min.y, min.z) }, Color::RED, 0, false);
+		lineRenderer.PushLine(min, glm::vec3(max.x, min.y, min.z), Color::RED, 0, false);
+		lineRenderer.PushLine(glm::vec3(min.x, min.y, max.z), glm::vec3(max.x, min.y, max.z), Color::RED, 0, false);
+		lineRenderer.PushLine(glm::vec3(min.x, max.y, max.z), max, Color::RED, 0, false);
+		lineRenderer.PushLine(glm::vec3(min.x, max.y, min.z), glm::vec3(max.x, max.y, min.z), Color::RED, 0, false);
+		lineRenderer.PushLine(min, glm::vec3(max.x, min.y, min.z), Color::RED, 0, false);
+	}
+	lineRenderer.Update();
+	float lineTimeMS = lineTimer.Stop().GetDeltaTimeMS();
+	uint32 lineBytes = lineRenderer.GetStats().NumberOfUploadedBytes;
+
+	LOG_INFO("Debug boxes, {}: {:.3f} ms and {:.2f} MB as shapes ({} bytes each), {:.3f} ms and {:.2f} MB as lines ({} bytes each).",
+		numBoxes, shapeTimeMS, ToMB(shapeBytes), shapeBytes / numBoxes, lineTimeMS, ToMB(lineBytes), lineBytes / numBoxes);
+	RS_CHECK(shapeStats.NumberOfShapes == numBoxes, "{} shapes were pushed for {} boxes", shapeStats.NumberOfShapes, numBoxes);
+	RS_CHECK(shapeBytes < lineBytes, "The boxes take {} bytes as shapes and {} bytes as lines", shapeBytes, lineBytes);
+
+	shapeRenderer.Release();
+	lineRenderer.Release();
+}
+
+RS_DEVICE_TEST(DebugRendererExpiresTimedPrimitives)
+{
+	// Timed points, pushed during the first three seconds with lifetimes between 0.1 and 5 seconds.
+	const uint32 numTimed		= 100000;
+	const uint32 numPushFrames	= 180;
+	const float frameTime		= 1.f / 60.f;
+	DebugRenderer timed;
+	std::mt19937 generator(1337);
+	std::uniform_real_distribution<float> lifetimeDistribution(0.1f, 5.f);
+	std::vector<double> pushTimes;
+	std::vector<float> lifetimes;
+	pushTimes.reserve(numTimed);
+	lifetimes.reserve(numTimed);
+
+	// The time is advanced the same way as in the renderer, such that it is the same to the bit.
+	double time = 0.0;
+	float timedTimeMS = 0.f, maxTimedTimeMS = 0.f;
+	uint32 frame = 0;
+	for (; pushTimes.size() < numTimed || timed.GetStats().NumberOfTimedBuckets > 0; frame++)
+	{
+		Timer timer;
+		timed.NewFrame(frameTime);
+		time += (double)frameTime;
+		uint32 numToPush = std::min(numTimed / numPushFrames + 1, numTimed - (uint32)pushTimes.size());
+		for (uint32 i = 0; i < numToPush; i++)
+		{
+			float lifetime = lifetimeDistribution(generator);
+			timed.PushPoint(glm::vec3((float)i, 0.f, 0.f), Color::RED, 0, true, lifetime);
+			pushTimes.push_back(time);
+			lifetimes.push_back(lifetime);
+		}
+		timed.Update();
+		float timeMS = timer.Stop().GetDeltaTimeMS();
+		timedTimeMS += timeMS;
+		maxTimedTimeMS = std::max(maxTimedTimeMS, timeMS);
+
+		// A point has to be alive until its lifetime has passed, and be removed within one bucket after that.
+		uint32 minAlive = 0, maxAlive = 0;
+		for (uint32 i = 0; i < (uint32)pushTimes.size(); i++)
+		{
+			double expiry = pushTimes[i] + (double)lifetimes[i];
+			minAlive += time < expiry ? 1 : 0;
+			maxAlive += time < expiry + 1.0 / DebugRenderer::TIMED_BUCKETS_PER_SECOND ? 1 : 0;
+		}
+		uint32 numAlive = timed.GetStats().NumberOfPoints;
+
+		RS_CHECK(numAlive >= minAlive && numAlive <= maxAlive, "At {:.3f} s {} timed points are alive, expected {} to {}", time, numAlive, minAlive, maxAlive);
+		if (numAlive < minAlive || numAlive > maxAlive)
+			break;
+	}
+
+	LOG_INFO("Timed debug points, {} with lifetimes of 0.1 to 5 s: {:.3f} ms per frame on average and {:.3f} ms at most, over {} frames.",
+		numTimed, timedTimeMS / frame, maxTimedTimeMS, frame);
+	timed.Release();
+}
+
+RS_DEVICE_TEST(DebugRendererMergesPushesFromThreads)
+{
+	// Many threads pushing at once to a shared id, their own ids and the default id, with the index of the thread as the sort key.
+	const uint32 numThreads			= std::max(std::thread::hardware_concurrency(), 2u) * 2;
+	const uint32 numPushesPerThread	= 20000;
+	const uint32 numIDsPerThread	= 1000;
+
+	struct Result
+	{
+		std::vector<glm::vec3>	SharedLines;
+		uint32					NumPoints		= 0u;
+		uint32					NumBoxes		= 0u;
+		bool					HasUniqueIDs	= true;
+		float					PushTimeMS		= 0.f; // Average over the threads.
+		float					MergeTimeMS		= 0.f; // With the upload.
+	};
+
+	auto Run = [&]() -> Result
+	{
+		DebugRenderer renderer;
+		uint32 sharedID = renderer.GenID();
+		std::vector<uint32> threadIDs(numThreads);
+		std::vector<std::vector<uint32>> generatedIDs(numThreads);
+		std::vector<float> pushTimesMS(numThreads);
+
+		auto Worker = [&](uint32 threadIndex)
+		{
+			for (uint32 i = 0; i < numIDsPerThread; i++)
+				generatedIDs[threadIndex].push_back(renderer.GenID());
+			threadIDs[threadIndex] = generatedIDs[threadIndex].back();
+
+			Timer timer;
+			for (uint32 i = 0; i < numPushesPerThread; i++)
+			{
+				glm::vec3 position((float)threadIndex, (float)i, 0.f);
+				renderer.PushLine(position, position + glm::vec3(0.f, 0.f, 1.f), Color::RED, sharedID, false);
+				renderer.PushPoint(position, Color::GREEN, threadIDs[threadIndex], false);
+				renderer.PushBox(position, position + glm::vec3(0.5f));
+			}
+			pushTimesMS[threadIndex] = timer.Stop().GetDeltaTimeMS();
+			renderer.SubmitThreadCommands(threadIndex);
+		};
+
+		std::vector<std::thread> threads;
+		for (uint32 i = 0; i < numThreads; i++)
+			threads.emplace_back(Worker, i);
+		for (std::thread& thread : threads)
+			thread.join();
+
+		Result result;
+		Timer mergeTimer;
+		renderer.Update();
+		result.MergeTimeMS = mergeTimer.Stop().GetDeltaTimeMS();
+
+		result.SharedLines	= renderer.GetLinePositions(sharedID);
+		result.NumBoxes		= renderer.GetStats().NumberOfShapes;
+		result.NumPoints	= renderer.GetStats().NumberOfPoints;
+
+		std::vector<uint32> allIDs;
+		for (const std::vector<uint32>& ids : generatedIDs)
+			allIDs.insert(allIDs.end(), ids.begin(), ids.end());
+		std::sort(allIDs.begin(), allIDs.end());
+		result.HasUniqueIDs = std::adjacent_find(allIDs.begin(), allIDs.end()) == allIDs.end();
+
+		for (float timeMS : pushTimesMS)
+			result.PushTimeMS += timeMS / numThreads;
+		renderer.Release();
+		return result;
+	};
+
+	Result first = Run();
+	Result second = Run();
+
+	const uint32 numPushes = numThreads * numPushesPerThread;
+	RS_CHECK(first.SharedLines.size() == numPushes * 2 && first.NumPoints == numPushes && first.NumBoxes == numPushes,
+		"{} line vertices, {} points and {} boxes were merged for {} pushes", first.SharedLines.size(), first.NumPoints, first.NumBoxes, numPushes);
+	RS_CHECK(first.SharedLines == second.SharedLines, "The pushes from {} threads are not in the same order on each run", numThreads);
+	RS_CHECK(first.HasUniqueIDs && second.HasUniqueIDs, "Two threads got the same id");
+
+	// The same pushes on the render thread, straight into the groups.
+	DebugRenderer serial;
+	uint32 serialID = serial.GenID();
+	Timer serialTimer;
+	for (uint32 i = 0; i < numPushesPerThread; i++)
+	{
+		glm::vec3 position(0.f, (float)i, 0.f);
+		serial.PushLine(position, position + glm::vec3(0.f, 0.f, 1.f), Color::RED, serialID, false);
+		serial.PushPoint(position, Color::GREEN, serialID, false);
+		serial.PushBox(position, position + glm::vec3(0.5f));
+	}
+	float serialTimeMS = serialTimer.Stop().GetDeltaTimeMS();
+	serial.Release();
+
+	const uint32 numCallsPerThread = numPushesPerThread * 3;
+	LOG_INFO("Debug pushes from {} threads: {:.0f} pushes/ms per thread ({:.0f} pushes/ms on the render thread), {:.3f} ms to merge and upload {} pushes.",
+		numThreads, first.PushTimeMS > 0.f ? numCallsPerThread / first.PushTimeMS : 0.f, serialTimeMS > 0.f ? numCallsPerThread / serialTimeMS : 0.f,
+		first.MergeTimeMS, numCallsPerThread * numThreads);
+}
+
+RS_DEVICE_TEST(DebugRendererDetachesThreadsOnRelease)
+{
+	// A thread which outlives the renderer it pushed to, and then pushes to another one.
+	std::unique_ptr<DebugRenderer> pRenderer = std::make_unique<DebugRenderer>();
+	DebugRenderer other;
+	std::promise<void> hasPushed, isReleased;
+	std::thread thread([&]()
+	{
+		pRenderer->PushLine(glm::vec3(0.f), glm::vec3(1.f), Color::RED, 0, false);
+		hasPushed.set_value();
+		isReleased.get_future().wait();
+		other.PushLine(glm::vec3(0.f), glm::vec3(1.f), Color::RED, 0, false);
+		other.SubmitThreadCommands(0);
+	});
+
+	// The recorder of the thread submits what it recorded for the destroyed renderer when it moves to the other one, unless it was detached.
+	hasPushed.get_future().wait();
+	pRenderer->Release();
+	pRenderer.reset();
+	isReleased.set_value();
+	thread.join();
+
+	other.Update();
+	const uint32 numVertices = other.GetStats().NumberOfLineVertices;
+	RS_CHECK(numVertices == 2, "The other renderer got {} line vertices from the thread instead of 2", numVertices);
+	other.Release();
+}
+
+RS_DEVICE_TEST(DebugRendererPushesText)
+{
+	// 50k labels pushed and uploaded each frame. The renderer is not initialized, so it lays the text out with monospace metrics, where each character but the space is a glyph.
+	const uint32 numLabels = 50000;
+	std::vector<std::string> labels(numLabels);
+	for (uint32 i = 0; i < numLabels; i++)
+		labels[i] = "Object " + std::to_string(i) + " (" + std::to_string(i % 97) + " children)";
+
+	DebugFont font;
+	font.InitMonospace(16.f, 32.f);
+	uint32 numGlyphs = 0;
+	for (const std::string& label : labels)
+		font.Layout(label, 0.f, [&](const DebugFont::Quad&) { numGlyphs++; });
+
+	DebugRenderer textRenderer;
+
+	uint32 textID = textRenderer.GenID();
+	float textTimeMS = 0.f;
+	uint64 textBytes = 0;
+	for (uint32 frame = 0; frame < NUM_FRAMES; frame++)
+	{
+		Timer timer;
+		for (uint32 i = 0; i < numLabels; i++)
+			textRenderer.PushText(labels[i], glm::vec3((float)(i % 100), (float)frame, (float)(i / 100)), Color::WHITE, 16.f, 0.f, textID, i == 0);
+		textRenderer.Update();
+		textTimeMS += timer.Stop().GetDeltaTimeMS();
+		textBytes += textRenderer.GetStats().NumberOfUploadedBytes;
+	}
+
+	// Each frame rewrites all of the text.
+	const DebugRenderer::Stats& textStats = textRenderer.GetStats();
+	LOG_INFO("Debug text, {} labels: {:.3f} ms and {:.2f} MB uploaded per frame for {} glyphs ({} bytes each) in {} draw calls.",
+		numLabels, textTimeMS / NUM_FRAMES, ToMB(textBytes) / NUM_FRAMES, textStats.NumberOfGlyphs,
+		textStats.NumberOfUploadedBytes / std::max(textStats.NumberOfGlyphs, 1u), textStats.NumberOfDrawCalls);
+	RS_CHECK(textStats.NumberOfGlyphs == numGlyphs, "{} glyphs were pushed, the labels have {}", textStats.NumberOfGlyphs, numGlyphs);
+	textRenderer.Release();
+}
+
+RS_DEVICE_TEST(DebugRendererPacksPoints)
+{
+	// Points as packed records, against points as the line vertices they used to be.
+	const uint32 numPoints = 1000000;
+	std::vector<glm::vec3> positions(numPoints);
+	for (uint32 i = 0; i < numPoints; i++)
+		positions[i] = glm::vec3((float)(i % 1000), (float)(i / 1000), 0.f) * 0.1f;
+
+	DebugRenderer pointRenderer;
+	Timer pointTimer;
+	pointRenderer.PushPoints(positions, Color::GREEN);
+	pointRenderer.Update();
+	float pointTimeMS = pointTimer.Stop().GetDeltaTimeMS();
+	const DebugRenderer::Stats& pointStats = pointRenderer.GetStats();
+	uint32 pointBytes = pointStats.NumberOfUploadedBytes;
+
+	LineBuffer vertices(false);
+	LineGroup& vertexGroup = vertices.Groups[1];
+	Timer vertexTimer;
+	Vertex v;
+	v.Color = Color::GREEN;
+	for (const glm::vec3& position : positions)
+	{
+		v.Position = position;
+		vertexGroup.Elements.push_back(v);
+	}
+	vertices.MarkDirty(vertexGroup, 0);
+	vertices.Update();
+	float vertexTimeMS = vertexTimer.Stop().GetDeltaTimeMS();
+	uint32 vertexBytes = vertices.UploadedBytes;
+
+	LOG_INFO("Debug points, {}: {:.3f} ms and {:.2f} MB as {} byte points, {:.3f} ms and {:.2f} MB as {} byte vertices ({:.2f} MB saved).",
+		numPoints, pointTimeMS, ToMB(pointBytes), pointBytes / numPoints,
+		vertexTimeMS, ToMB(vertexBytes), LineBuffer::ELEMENT_SIZE, ToMB(vertexBytes - pointBytes));
+	RS_CHECK(pointStats.NumberOfPoints == numPoints, "{} of {} points were pushed", pointStats.NumberOfPoints, numPoints);
+	RS_CHECK(pointBytes < vertexBytes, "The points uploaded {} bytes, as vertices {} bytes", pointBytes, vertexBytes);
+
+	pointRenderer.Release();
+	vertices.Release();
+}
+
+RS_DEVICE_TEST(DebugRendererPushesMeshesAsInstances)
+{
+	// The Backpack pushed several times each frame as instances of its edges, against the lines of each triangle as PushMesh made them before.
+	const uint32 numMeshFrames	= 10;
+	const uint32 numMeshPushes	= 10;
+	const std::string modelPath	= std::string(RS_MODEL_PATH) + "SurvivalGuitarBackpack/Survival_BackPack_2.fbx";
+	const ModelLoadDesc::LoaderFlags flags = ModelLoadDesc::LOADER_FLAG_USE_UV_TOP_LEFT;
+
+	// The model is imported without the ResourceManager, such that its vertices are kept in RAM.
+	ImportedModel model;
+	if (CookedAssets::ReadModel(modelPath, flags, model) == false && ModelImporter::ImportWithAssimp(modelPath, flags, model) == false)
+	{
+		LOG_WARNING("Could not load [{}], the debug meshes are not measured!", modelPath.c_str());
+		return;
+	}
+
+	DebugRenderer meshRenderer;
+	uint32 meshID = meshRenderer.GenID();
+	Timer firstTimer;
+	meshRenderer.PushMesh(&model.Root, Color::GREEN, glm::vec3(0.f), meshID);
+	float firstTimeMS = firstTimer.Stop().GetDeltaTimeMS();
+	meshRenderer.Update();
+	const uint32 numInstances = meshRenderer.GetStats().NumberOfMeshes;
+
+	float meshTimeMS = 0.f;
+	uint64 meshBytes = 0;
+	for (uint32 frame = 0; frame < numMeshFrames; frame++)
+	{
+		Timer timer;
+		for (uint32 i = 0; i < numMeshPushes; i++)
+			meshRenderer.PushMesh(&model.Root, glm::translate(glm::vec3((float)i, (float)frame, 0.f)), Color::GREEN, meshID, i == 0);
+		meshRenderer.Update();
+		meshTimeMS += timer.Stop().GetDeltaTimeMS();
+		meshBytes += meshRenderer.GetStats().NumberOfUploadedBytes; // The wireframes and the instances.
+	}
+
+	// Three lines for each triangle, transformed on the CPU.
+	LineBuffer lines(false);
+	LineGroup& lineGroup = lines.Groups[meshID];
+	auto PushTriangles = [&](const ModelResource& node, const glm::mat4& accTransform, auto& pushTriangles) -> void
+	{
+		glm::mat4 transform = accTransform * node.Transform;
+		Vertex v;
+		v.Color = Color::GREEN;
+		for (const MeshObject& mesh : node.Meshes)
+		{
+			for (size_t t = 0; t + 2 < mesh.Indices.size(); t += 3)
+			{
+				for (uint32 e = 0; e < 3; e++)
+				{
+					v.Position = glm::vec3(transform * glm::vec4(mesh.Vertices[mesh.Indices[t + e]].Position, 1.f));
+					lineGroup.Elements.push_back(v);
+					v.Position = glm::vec3(transform * glm::vec4(mesh.Vertices[mesh.Indices[t + (e + 1) % 3]].Position, 1.f));
+					lineGroup.Elements.push_back(v);
+				}
+			}
+		}
+		for (const ModelResource& child : node.Children)
+			pushTriangles(child, transform, pushTriangles);
+	};
+
+	float lineTimeMS = 0.f;
+	uint64 lineBytes = 0;
+	for (uint32 frame = 0; frame < numMeshFrames; frame++)
+	{
+		Timer timer;
+		lineGroup.Elements.clear();
+		for (uint32 i = 0; i < numMeshPushes; i++)
+			PushTriangles(model.Root, glm::translate(glm::vec3((float)i, (float)frame, 0.f)), PushTriangles);
+		lines.MarkDirty(lineGroup, 0);
+		lines.Update();
+		lineTimeMS += timer.Stop().GetDeltaTimeMS();
+		lineBytes += lines.UploadedBytes;
+	}
+
+	const DebugRenderer::Stats& meshStats = meshRenderer.GetStats();
+	LOG_INFO("Debug meshes, [{}] pushed {} times per frame: {:.3f} ms for the first push, {:.3f} ms and {:.2f} MB uploaded per frame for {} lines as instances, "
+		"{:.3f} ms and {:.2f} MB for {} lines of triangles ({:.1f}x).",
+		model.Root.Name.c_str(), numMeshPushes, firstTimeMS, meshTimeMS / numMeshFrames, ToMB(meshBytes) / numMeshFrames,
+		meshStats.NumberOfWireframeVertices / 2 * numMeshPushes, lineTimeMS / numMeshFrames, ToMB(lineBytes) / numMeshFrames,
+		lines.NumElements / 2, meshTimeMS > 0.f ? lineTimeMS / meshTimeMS : 1.f);
+	RS_CHECK(meshStats.NumberOfMeshes == numInstances * numMeshPushes, "{} mesh instances for {} pushes of {} meshes",
+		meshStats.NumberOfMeshes, numMeshPushes, numInstances);
+	RS_CHECK(meshStats.NumberOfWireframeVertices > 0 && meshStats.NumberOfWireframeVertices * numMeshPushes < lines.NumElements,
+		"The edges of the meshes have {} vertices, the triangles {}", meshStats.NumberOfWireframeVertices * numMeshPushes, lines.NumElements);
+
+	meshRenderer.Release();
+	lines.Release();
+}
@@ -0,0 +1,232 @@
+#include "PreCompiled.h"
+#include "Test.h"
+
+#include "Renderer/DebugWireframe.h"
+#include "Loaders/CookedAssets.h"
+#include "Utils/Timer.h"
+
+#include <algorithm>
+#include <thread>
+
+using namespace RS;
+
+namespace
+{
+	const uint32 NUM_THREADS = std::max(std::thread::hardware_concurrency(), 1u);
+
+	/*
+	* A cube with four vertices for each face, as it is loaded with split normals.
+	*/
+	void MakeCube(std::vector<MeshObject::Vertex>& outVertices, std::vector<uint32>& outIndices)
+	{
+		for (uint32 axis = 0; axis < 3; axis++)
+		{
+			for (float side : { -1.f, 1.f })
+			{
+				uint32 first = (uint32)outVertices.size();
+				for (uint32 corner = 0; corner < 4; corner++)
+				{
+					MeshObject::Vertex v;
+					v.Position[axis]			= side;
+					v.Position[(axis + 1) % 3]	= (corner & 1) ? 1.f : -1.f;
+					v.Position[(axis + 2) % 3]	= (corner & 2) ? 1.f : -1.f;
+					v.Normal[axis]				= side;
+					outVertices.push_back(v);
+				}
+				outIndices.insert(outIndices.end(), { first, first + 1, first + 3, first, first + 3, first + 2 });
+			}
+		}
+	}
+
+	/*
+	* A grid of size by size quads, each split into two triangles by a diagonal.
+	*/
+	void MakeGrid(uint32 size, std::vector<MeshObject::Vertex>& outVertices, std::vector<uint32>& outIndices)
+	{
+		const uint32 width = size + 1;
+		outVertices.resize((size_t)width * width);
+		for (uint32 i = 0; i < (uint32)outVertices.size(); i++)
+			outVertices[i].Position = glm::vec3((float)(i % width), 0.f, (float)(i / width));
+
+		outIndices.reserve((size_t)size * size * 6);
+		for (uint32 z = 0; z < size; z++)
+		{
+			for (uint32 x = 0; x < size; x++)
+			{
+				uint32 v = z * width + x;
+				outIndices.insert(outIndices.end(), { v, v + width, v + 1, v + 1, v + width, v + width + 1 });
+			}
+		}
+	}
+
+	bool IsSame(const std::vector<DebugWireframe::Edge>& a, const std::vector<DebugWireframe::Edge>& b)
+	{
+		return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](const DebugWireframe::Edge& x, const DebugWireframe::Edge& y)
+		{
+			return x.First == y.First && x.Second == y.Second;
+		});
+	}
+}
+
+RS_TEST(DebugWireframeWeldsSplitVertices)
+{
+	// Twelve edges and one diagonal on each face, the split vertices of the faces are welded.
+	std::vector<MeshObject::Vertex> vertices;
+	std::vector<uint32> indices;
+	MakeCube(vertices, indices);
+
+	std::vector<DebugWireframe::Edge> edges;
+	DebugWireframe::ExtractEdges(vertices, indices, NUM_THREADS, edges);
+	RS_CHECK(edges.size() == 18, "A cube has {} edges", edges.size());
+
+	// Triangles with an index outside of the vertices, and degenerate triangles, add no edges.
+	indices.insert(indices.end(), { 0, 1, (uint32)vertices.size(), 0, 0, 0 });
+	DebugWireframe::ExtractEdges(vertices, indices, NUM_THREADS, edges);
+	RS_CHECK(edges.size() == 18, "A cube with broken triangles has {} edges", edges.size());
+}
+
+RS_TEST(DebugWireframeExtractsTheSameEdgesOnAnyNumberOfThreads)
+{
+	// A grid with enough triangles to be split over the threads, it has 2n(n+1) edges along the rows and columns and n*n diagonals.
+	const uint32 size = 300;
+	std::vector<MeshObject::Vertex> vertices;
+	std::vector<uint32> indices;
+	MakeGrid(size, vertices, indices);
+
+	std::vector<DebugWireframe::Edge> serialEdges, parallelEdges;
+	DebugWireframe::ExtractEdges(vertices, indices, 1, serialEdges);
+	DebugWireframe::ExtractEdges(vertices, indices, NUM_THREADS, parallelEdges);
+	size_t expected = (size_t)2 * size * (size + 1) + (size_t)size * size;
+	RS_CHECK(serialEdges.size() == expected, "A grid has {} edges, expected {}", serialEdges.size(), expected);
+	RS_CHECK(IsSame(serialEdges, parallelEdges), "The edges of a grid on {} threads differ from the ones on one thread", NUM_THREADS);
+}
+
+RS_TEST(DebugWireframeExtractsTheEdgesOfAModel)
+{
+	// The model is imported without the ResourceManager, such that its vertices are in RAM.
+	const std::string modelPath = std::string(RS_MODEL_PATH) + "SurvivalGuitarBackpack/Survival_BackPack_2.fbx";
+	const ModelLoadDesc::LoaderFlags flags = ModelLoadDesc::LOADER_FLAG_USE_UV_TOP_LEFT;
+	ImportedModel model;
+	if (CookedAssets::ReadModel(modelPath, flags, model) == false && ModelImporter::ImportWithAssimp(modelPath, flags, model) == false)
+	{
+		LOG_WARNING("Could not load [{}], the edges of a model are not checked!", modelPath.c_str());
+		return;
+	}
+
+	std::vector<const MeshObject*> meshes;
+	auto GatherMeshes = [&](const ModelResource& node, auto& gatherMeshes) -> void
+	{
+		for (const MeshObject& mesh : node.Meshes)
+			meshes.push_back(&mesh);
+		for (const ModelResource& child : node.Children)
+			gatherMeshes(child, gatherMeshes);
+	};
+	GatherMeshes(model.Root, GatherMeshes);
+
+	// Each mesh on one thread and on all of them.
+	size_t numTriangles = 0, numEdges = 0;
+	float serialTimeMS = 0.f, parallelTimeMS = 0.f;
+	std::vector<DebugWireframe::Edge> serialEdges, parallelEdges;
+	for (const MeshObject* pMesh : meshes)
+	{
+		Timer serialTimer;
+		DebugWireframe::ExtractEdges(pMesh->Vertices, pMesh->Indices, 1, serialEdges);
+		serialTimeMS += serialTimer.Stop().GetDeltaTimeMS();
+
+		Timer parallelTimer;
+		DebugWireframe::ExtractEdges(pMesh->Vertices, pMesh->Indices, NUM_THREADS, parallelEdges);
+		parallelTimeMS += parallelTimer.Stop().GetDeltaTimeMS();
+
+		RS_CHECK(IsSame(serialEdges, parallelEdges), "The edges of a mesh with {} triangles differ between one and {} threads", pMesh->Indices.size() / 3, NUM_THREADS);
+		numTriangles += pMesh->Indices.size() / 3;
+		numEdges += parallelEdges.size();
+	}
+
+	LOG_INFO("Debug wireframe of [{}], {} meshes and {} triangles: {} unique edges ({} lines when each triangle is drawn), {:.3f} ms on one thread and {:.3f} ms on {} threads ({:.1f}x).",
+		model.Root.Name.c_str(), meshes.size(), numTriangles, numEdges, numTriangles * 3, serialTimeMS, parallelTimeMS, NUM_THREADS,
+		parallelTimeMS > 0.f ? serialTimeMS / parallelTimeMS : 1.f);
+	RS_CHECK(numEdges > 0 && numEdges < numTriangles * 3, "The model has {} edges for {} triangles", numEdges, numTriangles);
+}
+
+RS_TEST(DebugWireframeForgetsMeshesOverTheBudget)
+{
+	// Eight cubes at different positions, with a budget of four of them. The last two are drawn, the others were only pushed.
+	const uint32 numMeshes = 8, numCubeVertices = 36;
+	std::vector<MeshObject> meshes(numMeshes);
+	for (uint32 i = 0; i < numMeshes; i++)
+	{
+		MakeCube(meshes[i].Vertices, meshes[i].Indices);
+		for (MeshObject::Vertex& v : meshes[i].Vertices)
+			v.Position.x += 3.f * i;
+	}
+
+	DebugWireframe wireframes;
+	wireframes.SetMaxVertices(numCubeVertices * 4);
+	std::vector<uint32> ids;
+	for (const MeshObject& mesh : meshes)
+		ids.push_back(wireframes.Get(mesh));
+
+	// The lines of each cube, to compare with after the list is compacted.
+	std::vector<glm::vec3> vertices;
+	wireframes.CopyVertices(vertices);
+	std::vector<std::vector<glm::vec3>> lines(numMeshes);
+	for (uint32 i = 0; i < numMeshes; i++)
+	{
+		const DebugWireframe::Range range = wireframes.GetRange(ids[i]);
+		lines[i].assign(vertices.begin() + range.FirstVertex, vertices.begin() + range.FirstVertex + range.NumVertices);
+	}
+
+	const uint32 drawnIDs[] = { ids[6], ids[7] };
+	wireframes.Trim(drawnIDs);
+	uint32 numKept = 0;
+	for (uint32 id : ids)
+		numKept += wireframes.GetRange(id).NumVertices > 0;
+	RS_CHECK(numKept == 4, "{} of {} cubes were kept with a budget of 4", numKept, numMeshes);
+	RS_CHECK(wireframes.GetRange(ids[6]).NumVertices > 0 && wireframes.GetRange(ids[7]).NumVertices > 0, "A cube which is drawn was forgotten");
+
+	// A freed mesh leaves more than half of the list unused, which is compacted by the next trim.
+	wireframes.Remove(meshes[7]);
+	const uint32 versionBefore = wireframes.GetVersion();
+	wireframes.Trim({});
+	RS_CHECK(wireframes.GetRange(ids[7]).NumVertices == 0, "The lines of a removed mesh are still drawn");
+	RS_CHECK(wireframes.GetNumVertices() == numCubeVertices * 3, "The compacted list has {} vertices for 3 cubes", wireframes.GetNumVertices());
+	RS_CHECK(wireframes.GetVersion() != versionBefore, "The version did not change when the list was compacted");
+
+	const uint32 version = wireframes.CopyVertices(vertices);
+	RS_CHECK(version == wireframes.GetVersion(), "The copy has version {} instead of {}", version, wireframes.GetVersion());
+	for (uint32 i = 0; i < numMeshes; i++)
+	{
+		const DebugWireframe::Range range = wireframes.GetRange(ids[i]);
+		if (range.NumVertices == 0)
+			continue;
+		RS_CHECK(range.FirstVertex + range.NumVertices <= vertices.size() && std::equal(lines[i].begin(), lines[i].end(), vertices.begin() + range.FirstVertex),
+			"The lines of cube {} moved wrong when the list was compacted", i);
+	}
+
+	// A forgotten mesh which is pushed again gets a new id.
+	const uint32 newID = wireframes.Get(meshes[0]);
+	RS_CHECK(newID != DebugWireframe::INVALID_ID && (wireframes.GetRange(ids[0]).NumVertices == 0 || newID == ids[0]), "A forgotten mesh got id {}", newID);
+}
+
+RS_TEST(DebugWireframeKeepsOneCopyOfAMeshPushedFromThreads)
+{
+	// The same grid from several threads at once, its edges are found outside of the lock and only the first ones are kept.
+	MeshObject mesh;
+	MakeGrid(256, mesh.Vertices, mesh.Indices);
+	std::vector<DebugWireframe::Edge> edges;
+	DebugWireframe::ExtractEdges(mesh.Vertices, mesh.Indices, 1, edges);
+
+	DebugWireframe wireframes;
+	const uint32 numThreads = std::max(NUM_THREADS, 4u);
+	std::vector<uint32> ids(numThreads, DebugWireframe::INVALID_ID);
+	std::vector<std::thread> threads;
+	for (uint32 i = 0; i < numThreads; i++)
+		threads.emplace_back([&, i]() { ids[i] = wireframes.Get(mesh); });
+	for (std::thread& thread : threads)
+		thread.join();
+
+	const bool hasSameIDs = ids[0] != DebugWireframe::INVALID_ID && std::all_of(ids.begin(), ids.end(), [&](uint32 id) { return id == ids[0]; });
+	RS_CHECK(hasSameIDs, "The threads got different ids for the same mesh");
+	RS_CHECK(wireframes.GetNumVertices() == edges.size() * 2, "The list has {} vertices for a mesh with {} edges", wireframes.GetNumVertices(), edges.size());
+	RS_CHECK(wireframes.GetRange(ids[0]).NumVertices == edges.size() * 2, "The mesh has {} line vertices for {} edges", wireframes.GetRange(ids[0]).NumVertices, edges.size());
+}
@@ -0,0 +1,84 @@
+#include "PreCompiled.h"
+#include "FakeShaderCompiler.h"
+
+#include <sstream>
+#include <thread>
+
+using namespace RS;
+using namespace RS::Tests;
+
+FakeShaderCompiler::FakeShaderCompiler(uint32 compileTimeMS) : m_CompileTimeMS(compileTimeMS)
+{
+}
+
+void FakeShaderCompiler::SetFile(const std::string& path, const std::string& source)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Files[path] = source;
+}
+
+bool FakeShaderCompiler::Preprocess(const ShaderCompileDesc& desc, std::string& outSource, ShaderCompileResult& outResult)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	auto it = m_Files.find(desc.FilePath);
+	if (it == m_Files.end())
+	{
+		outResult.Errors = "Cannot open " + desc.FilePath;
+		return false;
+	}
+
+	// One level of includes is enough for the tests.
+	std::istringstream stream(it->second);
+	std::string line;
+	outSource.clear();
+	while (std::getline(stream, line))
+	{
+		if (line.rfind("#include <", 0) == 0 && line.back() == '>')
+		{
+			std::string includePath = line.substr(10, line.size() - 11);
+			auto includeIt = m_Files.find(includePath);
+			if (includeIt == m_Files.end())
+			{
+				outResult.Errors = "Cannot open include " + includePath;
+				return false;
+			}
+			outResult.Includes[desc.FilePath].push_back(includePath);
+			outSource += includeIt->second + "\n";
+		}
+		else
+		{
+			outSource += line + "\n";
+		}
+	}
+	return true;
+}
+
+bool FakeShaderCompiler::Compile(const ShaderCompileDesc& desc, const std::string& preprocessedSource, ShaderCompileResult& outResult)
+{
+	m_NumCompiles++;
+	if (m_CompileTimeMS > 0)
+		std::this_thread::sleep_for(std::chrono::milliseconds(m_CompileTimeMS));
+
+	if (preprocessedSource.find("#error") != std::string::npos)
+	{
+		outResult.Errors = desc.FilePath + ": #error";
+		return false;
+	}
+
+	std::string byteCode = preprocessedSource + desc.Target;
+	outResult.ByteCode.assign(byteCode.begin(), byteCode.end());
+
+	ShaderReflectionData::Binding binding;
+	binding.Name		= "Constants";
+	binding.Type		= 0; // D3D_SIT_CBUFFER
+	binding.Size		= 16;
+	binding.BindCount	= 1;
+	binding.Variables.push_back({ "Color", 0, 16 });
+	outResult.Reflection.Bindings = { binding };
+	return true;
+}
+
+std::string FakeShaderCompiler::GetName() const
+{
+	return "Fake";
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "Renderer/ShaderCompiler.h"
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace RS::Tests
+{
+	/*
+	* A compiler which does not use D3D, such that the shader cache and batches can be tested on any thread without a device.
+	* The files are kept in memory, a line "#include <path>" is replaced by that file. A source which contains "#error" fails to compile.
+	* The bytecode is the preprocessed source followed by the target, and the reflection has one constant buffer.
+	* Example:
+	*	auto pCompiler = std::make_shared<FakeShaderCompiler>();
+	*	pCompiler->SetFile("Common.hlsl", "float4 Color;");
+	*	pCompiler->SetFile("Pixel.hlsl", "#include <Common.hlsl>\nfloat4 main() : SV_Target { return Color; }");
+	*	pShaderCache->Init(folderPath, maxSizeBytes, true, pCompiler);
+	*/
+	class FakeShaderCompiler : public IShaderCompiler
+	{
+	public:
+		/*
+		* compileTimeMS: How long each compile sleeps, to stand in for the work of a real compiler.
+		*/
+		FakeShaderCompiler(uint32 compileTimeMS = 0);
+
+		void SetFile(const std::string& path, const std::string& source);
+
+		bool Preprocess(const ShaderCompileDesc& desc, std::string& outSource, ShaderCompileResult& outResult) override;
+		bool Compile(const ShaderCompileDesc& desc, const std::string& preprocessedSource, ShaderCompileResult& outResult) override;
+		std::string GetName() const override;
+
+		uint32 GetNumCompiles() const { return m_NumCompiles; }
+
+	private:
+		std::mutex										m_Mutex;
+		std::unordered_map<std::string, std::string>	m_Files;
+		uint32											m_CompileTimeMS	= 0;
+		std::atomic<uint32>								m_NumCompiles	= 0;
+	};
+}
@@ -0,0 +1,173 @@
+#include "PreCompiled.h"
+#include "Test.h"
+
+#include "Utils/FileWatcher.h"
+#include "Utils/Timer.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <unordered_set>
+
+using namespace RS;
+
+namespace
+{
+	const uint32 NUM_DIRECTORIES			= 100;
+	const uint32 NUM_FILES_PER_DIRECTORY	= 100;
+	const uint32 POLLING_DELAY_MS			= 100;
+	const uint32 TIMEOUT_MS					= 10000;
+
+	std::string GetFileName(uint32 directory, uint32 file)
+	{
+		return "Dir" + std::to_string(directory) + "/File" + std::to_string(file) + ".hlsl";
+	}
+
+	// 10 000 small files in 100 directories, about the size of a large shader and asset folder.
+	std::filesystem::path MakeWatchFolder()
+	{
+		std::filesystem::path folder = std::filesystem::temp_directory_path() / "RSFileWatcherTests";
+		std::error_code error;
+		std::filesystem::remove_all(folder, error);
+		for (uint32 d = 0; d < NUM_DIRECTORIES; d++)
+		{
+			std::filesystem::create_directories(folder / ("Dir" + std::to_string(d)));
+			for (uint32 f = 0; f < NUM_FILES_PER_DIRECTORY; f++)
+				std::ofstream(folder / GetFileName(d, f)) << "float4 main() : SV_Target { return 0.f; }\n";
+		}
+		return folder;
+	}
+
+	// Collects the reported files of the watcher thread.
+	struct Reports
+	{
+		std::mutex						Mutex;
+		std::condition_variable			Condition;
+		std::unordered_set<std::string>	Files;
+
+		void Add(const std::vector<std::string>& files)
+		{
+			{
+				std::lock_guard<std::mutex> lock(Mutex);
+				for (const std::string& file : files)
+					Files.insert(file);
+			}
+			Condition.notify_all();
+		}
+
+		bool WaitFor(size_t numFiles)
+		{
+			std::unique_lock<std::mutex> lock(Mutex);
+			return Condition.wait_for(lock, std::chrono::milliseconds(TIMEOUT_MS), [&]() { return Files.size() >= numFiles; });
+		}
+
+		size_t GetCount()
+		{
+			std::lock_guard<std::mutex> lock(Mutex);
+			return Files.size();
+		}
+
+		void Clear()
+		{
+			std::lock_guard<std::mutex> lock(Mutex);
+			Files.clear();
+		}
+	};
+
+	// Moves the write time forward, which is what an editor saving the file does.
+	void TouchFiles(const std::filesystem::path& folder, uint32 numFiles, uint32 step)
+	{
+		const std::filesystem::file_time_type writeTime = std::filesystem::file_time_type::clock::now() + std::chrono::seconds(step);
+		for (uint32 i = 0; i < numFiles; i++)
+			std::filesystem::last_write_time(folder / GetFileName(i % NUM_DIRECTORIES, i / NUM_DIRECTORIES), writeTime);
+	}
+
+	void WatchFolder(FileWatcher::Backend backend)
+	{
+		const char* pBackendName = backend == FileWatcher::Backend::EVENTS ? "events" : "polling";
+		std::filesystem::path folder = MakeWatchFolder();
+		const uint32 numFiles = NUM_DIRECTORIES * NUM_FILES_PER_DIRECTORY;
+
+		Reports reports;
+		FileWatcher watcher;
+		Timer addTimer;
+		watcher.AddDirectory(folder.string(), true);
+		const float addTimeMS = addTimer.Stop().GetDeltaTimeMS();
+		watcher.AddCallBack({ [&](std::vector<std::string> files) { reports.Add(files); } });
+		watcher.Init(POLLING_DELAY_MS, backend);
+
+		// Idle, the events only wake up the watcher when something has changed.
+		std::this_thread::sleep_for(std::chrono::milliseconds(500));
+		FileWatcher::Stats idleStats = watcher.GetStats();
+		RS_CHECK(idleStats.ActiveBackend == backend, "The {} backend fell back to polling", pBackendName);
+		if (backend == FileWatcher::Backend::EVENTS)
+			RS_CHECK(idleStats.NumWakeUps <= 2, "The idle event watcher woke up {} times", idleStats.NumWakeUps);
+
+		// A few files, like saving shaders.
+		Timer latencyTimer;
+		TouchFiles(folder, 10, 10);
+		bool reportedFew = reports.WaitFor(10);
+		const float fewLatencyMS = latencyTimer.Stop().GetDeltaTimeMS();
+		RS_CHECK(reportedFew, "{}: {} of 10 modified files were reported", pBackendName, reports.GetCount());
+
+		// Every file at once, more changes than the notification buffer holds, such that the directory has to be rescanned.
+		std::this_thread::sleep_for(std::chrono::milliseconds(200));
+		reports.Clear();
+		Timer allTimer;
+		TouchFiles(folder, numFiles, 20);
+		bool reportedAll = reports.WaitFor(numFiles);
+		const float allLatencyMS = allTimer.Stop().GetDeltaTimeMS();
+		RS_CHECK(reportedAll, "{}: {} of {} modified files were reported", pBackendName, reports.GetCount(), numFiles);
+
+		FileWatcher::Stats stats = watcher.GetStats();
+		watcher.Release();
+		LOG_INFO("Watching {} files with {}: {:.1f} ms to add, {:.1f} ms for 10 changes, {:.1f} ms for all, {} wake ups, {} events, {} callbacks.",
+			numFiles, pBackendName, addTimeMS, fewLatencyMS, allLatencyMS, stats.NumWakeUps, stats.NumEvents, stats.NumCallbacks);
+
+		std::error_code error;
+		std::filesystem::remove_all(folder, error);
+	}
+}
+
+RS_TEST(FileWatcherEventsReportTenThousandFiles)
+{
+	WatchFolder(FileWatcher::Backend::EVENTS);
+}
+
+RS_TEST(FileWatcherPollingReportsTenThousandFiles)
+{
+	WatchFolder(FileWatcher::Backend::POLLING);
+}
+
+RS_TEST(FileWatcherPollingDoesNotBlockAddFile)
+{
+	std::filesystem::path folder = MakeWatchFolder();
+
+	// The time of one sweep over all files, which AddFile would wait for if the lock was held while polling.
+	Timer sweepTimer;
+	std::error_code error;
+	for (const auto& entry : std::filesystem::recursive_directory_iterator(folder, error))
+		std::filesystem::last_write_time(entry.path(), error);
+	const float sweepTimeMS = sweepTimer.Stop().GetDeltaTimeMS();
+
+	FileWatcher watcher;
+	watcher.AddDirectory(folder.string(), true);
+	watcher.Init(0, FileWatcher::Backend::POLLING);
+
+	float maxAddTimeMS = 0.f;
+	for (uint32 i = 0; i < 200; i++)
+	{
+		Timer addTimer;
+		watcher.AddFile((folder / GetFileName(i % NUM_DIRECTORIES, i / NUM_DIRECTORIES)).string());
+		maxAddTimeMS = std::max(maxAddTimeMS, addTimer.Stop().GetDeltaTimeMS());
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	FileWatcher::Stats stats = watcher.GetStats();
+	watcher.Release();
+
+	LOG_INFO("AddFile took at most {:.2f} ms while polling, one sweep takes {:.1f} ms ({} sweeps).", maxAddTimeMS, sweepTimeMS, stats.NumWakeUps);
+	RS_CHECK(stats.NumWakeUps > 1, "The watcher only polled {} times", stats.NumWakeUps);
+	RS_CHECK(maxAddTimeMS < std::max(sweepTimeMS / 2.f, 5.f), "AddFile waited {:.2f} ms for a sweep of {:.1f} ms", maxAddTimeMS, sweepTimeMS);
+
+	std::filesystem::remove_all(folder, error);
+}
@@ -0,0 +1,232 @@
+#include "PreCompiled.h"
+#include "Test.h"
+
+#include "Renderer/LightClusters.h"
+
+#include <algorithm>
+#include <random>
+#include <thread>
+
+using namespace RS;
+
+namespace
+{
+	const float NEAR_PLANE	= 0.1f;
+	const float FAR_PLANE	= 100.f;
+
+	glm::mat4 GetView()
+	{
+		return glm::lookAtRH(glm::vec3(0.f), glm::vec3(0.f, 0.f, -1.f), glm::vec3(0.f, 1.f, 0.f));
+	}
+
+	glm::mat4 GetProj()
+	{
+		return glm::perspectiveRH(glm::pi<float>() / 4.f, 16.f / 9.f, NEAR_PLANE, FAR_PLANE);
+	}
+
+	// The cluster which holds a view space position in front of the camera.
+	uint32 GetClusterOf(const LightClusters& clusters, const glm::vec3& position)
+	{
+		const glm::vec4 clip = GetProj() * glm::vec4(position, 1.f);
+		const float ndcX = clip.x / clip.w;
+		const float ndcY = clip.y / clip.w;
+		const uint32 x = (uint32)glm::clamp((ndcX * 0.5f + 0.5f) * (float)clusters.GetGridX(), 0.f, (float)clusters.GetGridX() - 1.f);
+		const uint32 y = (uint32)glm::clamp((0.5f - ndcY * 0.5f) * (float)clusters.GetGridY(), 0.f, (float)clusters.GetGridY() - 1.f);
+		const uint32 z = (uint32)glm::clamp(glm::log2(-position.z) * clusters.GetSliceScale() + clusters.GetSliceBias(), 0.f, (float)clusters.GetGridZ() - 1.f);
+		return clusters.GetClusterIndex(x, y, z);
+	}
+
+	bool HasLight(const LightClusters& clusters, uint32 cluster, uint32 lightIndex)
+	{
+		const LightClusters::Cluster& range = clusters.GetClusters()[cluster];
+		const uint32* pIndices = clusters.GetLightIndices().data() + range.Offset;
+		return std::find(pIndices, pIndices + range.Count, lightIndex) != pIndices + range.Count;
+	}
+
+	/*
+	* Scalar reference of the tests of LightClusters for one light in view space and one cluster, without the slice and row steps.
+	* The slack widens (or narrows when negative) each test, such that rounding differences to the SSE version do not count.
+	*/
+	bool IsLightInCluster(const LightClusters::Light& light, const AABB& bounds, float slack)
+	{
+		const glm::vec3 closest = glm::clamp(light.Position, bounds.min, bounds.max);
+		const float range = light.Range + slack;
+		if (range < 0.f || glm::dot(closest - light.Position, closest - light.Position) > range * range)
+			return false;
+		if (light.Type != LightClusters::LightType::SPOT)
+			return true;
+
+		const glm::vec3 center = (bounds.min + bounds.max) * 0.5f;
+		const float radius = glm::length(bounds.max - bounds.min) * 0.5f + slack;
+		const glm::vec3 toCenter = center - light.Position;
+		const float alongAxis = glm::dot(toCenter, light.Direction);
+		const float fromAxis = glm::sqrt(glm::max(glm::dot(toCenter, toCenter) - alongAxis * alongAxis, 0.f));
+		const float cosAngle = glm::clamp(light.CosOuterAngle, -1.f, 1.f);
+		const float sinAngle = glm::sqrt(1.f - cosAngle * cosAngle);
+		const bool inAngle = cosAngle * fromAxis - alongAxis * sinAngle <= radius;
+		const bool inFront = alongAxis <= radius + light.Range;
+		const bool inBack = cosAngle < 0.f || alongAxis >= -radius;
+		return inAngle && inFront && inBack;
+	}
+
+	// The same lights for each run, half of them spot lights, spread over the frustum.
+	std::vector<LightClusters::Light> MakeLights(uint32 numLights)
+	{
+		std::mt19937 generator(1337);
+		std::uniform_real_distribution<float> unit(0.f, 1.f);
+		std::vector<LightClusters::Light> lights(numLights);
+		for (LightClusters::Light& light : lights)
+		{
+			light.Position		= glm::vec3(unit(generator) * 120.f - 60.f, unit(generator) * 40.f - 20.f, -unit(generator) * 100.f);
+			light.Range			= 0.5f + unit(generator) * 3.5f;
+			light.Color			= glm::vec3(unit(generator), unit(generator), unit(generator));
+			light.Type			= unit(generator) < 0.5f ? LightClusters::LightType::POINT : LightClusters::LightType::SPOT;
+			light.Direction		= glm::normalize(glm::vec3(unit(generator) - 0.5f, unit(generator) - 0.5f, unit(generator) - 0.5f) + glm::vec3(0.f, 0.f, 0.001f));
+			light.CosOuterAngle	= glm::cos(0.2f + unit(generator) * 0.8f);
+			light.CosInnerAngle	= glm::mix(light.CosOuterAngle, 1.f, 0.5f);
+		}
+		return lights;
+	}
+}
+
+RS_TEST(LightClustersSkipLightsOutsideTheFrustum)
+{
+	std::vector<LightClusters::Light> lights(3);
+	lights[0].Position	= glm::vec3(0.f, 0.f, -10.f);	// In front of the camera.
+	lights[1].Position	= glm::vec3(0.f, 0.f, 10.f);	// Behind the camera.
+	lights[2].Position	= glm::vec3(0.f, 0.f, -200.f);	// Past the far plane.
+
+	LightClusters clusters;
+	clusters.Init(16, 9, 24);
+	clusters.Build(lights, GetView(), GetProj(), NEAR_PLANE, FAR_PLANE, 1);
+
+	const LightClusters::Stats& stats = clusters.GetStats();
+	RS_CHECK(stats.NumLights == 3 && stats.NumVisibleLights == 1, "{} of {} lights are visible", stats.NumVisibleLights, stats.NumLights);
+	for (uint32 index : clusters.GetLightIndices())
+		RS_CHECK(index == 0, "Light {} was binned", index);
+
+	// The light is in the slice of its depth.
+	uint32 slice = (uint32)(glm::log2(10.f) * clusters.GetSliceScale() + clusters.GetSliceBias());
+	uint32 count = 0;
+	for (uint32 y = 0; y < clusters.GetGridY(); y++)
+	{
+		for (uint32 x = 0; x < clusters.GetGridX(); x++)
+			count += clusters.GetClusters()[clusters.GetClusterIndex(x, y, slice)].Count;
+	}
+	RS_CHECK(count > 0, "The light is not in slice {}", slice);
+}
+
+RS_TEST(LightClustersKeepWideSpotLightsBehindTheirApex)
+{
+	// A spot light of 150 degrees which points at the camera still lights the clusters beside and behind it.
+	std::vector<LightClusters::Light> lights(1);
+	lights[0].Position		= glm::vec3(0.f, 0.f, -5.f);
+	lights[0].Range			= 10.f;
+	lights[0].Type			= LightClusters::LightType::SPOT;
+	lights[0].Direction		= glm::vec3(0.f, 0.f, 1.f);
+	lights[0].CosOuterAngle	= glm::cos(glm::radians(150.f));
+
+	LightClusters clusters;
+	clusters.Init(16, 9, 24);
+	clusters.Build(lights, GetView(), GetProj(), NEAR_PLANE, FAR_PLANE, 1);
+
+	const glm::vec3 behind = glm::vec3(3.f, 0.f, -7.f);
+	RS_CHECK(HasLight(clusters, GetClusterOf(clusters, behind), 0), "The cluster at ({}, {}, {}) does not hold the wide spot light", behind.x, behind.y, behind.z);
+}
+
+RS_TEST(LightClustersMatchAScalarReference)
+{
+	// Random points and spots around the frustum, also behind the camera, with cones from narrow to almost 180 degrees.
+	// An odd count leaves a partly filled group of four.
+	const uint32 numLights = 1001;
+	const float slack = 1e-3f;
+	std::mt19937 generator(42);
+	std::uniform_real_distribution<float> unit(0.f, 1.f);
+	std::vector<LightClusters::Light> lights(numLights);
+	for (LightClusters::Light& light : lights)
+	{
+		light.Position		= glm::vec3(unit(generator) * 80.f - 40.f, unit(generator) * 40.f - 20.f, 10.f - unit(generator) * 100.f);
+		light.Range			= 0.5f + unit(generator) * 8.f;
+		light.Type			= unit(generator) < 0.5f ? LightClusters::LightType::POINT : LightClusters::LightType::SPOT;
+		light.Direction		= glm::normalize(glm::vec3(unit(generator) - 0.5f, unit(generator) - 0.5f, unit(generator) - 0.5f) + glm::vec3(0.f, 0.f, 0.001f));
+		light.CosOuterAngle	= glm::cos(0.1f + unit(generator) * 2.9f);
+	}
+
+	LightClusters clusters;
+	clusters.Init(16, 9, 24);
+	clusters.Build(lights, GetView(), GetProj(), NEAR_PLANE, FAR_PLANE, 1);
+
+	// The view is the identity, the lights are already in view space.
+	uint32 numMissing = 0, numExtra = 0, numRejectedByCone = 0, numChecked = 0;
+	std::vector<bool> isListed(numLights);
+	for (uint32 cluster = 0; cluster < (uint32)clusters.GetClusters().size(); cluster++)
+	{
+		const LightClusters::Cluster& range = clusters.GetClusters()[cluster];
+		std::fill(isListed.begin(), isListed.end(), false);
+		for (uint32 i = range.Offset; i < range.Offset + range.Count; i++)
+			isListed[clusters.GetLightIndices()[i]] = true;
+
+		const AABB& bounds = clusters.GetClusterBounds(cluster);
+		for (uint32 light = 0; light < numLights; light++)
+		{
+			const bool isInside = IsLightInCluster(lights[light], bounds, -slack);
+			const bool isNear = IsLightInCluster(lights[light], bounds, slack);
+			numMissing += isInside && !isListed[light] ? 1 : 0;
+			numExtra += !isNear && isListed[light] ? 1 : 0;
+			numChecked += isListed[light] ? 1 : 0;
+
+			LightClusters::Light point = lights[light];
+			point.Type = LightClusters::LightType::POINT;
+			numRejectedByCone += lights[light].Type == LightClusters::LightType::SPOT && !isNear && IsLightInCluster(point, bounds, -slack) ? 1 : 0;
+		}
+	}
+
+	RS_CHECK(numChecked > numLights && numRejectedByCone > 0, "The lights cover too little, {} entries and {} rejected by a cone", numChecked, numRejectedByCone);
+	RS_CHECK(numMissing == 0, "{} lights are missing from clusters they touch", numMissing);
+	RS_CHECK(numExtra == 0, "{} lights are in clusters they do not touch", numExtra);
+
+	// Each cluster lists its lights in the order of the input.
+	for (const LightClusters::Cluster& range : clusters.GetClusters())
+	{
+		const uint32* pIndices = clusters.GetLightIndices().data() + range.Offset;
+		RS_CHECK(std::is_sorted(pIndices, pIndices + range.Count), "A cluster does not list its lights in the order of the input");
+	}
+}
+
+RS_TEST(LightClustersBinTheSameOnAnyNumberOfThreads)
+{
+	// Bin 1k, 10k and 100k lights and log the times on one thread and on all threads.
+	const uint32 numRuns = 5;
+	const uint32 numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	for (uint32 numLights : { 1000u, 10000u, 100000u })
+	{
+		std::vector<LightClusters::Light> lights = MakeLights(numLights);
+		LightClusters serialClusters;
+		LightClusters threadedClusters;
+		serialClusters.Init(16, 9, 24);
+		threadedClusters.Init(16, 9, 24);
+		float serialTimeMS = 0.f, threadedTimeMS = 0.f;
+		for (uint32 run = 0; run < numRuns; run++)
+		{
+			serialClusters.Build(lights, GetView(), GetProj(), NEAR_PLANE, FAR_PLANE, 1);
+			serialTimeMS += serialClusters.GetStats().BuildTimeMS;
+			threadedClusters.Build(lights, GetView(), GetProj(), NEAR_PLANE, FAR_PLANE, numThreads);
+			threadedTimeMS += threadedClusters.GetStats().BuildTimeMS;
+		}
+
+		bool isSame = serialClusters.GetLightIndices() == threadedClusters.GetLightIndices();
+		for (uint32 cluster = 0; isSame && cluster < (uint32)serialClusters.GetClusters().size(); cluster++)
+		{
+			const LightClusters::Cluster& a = serialClusters.GetClusters()[cluster];
+			const LightClusters::Cluster& b = threadedClusters.GetClusters()[cluster];
+			isSame = a.Offset == b.Offset && a.Count == b.Count;
+		}
+
+		const LightClusters::Stats& stats = threadedClusters.GetStats();
+		LOG_INFO("Light binning of {} lights: {:.3f} ms on 1 thread, {:.3f} ms on {} threads ({:.2f}x). {} visible, {} indices, at most {} in a cluster.",
+			numLights, serialTimeMS / numRuns, threadedTimeMS / numRuns, stats.NumThreads, threadedTimeMS > 0.f ? serialTimeMS / threadedTimeMS : 1.f,
+			stats.NumVisibleLights, stats.NumIndices, stats.MaxLightsPerCluster);
+		RS_CHECK(isSame, "Light binning of {} lights on {} threads differs from the result on one thread", numLights, stats.NumThreads);
+		RS_CHECK(stats.NumVisibleLights > 0 && stats.NumVisibleLights <= numLights, "{} of {} lights are visible", stats.NumVisibleLights, numLights);
+	}
+}
@@ -0,0 +1,62 @@
+#include <algorithm>
+#include <iostream>
+
+#include "Test.h"
+
+#include "Core/ResourceManager.h"
+#include "Core/VirtualFileSystem.h"
+#include "Renderer/RenderAPI.h"
+#include "Utils/Config.h"
+#include "Utils/Timer.h"
+
+using namespace RS;
+
+int main(int argc, char* argv[])
+{
+	// Tests [filter]: Runs the tests whose name contains the filter, or all of them.
+	const std::string filter = argc > 1 ? argv[1] : "";
+
+	Logger::Init();
+	Config::Get()->Init(RS_CONFIG_FILE_PATH);
+	VirtualFileSystem::Get()->Init();
+	VirtualFileSystem::Get()->MountLooseFiles(RS_ASSET_PATH);
+
+	std::vector<Tests::TestCase> testCases = Tests::GetTestCases();
+	std::sort(testCases.begin(), testCases.end(), [](const Tests::TestCase& a, const Tests::TestCase& b) { return std::string(a.Name) < std::string(b.Name); });
+
+	bool hasDevice = false;
+	uint32 numRun = 0, numFailed = 0;
+	for (const Tests::TestCase& testCase : testCases)
+	{
+		if (std::string(testCase.Name).find(filter) == std::string::npos)
+			continue;
+
+		if (testCase.NeedsDevice && !hasDevice)
+		{
+			RenderAPI::Get()->InitWithoutDisplay();
+			ResourceManager::Get()->Init();
+			hasDevice = true;
+		}
+
+		std::cout << "[Run] " << testCase.Name << "\n";
+		uint32 numFailuresBefore = Tests::GetNumFailures();
+		Timer timer;
+		testCase.Function();
+		float timeMS = timer.Stop().GetDeltaTimeMS();
+
+		bool hasPassed = Tests::GetNumFailures() == numFailuresBefore;
+		std::cout << (hasPassed ? "[Passed] " : "[Failed] ") << testCase.Name << " (" << timeMS << " ms)\n";
+		numRun++;
+		numFailed += hasPassed ? 0 : 1;
+	}
+
+	if (hasDevice)
+	{
+		ResourceManager::Get()->Release();
+		RenderAPI::Get()->Release();
+	}
+	VirtualFileSystem::Get()->Release();
+
+	std::cout << numRun - numFailed << " of " << numRun << " tests passed.\n";
+	return numFailed == 0 ? 0 : 1;
+}
@@ -0,0 +1,81 @@
+#include "PreCompiled.h"
+#include "Test.h"
+
+#include "Core/PackArchive.h"
+
+#include <filesystem>
+#include <fstream>
+#include <functional>
+
+using namespace RS;
+
+namespace
+{
+	std::vector<uint8> ReadBytes(const std::filesystem::path& path)
+	{
+		std::ifstream file(path, std::ios::binary | std::ios::ate);
+		std::vector<uint8> data((size_t)file.tellg());
+		file.seekg(0);
+		file.read((char*)data.data(), (std::streamsize)data.size());
+		return data;
+	}
+
+	// Writes the archive with one field changed, and returns if it could still be opened.
+	bool OpenChanged(const std::filesystem::path& folder, const std::vector<uint8>& archive, const std::function<void(PackArchive::Header&, PackArchive::Entry*)>& change)
+	{
+		std::vector<uint8> data = archive;
+		change(*(PackArchive::Header*)data.data(), (PackArchive::Entry*)(data.data() + sizeof(PackArchive::Header)));
+		const std::filesystem::path path = folder / "Changed.rspak";
+		std::ofstream(path, std::ios::binary | std::ios::trunc).write((const char*)data.data(), (std::streamsize)data.size());
+
+		PackArchive pack;
+		return pack.Open(path.string());
+	}
+}
+
+RS_TEST(PackArchiveRejectsCorruptTables)
+{
+	std::filesystem::path folder = std::filesystem::temp_directory_path() / "RSPackArchiveTests";
+	std::error_code error;
+	std::filesystem::remove_all(folder, error);
+	std::filesystem::create_directories(folder);
+
+	std::vector<PackArchive::SourceFile> files;
+	for (const char* pName : { "A.txt", "B.txt", "C.txt" })
+	{
+		std::ofstream(folder / pName) << "The content of " << pName << "\n";
+		files.push_back({ std::string("Text/") + pName, (folder / pName).string(), false });
+	}
+
+	const std::filesystem::path archivePath = folder / "Text.rspak";
+	PackArchive::WriteStats stats;
+	bool written = PackArchive::Write(archivePath.string(), files, 16, false, 0.f, stats);
+	RS_CHECK(written && stats.NumEntries == 3, "The archive could not be written");
+	if (!written)
+		return;
+
+	{
+		PackArchive pack;
+		FileView view;
+		bool isRead = pack.Open(archivePath.string()) && pack.Read(pack.Find("Text/B.txt"), view);
+		RS_CHECK(isRead && std::string((const char*)view.pData, (size_t)view.Size) == "The content of B.txt\n", "The valid archive could not be read");
+	}
+
+	const std::vector<uint8> archive = ReadBytes(archivePath);
+	const uint64 end = (uint64)archive.size();
+	RS_CHECK(OpenChanged(folder, archive, [](PackArchive::Header&, PackArchive::Entry*) {}), "The unchanged copy could not be opened");
+	RS_CHECK(!OpenChanged(folder, archive, [](PackArchive::Header& header, PackArchive::Entry*) { header.NumEntries = UINT32_MAX; }),
+		"A table of contents past the end of the file was opened");
+	RS_CHECK(!OpenChanged(folder, archive, [](PackArchive::Header&, PackArchive::Entry* pEntries) { pEntries[0].Size++; }),
+		"An uncompressed entry with another size than it is stored with was opened");
+	RS_CHECK(!OpenChanged(folder, archive, [](PackArchive::Header&, PackArchive::Entry* pEntries) { pEntries[1].DataOffset = UINT64_MAX - 4; }),
+		"An entry whose end overflows was opened");
+	RS_CHECK(!OpenChanged(folder, archive, [end](PackArchive::Header&, PackArchive::Entry* pEntries) { pEntries[2].StoredSize = pEntries[2].Size = end; }),
+		"An entry past the end of the file was opened");
+	RS_CHECK(!OpenChanged(folder, archive, [](PackArchive::Header& header, PackArchive::Entry* pEntries) { pEntries[2].PathLength = (uint32)header.StringsSize; }),
+		"A path past the end of the strings was opened");
+	RS_CHECK(!OpenChanged(folder, archive, [](PackArchive::Header&, PackArchive::Entry* pEntries) { std::swap(pEntries[0], pEntries[1]); }),
+		"An unsorted table of contents was opened");
+
+	std::filesystem::remove_all(folder, error);
+}
@@ -0,0 +1,194 @@
+#include "PreCompiled.h"
+#include "Test.h"
+
+#include "Renderer/RenderGraph.h"
+#include "Renderer/RenderUtils.h"
+
+using namespace RS;
+
+namespace
+{
+	const RenderGraph::TextureDesc COLOR_DESC = { 64, 64, DXGI_FORMAT_R8G8B8A8_UNORM };
+	const RenderGraph::TextureDesc DEPTH_DESC = { 64, 64, DXGI_FORMAT_D32_FLOAT, 1, 1, true };
+
+	// The output of the frame, the graph does not need the texture itself to compile.
+	uint32 ImportOutput(RenderGraph& graph)
+	{
+		return graph.ImportTexture("Output", nullptr, COLOR_DESC);
+	}
+
+	bool HasTransition(const RenderGraph& graph, uint32 pass, uint32 texture, RenderGraph::Access before, RenderGraph::Access after)
+	{
+		for (const RenderGraph::Transition& transition : graph.GetTransitions(pass))
+		{
+			if (transition.Resource == texture && transition.Before == before && transition.After == after)
+				return true;
+		}
+		return false;
+	}
+}
+
+RS_TEST(RenderGraphCullsUnusedPasses)
+{
+	RenderGraph graph;
+	uint32 output = ImportOutput(graph);
+	uint32 unused = graph.CreateTexture("Unused", COLOR_DESC);
+	uint32 unusedChain = graph.CreateTexture("UnusedChain", COLOR_DESC);
+	uint32 gBuffer = graph.CreateTexture("GBuffer", COLOR_DESC);
+
+	uint32 unusedPass = graph.AddPass("Unused", nullptr);
+	graph.Write(unusedPass, unused);
+
+	// Reads a texture, but its own write is never read, so both passes of the chain are culled.
+	uint32 chainFirstPass = graph.AddPass("ChainFirst", nullptr);
+	graph.Write(chainFirstPass, unusedChain);
+	uint32 chainSecondPass = graph.AddPass("ChainSecond", nullptr);
+	graph.Read(chainSecondPass, unusedChain);
+	graph.Write(chainSecondPass, unused);
+
+	uint32 geometryPass = graph.AddPass("Geometry", nullptr);
+	graph.Write(geometryPass, gBuffer);
+	uint32 lightPass = graph.AddPass("Light", nullptr);
+	graph.Read(lightPass, gBuffer);
+	graph.Write(lightPass, output);
+
+	uint32 debugPass = graph.AddPass("Debug", nullptr);
+	graph.SetSideEffect(debugPass);
+
+	RS_CHECK(graph.Compile(), "The graph did not compile");
+	RS_CHECK(graph.IsCulled(unusedPass) && graph.IsCulled(chainFirstPass) && graph.IsCulled(chainSecondPass), "A pass whose writes are never read was kept");
+	RS_CHECK(!graph.IsCulled(geometryPass) && !graph.IsCulled(lightPass), "A pass which leads to the output was culled");
+	RS_CHECK(!graph.IsCulled(debugPass), "A pass with a side effect was culled");
+
+	const RenderGraph::Stats& stats = graph.GetStats();
+	RS_CHECK(stats.NumPasses == 6 && stats.NumCulledPasses == 3, "{} of {} passes were culled", stats.NumCulledPasses, stats.NumPasses);
+	RS_CHECK(stats.NumTransientTextures == 1, "{} transient textures are used", stats.NumTransientTextures);
+	RS_CHECK(graph.GetPhysicalIndex(unused) == RenderGraph::INVALID_INDEX && graph.GetPhysicalIndex(unusedChain) == RenderGraph::INVALID_INDEX,
+		"A texture of a culled pass got a physical texture");
+	RS_CHECK(graph.GetPhysicalIndex(output) == RenderGraph::INVALID_INDEX, "The imported texture got a physical texture");
+}
+
+RS_TEST(RenderGraphPlacesTransitionsInPassOrder)
+{
+	RenderGraph graph;
+	uint32 output = ImportOutput(graph);
+	uint32 depth = graph.CreateTexture("Depth", DEPTH_DESC);
+	uint32 gBuffer = graph.CreateTexture("GBuffer", COLOR_DESC);
+
+	uint32 depthPass = graph.AddPass("DepthPrePass", nullptr);
+	graph.Write(depthPass, depth);
+	uint32 geometryPass = graph.AddPass("Geometry", nullptr);
+	graph.Write(geometryPass, depth);
+	graph.Write(geometryPass, gBuffer);
+	uint32 lightPass = graph.AddPass("Light", nullptr);
+	graph.Read(lightPass, depth);
+	graph.Read(lightPass, gBuffer);
+	graph.Write(lightPass, output);
+
+	RS_CHECK(graph.Compile(), "The graph did not compile");
+
+	// Each texture moves from undefined to written in its first pass, and to read in the pass after its producers.
+	using Access = RenderGraph::Access;
+	RS_CHECK(graph.GetTransitions(depthPass).size() == 1 && HasTransition(graph, depthPass, depth, Access::NONE, Access::WRITE), "The depth pre pass has the wrong transitions");
+	RS_CHECK(graph.GetTransitions(geometryPass).size() == 1 && HasTransition(graph, geometryPass, gBuffer, Access::NONE, Access::WRITE),
+		"The geometry pass has {} transitions, writing depth again needs none", graph.GetTransitions(geometryPass).size());
+	RS_CHECK(HasTransition(graph, lightPass, depth, Access::WRITE, Access::READ) && HasTransition(graph, lightPass, gBuffer, Access::WRITE, Access::READ)
+		&& HasTransition(graph, lightPass, output, Access::NONE, Access::WRITE), "The light pass has the wrong transitions");
+	RS_CHECK(graph.GetStats().NumTransitions == 5, "{} transitions", graph.GetStats().NumTransitions);
+}
+
+RS_TEST(RenderGraphRejectsReadsBeforeWrites)
+{
+	// The passes run in the order they were added, reading a transient texture before the pass which writes it is an error.
+	RenderGraph graph;
+	uint32 output = ImportOutput(graph);
+	uint32 gBuffer = graph.CreateTexture("GBuffer", COLOR_DESC);
+	uint32 lightPass = graph.AddPass("Light", nullptr);
+	graph.Read(lightPass, gBuffer);
+	graph.Write(lightPass, output);
+	uint32 geometryPass = graph.AddPass("Geometry", nullptr);
+	graph.Write(geometryPass, gBuffer);
+	graph.SetSideEffect(geometryPass);
+	RS_CHECK(!graph.Compile(), "A read before the write compiled");
+
+	// The same texture as a shader resource and a target in one pass.
+	graph.Clear();
+	output = ImportOutput(graph);
+	uint32 pass = graph.AddPass("ReadWrite", nullptr);
+	graph.Read(pass, output);
+	graph.Write(pass, output);
+	RS_CHECK(!graph.Compile(), "A pass which reads and writes the same texture compiled");
+
+	// An imported texture has content before the first pass.
+	graph.Clear();
+	uint32 history = graph.ImportTexture("History", nullptr, COLOR_DESC);
+	output = ImportOutput(graph);
+	pass = graph.AddPass("Resolve", nullptr);
+	graph.Read(pass, history);
+	graph.Write(pass, output);
+	RS_CHECK(graph.Compile() && graph.GetTransitions(pass).size() == 2, "Reading an imported texture first did not compile");
+}
+
+RS_TEST(RenderGraphAliasesTransientTextures)
+{
+	// A chain of passes where each reads the texture of the previous one, a texture is only alive for two passes.
+	RenderGraph graph;
+	uint32 output = ImportOutput(graph);
+	uint32 first = graph.CreateTexture("First", COLOR_DESC);
+	uint32 second = graph.CreateTexture("Second", COLOR_DESC);
+	uint32 third = graph.CreateTexture("Third", COLOR_DESC);
+	uint32 depth = graph.CreateTexture("Depth", DEPTH_DESC);
+
+	uint32 firstPass = graph.AddPass("First", nullptr);
+	graph.Write(firstPass, first);
+	graph.Write(firstPass, depth);
+	uint32 secondPass = graph.AddPass("Second", nullptr);
+	graph.Read(secondPass, first);
+	graph.Write(secondPass, second);
+	uint32 thirdPass = graph.AddPass("Third", nullptr);
+	graph.Read(thirdPass, second);
+	graph.Read(thirdPass, depth);
+	graph.Write(thirdPass, third);
+	uint32 outputPass = graph.AddPass("Output", nullptr);
+	graph.Read(outputPass, third);
+	graph.Write(outputPass, output);
+
+	RS_CHECK(graph.Compile(), "The graph did not compile");
+
+	// First is free after the second pass, so third takes its place. Second overlaps both, and depth has another description.
+	RS_CHECK(graph.GetPhysicalIndex(first) == graph.GetPhysicalIndex(third), "First and third do not share a physical texture");
+	RS_CHECK(graph.GetPhysicalIndex(second) != graph.GetPhysicalIndex(first), "Second shares a texture with first, they are alive at the same time");
+	RS_CHECK(graph.GetPhysicalIndex(depth) != graph.GetPhysicalIndex(first) && graph.GetPhysicalIndex(depth) != graph.GetPhysicalIndex(second),
+		"Depth shares a texture with another description");
+
+	const uint64 colorSize = RenderUtils::EstimateTextureSize(COLOR_DESC.Format, COLOR_DESC.Width, COLOR_DESC.Height, 1, 1);
+	const uint64 depthSize = RenderUtils::EstimateTextureSize(DEPTH_DESC.Format, DEPTH_DESC.Width, DEPTH_DESC.Height, 1, 1);
+	const RenderGraph::Stats& stats = graph.GetStats();
+	RS_CHECK(stats.NumTransientTextures == 4 && stats.NumPhysicalTextures == 3, "{} transient textures in {} physical textures", stats.NumTransientTextures, stats.NumPhysicalTextures);
+	RS_CHECK(stats.NonAliasedBytes == colorSize * 3 + depthSize && stats.AliasedBytes == colorSize * 2 + depthSize, "{} bytes aliased to {} bytes",
+		stats.NonAliasedBytes, stats.AliasedBytes);
+	RS_CHECK(stats.PeakLiveBytes == colorSize * 2 + depthSize, "{} bytes are alive at the peak", stats.PeakLiveBytes);
+}
+
+RS_DEVICE_TEST(RenderGraphImportsTypelessDepthTextures)
+{
+	// A depth texture which is also read in shaders, made like RenderUtils::GetDepthFormats describes.
+	D3D11_TEXTURE2D_DESC textureDesc = {};
+	textureDesc.Width				= 64;
+	textureDesc.Height				= 64;
+	textureDesc.MipLevels			= 1;
+	textureDesc.ArraySize			= 1;
+	textureDesc.Format				= DXGI_FORMAT_R24G8_TYPELESS;
+	textureDesc.SampleDesc.Count	= 1;
+	textureDesc.Usage				= D3D11_USAGE_DEFAULT;
+	textureDesc.BindFlags			= D3D11_BIND_DEPTH_STENCIL | D3D11_BIND_SHADER_RESOURCE;
+	ID3D11Texture2D* pTexture = nullptr;
+	HRESULT result = RenderAPI::Get()->GetDevice()->CreateTexture2D(&textureDesc, nullptr, &pTexture);
+	RS_D311_ASSERT_CHECK(result, "Failed to create the depth texture!");
+
+	RenderGraph graph;
+	uint32 depth = graph.ImportTexture("Depth", pTexture);
+	const RenderGraph::TextureDesc& desc = graph.GetDesc(depth);
+	RS_CHECK(desc.IsDepth && desc.Format == DXGI_FORMAT_D24_UNORM_S8_UINT, "The typeless depth texture was imported as {}", RenderUtils::FormatToString(desc.Format));
+	pTexture->Release();
+}
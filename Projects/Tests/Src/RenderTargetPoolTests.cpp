@@ -0,0 +1,145 @@
+#include "PreCompiled.h"
+#include "Test.h"
+
+#include "Renderer/RenderTargetPool.h"
+#include "Renderer/RenderUtils.h"
+
+using namespace RS;
+
+namespace
+{
+	const uint32 MAX_UNUSED_FRAMES = 2;
+
+	RenderTargetPool::Desc MakeDesc(uint32 size, DXGI_FORMAT format = DXGI_FORMAT_R8G8B8A8_UNORM)
+	{
+		RenderTargetPool::Desc desc;
+		desc.Width	= size;
+		desc.Height	= size;
+		desc.Format	= format;
+		return desc;
+	}
+
+	uint64 GetSize(uint32 size)
+	{
+		return RenderUtils::EstimateTextureSize(DXGI_FORMAT_R8G8B8A8_UNORM, size, size, 1, 1);
+	}
+}
+
+RS_DEVICE_TEST(RenderTargetPoolReusesReleasedTargets)
+{
+	RenderTargetPool pool;
+	pool.Init(RenderAPI::Get()->GetDevice(), MAX_UNUSED_FRAMES, GetSize(64) * 16);
+
+	RenderTargetPool::Target* pFirst = pool.Acquire(MakeDesc(64));
+	RS_CHECK(pFirst && pFirst->pTexture && pFirst->pSRV && pFirst->pRTV && !pFirst->pDSV, "The target does not have the views of its bind flags");
+	RenderTargetPool::Target* pSecond = pool.Acquire(MakeDesc(64));
+	RS_CHECK(pSecond && pSecond != pFirst && pSecond->pTexture != pFirst->pTexture, "A target in use was handed out twice");
+
+	// A released target is handed out again for the same description only.
+	ID3D11Texture2D* pFirstTexture = pFirst->pTexture;
+	pool.Release(pFirst);
+	RenderTargetPool::Target* pOther = pool.Acquire(MakeDesc(64, DXGI_FORMAT_R16G16B16A16_FLOAT));
+	RS_CHECK(pOther && pOther->pTexture != pFirstTexture, "A target with another format was reused");
+	RenderTargetPool::Target* pReused = pool.Acquire(MakeDesc(64));
+	RS_CHECK(pReused && pReused->pTexture == pFirstTexture, "The released target was not reused");
+
+	const RenderTargetPool::Stats& stats = pool.GetStats();
+	RS_CHECK(stats.NumHits == 1 && stats.NumMisses == 3 && stats.NumTargets == 3 && stats.NumInUse == 3, "{} hits, {} misses, {} targets and {} in use",
+		stats.NumHits, stats.NumMisses, stats.NumTargets, stats.NumInUse);
+	RS_CHECK(stats.BytesInUse == stats.BytesHeld, "{} of {} bytes are in use", stats.BytesInUse, stats.BytesHeld);
+
+	// Giving back a target twice is ignored.
+	pool.Release(pSecond);
+	pool.Release(pSecond);
+	RS_CHECK(pool.GetStats().NumInUse == 2, "{} targets are in use", pool.GetStats().NumInUse);
+
+	pool.Release(pOther);
+	pool.Release(pReused);
+	pool.Release();
+}
+
+RS_DEVICE_TEST(RenderTargetPoolAcquiresDepthTargets)
+{
+	RenderTargetPool pool;
+	pool.Init(RenderAPI::Get()->GetDevice(), MAX_UNUSED_FRAMES, GetSize(64) * 16);
+
+	RenderTargetPool::Desc desc = MakeDesc(64, DXGI_FORMAT_D32_FLOAT);
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_DEPTH_STENCIL;
+	RenderTargetPool::Target* pDepth = pool.Acquire(desc);
+	RS_CHECK(pDepth && pDepth->pDSV && pDepth->pSRV && !pDepth->pRTV, "The depth target does not have a depth stencil view and a shader resource view");
+	pool.Release(pDepth);
+
+	// A depth format which can not be read in shaders.
+	desc.Format = DXGI_FORMAT_D32_FLOAT_S8X24_UINT;
+	RS_CHECK(pool.Acquire(desc) == nullptr, "A depth target which can not be read was created");
+	RS_CHECK(pool.GetStats().NumTargets == 1, "The failed target was kept");
+	pool.Release();
+}
+
+RS_DEVICE_TEST(RenderTargetPoolEvictsUnusedTargets)
+{
+	RenderTargetPool pool;
+	pool.Init(RenderAPI::Get()->GetDevice(), MAX_UNUSED_FRAMES, GetSize(64) * 16);
+
+	RenderTargetPool::Target* pKept = pool.Acquire(MakeDesc(64));
+	RenderTargetPool::Target* pFree = pool.Acquire(MakeDesc(32));
+	pool.Release(pFree);
+
+	// A free target is kept for MAX_UNUSED_FRAMES frames, a target in use is never evicted.
+	for (uint32 frame = 0; frame < MAX_UNUSED_FRAMES; frame++)
+		pool.NewFrame();
+	RS_CHECK(pool.GetStats().NumTargets == 2, "A target was evicted after {} frames", MAX_UNUSED_FRAMES);
+	pool.NewFrame();
+	RS_CHECK(pool.GetStats().NumTargets == 1 && pool.GetStats().NumEvicted == 1, "{} targets are left after {} frames", pool.GetStats().NumTargets, MAX_UNUSED_FRAMES + 1);
+	for (uint32 frame = 0; frame < 10; frame++)
+		pool.NewFrame();
+	RS_CHECK(pool.GetStats().NumTargets == 1 && pKept->pTexture, "The target in use was evicted");
+
+	// Using a target again resets its age.
+	pool.Release(pKept);
+	pool.NewFrame();
+	pKept = pool.Acquire(MakeDesc(64));
+	pool.Release(pKept);
+	for (uint32 frame = 0; frame < MAX_UNUSED_FRAMES; frame++)
+		pool.NewFrame();
+	RS_CHECK(pool.GetStats().NumTargets == 1 && pool.GetStats().NumHits == 1, "The reused target was evicted");
+
+	pool.EvictFree();
+	RS_CHECK(pool.GetStats().NumTargets == 0 && pool.GetStats().BytesHeld == 0, "EvictFree kept {} targets", pool.GetStats().NumTargets);
+	pool.Release();
+}
+
+RS_DEVICE_TEST(RenderTargetPoolStaysWithinBudget)
+{
+	// Room for three 64x64 targets, each with another format such that they are never reused for each other.
+	const DXGI_FORMAT formats[4] = { DXGI_FORMAT_R8G8B8A8_UNORM, DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, DXGI_FORMAT_B8G8R8A8_UNORM, DXGI_FORMAT_R32_FLOAT };
+	RenderTargetPool pool;
+	pool.Init(RenderAPI::Get()->GetDevice(), 1000, GetSize(64) * 3);
+
+	RenderTargetPool::Target* pTargets[3] = {};
+	for (uint32 i = 0; i < 3; i++)
+		pTargets[i] = pool.Acquire(MakeDesc(64, formats[i]));
+	for (uint32 i = 0; i < 3; i++)
+	{
+		pool.Release(pTargets[i]);
+		pool.NewFrame();
+	}
+	RS_CHECK(pool.GetStats().NumTargets == 3 && pool.GetStats().NumEvicted == 0, "A target was evicted within the budget");
+
+	// A fourth target goes over the budget, the free target which was given back first is released.
+	RenderTargetPool::Target* pFourth = pool.Acquire(MakeDesc(64, formats[3]));
+	const RenderTargetPool::Stats& stats = pool.GetStats();
+	RS_CHECK(stats.NumTargets == 3 && stats.NumEvicted == 1 && stats.BytesHeld <= stats.BudgetBytes, "{} targets with {} of {} bytes", stats.NumTargets, stats.BytesHeld, stats.BudgetBytes);
+
+	RenderTargetPool::Target* pSecond = pool.Acquire(MakeDesc(64, formats[1]));
+	RS_CHECK(pool.GetStats().NumHits == 1, "A target which was used more recently was evicted");
+	pool.Release(pSecond);
+	RenderTargetPool::Target* pFirst = pool.Acquire(MakeDesc(64, formats[0]));
+	RS_CHECK(pool.GetStats().NumHits == 1 && pool.GetStats().NumMisses == 5, "The least recently used target was kept");
+
+	// Targets in use are never released, even when the pool is over its budget.
+	RS_CHECK(pFourth->pTexture && pFirst->pTexture, "A target in use was released");
+	pool.Release(pFirst);
+	pool.Release(pFourth);
+	pool.Release();
+}
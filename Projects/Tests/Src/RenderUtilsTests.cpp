@@ -0,0 +1,104 @@
+#include "PreCompiled.h"
+#include "Test.h"
+
+#include "Core/ResourceManager.h"
+#include "Renderer/RenderUtils.h"
+
+using namespace RS;
+
+namespace
+{
+	struct FormatSize
+	{
+		DXGI_FORMAT	Format;
+		uint32		PixelBytes; // Zero for block compressed formats.
+		uint32		BlockBytes; // Bytes of a 4x4 block.
+	};
+
+	// Every format RenderUtils knows the size of, from the DXGI documentation.
+	const FormatSize FORMAT_SIZES[] =
+	{
+		{ DXGI_FORMAT_R32G32B32A32_TYPELESS, 16, 0 }, { DXGI_FORMAT_R32G32B32A32_FLOAT, 16, 0 }, { DXGI_FORMAT_R32G32B32A32_UINT, 16, 0 }, { DXGI_FORMAT_R32G32B32A32_SINT, 16, 0 },
+		{ DXGI_FORMAT_R32G32B32_TYPELESS, 12, 0 }, { DXGI_FORMAT_R32G32B32_FLOAT, 12, 0 }, { DXGI_FORMAT_R32G32B32_UINT, 12, 0 }, { DXGI_FORMAT_R32G32B32_SINT, 12, 0 },
+		{ DXGI_FORMAT_R16G16B16A16_TYPELESS, 8, 0 }, { DXGI_FORMAT_R16G16B16A16_FLOAT, 8, 0 }, { DXGI_FORMAT_R16G16B16A16_UNORM, 8, 0 }, { DXGI_FORMAT_R16G16B16A16_UINT, 8, 0 },
+		{ DXGI_FORMAT_R16G16B16A16_SNORM, 8, 0 }, { DXGI_FORMAT_R16G16B16A16_SINT, 8, 0 },
+		{ DXGI_FORMAT_R32G32_TYPELESS, 8, 0 }, { DXGI_FORMAT_R32G32_FLOAT, 8, 0 }, { DXGI_FORMAT_R32G32_UINT, 8, 0 }, { DXGI_FORMAT_R32G32_SINT, 8, 0 },
+		{ DXGI_FORMAT_R32G8X24_TYPELESS, 8, 0 }, { DXGI_FORMAT_D32_FLOAT_S8X24_UINT, 8, 0 }, { DXGI_FORMAT_R32_FLOAT_X8X24_TYPELESS, 8, 0 }, { DXGI_FORMAT_X32_TYPELESS_G8X24_UINT, 8, 0 },
+		{ DXGI_FORMAT_R10G10B10A2_TYPELESS, 4, 0 }, { DXGI_FORMAT_R10G10B10A2_UNORM, 4, 0 }, { DXGI_FORMAT_R10G10B10A2_UINT, 4, 0 }, { DXGI_FORMAT_R11G11B10_FLOAT, 4, 0 },
+		{ DXGI_FORMAT_R8G8B8A8_TYPELESS, 4, 0 }, { DXGI_FORMAT_R8G8B8A8_UNORM, 4, 0 }, { DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, 4, 0 }, { DXGI_FORMAT_R8G8B8A8_UINT, 4, 0 },
+		{ DXGI_FORMAT_R8G8B8A8_SNORM, 4, 0 }, { DXGI_FORMAT_R8G8B8A8_SINT, 4, 0 },
+		{ DXGI_FORMAT_R16G16_TYPELESS, 4, 0 }, { DXGI_FORMAT_R16G16_FLOAT, 4, 0 }, { DXGI_FORMAT_R16G16_UNORM, 4, 0 }, { DXGI_FORMAT_R16G16_UINT, 4, 0 },
+		{ DXGI_FORMAT_R16G16_SNORM, 4, 0 }, { DXGI_FORMAT_R16G16_SINT, 4, 0 },
+		{ DXGI_FORMAT_R32_TYPELESS, 4, 0 }, { DXGI_FORMAT_D32_FLOAT, 4, 0 }, { DXGI_FORMAT_R32_FLOAT, 4, 0 }, { DXGI_FORMAT_R32_UINT, 4, 0 }, { DXGI_FORMAT_R32_SINT, 4, 0 },
+		{ DXGI_FORMAT_R24G8_TYPELESS, 4, 0 }, { DXGI_FORMAT_D24_UNORM_S8_UINT, 4, 0 }, { DXGI_FORMAT_R24_UNORM_X8_TYPELESS, 4, 0 }, { DXGI_FORMAT_X24_TYPELESS_G8_UINT, 4, 0 },
+		{ DXGI_FORMAT_R9G9B9E5_SHAREDEXP, 4, 0 }, { DXGI_FORMAT_R8G8_B8G8_UNORM, 2, 0 }, { DXGI_FORMAT_G8R8_G8B8_UNORM, 2, 0 },
+		{ DXGI_FORMAT_R8G8_TYPELESS, 2, 0 }, { DXGI_FORMAT_R8G8_UNORM, 2, 0 }, { DXGI_FORMAT_R8G8_UINT, 2, 0 }, { DXGI_FORMAT_R8G8_SNORM, 2, 0 }, { DXGI_FORMAT_R8G8_SINT, 2, 0 },
+		{ DXGI_FORMAT_R16_TYPELESS, 2, 0 }, { DXGI_FORMAT_R16_FLOAT, 2, 0 }, { DXGI_FORMAT_D16_UNORM, 2, 0 }, { DXGI_FORMAT_R16_UNORM, 2, 0 }, { DXGI_FORMAT_R16_UINT, 2, 0 },
+		{ DXGI_FORMAT_R16_SNORM, 2, 0 }, { DXGI_FORMAT_R16_SINT, 2, 0 },
+		{ DXGI_FORMAT_R8_TYPELESS, 1, 0 }, { DXGI_FORMAT_R8_UNORM, 1, 0 }, { DXGI_FORMAT_R8_UINT, 1, 0 }, { DXGI_FORMAT_R8_SNORM, 1, 0 }, { DXGI_FORMAT_R8_SINT, 1, 0 },
+		{ DXGI_FORMAT_A8_UNORM, 1, 0 },
+		{ DXGI_FORMAT_B5G6R5_UNORM, 2, 0 }, { DXGI_FORMAT_B5G5R5A1_UNORM, 2, 0 },
+		{ DXGI_FORMAT_B8G8R8A8_UNORM, 4, 0 }, { DXGI_FORMAT_B8G8R8X8_UNORM, 4, 0 }, { DXGI_FORMAT_R10G10B10_XR_BIAS_A2_UNORM, 4, 0 }, { DXGI_FORMAT_B8G8R8A8_TYPELESS, 4, 0 },
+		{ DXGI_FORMAT_B8G8R8A8_UNORM_SRGB, 4, 0 }, { DXGI_FORMAT_B8G8R8X8_TYPELESS, 4, 0 }, { DXGI_FORMAT_B8G8R8X8_UNORM_SRGB, 4, 0 },
+		{ DXGI_FORMAT_BC1_TYPELESS, 0, 8 }, { DXGI_FORMAT_BC1_UNORM, 0, 8 }, { DXGI_FORMAT_BC1_UNORM_SRGB, 0, 8 },
+		{ DXGI_FORMAT_BC4_TYPELESS, 0, 8 }, { DXGI_FORMAT_BC4_UNORM, 0, 8 }, { DXGI_FORMAT_BC4_SNORM, 0, 8 },
+		{ DXGI_FORMAT_BC2_TYPELESS, 0, 16 }, { DXGI_FORMAT_BC2_UNORM, 0, 16 }, { DXGI_FORMAT_BC2_UNORM_SRGB, 0, 16 },
+		{ DXGI_FORMAT_BC3_TYPELESS, 0, 16 }, { DXGI_FORMAT_BC3_UNORM, 0, 16 }, { DXGI_FORMAT_BC3_UNORM_SRGB, 0, 16 },
+		{ DXGI_FORMAT_BC5_TYPELESS, 0, 16 }, { DXGI_FORMAT_BC5_UNORM, 0, 16 }, { DXGI_FORMAT_BC5_SNORM, 0, 16 },
+	};
+}
+
+RS_TEST(TextureSizeEstimateMatchesEachFormat)
+{
+	// A 64x32 texture with all 7 mips and 3 slices:
+	//	Pixels:	64*32 + 32*16 + 16*8 + 8*4 + 4*2 + 2*1 + 1*1 = 2731 for each slice.
+	//	Blocks:	16*8 + 8*4 + 4*2 + 2*1 + 1*1 + 1*1 + 1*1 = 173 for each slice, the mips below 4x4 still take a whole block.
+	// A 5x3 texture with one mip is 15 pixels or 2*1 blocks.
+	for (const FormatSize& size : FORMAT_SIZES)
+	{
+		const std::string name = RenderUtils::FormatToString(size.Format);
+		RS_CHECK(RenderUtils::GetSizeOfFormat(size.Format) == size.PixelBytes, "{} is {} bytes per pixel, expected {}", name, RenderUtils::GetSizeOfFormat(size.Format), size.PixelBytes);
+		RS_CHECK(RenderUtils::GetBlockSizeOfFormat(size.Format) == size.BlockBytes, "{} is {} bytes per block, expected {}", name, RenderUtils::GetBlockSizeOfFormat(size.Format), size.BlockBytes);
+		RS_CHECK(RenderUtils::IsBlockCompressed(size.Format) == (size.BlockBytes > 0), "{} is wrongly block compressed", name);
+
+		const uint64 mippedSize = size.BlockBytes > 0 ? 173ull * size.BlockBytes * 3 : 2731ull * size.PixelBytes * 3;
+		const uint64 oddSize	= size.BlockBytes > 0 ? 2ull * size.BlockBytes : 15ull * size.PixelBytes;
+		RS_CHECK(RenderUtils::EstimateTextureSize(size.Format, 64, 32, 7, 3) == mippedSize, "{} 64x32 with 7 mips and 3 slices is estimated at {} bytes, expected {}",
+			name, RenderUtils::EstimateTextureSize(size.Format, 64, 32, 7, 3), mippedSize);
+		RS_CHECK(RenderUtils::EstimateTextureSize(size.Format, 5, 3, 1, 1) == oddSize, "{} 5x3 is estimated at {} bytes, expected {}",
+			name, RenderUtils::EstimateTextureSize(size.Format, 5, 3, 1, 1), oddSize);
+	}
+
+	// The examples of the documentation, and zero mips or slices count as one.
+	RS_CHECK(RenderUtils::EstimateTextureSize(DXGI_FORMAT_R8G8B8A8_UNORM, 256, 256, 9, 1) == 349524, "The documented RGBA8 example is wrong");
+	RS_CHECK(RenderUtils::EstimateTextureSize(DXGI_FORMAT_BC1_UNORM, 256, 256, 1, 1) == 32768, "The documented BC1 example is wrong");
+	RS_CHECK(RenderUtils::EstimateTextureSize(DXGI_FORMAT_R8G8B8A8_UNORM, 4, 4, 0, 0) == 64, "Zero mips and slices are not counted as one");
+}
+
+RS_DEVICE_TEST(TextureFootprintIsKeptOnTheResource)
+{
+	std::vector<uint8> pixels(16 * 8 * 4, 0x7F);
+	TextureLoadDesc loadDesc = {};
+	loadDesc.ImageDesc.Memory.pData			= pixels.data();
+	loadDesc.ImageDesc.Memory.Size			= (uint32)pixels.size();
+	loadDesc.ImageDesc.Memory.Width			= 16;
+	loadDesc.ImageDesc.Memory.Height		= 8;
+	loadDesc.ImageDesc.Memory.IsCompressed	= false;
+	loadDesc.ImageDesc.IsFromFile			= false;
+	loadDesc.ImageDesc.NumChannels			= ImageLoadDesc::Channels::RGBA;
+	loadDesc.ImageDesc.Name					= "Tests.Footprint";
+	loadDesc.GenerateMipmaps				= true;
+
+	std::shared_ptr<ResourceManager> pResourceManager = ResourceManager::Get();
+	auto [pTexture, textureID] = pResourceManager->LoadTextureResource(loadDesc);
+	ImageResource* pImage = pResourceManager->GetResource<ImageResource>(pTexture->ImageHandler);
+
+	// The ResourceManager makes log2 of the smallest side mips: 16x8, 8x4 and 4x2, 128 + 32 + 8 pixels of 4 bytes.
+	RS_CHECK(pTexture->NumMipLevels == 3, "The texture has {} mips", pTexture->NumMipLevels);
+	RS_CHECK(pTexture->GPUBytes == 672, "The texture is {} bytes on the GPU, expected 672", pTexture->GPUBytes);
+	RS_CHECK(pImage && pImage->CPUBytes == pixels.size(), "The image is {} bytes in RAM, expected {}", pImage ? pImage->CPUBytes : 0, pixels.size());
+
+	ResourceManager::MemoryReport report = pResourceManager->GetMemoryReport();
+	RS_CHECK(report.PerType[Resource::Type::TEXTURE].GPUBytes >= pTexture->GPUBytes, "The report does not include the texture");
+	pResourceManager->FreeResource(pTexture);
+}
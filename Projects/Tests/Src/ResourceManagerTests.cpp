@@ -0,0 +1,160 @@
+#include "PreCompiled.h"
+#include "Test.h"
+
+#include "Core/ResourceManager.h"
+#include "Renderer/RenderUtils.h"
+
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+
+using namespace RS;
+
+namespace
+{
+	struct ResidencyRun
+	{
+		uint64	ImageCPUBytes	= 0;
+		uint32	NumEvicted		= 0;
+		uint64	SteadyRSS		= 0; // Growth of the working set after all models are loaded.
+		uint64	PeakRSS			= 0; // Largest growth after one of the models was loaded.
+	};
+
+	uint64 GetWorkingSetBytes()
+	{
+		PROCESS_MEMORY_COUNTERS counters = {};
+		GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+		return (uint64)counters.WorkingSetSize;
+	}
+
+	// Starts over with the residency of the config, which the tests change.
+	void ResetResourceManager()
+	{
+		ResourceManager::Get()->Release();
+		ResourceManager::Get()->Init();
+	}
+
+	ResidencyRun LoadAllModels(ImageResidency residency, uint64 budgetBytes)
+	{
+		ResetResourceManager();
+		std::shared_ptr<ResourceManager> pResourceManager = ResourceManager::Get();
+		pResourceManager->SetImageResidency(residency, budgetBytes);
+
+		ResidencyRun run;
+		const uint64 baseRSS = GetWorkingSetBytes();
+		auto GetGrowth = [baseRSS]() { uint64 rss = GetWorkingSetBytes(); return rss > baseRSS ? rss - baseRSS : 0ull; };
+		for (const auto& entry : std::filesystem::recursive_directory_iterator(RS_MODEL_PATH))
+		{
+			std::string extension = entry.path().extension().string();
+			if (extension != ".gltf" && extension != ".glb" && extension != ".fbx" && extension != ".obj")
+				continue;
+
+			ModelLoadDesc modelLoadDesc = {};
+			modelLoadDesc.FilePath	= std::filesystem::relative(entry.path(), RS_MODEL_PATH).generic_string();
+			modelLoadDesc.Loader	= extension == ".obj" ? ModelLoadDesc::Loader::TINYOBJ : ModelLoadDesc::Loader::ASSIMP;
+			pResourceManager->LoadModelResource(modelLoadDesc);
+			run.PeakRSS = std::max(run.PeakRSS, GetGrowth());
+		}
+
+		ResourceManager::Stats stats = pResourceManager->GetStats();
+		run.ImageCPUBytes	= stats.TypeCPUBytes[Resource::Type::IMAGE];
+		run.NumEvicted		= stats.NumEvictedImages;
+		run.SteadyRSS		= GetGrowth();
+
+		ResetResourceManager();
+		return run;
+	}
+}
+
+RS_DEVICE_TEST(ImageResidencyLimitsMemoryOfAllModels)
+{
+	// The first run only warms up the loaders and the heap.
+	LoadAllModels(ImageResidency::KEEP, 0);
+
+	ResidencyRun keep = LoadAllModels(ImageResidency::KEEP, 0);
+	ResidencyRun drop = LoadAllModels(ImageResidency::DROP_AFTER_UPLOAD, 0);
+	const uint64 budgetBytes = keep.ImageCPUBytes / 4;
+	ResidencyRun lru = LoadAllModels(ImageResidency::LRU_BUDGET, budgetBytes);
+
+	const float toMB = 1.f / (1024.f * 1024.f);
+	LOG_INFO("All models, image data: {:.1f} MB kept, {:.1f} MB dropped after upload, {:.1f} MB under a budget of {:.1f} MB.",
+		keep.ImageCPUBytes * toMB, drop.ImageCPUBytes * toMB, lru.ImageCPUBytes * toMB, budgetBytes * toMB);
+	LOG_INFO("All models, working set growth (steady/peak): {:.1f}/{:.1f} MB kept, {:.1f}/{:.1f} MB dropped, {:.1f}/{:.1f} MB under the budget.",
+		keep.SteadyRSS * toMB, keep.PeakRSS * toMB, drop.SteadyRSS * toMB, drop.PeakRSS * toMB, lru.SteadyRSS * toMB, lru.PeakRSS * toMB);
+
+	RS_CHECK(keep.ImageCPUBytes > 0 && keep.NumEvicted == 0, "Keep holds {} bytes with {} evicted images", keep.ImageCPUBytes, keep.NumEvicted);
+	RS_CHECK(drop.NumEvicted > 0 && drop.ImageCPUBytes < keep.ImageCPUBytes, "Drop holds {} bytes with {} evicted images", drop.ImageCPUBytes, drop.NumEvicted);
+
+	// The images which drop keeps are the ones which cannot be reloaded, the budget is on top of them.
+	RS_CHECK(lru.ImageCPUBytes <= drop.ImageCPUBytes + budgetBytes, "The budget of {} bytes holds {} bytes", budgetBytes, lru.ImageCPUBytes);
+
+	// At least half of the dropped pixel data has to be given back to the system, the rest can be held by the heap.
+	const uint64 droppedBytes = keep.ImageCPUBytes - drop.ImageCPUBytes;
+	RS_CHECK(drop.SteadyRSS + droppedBytes / 2 <= keep.SteadyRSS, "Dropping {} bytes grew the working set by {} bytes, against {} bytes when kept",
+		droppedBytes, drop.SteadyRSS, keep.SteadyRSS);
+	RS_CHECK(drop.PeakRSS < keep.PeakRSS, "The peak working set was {} bytes when dropped, against {} bytes when kept", drop.PeakRSS, keep.PeakRSS);
+	RS_CHECK(lru.SteadyRSS < keep.SteadyRSS, "The budget grew the working set by {} bytes, against {} bytes when kept", lru.SteadyRSS, keep.SteadyRSS);
+}
+
+RS_DEVICE_TEST(ImageBudgetKeepsCubeMapFacesUntilUploaded)
+{
+	// A budget smaller than one face, each face evicts the ones before it if they are not pinned.
+	ResetResourceManager();
+	std::shared_ptr<ResourceManager> pResourceManager = ResourceManager::Get();
+	pResourceManager->SetImageResidency(ImageResidency::LRU_BUDGET, 1);
+
+	const char* faces[6] = { "right.jpg", "left.jpg", "top.jpg", "bottom.jpg", "front.jpg", "back.jpg" };
+	CubeMapLoadDesc cubeMapDesc = {};
+	for (uint32 i = 0; i < 6; i++)
+	{
+		cubeMapDesc.ImageDescs[i].File.Path		= std::string("Skybox/") + faces[i];
+		cubeMapDesc.ImageDescs[i].Name			= std::string("Tests.Skybox.") + faces[i];
+		cubeMapDesc.ImageDescs[i].NumChannels	= ImageLoadDesc::Channels::RGBA;
+	}
+	auto [pCubeMap, id] = pResourceManager->LoadCubeMapResource(cubeMapDesc);
+	RS_CHECK(pCubeMap && pCubeMap->pTexture, "The cube map was not created");
+	if (!pCubeMap || !pCubeMap->pTexture)
+		return;
+
+	D3D11_TEXTURE2D_DESC stagingDesc = {};
+	pCubeMap->pTexture->GetDesc(&stagingDesc);
+	stagingDesc.Usage			= D3D11_USAGE_STAGING;
+	stagingDesc.BindFlags		= 0;
+	stagingDesc.CPUAccessFlags	= D3D11_CPU_ACCESS_READ;
+	stagingDesc.MiscFlags		= 0;
+	ID3D11Texture2D* pStaging = nullptr;
+	HRESULT result = RenderAPI::Get()->GetDevice()->CreateTexture2D(&stagingDesc, nullptr, &pStaging);
+	RS_D311_ASSERT_CHECK(result, "Failed to create the staging texture!");
+	ID3D11DeviceContext* pContext = RenderAPI::Get()->GetDeviceContext();
+	pContext->CopyResource(pStaging, pCubeMap->pTexture);
+
+	// The faces are evicted after the upload, reloading them one at a time gives the data which should have been uploaded.
+	const uint32 pixelSize = RenderUtils::GetSizeOfFormat(stagingDesc.Format);
+	for (uint32 i = 0; i < 6; i++)
+	{
+		ImageResource* pImage = pResourceManager->GetResource<ImageResource>(pCubeMap->ImageHandlers[i]);
+		RS_CHECK(pImage && pImage->IsResident == false, "Face {} is still resident under the budget", i);
+		if (!pImage || !pResourceManager->RequestImageData(pImage))
+		{
+			RS_CHECK(false, "Face {} could not be reloaded", i);
+			continue;
+		}
+
+		D3D11_MAPPED_SUBRESOURCE mapped = {};
+		result = pContext->Map(pStaging, D3D11CalcSubresource(0, i, stagingDesc.MipLevels), D3D11_MAP_READ, 0, &mapped);
+		RS_D311_ASSERT_CHECK(result, "Failed to map the staging texture!");
+		const uint32 rowBytes = pImage->Width * pixelSize;
+		uint32 numDifferentRows = 0;
+		for (uint32 y = 0; y < pImage->Height; y++)
+			numDifferentRows += std::memcmp((const uint8*)mapped.pData + (size_t)y * mapped.RowPitch, pImage->Data.data() + (size_t)y * rowBytes, rowBytes) != 0 ? 1 : 0;
+		pContext->Unmap(pStaging, D3D11CalcSubresource(0, i, stagingDesc.MipLevels));
+		RS_CHECK(numDifferentRows == 0, "{} rows of face {} differ from its image", numDifferentRows, i);
+	}
+
+	pStaging->Release();
+	pResourceManager->FreeResource(pCubeMap);
+	ResetResourceManager();
+}
@@ -0,0 +1,150 @@
+#include "PreCompiled.h"
+#include "Test.h"
+#include "FakeShaderCompiler.h"
+
+#include "Renderer/ShaderBatch.h"
+
+#include <filesystem>
+
+using namespace RS;
+using namespace RS::Tests;
+
+namespace
+{
+	const uint32 NUM_SHADERS		= 16;
+	const uint32 COMPILE_TIME_MS	= 20;
+
+	// Each shader has a vertex and a pixel stage, the files are only known by the compiler.
+	std::shared_ptr<FakeShaderCompiler> MakeCompiler(uint32 compileTimeMS)
+	{
+		auto pCompiler = std::make_shared<FakeShaderCompiler>(compileTimeMS);
+		pCompiler->SetFile(std::string(RS_SHADER_PATH) + "Common.hlsl", "float4 Color;");
+		for (uint32 i = 0; i < NUM_SHADERS; i++)
+		{
+			pCompiler->SetFile(std::string(RS_SHADER_PATH) + "Shader" + std::to_string(i) + ".vs", "float4 main() : SV_Position { return " + std::to_string(i) + "; }");
+			pCompiler->SetFile(std::string(RS_SHADER_PATH) + "Shader" + std::to_string(i) + ".ps", "#include <" + std::string(RS_SHADER_PATH) + "Common.hlsl>\nfloat4 main() : SV_Target { return Color; }");
+		}
+		pCompiler->SetFile(std::string(RS_SHADER_PATH) + "Broken.ps", "#error");
+		return pCompiler;
+	}
+
+	void AddShaders(ShaderBatch& batch, std::vector<Shader>& shaders)
+	{
+		for (uint32 i = 0; i < (uint32)shaders.size(); i++)
+		{
+			Shader::Descriptor descriptor;
+			descriptor.Vertex	= "Shader" + std::to_string(i) + ".vs";
+			descriptor.Fragment	= "Shader" + std::to_string(i) + ".ps";
+			batch.Add(&shaders[i], descriptor, AttributeLayout());
+		}
+	}
+
+	std::shared_ptr<ShaderCache> MakeCache(const std::filesystem::path& folder, bool enabled, std::shared_ptr<IShaderCompiler> pCompiler)
+	{
+		std::error_code error;
+		std::filesystem::remove_all(folder, error);
+		auto pCache = std::make_shared<ShaderCache>();
+		pCache->Init(folder.string(), 1024 * 1024, enabled, pCompiler);
+		return pCache;
+	}
+}
+
+RS_TEST(ShaderBatchCompilesEveryStage)
+{
+	std::filesystem::path folder = std::filesystem::temp_directory_path() / "RSShaderBatchTests";
+	auto pCompiler = MakeCompiler(0);
+	auto pCache = MakeCache(folder, true, pCompiler);
+
+	std::vector<Shader> shaders(NUM_SHADERS);
+	ShaderBatch batch(pCache);
+	AddShaders(batch, shaders);
+	batch.Compile(4);
+
+	const ShaderBatch::Stats& stats = batch.GetStats();
+	RS_CHECK(stats.NumShaders == NUM_SHADERS && stats.NumStages == NUM_SHADERS * 2 && stats.NumThreads == 4, "{} shaders and {} stages on {} threads",
+		stats.NumShaders, stats.NumStages, stats.NumThreads);
+	RS_CHECK(pCompiler->GetNumCompiles() == NUM_SHADERS * 2, "Compiled {} stages", pCompiler->GetNumCompiles());
+	for (uint32 i = 0; i < batch.GetNumShaders(); i++)
+	{
+		const std::vector<Shader::Stage>& stages = batch.GetStages(i);
+		RS_CHECK(stages.size() == 2 && stages[0].Type == ShaderTypeFlag::VERTEX && stages[1].Type == ShaderTypeFlag::FRAGMENT, "Shader {} has the wrong stages", i);
+		for (const Shader::Stage& stage : stages)
+		{
+			// The fake bytecode ends with the target, which shows the stage got the result of its own file.
+			std::string byteCode(stage.Result.ByteCode.begin(), stage.Result.ByteCode.end());
+			const std::string target = ShaderTypeToTarget(stage.Type);
+			RS_CHECK(stage.Compiled && byteCode.ends_with(target), "{} was not compiled for {}", stage.FilePath, target);
+		}
+		RS_CHECK(stages[1].Result.Includes.size() == 1, "The includes of shader {} were not reported", i);
+	}
+
+	// The same shaders again are all read from the cache.
+	std::vector<Shader> cachedShaders(NUM_SHADERS);
+	ShaderBatch cachedBatch(pCache);
+	AddShaders(cachedBatch, cachedShaders);
+	cachedBatch.Compile(4);
+	uint32 numFromCache = 0;
+	for (uint32 i = 0; i < cachedBatch.GetNumShaders(); i++)
+	{
+		for (const Shader::Stage& stage : cachedBatch.GetStages(i))
+			numFromCache += stage.Compiled && stage.Result.FromCache ? 1 : 0;
+	}
+	RS_CHECK(numFromCache == NUM_SHADERS * 2 && pCompiler->GetNumCompiles() == NUM_SHADERS * 2, "{} stages came from the cache", numFromCache);
+
+	pCache->Release();
+	std::error_code error;
+	std::filesystem::remove_all(folder, error);
+}
+
+RS_TEST(ShaderBatchKeepsErrorsPerStage)
+{
+	std::filesystem::path folder = std::filesystem::temp_directory_path() / "RSShaderBatchTests";
+	auto pCompiler = MakeCompiler(0);
+	auto pCache = MakeCache(folder, false, pCompiler);
+
+	std::vector<Shader> shaders(2);
+	ShaderBatch batch(pCache);
+	Shader::Descriptor descriptor;
+	descriptor.Vertex	= "Shader0.vs";
+	descriptor.Fragment	= "Broken.ps";
+	batch.Add(&shaders[0], descriptor, AttributeLayout());
+	descriptor.Fragment	= "Shader0.ps";
+	batch.Add(&shaders[1], descriptor, AttributeLayout());
+	batch.Add(nullptr, descriptor, AttributeLayout());
+	batch.Compile(2);
+
+	const std::vector<Shader::Stage>& brokenStages = batch.GetStages(0);
+	RS_CHECK(batch.GetNumShaders() == 2, "The nullptr shader was added");
+	RS_CHECK(brokenStages[0].Compiled && !brokenStages[1].Compiled && !brokenStages[1].Result.Errors.empty(), "The broken stage did not keep its errors");
+	RS_CHECK(batch.GetStages(1)[0].Compiled && batch.GetStages(1)[1].Compiled, "A failed shader stopped the others");
+	pCache->Release();
+}
+
+RS_TEST(ShaderBatchCompilesInParallel)
+{
+	std::filesystem::path folder = std::filesystem::temp_directory_path() / "RSShaderBatchTests";
+	auto pCompiler = MakeCompiler(COMPILE_TIME_MS);
+	auto pCache = MakeCache(folder, false, pCompiler);
+
+	auto CompileOn = [&](uint32 numThreads)
+	{
+		std::vector<Shader> shaders(NUM_SHADERS);
+		ShaderBatch batch(pCache);
+		AddShaders(batch, shaders);
+		batch.Compile(numThreads);
+		return batch.GetStats();
+	};
+
+	ShaderBatch::Stats serial = CompileOn(1);
+	ShaderBatch::Stats parallel = CompileOn(4);
+	ShaderBatch::Stats clamped = CompileOn(1000);
+	LOG_INFO("Compiled {} stages of {} ms: {:.1f} ms on one thread, {:.1f} ms on four ({:.2f}x), {:.1f} ms of work.", parallel.NumStages, COMPILE_TIME_MS,
+		serial.CompileTimeMS, parallel.CompileTimeMS, serial.CompileTimeMS / parallel.CompileTimeMS, parallel.SerialCompileTimeMS);
+
+	RS_CHECK(serial.NumThreads == 1 && parallel.NumThreads == 4 && clamped.NumThreads == NUM_SHADERS * 2, "Ran on {}, {} and {} threads",
+		serial.NumThreads, parallel.NumThreads, clamped.NumThreads);
+	RS_CHECK(serial.CompileTimeMS >= (float)(NUM_SHADERS * 2 * COMPILE_TIME_MS), "One thread took {:.1f} ms", serial.CompileTimeMS);
+	RS_CHECK(parallel.CompileTimeMS * 2.f < serial.CompileTimeMS, "Four threads took {:.1f} ms against {:.1f} ms on one", parallel.CompileTimeMS, serial.CompileTimeMS);
+	RS_CHECK(parallel.SerialCompileTimeMS >= serial.CompileTimeMS * 0.9f, "The work of the stages adds up to {:.1f} ms", parallel.SerialCompileTimeMS);
+	pCache->Release();
+}
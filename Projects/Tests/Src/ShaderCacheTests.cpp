@@ -0,0 +1,220 @@
+#include "PreCompiled.h"
+#include "Test.h"
+#include "FakeShaderCompiler.h"
+
+#include "Renderer/ShaderCache.h"
+
+#include <filesystem>
+
+using namespace RS;
+using namespace RS::Tests;
+
+namespace
+{
+	const uint64 MAX_CACHE_SIZE = 1024 * 1024;
+
+	std::filesystem::path MakeCacheFolder()
+	{
+		std::filesystem::path folder = std::filesystem::temp_directory_path() / "RSShaderCacheTests";
+		std::error_code error;
+		std::filesystem::remove_all(folder, error);
+		return folder;
+	}
+
+	std::shared_ptr<FakeShaderCompiler> MakeCompiler()
+	{
+		auto pCompiler = std::make_shared<FakeShaderCompiler>();
+		pCompiler->SetFile("Common.hlsl", "float4 Color;");
+		pCompiler->SetFile("Pixel.hlsl", "#include <Common.hlsl>\nfloat4 main() : SV_Target { return Color; }");
+		pCompiler->SetFile("Vertex.hlsl", "float4 main(float4 position : POSITION) : SV_Position { return position; }");
+		pCompiler->SetFile("Broken.hlsl", "#error");
+		return pCompiler;
+	}
+
+	ShaderCompileDesc MakeDesc(const std::string& filePath, const std::string& target)
+	{
+		ShaderCompileDesc desc;
+		desc.FilePath	= filePath;
+		desc.Target		= target;
+		return desc;
+	}
+
+	bool Compile(ShaderCache& cache, const ShaderCompileDesc& desc, ShaderCompileResult& outResult)
+	{
+		outResult = ShaderCompileResult();
+		return cache.Compile(desc, outResult);
+	}
+}
+
+RS_TEST(ShaderCacheHitsAfterTheFirstCompile)
+{
+	std::filesystem::path folder = MakeCacheFolder();
+	auto pCompiler = MakeCompiler();
+	ShaderCache cache;
+	cache.Init(folder.string(), MAX_CACHE_SIZE, true, pCompiler);
+
+	ShaderCompileDesc desc = MakeDesc("Pixel.hlsl", "ps_5_0");
+	ShaderCompileResult compiled;
+	RS_CHECK(Compile(cache, desc, compiled) && !compiled.FromCache, "The first compile failed or came from the cache");
+	RS_CHECK(compiled.Includes["Pixel.hlsl"].size() == 1, "The include was not reported");
+
+	ShaderCompileResult cached;
+	RS_CHECK(Compile(cache, desc, cached) && cached.FromCache, "The second compile failed or was not a hit");
+	RS_CHECK(cached.ByteCode == compiled.ByteCode, "The cached bytecode differs");
+	RS_CHECK(cached.Reflection.Bindings.size() == 1 && cached.Reflection.Bindings[0].Name == "Constants" && cached.Reflection.Bindings[0].Variables.size() == 1,
+		"The cached reflection differs");
+	RS_CHECK(cached.Includes["Pixel.hlsl"].size() == 1, "A hit does not report the includes");
+	RS_CHECK(pCompiler->GetNumCompiles() == 1, "Compiled {} times", pCompiler->GetNumCompiles());
+
+	ShaderCache::Stats stats = cache.GetStats();
+	RS_CHECK(stats.NumHits == 1 && stats.NumMisses == 1 && stats.NumEntries == 1 && stats.SizeBytes > 0, "{} hits, {} misses and {} entries",
+		stats.NumHits, stats.NumMisses, stats.NumEntries);
+	cache.Release();
+
+	// A restart finds the entries on disk.
+	ShaderCache restartedCache;
+	restartedCache.Init(folder.string(), MAX_CACHE_SIZE, true, pCompiler);
+	RS_CHECK(restartedCache.GetStats().NumEntries == 1, "The restarted cache found {} entries", restartedCache.GetStats().NumEntries);
+	RS_CHECK(Compile(restartedCache, desc, cached) && cached.FromCache && pCompiler->GetNumCompiles() == 1, "The restarted cache missed");
+	restartedCache.Release();
+
+	std::error_code error;
+	std::filesystem::remove_all(folder, error);
+}
+
+RS_TEST(ShaderCacheMissesWhenTheKeyChanges)
+{
+	std::filesystem::path folder = MakeCacheFolder();
+	auto pCompiler = MakeCompiler();
+	ShaderCache cache;
+	cache.Init(folder.string(), MAX_CACHE_SIZE, true, pCompiler);
+
+	ShaderCompileDesc desc = MakeDesc("Pixel.hlsl", "ps_5_0");
+	ShaderCompileResult result;
+	Compile(cache, desc, result);
+
+	// Every part of the key misses: the target, the entry point, the flags, the defines and an included file.
+	ShaderCompileDesc otherDesc = desc;
+	otherDesc.Target = "ps_5_1";
+	RS_CHECK(Compile(cache, otherDesc, result) && !result.FromCache, "Another target was a hit");
+	otherDesc = desc;
+	otherDesc.EntryPoint = "PSMain";
+	RS_CHECK(Compile(cache, otherDesc, result) && !result.FromCache, "Another entry point was a hit");
+	otherDesc = desc;
+	otherDesc.Flags = 1;
+	RS_CHECK(Compile(cache, otherDesc, result) && !result.FromCache, "Other flags were a hit");
+	otherDesc = desc;
+	otherDesc.Defines = { { "USE_SHADOWS", "1" } };
+	RS_CHECK(Compile(cache, otherDesc, result) && !result.FromCache, "Other defines were a hit");
+	otherDesc.Defines = { { "USE_SHADOWS", "0" } };
+	RS_CHECK(Compile(cache, otherDesc, result) && !result.FromCache, "Another define value was a hit");
+
+	pCompiler->SetFile("Common.hlsl", "float4 Color; float Intensity;");
+	RS_CHECK(Compile(cache, desc, result) && !result.FromCache, "A changed include was a hit");
+	RS_CHECK(Compile(cache, desc, result) && result.FromCache, "The changed include missed again");
+
+	ShaderCache::Stats stats = cache.GetStats();
+	RS_CHECK(stats.NumMisses == 7 && stats.NumHits == 1 && stats.NumEntries == 7, "{} misses, {} hits and {} entries", stats.NumMisses, stats.NumHits, stats.NumEntries);
+	RS_CHECK(ShaderCache::ComputeKey(desc, "a", "Fake") != ShaderCache::ComputeKey(desc, "a", "D3D"), "The compiler name is not part of the key");
+	cache.Release();
+
+	std::error_code error;
+	std::filesystem::remove_all(folder, error);
+}
+
+RS_TEST(ShaderCacheDoesNotStoreFailures)
+{
+	std::filesystem::path folder = MakeCacheFolder();
+	auto pCompiler = MakeCompiler();
+	ShaderCache cache;
+	cache.Init(folder.string(), MAX_CACHE_SIZE, true, pCompiler);
+
+	ShaderCompileResult result;
+	RS_CHECK(!Compile(cache, MakeDesc("Broken.hlsl", "ps_5_0"), result) && !result.Errors.empty(), "The broken shader compiled");
+	RS_CHECK(!Compile(cache, MakeDesc("Broken.hlsl", "ps_5_0"), result), "The broken shader came from the cache");
+	RS_CHECK(!Compile(cache, MakeDesc("Missing.hlsl", "ps_5_0"), result), "A missing file compiled");
+	RS_CHECK(pCompiler->GetNumCompiles() == 2, "Compiled {} times, a missing file should fail before compiling", pCompiler->GetNumCompiles());
+
+	ShaderCache::Stats stats = cache.GetStats();
+	RS_CHECK(stats.NumFailed == 3 && stats.NumEntries == 0, "{} failed and {} entries", stats.NumFailed, stats.NumEntries);
+	cache.Release();
+
+	std::error_code error;
+	std::filesystem::remove_all(folder, error);
+}
+
+RS_TEST(ShaderCacheReplacesBrokenEntries)
+{
+	std::filesystem::path folder = MakeCacheFolder();
+	auto pCompiler = MakeCompiler();
+	ShaderCache cache;
+	cache.Init(folder.string(), MAX_CACHE_SIZE, true, pCompiler);
+
+	ShaderCompileDesc desc = MakeDesc("Vertex.hlsl", "vs_5_0");
+	ShaderCompileResult result;
+	Compile(cache, desc, result);
+
+	// Cut the entry in half, like a crash while writing it with an older version would have.
+	for (const auto& entry : std::filesystem::directory_iterator(folder))
+		std::filesystem::resize_file(entry.path(), std::filesystem::file_size(entry.path()) / 2);
+
+	RS_CHECK(Compile(cache, desc, result) && !result.FromCache, "A broken entry was a hit");
+	RS_CHECK(Compile(cache, desc, result) && result.FromCache, "The replaced entry missed");
+	RS_CHECK(pCompiler->GetNumCompiles() == 2, "Compiled {} times", pCompiler->GetNumCompiles());
+	cache.Release();
+
+	std::error_code error;
+	std::filesystem::remove_all(folder, error);
+}
+
+RS_TEST(ShaderCacheEvictsLeastRecentlyUsed)
+{
+	std::filesystem::path folder = MakeCacheFolder();
+	auto pCompiler = MakeCompiler();
+	ShaderCache cache;
+	cache.Init(folder.string(), MAX_CACHE_SIZE, true, pCompiler);
+
+	ShaderCompileResult result;
+	ShaderCompileDesc pixelDesc = MakeDesc("Pixel.hlsl", "ps_5_0");
+	ShaderCompileDesc vertexDesc = MakeDesc("Vertex.hlsl", "vs_5_0");
+	Compile(cache, pixelDesc, result);
+	const uint64 pixelSize = cache.GetStats().SizeBytes;
+	Compile(cache, vertexDesc, result);
+	const uint64 totalSize = cache.GetStats().SizeBytes;
+	cache.Release();
+
+	// Room for the vertex shader only, the pixel shader was used least recently.
+	ShaderCache smallCache;
+	smallCache.Init(folder.string(), totalSize - pixelSize, true, pCompiler);
+	ShaderCache::Stats stats = smallCache.GetStats();
+	RS_CHECK(stats.NumEvicted == 1 && stats.NumEntries == 1 && stats.SizeBytes <= totalSize - pixelSize, "{} evicted, {} entries and {} bytes",
+		stats.NumEvicted, stats.NumEntries, stats.SizeBytes);
+	RS_CHECK(Compile(smallCache, vertexDesc, result) && result.FromCache, "The most recently used entry was evicted");
+
+	// Compiling the pixel shader again evicts the vertex shader, but never the entry which was just written.
+	RS_CHECK(Compile(smallCache, pixelDesc, result) && !result.FromCache, "The evicted entry was a hit");
+	stats = smallCache.GetStats();
+	RS_CHECK(stats.NumEvicted == 2 && stats.NumEntries == 1, "{} evicted and {} entries", stats.NumEvicted, stats.NumEntries);
+	RS_CHECK(Compile(smallCache, pixelDesc, result) && result.FromCache, "The new entry was evicted");
+	smallCache.Release();
+
+	std::error_code error;
+	std::filesystem::remove_all(folder, error);
+}
+
+RS_TEST(ShaderCacheDisabledAlwaysCompiles)
+{
+	std::filesystem::path folder = MakeCacheFolder();
+	auto pCompiler = MakeCompiler();
+	ShaderCache cache;
+	cache.Init(folder.string(), MAX_CACHE_SIZE, false, pCompiler);
+
+	ShaderCompileResult result;
+	for (uint32 i = 0; i < 3; i++)
+		RS_CHECK(Compile(cache, MakeDesc("Pixel.hlsl", "ps_5_0"), result) && !result.FromCache, "Compile {} came from the disabled cache", i);
+
+	ShaderCache::Stats stats = cache.GetStats();
+	RS_CHECK(pCompiler->GetNumCompiles() == 3 && stats.NumMisses == 3 && stats.NumEntries == 0, "Compiled {} times with {} entries", pCompiler->GetNumCompiles(), stats.NumEntries);
+	RS_CHECK(!std::filesystem::exists(folder), "The disabled cache made its folder");
+	cache.Release();
+}
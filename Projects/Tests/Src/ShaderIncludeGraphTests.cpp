@@ -0,0 +1,110 @@
+#include "PreCompiled.h"
+#include "Test.h"
+
+#include "Renderer/ShaderIncludeGraph.h"
+
+using namespace RS;
+
+namespace
+{
+	// Two shaders sharing a common include through a lighting file:
+	//	PBR.hlsl -> Lighting.hlsl -> Common.hlsl
+	//	Sky.hlsl -> Common.hlsl
+	//	Post.hlsl -> Tonemap.hlsl
+	ShaderIncludeGraph MakeGraph()
+	{
+		ShaderIncludeGraph graph;
+		graph.AddIncludes("Shaders/PBR.hlsl", { "Shaders/Include/Lighting.hlsl" });
+		graph.AddIncludes("Shaders/Include/Lighting.hlsl", { "Shaders/Include/Common.hlsl" });
+		graph.AddIncludes("Shaders/Sky.hlsl", { "Shaders/Include/Common.hlsl" });
+		graph.AddIncludes("Shaders/Post.hlsl", { "Shaders/Include/Tonemap.hlsl" });
+		return graph;
+	}
+
+	std::unordered_set<std::string> GetDependents(const ShaderIncludeGraph& graph, const std::vector<std::string>& changedFiles)
+	{
+		std::unordered_set<std::string> files;
+		graph.GetDependents(changedFiles, files);
+		return files;
+	}
+}
+
+RS_TEST(ShaderIncludeGraphFindsIndirectIncluders)
+{
+	ShaderIncludeGraph graph = MakeGraph();
+	RS_CHECK(graph.GetNumFiles() == 6, "The graph has {} files", graph.GetNumFiles());
+
+	std::unordered_set<std::string> files = GetDependents(graph, { "Shaders/Include/Common.hlsl" });
+	const std::unordered_set<std::string> expected = { "Shaders/Include/Common.hlsl", "Shaders/Include/Lighting.hlsl", "Shaders/PBR.hlsl", "Shaders/Sky.hlsl" };
+	RS_CHECK(files == expected, "Common.hlsl has {} dependents", files.size());
+
+	files = GetDependents(graph, { "Shaders/Include/Tonemap.hlsl" });
+	RS_CHECK(files.size() == 2 && files.contains("Shaders/Post.hlsl"), "Tonemap.hlsl has {} dependents", files.size());
+
+	// A shader which is not included by anything only affects itself, and so does a file the graph does not know.
+	files = GetDependents(graph, { "Shaders/PBR.hlsl", "Shaders/Unknown.hlsl" });
+	RS_CHECK(files.size() == 2 && files.contains("Shaders/PBR.hlsl") && files.contains("Shaders/Unknown.hlsl"), "A root shader has {} dependents", files.size());
+}
+
+RS_TEST(ShaderIncludeGraphNormalizesPaths)
+{
+	ShaderIncludeGraph graph;
+	graph.AddIncludes("Shaders\\PBR.hlsl", { "Shaders/Include/../Include/./Common.hlsl" });
+
+	std::unordered_set<std::string> files = GetDependents(graph, { "Shaders\\Include\\Common.hlsl" });
+	RS_CHECK(files.contains("Shaders/PBR.hlsl"), "Differently written paths are different files");
+	RS_CHECK(ShaderIncludeGraph::NormalizePath("A/B/../C.hlsl") == "A/C.hlsl", "Normalized to {}", ShaderIncludeGraph::NormalizePath("A/B/../C.hlsl"));
+
+	std::vector<std::string> includedFiles = graph.GetIncludedFiles();
+	RS_CHECK(includedFiles.size() == 1 && includedFiles[0] == "Shaders/Include/Common.hlsl", "{} included files", includedFiles.size());
+}
+
+RS_TEST(ShaderIncludeGraphStopsAtCycles)
+{
+	ShaderIncludeGraph graph;
+	graph.AddIncludes("A.hlsl", { "B.hlsl" });
+	graph.AddIncludes("B.hlsl", { "C.hlsl" });
+	graph.AddIncludes("C.hlsl", { "A.hlsl" });
+
+	std::unordered_set<std::string> files = GetDependents(graph, { "B.hlsl" });
+	RS_CHECK(files.size() == 3, "The cycle has {} dependents", files.size());
+
+	graph.Clear();
+	RS_CHECK(graph.GetNumFiles() == 0 && GetDependents(graph, { "B.hlsl" }).size() == 1, "Clear kept {} files", graph.GetNumFiles());
+}
+
+RS_TEST(ShaderIncludeGraphScalesToLargeGraphs)
+{
+	// 1000 shaders, each including one of 100 material files, which include one of 10 lighting files, which all include one common file.
+	ShaderIncludeGraph graph;
+	for (uint32 i = 0; i < 10; i++)
+		graph.AddIncludes("Lighting" + std::to_string(i) + ".hlsl", { "Common.hlsl" });
+	for (uint32 i = 0; i < 100; i++)
+		graph.AddIncludes("Material" + std::to_string(i) + ".hlsl", { "Lighting" + std::to_string(i % 10) + ".hlsl" });
+	for (uint32 i = 0; i < 1000; i++)
+		graph.AddIncludes("Shader" + std::to_string(i) + ".hlsl", { "Material" + std::to_string(i % 100) + ".hlsl" });
+
+	RS_CHECK(GetDependents(graph, { "Common.hlsl" }).size() == 1111, "Common.hlsl does not reach every file");
+	RS_CHECK(GetDependents(graph, { "Lighting3.hlsl" }).size() == 111, "Lighting3.hlsl reaches {} files", GetDependents(graph, { "Lighting3.hlsl" }).size());
+	RS_CHECK(GetDependents(graph, { "Material42.hlsl" }).size() == 11, "Material42.hlsl reaches {} files", GetDependents(graph, { "Material42.hlsl" }).size());
+}
+
+RS_TEST(ShaderIncludeGraphResolvesIncludes)
+{
+	const std::unordered_set<std::string> existingFiles = { "Shaders/Include/Common.hlsl", "Shaders/Passes/Common.hlsl", "Shaders/Passes/Local.hlsl" };
+	auto FileExists = [&](const std::string& path) { return existingFiles.contains(path); };
+
+	// Local includes are found next to the includer first, then in the shader folder.
+	std::string path = ShaderIncludeGraph::ResolveInclude("Shaders/Passes/Blur.hlsl", "Local.hlsl", false, "Shaders", FileExists);
+	RS_CHECK(path == "Shaders/Passes/Local.hlsl", "Resolved to {}", path);
+	path = ShaderIncludeGraph::ResolveInclude("Shaders/Passes/Blur.hlsl", "Common.hlsl", false, "Shaders", FileExists);
+	RS_CHECK(path == "Shaders/Passes/Common.hlsl", "Resolved to {}", path);
+	path = ShaderIncludeGraph::ResolveInclude("Shaders/Passes/Blur.hlsl", "Include/Common.hlsl", false, "Shaders", FileExists);
+	RS_CHECK(path == "Shaders/Include/Common.hlsl", "Resolved to {}", path);
+
+	// System includes skip the folder of the includer.
+	path = ShaderIncludeGraph::ResolveInclude("Shaders/Passes/Blur.hlsl", "Local.hlsl", true, "Shaders", FileExists);
+	RS_CHECK(path.empty(), "A system include resolved to {}", path);
+	path = ShaderIncludeGraph::ResolveInclude("Shaders/Passes/Blur.hlsl", "Missing.hlsl", false, "Shaders", FileExists);
+	RS_CHECK(path.empty(), "A missing include resolved to {}", path);
+}
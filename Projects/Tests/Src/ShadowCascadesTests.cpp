@@ -0,0 +1,180 @@
+#include "PreCompiled.h"
+#include "Test.h"
+
+#include "Renderer/ShadowCascades.h"
+
+using namespace RS;
+
+namespace
+{
+	const float		NEAR_PLANE	= 0.1f;
+	const float		FAR_PLANE	= 500.f;
+	const uint32	RESOLUTION	= 2048;
+
+	glm::mat4 GetProj()
+	{
+		return glm::perspectiveRH(glm::radians(60.f), 16.f / 9.f, NEAR_PLANE, FAR_PLANE);
+	}
+
+	// The eight view space corners of the part of a symmetric frustum between two view depths.
+	std::vector<glm::vec3> GetCorners(float tanHalfFovX, float tanHalfFovY, float nearSplit, float farSplit)
+	{
+		std::vector<glm::vec3> corners;
+		for (float depth : { nearSplit, farSplit })
+		{
+			for (float x : { -1.f, 1.f })
+			{
+				for (float y : { -1.f, 1.f })
+					corners.push_back(glm::vec3(x * depth * tanHalfFovX, y * depth * tanHalfFovY, -depth));
+			}
+		}
+		return corners;
+	}
+
+	float GetMaxDistance(const std::vector<glm::vec3>& points, const glm::vec3& center)
+	{
+		float maxDistance = 0.f;
+		for (const glm::vec3& point : points)
+			maxDistance = glm::max(maxDistance, glm::distance(point, center));
+		return maxDistance;
+	}
+}
+
+RS_TEST(ShadowCascadesSplitTheFrustum)
+{
+	float splits[ShadowCascades::MAX_CASCADES + 1];
+
+	// Uniform splits are evenly spaced.
+	ShadowCascades::ComputeSplits(1.f, 101.f, 4, 0.f, splits);
+	const float uniform[] = { 1.f, 26.f, 51.f, 76.f, 101.f };
+	for (uint32 i = 0; i < 5; i++)
+		RS_CHECK(glm::abs(splits[i] - uniform[i]) < 0.001f, "Uniform split {} is {} instead of {}", i, splits[i], uniform[i]);
+
+	// Logarithmic splits have the same ratio between each pair.
+	ShadowCascades::ComputeSplits(1.f, 10000.f, 4, 1.f, splits);
+	for (uint32 i = 0; i < 4; i++)
+		RS_CHECK(glm::abs(splits[i + 1] / splits[i] - 10.f) < 0.01f, "Logarithmic split {} is {}", i + 1, splits[i + 1]);
+
+	// A blend lies between the two and still starts and ends at the planes.
+	float uniformSplits[ShadowCascades::MAX_CASCADES + 1];
+	float logSplits[ShadowCascades::MAX_CASCADES + 1];
+	ShadowCascades::ComputeSplits(NEAR_PLANE, FAR_PLANE, 3, 0.f, uniformSplits);
+	ShadowCascades::ComputeSplits(NEAR_PLANE, FAR_PLANE, 3, 1.f, logSplits);
+	ShadowCascades::ComputeSplits(NEAR_PLANE, FAR_PLANE, 3, 0.75f, splits);
+	RS_CHECK(splits[0] == NEAR_PLANE && splits[3] == FAR_PLANE, "The splits go from {} to {}", splits[0], splits[3]);
+	for (uint32 i = 1; i < 3; i++)
+	{
+		RS_CHECK(splits[i] > splits[i - 1], "Split {} is not after the previous one", i);
+		RS_CHECK(splits[i] >= logSplits[i] && splits[i] <= uniformSplits[i], "Split {} is {}, outside of {} and {}", i, splits[i], logSplits[i], uniformSplits[i]);
+	}
+}
+
+RS_TEST(ShadowCascadesSphereHoldsTheFrustum)
+{
+	// The frustum of the camera, and a narrow one whose sphere is centered between the near and far plane.
+	const glm::mat4 proj = GetProj();
+	const glm::vec4 frustums[] =
+	{
+		glm::vec4(1.f / proj[0][0], 1.f / proj[1][1], 0.1f, 10.f),
+		glm::vec4(1.f / proj[0][0], 1.f / proj[1][1], 100.f, 500.f),
+		glm::vec4(0.3f, 0.2f, 0.1f, 10.f),
+		glm::vec4(0.3f, 0.2f, 10.f, 40.f)
+	};
+
+	for (const glm::vec4& frustum : frustums)
+	{
+		const float nearSplit = frustum.z, farSplit = frustum.w;
+		glm::vec4 sphere = ShadowCascades::ComputeBoundingSphere(frustum.x, frustum.y, nearSplit, farSplit);
+		std::vector<glm::vec3> corners = GetCorners(frustum.x, frustum.y, nearSplit, farSplit);
+		float maxDistance = GetMaxDistance(corners, glm::vec3(sphere));
+		RS_CHECK(sphere.x == 0.f && sphere.y == 0.f, "The center of {} to {} is off the view axis", nearSplit, farSplit);
+		RS_CHECK(maxDistance <= sphere.w * 1.0001f, "A corner of {} to {} is {} from the center, the radius is {}", nearSplit, farSplit, maxDistance, sphere.w);
+
+		// The smallest sphere touches the far corners, and the near corners too unless it is centered on the far plane.
+		float farDistance = glm::distance(corners[7], glm::vec3(sphere));
+		RS_CHECK(glm::abs(farDistance - sphere.w) < sphere.w * 0.0001f, "The sphere of {} to {} does not touch the far corners", nearSplit, farSplit);
+		if (-sphere.z < farSplit)
+		{
+			float nearDistance = glm::distance(corners[0], glm::vec3(sphere));
+			RS_CHECK(glm::abs(nearDistance - sphere.w) < sphere.w * 0.0001f, "The sphere of {} to {} does not touch the near corners", nearSplit, farSplit);
+		}
+	}
+
+	// A wide frustum, the center would be past the far plane, so the sphere is around the far corners only.
+	glm::vec4 sphere = ShadowCascades::ComputeBoundingSphere(2.f, 2.f, 1.f, 2.f);
+	RS_CHECK(sphere.z == -2.f && glm::abs(sphere.w - 2.f * glm::sqrt(8.f)) < 0.0001f, "The wide sphere is at {} with radius {}", sphere.z, sphere.w);
+	RS_CHECK(GetMaxDistance(GetCorners(2.f, 2.f, 1.f, 2.f), glm::vec3(sphere)) <= sphere.w * 1.0001f, "The wide sphere does not hold the frustum");
+}
+
+RS_TEST(ShadowCascadesAreStableWhenTheCameraMoves)
+{
+	const glm::mat4 proj = GetProj();
+	const glm::vec3 lightDir = glm::normalize(glm::vec3(0.3f, -1.f, 0.4f));
+	ShadowCascades cascades;
+	cascades.Init(4, RESOLUTION, 0.75f, 100.f);
+
+	// The camera turns and moves a fraction of a texel each frame.
+	std::vector<float> radii;
+	for (uint32 frame = 0; frame < 16; frame++)
+	{
+		glm::vec3 position = glm::vec3(frame * 0.013f, 2.f, frame * -0.027f);
+		glm::vec3 forward = glm::vec3(glm::sin(frame * 0.3f), -0.1f, -glm::cos(frame * 0.3f));
+		glm::mat4 view = glm::lookAtRH(position, position + forward, glm::vec3(0.f, 1.f, 0.f));
+		cascades.Update(view, proj, NEAR_PLANE, FAR_PLANE, lightDir);
+
+		RS_CHECK(cascades.GetNumCascades() == 4 && cascades.GetCascade(3).FarSplit == 100.f, "The cascades end at {} instead of the shadow distance", cascades.GetCascade(3).FarSplit);
+		const glm::mat4 invView = glm::inverse(view);
+		for (uint32 i = 0; i < cascades.GetNumCascades(); i++)
+		{
+			const ShadowCascades::Cascade& cascade = cascades.GetCascade(i);
+			if (frame == 0)
+				radii.push_back(cascade.BoundingSphere.w);
+			RS_CHECK(cascade.BoundingSphere.w == radii[i], "The radius of cascade {} changed from {} to {} when the camera turned", i, radii[i], cascade.BoundingSphere.w);
+
+			// The world space corners of the cascade are inside its sphere.
+			std::vector<glm::vec3> corners = GetCorners(1.f / proj[0][0], 1.f / proj[1][1], cascade.NearSplit, cascade.FarSplit);
+			for (glm::vec3& corner : corners)
+				corner = glm::vec3(invView * glm::vec4(corner, 1.f));
+			float maxDistance = GetMaxDistance(corners, glm::vec3(cascade.BoundingSphere));
+			RS_CHECK(maxDistance <= cascade.BoundingSphere.w * 1.0001f, "A corner of cascade {} is outside of its sphere", i);
+
+			// The world origin lands on a whole texel, so every point stays in its texel.
+			glm::vec2 origin = glm::vec2(cascade.ViewProj * glm::vec4(0.f, 0.f, 0.f, 1.f)) * (RESOLUTION * 0.5f);
+			glm::vec2 error = glm::abs(origin - glm::round(origin));
+			RS_CHECK(error.x < 0.01f && error.y < 0.01f, "The origin of cascade {} is {} texels off the grid", i, glm::max(error.x, error.y));
+		}
+	}
+}
+
+RS_TEST(ShadowCascadesCullCasters)
+{
+	const glm::vec3 lightDir = glm::vec3(0.f, -1.f, 0.f);
+	const glm::mat4 view = glm::lookAtRH(glm::vec3(0.f, 2.f, 0.f), glm::vec3(0.f, 2.f, -1.f), glm::vec3(0.f, 1.f, 0.f));
+	ShadowCascades cascades;
+	cascades.Init(2, RESOLUTION, 0.75f, 50.f);
+	cascades.Update(view, GetProj(), NEAR_PLANE, FAR_PLANE, lightDir);
+
+	// The light shines straight down on the sphere of the first cascade.
+	const ShadowCascades::Cascade& first = cascades.GetCascade(0);
+	const glm::vec3 center = glm::vec3(first.BoundingSphere);
+	const float radius = first.BoundingSphere.w;
+	auto MakeBox = [&](const glm::vec3& offset) { return AABB{ center + offset - glm::vec3(0.5f), center + offset + glm::vec3(0.5f) }; };
+	std::vector<AABB> casters =
+	{
+		MakeBox(glm::vec3(0.f)),							// In the cascade.
+		MakeBox(glm::vec3(radius * 3.f, 0.f, 0.f)),			// Beside the cascade.
+		MakeBox(glm::vec3(0.f, radius * 4.f, 0.f)),			// Between the light and the cascade.
+		MakeBox(glm::vec3(0.f, -radius * 4.f, 0.f)),		// Below the cascade, it can not cast onto it.
+		MakeBox(glm::vec3(radius + 0.25f, 0.f, 0.f))		// Overlaps the side of the cascade.
+	};
+	cascades.CullCasters(casters);
+
+	const std::vector<uint32>& kept = first.Casters;
+	RS_CHECK(kept == std::vector<uint32>({ 0, 2, 4 }), "The first cascade kept {} casters", kept.size());
+	RS_CHECK(first.NumCulled == 2, "The first cascade culled {} casters", first.NumCulled);
+	RS_CHECK(ShadowCascades::IsInCascade(first, casters[0]) && !ShadowCascades::IsInCascade(first, casters[3]), "IsInCascade differs from CullCasters");
+
+	// Every caster is either kept or culled by the other cascade as well.
+	const ShadowCascades::Cascade& second = cascades.GetCascade(1);
+	RS_CHECK(second.Casters.size() + second.NumCulled == casters.size(), "The second cascade has {} casters and {} culled", second.Casters.size(), second.NumCulled);
+}
@@ -0,0 +1,92 @@
+#include "PreCompiled.h"
+#include "Test.h"
+
+#include "Renderer/StateCache.h"
+
+using namespace RS;
+
+namespace
+{
+	// A texture a compute shader writes in one pass and reads in the next.
+	struct ReadWriteTexture
+	{
+		ID3D11Texture2D*			pTexture	= nullptr;
+		ID3D11ShaderResourceView*	pSRV		= nullptr;
+		ID3D11UnorderedAccessView*	pUAV		= nullptr;
+
+		ReadWriteTexture()
+		{
+			D3D11_TEXTURE2D_DESC textureDesc = {};
+			textureDesc.Width				= 4;
+			textureDesc.Height				= 4;
+			textureDesc.MipLevels			= 1;
+			textureDesc.ArraySize			= 1;
+			textureDesc.Format				= DXGI_FORMAT_R32_FLOAT;
+			textureDesc.SampleDesc.Count	= 1;
+			textureDesc.Usage				= D3D11_USAGE_DEFAULT;
+			textureDesc.BindFlags			= D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS;
+			ID3D11Device* pDevice = RenderAPI::Get()->GetDevice();
+			HRESULT result = pDevice->CreateTexture2D(&textureDesc, nullptr, &pTexture);
+			RS_D311_ASSERT_CHECK(result, "Failed to create the texture!");
+			result = pDevice->CreateShaderResourceView(pTexture, nullptr, &pSRV);
+			RS_D311_ASSERT_CHECK(result, "Failed to create the SRV!");
+			result = pDevice->CreateUnorderedAccessView(pTexture, nullptr, &pUAV);
+			RS_D311_ASSERT_CHECK(result, "Failed to create the UAV!");
+		}
+
+		~ReadWriteTexture()
+		{
+			pUAV->Release();
+			pSRV->Release();
+			pTexture->Release();
+		}
+	};
+
+	ID3D11ShaderResourceView* GetBoundComputeSRV()
+	{
+		ID3D11ShaderResourceView* pSRV = nullptr;
+		RenderAPI::Get()->GetDeviceContext()->CSGetShaderResources(0, 1, &pSRV);
+		if (pSRV)
+			pSRV->Release();
+		return pSRV;
+	}
+}
+
+RS_DEVICE_TEST(StateCacheUnbindsUnorderedAccessBeforeReading)
+{
+	ID3D11DeviceContext* pContext = RenderAPI::Get()->GetDeviceContext();
+	StateCache cache;
+	cache.Init(pContext, true);
+	ReadWriteTexture texture;
+	ID3D11UnorderedAccessView* pNullUAV = nullptr;
+	ID3D11ShaderResourceView* pNullSRV = nullptr;
+
+	// Written by one dispatch.
+	cache.SetUnorderedAccessViews(0, 1, &texture.pUAV);
+	cache.FlushBindings();
+
+	// Read by the next, the unbind of the UAV and the bind of the SRV are flushed together.
+	cache.SetUnorderedAccessViews(0, 1, &pNullUAV);
+	cache.SetShaderResources(ShaderTypeFlag::COMPUTE, 0, 1, &texture.pSRV);
+	cache.FlushBindings();
+	RS_CHECK(GetBoundComputeSRV() == texture.pSRV, "The SRV was dropped by the context, the UAV was still bound");
+
+	// Written again, the context unbinds the SRV and the cache has to bind it again for the next read.
+	cache.SetShaderResources(ShaderTypeFlag::COMPUTE, 0, 1, &pNullSRV);
+	cache.SetUnorderedAccessViews(0, 1, &texture.pUAV);
+	cache.FlushBindings();
+	cache.SetUnorderedAccessViews(0, 1, &pNullUAV);
+	cache.SetShaderResources(ShaderTypeFlag::COMPUTE, 0, 1, &texture.pSRV);
+	cache.FlushBindings();
+	RS_CHECK(GetBoundComputeSRV() == texture.pSRV, "The SRV was not bound again after the UAV");
+
+	// The same SRV again is filtered.
+	const uint32 numIssued = cache.GetTotalStats().NumIssued;
+	cache.SetShaderResources(ShaderTypeFlag::COMPUTE, 0, 1, &texture.pSRV);
+	cache.FlushBindings();
+	RS_CHECK(cache.GetTotalStats().NumIssued == numIssued, "A redundant bind was sent to the context");
+
+	pContext->CSSetShaderResources(0, 1, &pNullSRV);
+	cache.Release();
+	StateCache::Get()->Invalidate();
+}
@@ -0,0 +1,77 @@
+#include "PreCompiled.h"
+#include "Test.h"
+
+#include "Renderer/TerrainGenerator.h"
+#include "Utils/Timer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+using namespace RS;
+
+namespace
+{
+	const uint32 SIZE = 1024;
+}
+
+RS_TEST(TerrainGeneratorNoiseMatchesTheScalarNoise)
+{
+	// The noise of a region with SSE2 and with the scalar functions, on one core.
+	const TerrainGenerator::Settings settings;
+	const uint32 regionX = 384, regionZ = 640, regionSize = 256;
+	std::vector<float> simdNoise((size_t)regionSize * regionSize), scalarNoise((size_t)regionSize * regionSize);
+	Timer simdTimer;
+	TerrainGenerator::GenerateNoise(SIZE, settings, regionX, regionZ, regionSize, regionSize, simdNoise.data());
+	const float simdTimeMS = simdTimer.Stop().GetDeltaTimeMS();
+
+	Timer scalarTimer;
+	for (uint32 z = 0; z < regionSize; z++)
+	{
+		for (uint32 x = 0; x < regionSize; x++)
+			scalarNoise[(size_t)z * regionSize + x] = TerrainGenerator::SampleHeight(SIZE, settings, (float)(regionX + x), (float)(regionZ + z));
+	}
+	const float scalarTimeMS = scalarTimer.Stop().GetDeltaTimeMS();
+
+	float maxDifference = 0.f;
+	for (size_t i = 0; i < simdNoise.size(); i++)
+		maxDifference = std::max(maxDifference, std::abs(simdNoise[i] - scalarNoise[i]));
+
+	const float numSamples = (float)regionSize * regionSize;
+	LOG_INFO("Terrain noise of {} samples on one core: {:.2f} M samples/s scalar, {:.2f} M samples/s with SSE2 ({:.2f}x), the largest difference is {}.",
+		regionSize * regionSize, numSamples / (scalarTimeMS * 1000.f), numSamples / (simdTimeMS * 1000.f), simdTimeMS > 0.f ? scalarTimeMS / simdTimeMS : 1.f, maxDifference);
+	RS_CHECK(maxDifference <= 1e-6f, "The SSE2 noise differs from the scalar noise by {}", maxDifference);
+}
+
+RS_TEST(TerrainGeneratorIsTheSameForAnyTilesAndThreads)
+{
+	// The same terrain cut into tiles which do not line up, and generated on one thread.
+	const uint32 numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	const TerrainGenerator::Settings settings;
+	TerrainGenerator::Settings otherTilesSettings = settings;
+	otherTilesSettings.TileSize = 96;
+	TerrainGenerator generator, otherTilesGenerator, serialGenerator;
+	std::vector<uint16> heights, otherTilesHeights, serialHeights;
+	generator.Generate(SIZE, settings, heights, numThreads);
+	otherTilesGenerator.Generate(SIZE, otherTilesSettings, otherTilesHeights, numThreads);
+	serialGenerator.Generate(SIZE, settings, serialHeights, 1);
+	RS_CHECK(heights == otherTilesHeights, "The terrain in tiles of {} differs from the one in tiles of {}", otherTilesSettings.TileSize, settings.TileSize);
+	RS_CHECK(heights == serialHeights, "The terrain on {} threads differs from the one on one thread", numThreads);
+
+	// A region which is not aligned to the tiles.
+	const uint32 x = 300, z = 500, width = 77, height = 53;
+	std::vector<uint16> region((size_t)width * height);
+	TerrainGenerator::GenerateRegion(SIZE, settings, x, z, width, height, region.data());
+	bool isSeamless = true;
+	for (uint32 row = 0; row < height; row++)
+		isSeamless &= std::equal(region.begin() + (size_t)row * width, region.begin() + (size_t)(row + 1) * width, heights.begin() + (size_t)(z + row) * SIZE + x);
+	RS_CHECK(isSeamless, "The region at ({}, {}) differs from the terrain", x, z);
+
+	const TerrainGenerator::Stats& stats = generator.GetStats();
+	const TerrainGenerator::Stats& serialStats = serialGenerator.GetStats();
+	const float numTerrainSamples = (float)SIZE * SIZE;
+	LOG_INFO("Terrain generation of {}x{} in {} tiles: {:.1f} ms on {} threads ({:.2f} M samples/s per core), {:.1f} ms on 1 thread ({:.2f} M samples/s). "
+		"{:.1f} ms noise and {:.1f} ms erosion summed over the threads, {:.2f}x as many noise samples with the erosion margins.",
+		SIZE, SIZE, stats.NumTiles, stats.TotalTimeMS, stats.NumThreads, numTerrainSamples / (stats.TotalTimeMS * 1000.f) / stats.NumThreads,
+		serialStats.TotalTimeMS, numTerrainSamples / (serialStats.TotalTimeMS * 1000.f), stats.NoiseTimeMS, stats.ErosionTimeMS, (float)stats.NumNoiseSamples / numTerrainSamples);
+}
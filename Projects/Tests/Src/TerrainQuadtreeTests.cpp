@@ -0,0 +1,237 @@
+#include "PreCompiled.h"
+#include "Test.h"
+
+#include "Renderer/TerrainQuadtree.h"
+
+#include <cmath>
+#include <random>
+
+using namespace RS;
+
+namespace
+{
+	// The number of nodes on any level whose bounds are not the lowest and highest height under them.
+	template<typename Function>
+	uint32 CountWrongBounds(const TerrainQuadtree& quadtree, Function getHeight)
+	{
+		uint32 numWrongNodes = 0;
+		const uint32 size = quadtree.GetSize();
+		for (uint32 level = 0; level < quadtree.GetNumLods(); level++)
+		{
+			const uint32 nodeSize = quadtree.GetSettings().LeafSize << level;
+			const uint32 width = size / nodeSize;
+			for (uint32 node = 0; node < width * width; node++)
+			{
+				TerrainQuadtree::MinMax expected = { UINT16_MAX, 0 };
+				for (uint32 z = (node / width) * nodeSize; z <= (node / width + 1) * nodeSize; z++)
+				{
+					for (uint32 x = (node % width) * nodeSize; x <= (node % width + 1) * nodeSize; x++)
+					{
+						const uint16 height = getHeight(std::min(x, size - 1), std::min(z, size - 1));
+						expected.Min = std::min(expected.Min, height);
+						expected.Max = std::max(expected.Max, height);
+					}
+				}
+				const TerrainQuadtree::MinMax& minMax = quadtree.GetNodeHeights(level, node % width, node / width);
+				numWrongNodes += minMax.Min != expected.Min || minMax.Max != expected.Max;
+			}
+		}
+		return numWrongNodes;
+	}
+
+	// Smooth value noise with a few octaves, the same for a position on every run.
+	uint16 ProceduralHeight(uint32 x, uint32 z)
+	{
+		auto Hash = [](uint32 x, uint32 z, uint32 octave)
+		{
+			uint32 h = x * 0x8da6b343u ^ z * 0xd8163841u ^ octave * 0xcb1ab31fu;
+			h = (h ^ (h >> 15)) * 0x2c1b3c6du;
+			h = (h ^ (h >> 12)) * 0x297a2d39u;
+			return (float)((h ^ (h >> 15)) & 0xFFFF) / 65535.f;
+		};
+
+		float height = 0.f, amplitude = 0.5f;
+		uint32 period = 1024;
+		for (uint32 octave = 0; octave < 4; octave++, period /= 4, amplitude *= 0.3f)
+		{
+			const uint32 cellX = x / period, cellZ = z / period;
+			float tx = (float)(x % period) / period, tz = (float)(z % period) / period;
+			tx = tx * tx * (3.f - 2.f * tx);
+			tz = tz * tz * (3.f - 2.f * tz);
+			const float h0 = glm::mix(Hash(cellX, cellZ, octave), Hash(cellX + 1, cellZ, octave), tx);
+			const float h1 = glm::mix(Hash(cellX, cellZ + 1, octave), Hash(cellX + 1, cellZ + 1, octave), tx);
+			height += glm::mix(h0, h1, tz) * amplitude;
+		}
+		return (uint16)(std::min(height / 0.72f, 1.f) * 65535.f);
+	}
+
+	// A small terrain, where every cell of the size of a LOD 0 patch can be compared to its neighbours.
+	const uint32 SMALL_SIZE = 1024;
+
+	TerrainQuadtree::Settings GetSmallSettings()
+	{
+		TerrainQuadtree::Settings settings;
+		settings.NumLods		= 6;
+		settings.HeightScale	= 80.f;
+		settings.Lod0Range		= 80.f;
+		return settings;
+	}
+}
+
+RS_TEST(TerrainQuadtreeBoundsHoldTheHeights)
+{
+	TerrainQuadtree quadtree;
+	RS_CHECK(quadtree.Build(SMALL_SIZE, GetSmallSettings(), ProceduralHeight), "The quadtree of {}x{} was not built", SMALL_SIZE, SMALL_SIZE);
+	uint32 numWrongNodes = CountWrongBounds(quadtree, ProceduralHeight);
+	RS_CHECK(numWrongNodes == 0, "{} nodes have the wrong height bounds", numWrongNodes);
+
+	// The same from the heights in memory, on one thread.
+	std::vector<uint16> heights((size_t)SMALL_SIZE * SMALL_SIZE);
+	for (uint32 i = 0; i < (uint32)heights.size(); i++)
+		heights[i] = ProceduralHeight(i % SMALL_SIZE, i / SMALL_SIZE);
+	RS_CHECK(quadtree.Build(heights.data(), SMALL_SIZE, GetSmallSettings(), 1), "The quadtree of the heights was not built");
+	numWrongNodes = CountWrongBounds(quadtree, ProceduralHeight);
+	RS_CHECK(numWrongNodes == 0, "{} nodes built on one thread have the wrong height bounds", numWrongNodes);
+}
+
+RS_TEST(TerrainQuadtreeSelectsPatchesWithoutGapsOrCracks)
+{
+	const uint32 size = SMALL_SIZE;
+	const TerrainQuadtree::Settings settings = GetSmallSettings();
+	TerrainQuadtree quadtree;
+	quadtree.Build(size, settings, ProceduralHeight);
+
+	// Select with a frustum which holds the whole terrain, from a few positions above it.
+	const glm::mat4 everything = glm::orthoRH(-1e5f, 1e5f, -1e5f, 1e5f, -1e5f, 1e5f);
+	const uint32 cellSamples = quadtree.GetMeshSize();
+	const uint32 numCells = size / cellSamples;
+	std::mt19937 generator(1337);
+	std::uniform_real_distribution<float> unit(0.f, 1.f);
+	uint32 numGaps = 0, numOverlaps = 0, numLodSteps = 0, numCracks = 0;
+	for (uint32 run = 0; run < 16; run++)
+	{
+		const glm::vec3 cameraPos(unit(generator) * size, settings.HeightScale * (0.2f + unit(generator)), unit(generator) * size);
+		quadtree.Select(cameraPos, everything);
+
+		std::vector<uint32> cellCounts((size_t)numCells * numCells, 0);
+		std::vector<uint32> cellLods((size_t)numCells * numCells, 0);
+		for (const TerrainQuadtree::Patch& patch : quadtree.GetPatches())
+		{
+			const uint32 firstX = (uint32)std::lround(patch.Offset.x / settings.SampleSpacing) / cellSamples;
+			const uint32 firstZ = (uint32)std::lround(patch.Offset.y / settings.SampleSpacing) / cellSamples;
+			const uint32 count = 1u << patch.Lod;
+			for (uint32 z = firstZ; z < firstZ + count; z++)
+			{
+				for (uint32 x = firstX; x < firstX + count; x++)
+				{
+					cellCounts[(size_t)z * numCells + x]++;
+					cellLods[(size_t)z * numCells + x] = patch.Lod;
+				}
+			}
+		}
+
+		for (uint32 cell = 0; cell < numCells * numCells; cell++)
+		{
+			numGaps += cellCounts[cell] == 0;
+			numOverlaps += cellCounts[cell] > 1;
+		}
+
+		// Along an edge between a LOD and the next one, the vertices of the finer side must have morphed into the coarser grid
+		// and the coarser side must not have started to morph into the one after it.
+		auto CheckEdge = [&](uint32 cellA, uint32 cellB, uint32 edgeX, uint32 edgeZ, bool isAlongX)
+		{
+			const uint32 lodA = cellLods[cellA], lodB = cellLods[cellB];
+			if (lodA == lodB)
+				return;
+			if (lodA > lodB + 1 || lodB > lodA + 1)
+			{
+				numLodSteps++;
+				return;
+			}
+
+			const uint32 fineLod = std::min(lodA, lodB);
+			const glm::vec2 fineRange = quadtree.GetMorphRange(fineLod);
+			const glm::vec2 coarseRange = quadtree.GetMorphRange(fineLod + 1);
+			for (uint32 i = 0; i <= cellSamples; i++)
+			{
+				const uint32 x = std::min(edgeX + (isAlongX ? i : 0), size - 1);
+				const uint32 z = std::min(edgeZ + (isAlongX ? 0 : i), size - 1);
+				const glm::vec3 vertex(x * settings.SampleSpacing, ProceduralHeight(x, z) / 65535.f * settings.HeightScale, z * settings.SampleSpacing);
+				const float distance = glm::length(vertex - cameraPos);
+				const bool isCoarsest = fineLod + 1 == quadtree.GetNumLods() - 1;
+				numCracks += distance < fineRange.y * 0.999f || (!isCoarsest && distance > coarseRange.x);
+			}
+		};
+		for (uint32 z = 0; z < numCells; z++)
+		{
+			for (uint32 x = 0; x < numCells; x++)
+			{
+				if (x + 1 < numCells)
+					CheckEdge(z * numCells + x, z * numCells + x + 1, (x + 1) * cellSamples, z * cellSamples, false);
+				if (z + 1 < numCells)
+					CheckEdge(z * numCells + x, (z + 1) * numCells + x, x * cellSamples, (z + 1) * cellSamples, true);
+			}
+		}
+	}
+	RS_CHECK(numGaps == 0 && numOverlaps == 0, "The patches have {} gaps and {} overlaps", numGaps, numOverlaps);
+	RS_CHECK(numLodSteps == 0, "{} neighbours are more than one LOD apart", numLodSteps);
+	RS_CHECK(numCracks == 0, "{} vertices do not meet their neighbour", numCracks);
+}
+
+RS_TEST(TerrainQuadtreeCullsPatchesBehindTheCamera)
+{
+	const uint32 size = SMALL_SIZE;
+	const TerrainQuadtree::Settings settings = GetSmallSettings();
+	TerrainQuadtree quadtree;
+	quadtree.Build(size, settings, ProceduralHeight);
+
+	const glm::vec3 cameraPos(size * 0.5f, settings.HeightScale * 1.2f, size * 0.5f);
+	quadtree.Select(cameraPos, glm::orthoRH(-1e5f, 1e5f, -1e5f, 1e5f, -1e5f, 1e5f));
+	const uint32 numAllPatches = quadtree.GetStats().NumPatches;
+
+	// From the middle, looking along +x, nothing behind the camera is selected.
+	const glm::mat4 view = glm::lookAtRH(cameraPos, cameraPos + glm::vec3(1.f, -0.2f, 0.f), glm::vec3(0.f, 1.f, 0.f));
+	quadtree.Select(cameraPos, glm::perspectiveRH(glm::pi<float>() / 3.f, 16.f / 9.f, 0.1f, 2000.f) * view);
+	uint32 numBehind = 0;
+	for (const TerrainQuadtree::Patch& patch : quadtree.GetPatches())
+		numBehind += quadtree.GetPatchBounds(patch).max.x < cameraPos.x - 0.001f;
+	RS_CHECK(numBehind == 0, "{} of {} patches are behind the camera", numBehind, quadtree.GetStats().NumPatches);
+	RS_CHECK(quadtree.GetStats().NumPatches < numAllPatches, "{} of {} patches are in the frustum", quadtree.GetStats().NumPatches, numAllPatches);
+}
+
+RS_TEST(TerrainQuadtreeSelectsLargeTerrains)
+{
+	// 16k x 16k, the heights are made while the leaves are built so they are never kept in memory.
+	const uint32 size = 16384;
+	TerrainQuadtree::Settings settings;
+	settings.NumLods		= 8;
+	settings.HeightScale	= 800.f;
+	settings.Lod0Range		= 96.f;
+
+	TerrainQuadtree quadtree;
+	RS_CHECK(quadtree.Build(size, settings, ProceduralHeight), "The quadtree of {}x{} was not built", size, size);
+
+	const uint32 numFrames = 500;
+	const glm::mat4 proj = glm::perspectiveRH(glm::pi<float>() / 3.f, 16.f / 9.f, 0.5f, 20000.f);
+	float totalTimeMS = 0.f, maxTimeMS = 0.f;
+	uint64 totalPatches = 0, totalVisited = 0;
+	for (uint32 frame = 0; frame < numFrames; frame++)
+	{
+		// Along the diagonal at a fixed height, turning around once.
+		const float t = (float)frame / numFrames;
+		const float angle = t * glm::pi<float>() * 2.f;
+		const glm::vec3 cameraPos(size * (0.1f + 0.8f * t), settings.HeightScale * 1.1f, size * (0.1f + 0.8f * t));
+		const glm::vec3 direction(glm::cos(angle), -0.3f, glm::sin(angle));
+		quadtree.Select(cameraPos, proj * glm::lookAtRH(cameraPos, cameraPos + direction, glm::vec3(0.f, 1.f, 0.f)));
+
+		const TerrainQuadtree::Stats& stats = quadtree.GetStats();
+		totalTimeMS += stats.SelectTimeMS;
+		maxTimeMS = std::max(maxTimeMS, stats.SelectTimeMS);
+		totalPatches += stats.NumPatches;
+		totalVisited += stats.NumVisitedNodes;
+	}
+
+	LOG_INFO("Terrain quadtree of {}x{} with {} LODs built in {:.1f} ms. Selection over {} frames: {:.3f} ms on average, {:.3f} ms at most, {} patches and {} visited nodes on average.",
+		size, size, quadtree.GetNumLods(), quadtree.GetStats().BuildTimeMS, numFrames, totalTimeMS / numFrames, maxTimeMS, totalPatches / numFrames, totalVisited / numFrames);
+	RS_CHECK(totalPatches > 0, "No patches were selected along the fly-through");
+}
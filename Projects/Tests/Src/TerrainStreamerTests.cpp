@@ -0,0 +1,188 @@
+#include "PreCompiled.h"
+#include "Test.h"
+
+#include "Core/MappedFile.h"
+#include "Renderer/TerrainQuadtree.h"
+#include "Renderer/TerrainStreamer.h"
+#include "Utils/ParallelFor.h"
+#include "Utils/Timer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+using namespace RS;
+
+namespace
+{
+	/*
+	* Find the tile of each level, x and z of the terrain and compare the resident ones with the cooked tiles in the view.
+	* numCheckedTiles: The resident tiles which were found, a coarser tile may be found for a tile which is not resident.
+	* Returns the number of those which differ from the cooked tiles, or whose first sample is not the height it was cooked from.
+	*/
+	uint32 CountWrongTiles(TerrainStreamer& streamer, const FileView& view, const std::vector<uint16>& heights, uint32 size, uint32& numCheckedTiles)
+	{
+		const CookedAssets::TerrainHeader& header = streamer.GetHeader();
+		const uint32 tileSize = header.TileSize;
+		const size_t splatBytes = (size_t)(tileSize + 1) * (tileSize + 1) * 4;
+		uint32 numWrongTiles = 0;
+		numCheckedTiles = 0;
+		for (uint32 level = 0; level < header.NumLevels; level++)
+		{
+			const uint32 numTiles = CookedAssets::GetNumTerrainTiles(header, level);
+			for (uint32 z = 0; z < numTiles; z++)
+			{
+				for (uint32 x = 0; x < numTiles; x++)
+				{
+					// Finding a tile marks it as used in this frame, so it is not taken for another tile while it is compared.
+					TerrainStreamer::Tile tile;
+					const glm::vec2 center = (glm::vec2((float)x, (float)z) + 0.5f) * (float)(tileSize << level);
+					if (!streamer.FindTile(level, center, tile) || tile.Level != level || tile.X != x || tile.Z != z)
+						continue;
+
+					const uint8* pCooked = view.pData + CookedAssets::GetTerrainTileOffset(header, level, x, z);
+					const uint16 origin = heights[(size_t)(z * tileSize << level) * size + (x * tileSize << level)];
+					numWrongTiles += memcmp(pCooked, tile.pHeights, header.SplatOffset) != 0 || memcmp(pCooked + header.SplatOffset, tile.pSplat, splatBytes) != 0
+						|| tile.pHeights[CookedAssets::GetTerrainHeightIndex(header, 0, 0)] != origin;
+					numCheckedTiles++;
+				}
+			}
+		}
+		return numWrongTiles;
+	}
+}
+
+RS_TEST(TerrainStreamerStreamsTheCookedTiles)
+{
+	// A procedural 4k x 4k terrain, flown over with a cache which is smaller than the terrain.
+	const uint32 size = 4096, tileSize = 128, leafSize = 32;
+	std::vector<uint16> heights((size_t)size * size);
+	ParallelFor(std::max(std::thread::hardware_concurrency(), 1u), size, [&](uint32 z, uint32)
+		{
+			for (uint32 x = 0; x < size; x++)
+			{
+				const float height = 0.5f + 0.25f * std::sin(x * 0.0031f) * std::cos(z * 0.0027f) + 0.125f * std::sin((x + z) * 0.013f) + 0.0625f * std::cos(x * 0.041f - z * 0.037f);
+				heights[(size_t)z * size + x] = (uint16)(std::clamp(height, 0.f, 1.f) * UINT16_MAX);
+			}
+		});
+
+	Timer cookTimer;
+	std::vector<uint8> data;
+	const bool isCooked = CookedAssets::CookTerrain(heights.data(), nullptr, size, tileSize, leafSize, data);
+	RS_CHECK(isCooked, "The terrain could not be cooked");
+	if (!isCooked)
+		return;
+	const float cookTimeMS = cookTimer.Stop().GetDeltaTimeMS();
+
+	// Written to a file and mapped, like a cooked terrain which is read through the VirtualFileSystem. The file is likely still in the OS cache.
+	const std::filesystem::path path = std::filesystem::temp_directory_path() / "RSTerrainStreamerTests.rster";
+	{
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		file.write((const char*)data.data(), (std::streamsize)data.size());
+		RS_CHECK(file.good(), "Failed to write [{}]", path.string());
+		if (!file.good())
+			return;
+	}
+
+	{
+		std::shared_ptr<MappedFile> pFile = std::make_shared<MappedFile>();
+		const bool isMapped = pFile->Open(path.string());
+		RS_CHECK(isMapped, "Failed to map [{}]", path.string());
+		if (!isMapped)
+			return;
+		FileView view;
+		view.pData		= pFile->GetData();
+		view.Size		= pFile->GetSize();
+		view.IsZeroCopy	= true;
+		view.pOwner		= pFile;
+
+		TerrainStreamer::Settings settings;
+		settings.NumSlots	= 48;
+		settings.LodRange	= 96.f;
+		TerrainStreamer streamer;
+		const bool isOpen = streamer.Open(view, settings);
+		RS_CHECK(isOpen, "The cooked terrain could not be opened");
+		if (!isOpen)
+			return;
+
+		// The quadtree from the cooked min/max map selects the same patches as the one from the heights.
+		TerrainQuadtree::Settings quadtreeSettings;
+		quadtreeSettings.LeafSize		= leafSize;
+		quadtreeSettings.HeightScale	= 600.f;
+		quadtreeSettings.Lod0Range		= settings.LodRange;
+		TerrainQuadtree quadtree, referenceQuadtree;
+		RS_CHECK(quadtree.Build((const TerrainQuadtree::MinMax*)streamer.GetLeafMinMax(), size, quadtreeSettings), "The quadtree of the min/max map was not built");
+		RS_CHECK(referenceQuadtree.Build(heights.data(), size, quadtreeSettings), "The quadtree of the heights was not built");
+
+		const uint32 numFrames = 1500;
+		const glm::mat4 proj = glm::perspectiveRH(glm::pi<float>() / 3.f, 16.f / 9.f, 0.5f, 10000.f);
+		const uint64 cacheBytes = streamer.GetStats().CacheBytes;
+		uint64 numPatches = 0, numExactPatches = 0, numMissingPatches = 0;
+		uint32 maxResidentTiles = 0, maxPendingRequests = 0, numDifferentSelections = 0;
+		bool isBounded = true;
+		for (uint32 frame = 0; frame < numFrames; frame++)
+		{
+			// A loop around the middle of the terrain, looking where it goes.
+			const float angle = (float)frame / numFrames * glm::two_pi<float>();
+			const glm::vec3 cameraPos(size * (0.5f + 0.35f * std::cos(angle)), quadtreeSettings.HeightScale * 1.2f, size * (0.5f + 0.35f * std::sin(angle)));
+			const glm::vec3 direction(-std::sin(angle), -0.4f, std::cos(angle));
+			const glm::mat4 viewProj = proj * glm::lookAtRH(cameraPos, cameraPos + direction, glm::vec3(0.f, 1.f, 0.f));
+
+			streamer.Update(cameraPos);
+			quadtree.Select(cameraPos, viewProj);
+			if (frame % 100 == 0)
+			{
+				referenceQuadtree.Select(cameraPos, viewProj);
+				const std::vector<TerrainQuadtree::Patch>& a = quadtree.GetPatches();
+				const std::vector<TerrainQuadtree::Patch>& b = referenceQuadtree.GetPatches();
+				numDifferentSelections += a.size() != b.size() || !std::equal(a.begin(), a.end(), b.begin(), [](const TerrainQuadtree::Patch& p, const TerrainQuadtree::Patch& q)
+					{
+						return p.Offset.x == q.Offset.x && p.Offset.y == q.Offset.y && p.Size == q.Size && p.Lod == q.Lod;
+					});
+			}
+
+			for (const TerrainQuadtree::Patch& patch : quadtree.GetPatches())
+			{
+				TerrainStreamer::Tile tile;
+				const uint32 level = std::min(patch.Lod, streamer.GetHeader().NumLevels - 1);
+				if (streamer.FindTile(level, patch.Offset + glm::vec2(patch.Size * 0.5f), tile))
+					numExactPatches += tile.Level == level;
+				else
+					numMissingPatches++;
+			}
+			numPatches += quadtree.GetPatches().size();
+
+			const TerrainStreamer::Stats stats = streamer.GetStats();
+			isBounded &= stats.NumResidentTiles <= settings.NumSlots && stats.NumPendingRequests <= settings.NumSlots && stats.CacheBytes == cacheBytes;
+			maxResidentTiles = std::max(maxResidentTiles, stats.NumResidentTiles);
+			maxPendingRequests = std::max(maxPendingRequests, stats.NumPendingRequests);
+
+			// The rest of a frame, which gives the streaming thread time to work.
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+
+		// The tiles in the cache are the cooked tiles.
+		uint32 numCheckedTiles = 0;
+		const uint32 numWrongTiles = CountWrongTiles(streamer, view, heights, size, numCheckedTiles);
+
+		const TerrainStreamer::Stats stats = streamer.GetStats();
+		LOG_INFO("Terrain streaming of {}x{} in tiles of {} ({:.1f} MB cooked in {:.1f} ms), {} slots ({:.1f} MB), {} frames: {:.1f}% of the wanted tiles were resident, "
+			"{:.1f}% of the patches had the tile of their LOD and {} had none. {} loads, {} evictions, {:.1f} MB read at {:.1f} MB/s, at most {} tiles and {} requests.",
+			size, size, tileSize, (float)data.size() / (1024.f * 1024.f), cookTimeMS, settings.NumSlots, (float)stats.CacheBytes / (1024.f * 1024.f), numFrames,
+			stats.NumWantedTiles > 0 ? 100.f * stats.NumHits / stats.NumWantedTiles : 0.f, numPatches > 0 ? 100.f * numExactPatches / numPatches : 0.f, numMissingPatches,
+			stats.NumLoads, stats.NumEvictions, (float)stats.BytesLoaded / (1024.f * 1024.f), stats.LoadTimeMS > 0.f ? (float)stats.BytesLoaded / (1024.f * 1024.f) / (stats.LoadTimeMS / 1000.f) : 0.f,
+			maxResidentTiles, maxPendingRequests);
+
+		RS_CHECK(isBounded, "The streamer held more tiles or requests than it has slots, or its cache grew");
+		RS_CHECK(numCheckedTiles > 0, "No tile was resident after the flight");
+		RS_CHECK(numWrongTiles == 0, "{} of {} tiles in the cache differ from the cooked tiles", numWrongTiles, numCheckedTiles);
+		RS_CHECK(numDifferentSelections == 0, "The quadtree from the cooked min/max map selected different patches {} times", numDifferentSelections);
+		streamer.Close();
+	}
+
+	std::error_code error;
+	std::filesystem::remove(path, error);
+}
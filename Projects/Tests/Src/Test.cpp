@@ -0,0 +1,35 @@
+#include "PreCompiled.h"
+#include "Test.h"
+
+#include <atomic>
+#include <iostream>
+#include <mutex>
+
+namespace
+{
+	std::atomic<uint32>	s_NumFailures = 0;
+	std::mutex			s_PrintMutex;
+}
+
+std::vector<RS::Tests::TestCase>& RS::Tests::GetTestCases()
+{
+	static std::vector<TestCase> s_TestCases;
+	return s_TestCases;
+}
+
+RS::Tests::TestRegistrar::TestRegistrar(const char* name, TestFunction function, bool needsDevice)
+{
+	GetTestCases().push_back(TestCase{ name, function, needsDevice });
+}
+
+void RS::Tests::ReportFailure(const char* file, int line, const std::string& message)
+{
+	s_NumFailures++;
+	std::lock_guard<std::mutex> lock(s_PrintMutex);
+	std::cout << "[Failed] " << file << "(" << line << "): " << message << "\n";
+}
+
+uint32 RS::Tests::GetNumFailures()
+{
+	return s_NumFailures;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <spdlog/fmt/fmt.h>
+
+#include <string>
+#include <vector>
+
+namespace RS::Tests
+{
+	using TestFunction = void(*)();
+
+	struct TestCase
+	{
+		const char*		Name		= "";
+		TestFunction	Function	= nullptr;
+		bool			NeedsDevice	= false; // The device is made without a window before the first test which needs it, see RenderAPI::InitWithoutDisplay.
+	};
+
+	std::vector<TestCase>& GetTestCases();
+
+	/*
+	* Adds the test to GetTestCases when the program starts, use RS_TEST or RS_DEVICE_TEST instead.
+	*/
+	struct TestRegistrar
+	{
+		TestRegistrar(const char* name, TestFunction function, bool needsDevice);
+	};
+
+	/*
+	* Mark the running test as failed and print where. This can be called from any thread.
+	*/
+	void ReportFailure(const char* file, int line, const std::string& message);
+
+	/*
+	* The number of failures reported since the program started.
+	*/
+	uint32 GetNumFailures();
+}
+
+/*
+* A test is a function which checks with RS_CHECK, the timings of benchmarks are logged with LOG_INFO.
+* Example:
+*	RS_TEST(ParallelForVisitsEachIndexOnce)
+*	{
+*		std::vector<std::atomic<uint32>> visits(100);
+*		ParallelFor(4, 100, [&](uint32 index, uint32) { visits[index]++; });
+*		for (uint32 i = 0; i < 100; i++)
+*			RS_CHECK(visits[i] == 1, "Index {} was visited {} times", i, visits[i].load());
+*	}
+*/
+#define RS_TEST(name) \
+	static void name(); \
+	static RS::Tests::TestRegistrar s_##name##Registrar(#name, &name, false); \
+	static void name()
+
+#define RS_DEVICE_TEST(name) \
+	static void name(); \
+	static RS::Tests::TestRegistrar s_##name##Registrar(#name, &name, true); \
+	static void name()
+
+#define RS_CHECK(condition, ...) \
+	do { if (!(condition)) RS::Tests::ReportFailure(__FILE__, __LINE__, std::string(#condition) + ": " + fmt::format(__VA_ARGS__)); } while (false)
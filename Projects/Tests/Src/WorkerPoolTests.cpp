@@ -0,0 +1,30 @@
+#include "PreCompiled.h"
+#include "Test.h"
+
+#include "Utils/WorkerPool.h"
+
+using namespace RS;
+
+RS_TEST(WorkerPoolVisitsEachIndexOnce)
+{
+	// The same pool for calls with more and fewer threads, the threads of the first calls are used again.
+	WorkerPool workers;
+	for (uint32 numThreads : { 4u, 2u, 8u, 1u, 8u })
+	{
+		std::vector<std::atomic<uint32>> visits(1000);
+		std::atomic<uint32> maxThreadIndex = 0;
+		workers.ParallelFor(numThreads, (uint32)visits.size(), [&](uint32 index, uint32 threadIndex)
+		{
+			visits[index]++;
+			uint32 previous = maxThreadIndex;
+			while (threadIndex > previous && !maxThreadIndex.compare_exchange_weak(previous, threadIndex)) {}
+		});
+
+		uint32 numWrong = 0;
+		for (std::atomic<uint32>& count : visits)
+			numWrong += count == 1 ? 0 : 1;
+		RS_CHECK(numWrong == 0, "{} indices were not visited once on {} threads", numWrong, numThreads);
+		RS_CHECK(maxThreadIndex < numThreads, "Thread {} ran with {} threads", maxThreadIndex.load(), numThreads);
+	}
+	RS_CHECK(workers.GetNumThreads() == 8, "The pool has {} threads after asking for at most 8", workers.GetNumThreads());
+}
@@ -0,0 +1,74 @@
+-- Command line tool which runs the checks and benchmarks of the Sandbox code without opening a window, Tests [filter] runs the tests whose name contains the filter.
+project "Tests"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++latest"
+	systemversion "latest"
+
+	forceincludes
+	{
+		"PreCompiled.h"
+	}
+
+	-- Targets
+	targetdir ("%{wks.location}/Build/bin/" .. outputdir .. "/%{prj.name}")
+	objdir ("%{wks.location}/Build/obj/" .. outputdir .. "/%{prj.name}")
+
+	-- Files to include, all of the Sandbox and the cooking of the Cooker is built in except for their mains.
+	files
+	{
+		"Src/**.h",
+		"Src/**.cpp",
+		"../Sandbox/Src/**.h",
+		"../Sandbox/Src/**.cpp",
+		"../Cooker/Src/AssetCooker.h",
+		"../Cooker/Src/AssetCooker.cpp",
+		"../Cooker/Src/CookDatabase.h",
+		"../Cooker/Src/CookDatabase.cpp"
+	}
+	removefiles { "../Sandbox/Src/Main.cpp" }
+
+	--Includes
+	includedirs { "Src", "../Sandbox/Src", "../Cooker/Src" }
+
+	sysincludedirs
+	{
+		"%{includeDir.glm}",
+		"%{includeDir.imgui}",
+		"%{includeDir.spdlog}",
+		"%{includeDir.stb}",
+		"%{includeDir.json}",
+		"%{includeDir.glfw}",
+		"%{includeDir.tinyobj}",
+		"%{includeDir.assimp}"
+	}
+
+	filter "configurations:Debug"
+		links
+		{
+			"glfw",
+			"imgui",
+			"%{libDir.assimp}/assimp-vc142-mtd.lib",
+			"%{libDir.assimp}/zlibstaticd.lib",
+			"%{libDir.assimp}/dracod.lib"
+		}
+
+	filter "configurations:Release"
+		links
+		{
+			"glfw",
+			"imgui",
+			"%{libDir.assimp}/assimp-vc142-mt.lib",
+			"%{libDir.assimp}/zlibstatic.lib",
+			"%{libDir.assimp}/draco.lib"
+		}
+	filter "configurations:Production"
+		links
+		{
+			"glfw",
+			"imgui",
+			"%{libDir.assimp}/assimp-vc142-mt.lib",
+			"%{libDir.assimp}/zlibstatic.lib",
+			"%{libDir.assimp}/draco.lib"
+		}
+	filter {}
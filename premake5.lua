@@ -98,4 +98,10 @@ group "Externals"
 		include "Externals/imgui"
 group ""
 
-include "Projects/Sandbox"
\ No newline at end of file
+include "Projects/Sandbox"
+
+group "Tools"
+		include "Projects/Packer"
+		include "Projects/Cooker"
+		include "Projects/Tests"
+group ""
\ No newline at end of file